@@ -31,12 +31,19 @@
  * @brief Implementation of inflate decompression
  *
  * A simple inflate implementation (decompression of `deflate' stream as
- * described by RFC 1951) based on puff.c by Mark Adler. It is not optimized
- * for speed but for readability as it is used as part of the bootloader and
- * any miss-optimization might be hard to debug.
+ * described by RFC 1951) originally based on puff.c by Mark Adler.
  *
- * All dynamically allocated memory memory is taken from the stack. The
- * stack usage should be typically bounded by 2 KB.
+ * This is the one-shot subset of the decoder in uspace/lib/compress.
+ * Input is consumed through a 64-bit bit buffer that is refilled a whole
+ * word at a time and Huffman symbols are decoded by a single table lookup
+ * of the next FAST_BITS bits, falling back to the canonical bit-by-bit walk
+ * only for the rare longer codes. As the boot loader spends most of its
+ * time decompressing the kernel and the initial tasks, this is worth the
+ * little extra complexity.
+ *
+ * The decoder state (about 3.5 KB) is statically allocated, as some
+ * boot stacks are just a single page and the boot loader never runs
+ * more than one decompression at a time.
  *
  * Original copyright notice:
  *
@@ -69,6 +76,7 @@
 #include <stdint.h>
 #include <errno.h>
 #include <memstr.h>
+#include <byteorder.h>
 #include <inflate.h>
 
 /** Maximum bits in the Huffman code */
@@ -84,42 +92,74 @@
 #define MAX_LITLEN        286
 /** Number of fixed literal/length codes */
 #define MAX_FIXED_LITLEN  288
+/** Number of fixed distance codes */
+#define MAX_FIXED_DIST    30
 
 /** Number of all codes */
 #define MAX_CODE  (MAX_LITLEN + MAX_DIST)
 
-/** Check for input buffer overrun condition */
-#define CHECK_OVERRUN(state) \
-	do { \
-		if ((state).overrun) \
-			return ELIMIT; \
-	} while (false)
+/** Bits resolved by a single lookup in the fast decoding table */
+#define FAST_BITS         9
+#define FAST_SIZE         (1 << FAST_BITS)
+#define FAST_MASK         (FAST_SIZE - 1)
 
-/** Inflate algorithm state
+/** Fast table entry: symbol in the low bits, code length above */
+#define FAST_SYMBOL_BITS  9
+#define FAST_SYMBOL_MASK  ((1 << FAST_SYMBOL_BITS) - 1)
+
+/** Most bits consumed by a single length/distance pair */
+#define MAX_PAIR_BITS     48
+
+/** Huffman code description
  *
  */
 typedef struct {
-	uint8_t *dest;    /**< Output buffer */
-	size_t destlen;   /**< Output buffer size */
-	size_t destcnt;   /**< Position in the output buffer */
-
-	const uint8_t *src;     /**< Input buffer */
-	size_t srclen;    /**< Input buffer size */
-	size_t srccnt;    /**< Position in the input buffer */
-
-	uint16_t bitbuf;  /**< Bit buffer */
-	size_t bitlen;    /**< Number of bits in the bit buffer */
+	uint16_t count[MAX_HUFFMAN_BIT + 1];  /**< Array of symbol counts */
+	uint16_t symbol[MAX_FIXED_LITLEN];    /**< Array of symbols */
+	uint16_t fast[FAST_SIZE];             /**< Fast decoding table */
+} huffman_t;
 
-	bool overrun;     /**< Overrun condition */
-} inflate_state_t;
+/** Decoder position within the deflate stream */
+typedef enum {
+	/** Next block header expected */
+	INFLATE_HEADER,
+	/** Inside a stored block */
+	INFLATE_STORED,
+	/** Inside a fixed or dynamic Huffman block */
+	INFLATE_CODES,
+	/** Last block finished */
+	INFLATE_DONE
+} inflate_mode_t;
 
-/** Huffman code description
+/** Inflate algorithm state
  *
  */
 typedef struct {
-	uint16_t *count;   /**< Array of symbol counts */
-	uint16_t *symbol;  /**< Array of symbols */
-} huffman_t;
+	uint8_t *dest;           /**< Output buffer */
+	size_t destlen;          /**< Output buffer size */
+	size_t destcnt;          /**< Position in the output buffer */
+
+	const uint8_t *src;      /**< Input buffer */
+	size_t srclen;           /**< Input buffer size */
+	size_t srccnt;           /**< Position in the input buffer */
+
+
+	uint64_t bitbuf;         /**< Bit buffer */
+	size_t bitlen;           /**< Number of bits in the bit buffer */
+
+	inflate_mode_t mode;     /**< Current decoder position */
+	bool last;               /**< Current block is the last one */
+	bool fixed;              /**< Tables hold the fixed code */
+	size_t stored;           /**< Bytes left in the stored block */
+
+	bool literal;            /**< Literal pending for output */
+	uint8_t literal_value;   /**< Pending literal */
+	size_t copy_len;         /**< Match bytes pending for output */
+	size_t copy_dist;        /**< Distance of the pending match */
+
+	huffman_t len_code;      /**< Literal/length code of the block */
+	huffman_t dist_code;     /**< Distance code of the block */
+} inflate_state_t;
 
 /** Length codes
  *
@@ -162,147 +202,76 @@ static const short order[MAX_ORDER] = {
 	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
 };
 
-/** Static length symbol counts
+/** Refill the bit buffer
  *
- */
-static uint16_t len_count[MAX_HUFFMAN_BIT + 1] = {
-	0, 0, 0, 0, 0, 0, 0, 24, 152, 112, 0, 0, 0, 0, 0, 0
-};
-
-/** Static length symbols
+ * Load as many whole bytes as fit into the bit buffer. Fewer bits
+ * are only left in the buffer at the end of the input.
  *
- */
-static uint16_t len_symbol[MAX_FIXED_LITLEN] = {
-	256, 257, 258, 259, 260, 261, 262, 263, 264, 265, 266, 267, 268,
-	269, 270, 271, 272, 273, 274, 275, 276, 277, 278, 279, 0, 1, 2,
-	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
-	21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36,
-	37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52,
-	53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68,
-	69, 70, 71, 72, 73, 74, 75, 76, 77, 78, 79, 80, 81, 82, 83, 84,
-	85, 86, 87, 88, 89, 90, 91, 92, 93, 94, 95, 96, 97, 98, 99, 100,
-	101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113,
-	114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 126,
-	127, 128, 129, 130, 131, 132, 133, 134, 135, 136, 137, 138, 139,
-	140, 141, 142, 143, 280, 281, 282, 283, 284, 285, 286, 287, 144,
-	145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155, 156, 157,
-	158, 159, 160, 161, 162, 163, 164, 165, 166, 167, 168, 169, 170,
-	171, 172, 173, 174, 175, 176, 177, 178, 179, 180, 181, 182, 183,
-	184, 185, 186, 187, 188, 189, 190, 191, 192, 193, 194, 195, 196,
-	197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207, 208, 209,
-	210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221, 222,
-	223, 224, 225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235,
-	236, 237, 238, 239, 240, 241, 242, 243, 244, 245, 246, 247, 248,
-	249, 250, 251, 252, 253, 254, 255
-};
-
-/** Static distance symbol counts
+ * The word-sized load may leave some bits of the next input byte above
+ * bitlen. They are loaded again to the very same position by the next
+ * refill, so they need not be masked out.
  *
- */
-static uint16_t dist_count[MAX_HUFFMAN_BIT + 1] = {
-	0, 0, 0, 0, 0, 30, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
-};
-
-/** Static distance symbols
+ * @param state Inflate state.
  *
  */
-static uint16_t dist_symbol[MAX_DIST] = {
-	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
-	16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29
-};
+static void bits_refill(inflate_state_t *state)
+{
+	if (state->srclen - state->srccnt >= sizeof(uint64_t)) {
+		/* Load a whole word and keep as many bytes as fit */
+		uint64_t word;
+		memcpy(&word, state->src + state->srccnt, sizeof(word));
+
+		state->bitbuf |= uint64_t_le2host(word) << state->bitlen;
+		state->srccnt += (63 - state->bitlen) >> 3;
+		state->bitlen |= 56;
+		return;
+	}
 
-/** Huffman code for lengths
- *
- */
-static huffman_t len_code = {
-	.count = len_count,
-	.symbol = len_symbol
-};
+	while (state->bitlen <= 56) {
+		if (state->srccnt == state->srclen)
+			return;
 
-/** Huffman code for distances
- *
- */
-static huffman_t dist_code = {
-	.count = dist_count,
-	.symbol = dist_symbol
-};
+		state->bitbuf |=
+		    ((uint64_t) state->src[state->srccnt]) << state->bitlen;
+		state->srccnt++;
+		state->bitlen += 8;
+	}
+}
 
-/** Get bits from the bit buffer
+/** Make sure the bit buffer holds enough bits
  *
  * @param state Inflate state.
- * @param cnt   Number of bits to return (at most 16).
+ * @param cnt   Number of bits needed (at most 57).
  *
- * @return Returned bits.
+ * @return True if at least cnt bits are available.
  *
  */
-static inline uint16_t get_bits(inflate_state_t *state, size_t cnt)
+static inline bool bits_need(inflate_state_t *state, size_t cnt)
 {
-	/* Bit accumulator for at least 20 bits */
-	uint32_t val = state->bitbuf;
-
-	while (state->bitlen < cnt) {
-		if (state->srccnt == state->srclen) {
-			state->overrun = true;
-			return 0;
-		}
-
-		/* Load 8 more bits */
-		val |= ((uint32_t) state->src[state->srccnt]) << state->bitlen;
-		state->srccnt++;
-		state->bitlen += 8;
-	}
-
-	/* Update bits in the buffer */
-	state->bitbuf = (uint16_t) (val >> cnt);
-	state->bitlen -= cnt;
+	if (state->bitlen < cnt)
+		bits_refill(state);
 
-	return ((uint16_t) (val & ((1 << cnt) - 1)));
+	return (state->bitlen >= cnt);
 }
 
-/** Decode `stored' block
+/** Get bits from the bit buffer
+ *
+ * The bits must be made available by bits_need() beforehand.
  *
  * @param state Inflate state.
+ * @param cnt   Number of bits to return (at most 32).
  *
- * @return EOK on success.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
- * @return EINVAL on invalid data.
+ * @return Returned bits.
  *
  */
-static int inflate_stored(inflate_state_t *state)
+static inline uint32_t get_bits(inflate_state_t *state, size_t cnt)
 {
-	/* Discard bits in the bit buffer */
-	state->bitbuf = 0;
-	state->bitlen = 0;
-
-	if (state->srccnt + 4 > state->srclen)
-		return ELIMIT;
-
-	uint16_t len =
-	    state->src[state->srccnt] | (state->src[state->srccnt + 1] << 8);
-	uint16_t len_compl =
-	    state->src[state->srccnt + 2] | (state->src[state->srccnt + 3] << 8);
-
-	/* Check block length and its complement */
-	if (((int16_t) len) != ~((int16_t) len_compl))
-		return EINVAL;
-
-	state->srccnt += 4;
-
-	/* Check input buffer size */
-	if (state->srccnt + len > state->srclen)
-		return ELIMIT;
+	uint32_t val = (uint32_t) (state->bitbuf & ((UINT64_C(1) << cnt) - 1));
 
-	/* Check output buffer size */
-	if (state->destcnt + len > state->destlen)
-		return ENOMEM;
-
-	/* Copy data */
-	memcpy(state->dest + state->destcnt, state->src + state->srccnt, len);
-	state->srccnt += len;
-	state->destcnt += len;
+	state->bitbuf >>= cnt;
+	state->bitlen -= cnt;
 
-	return EOK;
+	return val;
 }
 
 /** Decode a symbol using the Huffman code
@@ -311,14 +280,33 @@ static int inflate_stored(inflate_state_t *state)
  * @param huffman Huffman code.
  * @param symbol  Decoded symbol.
  *
- * @param EOK on success.
- * @param EINVAL on invalid Huffman code.
+ * @return EOK on success.
+ * @return EINVAL on invalid Huffman code.
+ * @return ELIMIT on input buffer overrun.
  *
  */
-static int huffman_decode(inflate_state_t *state, huffman_t *huffman,
-    uint16_t *symbol)
+static inline int huffman_decode(inflate_state_t *state,
+    huffman_t *huffman, uint16_t *symbol)
 {
+	if (state->bitlen < MAX_HUFFMAN_BIT)
+		bits_refill(state);
+
+	/* Codes up to FAST_BITS long are resolved by a single lookup */
+	uint16_t entry = huffman->fast[state->bitbuf & FAST_MASK];
+	size_t len = entry >> FAST_SYMBOL_BITS;
+
+	if (len != 0) {
+		if (len > state->bitlen)
+			return ELIMIT;
+
+		state->bitbuf >>= len;
+		state->bitlen -= len;
+		*symbol = entry & FAST_SYMBOL_MASK;
+		return EOK;
+	}
+
 	/* Decode bits */
+	uint64_t bits = state->bitbuf;
 	uint16_t code = 0;
 
 	/* First code of the given length */
@@ -330,17 +318,19 @@ static int huffman_decode(inflate_state_t *state, huffman_t *huffman,
 	 */
 	size_t index = 0;
 
-	/* Current number of bits in the code */
-	size_t len;
-
 	for (len = 1; len <= MAX_HUFFMAN_BIT; len++) {
+		if (len > state->bitlen)
+			return ELIMIT;
+
 		/* Get next bit */
-		code |= get_bits(state, 1);
-		CHECK_OVERRUN(*state);
+		code |= bits & 1;
+		bits >>= 1;
 
 		uint16_t count = huffman->count[len];
 		if (code < first + count) {
 			/* Return decoded symbol */
+			state->bitbuf >>= len;
+			state->bitlen -= len;
 			*symbol = huffman->symbol[index + code - first];
 			return EOK;
 		}
@@ -368,6 +358,8 @@ static int huffman_decode(inflate_state_t *state, huffman_t *huffman,
  */
 static int16_t huffman_construct(huffman_t *huffman, uint16_t *length, size_t n)
 {
+	memset(huffman->fast, 0, sizeof(huffman->fast));
+
 	/* Count number of codes for each length */
 	size_t len;
 	for (len = 0; len <= MAX_HUFFMAN_BIT; len++)
@@ -408,132 +400,325 @@ static int16_t huffman_construct(huffman_t *huffman, uint16_t *length, size_t n)
 		}
 	}
 
+	/*
+	 * Fill the fast table. The codes are stored in the stream
+	 * starting with the most significant bit, hence each canonical
+	 * code is bit-reversed and replicated over all the entries
+	 * which share its low bits.
+	 */
+	uint16_t code = 0;
+	size_t index = 0;
+	for (len = 1; len <= FAST_BITS; len++) {
+		for (size_t i = 0; i < huffman->count[len]; i++) {
+			uint16_t rev = 0;
+			for (size_t bit = 0; bit < len; bit++)
+				rev |= ((code >> bit) & 1) << (len - 1 - bit);
+
+			uint16_t entry = huffman->symbol[index] |
+			    (len << FAST_SYMBOL_BITS);
+			for (size_t j = rev; j < FAST_SIZE; j += 1 << len)
+				huffman->fast[j] = entry;
+
+			code++;
+			index++;
+		}
+
+		code <<= 1;
+	}
+
 	return left;
 }
 
+/** Copy a match within the output buffer
+ *
+ * @param dest Position in the output buffer.
+ * @param dist Distance of the source (bytes back).
+ * @param len  Number of bytes to copy.
+ *
+ */
+static inline void copy_match(uint8_t *dest, size_t dist, size_t len)
+{
+	const uint8_t *src = dest - dist;
+
+	if (dist >= len) {
+		memcpy(dest, src, len);
+	} else if (dist == 1) {
+		memset(dest, *src, len);
+	} else {
+		/* The source overlaps the bytes being written */
+		while (len > 0) {
+			*dest++ = *src++;
+			len--;
+		}
+	}
+}
+
+/** Decode `stored' block header
+ *
+ * @param state Inflate state.
+ *
+ * @return EOK on success.
+ * @return ELIMIT on input buffer overrun.
+ * @return EINVAL on invalid data.
+ *
+ */
+static int inflate_stored_header(inflate_state_t *state)
+{
+	/* Discard bits up to the byte boundary */
+	get_bits(state, state->bitlen & 7);
+
+	if (!bits_need(state, 32))
+		return ELIMIT;
+
+	uint16_t len = get_bits(state, 16);
+	uint16_t len_compl = get_bits(state, 16);
+
+	/* Check block length and its complement */
+	if (((int16_t) len) != ~((int16_t) len_compl))
+		return EINVAL;
+
+	state->stored = len;
+	state->mode = INFLATE_STORED;
+	return EOK;
+}
+
+/** Decode `stored' block data
+ *
+ * Copy as much of the block as fits into the output buffer.
+ *
+ * @param state Inflate state.
+ *
+ * @return EOK on success.
+ * @return ELIMIT on input buffer overrun.
+ *
+ */
+static int inflate_stored(inflate_state_t *state)
+{
+	while (state->stored > 0) {
+		if (state->destcnt == state->destlen)
+			return EOK;
+
+		/* Whole bytes already in the bit buffer go first */
+		if (state->bitlen >= 8) {
+			state->dest[state->destcnt] = get_bits(state, 8);
+			state->destcnt++;
+			state->stored--;
+			continue;
+		}
+
+		/*
+		 * The bit buffer may still hold bits of the next input
+		 * byte beyond bitlen (see bits_refill()).
+		 */
+		state->bitbuf = 0;
+
+		if (state->srccnt == state->srclen)
+			return ELIMIT;
+
+		size_t len = state->stored;
+		if (len > state->srclen - state->srccnt)
+			len = state->srclen - state->srccnt;
+		if (len > state->destlen - state->destcnt)
+			len = state->destlen - state->destcnt;
+
+		/* Copy data */
+		memcpy(state->dest + state->destcnt, state->src + state->srccnt,
+		    len);
+		state->srccnt += len;
+		state->destcnt += len;
+		state->stored -= len;
+	}
+
+	state->mode = INFLATE_HEADER;
+	return EOK;
+}
+
 /** Decode literal/length and distance codes
  *
- * Decode until end-of-block code.
+ * Decode until end-of-block code or until the output buffer
+ * becomes full. A literal or the part of a match that does not
+ * fit into the output buffer is kept pending in the state.
  *
- * @param state     Inflate state.
- * @param len_code  Huffman code for literal/length.
- * @param dist_code Huffman code for distance.
+ * @param state Inflate state.
  *
  * @return EOK on success.
  * @return ENOENT on distance too large.
  * @return EINVAL on invalid Huffman code.
  * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
  *
  */
-static int inflate_codes(inflate_state_t *state, huffman_t *len_code,
-    huffman_t *dist_code)
+static int inflate_codes(inflate_state_t *state)
 {
-	uint16_t symbol;
+	uint8_t *dest = state->dest;
+	size_t destlen = state->destlen;
+	size_t destcnt = state->destcnt;
+	int err = EOK;
+
+	/* Flush output pending from the previous call */
+	if (state->literal) {
+		if (destcnt == destlen)
+			return EOK;
 
-	do {
-		int err = huffman_decode(state, len_code, &symbol);
-		if (err != EOK) {
-			/* Error decoding */
-			return err;
+		dest[destcnt] = state->literal_value;
+		destcnt++;
+		state->literal = false;
+	}
+
+	if (state->copy_len > 0) {
+		size_t len = state->copy_len;
+		if (len > destlen - destcnt)
+			len = destlen - destcnt;
+
+		copy_match(dest + destcnt, state->copy_dist, len);
+		destcnt += len;
+		state->copy_len -= len;
+
+		if (state->copy_len > 0) {
+			state->destcnt = destcnt;
+			return EOK;
 		}
+	}
+
+	while (true) {
+		if (state->bitlen < MAX_PAIR_BITS)
+			bits_refill(state);
+
+		uint16_t symbol;
+		err = huffman_decode(state, &state->len_code, &symbol);
+		if (err != EOK)
+			break;
 
 		if (symbol < 256) {
 			/* Write out literal */
-			if (state->destcnt == state->destlen)
-				return ENOMEM;
+			if (destcnt == destlen) {
+				state->literal = true;
+				state->literal_value = (uint8_t) symbol;
+				break;
+			}
 
-			state->dest[state->destcnt] = (uint8_t) symbol;
-			state->destcnt++;
-		} else if (symbol > 256) {
-			/* Compute length */
-			symbol -= 257;
-			if (symbol >= 29)
-				return EINVAL;
+			dest[destcnt] = (uint8_t) symbol;
+			destcnt++;
+			continue;
+		}
 
-			size_t len = lens[symbol] + get_bits(state, lens_ext[symbol]);
-			CHECK_OVERRUN(*state);
+		if (symbol == 256) {
+			/* End of block */
+			state->mode = INFLATE_HEADER;
+			break;
+		}
 
-			/* Get distance */
-			err = huffman_decode(state, dist_code, &symbol);
-			if (err != EOK)
-				return err;
+		/* Compute length */
+		symbol -= 257;
+		if (symbol >= MAX_LEN) {
+			err = EINVAL;
+			break;
+		}
 
-			size_t dist = dists[symbol] + get_bits(state, dists_ext[symbol]);
-			if (dist > state->destcnt)
-				return ENOENT;
+		if (!bits_need(state, lens_ext[symbol])) {
+			err = ELIMIT;
+			break;
+		}
 
-			if (state->destcnt + len > state->destlen)
-				return ENOMEM;
+		size_t len = lens[symbol] + get_bits(state, lens_ext[symbol]);
 
-			while (len > 0) {
-				/* Copy len bytes from distance bytes back */
-				state->dest[state->destcnt] =
-				    state->dest[state->destcnt - dist];
-				state->destcnt++;
-				len--;
-			}
+		/* Get distance */
+		err = huffman_decode(state, &state->dist_code, &symbol);
+		if (err != EOK)
+			break;
+
+		if (symbol >= MAX_DIST) {
+			err = EINVAL;
+			break;
 		}
-	} while (symbol != 256);
 
-	return EOK;
+		if (!bits_need(state, dists_ext[symbol])) {
+			err = ELIMIT;
+			break;
+		}
+
+		size_t dist = dists[symbol] + get_bits(state, dists_ext[symbol]);
+		if (dist > destcnt) {
+			err = ENOENT;
+			break;
+		}
+
+		if (len > destlen - destcnt) {
+			/* Keep the rest of the match for the next call */
+			state->copy_len = len - (destlen - destcnt);
+			state->copy_dist = dist;
+			len = destlen - destcnt;
+		}
+
+		/* Copy len bytes from distance bytes back */
+		copy_match(dest + destcnt, dist, len);
+		destcnt += len;
+
+		if (state->copy_len > 0)
+			break;
+	}
+
+	state->destcnt = destcnt;
+	return err;
 }
 
-/** Decode `fixed codes' block
- *
- * @param state     Inflate state.
- * @param len_code  Huffman code for literal/length.
- * @param dist_code Huffman code for distance.
+/** Prepare tables for a `fixed codes' block
  *
- * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code.
- * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
+ * @param state Inflate state.
  *
  */
-static int inflate_fixed(inflate_state_t *state, huffman_t *len_code,
-    huffman_t *dist_code)
+static void inflate_fixed(inflate_state_t *state)
 {
-	return inflate_codes(state, len_code, dist_code);
+	if (!state->fixed) {
+		uint16_t length[MAX_FIXED_LITLEN];
+		size_t symbol;
+
+		for (symbol = 0; symbol < 144; symbol++)
+			length[symbol] = 8;
+		for (; symbol < 256; symbol++)
+			length[symbol] = 9;
+		for (; symbol < 280; symbol++)
+			length[symbol] = 7;
+		for (; symbol < MAX_FIXED_LITLEN; symbol++)
+			length[symbol] = 8;
+
+		(void) huffman_construct(&state->len_code, length,
+		    MAX_FIXED_LITLEN);
+
+		for (symbol = 0; symbol < MAX_FIXED_DIST; symbol++)
+			length[symbol] = 5;
+
+		(void) huffman_construct(&state->dist_code, length,
+		    MAX_FIXED_DIST);
+
+		state->fixed = true;
+	}
+
+	state->mode = INFLATE_CODES;
 }
 
-/** Decode `dynamic codes' block
+/** Decode `dynamic codes' block header
  *
  * @param state     Inflate state.
  *
  * @return EOK on success.
- * @return ENOENT on distance too large.
- * @return EINVAL on invalid Huffman code.
+ * @return EINVAL on invalid Huffman code or invalid deflate data.
  * @return ELIMIT on input buffer overrun.
- * @return ENOMEM on output buffer overrun.
  *
  */
 static int inflate_dynamic(inflate_state_t *state)
 {
 	uint16_t length[MAX_CODE];
-	uint16_t dyn_len_count[MAX_HUFFMAN_BIT + 1];
-	uint16_t dyn_len_symbol[MAX_LITLEN];
-	uint16_t dyn_dist_count[MAX_HUFFMAN_BIT + 1];
-	uint16_t dyn_dist_symbol[MAX_DIST];
-	huffman_t dyn_len_code;
-	huffman_t dyn_dist_code;
 
-	dyn_len_code.count = dyn_len_count;
-	dyn_len_code.symbol = dyn_len_symbol;
-
-	dyn_dist_code.count = dyn_dist_count;
-	dyn_dist_code.symbol = dyn_dist_symbol;
+	/* The tables are going to be overwritten */
+	state->fixed = false;
 
 	/* Get number of bits in each table */
-	uint16_t nlen = get_bits(state, 5) + 257;
-	CHECK_OVERRUN(*state);
+	if (!bits_need(state, 14))
+		return ELIMIT;
 
+	uint16_t nlen = get_bits(state, 5) + 257;
 	uint16_t ndist = get_bits(state, 5) + 1;
-	CHECK_OVERRUN(*state);
-
 	uint16_t ncode = get_bits(state, 4) + 4;
-	CHECK_OVERRUN(*state);
 
 	if ((nlen > MAX_LITLEN) || (ndist > MAX_DIST) ||
 	    (ncode > MAX_ORDER))
@@ -542,16 +727,19 @@ static int inflate_dynamic(inflate_state_t *state)
 	/* Read code length code lengths */
 	uint16_t index;
 	for (index = 0; index < ncode; index++) {
+		if (!bits_need(state, 3))
+			return ELIMIT;
+
 		length[order[index]] = get_bits(state, 3);
-		CHECK_OVERRUN(*state);
 	}
 
 	/* Set missing lengths to zero */
 	for (index = ncode; index < MAX_ORDER; index++)
 		length[order[index]] = 0;
 
-	/* Build Huffman code */
-	int16_t rc = huffman_construct(&dyn_len_code, length, MAX_ORDER);
+	/* Build Huffman code (temporarily in the distance tables) */
+	huffman_t *code_code = &state->dist_code;
+	int16_t rc = huffman_construct(code_code, length, MAX_ORDER);
 	if (rc != 0)
 		return EINVAL;
 
@@ -559,9 +747,9 @@ static int inflate_dynamic(inflate_state_t *state)
 	index = 0;
 	while (index < nlen + ndist) {
 		uint16_t symbol;
-		int err = huffman_decode(state, &dyn_len_code, &symbol);
+		int err = huffman_decode(state, code_code, &symbol);
 		if (err != EOK)
-			return EOK;
+			return err;
 
 		if (symbol < 16) {
 			length[index] = symbol;
@@ -569,19 +757,19 @@ static int inflate_dynamic(inflate_state_t *state)
 		} else {
 			uint16_t len = 0;
 
+			if (!bits_need(state, 7))
+				return ELIMIT;
+
 			if (symbol == 16) {
 				if (index == 0)
 					return EINVAL;
 
 				len = length[index - 1];
 				symbol = get_bits(state, 2) + 3;
-				CHECK_OVERRUN(*state);
 			} else if (symbol == 17) {
 				symbol = get_bits(state, 3) + 3;
-				CHECK_OVERRUN(*state);
 			} else {
 				symbol = get_bits(state, 7) + 11;
-				CHECK_OVERRUN(*state);
 			}
 
 			if (index + symbol > nlen + ndist)
@@ -600,16 +788,92 @@ static int inflate_dynamic(inflate_state_t *state)
 		return EINVAL;
 
 	/* Build Huffman tables for literal/length codes */
-	rc = huffman_construct(&dyn_len_code, length, nlen);
-	if ((rc < 0) || ((rc > 0) && (dyn_len_code.count[0] + 1 != nlen)))
+	rc = huffman_construct(&state->len_code, length, nlen);
+	if ((rc < 0) || ((rc > 0) && (state->len_code.count[0] + 1 != nlen)))
 		return EINVAL;
 
 	/* Build Huffman tables for distance codes */
-	rc = huffman_construct(&dyn_dist_code, length + nlen, ndist);
-	if ((rc < 0) || ((rc > 0) && (dyn_dist_code.count[0] + 1 != ndist)))
+	rc = huffman_construct(&state->dist_code, length + nlen, ndist);
+	if ((rc < 0) || ((rc > 0) && (state->dist_code.count[0] + 1 != ndist)))
 		return EINVAL;
 
-	return inflate_codes(state, &dyn_len_code, &dyn_dist_code);
+	state->mode = INFLATE_CODES;
+	return EOK;
+}
+
+/** Run the decoder
+ *
+ * Decode until the end of the deflate stream or until the output
+ * buffer becomes full.
+ *
+ * @param state Inflate state.
+ *
+ * @return EOK on success.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid Huffman code or invalid deflate data.
+ * @return ELIMIT on input buffer overrun.
+ *
+ */
+static int inflate_run(inflate_state_t *state)
+{
+	int ret = EOK;
+
+	while (ret == EOK) {
+		switch (state->mode) {
+		case INFLATE_HEADER:
+			if (state->last) {
+				state->mode = INFLATE_DONE;
+				return EOK;
+			}
+
+			if (!bits_need(state, 3))
+				return ELIMIT;
+
+			/* Last block is indicated by a non-zero bit */
+			state->last = get_bits(state, 1);
+
+			/* Block type */
+			switch (get_bits(state, 2)) {
+			case 0:
+				ret = inflate_stored_header(state);
+				break;
+			case 1:
+				inflate_fixed(state);
+				break;
+			case 2:
+				ret = inflate_dynamic(state);
+				break;
+			default:
+				ret = EINVAL;
+			}
+			break;
+		case INFLATE_STORED:
+			ret = inflate_stored(state);
+			if (state->mode == INFLATE_STORED)
+				return ret;
+			break;
+		case INFLATE_CODES:
+			ret = inflate_codes(state);
+			if (state->mode == INFLATE_CODES)
+				return ret;
+			break;
+		case INFLATE_DONE:
+			return EOK;
+		}
+	}
+
+	return ret;
+}
+
+/** Initialize the decoder state
+ *
+ * @param state Inflate state.
+ *
+ */
+static void inflate_init(inflate_state_t *state)
+{
+	memset(state, 0, offsetof(inflate_state_t, len_code));
+	state->mode = INFLATE_HEADER;
 }
 
 /** Inflate data
@@ -629,47 +893,20 @@ static int inflate_dynamic(inflate_state_t *state)
 int inflate(const void *src, size_t srclen, void *dest, size_t destlen)
 {
 	/* Initialize the state */
-	inflate_state_t state;
+	static inflate_state_t state;
+	inflate_init(&state);
 
 	state.dest = (uint8_t *) dest;
 	state.destlen = destlen;
-	state.destcnt = 0;
 
 	state.src = (const uint8_t *) src;
 	state.srclen = srclen;
-	state.srccnt = 0;
-
-	state.bitbuf = 0;
-	state.bitlen = 0;
-
-	state.overrun = false;
-
-	uint16_t last;
-	int ret = 0;
 
-	do {
-		/* Last block is indicated by a non-zero bit */
-		last = get_bits(&state, 1);
-		CHECK_OVERRUN(state);
-
-		/* Block type */
-		uint16_t type = get_bits(&state, 2);
-		CHECK_OVERRUN(state);
-
-		switch (type) {
-		case 0:
-			ret = inflate_stored(&state);
-			break;
-		case 1:
-			ret = inflate_fixed(&state, &len_code, &dist_code);
-			break;
-		case 2:
-			ret = inflate_dynamic(&state);
-			break;
-		default:
-			ret = EINVAL;
-		}
-	} while ((!last) && (ret == 0));
+	int ret = inflate_run(&state);
+	if ((ret == EOK) && (state.mode != INFLATE_DONE)) {
+		/* Decoding stopped on a full output buffer */
+		return ENOMEM;
+	}
 
 	return ret;
 }
@@ -41,9 +41,11 @@
 
 #define INTEL_CPUID_LEVEL     0x00000000
 #define INTEL_CPUID_STANDARD  0x00000001
+#define INTEL_CPUID_FEATURES  0x00000007
 #define INTEL_CPUID_EXTENDED  0x80000000
 #define INTEL_SSE2            26
 #define INTEL_FXSAVE          24
+#define INTEL_ERMS            9
 
 #ifndef __ASSEMBLER__
 
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_amd64
+ * @{
+ */
+/** @file
+ * @brief Architecture-specific block memory operations.
+ *
+ * The kernel cannot use the SSE registers, so the string instructions
+ * are the fastest way to move large blocks. They are used from 2 KiB
+ * up on all processors and from 256 B up on processors with Enhanced
+ * REP MOVSB/STOSB (ERMS). The threshold is set in cpu_identify().
+ */
+
+#ifndef KERN_amd64_MEMFNC_H_
+#define KERN_amd64_MEMFNC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <trace.h>
+
+#define ARCH_MEMFNC_LARGE
+
+#define MEMFNC_LARGE_FAST_STRINGS  2048
+#define MEMFNC_LARGE_ERMS          256
+
+/** Copy a large non-overlapping block. */
+_NO_TRACE static inline void memcpy_large(void *dst, const void *src,
+    size_t cnt)
+{
+	size_t words = cnt >> 3;
+	size_t rest = cnt & 7;
+
+	asm volatile (
+	    "rep movsq\n"
+	    "movq %[rest], %%rcx\n"
+	    "rep movsb\n"
+	    : "+D" (dst), "+S" (src), "+c" (words)
+	    : [rest] "r" (rest)
+	    : "memory"
+	);
+}
+
+/** Fill a large block with a constant byte. */
+_NO_TRACE static inline void memset_large(void *dst, uint8_t val, size_t cnt)
+{
+	size_t words = cnt >> 3;
+	size_t rest = cnt & 7;
+
+	asm volatile (
+	    "rep stosq\n"
+	    "movq %[rest], %%rcx\n"
+	    "rep stosb\n"
+	    : "+D" (dst), "+c" (words)
+	    : "a" (val * UINT64_C(0x0101010101010101)), [rest] "r" (rest)
+	    : "memory"
+	);
+}
+
+#endif
+
+/** @}
+ */
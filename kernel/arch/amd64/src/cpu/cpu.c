@@ -36,6 +36,7 @@
 #include <arch/cpu.h>
 #include <arch/cpuid.h>
 #include <arch/pm.h>
+#include <lib/memfnc.h>
 
 #include <arch.h>
 #include <stdio.h>
@@ -108,6 +109,7 @@ void cpu_identify(void)
 	CPU->arch.vendor = VendorUnknown;
 	if (has_cpuid()) {
 		cpuid(INTEL_CPUID_LEVEL, &info);
+		uint32_t max_level = info.cpuid_eax;
 
 		/*
 		 * Check for AMD processor.
@@ -131,6 +133,17 @@ void cpu_identify(void)
 		CPU->arch.family = (info.cpuid_eax >> 8) & 0xf;
 		CPU->arch.model = (info.cpuid_eax >> 4) & 0xf;
 		CPU->arch.stepping = (info.cpuid_eax >> 0) & 0xf;
+
+		/*
+		 * Choose the size from which memcpy() and memset() use
+		 * the string instructions.
+		 */
+		memfnc_large = MEMFNC_LARGE_FAST_STRINGS;
+		if (max_level >= INTEL_CPUID_FEATURES) {
+			cpuid(INTEL_CPUID_FEATURES, &info);
+			if (info.cpuid_ebx & (1 << INTEL_ERMS))
+				memfnc_large = MEMFNC_LARGE_ERMS;
+		}
 	}
 }
 
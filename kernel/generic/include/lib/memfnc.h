@@ -37,6 +37,7 @@
 
 #include <stddef.h>
 #include <cc.h>
+#include <arch/memfnc.h>
 
 #ifdef CONFIG_LTO
 #define DO_NOT_DISCARD ATTRIBUTE_USED
@@ -54,6 +55,10 @@ extern int memcmp(const void *, const void *, size_t len)
     __attribute__((nonnull(1, 2)))
     ATTRIBUTE_OPTIMIZE("-fno-tree-loop-distribute-patterns") DO_NOT_DISCARD;
 
+#ifdef ARCH_MEMFNC_LARGE
+extern size_t memfnc_large;
+#endif
+
 #define alloca(size) __builtin_alloca((size))
 
 #endif
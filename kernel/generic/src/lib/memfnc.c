@@ -40,8 +40,45 @@
  */
 
 #include <lib/memfnc.h>
+#include <stdint.h>
 #include <typedefs.h>
 
+/*
+ * Blocks of up to SMALL_SIZE bytes are handled by a pair of possibly
+ * overlapping word accesses, longer blocks by a loop over aligned
+ * destination words. Architectures with fast block move instructions
+ * use them for blocks of at least memfnc_large bytes.
+ */
+#define SMALL_SIZE  16
+
+#define WORD_SIZE  sizeof(unsigned long)
+
+#ifdef ARCH_MEMFNC_LARGE
+
+/** Smallest block handed to the architecture block operations.
+ *
+ * Lowered by the architecture once it has identified the processor.
+ */
+size_t memfnc_large = SIZE_MAX;
+
+#endif
+
+struct aword {
+	unsigned long n;
+} __attribute__((packed));
+
+struct a64 {
+	uint64_t n;
+} __attribute__((packed));
+
+struct a32 {
+	uint32_t n;
+} __attribute__((packed));
+
+struct a16 {
+	uint16_t n;
+} __attribute__((packed));
+
 /** Fill block of memory.
  *
  * Fill cnt bytes at dst address with the value val.
@@ -56,9 +93,40 @@
 void *memset(void *dst, int val, size_t cnt)
 {
 	uint8_t *dp = (uint8_t *) dst;
+	uint64_t pattern = (uint8_t) val * UINT64_C(0x0101010101010101);
+
+	if (cnt <= SMALL_SIZE) {
+		if (cnt >= 8) {
+			((struct a64 *) dp)->n = pattern;
+			((struct a64 *) (dp + cnt - 8))->n = pattern;
+		} else if (cnt >= 4) {
+			((struct a32 *) dp)->n = pattern;
+			((struct a32 *) (dp + cnt - 4))->n = pattern;
+		} else if (cnt >= 2) {
+			((struct a16 *) dp)->n = pattern;
+			((struct a16 *) (dp + cnt - 2))->n = pattern;
+		} else if (cnt == 1) {
+			*dp = val;
+		}
 
-	while (cnt-- != 0)
-		*dp++ = val;
+		return dst;
+	}
+
+#ifdef ARCH_MEMFNC_LARGE
+	if (cnt >= memfnc_large) {
+		memset_large(dst, val, cnt);
+		return dst;
+	}
+#endif
+
+	/* Unaligned first and last word, aligned words in between. */
+	size_t i = WORD_SIZE - ((uintptr_t) dp & (WORD_SIZE - 1));
+	size_t end = cnt - WORD_SIZE;
+
+	((struct aword *) dp)->n = pattern;
+	for (; i < end; i += WORD_SIZE)
+		*(unsigned long *) (dp + i) = pattern;
+	((struct aword *) (dp + end))->n = pattern;
 
 	return dst;
 }
@@ -80,8 +148,53 @@ void *memcpy(void *dst, const void *src, size_t cnt)
 	uint8_t *dp = (uint8_t *) dst;
 	const uint8_t *sp = (uint8_t *) src;
 
-	while (cnt-- != 0)
-		*dp++ = *sp++;
+	if (cnt <= SMALL_SIZE) {
+		if (cnt >= 8) {
+			uint64_t head = ((const struct a64 *) sp)->n;
+			uint64_t tail = ((const struct a64 *) (sp + cnt - 8))->n;
+			((struct a64 *) dp)->n = head;
+			((struct a64 *) (dp + cnt - 8))->n = tail;
+		} else if (cnt >= 4) {
+			uint32_t head = ((const struct a32 *) sp)->n;
+			uint32_t tail = ((const struct a32 *) (sp + cnt - 4))->n;
+			((struct a32 *) dp)->n = head;
+			((struct a32 *) (dp + cnt - 4))->n = tail;
+		} else if (cnt >= 2) {
+			uint16_t head = ((const struct a16 *) sp)->n;
+			uint16_t tail = ((const struct a16 *) (sp + cnt - 2))->n;
+			((struct a16 *) dp)->n = head;
+			((struct a16 *) (dp + cnt - 2))->n = tail;
+		} else if (cnt == 1) {
+			*dp = *sp;
+		}
+
+		return dst;
+	}
+
+#ifdef ARCH_MEMFNC_LARGE
+	if (cnt >= memfnc_large) {
+		memcpy_large(dst, src, cnt);
+		return dst;
+	}
+#endif
+
+	/* Unaligned first and last word, aligned words in between. */
+	unsigned long head = ((const struct aword *) sp)->n;
+	unsigned long tail = ((const struct aword *) (sp + cnt - WORD_SIZE))->n;
+
+	size_t i = WORD_SIZE - ((uintptr_t) dp & (WORD_SIZE - 1));
+	size_t end = cnt - WORD_SIZE;
+
+	if (((uintptr_t) (sp + i) & (WORD_SIZE - 1)) == 0) {
+		for (; i < end; i += WORD_SIZE)
+			*(unsigned long *) (dp + i) = *(const unsigned long *) (sp + i);
+	} else {
+		for (; i < end; i += WORD_SIZE)
+			*(unsigned long *) (dp + i) = ((const struct aword *) (sp + i))->n;
+	}
+
+	((struct aword *) dp)->n = head;
+	((struct aword *) (dp + end))->n = tail;
 
 	return dst;
 }
@@ -40,7 +40,10 @@
 #include <print.h>
 #include <stdarg.h>
 #include <macros.h>
+#include <mem.h>
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <str.h>
 #include <arch.h>
 
@@ -75,6 +78,12 @@
  */
 #define PRINT_NUMBER_BUFFER_SIZE  (64 + 5)
 
+/**
+ * Size of the buffer printf_core() collects output in. It lives on the
+ * stack, kernel stacks are small.
+ */
+#define PRINTF_BUFFER_SIZE  128
+
 /** Get signed or unsigned integer argument */
 #define PRINTF_GET_INT_ARGUMENT(type, ap, flags) \
 	({ \
@@ -112,20 +121,216 @@ static const char *digits_small = "0123456789abcdef";
 static const char *digits_big = "0123456789ABCDEF";
 static const char invalch = U_SPECIAL;
 
+/** Decimal representation of 0 to 99, two digits each */
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/** Output collected by printf_core() before it is handed to the caller. */
+typedef struct {
+	/** Output methods of the caller */
+	printf_spec_t *ps;
+	/** Characters reported as printed by the caller's output methods */
+	size_t counter;
+	/** Number of bytes used in buf */
+	size_t len;
+	/** An output method of the caller has failed */
+	bool error;
+	/** Pending output */
+	char buf[PRINTF_BUFFER_SIZE];
+} printf_buffer_t;
+
+/** Hand pending output over to the caller's output method.
+ *
+ * @param pb Output buffer.
+ *
+ * @return Zero on success, negative value on failure.
+ *
+ */
+static int printf_flush(printf_buffer_t *pb)
+{
+	if (pb->error)
+		return -1;
+
+	if (pb->len == 0)
+		return 0;
+
+	int ret = pb->ps->str_write(pb->buf, pb->len, pb->ps->data);
+	pb->len = 0;
+
+	if (ret < 0) {
+		pb->error = true;
+		return -1;
+	}
+
+	pb->counter += ret;
+	return 0;
+}
+
+/** Append characters to the output buffer.
+ *
+ * The buffer is flushed before it would have to split @a str, so the
+ * caller's output method always gets whole characters. Strings that do not
+ * fit into an empty buffer are passed on directly.
+ *
+ * @param str  Characters to print.
+ * @param size Number of bytes in @a str.
+ * @param pb   Output buffer.
+ *
+ * @return Number of bytes accepted, negative value on failure.
+ *
+ */
+static int printf_write(const char *str, size_t size, printf_buffer_t *pb)
+{
+	if (size > PRINTF_BUFFER_SIZE - pb->len) {
+		if (printf_flush(pb) < 0)
+			return -1;
+
+		if (size > PRINTF_BUFFER_SIZE) {
+			int ret = pb->ps->str_write(str, size, pb->ps->data);
+			if (ret < 0) {
+				pb->error = true;
+				return -1;
+			}
+
+			pb->counter += ret;
+			return ret;
+		}
+	}
+
+	if (pb->error)
+		return -1;
+
+	memcpy(pb->buf + pb->len, str, size);
+	pb->len += size;
+	return (int) size;
+}
+
+/** Print wide characters after the pending output.
+ *
+ * Unlike printf_write(), the result is not added to the counter of
+ * printed characters, that is up to the caller.
+ *
+ * @param str  Wide characters to print.
+ * @param size Number of bytes in @a str.
+ * @param pb   Output buffer.
+ *
+ * @return Return value of the caller's output method, negative value
+ *         on failure.
+ *
+ */
+static int printf_wwrite(const wchar_t *str, size_t size, printf_buffer_t *pb)
+{
+	if (printf_flush(pb) < 0)
+		return -1;
+
+	int ret = pb->ps->wstr_write(str, size, pb->ps->data);
+	if (ret < 0) {
+		pb->error = true;
+		return -1;
+	}
+
+	return ret;
+}
+
+/** Convert a number to digits in a given base.
+ *
+ * Decimal numbers are converted two digits per division, 32-bit
+ * arithmetic is used as soon as the rest of the number fits. Bases that
+ * are powers of two need no division at all.
+ *
+ * @param num    Number to convert.
+ * @param base   Base to convert the number to (between 2 and 16).
+ * @param digits Digits of the base.
+ * @param end    End of the output buffer.
+ *
+ * @return Pointer to the first digit, the last one is stored right
+ *         before @a end.
+ *
+ */
+static char *number_to_str(uint64_t num, unsigned int base,
+    const char *digits, char *end)
+{
+	char *ptr = end;
+
+	if (base == 10) {
+		while (num > UINT32_MAX) {
+			unsigned int rem = num % 100;
+			num /= 100;
+			ptr -= 2;
+			ptr[0] = digit_pairs[2 * rem];
+			ptr[1] = digit_pairs[2 * rem + 1];
+		}
+
+		uint32_t n = (uint32_t) num;
+		while (n >= 100) {
+			unsigned int rem = n % 100;
+			n /= 100;
+			ptr -= 2;
+			ptr[0] = digit_pairs[2 * rem];
+			ptr[1] = digit_pairs[2 * rem + 1];
+		}
+
+		if (n >= 10) {
+			ptr -= 2;
+			ptr[0] = digit_pairs[2 * n];
+			ptr[1] = digit_pairs[2 * n + 1];
+		} else {
+			*--ptr = '0' + n;
+		}
+
+		return ptr;
+	}
+
+	unsigned int shift;
+	switch (base) {
+	case 2:
+		shift = 1;
+		break;
+	case 8:
+		shift = 3;
+		break;
+	case 16:
+		shift = 4;
+		break;
+	default:
+		do {
+			*--ptr = digits[num % base];
+		} while (num /= base);
+
+		return ptr;
+	}
+
+	do {
+		*--ptr = digits[num & (base - 1)];
+		num >>= shift;
+	} while (num != 0);
+
+	return ptr;
+}
+
 /** Print one or more characters without adding newline.
  *
  * @param buf  Buffer holding characters with size of
  *             at least size bytes. NULL is not allowed!
  * @param size Size of the buffer in bytes.
- * @param ps   Output method and its data.
+ * @param pb   Output buffer.
  *
  * @return Number of characters printed.
  *
  */
 static int printf_putnchars(const char *buf, size_t size,
-    printf_spec_t *ps)
+    printf_buffer_t *pb)
 {
-	return ps->str_write((void *) buf, size, ps->data);
+	return printf_write(buf, size, pb);
 }
 
 /** Print one or more wide characters without adding newline.
@@ -133,63 +338,71 @@ static int printf_putnchars(const char *buf, size_t size,
  * @param buf  Buffer holding wide characters with size of
  *             at least size bytes. NULL is not allowed!
  * @param size Size of the buffer in bytes.
- * @param ps   Output method and its data.
+ * @param pb   Output buffer.
  *
  * @return Number of wide characters printed.
  *
  */
 static int printf_wputnchars(const wchar_t *buf, size_t size,
-    printf_spec_t *ps)
+    printf_buffer_t *pb)
 {
-	return ps->wstr_write((void *) buf, size, ps->data);
+	int ret = printf_wwrite(buf, size, pb);
+	if (ret > 0)
+		pb->counter += ret;
+
+	return ret;
 }
 
 /** Print string without adding a newline.
  *
  * @param str String to print.
- * @param ps  Write function specification and support data.
+ * @param pb  Output buffer.
  *
  * @return Number of characters printed.
  *
  */
-static int printf_putstr(const char *str, printf_spec_t *ps)
+static int printf_putstr(const char *str, printf_buffer_t *pb)
 {
 	if (str == NULL)
-		return printf_putnchars(nullstr, str_size(nullstr), ps);
+		return printf_putnchars(nullstr, str_size(nullstr), pb);
 
-	return ps->str_write((void *) str, str_size(str), ps->data);
+	return printf_write(str, str_size(str), pb);
 }
 
 /** Print one ASCII character.
  *
  * @param c  ASCII character to be printed.
- * @param ps Output method.
+ * @param pb Output buffer.
  *
  * @return Number of characters printed.
  *
  */
-static int printf_putchar(const char ch, printf_spec_t *ps)
+static int printf_putchar(const char ch, printf_buffer_t *pb)
 {
 	if (!ascii_check(ch))
-		return ps->str_write((void *) &invalch, 1, ps->data);
+		return printf_write(&invalch, 1, pb);
 
-	return ps->str_write(&ch, 1, ps->data);
+	return printf_write(&ch, 1, pb);
 }
 
 /** Print one wide character.
  *
  * @param c  Wide character to be printed.
- * @param ps Output method.
+ * @param pb Output buffer.
  *
  * @return Number of characters printed.
  *
  */
-static int printf_putwchar(const wchar_t ch, printf_spec_t *ps)
+static int printf_putwchar(const wchar_t ch, printf_buffer_t *pb)
 {
 	if (!chr_check(ch))
-		return ps->str_write((void *) &invalch, 1, ps->data);
+		return printf_write(&invalch, 1, pb);
 
-	return ps->wstr_write(&ch, sizeof(wchar_t), ps->data);
+	int ret = printf_wwrite(&ch, sizeof(wchar_t), pb);
+	if (ret > 0)
+		pb->counter++;
+
+	return ret;
 }
 
 /** Print one formatted ASCII character.
@@ -201,7 +414,7 @@ static int printf_putwchar(const wchar_t ch, printf_spec_t *ps)
  * @return Number of characters printed, negative value on failure.
  *
  */
-static int print_char(const char ch, int width, uint32_t flags, printf_spec_t *ps)
+static int print_char(const char ch, int width, uint32_t flags, printf_buffer_t *pb)
 {
 	size_t counter = 0;
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
@@ -210,12 +423,12 @@ static int print_char(const char ch, int width, uint32_t flags, printf_spec_t *p
 			 * One space is consumed by the character itself, hence
 			 * the predecrement.
 			 */
-			if (printf_putchar(' ', ps) > 0)
+			if (printf_putchar(' ', pb) > 0)
 				counter++;
 		}
 	}
 
-	if (printf_putchar(ch, ps) > 0)
+	if (printf_putchar(ch, pb) > 0)
 		counter++;
 
 	while (--width > 0) {
@@ -223,7 +436,7 @@ static int print_char(const char ch, int width, uint32_t flags, printf_spec_t *p
 		 * One space is consumed by the character itself, hence
 		 * the predecrement.
 		 */
-		if (printf_putchar(' ', ps) > 0)
+		if (printf_putchar(' ', pb) > 0)
 			counter++;
 	}
 
@@ -239,7 +452,7 @@ static int print_char(const char ch, int width, uint32_t flags, printf_spec_t *p
  * @return Number of characters printed, negative value on failure.
  *
  */
-static int print_wchar(const wchar_t ch, int width, uint32_t flags, printf_spec_t *ps)
+static int print_wchar(const wchar_t ch, int width, uint32_t flags, printf_buffer_t *pb)
 {
 	size_t counter = 0;
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
@@ -248,12 +461,12 @@ static int print_wchar(const wchar_t ch, int width, uint32_t flags, printf_spec_
 			 * One space is consumed by the character itself, hence
 			 * the predecrement.
 			 */
-			if (printf_putchar(' ', ps) > 0)
+			if (printf_putchar(' ', pb) > 0)
 				counter++;
 		}
 	}
 
-	if (printf_putwchar(ch, ps) > 0)
+	if (printf_putwchar(ch, pb) > 0)
 		counter++;
 
 	while (--width > 0) {
@@ -261,7 +474,7 @@ static int print_wchar(const wchar_t ch, int width, uint32_t flags, printf_spec_
 		 * One space is consumed by the character itself, hence
 		 * the predecrement.
 		 */
-		if (printf_putchar(' ', ps) > 0)
+		if (printf_putchar(' ', pb) > 0)
 			counter++;
 	}
 
@@ -278,10 +491,10 @@ static int print_wchar(const wchar_t ch, int width, uint32_t flags, printf_spec_
  * @return Number of characters printed, negative value on failure.
  */
 static int print_str(char *str, int width, unsigned int precision,
-    uint32_t flags, printf_spec_t *ps)
+    uint32_t flags, printf_buffer_t *pb)
 {
 	if (str == NULL)
-		return printf_putstr(nullstr, ps);
+		return printf_putstr(nullstr, pb);
 
 	/* Print leading spaces. */
 	size_t strw = str_length(str);
@@ -293,7 +506,7 @@ static int print_str(char *str, int width, unsigned int precision,
 	width -= precision;
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
 		while (width-- > 0) {
-			if (printf_putchar(' ', ps) == 1)
+			if (printf_putchar(' ', pb) == 1)
 				counter++;
 		}
 	}
@@ -301,14 +514,14 @@ static int print_str(char *str, int width, unsigned int precision,
 	/* Part of @a str fitting into the alloted space. */
 	int retval;
 	size_t size = str_lsize(str, precision);
-	if ((retval = printf_putnchars(str, size, ps)) < 0)
+	if ((retval = printf_putnchars(str, size, pb)) < 0)
 		return -counter;
 
 	counter += retval;
 
 	/* Right padding */
 	while (width-- > 0) {
-		if (printf_putchar(' ', ps) == 1)
+		if (printf_putchar(' ', pb) == 1)
 			counter++;
 	}
 
@@ -326,10 +539,10 @@ static int print_str(char *str, int width, unsigned int precision,
  * @return Number of wide characters printed, negative value on failure.
  */
 static int print_wstr(wchar_t *str, int width, unsigned int precision,
-    uint32_t flags, printf_spec_t *ps)
+    uint32_t flags, printf_buffer_t *pb)
 {
 	if (str == NULL)
-		return printf_putstr(nullstr, ps);
+		return printf_putstr(nullstr, pb);
 
 	/* Print leading spaces. */
 	size_t strw = wstr_length(str);
@@ -341,7 +554,7 @@ static int print_wstr(wchar_t *str, int width, unsigned int precision,
 	width -= precision;
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
 		while (width-- > 0) {
-			if (printf_putchar(' ', ps) == 1)
+			if (printf_putchar(' ', pb) == 1)
 				counter++;
 		}
 	}
@@ -349,14 +562,14 @@ static int print_wstr(wchar_t *str, int width, unsigned int precision,
 	/* Part of @a wstr fitting into the alloted space. */
 	int retval;
 	size_t size = wstr_lsize(str, precision);
-	if ((retval = printf_wputnchars(str, size, ps)) < 0)
+	if ((retval = printf_wputnchars(str, size, pb)) < 0)
 		return -counter;
 
 	counter += retval;
 
 	/* Right padding */
 	while (width-- > 0) {
-		if (printf_putchar(' ', ps) == 1)
+		if (printf_putchar(' ', pb) == 1)
 			counter++;
 	}
 
@@ -377,7 +590,7 @@ static int print_wstr(wchar_t *str, int width, unsigned int precision,
  *
  */
 static int print_number(uint64_t num, int width, int precision, int base,
-    uint32_t flags, printf_spec_t *ps)
+    uint32_t flags, printf_buffer_t *pb)
 {
 	const char *digits;
 	if (flags & __PRINTF_FLAG_BIGCHARS)
@@ -386,23 +599,11 @@ static int print_number(uint64_t num, int width, int precision, int base,
 		digits = digits_small;
 
 	char data[PRINT_NUMBER_BUFFER_SIZE];
-	char *ptr = &data[PRINT_NUMBER_BUFFER_SIZE - 1];
+	char *end = &data[PRINT_NUMBER_BUFFER_SIZE];
+	char *ptr = number_to_str(num, base, digits, end);
 
 	/* Size of number with all prefixes and signs */
-	int size = 0;
-
-	/* Put zero at end of string */
-	*ptr-- = 0;
-
-	if (num == 0) {
-		*ptr-- = '0';
-		size++;
-	} else {
-		do {
-			*ptr-- = digits[num % base];
-			size++;
-		} while (num /= base);
-	}
+	int size = end - ptr;
 
 	/* Size of plain number */
 	int number_size = size;
@@ -463,14 +664,14 @@ static int print_number(uint64_t num, int width, int precision, int base,
 
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
 		while (width-- > 0) {
-			if (printf_putchar(' ', ps) == 1)
+			if (printf_putchar(' ', pb) == 1)
 				counter++;
 		}
 	}
 
 	/* Print sign */
 	if (sgn) {
-		if (printf_putchar(sgn, ps) == 1)
+		if (printf_putchar(sgn, pb) == 1)
 			counter++;
 	}
 
@@ -479,28 +680,28 @@ static int print_number(uint64_t num, int width, int precision, int base,
 		switch (base) {
 		case 2:
 			/* Binary formating is not standard, but usefull */
-			if (printf_putchar('0', ps) == 1)
+			if (printf_putchar('0', pb) == 1)
 				counter++;
 			if (flags & __PRINTF_FLAG_BIGCHARS) {
-				if (printf_putchar('B', ps) == 1)
+				if (printf_putchar('B', pb) == 1)
 					counter++;
 			} else {
-				if (printf_putchar('b', ps) == 1)
+				if (printf_putchar('b', pb) == 1)
 					counter++;
 			}
 			break;
 		case 8:
-			if (printf_putchar('o', ps) == 1)
+			if (printf_putchar('o', pb) == 1)
 				counter++;
 			break;
 		case 16:
-			if (printf_putchar('0', ps) == 1)
+			if (printf_putchar('0', pb) == 1)
 				counter++;
 			if (flags & __PRINTF_FLAG_BIGCHARS) {
-				if (printf_putchar('X', ps) == 1)
+				if (printf_putchar('X', pb) == 1)
 					counter++;
 			} else {
-				if (printf_putchar('x', ps) == 1)
+				if (printf_putchar('x', pb) == 1)
 					counter++;
 			}
 			break;
@@ -510,25 +711,52 @@ static int print_number(uint64_t num, int width, int precision, int base,
 	/* Print leading zeroes */
 	precision -= number_size;
 	while (precision-- > 0) {
-		if (printf_putchar('0', ps) == 1)
+		if (printf_putchar('0', pb) == 1)
 			counter++;
 	}
 
 	/* Print the number itself */
 	int retval;
-	if ((retval = printf_putstr(++ptr, ps)) > 0)
+	if ((retval = printf_putnchars(ptr, number_size, pb)) > 0)
 		counter += retval;
 
 	/* Print trailing spaces */
 
 	while (width-- > 0) {
-		if (printf_putchar(' ', ps) == 1)
+		if (printf_putchar(' ', pb) == 1)
 			counter++;
 	}
 
 	return ((int) counter);
 }
 
+/** Print a signed decimal number without any modifiers.
+ *
+ * This is what print_number() prints for a plain %d, minus the handling
+ * of flags, width and precision.
+ *
+ * @param num Number to print.
+ * @param pb  Output buffer.
+ *
+ * @return Number of characters printed, negative value on failure.
+ *
+ */
+static int print_decimal(int num, printf_buffer_t *pb)
+{
+	char data[PRINT_NUMBER_BUFFER_SIZE];
+	char *end = &data[PRINT_NUMBER_BUFFER_SIZE];
+	char *ptr;
+
+	if (num < 0) {
+		ptr = number_to_str(-(unsigned int) num, 10, digits_small, end);
+		*--ptr = '-';
+	} else {
+		ptr = number_to_str(num, 10, digits_small, end);
+	}
+
+	return printf_write(ptr, end - ptr, pb);
+}
+
 /** Print formatted string.
  *
  * Print string formatted according to the fmt parameter and variadic arguments.
@@ -624,10 +852,24 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 	size_t nxt = 0;  /* Index of the next character from fmt */
 	size_t j = 0;    /* Index to the first not printed nonformating character */
 
-	size_t counter = 0;   /* Number of characters printed */
 	int retval;           /* Return values from nested functions */
+	bool failed = false;
+
+	printf_buffer_t buffer = {
+		.ps = ps,
+		.counter = 0,
+		.len = 0,
+		.error = false
+	};
 
 	while (true) {
+		/*
+		 * Skip ordinary characters. Both '%' and the terminating zero
+		 * are ASCII, so they never appear inside a multibyte sequence.
+		 */
+		while ((fmt[nxt] != '%') && (fmt[nxt] != 0))
+			nxt++;
+
 		i = nxt;
 		wchar_t uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
 
@@ -638,16 +880,36 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 		if (uc == '%') {
 			/* Print common characters if any processed */
 			if (i > j) {
-				if ((retval = printf_putnchars(&fmt[j], i - j, ps)) < 0) {
+				if (printf_putnchars(&fmt[j], i - j, &buffer) < 0) {
 					/* Error */
-					counter = -counter;
+					failed = true;
 					goto out;
 				}
-				counter += retval;
 			}
 
 			j = i;
 
+			/* Fast path for plain %s and %d */
+			if (fmt[nxt] == 's') {
+				if (printf_putstr(va_arg(ap, char *), &buffer) < 0) {
+					failed = true;
+					goto out;
+				}
+
+				j = ++nxt;
+				continue;
+			}
+
+			if (fmt[nxt] == 'd') {
+				if (print_decimal(va_arg(ap, int), &buffer) < 0) {
+					failed = true;
+					goto out;
+				}
+
+				j = ++nxt;
+				continue;
+			}
+
 			/* Parse modifiers */
 			uint32_t flags = 0;
 			bool end = false;
@@ -788,30 +1050,26 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				 */
 			case 's':
 				if (qualifier == PrintfQualifierLong)
-					retval = print_wstr(va_arg(ap, wchar_t *), width, precision, flags, ps);
+					retval = print_wstr(va_arg(ap, wchar_t *), width, precision, flags, &buffer);
 				else
-					retval = print_str(va_arg(ap, char *), width, precision, flags, ps);
+					retval = print_str(va_arg(ap, char *), width, precision, flags, &buffer);
 
 				if (retval < 0) {
-					counter = -counter;
+					failed = true;
 					goto out;
 				}
-
-				counter += retval;
 				j = nxt;
 				continue;
 			case 'c':
 				if (qualifier == PrintfQualifierLong)
-					retval = print_wchar(va_arg(ap, wint_t), width, flags, ps);
+					retval = print_wchar(va_arg(ap, wint_t), width, flags, &buffer);
 				else
-					retval = print_char(va_arg(ap, unsigned int), width, flags, ps);
+					retval = print_char(va_arg(ap, unsigned int), width, flags, &buffer);
 
 				if (retval < 0) {
-					counter = -counter;
+					failed = true;
 					goto out;
 				}
-
-				counter += retval;
 				j = nxt;
 				continue;
 
@@ -903,32 +1161,35 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				break;
 			default:
 				/* Unknown qualifier */
-				counter = -counter;
+				failed = true;
 				goto out;
 			}
 
 			if ((retval = print_number(number, width, precision,
-			    base, flags, ps)) < 0) {
-				counter = -counter;
+			    base, flags, &buffer)) < 0) {
+				failed = true;
 				goto out;
 			}
-
-			counter += retval;
 			j = nxt;
 		}
 	}
 
 	if (i > j) {
-		if ((retval = printf_putnchars(&fmt[j], i - j, ps)) < 0) {
+		if (printf_putnchars(&fmt[j], i - j, &buffer) < 0) {
 			/* Error */
-			counter = -counter;
+			failed = true;
 			goto out;
 		}
-		counter += retval;
 	}
 
 out:
-	return ((int) counter);
+	if (printf_flush(&buffer) < 0)
+		failed = true;
+
+	if (failed)
+		return -((int) buffer.counter);
+
+	return ((int) buffer.counter);
 }
 
 /** @}
@@ -100,8 +100,18 @@
 
 #include <__bits/trycatch.hpp>
 
-int main()
+int main(int argc, char* argv[])
 {
+    if (argc > 1 && std::strcmp(argv[1], "--bench") == 0)
+    {
+        std::test::test_set bs{};
+        bs.add<std::test::sort_bench>();
+        bs.add<std::test::hash_bench>();
+        bs.add<std::test::iostream_bench>();
+
+        return bs.run(true) ? 0 : 1;
+    }
+
     std::test::test_set ts{};
     ts.add<std::test::vector_test>();
     ts.add<std::test::string_test>();
@@ -121,6 +131,8 @@ int main()
     ts.add<std::test::functional_test>();
     ts.add<std::test::algorithm_test>();
     ts.add<std::test::future_test>();
+    ts.add<std::test::atomic_test>();
+    ts.add<std::test::fstream_test>();
 
     return ts.run(true) ? 0 : 1;
 }
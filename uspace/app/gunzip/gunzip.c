@@ -33,92 +33,241 @@
  */
 
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <gzip.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+/** Size of a buffer for decompressed data */
+#define BUF_SIZE  65536
+
+/** Number of buffers for decompressed data */
+#define BUFS  4
+
+/** Writer of the decompressed data
+ *
+ * A separate fibril writes out the buffers filled by the decoder,
+ * so that decompression overlaps with writing.
+ *
+ */
+typedef struct {
+	FILE *file;                /**< Destination file */
+	fibril_mutex_t lock;       /**< Protects the fields below */
+	fibril_condvar_t cv;       /**< Signals any change */
+	void *bufs[BUFS];          /**< Ring of buffers */
+	size_t sizes[BUFS];        /**< Bytes of data in the buffers */
+	size_t head;               /**< First filled buffer */
+	size_t count;              /**< Number of filled buffers */
+	bool done;                 /**< No more buffers will be filled */
+	bool running;              /**< Writer fibril is running */
+	errno_t error;             /**< Write error */
+} gunzip_writer_t;
+
+/** Read compressed data from the source file
+ *
+ * @param arg   Source file.
+ * @param buf   Buffer to fill.
+ * @param size  Size of the buffer (bytes).
+ * @param nread Place to store the number of bytes read.
+ *
+ * @return EOK on success or EIO on read error.
+ *
+ */
+static errno_t gunzip_read(void *arg, void *buf, size_t size, size_t *nread)
+{
+	FILE *f = (FILE *) arg;
+
+	*nread = fread(buf, 1, size, f);
+	if ((*nread < size) && ferror(f))
+		return EIO;
+
+	return EOK;
+}
+
+/** Writer fibril
+ *
+ * @param arg Writer.
+ *
+ * @return Always EOK.
+ *
+ */
+static errno_t gunzip_writer_fibril(void *arg)
+{
+	gunzip_writer_t *writer = (gunzip_writer_t *) arg;
+
+	fibril_mutex_lock(&writer->lock);
+
+	while (true) {
+		while ((writer->count == 0) && (!writer->done))
+			fibril_condvar_wait(&writer->cv, &writer->lock);
+
+		if (writer->count == 0)
+			break;
+
+		void *buf = writer->bufs[writer->head];
+		size_t size = writer->sizes[writer->head];
+		fibril_mutex_unlock(&writer->lock);
+
+		size_t nwr = fwrite(buf, 1, size, writer->file);
+
+		fibril_mutex_lock(&writer->lock);
+
+		if ((nwr != size) && (writer->error == EOK))
+			writer->error = EIO;
+
+		writer->head = (writer->head + 1) % BUFS;
+		writer->count--;
+		fibril_condvar_broadcast(&writer->cv);
+	}
+
+	writer->running = false;
+	fibril_condvar_broadcast(&writer->cv);
+	fibril_mutex_unlock(&writer->lock);
+
+	return EOK;
+}
+
+/** Decompress the data while the writer writes them out
+ *
+ * @param reader GZIP reader.
+ * @param writer Writer.
+ *
+ * @return EOK on success.
+ * @return EIO on write error.
+ * @return Error code returned by the GZIP reader.
+ *
+ */
+static errno_t gunzip_run(gzip_reader_t *reader, gunzip_writer_t *writer)
+{
+	errno_t rc = EOK;
+	size_t nread;
+
+	fibril_mutex_lock(&writer->lock);
+
+	do {
+		while ((writer->count == BUFS) && (writer->error == EOK))
+			fibril_condvar_wait(&writer->cv, &writer->lock);
+
+		if (writer->error != EOK)
+			break;
+
+		/* The buffer is not used by the writer until it is filled */
+		size_t idx = (writer->head + writer->count) % BUFS;
+		fibril_mutex_unlock(&writer->lock);
+
+		rc = gzip_reader_read(reader, writer->bufs[idx], BUF_SIZE, &nread);
+
+		fibril_mutex_lock(&writer->lock);
+
+		if (rc != EOK) {
+			printf("Error decompressing data.\n");
+			break;
+		}
+
+		writer->sizes[idx] = nread;
+		writer->count++;
+		fibril_condvar_broadcast(&writer->cv);
+	} while (nread == BUF_SIZE);
+
+	/* Wait for the writer to finish */
+	writer->done = true;
+	fibril_condvar_broadcast(&writer->cv);
+
+	while (writer->running)
+		fibril_condvar_wait(&writer->cv, &writer->lock);
+
+	if (rc == EOK)
+		rc = writer->error;
+
+	fibril_mutex_unlock(&writer->lock);
+	return rc;
+}
+
 int main(int argc, char *argv[])
 {
 	errno_t rc;
-	void *data, *ddata;
-	size_t size, dsize;
-	size_t nread, nwr;
-	long len;
 	FILE *f, *wf;
+	gzip_reader_t *reader;
+	gunzip_writer_t writer;
+	fid_t fid;
 
 	if (argc != 3) {
 		printf("syntax: gunzip <src.gz> <dest>\n");
 		return 1;
 	}
 
+	for (size_t i = 0; i < BUFS; i++) {
+		writer.bufs[i] = malloc(BUF_SIZE);
+		if (writer.bufs[i] == NULL) {
+			printf("Error allocating %d bytes.\n", BUF_SIZE);
+			while (i > 0)
+				free(writer.bufs[--i]);
+			return 1;
+		}
+	}
+
 	f = fopen(argv[1], "rb");
 	if (f == NULL) {
 		printf("Error opening '%s'\n", argv[1]);
-		return 1;
+		rc = ENOENT;
+		goto error;
 	}
 
-	if (fseek(f, 0, SEEK_END) < 0) {
-		printf("Error determining size of '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
-	}
-
-	len = ftell(f);
-	if (len < 0) {
-		printf("Error determining size of '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
-	}
-
-	if (fseek(f, 0, SEEK_SET) < 0) {
-		printf ("Error rewinding '%s'\n", argv[1]);
+	rc = gzip_reader_create(gunzip_read, f, &reader);
+	if (rc != EOK) {
+		printf("Error decompressing data.\n");
 		fclose(f);
-		return 1;
+		goto error;
 	}
 
-	data = malloc(len);
-	if (data == NULL) {
-		printf("Error allocating %ld bytes.\n", len);
+	wf = fopen(argv[2], "wb");
+	if (wf == NULL) {
+		printf("Error creating file '%s'\n", argv[2]);
+		gzip_reader_destroy(reader);
 		fclose(f);
-		return 1;
+		rc = EIO;
+		goto error;
 	}
 
-	nread = fread(data, 1, len, f);
-	if (nread != (size_t)len) {
-		printf("Error reading '%s'\n", argv[1]);
-		fclose(f);
-		return 1;
-	}
+	/* Let decompression and writing run in parallel */
+	fibril_enable_multithreaded();
 
-	fclose(f);
+	writer.file = wf;
+	fibril_mutex_initialize(&writer.lock);
+	fibril_condvar_initialize(&writer.cv);
+	writer.head = 0;
+	writer.count = 0;
+	writer.done = false;
+	writer.error = EOK;
 
-	size = (size_t) len;
+	fid = fibril_create(gunzip_writer_fibril, &writer);
+	if (fid == 0) {
+		printf("Error creating writer fibril.\n");
+		rc = ENOMEM;
+	} else {
+		writer.running = true;
+		fibril_add_ready(fid);
 
-	rc = gzip_expand(data, size, &ddata, &dsize);
-	if (rc != EOK) {
-		printf("Error decompressing data.\n");
-		return 1;
+		rc = gunzip_run(reader, &writer);
+		if (writer.error != EOK)
+			printf("Error writing '%s'\n", argv[2]);
 	}
 
-	wf = fopen(argv[2], "wb");
-	if (wf == NULL) {
-		printf("Error creating file '%s'\n", argv[2]);
-		return 1;
-	}
+	gzip_reader_destroy(reader);
+	fclose(f);
 
-	nwr = fwrite(ddata, 1, dsize, wf);
-	if (nwr != dsize) {
+	if ((fclose(wf) != 0) && (rc == EOK)) {
 		printf("Error writing '%s'\n", argv[2]);
-		fclose(wf);
-		return 1;
+		rc = EIO;
 	}
 
-	if (fclose(wf) != 0) {
-		printf("Error writing '%s'\n", argv[2]);
-		return 1;
-	}
+error:
+	for (size_t i = 0; i < BUFS; i++)
+		free(writer.bufs[i]);
 
-	return 0;
+	return (rc == EOK) ? 0 : 1;
 }
 
 /** @}
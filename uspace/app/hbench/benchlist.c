@@ -43,8 +43,13 @@ benchmark_t *benchmarks[] = {
 	&benchmark_file_read,
 	&benchmark_malloc1,
 	&benchmark_malloc2,
+	&benchmark_memcpy,
+	&benchmark_memmove,
+	&benchmark_memset,
 	&benchmark_ns_ping,
-	&benchmark_ping_pong
+	&benchmark_ping_pong,
+	&benchmark_str_scan,
+	&benchmark_str_search
 };
 
 size_t benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
@@ -136,8 +136,13 @@ extern benchmark_t benchmark_fibril_mutex;
 extern benchmark_t benchmark_file_read;
 extern benchmark_t benchmark_malloc1;
 extern benchmark_t benchmark_malloc2;
+extern benchmark_t benchmark_memcpy;
+extern benchmark_t benchmark_memmove;
+extern benchmark_t benchmark_memset;
 extern benchmark_t benchmark_ns_ping;
 extern benchmark_t benchmark_ping_pong;
+extern benchmark_t benchmark_str_scan;
+extern benchmark_t benchmark_str_search;
 
 #endif
 
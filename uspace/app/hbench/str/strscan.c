@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <str.h>
+#include "../hbench.h"
+
+/** Strings similar to what path lookups and command parsing see. */
+static const char *strings[] = {
+	"/usr/lib/libc.so.0",
+	"/usr/lib/libcpp.so.0",
+	"/data/web/helenos.png",
+	"/app/hbench -o /tmp/results.csv file_read",
+	"Content-Type: text/html; charset=utf-8",
+	"/data/dokumenty/příliš žluťoučký kůň.txt",
+	"/data/dokumenty/úpěl ďábelské ódy.txt"
+};
+
+#define STRING_COUNT (sizeof(strings) / sizeof(strings[0]))
+
+/** Execute string scanning benchmark.
+ *
+ * Measures str_size(), str_length(), str_cmp(), str_chr() and
+ * str_check() on short strings of mostly ASCII text.
+ */
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	size_t total = 0;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		const char *s1 = strings[i % STRING_COUNT];
+		const char *s2 = strings[(i + 1) % STRING_COUNT];
+
+		total += str_size(s1);
+		total += str_length(s1);
+		total += str_cmp(s1, s2) + 1;
+		total += (str_chr(s1, '.') != NULL);
+		total += str_check(s1);
+	}
+	bench_run_stop(run);
+
+	if (total == 0)
+		return bench_run_fail(run, "unexpected result");
+
+	return true;
+}
+
+benchmark_t benchmark_str_scan = {
+	.name = "str_scan",
+	.desc = "Measure size, length, comparison, search and validation of short strings",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <inttypes.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <str.h>
+#include "../hbench.h"
+
+#define HAYSTACK_SIZE 65536
+
+static const char needle[] = "Content-Length: 42";
+
+/** Execute substring search benchmark.
+ *
+ * Searches for a header line in a large block of text that only contains
+ * partial matches of it.
+ */
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	static const char filler[] = "Content-Type: text/plain\r\n";
+
+	char *haystack = malloc(HAYSTACK_SIZE + sizeof(needle));
+	if (haystack == NULL) {
+		return bench_run_fail(run, "failed to allocate %dB haystack",
+		    HAYSTACK_SIZE);
+	}
+
+	size_t off = 0;
+	while (off + sizeof(filler) - 1 <= HAYSTACK_SIZE) {
+		memcpy(haystack + off, filler, sizeof(filler) - 1);
+		off += sizeof(filler) - 1;
+	}
+	memcpy(haystack + off, needle, sizeof(needle));
+
+	bool ret = true;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < size; i++) {
+		if (str_str(haystack, needle) != haystack + off) {
+			ret = bench_run_fail(run, "needle not found in run %" PRIu64,
+			    i);
+			break;
+		}
+	}
+	bench_run_stop(run);
+
+	free(haystack);
+
+	return ret;
+}
+
+benchmark_t benchmark_str_search = {
+	.name = "str_search",
+	.desc = "Search for a substring in 64kB of text",
+	.entry = &runner,
+	.setup = NULL,
+	.teardown = NULL
+};
+
+/** @}
+ */
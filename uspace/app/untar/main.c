@@ -33,36 +33,278 @@
  */
 
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <gzip.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <untar.h>
 
+/** Size of a buffer of archive data read ahead */
+#define READ_BUF_SIZE  65536
+
+/** Number of buffers read ahead */
+#define READ_BUFS  4
+
+/** Buffer of archive data */
+typedef struct {
+	uint8_t data[READ_BUF_SIZE];  /**< Data */
+	size_t size;                  /**< Bytes of data */
+} read_buf_t;
+
+/** Read-ahead of the archive
+ *
+ * A separate fibril reads the archive into a ring of buffers, so that
+ * reading overlaps with decompression and extraction.
+ *
+ */
+typedef struct {
+	FILE *file;                  /**< Archive */
+	fibril_mutex_t lock;         /**< Protects the fields below */
+	fibril_condvar_t cv;         /**< Signals any change */
+	read_buf_t bufs[READ_BUFS];  /**< Ring of buffers */
+	size_t head;                 /**< First filled buffer */
+	size_t count;                /**< Number of filled buffers */
+	size_t pos;                  /**< Data consumed from the first buffer */
+	bool eof;                    /**< Reader has finished */
+	bool running;                /**< Reader fibril is running */
+	bool stop;                   /**< Reader fibril should terminate */
+	errno_t error;               /**< Read error */
+} read_ahead_t;
+
 typedef struct {
 	const char *filename;
-	FILE *file;
+	read_ahead_t *ra;
+	gzip_reader_t *gzip;  /**< Decoder of compressed archives or NULL */
 } tar_state_t;
 
+/** Read-ahead fibril
+ *
+ * @param arg Read-ahead.
+ *
+ * @return Always EOK.
+ *
+ */
+static errno_t read_ahead_fibril(void *arg)
+{
+	read_ahead_t *ra = (read_ahead_t *) arg;
+
+	fibril_mutex_lock(&ra->lock);
+
+	while (!ra->eof) {
+		while ((ra->count == READ_BUFS) && (!ra->stop))
+			fibril_condvar_wait(&ra->cv, &ra->lock);
+
+		if (ra->stop)
+			break;
+
+		/* The buffer is not used by the consumer until it is filled */
+		read_buf_t *buf = &ra->bufs[(ra->head + ra->count) % READ_BUFS];
+		fibril_mutex_unlock(&ra->lock);
+
+		buf->size = fread(buf->data, 1, READ_BUF_SIZE, ra->file);
+		bool error = (buf->size < READ_BUF_SIZE) && ferror(ra->file);
+
+		fibril_mutex_lock(&ra->lock);
+
+		if (buf->size > 0)
+			ra->count++;
+
+		if (buf->size < READ_BUF_SIZE) {
+			ra->eof = true;
+			if (error)
+				ra->error = EIO;
+		}
+
+		fibril_condvar_broadcast(&ra->cv);
+	}
+
+	ra->running = false;
+	fibril_condvar_broadcast(&ra->cv);
+	fibril_mutex_unlock(&ra->lock);
+
+	return EOK;
+}
+
+/** Read archive data
+ *
+ * @param arg   Read-ahead.
+ * @param data  Buffer to fill.
+ * @param size  Size of the buffer (bytes).
+ * @param nread Place to store the number of bytes read,
+ *              zero signals the end of the archive.
+ *
+ * @return EOK on success or EIO on read error.
+ *
+ */
+static errno_t read_ahead_read(void *arg, void *data, size_t size,
+    size_t *nread)
+{
+	read_ahead_t *ra = (read_ahead_t *) arg;
+	uint8_t *dp = (uint8_t *) data;
+	errno_t rc = EOK;
+
+	*nread = 0;
+
+	fibril_mutex_lock(&ra->lock);
+
+	while (*nread < size) {
+		while ((ra->count == 0) && (!ra->eof))
+			fibril_condvar_wait(&ra->cv, &ra->lock);
+
+		if (ra->count == 0) {
+			rc = ra->error;
+			break;
+		}
+
+		read_buf_t *buf = &ra->bufs[ra->head];
+		size_t len = buf->size - ra->pos;
+		if (len > size - *nread)
+			len = size - *nread;
+
+		fibril_mutex_unlock(&ra->lock);
+		memcpy(dp + *nread, buf->data + ra->pos, len);
+		fibril_mutex_lock(&ra->lock);
+
+		*nread += len;
+		ra->pos += len;
+
+		if (ra->pos == buf->size) {
+			ra->head = (ra->head + 1) % READ_BUFS;
+			ra->count--;
+			ra->pos = 0;
+			fibril_condvar_broadcast(&ra->cv);
+		}
+	}
+
+	fibril_mutex_unlock(&ra->lock);
+
+	/* Report the data read before an error first */
+	if (*nread > 0)
+		return EOK;
+
+	return rc;
+}
+
+/** Start reading ahead
+ *
+ * @param file Archive.
+ * @param rra  Place to store the read-ahead.
+ *
+ * @return EOK on success or ENOMEM if out of memory.
+ *
+ */
+static errno_t read_ahead_start(FILE *file, read_ahead_t **rra)
+{
+	read_ahead_t *ra = calloc(1, sizeof(read_ahead_t));
+	if (ra == NULL)
+		return ENOMEM;
+
+	ra->file = file;
+	fibril_mutex_initialize(&ra->lock);
+	fibril_condvar_initialize(&ra->cv);
+
+	fid_t fid = fibril_create(read_ahead_fibril, ra);
+	if (fid == 0) {
+		free(ra);
+		return ENOMEM;
+	}
+
+	ra->running = true;
+	fibril_add_ready(fid);
+
+	*rra = ra;
+	return EOK;
+}
+
+/** Stop reading ahead
+ *
+ * @param ra Read-ahead.
+ *
+ */
+static void read_ahead_stop(read_ahead_t *ra)
+{
+	fibril_mutex_lock(&ra->lock);
+
+	ra->stop = true;
+	fibril_condvar_broadcast(&ra->cv);
+
+	while (ra->running)
+		fibril_condvar_wait(&ra->cv, &ra->lock);
+
+	fibril_mutex_unlock(&ra->lock);
+	free(ra);
+}
+
 static int tar_open(tar_file_t *tar)
 {
 	tar_state_t *state = (tar_state_t *) tar->data;
+	uint8_t magic[2];
 
-	state->file = fopen(state->filename, "rb");
-	if (state->file == NULL)
+	FILE *file = fopen(state->filename, "rb");
+	if (file == NULL)
 		return errno;
 
+	/* Compressed archives are recognized by the GZIP magic number */
+	bool compressed = (fread(magic, 1, sizeof(magic), file) ==
+	    sizeof(magic)) && (magic[0] == 0x1f) && (magic[1] == 0x8b);
+
+	if (fseek(file, 0, SEEK_SET) != 0) {
+		fclose(file);
+		return EIO;
+	}
+
+	errno_t rc = read_ahead_start(file, &state->ra);
+	if (rc != EOK) {
+		fclose(file);
+		return rc;
+	}
+
+	state->gzip = NULL;
+
+	if (compressed) {
+		rc = gzip_reader_create(read_ahead_read, state->ra,
+		    &state->gzip);
+		if (rc != EOK) {
+			read_ahead_stop(state->ra);
+			fclose(file);
+			return rc;
+		}
+	}
+
 	return EOK;
 }
 
 static void tar_close(tar_file_t *tar)
 {
 	tar_state_t *state = (tar_state_t *) tar->data;
-	fclose(state->file);
+	FILE *file = state->ra->file;
+
+	gzip_reader_destroy(state->gzip);
+	read_ahead_stop(state->ra);
+	fclose(file);
 }
 
 static size_t tar_read(tar_file_t *tar, void *data, size_t size)
 {
 	tar_state_t *state = (tar_state_t *) tar->data;
-	return fread(data, 1, size, state->file);
+	size_t nread;
+	errno_t rc;
+
+	if (state->gzip != NULL)
+		rc = gzip_reader_read(state->gzip, data, size, &nread);
+	else
+		rc = read_ahead_read(state->ra, data, size, &nread);
+
+	if (rc != EOK) {
+		errno = rc;
+		return 0;
+	}
+
+	return nread;
 }
 
 static void tar_vreport(tar_file_t *tar, const char *fmt, va_list args)
@@ -85,11 +327,14 @@ int main(int argc, char *argv[])
 		return 1;
 	}
 
+	/* Let reading, decompression and writing run in parallel */
+	fibril_enable_multithreaded();
+
 	tar_state_t state;
 	state.filename = argv[1];
 
 	tar.data = (void *) &state;
-	return untar(&tar);
+	return (untar(&tar) == EOK) ? 0 : 1;
 }
 
 /** @}
@@ -54,6 +54,9 @@
 
 #define E1000_DEFAULT_INTERRUPT_INTERVAL_USEC  250
 
+/* Maximum interrupt throttling interval the ITR register can hold */
+#define E1000_MAX_INTERRUPT_INTERVAL_USEC  16383
+
 /* Must be power of 8 */
 #define E1000_RX_FRAME_COUNT  128
 #define E1000_TX_FRAME_COUNT  128
@@ -153,6 +156,9 @@ typedef struct {
 	/** Add VLAN tag to frame */
 	bool vlan_tag_add;
 
+	/** Value of the RXCSUM register */
+	uint32_t rxcsum;
+
 	/** Used unicast Receive Address count */
 	unsigned int unicast_ra_count;
 
@@ -235,6 +241,8 @@ static driver_t e1000_driver = {
 static errno_t e1000_on_activating(nic_t *);
 static errno_t e1000_on_stopping(nic_t *);
 static void e1000_send_frame(nic_t *, void *, size_t);
+static void e1000_send_frame_offload(nic_t *, void *, size_t, uint32_t);
+static errno_t e1000_on_offload_change(nic_t *, uint32_t);
 
 /** PIO ranges used in the IRQ code. */
 irq_pio_range_t e1000_irq_pio_ranges[] = {
@@ -1165,6 +1173,31 @@ static uint32_t e1000_inc_tail(uint32_t tail, uint32_t descriptors_count)
 		return tail + 1;
 }
 
+/** Get checksum verification results of received frame
+ *
+ * @param rx_descriptor Receive descriptor of the frame
+ *
+ * @return Offload flags (NIC_FF_xxx)
+ *
+ */
+static uint32_t e1000_rx_offload_flags(e1000_rx_descriptor_t *rx_descriptor)
+{
+	uint32_t flags = 0;
+
+	if (rx_descriptor->status & RXDESCRIPTOR_STATUS_IXSM)
+		return 0;
+
+	if ((rx_descriptor->status & RXDESCRIPTOR_STATUS_IPCS) &&
+	    !(rx_descriptor->errors & RXDESCRIPTOR_ERRORS_IPE))
+		flags |= NIC_FF_IPV4_CSUM_OK;
+
+	if ((rx_descriptor->status & RXDESCRIPTOR_STATUS_TCPCS) &&
+	    !(rx_descriptor->errors & RXDESCRIPTOR_ERRORS_TCPE))
+		flags |= NIC_FF_L4_CSUM_OK;
+
+	return flags;
+}
+
 /** Receive frames
  *
  * @param nic NIC data
@@ -1188,6 +1221,7 @@ static void e1000_receive_frames(nic_t *nic)
 		nic_frame_t *frame = nic_alloc_frame(nic, frame_size);
 		if (frame != NULL) {
 			memcpy(frame->data, e1000->rx_frame_virt[next_tail], frame_size);
+			frame->flags = e1000_rx_offload_flags(rx_descriptor);
 			nic_received_frame(nic, frame);
 		} else {
 			ddf_msg(LVL_ERROR, "Memory allocation failed. Frame dropped.");
@@ -1311,8 +1345,13 @@ static void e1000_poll(nic_t *nic)
  */
 static uint16_t e1000_calculate_itr_interval(const struct timespec *period)
 {
-	// TODO: use also tv_sec
-	return e1000_calculate_itr_interval_from_usecs(NSEC2USEC(period->tv_nsec));
+	usec_t usecs = SEC2USEC(period->tv_sec) + NSEC2USEC(period->tv_nsec);
+
+	/* The ITR interval is 16 bits wide in 256 ns units */
+	if (usecs > E1000_MAX_INTERRUPT_INTERVAL_USEC)
+		usecs = E1000_MAX_INTERRUPT_INTERVAL_USEC;
+
+	return e1000_calculate_itr_interval_from_usecs(usecs);
 }
 
 /** Set polling mode
@@ -1369,6 +1408,8 @@ static void e1000_initialize_rx_registers(e1000_t *e1000)
 
 	/* Set Broadcast Enable Bit */
 	E1000_REG_WRITE(e1000, E1000_RCTL, RCTL_BAM);
+
+	E1000_REG_WRITE(e1000, E1000_RXCSUM, e1000->rxcsum);
 }
 
 /** Initialize receive structure
@@ -1535,9 +1576,8 @@ static void e1000_fill_mac_from_eeprom(e1000_t *e1000)
  */
 static void e1000_initialize_registers(e1000_t *e1000)
 {
-	E1000_REG_WRITE(e1000, E1000_ITR,
-	    e1000_calculate_itr_interval_from_usecs(
-	    E1000_DEFAULT_INTERRUPT_INTERVAL_USEC));
+	/* Interrupts are throttled only when the adaptive mode asks for it */
+	E1000_REG_WRITE(e1000, E1000_ITR, 0);
 	E1000_REG_WRITE(e1000, E1000_FCAH, 0);
 	E1000_REG_WRITE(e1000, E1000_FCAL, 0);
 	E1000_REG_WRITE(e1000, E1000_FCT, 0);
@@ -1904,6 +1944,9 @@ static e1000_t *e1000_create_dev_data(ddf_dev_t *dev)
 	    e1000_on_unicast_mode_change, e1000_on_multicast_mode_change,
 	    e1000_on_broadcast_mode_change, NULL, e1000_on_vlan_mask_change);
 	nic_set_poll_handlers(nic, e1000_poll_mode_change, e1000_poll);
+	nic_set_offload_handlers(nic, NIC_OFFLOAD_RX_IPV4_CSUM |
+	    NIC_OFFLOAD_RX_L4_CSUM | NIC_OFFLOAD_TX_L4_CSUM,
+	    e1000_on_offload_change, e1000_send_frame_offload);
 
 	fibril_mutex_initialize(&e1000->ctrl_lock);
 	fibril_mutex_initialize(&e1000->rx_lock);
@@ -2190,7 +2233,7 @@ errno_t e1000_dev_add(ddf_dev_t *dev)
 	struct timespec period;
 	period.tv_sec = 0;
 	period.tv_nsec = USEC2NSEC(E1000_DEFAULT_INTERRUPT_INTERVAL_USEC);
-	rc = nic_report_poll_mode(nic, NIC_POLL_PERIODIC, &period);
+	rc = nic_report_poll_mode(nic, NIC_POLL_ADAPTIVE, &period);
 	if (rc != EOK)
 		goto err_rx_structure;
 
@@ -2338,6 +2381,20 @@ static void e1000_eeprom_get_address(e1000_t *e1000,
  *
  */
 static void e1000_send_frame(nic_t *nic, void *data, size_t size)
+{
+	e1000_send_frame_offload(nic, data, size, 0);
+}
+
+/** Send frame with offload requests
+ *
+ * @param nic    NIC driver data structure
+ * @param data   Frame data
+ * @param size   Frame size in bytes
+ * @param flags  Offload requests (NIC_FF_xxx)
+ *
+ */
+static void e1000_send_frame_offload(nic_t *nic, void *data, size_t size,
+    uint32_t flags)
 {
 	assert(nic);
 
@@ -2387,6 +2444,20 @@ static void e1000_send_frame(nic_t *nic, void *data, size_t size)
 
 	tx_descriptor_addr->checksum_start_field = 0;
 
+	size_t csum_start;
+	size_t csum_offs;
+	if ((flags & NIC_FF_L4_CSUM) != 0 &&
+	    nic_offload_csum_location(data, size, &csum_start,
+	    &csum_offs) == EOK) {
+		/*
+		 * The checksum field holds the pseudo-header sum,
+		 * checksumming from CSS to the end of frame completes it.
+		 */
+		tx_descriptor_addr->checksum_start_field = csum_start;
+		tx_descriptor_addr->checksum_offset = csum_offs;
+		tx_descriptor_addr->command |= TXDESCRIPTOR_COMMAND_IC;
+	}
+
 	tdt++;
 	if (tdt == E1000_TX_FRAME_COUNT)
 		tdt = 0;
@@ -2396,6 +2467,36 @@ static void e1000_send_frame(nic_t *nic, void *data, size_t size)
 	fibril_mutex_unlock(&e1000->tx_lock);
 }
 
+/** Callback for change of the active offloads
+ *
+ * Transmit checksum insertion is requested per descriptor and needs
+ * no setup.
+ *
+ * @param nic    NIC driver data
+ * @param active Offloads to activate (NIC_OFFLOAD_xxx)
+ *
+ * @return EOK
+ *
+ */
+static errno_t e1000_on_offload_change(nic_t *nic, uint32_t active)
+{
+	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
+
+	fibril_mutex_lock(&e1000->rx_lock);
+
+	e1000->rxcsum = 0;
+	if (active & NIC_OFFLOAD_RX_IPV4_CSUM)
+		e1000->rxcsum |= RXCSUM_IPOFLD;
+	if (active & NIC_OFFLOAD_RX_L4_CSUM)
+		e1000->rxcsum |= RXCSUM_TUOFLD;
+
+	E1000_REG_WRITE(e1000, E1000_RXCSUM, e1000->rxcsum);
+
+	fibril_mutex_unlock(&e1000->rx_lock);
+
+	return EOK;
+}
+
 int main(void)
 {
 	printf("%s: HelenOS E1000 network adapter driver\n", NAME);
@@ -110,6 +110,7 @@ typedef enum {
 typedef enum {
 	TXDESCRIPTOR_COMMAND_VLE = (1 << 6),   /**< VLAN frame Enable */
 	TXDESCRIPTOR_COMMAND_RS = (1 << 3),    /**< Report Status */
+	TXDESCRIPTOR_COMMAND_IC = (1 << 2),    /**< Insert Checksum */
 	TXDESCRIPTOR_COMMAND_IFCS = (1 << 1),  /**< Insert FCS */
 	TXDESCRIPTOR_COMMAND_EOP = (1 << 0)    /**< End Of Packet */
 } e1000_txdescriptor_command_t;
@@ -119,6 +120,20 @@ typedef enum {
 	TXDESCRIPTOR_STATUS_DD = (1 << 0)  /**< Descriptor Done */
 } e1000_txdescriptor_status_t;
 
+/** Receive descriptor STATUS field bits */
+typedef enum {
+	RXDESCRIPTOR_STATUS_DD = (1 << 0),     /**< Descriptor Done */
+	RXDESCRIPTOR_STATUS_IXSM = (1 << 2),   /**< Ignore Checksum Indication */
+	RXDESCRIPTOR_STATUS_TCPCS = (1 << 5),  /**< TCP/UDP Checksum Calculated */
+	RXDESCRIPTOR_STATUS_IPCS = (1 << 6)    /**< IP Checksum Calculated */
+} e1000_rxdescriptor_status_t;
+
+/** Receive descriptor ERRORS field bits */
+typedef enum {
+	RXDESCRIPTOR_ERRORS_TCPE = (1 << 5),  /**< TCP/UDP Checksum Error */
+	RXDESCRIPTOR_ERRORS_IPE = (1 << 6)    /**< IP Checksum Error */
+} e1000_rxdescriptor_errors_t;
+
 /** E1000 Registers */
 typedef enum {
 	E1000_CTRL = 0x0,      /**< Device Control Register */
@@ -137,6 +152,7 @@ typedef enum {
 	E1000_RDLEN = 0x2808,  /**< Receive Descriptor Length */
 	E1000_RDH = 0x2810,    /**< Receive Descriptor Head */
 	E1000_RDT = 0x2818,    /**< Receive Descriptor Tail */
+	E1000_RXCSUM = 0x5000, /**< Receive Checksum Control */
 	E1000_RAL = 0x5400,    /**< Receive Address Low */
 	E1000_RAH = 0x5404,    /**< Receive Address High */
 	E1000_VFTA = 0x5600,   /**< VLAN Filter Table Array */
@@ -242,4 +258,10 @@ typedef enum {
 	RCTL_VFE = (1 << 18)   /**< VLAN Filter Enable */
 } e1000_rctl_t;
 
+/** RXCSUM register fields */
+typedef enum {
+	RXCSUM_IPOFLD = (1 << 8),  /**< IP Checksum Off-load Enable */
+	RXCSUM_TUOFLD = (1 << 9)   /**< TCP/UDP Checksum Off-load Enable */
+} e1000_rxcsum_t;
+
 #endif
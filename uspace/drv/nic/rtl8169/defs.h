@@ -267,6 +267,12 @@ enum rtl8169_phystatus {
 	PHYSTATUS_FDX = (1 << 0), /**< Link is full duplex */
 };
 
+/** C+ Command Register */
+enum rtl8169_ccr {
+	CCR_RXVLAN = (1 << 6), /**< Receive VLAN de-tagging enable */
+	CCR_RXCHKSUM = (1 << 5), /**< Receive checksum offload enable */
+};
+
 enum rtl8169_tppoll {
 	TPPOLL_HPQ = (1 << 7), /**< Start transmit on high priority queue */
 	TPPOLL_NPQ = (1 << 6), /**< Start transmit on normal queue */
@@ -328,6 +334,15 @@ enum rtl8169_descr_rxstatus {
 	RXSTATUS_TCPF = (1 << 14)
 };
 
+/** Protocol ID of received frame (RXSTATUS_PID1 and RXSTATUS_PID0) */
+enum rtl8169_descr_rxpid {
+	RXPID_MASK = (RXSTATUS_PID1 | RXSTATUS_PID0),
+	RXPID_NON_IP = 0,
+	RXPID_TCP = RXSTATUS_PID0,
+	RXPID_UDP = RXSTATUS_PID1,
+	RXPID_IP = (RXSTATUS_PID1 | RXSTATUS_PID0)
+};
+
 typedef struct rtl8169_descr {
 	uint32_t	control;
 	uint32_t	vlan;
@@ -74,6 +74,10 @@ static errno_t rtl8169_on_activated(nic_t *nic_data);
 static errno_t rtl8169_on_stopped(nic_t *nic_data);
 static void rtl8169_send_frame(nic_t *nic_data, void *data, size_t size);
 static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev);
+static errno_t rtl8169_poll_mode_change(nic_t *nic_data, nic_poll_mode_t mode,
+    const struct timespec *period);
+static void rtl8169_poll(nic_t *nic_data);
+static errno_t rtl8169_on_offload_change(nic_t *nic_data, uint32_t active);
 static inline errno_t rtl8169_register_int_handler(nic_t *nic_data,
     cap_irq_handle_t *handle);
 static inline void rtl8169_get_hwaddr(rtl8169_t *rtl8169, nic_address_t *addr);
@@ -316,6 +320,11 @@ static rtl8169_t *rtl8169_create_dev_data(ddf_dev_t *dev)
 	nic_set_filtering_change_handlers(nic_data,
 	    rtl8169_unicast_set, rtl8169_multicast_set, rtl8169_broadcast_set,
 	    NULL, NULL);
+	nic_set_poll_handlers(nic_data, rtl8169_poll_mode_change, rtl8169_poll);
+	nic_set_offload_handlers(nic_data, NIC_OFFLOAD_RX_IPV4_CSUM |
+	    NIC_OFFLOAD_RX_L4_CSUM, rtl8169_on_offload_change, NULL);
+
+	rtl8169->int_mask = RTL8169_DEFAULT_INTERRUPTS;
 
 	fibril_mutex_initialize(&rtl8169->rx_lock);
 	fibril_mutex_initialize(&rtl8169->tx_lock);
@@ -429,6 +438,13 @@ static errno_t rtl8169_dev_add(ddf_dev_t *dev)
 	if (rc != EOK)
 		goto err_pio;
 
+	struct timespec period;
+	period.tv_sec = 0;
+	period.tv_nsec = USEC2NSEC(RTL8169_DEFAULT_POLL_PERIOD_USEC);
+	rc = nic_report_poll_mode(nic_data, NIC_POLL_ADAPTIVE, &period);
+	if (rc != EOK)
+		goto err_pio;
+
 	cap_irq_handle_t irq_handle;
 	rc = rtl8169_register_int_handler(nic_data, &irq_handle);
 	if (rc != EOK) {
@@ -692,6 +708,73 @@ static void rtl8169_rx_ring_refill(rtl8169_t *rtl8169, unsigned int first,
 	}
 }
 
+/** Write receive checksum offload setting to the C+ Command Register */
+static void rtl8169_rx_csum_update(rtl8169_t *rtl8169)
+{
+	uint16_t ccr = pio_read_16(rtl8169->regs + CCR);
+
+	if (rtl8169->rx_csum)
+		ccr |= CCR_RXCHKSUM;
+	else
+		ccr &= ~CCR_RXCHKSUM;
+
+	pio_write_16(rtl8169->regs + CCR, ccr);
+}
+
+/** Change the active offloads
+ *
+ *  Only receive checksum verification is offloaded, the placement of the
+ *  transmit checksum bits in the descriptors differs among chip revisions.
+ *
+ *  @param nic_data  The NIC data
+ *  @param active    Offloads to activate (NIC_OFFLOAD_xxx)
+ *
+ *  @return EOK
+ */
+static errno_t rtl8169_on_offload_change(nic_t *nic_data, uint32_t active)
+{
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+
+	fibril_mutex_lock(&rtl8169->rx_lock);
+	rtl8169->rx_csum = (active &
+	    (NIC_OFFLOAD_RX_IPV4_CSUM | NIC_OFFLOAD_RX_L4_CSUM)) != 0;
+	rtl8169_rx_csum_update(rtl8169);
+	fibril_mutex_unlock(&rtl8169->rx_lock);
+
+	return EOK;
+}
+
+/** Get checksum verification results from the RX descriptor status
+ *
+ *  @param control  Control field of the last descriptor of the frame
+ *
+ *  @return Offload flags (NIC_FF_xxx)
+ */
+static uint32_t rtl8169_rx_offload_flags(uint32_t control)
+{
+	uint32_t flags = 0;
+
+	switch (control & RXPID_MASK) {
+	case RXPID_TCP:
+		if (!(control & RXSTATUS_TCPF))
+			flags |= NIC_FF_L4_CSUM_OK;
+		break;
+	case RXPID_UDP:
+		if (!(control & RXSTATUS_UDPF))
+			flags |= NIC_FF_L4_CSUM_OK;
+		break;
+	case RXPID_IP:
+		break;
+	default:
+		return 0;
+	}
+
+	if (!(control & RXSTATUS_IPF))
+		flags |= NIC_FF_IPV4_CSUM_OK;
+
+	return flags;
+}
+
 static errno_t rtl8169_on_activated(nic_t *nic_data)
 {
 	errno_t rc;
@@ -747,7 +830,9 @@ static errno_t rtl8169_on_activated(nic_t *nic_data)
 	pio_write_32(rtl8169->regs + RCR, rcr);
 	pio_write_16(rtl8169->regs + RMS, BUFFER_SIZE);
 
-	pio_write_16(rtl8169->regs + IMR, 0xffff);
+	rtl8169_rx_csum_update(rtl8169);
+
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
 	/* XXX Check return value */
 	hw_res_enable_interrupt(rtl8169->parent_sess, rtl8169->irq);
 
@@ -1016,6 +1101,8 @@ static void rtl8169_receive_done(ddf_dev_t *dev)
 			buffer = rtl8169->rx_buff + (BUFFER_SIZE * tail);
 			frame = nic_alloc_frame(nic_data, frame_size);
 			memcpy(frame->data, buffer, frame_size);
+			if (rtl8169->rx_csum)
+				frame->flags = rtl8169_rx_offload_flags(descr->control);
 			nic_frame_list_append(frames, frame);
 		}
 
@@ -1032,21 +1119,28 @@ static void rtl8169_receive_done(ddf_dev_t *dev)
 
 }
 
-static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+/** Process the events signalled in the interrupt status register
+ *
+ *  Shared by the interrupt handler and the poll request handler.
+ *
+ *  @param dev  The device
+ *  @param isr  Interrupt status register value
+ */
+static void rtl8169_interrupt_impl(ddf_dev_t *dev, uint16_t isr)
 {
-	assert(dev);
-	assert(icall);
-
-	uint16_t isr = (uint16_t) ipc_get_arg2(icall) & INT_KNOWN;
 	nic_t *nic_data = nic_get_from_ddf_dev(dev);
 	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
 
-	ddf_msg(LVL_DEBUG, "rtl8169_irq_handler(): isr=0x%04x", isr);
-	pio_write_16(rtl8169->regs + IMR, 0xffff);
-
 	while (isr != 0) {
 		ddf_msg(LVL_DEBUG, "irq handler: remaining isr=0x%04x", isr);
 
+		/* Poll timer expired, restart it and process both rings */
+		if (isr & INT_TIME_OUT) {
+			pio_write_32(rtl8169->regs + TCTR, 0);
+			pio_write_16(rtl8169->regs + ISR, INT_TIME_OUT);
+			isr |= INT_TOK | INT_ROK;
+		}
+
 		/* Packet underrun or link change */
 		if (isr & INT_PUN) {
 			rtl8169_link_change(dev);
@@ -1081,6 +1175,82 @@ static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 	pio_write_16(rtl8169->regs + ISR, 0xffff);
 }
 
+static void rtl8169_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	assert(dev);
+	assert(icall);
+
+	uint16_t isr = (uint16_t) ipc_get_arg2(icall) & INT_KNOWN;
+	nic_t *nic_data = nic_get_from_ddf_dev(dev);
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+
+	ddf_msg(LVL_DEBUG, "rtl8169_irq_handler(): isr=0x%04x", isr);
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
+
+	rtl8169_interrupt_impl(dev, isr);
+}
+
+/** Set polling mode
+ *
+ *  The periodic mode uses the timer interrupt of the controller, the frame
+ *  interrupts are masked and the rings are processed on each timeout.
+ *
+ *  @param nic_data  The NIC data
+ *  @param mode      The mode to set
+ *  @param period    The period for NIC_POLL_PERIODIC
+ *
+ *  @return EOK if succeed
+ *  @return ENOTSUP if the mode is not supported
+ */
+static errno_t rtl8169_poll_mode_change(nic_t *nic_data, nic_poll_mode_t mode,
+    const struct timespec *period)
+{
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+	uint32_t timer_val = 0;
+
+	switch (mode) {
+	case NIC_POLL_IMMEDIATE:
+		rtl8169->int_mask = RTL8169_DEFAULT_INTERRUPTS;
+		break;
+	case NIC_POLL_ON_DEMAND:
+		rtl8169->int_mask = 0;
+		break;
+	case NIC_POLL_PERIODIC:
+		assert(period);
+
+		uint64_t usecs = SEC2USEC(period->tv_sec) +
+		    NSEC2USEC(period->tv_nsec);
+		uint64_t ticks = usecs * RTL8169_PCI_FREQ_KHZ / 1000;
+		if (ticks == 0 || ticks > UINT32_MAX)
+			return ENOTSUP;
+
+		timer_val = ticks;
+		rtl8169->int_mask = INT_TIME_OUT | INT_PUN | INT_SERR;
+		break;
+	default:
+		return ENOTSUP;
+	}
+
+	/* A zero value in the timer interrupt register disables the timer */
+	pio_write_32(rtl8169->regs + TIMINT, timer_val);
+	pio_write_32(rtl8169->regs + TCTR, 0);
+	pio_write_16(rtl8169->regs + IMR, rtl8169->int_mask);
+
+	return EOK;
+}
+
+/** Force processing of the receive and transmit rings
+ *
+ *  @param nic_data  The NIC data
+ */
+static void rtl8169_poll(nic_t *nic_data)
+{
+	rtl8169_t *rtl8169 = nic_get_specific(nic_data);
+
+	uint16_t isr = pio_read_16(rtl8169->regs + ISR) & INT_KNOWN;
+	rtl8169_interrupt_impl(rtl8169->dev, isr);
+}
+
 static void rtl8169_send_frame(nic_t *nic_data, void *data, size_t size)
 {
 	rtl8169_descr_t *descr, *prev;
@@ -30,6 +30,7 @@
 #ifndef RTL8169_DRIVER_H_
 #define RTL8169_DRIVER_H_
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include "defs.h"
@@ -46,6 +47,13 @@
 #define	TX_BUFFERS_SIZE		(BUFFER_SIZE * TX_BUFFERS_COUNT)
 #define	RX_BUFFERS_SIZE		(BUFFER_SIZE * RX_BUFFERS_COUNT)
 
+/** Frequency of the timer counter (PCI clock) in kHz */
+#define	RTL8169_PCI_FREQ_KHZ	33000
+/** Interrupts enabled when the NIC is not polled */
+#define	RTL8169_DEFAULT_INTERRUPTS	0xffff
+/** Polling period used by the adaptive poll mode */
+#define	RTL8169_DEFAULT_POLL_PERIOD_USEC	250
+
 /** RTL8139 device data */
 typedef struct rtl8169_data {
 	/** DDF device */
@@ -93,6 +101,9 @@ typedef struct rtl8169_data {
 	uint32_t rcr_ucast;
 	uint32_t rcr_mcast;
 
+	/** Receive checksum offload enabled */
+	bool rx_csum;
+
 	/** Lock for receiver */
 	fibril_mutex_t rx_lock;
 	/** Lock for transmitter */
@@ -56,6 +56,9 @@
 #define TX_BUF_SIZE	BUFFER_SIZE
 #define CT_BUF_SIZE	BUFFER_SIZE
 
+/** Polling period used by the adaptive poll mode */
+#define VIRTIO_NET_POLL_PERIOD_USEC	250
+
 static ddf_dev_ops_t virtio_net_dev_ops;
 
 static errno_t virtio_net_dev_add(ddf_dev_t *dev);
@@ -69,9 +72,14 @@ static driver_t virtio_net_driver = {
 	.driver_ops = &virtio_net_driver_ops
 };
 
-static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+/** Process the used buffers of all virtqueues
+ *
+ * Shared by the interrupt handler and the poll request handler.
+ *
+ * @param nic  NIC data
+ */
+static void virtio_net_process_queues(nic_t *nic)
 {
-	nic_t *nic = ddf_dev_data_get(dev);
 	virtio_net_t *virtio_net = nic_get_specific(nic);
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
 
@@ -91,6 +99,13 @@ static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 		nic_frame_t *frame = nic_alloc_frame(nic, len - sizeof(*hdr));
 		if (frame) {
 			memcpy(frame->data, &hdr[1], len - sizeof(*hdr));
+			/*
+			 * Frames with partial checksum were never on the wire,
+			 * their data are as good as validated.
+			 */
+			if (hdr->flags & (VIRTIO_NET_HDR_F_NEEDS_CSUM |
+			    VIRTIO_NET_HDR_F_DATA_VALID))
+				frame->flags = NIC_FF_L4_CSUM_OK;
 			nic_received_frame(nic, frame);
 		} else {
 			ddf_msg(LVL_WARN,
@@ -110,6 +125,57 @@ static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
 	}
 }
 
+static void virtio_net_irq_handler(ipc_call_t *icall, ddf_dev_t *dev)
+{
+	nic_t *nic = ddf_dev_data_get(dev);
+
+	virtio_net_process_queues(nic);
+}
+
+/** Set polling mode
+ *
+ * The notifications of the RX and TX virtqueues are suppressed while the
+ * NIC is polled. There is no hardware timer, so periodic polling is left
+ * to the software period of the NIC framework.
+ *
+ * @param nic     NIC data
+ * @param mode    The mode to set
+ * @param period  The period for NIC_POLL_PERIODIC
+ *
+ * @return EOK if succeed
+ * @return ENOTSUP if the mode is not supported
+ */
+static errno_t virtio_net_poll_mode_change(nic_t *nic, nic_poll_mode_t mode,
+    const struct timespec *period)
+{
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+
+	switch (mode) {
+	case NIC_POLL_IMMEDIATE:
+		virtio_virtq_set_interrupts(vdev, RX_QUEUE_1, true);
+		virtio_virtq_set_interrupts(vdev, TX_QUEUE_1, true);
+		/* Pick up buffers used while the notifications were off */
+		virtio_net_process_queues(nic);
+		return EOK;
+	case NIC_POLL_ON_DEMAND:
+		virtio_virtq_set_interrupts(vdev, RX_QUEUE_1, false);
+		virtio_virtq_set_interrupts(vdev, TX_QUEUE_1, false);
+		return EOK;
+	default:
+		return ENOTSUP;
+	}
+}
+
+/** Force processing of the used buffers
+ *
+ * @param nic  NIC data
+ */
+static void virtio_net_poll(nic_t *nic)
+{
+	virtio_net_process_queues(nic);
+}
+
 static errno_t virtio_net_register_interrupt(ddf_dev_t *dev)
 {
 	nic_t *nic = ddf_dev_data_get(dev);
@@ -197,7 +263,8 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 
 	/* Reset the device and negotiate the feature bits */
 	rc = virtio_device_setup_start(vdev,
-	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ);
+	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ,
+	    VIRTIO_NET_F_CSUM | VIRTIO_NET_F_GUEST_CSUM);
 	if (rc != EOK)
 		goto fail;
 
@@ -324,7 +391,8 @@ static void virtio_net_uninitialize(ddf_dev_t *dev)
 	virtio_pci_dev_cleanup(&virtio_net->virtio_dev);
 }
 
-static void virtio_net_send(nic_t *nic, void *data, size_t size)
+static void virtio_net_send_offload(nic_t *nic, void *data, size_t size,
+    uint32_t flags)
 {
 	virtio_net_t *virtio_net = nic_get_specific(nic);
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
@@ -348,6 +416,17 @@ static void virtio_net_send(nic_t *nic, void *data, size_t size)
 	hdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
 	hdr->num_buffers = 0;
 
+	/* Let the device complete the checksum seeded by the stack */
+	size_t csum_start;
+	size_t csum_offs;
+	if ((flags & NIC_FF_L4_CSUM) &&
+	    nic_offload_csum_location(data, size, &csum_start,
+	    &csum_offs) == EOK) {
+		hdr->flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+		hdr->csum_start = csum_start;
+		hdr->csum_offset = csum_offs - csum_start;
+	}
+
 	/* Copy packet data into the buffer just past the header */
 	memcpy(&hdr[1], data, size);
 
@@ -359,6 +438,11 @@ static void virtio_net_send(nic_t *nic, void *data, size_t size)
 	virtio_virtq_produce_available(vdev, TX_QUEUE_1, descno);
 }
 
+static void virtio_net_send(nic_t *nic, void *data, size_t size)
+{
+	virtio_net_send_offload(nic, data, size, 0);
+}
+
 static errno_t virtio_net_on_multicast_mode_change(nic_t *nic,
     nic_multicast_mode_t new_mode, const nic_address_t *address_list,
     size_t address_count)
@@ -414,6 +498,24 @@ static errno_t virtio_net_dev_add(ddf_dev_t *dev)
 	nic_set_filtering_change_handlers(nic, NULL,
 	    virtio_net_on_multicast_mode_change,
 	    virtio_net_on_broadcast_mode_change, NULL, NULL);
+	nic_set_poll_handlers(nic, virtio_net_poll_mode_change,
+	    virtio_net_poll);
+
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	uint32_t features = virtio_net->virtio_dev.features;
+	uint32_t offload = 0;
+	if (features & VIRTIO_NET_F_CSUM)
+		offload |= NIC_OFFLOAD_TX_L4_CSUM;
+	if (features & VIRTIO_NET_F_GUEST_CSUM)
+		offload |= NIC_OFFLOAD_RX_L4_CSUM;
+	nic_set_offload_handlers(nic, offload, NULL, virtio_net_send_offload);
+
+	struct timespec period;
+	period.tv_sec = 0;
+	period.tv_nsec = USEC2NSEC(VIRTIO_NET_POLL_PERIOD_USEC);
+	rc = nic_report_poll_mode(nic, NIC_POLL_ADAPTIVE, &period);
+	if (rc != EOK)
+		goto destroy;
 
 	rc = ddf_fun_bind(fun);
 	if (rc != EOK) {
@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libcamd64
+ * @{
+ */
+/** @file
+ * @brief Hardware-assisted AES and GHASH.
+ *
+ * The AES rounds map directly to the AES-NI instructions, independent
+ * blocks are processed four at a time to hide the instruction latency.
+ * GHASH multiplies in GF(2^128) with carry-less multiplication
+ * (PCLMULQDQ) as described in Intel's "Carry-Less Multiplication
+ * Instruction and its Usage for Computing the GCM Mode".
+ */
+
+#ifndef _LIBC_amd64_AES_H_
+#define _LIBC_amd64_AES_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <libarch/cpuid.h>
+
+#define ARCH_AES
+#define ARCH_GHASH
+
+typedef long long aes_v2di_t __attribute__((vector_size(16)));
+
+struct aes_au128 {
+	aes_v2di_t n;
+} __attribute__((packed));
+
+/** Apply one AES instruction to @a state with round key @a key. */
+#define AES_ROUND(insn, state, key) \
+	asm ( \
+	    insn " %[k], %[s]\n" \
+	    : [s] "+x" (state) \
+	    : [k] "x" (key) \
+	)
+
+static inline aes_v2di_t aes_load(const uint8_t *data)
+{
+	return ((const struct aes_au128 *) data)->n;
+}
+
+static inline void aes_store(uint8_t *data, aes_v2di_t value)
+{
+	((struct aes_au128 *) data)->n = value;
+}
+
+static inline bool arch_aes_probe(void)
+{
+	cpu_info_t info;
+
+	cpuid(CPUID_STANDARD, &info);
+	return (info.cpuid_ecx & CPUID_AES) != 0;
+}
+
+/** Run the AES rounds over a sequence of independent blocks.
+ *
+ * The round keys are expected in the layout of the equivalent
+ * inverse cipher for decryption, as used by aesdec.
+ *
+ * @param rk      Round keys (rounds + 1 blocks).
+ * @param rounds  Number of rounds.
+ * @param decrypt Run the inverse cipher.
+ * @param in      Input blocks.
+ * @param out     Output blocks.
+ * @param blocks  Number of blocks.
+ *
+ */
+static inline void arch_aes_blocks(const uint8_t (*rk)[16], size_t rounds,
+    bool decrypt, const uint8_t *in, uint8_t *out, size_t blocks)
+{
+	aes_v2di_t k0 = aes_load(rk[0]);
+	aes_v2di_t kn = aes_load(rk[rounds]);
+
+	while (blocks >= 4) {
+		aes_v2di_t s0 = aes_load(in) ^ k0;
+		aes_v2di_t s1 = aes_load(in + 16) ^ k0;
+		aes_v2di_t s2 = aes_load(in + 32) ^ k0;
+		aes_v2di_t s3 = aes_load(in + 48) ^ k0;
+
+		for (size_t r = 1; r < rounds; r++) {
+			aes_v2di_t k = aes_load(rk[r]);
+
+			if (decrypt) {
+				AES_ROUND("aesdec", s0, k);
+				AES_ROUND("aesdec", s1, k);
+				AES_ROUND("aesdec", s2, k);
+				AES_ROUND("aesdec", s3, k);
+			} else {
+				AES_ROUND("aesenc", s0, k);
+				AES_ROUND("aesenc", s1, k);
+				AES_ROUND("aesenc", s2, k);
+				AES_ROUND("aesenc", s3, k);
+			}
+		}
+
+		if (decrypt) {
+			AES_ROUND("aesdeclast", s0, kn);
+			AES_ROUND("aesdeclast", s1, kn);
+			AES_ROUND("aesdeclast", s2, kn);
+			AES_ROUND("aesdeclast", s3, kn);
+		} else {
+			AES_ROUND("aesenclast", s0, kn);
+			AES_ROUND("aesenclast", s1, kn);
+			AES_ROUND("aesenclast", s2, kn);
+			AES_ROUND("aesenclast", s3, kn);
+		}
+
+		aes_store(out, s0);
+		aes_store(out + 16, s1);
+		aes_store(out + 32, s2);
+		aes_store(out + 48, s3);
+
+		in += 64;
+		out += 64;
+		blocks -= 4;
+	}
+
+	while (blocks > 0) {
+		aes_v2di_t s = aes_load(in) ^ k0;
+
+		for (size_t r = 1; r < rounds; r++) {
+			aes_v2di_t k = aes_load(rk[r]);
+
+			if (decrypt)
+				AES_ROUND("aesdec", s, k);
+			else
+				AES_ROUND("aesenc", s, k);
+		}
+
+		if (decrypt)
+			AES_ROUND("aesdeclast", s, kn);
+		else
+			AES_ROUND("aesenclast", s, kn);
+
+		aes_store(out, s);
+
+		in += 16;
+		out += 16;
+		blocks--;
+	}
+}
+
+static inline bool arch_ghash_probe(void)
+{
+	cpu_info_t info;
+
+	cpuid(CPUID_STANDARD, &info);
+	return (info.cpuid_ecx & CPUID_PCLMULQDQ) != 0;
+}
+
+/** Carry-less multiplication of two 64-bit values.
+ *
+ * @param a  First factor.
+ * @param b  Second factor.
+ * @param hi Upper half of the product.
+ * @param lo Lower half of the product.
+ *
+ */
+static inline void ghash_clmul(uint64_t a, uint64_t b, uint64_t *hi,
+    uint64_t *lo)
+{
+	aes_v2di_t va = { (long long) a, 0 };
+	aes_v2di_t vb = { (long long) b, 0 };
+
+	asm (
+	    "pclmulqdq $0x00, %[b], %[a]\n"
+	    : [a] "+x" (va)
+	    : [b] "x" (vb)
+	);
+
+	*lo = va[0];
+	*hi = va[1];
+}
+
+/** Multiply in GF(2^128) as defined by GCM.
+ *
+ * The blocks are passed as pairs of 64-bit words holding the big-endian
+ * interpretation of the 16 bytes (most significant word first), which
+ * is the bit-reflected form the carry-less multiplication works on.
+ *
+ * @param x Factor, replaced by the product.
+ * @param h Second factor (the hash subkey).
+ *
+ */
+static inline void arch_ghash_mult(uint64_t x[2], const uint64_t h[2])
+{
+	uint64_t l1, l0, h1, h0, m1, m0, t1, t0;
+
+	/* Karatsuba multiplication into p3:p2:p1:p0 */
+	ghash_clmul(x[1], h[1], &l1, &l0);
+	ghash_clmul(x[0], h[0], &h1, &h0);
+	ghash_clmul(x[0] ^ x[1], h[0] ^ h[1], &m1, &m0);
+	m1 ^= l1 ^ h1;
+	m0 ^= l0 ^ h0;
+
+	uint64_t p0 = l0;
+	uint64_t p1 = l1 ^ m0;
+	uint64_t p2 = h0 ^ m1;
+	uint64_t p3 = h1;
+
+	/* Compensate for the bit reflection */
+	p3 = (p3 << 1) | (p2 >> 63);
+	p2 = (p2 << 1) | (p1 >> 63);
+	p1 = (p1 << 1) | (p0 >> 63);
+	p0 <<= 1;
+
+	/* Reduce modulo x^128 + x^7 + x^2 + x + 1 */
+	uint64_t d = p1 ^ (p0 << 63) ^ (p0 << 62) ^ (p0 << 57);
+
+	t1 = d ^ (d >> 1) ^ (d >> 2) ^ (d >> 7);
+	t0 = p0 ^ (p0 >> 1) ^ (p0 >> 2) ^ (p0 >> 7) ^
+	    (d << 63) ^ (d << 62) ^ (d << 57);
+
+	x[0] = p3 ^ t1;
+	x[1] = p2 ^ t0;
+}
+
+#endif
+
+/** @}
+ */
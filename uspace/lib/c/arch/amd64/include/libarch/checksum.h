@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libcamd64
+ * @{
+ */
+/** @file
+ * @brief Hardware-assisted CRC computation.
+ *
+ * CRC32C maps directly to the SSE4.2 crc32 instruction. CRC32 is
+ * computed by folding the data with carry-less multiplication
+ * (PCLMULQDQ) and reducing the result with Barrett reduction, as
+ * described in Intel's "Fast CRC Computation for Generic Polynomials
+ * Using PCLMULQDQ Instruction". All functions operate on the
+ * non-inverted CRC register.
+ */
+
+#ifndef _LIBC_amd64_CHECKSUM_H_
+#define _LIBC_amd64_CHECKSUM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <libarch/cpuid.h>
+
+#define ARCH_CRC32
+#define ARCH_CRC32C
+
+typedef long long crc_v2di_t __attribute__((vector_size(16)));
+typedef int crc_v4si_t __attribute__((vector_size(16)));
+
+struct crc_au128 {
+	crc_v2di_t n;
+} __attribute__((packed));
+
+struct crc_au64 {
+	uint64_t n;
+} __attribute__((packed));
+
+/** Carry-less multiply selected quadwords of @a a and @a b. */
+#define CRC_CLMUL(a, b, imm) \
+	({ \
+		crc_v2di_t __r = (a); \
+		asm ( \
+		    "pclmulqdq %[sel], %[src], %[dst]\n" \
+		    : [dst] "+x" (__r) \
+		    : [src] "x" (b), [sel] "i" (imm) \
+		); \
+		__r; \
+	})
+
+static inline crc_v2di_t crc_load(const uint8_t *data)
+{
+	return ((const struct crc_au128 *) data)->n;
+}
+
+/** Fold constants for the bit-reflected CRC32 polynomial. */
+static const crc_v2di_t crc32_k1k2 = { 0x0154442bd4, 0x01c6e41596 };
+static const crc_v2di_t crc32_k3k4 = { 0x01751997d0, 0x00ccaa009e };
+static const crc_v2di_t crc32_k5k0 = { 0x0163cd6124, 0x0000000000 };
+static const crc_v2di_t crc32_poly = { 0x01db710641, 0x01f7011641 };
+
+static inline bool arch_crc32_probe(void)
+{
+	cpu_info_t info;
+
+	cpuid(CPUID_STANDARD, &info);
+	return (info.cpuid_ecx & CPUID_PCLMULQDQ) != 0;
+}
+
+/** Fold blocks of 16 bytes into the CRC32 register.
+ *
+ * @param crc    CRC register to update.
+ * @param data   Data to process.
+ * @param length Length of the data in bytes.
+ *
+ * @return Number of bytes processed, a multiple of 16. Blocks shorter
+ *         than 64 bytes are left to the caller.
+ *
+ */
+static inline size_t arch_crc32(uint32_t *crc, const uint8_t *data,
+    size_t length)
+{
+	if (length < 64)
+		return 0;
+
+	size_t done = length & ~(size_t) 15;
+	size_t left = done - 64;
+
+	crc_v2di_t x0;
+	crc_v2di_t x1 = crc_load(data);
+	crc_v2di_t x2 = crc_load(data + 16);
+	crc_v2di_t x3 = crc_load(data + 32);
+	crc_v2di_t x4 = crc_load(data + 48);
+	crc_v2di_t x5;
+
+	x1 ^= (crc_v2di_t) { *crc, 0 };
+	data += 64;
+
+	/* Fold four blocks in parallel. */
+	x0 = crc32_k1k2;
+	while (left >= 64) {
+		x5 = CRC_CLMUL(x1, x0, 0x00);
+		x1 = CRC_CLMUL(x1, x0, 0x11) ^ x5 ^ crc_load(data);
+		x5 = CRC_CLMUL(x2, x0, 0x00);
+		x2 = CRC_CLMUL(x2, x0, 0x11) ^ x5 ^ crc_load(data + 16);
+		x5 = CRC_CLMUL(x3, x0, 0x00);
+		x3 = CRC_CLMUL(x3, x0, 0x11) ^ x5 ^ crc_load(data + 32);
+		x5 = CRC_CLMUL(x4, x0, 0x00);
+		x4 = CRC_CLMUL(x4, x0, 0x11) ^ x5 ^ crc_load(data + 48);
+
+		data += 64;
+		left -= 64;
+	}
+
+	/* Fold the four lanes into one. */
+	x0 = crc32_k3k4;
+	x5 = CRC_CLMUL(x1, x0, 0x00);
+	x1 = CRC_CLMUL(x1, x0, 0x11) ^ x5 ^ x2;
+	x5 = CRC_CLMUL(x1, x0, 0x00);
+	x1 = CRC_CLMUL(x1, x0, 0x11) ^ x5 ^ x3;
+	x5 = CRC_CLMUL(x1, x0, 0x00);
+	x1 = CRC_CLMUL(x1, x0, 0x11) ^ x5 ^ x4;
+
+	/* Fold the remaining single blocks. */
+	while (left >= 16) {
+		x5 = CRC_CLMUL(x1, x0, 0x00);
+		x1 = CRC_CLMUL(x1, x0, 0x11) ^ x5 ^ crc_load(data);
+
+		data += 16;
+		left -= 16;
+	}
+
+	/* Fold 128 bits to 64 bits. */
+	crc_v2di_t mask = { 0xffffffff, 0xffffffff };
+
+	x2 = CRC_CLMUL(x1, x0, 0x10);
+	x1 = (crc_v2di_t) { x1[1], 0 } ^ x2;
+
+	x0 = crc32_k5k0;
+	x2 = (crc_v2di_t) __builtin_shuffle((crc_v4si_t) x1,
+	    (crc_v4si_t) { 0, 0, 0, 0 }, (crc_v4si_t) { 1, 2, 3, 4 });
+	x1 = CRC_CLMUL(x1 & mask, x0, 0x00) ^ x2;
+
+	/* Barrett reduction to 32 bits. */
+	x0 = crc32_poly;
+	x2 = CRC_CLMUL(x1 & mask, x0, 0x10);
+	x2 = CRC_CLMUL(x2 & mask, x0, 0x00);
+	x1 ^= x2;
+
+	*crc = ((crc_v4si_t) x1)[1];
+	return done;
+}
+
+static inline bool arch_crc32c_probe(void)
+{
+	cpu_info_t info;
+
+	cpuid(CPUID_STANDARD, &info);
+	return (info.cpuid_ecx & CPUID_SSE4_2) != 0;
+}
+
+/** Process 8-byte words with the CRC32C instruction.
+ *
+ * @param crc    CRC register to update.
+ * @param data   Data to process.
+ * @param length Length of the data in bytes.
+ *
+ * @return Number of bytes processed, a multiple of 8.
+ *
+ */
+static inline size_t arch_crc32c(uint32_t *crc, const uint8_t *data,
+    size_t length)
+{
+	uint64_t reg = *crc;
+	size_t done = length & ~(size_t) 7;
+
+	for (size_t i = 0; i < done; i += 8) {
+		asm (
+		    "crc32q %[v], %[reg]\n"
+		    : [reg] "+r" (reg)
+		    : [v] "rm" (((const struct crc_au64 *) (data + i))->n)
+		);
+	}
+
+	*crc = reg;
+	return done;
+}
+
+#endif
+
+/** @}
+ */
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libcamd64
+ * @{
+ */
+/** @file
+ * @brief Processor identification.
+ */
+
+#ifndef _LIBC_amd64_CPUID_H_
+#define _LIBC_amd64_CPUID_H_
+
+#include <stdint.h>
+
+#define CPUID_LEVEL     0x00000000
+#define CPUID_STANDARD  0x00000001
+#define CPUID_FEATURES  0x00000007
+
+/* Leaf CPUID_STANDARD, ECX */
+#define CPUID_PCLMULQDQ  (1 << 1)
+#define CPUID_SSE4_2     (1 << 20)
+#define CPUID_AES        (1 << 25)
+
+/* Leaf CPUID_FEATURES, EBX */
+#define CPUID_ERMS  (1 << 9)
+#define CPUID_SHA   (1 << 29)
+
+typedef struct {
+	uint32_t cpuid_eax;
+	uint32_t cpuid_ebx;
+	uint32_t cpuid_ecx;
+	uint32_t cpuid_edx;
+} cpu_info_t;
+
+/** Query subleaf 0 of a CPUID leaf. */
+static inline void cpuid(uint32_t cmd, cpu_info_t *info)
+{
+	asm volatile (
+	    "cpuid\n"
+	    : "=a" (info->cpuid_eax), "=b" (info->cpuid_ebx),
+	      "=c" (info->cpuid_ecx), "=d" (info->cpuid_edx)
+	    : "a" (cmd), "c" (0)
+	);
+}
+
+/** Return the highest supported standard CPUID leaf. */
+static inline uint32_t cpuid_max_level(void)
+{
+	cpu_info_t info;
+
+	cpuid(CPUID_LEVEL, &info);
+	return info.cpuid_eax;
+}
+
+#endif
+
+/** @}
+ */
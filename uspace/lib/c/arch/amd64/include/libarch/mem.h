@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libcamd64
+ * @{
+ */
+/** @file
+ * @brief Architecture-specific block memory operations.
+ *
+ * Processors with Enhanced REP MOVSB/STOSB (ERMS) move large blocks
+ * faster with the string instructions than with the SSE2 loops, as
+ * they can use full cache line transfers and avoid read-for-ownership
+ * of the destination.
+ */
+
+#ifndef _LIBC_amd64_MEM_H_
+#define _LIBC_amd64_MEM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <libarch/cpuid.h>
+
+#define ARCH_MEM_LARGE
+
+/** Smallest block worth moving with the ERMS string instructions. */
+#define ERMS_THRESHOLD  2048
+
+/** Determine the size from which arch_memcpy_large() should be used.
+ *
+ * @return Block size threshold or SIZE_MAX if the string instructions
+ *         are slower than the generic loops on this processor.
+ *
+ */
+static inline size_t arch_mem_large_threshold(void)
+{
+	cpu_info_t info;
+
+	if (cpuid_max_level() < CPUID_FEATURES)
+		return SIZE_MAX;
+
+	cpuid(CPUID_FEATURES, &info);
+	if ((info.cpuid_ebx & CPUID_ERMS) == 0)
+		return SIZE_MAX;
+
+	return ERMS_THRESHOLD;
+}
+
+/** Copy a large non-overlapping block. */
+static inline void arch_memcpy_large(void *dst, const void *src, size_t n)
+{
+	asm volatile (
+	    "rep movsb\n"
+	    : "+D" (dst), "+S" (src), "+c" (n)
+	    :
+	    : "memory"
+	);
+}
+
+/** Fill a large block with a constant byte. */
+static inline void arch_memset_large(void *dst, int b, size_t n)
+{
+	asm volatile (
+	    "rep stosb\n"
+	    : "+D" (dst), "+c" (n)
+	    : "a" (b)
+	    : "memory"
+	);
+}
+
+#endif
+
+/** @}
+ */
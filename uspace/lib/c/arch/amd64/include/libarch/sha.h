@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libcamd64
+ * @{
+ */
+/** @file
+ * @brief Hardware-assisted SHA-1 and SHA-256 compression.
+ *
+ * Uses the SHA extensions (SHA-NI). The round instructions keep the
+ * working variables packed in two vectors, SHA-1 as ABCD and E and
+ * SHA-256 as ABEF and CDGH, with the first variable in the top lane.
+ */
+
+#ifndef _LIBC_amd64_SHA_H_
+#define _LIBC_amd64_SHA_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <libarch/cpuid.h>
+
+#define ARCH_SHA1
+#define ARCH_SHA256
+
+typedef uint32_t sha_v4si_t __attribute__((vector_size(16)));
+
+/** Round constants of SHA-256, four per vector. */
+static const sha_v4si_t sha256_k4[16] = {
+	{ 0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5 },
+	{ 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5 },
+	{ 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3 },
+	{ 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174 },
+	{ 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc },
+	{ 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da },
+	{ 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7 },
+	{ 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967 },
+	{ 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13 },
+	{ 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85 },
+	{ 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3 },
+	{ 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070 },
+	{ 0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5 },
+	{ 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3 },
+	{ 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208 },
+	{ 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2 }
+};
+
+/** Apply a two-operand SHA instruction, the result replaces @a dst. */
+#define SHA_OP(insn, dst, src) \
+	asm ( \
+	    insn " %[s], %[d]\n" \
+	    : [d] "+x" (dst) \
+	    : [s] "x" (src) \
+	)
+
+/** Four SHA-1 rounds with round function @a func. */
+#define SHA1_RNDS4(abcd, e, func) \
+	asm ( \
+	    "sha1rnds4 %[f], %[w], %[s]\n" \
+	    : [s] "+x" (abcd) \
+	    : [w] "x" (e), [f] "i" (func) \
+	)
+
+static inline uint32_t sha_load_be32(const uint8_t *data)
+{
+	return ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) |
+	    ((uint32_t) data[2] << 8) | data[3];
+}
+
+static inline bool sha_probe(void)
+{
+	cpu_info_t info;
+
+	if (cpuid_max_level() < CPUID_FEATURES)
+		return false;
+
+	cpuid(CPUID_FEATURES, &info);
+	return (info.cpuid_ebx & CPUID_SHA) != 0;
+}
+
+static inline bool arch_sha1_probe(void)
+{
+	return sha_probe();
+}
+
+/** Run the SHA-1 compression function over a sequence of blocks.
+ *
+ * @param h      Hash state (five words).
+ * @param data   Input blocks.
+ * @param blocks Number of 64-byte blocks.
+ *
+ */
+static inline void arch_sha1_blocks(uint32_t *h, const uint8_t *data,
+    size_t blocks)
+{
+	sha_v4si_t abcd = { h[3], h[2], h[1], h[0] };
+	sha_v4si_t e0 = { 0, 0, 0, h[4] };
+
+	while (blocks > 0) {
+		sha_v4si_t abcd_save = abcd;
+		sha_v4si_t e_save = e0;
+		sha_v4si_t w[4];
+		sha_v4si_t e = e0;
+		sha_v4si_t prev = abcd;
+
+		for (size_t i = 0; i < 4; i++) {
+			const uint8_t *p = data + 16 * i;
+
+			w[i] = (sha_v4si_t) {
+				sha_load_be32(p + 12), sha_load_be32(p + 8),
+				sha_load_be32(p + 4), sha_load_be32(p)
+			};
+		}
+
+		for (size_t g = 0; g < 20; g++) {
+			sha_v4si_t wg;
+
+			if (g < 4) {
+				wg = w[g];
+			} else {
+				/* Message schedule for the next four words */
+				wg = w[g % 4];
+				SHA_OP("sha1msg1", wg, w[(g + 1) % 4]);
+				wg ^= w[(g + 2) % 4];
+				SHA_OP("sha1msg2", wg, w[(g + 3) % 4]);
+				w[g % 4] = wg;
+			}
+
+			if (g == 0) {
+				e += wg;
+			} else {
+				e = prev;
+				SHA_OP("sha1nexte", e, wg);
+			}
+
+			prev = abcd;
+
+			switch (g / 5) {
+			case 0:
+				SHA1_RNDS4(abcd, e, 0);
+				break;
+			case 1:
+				SHA1_RNDS4(abcd, e, 1);
+				break;
+			case 2:
+				SHA1_RNDS4(abcd, e, 2);
+				break;
+			default:
+				SHA1_RNDS4(abcd, e, 3);
+				break;
+			}
+		}
+
+		e0 = prev;
+		SHA_OP("sha1nexte", e0, e_save);
+		abcd += abcd_save;
+
+		data += 64;
+		blocks--;
+	}
+
+	h[0] = abcd[3];
+	h[1] = abcd[2];
+	h[2] = abcd[1];
+	h[3] = abcd[0];
+	h[4] = e0[3];
+}
+
+static inline bool arch_sha256_probe(void)
+{
+	return sha_probe();
+}
+
+/** Run the SHA-256 compression function over a sequence of blocks.
+ *
+ * @param h      Hash state (eight words).
+ * @param data   Input blocks.
+ * @param blocks Number of 64-byte blocks.
+ *
+ */
+static inline void arch_sha256_blocks(uint32_t *h, const uint8_t *data,
+    size_t blocks)
+{
+	sha_v4si_t abef = { h[5], h[4], h[1], h[0] };
+	sha_v4si_t cdgh = { h[7], h[6], h[3], h[2] };
+
+	while (blocks > 0) {
+		sha_v4si_t abef_save = abef;
+		sha_v4si_t cdgh_save = cdgh;
+		sha_v4si_t w[4];
+
+		for (size_t i = 0; i < 4; i++) {
+			const uint8_t *p = data + 16 * i;
+
+			w[i] = (sha_v4si_t) {
+				sha_load_be32(p), sha_load_be32(p + 4),
+				sha_load_be32(p + 8), sha_load_be32(p + 12)
+			};
+		}
+
+		for (size_t g = 0; g < 16; g++) {
+			sha_v4si_t wg;
+
+			if (g < 4) {
+				wg = w[g];
+			} else {
+				/* Message schedule for the next four words */
+				sha_v4si_t w1 = w[(g + 3) % 4];
+				sha_v4si_t w2 = w[(g + 2) % 4];
+
+				wg = w[g % 4];
+				SHA_OP("sha256msg1", wg, w[(g + 1) % 4]);
+				wg += (sha_v4si_t) { w2[1], w2[2], w2[3], w1[0] };
+				SHA_OP("sha256msg2", wg, w1);
+				w[g % 4] = wg;
+			}
+
+			sha_v4si_t wk = wg + sha256_k4[g];
+			sha_v4si_t wk_hi = { wk[2], wk[3], 0, 0 };
+
+			/* Two rounds at a time, the constants are taken from xmm0 */
+			asm (
+			    "sha256rnds2 %[k], %[ab], %[cd]\n"
+			    : [cd] "+x" (cdgh)
+			    : [ab] "x" (abef), [k] "Yz" (wk)
+			);
+			asm (
+			    "sha256rnds2 %[k], %[cd], %[ab]\n"
+			    : [ab] "+x" (abef)
+			    : [cd] "x" (cdgh), [k] "Yz" (wk_hi)
+			);
+		}
+
+		abef += abef_save;
+		cdgh += cdgh_save;
+
+		data += 64;
+		blocks--;
+	}
+
+	h[0] = abef[3];
+	h[1] = abef[2];
+	h[2] = cdgh[3];
+	h[3] = cdgh[2];
+	h[4] = abef[1];
+	h[5] = abef[0];
+	h[6] = cdgh[1];
+	h[7] = cdgh[0];
+}
+
+#endif
+
+/** @}
+ */
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libcarm64
+ * @{
+ */
+/** @file
+ * @brief Hardware-assisted AES and GHASH.
+ *
+ * The AES instructions of the ARMv8 Cryptographic Extension are
+ * optional and there is no way to probe for them from userspace, so
+ * they are only used when the target architecture guarantees them
+ * (+aes or +crypto). GHASH uses the generic 4-bit tables.
+ */
+
+#ifndef _LIBC_arm64_AES_H_
+#define _LIBC_arm64_AES_H_
+
+#if defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO)
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARCH_AES
+
+typedef uint8_t aes_v16qi_t __attribute__((vector_size(16)));
+
+struct aes_au128 {
+	aes_v16qi_t n;
+} __attribute__((packed));
+
+static inline aes_v16qi_t aes_load(const uint8_t *data)
+{
+	return ((const struct aes_au128 *) data)->n;
+}
+
+static inline void aes_store(uint8_t *data, aes_v16qi_t value)
+{
+	((struct aes_au128 *) data)->n = value;
+}
+
+static inline bool arch_aes_probe(void)
+{
+	return true;
+}
+
+/** Run the AES rounds over a sequence of independent blocks.
+ *
+ * The round keys are expected in the layout of the equivalent
+ * inverse cipher for decryption.
+ *
+ * @param rk      Round keys (rounds + 1 blocks).
+ * @param rounds  Number of rounds.
+ * @param decrypt Run the inverse cipher.
+ * @param in      Input blocks.
+ * @param out     Output blocks.
+ * @param blocks  Number of blocks.
+ *
+ */
+static inline void arch_aes_blocks(const uint8_t (*rk)[16], size_t rounds,
+    bool decrypt, const uint8_t *in, uint8_t *out, size_t blocks)
+{
+	aes_v16qi_t kn = aes_load(rk[rounds]);
+
+	while (blocks > 0) {
+		aes_v16qi_t s = aes_load(in);
+
+		for (size_t r = 0; r < rounds - 1; r++) {
+			aes_v16qi_t k = aes_load(rk[r]);
+
+			if (decrypt) {
+				asm (
+				    "aesd %0.16b, %1.16b\n"
+				    "aesimc %0.16b, %0.16b\n"
+				    : "+w" (s)
+				    : "w" (k)
+				);
+			} else {
+				asm (
+				    "aese %0.16b, %1.16b\n"
+				    "aesmc %0.16b, %0.16b\n"
+				    : "+w" (s)
+				    : "w" (k)
+				);
+			}
+		}
+
+		aes_v16qi_t k = aes_load(rk[rounds - 1]);
+
+		if (decrypt) {
+			asm (
+			    "aesd %0.16b, %1.16b\n"
+			    : "+w" (s)
+			    : "w" (k)
+			);
+		} else {
+			asm (
+			    "aese %0.16b, %1.16b\n"
+			    : "+w" (s)
+			    : "w" (k)
+			);
+		}
+
+		aes_store(out, s ^ kn);
+
+		in += 16;
+		out += 16;
+		blocks--;
+	}
+}
+
+#endif
+
+#endif
+
+/** @}
+ */
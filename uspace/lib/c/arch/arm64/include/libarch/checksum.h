@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libcarm64
+ * @{
+ */
+/** @file
+ * @brief Hardware-assisted CRC computation.
+ *
+ * The CRC32 instructions are optional in ARMv8.0 and there is no way
+ * to probe for them from userspace, so they are only used when the
+ * target architecture guarantees them (ARMv8.1 and later, or +crc).
+ * All functions operate on the non-inverted CRC register.
+ */
+
+#ifndef _LIBC_arm64_CHECKSUM_H_
+#define _LIBC_arm64_CHECKSUM_H_
+
+#ifdef __ARM_FEATURE_CRC32
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARCH_CRC32
+#define ARCH_CRC32C
+
+struct crc_au64 {
+	uint64_t n;
+} __attribute__((packed));
+
+static inline bool arch_crc32_probe(void)
+{
+	return true;
+}
+
+/** Process 8-byte words with the CRC32 instruction.
+ *
+ * @param crc    CRC register to update.
+ * @param data   Data to process.
+ * @param length Length of the data in bytes.
+ *
+ * @return Number of bytes processed, a multiple of 8.
+ *
+ */
+static inline size_t arch_crc32(uint32_t *crc, const uint8_t *data,
+    size_t length)
+{
+	uint32_t reg = *crc;
+	size_t done = length & ~(size_t) 7;
+
+	for (size_t i = 0; i < done; i += 8) {
+		reg = __builtin_aarch64_crc32x(reg,
+		    ((const struct crc_au64 *) (data + i))->n);
+	}
+
+	*crc = reg;
+	return done;
+}
+
+static inline bool arch_crc32c_probe(void)
+{
+	return true;
+}
+
+/** Process 8-byte words with the CRC32C instruction.
+ *
+ * @param crc    CRC register to update.
+ * @param data   Data to process.
+ * @param length Length of the data in bytes.
+ *
+ * @return Number of bytes processed, a multiple of 8.
+ *
+ */
+static inline size_t arch_crc32c(uint32_t *crc, const uint8_t *data,
+    size_t length)
+{
+	uint32_t reg = *crc;
+	size_t done = length & ~(size_t) 7;
+
+	for (size_t i = 0; i < done; i += 8) {
+		reg = __builtin_aarch64_crc32cx(reg,
+		    ((const struct crc_au64 *) (data + i))->n);
+	}
+
+	*crc = reg;
+	return done;
+}
+
+#endif
+
+#endif
+
+/** @}
+ */
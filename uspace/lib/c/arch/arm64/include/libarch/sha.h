@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libcarm64
+ * @{
+ */
+/** @file
+ * @brief Hardware-assisted SHA-256 compression.
+ *
+ * The SHA-256 instructions of the ARMv8 Cryptographic Extension are
+ * optional and there is no way to probe for them from userspace, so
+ * they are only used when the target architecture guarantees them
+ * (+sha2 or +crypto).
+ */
+
+#ifndef _LIBC_arm64_SHA_H_
+#define _LIBC_arm64_SHA_H_
+
+#if defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO)
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARCH_SHA256
+
+typedef uint32_t sha_v4si_t __attribute__((vector_size(16)));
+
+/** Round constants of SHA-256, four per vector. */
+static const sha_v4si_t sha256_k4[16] = {
+	{ 0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5 },
+	{ 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5 },
+	{ 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3 },
+	{ 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174 },
+	{ 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc },
+	{ 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da },
+	{ 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7 },
+	{ 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967 },
+	{ 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13 },
+	{ 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85 },
+	{ 0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3 },
+	{ 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070 },
+	{ 0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5 },
+	{ 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3 },
+	{ 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208 },
+	{ 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2 }
+};
+
+static inline uint32_t sha_load_be32(const uint8_t *data)
+{
+	return ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) |
+	    ((uint32_t) data[2] << 8) | data[3];
+}
+
+static inline bool arch_sha256_probe(void)
+{
+	return true;
+}
+
+/** Run the SHA-256 compression function over a sequence of blocks.
+ *
+ * @param h      Hash state (eight words).
+ * @param data   Input blocks.
+ * @param blocks Number of 64-byte blocks.
+ *
+ */
+static inline void arch_sha256_blocks(uint32_t *h, const uint8_t *data,
+    size_t blocks)
+{
+	sha_v4si_t abcd = { h[0], h[1], h[2], h[3] };
+	sha_v4si_t efgh = { h[4], h[5], h[6], h[7] };
+
+	while (blocks > 0) {
+		sha_v4si_t abcd_save = abcd;
+		sha_v4si_t efgh_save = efgh;
+		sha_v4si_t w[4];
+
+		for (size_t i = 0; i < 4; i++) {
+			const uint8_t *p = data + 16 * i;
+
+			w[i] = (sha_v4si_t) {
+				sha_load_be32(p), sha_load_be32(p + 4),
+				sha_load_be32(p + 8), sha_load_be32(p + 12)
+			};
+		}
+
+		for (size_t g = 0; g < 16; g++) {
+			sha_v4si_t wg;
+
+			if (g < 4) {
+				wg = w[g];
+			} else {
+				/* Message schedule for the next four words */
+				wg = w[g % 4];
+				asm (
+				    "sha256su0 %0.4s, %1.4s\n"
+				    "sha256su1 %0.4s, %2.4s, %3.4s\n"
+				    : "+w" (wg)
+				    : "w" (w[(g + 1) % 4]), "w" (w[(g + 2) % 4]),
+				      "w" (w[(g + 3) % 4])
+				);
+				w[g % 4] = wg;
+			}
+
+			sha_v4si_t wk = wg + sha256_k4[g];
+			sha_v4si_t prev = abcd;
+
+			asm (
+			    "sha256h %q0, %q1, %2.4s\n"
+			    : "+w" (abcd)
+			    : "w" (efgh), "w" (wk)
+			);
+			asm (
+			    "sha256h2 %q0, %q1, %2.4s\n"
+			    : "+w" (efgh)
+			    : "w" (prev), "w" (wk)
+			);
+		}
+
+		abcd += abcd_save;
+		efgh += efgh_save;
+
+		data += 64;
+		blocks--;
+	}
+
+	for (size_t i = 0; i < 4; i++) {
+		h[i] = abcd[i];
+		h[i + 4] = efgh[i];
+	}
+}
+
+#endif
+
+#endif
+
+/** @}
+ */
@@ -39,7 +39,12 @@
 #include <limits.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <mem.h>
+#include <macros.h>
+#include <align.h>
 #include <async.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <io/kio.h>
 #include <vfs/vfs.h>
 #include <vfs/vfs_sess.h>
@@ -50,6 +55,12 @@
 #include "../private/io.h"
 #include "../private/stdio.h"
 
+/** Preferred size of a fully buffered stream buffer */
+#define STDIO_BUF_DEFAULT  (32 * 1024)
+
+/** Upper bound on an adaptively sized stream buffer */
+#define STDIO_BUF_MAX  (64 * 1024)
+
 static void _ffillbuf(FILE *stream);
 static void _fflushbuf(FILE *stream);
 
@@ -77,6 +88,7 @@ static __stream_ops_t stdio_vfs_ops = {
 };
 
 static FILE stdin_null = {
+	.lock = FIBRIL_MUTEX_INITIALIZER(stdin_null.lock),
 	.fd = -1,
 	.pos = 0,
 	.error = true,
@@ -93,6 +105,7 @@ static FILE stdin_null = {
 };
 
 static FILE stdout_kio = {
+	.lock = FIBRIL_MUTEX_INITIALIZER(stdout_kio.lock),
 	.fd = -1,
 	.pos = 0,
 	.error = false,
@@ -109,6 +122,7 @@ static FILE stdout_kio = {
 };
 
 static FILE stderr_kio = {
+	.lock = FIBRIL_MUTEX_INITIALIZER(stderr_kio.lock),
 	.fd = -1,
 	.pos = 0,
 	.error = false,
@@ -263,12 +277,23 @@ static bool parse_mode(const char *fmode, int *mode, bool *create, bool *excl,
 	return true;
 }
 
-/** Set stream buffer. */
+/** Set stream buffer.
+ *
+ * A @p size of zero with a NULL @p buf lets the stream pick the buffer
+ * size on first use (see _fallocbuf()).
+ */
 int setvbuf(FILE *stream, void *buf, int mode, size_t size)
 {
 	if (mode != _IONBF && mode != _IOLBF && mode != _IOFBF)
 		return -1;
 
+	flockfile(stream);
+
+	if (stream->buf_alloc) {
+		free(stream->buf);
+		stream->buf_alloc = false;
+	}
+
 	stream->btype = mode;
 	stream->buf = buf;
 	stream->buf_size = size;
@@ -276,6 +301,7 @@ int setvbuf(FILE *stream, void *buf, int mode, size_t size)
 	stream->buf_tail = stream->buf;
 	stream->buf_state = _bs_empty;
 
+	funlockfile(stream);
 	return 0;
 }
 
@@ -306,21 +332,66 @@ static void _setvbuf(FILE *stream)
 		setvbuf(stream, NULL, _IONBF, 0);
 		break;
 	default:
-		setvbuf(stream, NULL, _IOFBF, BUFSIZ);
+		/* Size is chosen by _fallocbuf() once the stream is used. */
+		setvbuf(stream, NULL, _IOFBF, 0);
 	}
 }
 
-/** Allocate stream buffer. */
-static int _fallocbuf(FILE *stream)
+/** Choose buffer size for a fully buffered stream.
+ *
+ * The buffer is made a multiple of the file system block size so that
+ * refills and drains map onto whole blocks. A file that is opened for
+ * reading and is smaller than the default buffer only gets a buffer
+ * large enough to hold it.
+ *
+ * @param stream  Stream
+ * @param reading @c true if the first buffered operation is a read
+ * @return Buffer size in bytes
+ */
+static size_t _fbufsize(FILE *stream, bool reading)
+{
+	vfs_statfs_t stf;
+	vfs_stat_t st;
+	size_t bsize;
+	size_t size;
+
+	if (stream->fd < 0 || vfs_statfs(stream->fd, &stf) != EOK ||
+	    stf.f_bsize == 0 || stf.f_bsize > STDIO_BUF_MAX)
+		return BUFSIZ;
+
+	bsize = stf.f_bsize;
+	size = min(ALIGN_UP(STDIO_BUF_DEFAULT, bsize), STDIO_BUF_MAX);
+
+	if (reading && vfs_stat(stream->fd, &st) == EOK && st.is_file &&
+	    st.size < size) {
+		size = ALIGN_UP(st.size, bsize);
+		if (size < BUFSIZ)
+			size = BUFSIZ;
+	}
+
+	return size;
+}
+
+/** Allocate stream buffer.
+ *
+ * @param stream  Stream
+ * @param reading @c true if the buffer is allocated for reading
+ */
+static int _fallocbuf(FILE *stream, bool reading)
 {
 	assert(stream->buf == NULL);
 
+	if (stream->buf_size == 0)
+		stream->buf_size = _fbufsize(stream, reading);
+
 	stream->buf = malloc(stream->buf_size);
 	if (stream->buf == NULL) {
 		errno = ENOMEM;
 		return EOF;
 	}
 
+	stream->buf_alloc = true;
+
 	stream->buf_head = stream->buf;
 	stream->buf_tail = stream->buf;
 	return 0;
@@ -388,6 +459,10 @@ FILE *fopen(const char *path, const char *fmode)
 	stream->arg = NULL;
 	stream->sess = NULL;
 	stream->need_sync = false;
+	fibril_mutex_initialize(&stream->lock);
+	stream->lock_owner = NULL;
+	stream->lock_count = 0;
+	stream->buf_alloc = false;
 	_setvbuf(stream);
 	stream->ungetc_chars = 0;
 
@@ -413,6 +488,10 @@ FILE *fdopen(int fd, const char *mode)
 	stream->arg = NULL;
 	stream->sess = NULL;
 	stream->need_sync = false;
+	fibril_mutex_initialize(&stream->lock);
+	stream->lock_owner = NULL;
+	stream->lock_count = 0;
+	stream->buf_alloc = false;
 	_setvbuf(stream);
 	stream->ungetc_chars = 0;
 
@@ -425,7 +504,14 @@ static int _fclose_nofree(FILE *stream)
 {
 	errno_t rc = 0;
 
-	fflush(stream);
+	flockfile(stream);
+	fflush_unlocked(stream);
+	if (stream->buf_alloc) {
+		free(stream->buf);
+		stream->buf = NULL;
+		stream->buf_alloc = false;
+	}
+	funlockfile(stream);
 
 	if (stream->sess != NULL)
 		async_hangup(stream->sess);
@@ -473,6 +559,7 @@ FILE *freopen(const char *path, const char *mode, FILE *stream)
 
 	list_remove(&nstr->link);
 	*stream = *nstr;
+	fibril_mutex_initialize(&stream->lock);
 	list_append(&stream->link, &files);
 
 	free(nstr);
@@ -575,7 +662,85 @@ static void _fflushbuf(FILE *stream)
 	stream->buf_state = _bs_empty;
 }
 
-/** Read from a stream.
+/** Lock a stream.
+ *
+ * The lock is recursive so that a fibril holding a stream can still use
+ * the locking stdio functions on it.
+ *
+ * @param stream Stream
+ */
+void flockfile(FILE *stream)
+{
+	fid_t self = fibril_get_id();
+
+	if (stream->lock_owner == self) {
+		stream->lock_count++;
+		return;
+	}
+
+	fibril_mutex_lock(&stream->lock);
+	stream->lock_owner = self;
+	stream->lock_count = 1;
+}
+
+/** Try to lock a stream.
+ *
+ * @param stream Stream
+ * @return Zero on success, non-zero if the stream is locked by another fibril
+ */
+int ftrylockfile(FILE *stream)
+{
+	fid_t self = fibril_get_id();
+
+	if (stream->lock_owner == self) {
+		stream->lock_count++;
+		return 0;
+	}
+
+	if (!fibril_mutex_trylock(&stream->lock))
+		return -1;
+
+	stream->lock_owner = self;
+	stream->lock_count = 1;
+	return 0;
+}
+
+/** Unlock a stream.
+ *
+ * @param stream Stream locked by flockfile() or ftrylockfile()
+ */
+void funlockfile(FILE *stream)
+{
+	assert(stream->lock_owner == fibril_get_id());
+	assert(stream->lock_count > 0);
+
+	if (--stream->lock_count > 0)
+		return;
+
+	stream->lock_owner = NULL;
+	fibril_mutex_unlock(&stream->lock);
+}
+
+/** Flush standard output before blocking on input from @a stream.
+ *
+ * Only streams that are not fully buffered are considered interactive,
+ * reading a regular file does not need to push out pending output.
+ */
+static void _fflush_interactive(FILE *stream)
+{
+	if (stream->btype == _IOFBF)
+		return;
+
+	if (stdout != NULL)
+		fflush(stdout);
+	if (stderr != NULL)
+		fflush(stderr);
+}
+
+/** Read from a stream without locking it.
+ *
+ * Reads that are at least as large as the stream buffer and find the
+ * buffer empty are done directly into @a dest.
  *
  * @param dest   Destination buffer.
  * @param size   Size of each record.
@@ -583,14 +748,13 @@ static void _fflushbuf(FILE *stream)
  * @param stream Pointer to the stream.
  *
  */
-size_t fread(void *dest, size_t size, size_t nmemb, FILE *stream)
+size_t fread_unlocked(void *dest, size_t size, size_t nmemb, FILE *stream)
 {
 	uint8_t *dp;
 	size_t bytes_left;
 	size_t now;
 	size_t data_avail;
 	size_t total_read;
-	size_t i;
 
 	if (size == 0 || nmemb == 0)
 		return 0;
@@ -606,10 +770,14 @@ size_t fread(void *dest, size_t size, size_t nmemb, FILE *stream)
 		--bytes_left;
 	}
 
+	if (bytes_left == 0)
+		return (total_read / size);
+
 	/* If not buffered stream, read in directly. */
 	if (stream->btype == _IONBF) {
-		total_read += _fread(dest, 1, bytes_left, stream);
-		return total_read / size;
+		_fflush_interactive(stream);
+		total_read += _fread(dp, 1, bytes_left, stream);
+		return (total_read / size);
 	}
 
 	/* Make sure no data is pending write. */
@@ -618,29 +786,33 @@ size_t fread(void *dest, size_t size, size_t nmemb, FILE *stream)
 
 	/* Perform lazy allocation of stream buffer. */
 	if (stream->buf == NULL) {
-		if (_fallocbuf(stream) != 0)
+		if (_fallocbuf(stream, true) != 0)
 			return 0; /* Errno set by _fallocbuf(). */
 	}
 
 	while ((!stream->error) && (!stream->eof) && (bytes_left > 0)) {
-		if (stream->buf_head == stream->buf_tail)
-			_ffillbuf(stream);
+		if (stream->buf_head == stream->buf_tail) {
+			_fflush_interactive(stream);
+
+			if (bytes_left >= stream->buf_size) {
+				/* Large read, bypass the buffer. */
+				now = _fread(dp, 1, bytes_left, stream);
+				dp += now;
+				bytes_left -= now;
+				total_read += now;
+				continue;
+			}
 
-		if (stream->error || stream->eof) {
-			/* On error errno was set by _ffillbuf() */
-			break;
+			_ffillbuf(stream);
+			if (stream->error || stream->eof) {
+				/* On error errno was set by _ffillbuf() */
+				break;
+			}
 		}
 
 		data_avail = stream->buf_head - stream->buf_tail;
-
-		if (bytes_left > data_avail)
-			now = data_avail;
-		else
-			now = bytes_left;
-
-		for (i = 0; i < now; i++) {
-			dp[i] = stream->buf_tail[i];
-		}
+		now = min(bytes_left, data_avail);
+		memcpy(dp, stream->buf_tail, now);
 
 		dp += now;
 		stream->buf_tail += now;
@@ -651,7 +823,29 @@ size_t fread(void *dest, size_t size, size_t nmemb, FILE *stream)
 	return (total_read / size);
 }
 
-/** Write to a stream.
+/** Read from a stream.
+ *
+ * @param dest   Destination buffer.
+ * @param size   Size of each record.
+ * @param nmemb  Number of records to read.
+ * @param stream Pointer to the stream.
+ *
+ */
+size_t fread(void *dest, size_t size, size_t nmemb, FILE *stream)
+{
+	size_t nread;
+
+	flockfile(stream);
+	nread = fread_unlocked(dest, size, nmemb, stream);
+	funlockfile(stream);
+
+	return nread;
+}
+
+/** Write to a stream without locking it.
+ *
+ * Writes that are at least as large as the stream buffer and find the
+ * buffer empty are passed directly to the underlying file.
  *
  * @param buf    Source buffer.
  * @param size   Size of each record.
@@ -659,15 +853,14 @@ size_t fread(void *dest, size_t size, size_t nmemb, FILE *stream)
  * @param stream Pointer to the stream.
  *
  */
-size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
+size_t fwrite_unlocked(const void *buf, size_t size, size_t nmemb,
+    FILE *stream)
 {
-	uint8_t *data;
+	const uint8_t *data;
 	size_t bytes_left;
 	size_t now;
 	size_t buf_free;
 	size_t total_written;
-	size_t i;
-	uint8_t b;
 	bool need_flush;
 
 	if (size == 0 || nmemb == 0)
@@ -676,7 +869,7 @@ size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 	/* If not buffered stream, write out directly. */
 	if (stream->btype == _IONBF) {
 		now = _fwrite(buf, size, nmemb, stream);
-		fflush(stream);
+		fflush_unlocked(stream);
 		return now;
 	}
 
@@ -686,30 +879,33 @@ size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 
 	/* Perform lazy allocation of stream buffer. */
 	if (stream->buf == NULL) {
-		if (_fallocbuf(stream) != 0)
+		if (_fallocbuf(stream, false) != 0)
 			return 0; /* Errno set by _fallocbuf(). */
 	}
 
-	data = (uint8_t *) buf;
+	data = (const uint8_t *) buf;
 	bytes_left = size * nmemb;
 	total_written = 0;
-	need_flush = false;
+	need_flush = (stream->btype == _IOLBF) &&
+	    (memchr(data, '\n', bytes_left) != NULL);
 
 	while ((!stream->error) && (bytes_left > 0)) {
-		buf_free = stream->buf_size - (stream->buf_head - stream->buf);
-		if (bytes_left > buf_free)
-			now = buf_free;
-		else
-			now = bytes_left;
-
-		for (i = 0; i < now; i++) {
-			b = data[i];
-			stream->buf_head[i] = b;
-
-			if ((b == '\n') && (stream->btype == _IOLBF))
-				need_flush = true;
+		if ((stream->buf_head == stream->buf) &&
+		    (bytes_left >= stream->buf_size)) {
+			/* Large write, bypass the buffer. */
+			now = _fwrite(data, 1, bytes_left, stream);
+			data += now;
+			bytes_left -= now;
+			total_written += now;
+			if (now == 0)
+				break;
+			continue;
 		}
 
+		buf_free = stream->buf_size - (stream->buf_head - stream->buf);
+		now = min(bytes_left, buf_free);
+		memcpy(stream->buf_head, data, now);
+
 		data += now;
 		stream->buf_head += now;
 		buf_free -= now;
@@ -720,18 +916,35 @@ size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
 		if (buf_free == 0) {
 			/* Only need to drain buffer. */
 			_fflushbuf(stream);
-			if (!stream->error)
-				need_flush = false;
 		}
 	}
 
 	if (need_flush)
-		fflush(stream);
+		fflush_unlocked(stream);
 
 	return (total_written / size);
 }
 
-wint_t fputwc(wchar_t wc, FILE *stream)
+/** Write to a stream.
+ *
+ * @param buf    Source buffer.
+ * @param size   Size of each record.
+ * @param nmemb  Number of records to write.
+ * @param stream Pointer to the stream.
+ *
+ */
+size_t fwrite(const void *buf, size_t size, size_t nmemb, FILE *stream)
+{
+	size_t nwritten;
+
+	flockfile(stream);
+	nwritten = fwrite_unlocked(buf, size, nmemb, stream);
+	funlockfile(stream);
+
+	return nwritten;
+}
+
+wint_t fputwc_unlocked(wchar_t wc, FILE *stream)
 {
 	char buf[STR_BOUNDS(1)];
 	size_t sz = 0;
@@ -741,75 +954,148 @@ wint_t fputwc(wchar_t wc, FILE *stream)
 		return WEOF;
 	}
 
-	size_t wr = fwrite(buf, 1, sz, stream);
+	size_t wr = fwrite_unlocked(buf, 1, sz, stream);
 	if (wr < sz)
 		return WEOF;
 
 	return wc;
 }
 
+wint_t fputwc(wchar_t wc, FILE *stream)
+{
+	wint_t rc;
+
+	flockfile(stream);
+	rc = fputwc_unlocked(wc, stream);
+	funlockfile(stream);
+
+	return rc;
+}
+
 wint_t putwchar(wchar_t wc)
 {
 	return fputwc(wc, stdout);
 }
 
-int fputc(int c, FILE *stream)
+int fputc_unlocked(int c, FILE *stream)
 {
 	unsigned char b;
-	size_t wr;
 
 	b = (unsigned char) c;
-	wr = fwrite(&b, sizeof(b), 1, stream);
-	if (wr < 1)
+
+	/* Fast path: append to a write buffer that has room. */
+	if ((stream->buf_state == _bs_write) && (!stream->error) &&
+	    (stream->btype == _IOFBF || b != '\n') &&
+	    (stream->buf_head < stream->buf + stream->buf_size)) {
+		*stream->buf_head++ = b;
+		if (stream->buf_head == stream->buf + stream->buf_size)
+			_fflushbuf(stream);
+		return b;
+	}
+
+	if (fwrite_unlocked(&b, sizeof(b), 1, stream) < 1)
 		return EOF;
 
 	return b;
 }
 
+int fputc(int c, FILE *stream)
+{
+	int rc;
+
+	flockfile(stream);
+	rc = fputc_unlocked(c, stream);
+	funlockfile(stream);
+
+	return rc;
+}
+
+int putc_unlocked(int c, FILE *stream)
+{
+	return fputc_unlocked(c, stream);
+}
+
 int putchar(int c)
 {
 	return fputc(c, stdout);
 }
 
-int fputs(const char *str, FILE *stream)
+int putchar_unlocked(int c)
 {
-	(void) fwrite(str, str_size(str), 1, stream);
-	if (ferror(stream))
+	return fputc_unlocked(c, stdout);
+}
+
+int fputs_unlocked(const char *str, FILE *stream)
+{
+	(void) fwrite_unlocked(str, str_size(str), 1, stream);
+	if (ferror_unlocked(stream))
 		return EOF;
 	return 0;
 }
 
+int fputs(const char *str, FILE *stream)
+{
+	int rc;
+
+	flockfile(stream);
+	rc = fputs_unlocked(str, stream);
+	funlockfile(stream);
+
+	return rc;
+}
+
 int puts(const char *str)
 {
-	if (fputs(str, stdout) < 0)
+	int rc;
+
+	flockfile(stdout);
+	rc = fputs_unlocked(str, stdout);
+	if (rc == 0)
+		rc = fputc_unlocked('\n', stdout);
+	funlockfile(stdout);
+
+	return rc;
+}
+
+int fgetc_unlocked(FILE *stream)
+{
+	unsigned char c;
+
+	/* Fast path: take the next byte straight from the read buffer. */
+	if ((stream->ungetc_chars == 0) && (stream->buf_state == _bs_read) &&
+	    (stream->buf_tail < stream->buf_head))
+		return *stream->buf_tail++;
+
+	if (fread_unlocked(&c, sizeof(c), 1, stream) < 1)
 		return EOF;
-	return putchar('\n');
+
+	return c;
 }
 
 int fgetc(FILE *stream)
 {
-	char c;
+	int c;
 
-	/* This could be made faster by only flushing when needed. */
-	if (stdout)
-		fflush(stdout);
-	if (stderr)
-		fflush(stderr);
+	flockfile(stream);
+	c = fgetc_unlocked(stream);
+	funlockfile(stream);
 
-	if (fread(&c, sizeof(char), 1, stream) < sizeof(char))
-		return EOF;
+	return c;
+}
 
-	return (int) c;
+int getc_unlocked(FILE *stream)
+{
+	return fgetc_unlocked(stream);
 }
 
-char *fgets(char *str, int size, FILE *stream)
+char *fgets_unlocked(char *str, int size, FILE *stream)
 {
 	int c;
 	int idx;
 
 	idx = 0;
 	while (idx < size - 1) {
-		c = fgetc(stream);
+		c = fgetc_unlocked(stream);
 		if (c == EOF)
 			break;
 
@@ -819,7 +1105,7 @@ char *fgets(char *str, int size, FILE *stream)
 			break;
 	}
 
-	if (ferror(stream))
+	if (ferror_unlocked(stream))
 		return NULL;
 
 	if (idx == 0)
@@ -829,12 +1115,28 @@ char *fgets(char *str, int size, FILE *stream)
 	return str;
 }
 
+char *fgets(char *str, int size, FILE *stream)
+{
+	char *rc;
+
+	flockfile(stream);
+	rc = fgets_unlocked(str, size, stream);
+	funlockfile(stream);
+
+	return rc;
+}
+
 int getchar(void)
 {
 	return fgetc(stdin);
 }
 
-int ungetc(int c, FILE *stream)
+int getchar_unlocked(void)
+{
+	return fgetc_unlocked(stdin);
+}
+
+static int _ungetc(int c, FILE *stream)
 {
 	if (c == EOF)
 		return EOF;
@@ -849,7 +1151,18 @@ int ungetc(int c, FILE *stream)
 	return (uint8_t)c;
 }
 
-int fseek64(FILE *stream, off64_t offset, int whence)
+int ungetc(int c, FILE *stream)
+{
+	int rc;
+
+	flockfile(stream);
+	rc = _ungetc(c, stream);
+	funlockfile(stream);
+
+	return rc;
+}
+
+static int _fseek64(FILE *stream, off64_t offset, int whence)
 {
 	errno_t rc;
 
@@ -887,7 +1200,18 @@ int fseek64(FILE *stream, off64_t offset, int whence)
 	return 0;
 }
 
-off64_t ftell64(FILE *stream)
+int fseek64(FILE *stream, off64_t offset, int whence)
+{
+	int rc;
+
+	flockfile(stream);
+	rc = _fseek64(stream, offset, whence);
+	funlockfile(stream);
+
+	return rc;
+}
+
+static off64_t _ftell64(FILE *stream)
 {
 	if (stream->error)
 		return EOF;
@@ -901,6 +1225,17 @@ off64_t ftell64(FILE *stream)
 	return stream->pos - stream->ungetc_chars;
 }
 
+off64_t ftell64(FILE *stream)
+{
+	off64_t off;
+
+	flockfile(stream);
+	off = _ftell64(stream);
+	funlockfile(stream);
+
+	return off;
+}
+
 int fseek(FILE *stream, long offset, int whence)
 {
 	return fseek64(stream, offset, whence);
@@ -924,7 +1259,7 @@ void rewind(FILE *stream)
 	(void) fseek(stream, 0, SEEK_SET);
 }
 
-int fflush(FILE *stream)
+int fflush_unlocked(FILE *stream)
 {
 	if (stream->error)
 		return EOF;
@@ -949,22 +1284,62 @@ int fflush(FILE *stream)
 	return 0;
 }
 
-int feof(FILE *stream)
+int fflush(FILE *stream)
+{
+	int rc;
+
+	flockfile(stream);
+	rc = fflush_unlocked(stream);
+	funlockfile(stream);
+
+	return rc;
+}
+
+int feof_unlocked(FILE *stream)
 {
 	return stream->eof;
 }
 
-int ferror(FILE *stream)
+int feof(FILE *stream)
+{
+	int rc;
+
+	flockfile(stream);
+	rc = feof_unlocked(stream);
+	funlockfile(stream);
+
+	return rc;
+}
+
+int ferror_unlocked(FILE *stream)
 {
 	return stream->error;
 }
 
-void clearerr(FILE *stream)
+int ferror(FILE *stream)
+{
+	int rc;
+
+	flockfile(stream);
+	rc = ferror_unlocked(stream);
+	funlockfile(stream);
+
+	return rc;
+}
+
+void clearerr_unlocked(FILE *stream)
 {
 	stream->eof = false;
 	stream->error = false;
 }
 
+void clearerr(FILE *stream)
+{
+	flockfile(stream);
+	clearerr_unlocked(stream);
+	funlockfile(stream);
+}
+
 int fileno(FILE *stream)
 {
 	if (stream->ops != &stdio_vfs_ops) {
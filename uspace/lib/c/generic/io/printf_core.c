@@ -38,7 +38,9 @@
 
 #include <stdio.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <mem.h>
 #include <io/printf_core.h>
 #include <ctype.h>
 #include <str.h>
@@ -85,6 +87,9 @@
  */
 #define PRINT_NUMBER_BUFFER_SIZE  (64 + 5)
 
+/** Size of the buffer printf_core() collects output in */
+#define PRINTF_BUFFER_SIZE  256
+
 /** Get signed or unsigned integer argument */
 #define PRINTF_GET_INT_ARGUMENT(type, ap, flags) \
 	({ \
@@ -122,6 +127,33 @@ static const char *digits_small = "0123456789abcdef";
 static const char *digits_big = "0123456789ABCDEF";
 static const char invalch = U_SPECIAL;
 
+/** Decimal representation of 0 to 99, two digits each */
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/** Output collected by printf_core() before it is handed to the caller. */
+typedef struct {
+	/** Output methods of the caller */
+	printf_spec_t *ps;
+	/** Characters reported as printed by the caller's output methods */
+	size_t counter;
+	/** Number of bytes used in buf */
+	size_t len;
+	/** An output method of the caller has failed */
+	bool error;
+	/** Pending output */
+	char buf[PRINTF_BUFFER_SIZE];
+} printf_buffer_t;
+
 /** Unformatted double number string representation. */
 typedef struct {
 	/** Buffer with len digits, no sign or leading zeros. */
@@ -148,11 +180,180 @@ static int get_sign_char(bool negative, uint32_t flags)
 	}
 }
 
+/** Hand pending output over to the caller's output method.
+ *
+ * @param pb Output buffer.
+ *
+ * @return Zero on success, negative value on failure.
+ *
+ */
+static int printf_flush(printf_buffer_t *pb)
+{
+	if (pb->error)
+		return -1;
+
+	if (pb->len == 0)
+		return 0;
+
+	int ret = pb->ps->str_write(pb->buf, pb->len, pb->ps->data);
+	pb->len = 0;
+
+	if (ret < 0) {
+		pb->error = true;
+		return -1;
+	}
+
+	pb->counter += ret;
+	return 0;
+}
+
+/** Append characters to the output buffer.
+ *
+ * The buffer is flushed before it would have to split @a str, so the
+ * caller's output method always gets whole characters. Strings that do not
+ * fit into an empty buffer are passed on directly.
+ *
+ * @param str  Characters to print.
+ * @param size Number of bytes in @a str.
+ * @param pb   Output buffer.
+ *
+ * @return Number of bytes accepted, negative value on failure.
+ *
+ */
+static int printf_write(const char *str, size_t size, printf_buffer_t *pb)
+{
+	if (size > PRINTF_BUFFER_SIZE - pb->len) {
+		if (printf_flush(pb) < 0)
+			return -1;
+
+		if (size > PRINTF_BUFFER_SIZE) {
+			int ret = pb->ps->str_write(str, size, pb->ps->data);
+			if (ret < 0) {
+				pb->error = true;
+				return -1;
+			}
+
+			pb->counter += ret;
+			return ret;
+		}
+	}
+
+	if (pb->error)
+		return -1;
+
+	memcpy(pb->buf + pb->len, str, size);
+	pb->len += size;
+	return (int) size;
+}
+
+/** Print wide characters after the pending output.
+ *
+ * Unlike printf_write(), the result is not added to the counter of
+ * printed characters, that is up to the caller.
+ *
+ * @param str  Wide characters to print.
+ * @param size Number of bytes in @a str.
+ * @param pb   Output buffer.
+ *
+ * @return Return value of the caller's output method, negative value
+ *         on failure.
+ *
+ */
+static int printf_wwrite(const wchar_t *str, size_t size, printf_buffer_t *pb)
+{
+	if (printf_flush(pb) < 0)
+		return -1;
+
+	int ret = pb->ps->wstr_write(str, size, pb->ps->data);
+	if (ret < 0) {
+		pb->error = true;
+		return -1;
+	}
+
+	return ret;
+}
+
+/** Convert a number to digits in a given base.
+ *
+ * Decimal numbers are converted two digits per division, 32-bit
+ * arithmetic is used as soon as the rest of the number fits. Bases that
+ * are powers of two need no division at all.
+ *
+ * @param num    Number to convert.
+ * @param base   Base to convert the number to (between 2 and 16).
+ * @param digits Digits of the base.
+ * @param end    End of the output buffer.
+ *
+ * @return Pointer to the first digit, the last one is stored right
+ *         before @a end.
+ *
+ */
+static char *number_to_str(uint64_t num, unsigned int base,
+    const char *digits, char *end)
+{
+	char *ptr = end;
+
+	if (base == 10) {
+		while (num > UINT32_MAX) {
+			unsigned int rem = num % 100;
+			num /= 100;
+			ptr -= 2;
+			ptr[0] = digit_pairs[2 * rem];
+			ptr[1] = digit_pairs[2 * rem + 1];
+		}
+
+		uint32_t n = (uint32_t) num;
+		while (n >= 100) {
+			unsigned int rem = n % 100;
+			n /= 100;
+			ptr -= 2;
+			ptr[0] = digit_pairs[2 * rem];
+			ptr[1] = digit_pairs[2 * rem + 1];
+		}
+
+		if (n >= 10) {
+			ptr -= 2;
+			ptr[0] = digit_pairs[2 * n];
+			ptr[1] = digit_pairs[2 * n + 1];
+		} else {
+			*--ptr = '0' + n;
+		}
+
+		return ptr;
+	}
+
+	unsigned int shift;
+	switch (base) {
+	case 2:
+		shift = 1;
+		break;
+	case 8:
+		shift = 3;
+		break;
+	case 16:
+		shift = 4;
+		break;
+	default:
+		do {
+			*--ptr = digits[num % base];
+		} while (num /= base);
+
+		return ptr;
+	}
+
+	do {
+		*--ptr = digits[num & (base - 1)];
+		num >>= shift;
+	} while (num != 0);
+
+	return ptr;
+}
+
 /** Prints count times character ch. */
-static int print_padding(char ch, int count, printf_spec_t *ps)
+static int print_padding(char ch, int count, printf_buffer_t *pb)
 {
 	for (int i = 0; i < count; ++i) {
-		if (ps->str_write(&ch, 1, ps->data) < 0) {
+		if (printf_write(&ch, 1, pb) < 0) {
 			return -1;
 		}
 	}
@@ -165,15 +366,15 @@ static int print_padding(char ch, int count, printf_spec_t *ps)
  * @param buf  Buffer holding characters with size of
  *             at least size bytes. NULL is not allowed!
  * @param size Size of the buffer in bytes.
- * @param ps   Output method and its data.
+ * @param pb   Output buffer.
  *
  * @return Number of characters printed.
  *
  */
 static int printf_putnchars(const char *buf, size_t size,
-    printf_spec_t *ps)
+    printf_buffer_t *pb)
 {
-	return ps->str_write((void *) buf, size, ps->data);
+	return printf_write(buf, size, pb);
 }
 
 /** Print one or more wide characters without adding newline.
@@ -181,63 +382,71 @@ static int printf_putnchars(const char *buf, size_t size,
  * @param buf  Buffer holding wide characters with size of
  *             at least size bytes. NULL is not allowed!
  * @param size Size of the buffer in bytes.
- * @param ps   Output method and its data.
+ * @param pb   Output buffer.
  *
  * @return Number of wide characters printed.
  *
  */
 static int printf_wputnchars(const wchar_t *buf, size_t size,
-    printf_spec_t *ps)
+    printf_buffer_t *pb)
 {
-	return ps->wstr_write((void *) buf, size, ps->data);
+	int ret = printf_wwrite(buf, size, pb);
+	if (ret > 0)
+		pb->counter += ret;
+
+	return ret;
 }
 
 /** Print string without adding a newline.
  *
  * @param str String to print.
- * @param ps  Write function specification and support data.
+ * @param pb  Output buffer.
  *
  * @return Number of characters printed.
  *
  */
-static int printf_putstr(const char *str, printf_spec_t *ps)
+static int printf_putstr(const char *str, printf_buffer_t *pb)
 {
 	if (str == NULL)
-		return printf_putnchars(nullstr, str_size(nullstr), ps);
+		return printf_putnchars(nullstr, str_size(nullstr), pb);
 
-	return ps->str_write((void *) str, str_size(str), ps->data);
+	return printf_write(str, str_size(str), pb);
 }
 
 /** Print one ASCII character.
  *
  * @param c  ASCII character to be printed.
- * @param ps Output method.
+ * @param pb Output buffer.
  *
  * @return Number of characters printed.
  *
  */
-static int printf_putchar(const char ch, printf_spec_t *ps)
+static int printf_putchar(const char ch, printf_buffer_t *pb)
 {
 	if (!ascii_check(ch))
-		return ps->str_write((void *) &invalch, 1, ps->data);
+		return printf_write(&invalch, 1, pb);
 
-	return ps->str_write(&ch, 1, ps->data);
+	return printf_write(&ch, 1, pb);
 }
 
 /** Print one wide character.
  *
  * @param c  Wide character to be printed.
- * @param ps Output method.
+ * @param pb Output buffer.
  *
  * @return Number of characters printed.
  *
  */
-static int printf_putwchar(const wchar_t ch, printf_spec_t *ps)
+static int printf_putwchar(const wchar_t ch, printf_buffer_t *pb)
 {
 	if (!chr_check(ch))
-		return ps->str_write((void *) &invalch, 1, ps->data);
+		return printf_write(&invalch, 1, pb);
+
+	int ret = printf_wwrite(&ch, sizeof(wchar_t), pb);
+	if (ret > 0)
+		pb->counter++;
 
-	return ps->wstr_write(&ch, sizeof(wchar_t), ps->data);
+	return ret;
 }
 
 /** Print one formatted ASCII character.
@@ -249,7 +458,7 @@ static int printf_putwchar(const wchar_t ch, printf_spec_t *ps)
  * @return Number of characters printed, negative value on failure.
  *
  */
-static int print_char(const char ch, int width, uint32_t flags, printf_spec_t *ps)
+static int print_char(const char ch, int width, uint32_t flags, printf_buffer_t *pb)
 {
 	size_t counter = 0;
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
@@ -258,12 +467,12 @@ static int print_char(const char ch, int width, uint32_t flags, printf_spec_t *p
 			 * One space is consumed by the character itself, hence
 			 * the predecrement.
 			 */
-			if (printf_putchar(' ', ps) > 0)
+			if (printf_putchar(' ', pb) > 0)
 				counter++;
 		}
 	}
 
-	if (printf_putchar(ch, ps) > 0)
+	if (printf_putchar(ch, pb) > 0)
 		counter++;
 
 	while (--width > 0) {
@@ -271,7 +480,7 @@ static int print_char(const char ch, int width, uint32_t flags, printf_spec_t *p
 		 * One space is consumed by the character itself, hence
 		 * the predecrement.
 		 */
-		if (printf_putchar(' ', ps) > 0)
+		if (printf_putchar(' ', pb) > 0)
 			counter++;
 	}
 
@@ -287,7 +496,7 @@ static int print_char(const char ch, int width, uint32_t flags, printf_spec_t *p
  * @return Number of characters printed, negative value on failure.
  *
  */
-static int print_wchar(const wchar_t ch, int width, uint32_t flags, printf_spec_t *ps)
+static int print_wchar(const wchar_t ch, int width, uint32_t flags, printf_buffer_t *pb)
 {
 	size_t counter = 0;
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
@@ -296,12 +505,12 @@ static int print_wchar(const wchar_t ch, int width, uint32_t flags, printf_spec_
 			 * One space is consumed by the character itself, hence
 			 * the predecrement.
 			 */
-			if (printf_putchar(' ', ps) > 0)
+			if (printf_putchar(' ', pb) > 0)
 				counter++;
 		}
 	}
 
-	if (printf_putwchar(ch, ps) > 0)
+	if (printf_putwchar(ch, pb) > 0)
 		counter++;
 
 	while (--width > 0) {
@@ -309,7 +518,7 @@ static int print_wchar(const wchar_t ch, int width, uint32_t flags, printf_spec_
 		 * One space is consumed by the character itself, hence
 		 * the predecrement.
 		 */
-		if (printf_putchar(' ', ps) > 0)
+		if (printf_putchar(' ', pb) > 0)
 			counter++;
 	}
 
@@ -326,10 +535,10 @@ static int print_wchar(const wchar_t ch, int width, uint32_t flags, printf_spec_
  * @return Number of characters printed, negative value on failure.
  */
 static int print_str(char *str, int width, unsigned int precision,
-    uint32_t flags, printf_spec_t *ps)
+    uint32_t flags, printf_buffer_t *pb)
 {
 	if (str == NULL)
-		return printf_putstr(nullstr, ps);
+		return printf_putstr(nullstr, pb);
 
 	size_t strw = str_length(str);
 
@@ -342,7 +551,7 @@ static int print_str(char *str, int width, unsigned int precision,
 	width -= precision;
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
 		while (width-- > 0) {
-			if (printf_putchar(' ', ps) == 1)
+			if (printf_putchar(' ', pb) == 1)
 				counter++;
 		}
 	}
@@ -350,14 +559,14 @@ static int print_str(char *str, int width, unsigned int precision,
 	/* Part of @a str fitting into the alloted space. */
 	int retval;
 	size_t size = str_lsize(str, precision);
-	if ((retval = printf_putnchars(str, size, ps)) < 0)
+	if ((retval = printf_putnchars(str, size, pb)) < 0)
 		return -counter;
 
 	counter += retval;
 
 	/* Right padding */
 	while (width-- > 0) {
-		if (printf_putchar(' ', ps) == 1)
+		if (printf_putchar(' ', pb) == 1)
 			counter++;
 	}
 
@@ -375,10 +584,10 @@ static int print_str(char *str, int width, unsigned int precision,
  * @return Number of wide characters printed, negative value on failure.
  */
 static int print_wstr(wchar_t *str, int width, unsigned int precision,
-    uint32_t flags, printf_spec_t *ps)
+    uint32_t flags, printf_buffer_t *pb)
 {
 	if (str == NULL)
-		return printf_putstr(nullstr, ps);
+		return printf_putstr(nullstr, pb);
 
 	size_t strw = wstr_length(str);
 
@@ -391,7 +600,7 @@ static int print_wstr(wchar_t *str, int width, unsigned int precision,
 	width -= precision;
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
 		while (width-- > 0) {
-			if (printf_putchar(' ', ps) == 1)
+			if (printf_putchar(' ', pb) == 1)
 				counter++;
 		}
 	}
@@ -399,14 +608,14 @@ static int print_wstr(wchar_t *str, int width, unsigned int precision,
 	/* Part of @a wstr fitting into the alloted space. */
 	int retval;
 	size_t size = wstr_lsize(str, precision);
-	if ((retval = printf_wputnchars(str, size, ps)) < 0)
+	if ((retval = printf_wputnchars(str, size, pb)) < 0)
 		return -counter;
 
 	counter += retval;
 
 	/* Right padding */
 	while (width-- > 0) {
-		if (printf_putchar(' ', ps) == 1)
+		if (printf_putchar(' ', pb) == 1)
 			counter++;
 	}
 
@@ -427,7 +636,7 @@ static int print_wstr(wchar_t *str, int width, unsigned int precision,
  *
  */
 static int print_number(uint64_t num, int width, int precision, int base,
-    uint32_t flags, printf_spec_t *ps)
+    uint32_t flags, printf_buffer_t *pb)
 {
 	/* Precision not specified. */
 	if (precision < 0) {
@@ -441,23 +650,11 @@ static int print_number(uint64_t num, int width, int precision, int base,
 		digits = digits_small;
 
 	char data[PRINT_NUMBER_BUFFER_SIZE];
-	char *ptr = &data[PRINT_NUMBER_BUFFER_SIZE - 1];
+	char *end = &data[PRINT_NUMBER_BUFFER_SIZE];
+	char *ptr = number_to_str(num, base, digits, end);
 
 	/* Size of number with all prefixes and signs */
-	int size = 0;
-
-	/* Put zero at end of string */
-	*ptr-- = 0;
-
-	if (num == 0) {
-		*ptr-- = '0';
-		size++;
-	} else {
-		do {
-			*ptr-- = digits[num % base];
-			size++;
-		} while (num /= base);
-	}
+	int size = end - ptr;
 
 	/* Size of plain number */
 	int number_size = size;
@@ -518,14 +715,14 @@ static int print_number(uint64_t num, int width, int precision, int base,
 
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
 		while (width-- > 0) {
-			if (printf_putchar(' ', ps) == 1)
+			if (printf_putchar(' ', pb) == 1)
 				counter++;
 		}
 	}
 
 	/* Print sign */
 	if (sgn) {
-		if (printf_putchar(sgn, ps) == 1)
+		if (printf_putchar(sgn, pb) == 1)
 			counter++;
 	}
 
@@ -534,28 +731,28 @@ static int print_number(uint64_t num, int width, int precision, int base,
 		switch (base) {
 		case 2:
 			/* Binary formating is not standard, but usefull */
-			if (printf_putchar('0', ps) == 1)
+			if (printf_putchar('0', pb) == 1)
 				counter++;
 			if (flags & __PRINTF_FLAG_BIGCHARS) {
-				if (printf_putchar('B', ps) == 1)
+				if (printf_putchar('B', pb) == 1)
 					counter++;
 			} else {
-				if (printf_putchar('b', ps) == 1)
+				if (printf_putchar('b', pb) == 1)
 					counter++;
 			}
 			break;
 		case 8:
-			if (printf_putchar('o', ps) == 1)
+			if (printf_putchar('o', pb) == 1)
 				counter++;
 			break;
 		case 16:
-			if (printf_putchar('0', ps) == 1)
+			if (printf_putchar('0', pb) == 1)
 				counter++;
 			if (flags & __PRINTF_FLAG_BIGCHARS) {
-				if (printf_putchar('X', ps) == 1)
+				if (printf_putchar('X', pb) == 1)
 					counter++;
 			} else {
-				if (printf_putchar('x', ps) == 1)
+				if (printf_putchar('x', pb) == 1)
 					counter++;
 			}
 			break;
@@ -565,28 +762,55 @@ static int print_number(uint64_t num, int width, int precision, int base,
 	/* Print leading zeroes */
 	precision -= number_size;
 	while (precision-- > 0) {
-		if (printf_putchar('0', ps) == 1)
+		if (printf_putchar('0', pb) == 1)
 			counter++;
 	}
 
 	/* Print the number itself */
 	int retval;
-	if ((retval = printf_putstr(++ptr, ps)) > 0)
+	if ((retval = printf_putnchars(ptr, number_size, pb)) > 0)
 		counter += retval;
 
 	/* Print trailing spaces */
 
 	while (width-- > 0) {
-		if (printf_putchar(' ', ps) == 1)
+		if (printf_putchar(' ', pb) == 1)
 			counter++;
 	}
 
 	return ((int) counter);
 }
 
+/** Print a signed decimal number without any modifiers.
+ *
+ * This is what print_number() prints for a plain %d, minus the handling
+ * of flags, width and precision.
+ *
+ * @param num Number to print.
+ * @param pb  Output buffer.
+ *
+ * @return Number of characters printed, negative value on failure.
+ *
+ */
+static int print_decimal(int num, printf_buffer_t *pb)
+{
+	char data[PRINT_NUMBER_BUFFER_SIZE];
+	char *end = &data[PRINT_NUMBER_BUFFER_SIZE];
+	char *ptr;
+
+	if (num < 0) {
+		ptr = number_to_str(-(unsigned int) num, 10, digits_small, end);
+		*--ptr = '-';
+	} else {
+		ptr = number_to_str(num, 10, digits_small, end);
+	}
+
+	return printf_write(ptr, end - ptr, pb);
+}
+
 /** Prints a special double (ie NaN, infinity) padded to width characters. */
 static int print_special(ieee_double_t val, int width, uint32_t flags,
-    printf_spec_t *ps)
+    printf_buffer_t *pb)
 {
 	assert(val.is_special);
 
@@ -608,27 +832,27 @@ static int print_special(ieee_double_t val, int width, uint32_t flags,
 
 	/* Leading padding. */
 	if (!(flags & __PRINTF_FLAG_LEFTALIGNED)) {
-		if ((ret = print_padding(' ', padding_len, ps)) < 0)
+		if ((ret = print_padding(' ', padding_len, pb)) < 0)
 			return -1;
 
 		counter += ret;
 	}
 
 	if (sign) {
-		if ((ret = ps->str_write(&sign, 1, ps->data)) < 0)
+		if ((ret = printf_write(&sign, 1, pb)) < 0)
 			return -1;
 
 		counter += ret;
 	}
 
-	if ((ret = ps->str_write(str, str_len, ps->data)) < 0)
+	if ((ret = printf_write(str, str_len, pb)) < 0)
 		return -1;
 
 	counter += ret;
 
 	/* Trailing padding. */
 	if (flags & __PRINTF_FLAG_LEFTALIGNED) {
-		if ((ret = print_padding(' ', padding_len, ps)) < 0)
+		if ((ret = print_padding(' ', padding_len, pb)) < 0)
 			return -1;
 
 		counter += ret;
@@ -693,7 +917,7 @@ static void fp_round_up(char *buf, int *len, int *dec_exp)
  *  to the %f specifier.
  */
 static int print_double_str_fixed(double_str_t *val_str, int precision, int width,
-    uint32_t flags, printf_spec_t *ps)
+    uint32_t flags, printf_buffer_t *pb)
 {
 	int len = val_str->len;
 	char *buf = val_str->str;
@@ -733,21 +957,21 @@ static int print_double_str_fixed(double_str_t *val_str, int precision, int widt
 	/* Leading padding and sign. */
 
 	if (!(flags & (__PRINTF_FLAG_LEFTALIGNED | __PRINTF_FLAG_ZEROPADDED))) {
-		if ((ret = print_padding(' ', padding_len, ps)) < 0)
+		if ((ret = print_padding(' ', padding_len, pb)) < 0)
 			return -1;
 
 		counter += ret;
 	}
 
 	if (sign) {
-		if ((ret = ps->str_write(&sign, 1, ps->data)) < 0)
+		if ((ret = printf_write(&sign, 1, pb)) < 0)
 			return -1;
 
 		counter += ret;
 	}
 
 	if (flags & __PRINTF_FLAG_ZEROPADDED) {
-		if ((ret = print_padding('0', padding_len, ps)) < 0)
+		if ((ret = print_padding('0', padding_len, pb)) < 0)
 			return -1;
 
 		counter += ret;
@@ -758,18 +982,18 @@ static int print_double_str_fixed(double_str_t *val_str, int precision, int widt
 	int buf_int_len = min(len, len + dec_exp);
 
 	if (0 < buf_int_len) {
-		if ((ret = ps->str_write(buf, buf_int_len, ps->data)) < 0)
+		if ((ret = printf_write(buf, buf_int_len, pb)) < 0)
 			return -1;
 
 		counter += ret;
 
 		/* Print trailing zeros of the integral part of the number. */
-		if ((ret = print_padding('0', int_len - buf_int_len, ps)) < 0)
+		if ((ret = print_padding('0', int_len - buf_int_len, pb)) < 0)
 			return -1;
 	} else {
 		/* Single leading integer 0. */
 		char ch = '0';
-		if ((ret = ps->str_write(&ch, 1, ps->data)) < 0)
+		if ((ret = printf_write(&ch, 1, pb)) < 0)
 			return -1;
 	}
 
@@ -779,27 +1003,27 @@ static int print_double_str_fixed(double_str_t *val_str, int precision, int widt
 	if (has_decimal_pt) {
 		char ch = '.';
 
-		if ((ret = ps->str_write(&ch, 1, ps->data)) < 0)
+		if ((ret = printf_write(&ch, 1, pb)) < 0)
 			return -1;
 
 		counter += ret;
 
 		/* Print leading zeros of the fractional part of the number. */
-		if ((ret = print_padding('0', leading_frac_zeros, ps)) < 0)
+		if ((ret = print_padding('0', leading_frac_zeros, pb)) < 0)
 			return -1;
 
 		counter += ret;
 
 		/* Print significant digits of the fractional part of the number. */
 		if (0 < signif_frac_figs) {
-			if ((ret = ps->str_write(buf_frac, signif_frac_figs, ps->data)) < 0)
+			if ((ret = printf_write(buf_frac, signif_frac_figs, pb)) < 0)
 				return -1;
 
 			counter += ret;
 		}
 
 		/* Print trailing zeros of the fractional part of the number. */
-		if ((ret = print_padding('0', trailing_frac_zeros, ps)) < 0)
+		if ((ret = print_padding('0', trailing_frac_zeros, pb)) < 0)
 			return -1;
 
 		counter += ret;
@@ -807,7 +1031,7 @@ static int print_double_str_fixed(double_str_t *val_str, int precision, int widt
 
 	/* Trailing padding. */
 	if (flags & __PRINTF_FLAG_LEFTALIGNED) {
-		if ((ret = print_padding(' ', padding_len, ps)) < 0)
+		if ((ret = print_padding(' ', padding_len, pb)) < 0)
 			return -1;
 
 		counter += ret;
@@ -825,12 +1049,12 @@ static int print_double_str_fixed(double_str_t *val_str, int precision, int widt
  * @param width Minimum number of characters to display. Pads
  *              with '0' or ' ' depending on the set flags;
  * @param flags Printf flags.
- * @param ps    Printing functions.
+ * @param pb    Output buffer.
  *
  * @return The number of characters printed; negative on failure.
  */
 static int print_double_fixed(double g, int precision, int width, uint32_t flags,
-    printf_spec_t *ps)
+    printf_buffer_t *pb)
 {
 	if (flags & __PRINTF_FLAG_LEFTALIGNED) {
 		flags &= ~__PRINTF_FLAG_ZEROPADDED;
@@ -843,7 +1067,7 @@ static int print_double_fixed(double g, int precision, int width, uint32_t flags
 	ieee_double_t val = extract_ieee_double(g);
 
 	if (val.is_special) {
-		return print_special(val, width, flags, ps);
+		return print_special(val, width, flags, pb);
 	}
 
 	char buf[MAX_DOUBLE_STR_BUF_SIZE];
@@ -880,25 +1104,25 @@ static int print_double_fixed(double g, int precision, int width, uint32_t flags
 		precision = max(0, -val_str.dec_exp);
 	}
 
-	return print_double_str_fixed(&val_str, precision, width, flags, ps);
+	return print_double_str_fixed(&val_str, precision, width, flags, pb);
 }
 
 /** Prints the decimal exponent part of a %e specifier formatted number. */
-static int print_exponent(int exp_val, uint32_t flags, printf_spec_t *ps)
+static int print_exponent(int exp_val, uint32_t flags, printf_buffer_t *pb)
 {
 	int counter = 0;
 	int ret;
 
 	char exp_ch = (flags & __PRINTF_FLAG_BIGCHARS) ? 'E' : 'e';
 
-	if ((ret = ps->str_write(&exp_ch, 1, ps->data)) < 0)
+	if ((ret = printf_write(&exp_ch, 1, pb)) < 0)
 		return -1;
 
 	counter += ret;
 
 	char exp_sign = (exp_val < 0) ? '-' : '+';
 
-	if ((ret = ps->str_write(&exp_sign, 1, ps->data)) < 0)
+	if ((ret = printf_write(&exp_sign, 1, pb)) < 0)
 		return -1;
 
 	counter += ret;
@@ -915,7 +1139,7 @@ static int print_exponent(int exp_val, uint32_t flags, printf_spec_t *ps)
 	int exp_len = (exp_str[0] == '0') ? 2 : 3;
 	const char *exp_str_start = &exp_str[3] - exp_len;
 
-	if ((ret = ps->str_write(exp_str_start, exp_len, ps->data)) < 0)
+	if ((ret = printf_write(exp_str_start, exp_len, pb)) < 0)
 		return -1;
 
 	counter += ret;
@@ -927,7 +1151,7 @@ static int print_exponent(int exp_val, uint32_t flags, printf_spec_t *ps)
  *  to the %e specifier.
  */
 static int print_double_str_scient(double_str_t *val_str, int precision,
-    int width, uint32_t flags, printf_spec_t *ps)
+    int width, uint32_t flags, printf_buffer_t *pb)
 {
 	int len = val_str->len;
 	int dec_exp = val_str->dec_exp;
@@ -961,28 +1185,28 @@ static int print_double_str_scient(double_str_t *val_str, int precision,
 	int counter = 0;
 
 	if (!(flags & (__PRINTF_FLAG_LEFTALIGNED | __PRINTF_FLAG_ZEROPADDED))) {
-		if ((ret = print_padding(' ', padding_len, ps)) < 0)
+		if ((ret = print_padding(' ', padding_len, pb)) < 0)
 			return -1;
 
 		counter += ret;
 	}
 
 	if (sign) {
-		if ((ret = ps->str_write(&sign, 1, ps->data)) < 0)
+		if ((ret = printf_write(&sign, 1, pb)) < 0)
 			return -1;
 
 		counter += ret;
 	}
 
 	if (flags & __PRINTF_FLAG_ZEROPADDED) {
-		if ((ret = print_padding('0', padding_len, ps)) < 0)
+		if ((ret = print_padding('0', padding_len, pb)) < 0)
 			return -1;
 
 		counter += ret;
 	}
 
 	/* Single leading integer. */
-	if ((ret = ps->str_write(buf, 1, ps->data)) < 0)
+	if ((ret = printf_write(buf, 1, pb)) < 0)
 		return -1;
 
 	counter += ret;
@@ -991,34 +1215,34 @@ static int print_double_str_scient(double_str_t *val_str, int precision,
 	if (has_decimal_pt) {
 		char ch = '.';
 
-		if ((ret = ps->str_write(&ch, 1, ps->data)) < 0)
+		if ((ret = printf_write(&ch, 1, pb)) < 0)
 			return -1;
 
 		counter += ret;
 
 		/* Print significant digits of the fractional part of the number. */
 		if (0 < signif_frac_figs) {
-			if ((ret = ps->str_write(buf + 1, signif_frac_figs, ps->data)) < 0)
+			if ((ret = printf_write(buf + 1, signif_frac_figs, pb)) < 0)
 				return -1;
 
 			counter += ret;
 		}
 
 		/* Print trailing zeros of the fractional part of the number. */
-		if ((ret = print_padding('0', trailing_frac_zeros, ps)) < 0)
+		if ((ret = print_padding('0', trailing_frac_zeros, pb)) < 0)
 			return -1;
 
 		counter += ret;
 	}
 
 	/* Print the exponent. */
-	if ((ret = print_exponent(exp_val, flags, ps)) < 0)
+	if ((ret = print_exponent(exp_val, flags, pb)) < 0)
 		return -1;
 
 	counter += ret;
 
 	if (flags & __PRINTF_FLAG_LEFTALIGNED) {
-		if ((ret = print_padding(' ', padding_len, ps)) < 0)
+		if ((ret = print_padding(' ', padding_len, pb)) < 0)
 			return -1;
 
 		counter += ret;
@@ -1045,12 +1269,12 @@ static int print_double_str_scient(double_str_t *val_str, int precision,
  * @param width Minimum number of characters to display. Pads
  *              with '0' or ' ' depending on the set flags;
  * @param flags Printf flags.
- * @param ps    Printing functions.
+ * @param pb    Output buffer.
  *
  * @return The number of characters printed; negative on failure.
  */
 static int print_double_scientific(double g, int precision, int width,
-    uint32_t flags, printf_spec_t *ps)
+    uint32_t flags, printf_buffer_t *pb)
 {
 	if (flags & __PRINTF_FLAG_LEFTALIGNED) {
 		flags &= ~__PRINTF_FLAG_ZEROPADDED;
@@ -1059,7 +1283,7 @@ static int print_double_scientific(double g, int precision, int width,
 	ieee_double_t val = extract_ieee_double(g);
 
 	if (val.is_special) {
-		return print_special(val, width, flags, ps);
+		return print_special(val, width, flags, pb);
 	}
 
 	char buf[MAX_DOUBLE_STR_BUF_SIZE];
@@ -1097,7 +1321,7 @@ static int print_double_scientific(double g, int precision, int width,
 		precision = val_str.len - 1;
 	}
 
-	return print_double_str_scient(&val_str, precision, width, flags, ps);
+	return print_double_str_scient(&val_str, precision, width, flags, pb);
 }
 
 /** Convert, format and print a double according to the %g specifier.
@@ -1111,17 +1335,17 @@ static int print_double_scientific(double g, int precision, int width,
  * @param width Minimum number of characters to display. Pads
  *              with '0' or ' ' depending on the set flags;
  * @param flags Printf flags.
- * @param ps    Printing functions.
+ * @param pb    Output buffer.
  *
  * @return The number of characters printed; negative on failure.
  */
 static int print_double_generic(double g, int precision, int width,
-    uint32_t flags, printf_spec_t *ps)
+    uint32_t flags, printf_buffer_t *pb)
 {
 	ieee_double_t val = extract_ieee_double(g);
 
 	if (val.is_special) {
-		return print_special(val, width, flags, ps);
+		return print_special(val, width, flags, pb);
 	}
 
 	char buf[MAX_DOUBLE_STR_BUF_SIZE];
@@ -1143,11 +1367,11 @@ static int print_double_generic(double g, int precision, int width,
 		if (-4 <= dec_exp && dec_exp < precision) {
 			precision = precision - (dec_exp + 1);
 			return print_double_fixed(g, precision, width,
-			    flags | __PRINTF_FLAG_NOFRACZEROS, ps);
+			    flags | __PRINTF_FLAG_NOFRACZEROS, pb);
 		} else {
 			--precision;
 			return print_double_scientific(g, precision, width,
-			    flags | __PRINTF_FLAG_NOFRACZEROS, ps);
+			    flags | __PRINTF_FLAG_NOFRACZEROS, pb);
 		}
 	} else {
 		/* Convert to get the decimal exponent and digit count.*/
@@ -1171,11 +1395,11 @@ static int print_double_generic(double g, int precision, int width,
 		if (len <= 15 && -6 <= last_digit_pos && first_digit_pos <= 15) {
 			/* Precision needed for the last significant digit. */
 			precision = max(0, -val_str.dec_exp);
-			return print_double_str_fixed(&val_str, precision, width, flags, ps);
+			return print_double_str_fixed(&val_str, precision, width, flags, pb);
 		} else {
 			/* Use all produced digits. */
 			precision = val_str.len - 1;
-			return print_double_str_scient(&val_str, precision, width, flags, ps);
+			return print_double_str_scient(&val_str, precision, width, flags, pb);
 		}
 	}
 }
@@ -1195,12 +1419,12 @@ static int print_double_generic(double g, int precision, int width,
  * @param width Minimum number of characters to display. Pads
  *              with '0' or ' ' depending on the set flags;
  * @param flags Printf flags.
- * @param ps    Printing functions.
+ * @param pb    Output buffer.
  *
  * @return The number of characters printed; negative on failure.
  */
 static int print_double(double g, char spec, int precision, int width,
-    uint32_t flags, printf_spec_t *ps)
+    uint32_t flags, printf_buffer_t *pb)
 {
 	switch (spec) {
 	case 'F':
@@ -1208,20 +1432,20 @@ static int print_double(double g, char spec, int precision, int width,
 		/* Fallthrough */
 	case 'f':
 		precision = (precision < 0) ? 6 : precision;
-		return print_double_fixed(g, precision, width, flags, ps);
+		return print_double_fixed(g, precision, width, flags, pb);
 
 	case 'E':
 		flags |= __PRINTF_FLAG_BIGCHARS;
 		/* Fallthrough */
 	case 'e':
 		precision = (precision < 0) ? 6 : precision;
-		return print_double_scientific(g, precision, width, flags, ps);
+		return print_double_scientific(g, precision, width, flags, pb);
 
 	case 'G':
 		flags |= __PRINTF_FLAG_BIGCHARS;
 		/* Fallthrough */
 	case 'g':
-		return print_double_generic(g, precision, width, flags, ps);
+		return print_double_generic(g, precision, width, flags, pb);
 
 	default:
 		assert(false);
@@ -1324,10 +1548,24 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 	size_t nxt = 0;  /* Index of the next character from fmt */
 	size_t j = 0;    /* Index to the first not printed nonformating character */
 
-	size_t counter = 0;   /* Number of characters printed */
 	int retval;           /* Return values from nested functions */
+	bool failed = false;
+
+	printf_buffer_t buffer = {
+		.ps = ps,
+		.counter = 0,
+		.len = 0,
+		.error = false
+	};
 
 	while (true) {
+		/*
+		 * Skip ordinary characters. Both '%' and the terminating zero
+		 * are ASCII, so they never appear inside a multibyte sequence.
+		 */
+		while ((fmt[nxt] != '%') && (fmt[nxt] != 0))
+			nxt++;
+
 		i = nxt;
 		wchar_t uc = str_decode(fmt, &nxt, STR_NO_LIMIT);
 
@@ -1338,16 +1576,36 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 		if (uc == '%') {
 			/* Print common characters if any processed */
 			if (i > j) {
-				if ((retval = printf_putnchars(&fmt[j], i - j, ps)) < 0) {
+				if (printf_putnchars(&fmt[j], i - j, &buffer) < 0) {
 					/* Error */
-					counter = -counter;
+					failed = true;
 					goto out;
 				}
-				counter += retval;
 			}
 
 			j = i;
 
+			/* Fast path for plain %s and %d */
+			if (fmt[nxt] == 's') {
+				if (printf_putstr(va_arg(ap, char *), &buffer) < 0) {
+					failed = true;
+					goto out;
+				}
+
+				j = ++nxt;
+				continue;
+			}
+
+			if (fmt[nxt] == 'd') {
+				if (print_decimal(va_arg(ap, int), &buffer) < 0) {
+					failed = true;
+					goto out;
+				}
+
+				j = ++nxt;
+				continue;
+			}
+
 			/* Parse modifiers */
 			uint32_t flags = 0;
 			bool end = false;
@@ -1492,30 +1750,26 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				precision = max(0,  precision);
 
 				if (qualifier == PrintfQualifierLong)
-					retval = print_wstr(va_arg(ap, wchar_t *), width, precision, flags, ps);
+					retval = print_wstr(va_arg(ap, wchar_t *), width, precision, flags, &buffer);
 				else
-					retval = print_str(va_arg(ap, char *), width, precision, flags, ps);
+					retval = print_str(va_arg(ap, char *), width, precision, flags, &buffer);
 
 				if (retval < 0) {
-					counter = -counter;
+					failed = true;
 					goto out;
 				}
-
-				counter += retval;
 				j = nxt;
 				continue;
 			case 'c':
 				if (qualifier == PrintfQualifierLong)
-					retval = print_wchar(va_arg(ap, wint_t), width, flags, ps);
+					retval = print_wchar(va_arg(ap, wint_t), width, flags, &buffer);
 				else
-					retval = print_char(va_arg(ap, unsigned int), width, flags, ps);
+					retval = print_char(va_arg(ap, unsigned int), width, flags, &buffer);
 
 				if (retval < 0) {
-					counter = -counter;
+					failed = true;
 					goto out;
 				}
-
-				counter += retval;
 				j = nxt;
 				continue;
 
@@ -1529,14 +1783,12 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 			case 'E':
 			case 'e':
 				retval = print_double(va_arg(ap, double), uc, precision,
-				    width, flags, ps);
+				    width, flags, &buffer);
 
 				if (retval < 0) {
-					counter = -counter;
+					failed = true;
 					goto out;
 				}
-
-				counter += retval;
 				j = nxt;
 				continue;
 
@@ -1628,32 +1880,35 @@ int printf_core(const char *fmt, printf_spec_t *ps, va_list ap)
 				break;
 			default:
 				/* Unknown qualifier */
-				counter = -counter;
+				failed = true;
 				goto out;
 			}
 
 			if ((retval = print_number(number, width, precision,
-			    base, flags, ps)) < 0) {
-				counter = -counter;
+			    base, flags, &buffer)) < 0) {
+				failed = true;
 				goto out;
 			}
-
-			counter += retval;
 			j = nxt;
 		}
 	}
 
 	if (i > j) {
-		if ((retval = printf_putnchars(&fmt[j], i - j, ps)) < 0) {
+		if (printf_putnchars(&fmt[j], i - j, &buffer) < 0) {
 			/* Error */
-			counter = -counter;
+			failed = true;
 			goto out;
 		}
-		counter += retval;
 	}
 
 out:
-	return ((int) counter);
+	if (printf_flush(&buffer) < 0)
+		failed = true;
+
+	if (failed)
+		return -((int) buffer.counter);
+
+	return ((int) buffer.counter);
 }
 
 /** @}
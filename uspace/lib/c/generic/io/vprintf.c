@@ -35,15 +35,12 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <io/printf_core.h>
-#include <fibril_synch.h>
 #include <async.h>
 #include <str.h>
 
-static FIBRIL_MUTEX_INITIALIZE(printf_mutex);
-
 static int vprintf_str_write(const char *str, size_t size, void *stream)
 {
-	size_t wr = fwrite(str, 1, size, (FILE *) stream);
+	size_t wr = fwrite_unlocked(str, 1, size, (FILE *) stream);
 	return str_nlength(str, wr);
 }
 
@@ -53,7 +50,7 @@ static int vprintf_wstr_write(const wchar_t *str, size_t size, void *stream)
 	size_t chars = 0;
 
 	while (offset < size) {
-		if (fputwc(str[chars], (FILE *) stream) <= 0)
+		if (fputwc_unlocked(str[chars], (FILE *) stream) <= 0)
 			break;
 
 		chars++;
@@ -81,13 +78,14 @@ int vfprintf(FILE *stream, const char *fmt, va_list ap)
 	};
 
 	/*
-	 * Prevent other threads to execute printf_core()
+	 * Keep the output of one call together, other fibrils writing
+	 * to the same stream wait until it is done.
 	 */
-	fibril_mutex_lock(&printf_mutex);
+	flockfile(stream);
 
 	int ret = printf_core(fmt, &ps, ap);
 
-	fibril_mutex_unlock(&printf_mutex);
+	funlockfile(stream);
 
 	return ret;
 }
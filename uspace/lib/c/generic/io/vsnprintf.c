@@ -89,8 +89,14 @@ static int vsnprintf_str_write(const char *str, size_t size, vsnprintf_data_t *d
 		while (index < size) {
 			wchar_t uc = str_decode(str, &index, size);
 
-			if (chr_encode(uc, data->dst, &data->len, data->size - 1) != EOK)
+			if (chr_encode(uc, data->dst, &data->len, data->size - 1) != EOK) {
+				/*
+				 * Do not let shorter characters that follow
+				 * fill the space this one did not fit into.
+				 */
+				data->size = data->len + 1;
 				break;
+			}
 		}
 
 		/*
@@ -152,8 +158,11 @@ static int vsnprintf_wstr_write(const wchar_t *str, size_t size, vsnprintf_data_
 			return ((int) size);
 		}
 
-		if (chr_encode(str[index], data->dst, &data->len, data->size - 1) != EOK)
+		if (chr_encode(str[index], data->dst, &data->len, data->size - 1) != EOK) {
+			/* No more output after a character did not fit */
+			data->size = data->len + 1;
 			break;
+		}
 
 		index++;
 	}
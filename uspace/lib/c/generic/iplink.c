@@ -89,8 +89,9 @@ errno_t iplink_send(iplink_t *iplink, iplink_sdu_t *sdu)
 	async_exch_t *exch = async_exchange_begin(iplink->sess);
 
 	ipc_call_t answer;
-	aid_t req = async_send_2(exch, IPLINK_SEND, (sysarg_t) sdu->src,
-	    (sysarg_t) sdu->dest, &answer);
+	aid_t req = async_send_4(exch, IPLINK_SEND, (sysarg_t) sdu->src,
+	    (sysarg_t) sdu->dest, (sysarg_t) sdu->flags, (sysarg_t) sdu->mss,
+	    &answer);
 
 	errno_t rc = async_data_write_start(exch, sdu->data, sdu->size);
 
@@ -152,6 +153,28 @@ errno_t iplink_get_mtu(iplink_t *iplink, size_t *rmtu)
 	return EOK;
 }
 
+/** Get offload capabilities of IP link.
+ *
+ * @param iplink IP link
+ * @param rcaps  Place to store IPLINK_OFFLOAD_xxx capabilities
+ * @return EOK on success or an error code
+ */
+errno_t iplink_get_offload(iplink_t *iplink, uint32_t *rcaps)
+{
+	async_exch_t *exch = async_exchange_begin(iplink->sess);
+
+	sysarg_t caps;
+	errno_t rc = async_req_0_1(exch, IPLINK_GET_OFFLOAD, &caps);
+
+	async_exchange_end(exch);
+
+	if (rc != EOK)
+		return rc;
+
+	*rcaps = caps;
+	return EOK;
+}
+
 errno_t iplink_get_mac48(iplink_t *iplink, addr48_t *mac)
 {
 	async_exch_t *exch = async_exchange_begin(iplink->sess);
@@ -248,6 +271,7 @@ static void iplink_ev_recv(iplink_t *iplink, ipc_call_t *icall)
 	iplink_recv_sdu_t sdu;
 
 	ip_ver_t ver = ipc_get_arg1(icall);
+	sdu.flags = ipc_get_arg2(icall);
 
 	errno_t rc = async_data_write_accept(&sdu.data, false, 0, 0, 0,
 	    &sdu.size);
@@ -48,6 +48,18 @@ static void iplink_get_mtu_srv(iplink_srv_t *srv, ipc_call_t *call)
 	async_answer_1(call, rc, mtu);
 }
 
+static void iplink_get_offload_srv(iplink_srv_t *srv, ipc_call_t *call)
+{
+	uint32_t caps = 0;
+	errno_t rc = EOK;
+
+	/* Links which do not implement the method do not offload anything */
+	if (srv->ops->get_offload != NULL)
+		rc = srv->ops->get_offload(srv, &caps);
+
+	async_answer_1(call, rc, caps);
+}
+
 static void iplink_get_mac48_srv(iplink_srv_t *srv, ipc_call_t *icall)
 {
 	addr48_t mac;
@@ -163,6 +175,8 @@ static void iplink_send_srv(iplink_srv_t *srv, ipc_call_t *icall)
 
 	sdu.src = ipc_get_arg1(icall);
 	sdu.dest = ipc_get_arg2(icall);
+	sdu.flags = ipc_get_arg3(icall);
+	sdu.mss = ipc_get_arg4(icall);
 
 	errno_t rc = async_data_write_accept(&sdu.data, false, 0, 0, 0,
 	    &sdu.size);
@@ -285,6 +299,9 @@ errno_t iplink_conn(ipc_call_t *icall, void *arg)
 		case IPLINK_ADDR_REMOVE:
 			iplink_addr_remove_srv(srv, &call);
 			break;
+		case IPLINK_GET_OFFLOAD:
+			iplink_get_offload_srv(srv, &call);
+			break;
 		default:
 			async_answer_0(&call, EINVAL);
 		}
@@ -302,8 +319,8 @@ errno_t iplink_ev_recv(iplink_srv_t *srv, iplink_recv_sdu_t *sdu, ip_ver_t ver)
 	async_exch_t *exch = async_exchange_begin(srv->client_sess);
 
 	ipc_call_t answer;
-	aid_t req = async_send_1(exch, IPLINK_EV_RECV, (sysarg_t)ver,
-	    &answer);
+	aid_t req = async_send_2(exch, IPLINK_EV_RECV, (sysarg_t)ver,
+	    (sysarg_t) sdu->flags, &answer);
 
 	errno_t rc = async_data_write_start(exch, sdu->data, sdu->size);
 	async_exchange_end(exch);
@@ -37,192 +37,251 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <libarch/mem.h>
 #include "private/cc.h"
+#include "private/mem.h"
 
-/** Fill memory block with a constant value. */
-ATTRIBUTE_OPTIMIZE_NO_TLDP
-    void *memset(void *dest, int b, size_t n)
-{
-	char *pb;
-	unsigned long *pw;
-	size_t word_size;
-	size_t n_words;
+/*
+ * The block operations are dispatched by size class. Blocks of up to
+ * SMALL_SIZE bytes are handled by a pair of possibly overlapping loads
+ * and stores, medium blocks by a loop over aligned destination chunks
+ * and blocks of at least mem_large bytes by the architecture's string
+ * instructions, if it has any worth using on the current processor.
+ */
 
-	unsigned long pattern;
-	size_t i;
-	size_t fill;
+#define SMALL_SIZE  16
 
-	/* Fill initial segment. */
-	word_size = sizeof(unsigned long);
-	fill = word_size - ((uintptr_t) dest & (word_size - 1));
-	if (fill > n)
-		fill = n;
+#if defined(__SSE2__) || defined(__ARM_NEON)
 
-	pb = dest;
+/* The chunks are SSE2 or NEON registers. */
+typedef uint8_t chunk_t __attribute__((vector_size(16)));
 
-	i = fill;
-	while (i-- != 0)
-		*pb++ = b;
+#define CHUNK_SPLAT(b)  ((chunk_t) { 0 } + (uint8_t) (b))
 
-	/* Compute remaining size. */
-	n -= fill;
-	if (n == 0)
-		return dest;
+#else
+
+typedef unsigned long chunk_t;
 
-	n_words = n / word_size;
-	n = n % word_size;
-	pw = (unsigned long *) pb;
+#define CHUNK_SPLAT(b)  ((chunk_t) ((uint8_t) (b) * UINT64_C(0x0101010101010101)))
 
-	/* Create word-sized pattern for aligned segment. */
-	pattern = 0;
-	i = word_size;
-	while (i-- != 0)
-		pattern = (pattern << 8) | (uint8_t) b;
+#endif
 
-	/* Fill aligned segment. */
-	i = n_words;
-	while (i-- != 0)
-		*pw++ = pattern;
+#define CHUNK_SIZE  sizeof(chunk_t)
 
-	pb = (char *) pw;
+struct achunk {
+	chunk_t n;
+} __attribute__((packed));
 
-	/* Fill final segment. */
-	i = n;
-	while (i-- != 0)
-		*pb++ = b;
+struct a64 {
+	uint64_t n;
+} __attribute__((packed));
 
-	return dest;
-}
+struct a32 {
+	uint32_t n;
+} __attribute__((packed));
 
-struct along {
-	unsigned long n;
+struct a16 {
+	uint16_t n;
 } __attribute__((packed));
 
-static void *unaligned_memcpy(void *dst, const void *src, size_t n)
-{
-	size_t i, j;
-	struct along *adst = dst;
-	const struct along *asrc = src;
+#ifdef ARCH_MEM_LARGE
 
-	for (i = 0; i < n / sizeof(unsigned long); i++)
-		adst[i].n = asrc[i].n;
+/** Smallest block handed to the architecture block operations. */
+static size_t mem_large = SIZE_MAX;
 
-	for (j = 0; j < n % sizeof(unsigned long); j++)
-		((unsigned char *) (((unsigned long *) dst) + i))[j] =
-		    ((unsigned char *) (((unsigned long *) src) + i))[j];
+#endif
 
-	return (char *) dst;
+/** Select the size classes for the current processor. */
+void __mem_init(void)
+{
+#ifdef ARCH_MEM_LARGE
+	mem_large = arch_mem_large_threshold();
+#endif
 }
 
-/** Copy memory block. */
 ATTRIBUTE_OPTIMIZE_NO_TLDP
-    void *memcpy(void *dst, const void *src, size_t n)
+    static inline chunk_t chunk_load(const uint8_t *src)
 {
-	size_t i;
-	size_t mod, fill;
-	size_t word_size;
-	size_t n_words;
+	return ((const struct achunk *) src)->n;
+}
 
-	const unsigned long *srcw;
-	unsigned long *dstw;
-	const uint8_t *srcb;
-	uint8_t *dstb;
+ATTRIBUTE_OPTIMIZE_NO_TLDP
+    static inline void chunk_store(uint8_t *dst, chunk_t v)
+{
+	((struct achunk *) dst)->n = v;
+}
 
-	word_size = sizeof(unsigned long);
+/** Copy a block of at most SMALL_SIZE bytes.
+ *
+ * All loads are done before the first store, so the blocks may overlap.
+ */
+ATTRIBUTE_OPTIMIZE_NO_TLDP
+    static inline void copy_small(uint8_t *dst, const uint8_t *src, size_t n)
+{
+	if (n >= 8) {
+		uint64_t head = ((const struct a64 *) src)->n;
+		uint64_t tail = ((const struct a64 *) (src + n - 8))->n;
+		((struct a64 *) dst)->n = head;
+		((struct a64 *) (dst + n - 8))->n = tail;
+	} else if (n >= 4) {
+		uint32_t head = ((const struct a32 *) src)->n;
+		uint32_t tail = ((const struct a32 *) (src + n - 4))->n;
+		((struct a32 *) dst)->n = head;
+		((struct a32 *) (dst + n - 4))->n = tail;
+	} else if (n >= 2) {
+		uint16_t head = ((const struct a16 *) src)->n;
+		uint16_t tail = ((const struct a16 *) (src + n - 2))->n;
+		((struct a16 *) dst)->n = head;
+		((struct a16 *) (dst + n - 2))->n = tail;
+	} else if (n == 1) {
+		*dst = *src;
+	}
+}
 
-	/*
-	 * Are source and destination addresses congruent modulo word_size?
-	 * If not, use unaligned_memcpy().
-	 */
+/** Copy a block of more than SMALL_SIZE bytes front to back.
+ *
+ * The first and last chunk are loaded up front and stored last, the
+ * chunks in between are stored to aligned addresses. Every chunk is
+ * loaded before it is stored, so the blocks may overlap as long as
+ * @a dst precedes @a src.
+ */
+ATTRIBUTE_OPTIMIZE_NO_TLDP
+    static void copy_forward(uint8_t *dst, const uint8_t *src, size_t n)
+{
+	chunk_t head = chunk_load(src);
+	chunk_t tail = chunk_load(src + n - CHUNK_SIZE);
 
-	if (((uintptr_t) dst & (word_size - 1)) !=
-	    ((uintptr_t) src & (word_size - 1)))
-		return unaligned_memcpy(dst, src, n);
+	size_t i = CHUNK_SIZE - ((uintptr_t) dst & (CHUNK_SIZE - 1));
+	size_t end = n - CHUNK_SIZE;
 
-	/*
-	 * mod is the address modulo word size. fill is the length of the
-	 * initial buffer segment before the first word boundary.
-	 * If the buffer is very short, use unaligned_memcpy(), too.
-	 */
+	if (((uintptr_t) (src + i) & (CHUNK_SIZE - 1)) == 0) {
+		for (; i < end; i += CHUNK_SIZE)
+			*(chunk_t *) (dst + i) = *(const chunk_t *) (src + i);
+	} else {
+		for (; i < end; i += CHUNK_SIZE)
+			*(chunk_t *) (dst + i) = chunk_load(src + i);
+	}
 
-	mod = (uintptr_t) dst & (word_size - 1);
-	fill = word_size - mod;
-	if (fill > n)
-		fill = n;
+	chunk_store(dst, head);
+	chunk_store(dst + end, tail);
+}
 
-	/* Copy the initial segment. */
+/** Copy a block of more than SMALL_SIZE bytes back to front.
+ *
+ * Mirror image of copy_forward(), the blocks may overlap as long as
+ * @a src precedes @a dst.
+ */
+ATTRIBUTE_OPTIMIZE_NO_TLDP
+    static void copy_backward(uint8_t *dst, const uint8_t *src, size_t n)
+{
+	chunk_t head = chunk_load(src);
+	chunk_t tail = chunk_load(src + n - CHUNK_SIZE);
 
-	srcb = src;
-	dstb = dst;
+	size_t i = n - ((uintptr_t) (dst + n) & (CHUNK_SIZE - 1));
 
-	i = fill;
-	while (i-- != 0)
-		*dstb++ = *srcb++;
+	if (((uintptr_t) (src + i) & (CHUNK_SIZE - 1)) == 0) {
+		while (i > CHUNK_SIZE) {
+			i -= CHUNK_SIZE;
+			*(chunk_t *) (dst + i) = *(const chunk_t *) (src + i);
+		}
+	} else {
+		while (i > CHUNK_SIZE) {
+			i -= CHUNK_SIZE;
+			*(chunk_t *) (dst + i) = chunk_load(src + i);
+		}
+	}
 
-	/* Compute remaining length. */
+	chunk_store(dst, head);
+	chunk_store(dst + n - CHUNK_SIZE, tail);
+}
 
-	n -= fill;
-	if (n == 0)
-		return dst;
+/** Fill memory block with a constant value. */
+ATTRIBUTE_OPTIMIZE_NO_TLDP
+    void *memset(void *dest, int b, size_t n)
+{
+	uint8_t *pb = dest;
+	uint64_t pattern = (uint8_t) b * UINT64_C(0x0101010101010101);
+
+	if (n <= SMALL_SIZE) {
+		if (n >= 8) {
+			((struct a64 *) pb)->n = pattern;
+			((struct a64 *) (pb + n - 8))->n = pattern;
+		} else if (n >= 4) {
+			((struct a32 *) pb)->n = pattern;
+			((struct a32 *) (pb + n - 4))->n = pattern;
+		} else if (n >= 2) {
+			((struct a16 *) pb)->n = pattern;
+			((struct a16 *) (pb + n - 2))->n = pattern;
+		} else if (n == 1) {
+			*pb = b;
+		}
 
-	/* Pointers to aligned segment. */
+		return dest;
+	}
 
-	dstw = (unsigned long *) dstb;
-	srcw = (const unsigned long *) srcb;
+#ifdef ARCH_MEM_LARGE
+	if (n >= mem_large) {
+		arch_memset_large(dest, b, n);
+		return dest;
+	}
+#endif
 
-	n_words = n / word_size;	/* Number of whole words to copy. */
-	n -= n_words * word_size;	/* Remaining bytes at the end. */
+	chunk_t v = CHUNK_SPLAT(b);
 
-	/* "Fast" copy. */
-	i = n_words;
-	while (i-- != 0)
-		*dstw++ = *srcw++;
+	/* Unaligned first and last chunk, aligned chunks in between. */
+	size_t i = CHUNK_SIZE - ((uintptr_t) pb & (CHUNK_SIZE - 1));
+	size_t end = n - CHUNK_SIZE;
 
-	/*
-	 * Copy the rest.
-	 */
+	chunk_store(pb, v);
+	for (; i < end; i += CHUNK_SIZE)
+		*(chunk_t *) (pb + i) = v;
+	chunk_store(pb + end, v);
 
-	srcb = (const uint8_t *) srcw;
-	dstb = (uint8_t *) dstw;
+	return dest;
+}
 
-	i = n;
-	while (i-- != 0)
-		*dstb++ = *srcb++;
+/** Copy memory block. */
+ATTRIBUTE_OPTIMIZE_NO_TLDP
+    void *memcpy(void *dst, const void *src, size_t n)
+{
+	if (n <= SMALL_SIZE) {
+		copy_small(dst, src, n);
+		return dst;
+	}
+
+#ifdef ARCH_MEM_LARGE
+	if (n >= mem_large) {
+		arch_memcpy_large(dst, src, n);
+		return dst;
+	}
+#endif
 
+	copy_forward(dst, src, n);
 	return dst;
 }
 
 /** Move memory block with possible overlapping. */
-void *memmove(void *dst, const void *src, size_t n)
+ATTRIBUTE_OPTIMIZE_NO_TLDP
+    void *memmove(void *dst, const void *src, size_t n)
 {
-	const uint8_t *sp;
-	uint8_t *dp;
-
 	/* Nothing to do? */
 	if (src == dst)
 		return dst;
 
 	/* Non-overlapping? */
-	if (dst >= src + n || src >= dst + n) {
+	if (dst >= src + n || src >= dst + n)
 		return memcpy(dst, src, n);
+
+	if (n <= SMALL_SIZE) {
+		copy_small(dst, src, n);
+		return dst;
 	}
 
 	/* Which direction? */
-	if (src > dst) {
-		/* Forwards. */
-		sp = src;
-		dp = dst;
-
-		while (n-- != 0)
-			*dp++ = *sp++;
-	} else {
-		/* Backwards. */
-		sp = src + (n - 1);
-		dp = dst + (n - 1);
-
-		while (n-- != 0)
-			*dp-- = *sp--;
-	}
+	if (src > dst)
+		copy_forward(dst, src, n);
+	else
+		copy_backward(dst, src, n);
 
 	return dst;
 }
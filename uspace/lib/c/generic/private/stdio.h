@@ -38,6 +38,8 @@
 #include <adt/list.h>
 #include <stdio.h>
 #include <async.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <stddef.h>
 #include <offset.h>
 
@@ -106,6 +108,9 @@ struct _IO_FILE {
 	/** Buffer size */
 	size_t buf_size;
 
+	/** Buffer was allocated by stdio and is freed with the stream */
+	bool buf_alloc;
+
 	/** Buffer state */
 	enum __buffer_state buf_state;
 
@@ -120,6 +125,15 @@ struct _IO_FILE {
 
 	/** Number of pushed back characters */
 	int ungetc_chars;
+
+	/** Stream lock */
+	fibril_mutex_t lock;
+
+	/** Fibril holding the stream lock */
+	fid_t lock_owner;
+
+	/** Nesting depth of flockfile() by the lock owner */
+	unsigned int lock_count;
 };
 
 #endif
@@ -421,7 +421,7 @@ static int __fgetc(FILE *f, int *numchar)
 {
 	int c;
 
-	c = fgetc(f);
+	c = fgetc_unlocked(f);
 	if (c == EOF)
 		return EOF;
 
@@ -1326,6 +1326,9 @@ int vfscanf(FILE *f, const char *fmt, va_list ap)
 
 	va_copy(va.ap, ap);
 
+	/* The stream stays locked for the whole conversion. */
+	flockfile(f);
+
 	ncvt = 0;
 	numchar = 0;
 	cp = fmt;
@@ -1369,6 +1372,8 @@ int vfscanf(FILE *f, const char *fmt, va_list ap)
 		}
 	}
 
+	funlockfile(f);
+
 	if (input_error && ncvt == 0)
 		return EOF;
 
@@ -94,6 +94,7 @@ static int stdio_str_flush(FILE *stream)
 void __sstream_init(const char *str, FILE *stream)
 {
 	memset(stream, 0, sizeof(FILE));
+	fibril_mutex_initialize(&stream->lock);
 	stream->ops = &stdio_str_ops;
 	stream->arg = (void *)str;
 }
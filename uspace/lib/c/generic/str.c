@@ -116,6 +116,7 @@
 #include <stdlib.h>
 
 #include <align.h>
+#include <macros.h>
 #include <mem.h>
 
 /** Check the condition if wchar_t is signed */
@@ -137,6 +138,154 @@
 /** Number of data bits in a UTF-8 continuation byte */
 #define CONT_BITS  6
 
+/*
+ * Word-at-a-time scanning.
+ *
+ * Most strings are plain ASCII, which can be processed many bytes at a time
+ * without decoding. Scanning loops align to a word boundary first, so that
+ * the wide loads never cross into a page which the string does not touch.
+ */
+
+/** Number of bytes in a word used for scanning */
+#define WORD_SIZE  sizeof(unsigned long)
+
+/** Word with all bytes set to 0x01 */
+#define WORD_ONES  ((unsigned long) -1 / 0xff)
+
+/** Word with the highest bit of all bytes set */
+#define WORD_HIGHS  (WORD_ONES << 7)
+
+/** Check whether a word contains a zero byte */
+#define WORD_HAS_ZERO(w)  ((((w) - WORD_ONES) & ~(w) & WORD_HIGHS) != 0)
+
+/** Check whether a word contains a byte which is not plain ASCII */
+#define WORD_HAS_NON_ASCII(w)  (((w) & WORD_HIGHS) != 0)
+
+#ifdef __SSE2__
+
+/** Vector of bytes used for scanning with SSE2 */
+typedef char vec_t __attribute__((vector_size(16)));
+
+/** Number of bytes in a vector */
+#define VEC_SIZE  sizeof(vec_t)
+
+/** Get bit mask of the bytes of a vector which are zero or not plain ASCII */
+static inline unsigned int vec_stop_mask(vec_t v)
+{
+	vec_t zero = { 0 };
+
+	return __builtin_ia32_pmovmskb128(v) |
+	    __builtin_ia32_pmovmskb128((vec_t) (v == zero));
+}
+
+#endif
+
+/** Get the size of a plain ASCII prefix of a string.
+ *
+ * Count the leading bytes of @a str which are plain ASCII characters other
+ * than NULL and @a stop. Each of these bytes is a complete character.
+ *
+ * @param str  String to scan.
+ * @param stop ASCII character to stop at (NULL if none).
+ *
+ * @return Number of bytes in the prefix.
+ *
+ */
+static size_t ascii_span(const char *str, char stop)
+{
+	const uint8_t *p = (const uint8_t *) str;
+
+	/* Most calls end right away, e.g. in the middle of non-ASCII text */
+	if (*p == 0 || *p >= 0x80 || *p == (uint8_t) stop)
+		return 0;
+
+#ifdef __SSE2__
+	while (((uintptr_t) p & (VEC_SIZE - 1)) != 0) {
+		if (*p == 0 || *p >= 0x80 || *p == (uint8_t) stop)
+			return (const char *) p - str;
+		p++;
+	}
+
+	vec_t pattern = (vec_t) { 0 } + stop;
+
+	while (true) {
+		vec_t v = *(const vec_t *) p;
+		unsigned int mask = vec_stop_mask(v) |
+		    __builtin_ia32_pmovmskb128((vec_t) (v == pattern));
+
+		if (mask != 0)
+			return (const char *) p - str + __builtin_ctz(mask);
+
+		p += VEC_SIZE;
+	}
+#else
+	while (((uintptr_t) p & (WORD_SIZE - 1)) != 0) {
+		if (*p == 0 || *p >= 0x80 || *p == (uint8_t) stop)
+			return (const char *) p - str;
+		p++;
+	}
+
+	unsigned long pattern = WORD_ONES * (uint8_t) stop;
+	const unsigned long *w = (const unsigned long *) p;
+
+	while (!WORD_HAS_NON_ASCII(*w) && !WORD_HAS_ZERO(*w) &&
+	    !WORD_HAS_ZERO(*w ^ pattern))
+		w++;
+
+	p = (const uint8_t *) w;
+	while (*p != 0 && *p < 0x80 && *p != (uint8_t) stop)
+		p++;
+
+	return (const char *) p - str;
+#endif
+}
+
+/** Get the size of a common plain ASCII prefix of two strings.
+ *
+ * Count the leading bytes which are the same in @a s1 and @a s2 and which
+ * are plain ASCII characters other than NULL.
+ *
+ * @param s1       First string.
+ * @param s2       Second string.
+ * @param max_size Maximum number of bytes to consider.
+ *
+ * @return Number of bytes in the common prefix.
+ *
+ */
+static size_t ascii_common_span(const char *s1, const char *s2,
+    size_t max_size)
+{
+	const uint8_t *p1 = (const uint8_t *) s1;
+	const uint8_t *p2 = (const uint8_t *) s2;
+	size_t size = 0;
+
+	/* Words can only be compared if both strings are aligned alike */
+	if ((((uintptr_t) p1 ^ (uintptr_t) p2) & (WORD_SIZE - 1)) == 0) {
+		while (((uintptr_t) (p1 + size) & (WORD_SIZE - 1)) != 0) {
+			if (size >= max_size || p1[size] != p2[size] ||
+			    p1[size] == 0 || p1[size] >= 0x80)
+				return size;
+			size++;
+		}
+
+		while (max_size - size >= WORD_SIZE) {
+			unsigned long w1 = *(const unsigned long *) (p1 + size);
+			unsigned long w2 = *(const unsigned long *) (p2 + size);
+
+			if (w1 != w2 || WORD_HAS_NON_ASCII(w1) || WORD_HAS_ZERO(w1))
+				break;
+
+			size += WORD_SIZE;
+		}
+	}
+
+	while (size < max_size && p1[size] == p2[size] && p1[size] != 0 &&
+	    p1[size] < 0x80)
+		size++;
+
+	return size;
+}
+
 /** Decode a single character from a string.
  *
  * Decode a single character from a string of size @a size. Decoding starts
@@ -333,12 +482,43 @@ errno_t chr_encode(const wchar_t ch, char *str, size_t *offset, size_t size)
  */
 size_t str_size(const char *str)
 {
-	size_t size = 0;
+	const char *p = str;
 
-	while (*str++ != 0)
-		size++;
+#ifdef __SSE2__
+	while (((uintptr_t) p & (VEC_SIZE - 1)) != 0) {
+		if (*p == 0)
+			return p - str;
+		p++;
+	}
 
-	return size;
+	vec_t zero = { 0 };
+
+	while (true) {
+		unsigned int mask = __builtin_ia32_pmovmskb128(
+		    (vec_t) (*(const vec_t *) p == zero));
+
+		if (mask != 0)
+			return p - str + __builtin_ctz(mask);
+
+		p += VEC_SIZE;
+	}
+#else
+	while (((uintptr_t) p & (WORD_SIZE - 1)) != 0) {
+		if (*p == 0)
+			return p - str;
+		p++;
+	}
+
+	const unsigned long *w = (const unsigned long *) p;
+	while (!WORD_HAS_ZERO(*w))
+		w++;
+
+	p = (const char *) w;
+	while (*p != 0)
+		p++;
+
+	return p - str;
+#endif
 }
 
 /** Get size of wide string.
@@ -451,8 +631,17 @@ size_t str_length(const char *str)
 	size_t len = 0;
 	size_t offset = 0;
 
-	while (str_decode(str, &offset, STR_NO_LIMIT) != 0)
+	while (true) {
+		/* Every byte of a plain ASCII run is a character */
+		size_t span = ascii_span(str + offset, 0);
+		len += span;
+		offset += span;
+
+		if (str_decode(str, &offset, STR_NO_LIMIT) == 0)
+			break;
+
 		len++;
+	}
 
 	return len;
 }
@@ -568,6 +757,66 @@ bool chr_check(wchar_t ch)
 	return false;
 }
 
+/** Check whether string is valid UTF-8.
+ *
+ * The string is valid if it is well-formed UTF-8 as defined by RFC 3629,
+ * i.e. it contains no stray continuation bytes, truncated sequences,
+ * overlong encodings, surrogates or code points above U+10FFFF.
+ *
+ * @param str NULL-terminated string.
+ *
+ * @return True if the string is valid UTF-8.
+ *
+ */
+bool str_check(const char *str)
+{
+	const uint8_t *p = (const uint8_t *) str;
+
+	while (true) {
+		p += ascii_span((const char *) p, 0);
+
+		uint8_t b0 = *p++;
+		if (b0 == 0)
+			return true;
+
+		/* Range of the first continuation byte and their count */
+		uint8_t lo = 0x80;
+		uint8_t hi = 0xbf;
+		unsigned int cbytes;
+
+		if (b0 >= 0xc2 && b0 <= 0xdf) {
+			cbytes = 1;
+		} else if (b0 >= 0xe0 && b0 <= 0xef) {
+			/* Overlong encodings and surrogates */
+			if (b0 == 0xe0)
+				lo = 0xa0;
+			else if (b0 == 0xed)
+				hi = 0x9f;
+			cbytes = 2;
+		} else if (b0 >= 0xf0 && b0 <= 0xf4) {
+			/* Overlong encodings and code points above U+10FFFF */
+			if (b0 == 0xf0)
+				lo = 0x90;
+			else if (b0 == 0xf4)
+				hi = 0x8f;
+			cbytes = 3;
+		} else {
+			return false;
+		}
+
+		if (*p < lo || *p > hi)
+			return false;
+
+		while (--cbytes > 0) {
+			p++;
+			if ((*p & 0xc0) != 0x80)
+				return false;
+		}
+
+		p++;
+	}
+}
+
 /** Compare two NULL terminated strings.
  *
  * Do a char-by-char comparison of two NULL-terminated strings.
@@ -595,6 +844,12 @@ int str_cmp(const char *s1, const char *s2)
 	size_t off2 = 0;
 
 	while (true) {
+		/* Identical plain ASCII runs decode to identical characters */
+		size_t span = ascii_common_span(s1 + off1, s2 + off2,
+		    STR_NO_LIMIT);
+		off1 += span;
+		off2 += span;
+
 		c1 = str_decode(s1, &off1, STR_NO_LIMIT);
 		c2 = str_decode(s2, &off2, STR_NO_LIMIT);
 
@@ -644,6 +899,12 @@ int str_lcmp(const char *s1, const char *s2, size_t max_len)
 	size_t len = 0;
 
 	while (true) {
+		size_t span = ascii_common_span(s1 + off1, s2 + off2,
+		    max_len - len);
+		off1 += span;
+		off2 += span;
+		len += span;
+
 		if (len >= max_len)
 			break;
 
@@ -1225,17 +1486,29 @@ char *str_chr(const char *str, wchar_t ch)
 	wchar_t acc;
 	size_t off = 0;
 	size_t last = 0;
+	char stop = ascii_check(ch) ? (char) ch : 0;
+
+	while (true) {
+		/* Skip plain ASCII characters which cannot match */
+		off += ascii_span(str + off, stop);
+		last = off;
+
+		acc = str_decode(str, &off, STR_NO_LIMIT);
+		if (acc == 0)
+			break;
 
-	while ((acc = str_decode(str, &off, STR_NO_LIMIT)) != 0) {
 		if (acc == ch)
 			return (char *) (str + last);
-		last = off;
 	}
 
 	return NULL;
 }
 
 /** Find first occurence of substring in string.
+ *
+ * The search uses the Boyer-Moore-Horspool algorithm on the bytes of the
+ * strings. For valid UTF-8 this is the same as comparing characters, since
+ * a character never starts in the middle of another one.
  *
  * @param hs  Haystack (string)
  * @param n   Needle (substring to look for)
@@ -1244,14 +1517,53 @@ char *str_chr(const char *str, wchar_t ch)
  */
 char *str_str(const char *hs, const char *n)
 {
+	size_t n_size = str_size(n);
+
+	if (n_size == 0)
+		return (char *) hs;
+
+	if (n_size == 1) {
+		char c = n[0];
+		size_t off = 0;
+
+		while (true) {
+			if ((uint8_t) c < 0x80)
+				off += ascii_span(hs + off, c);
+
+			if (hs[off] == c)
+				return (char *) (hs + off);
+
+			if (hs[off] == 0)
+				return NULL;
+
+			off++;
+		}
+	}
+
+	/*
+	 * Shift of the window for each value of its last byte. The shifts are
+	 * capped to keep the table small, which only makes them conservative.
+	 */
+	uint8_t shift[256];
+	size_t max_shift = min(n_size, UINT8_MAX);
+
+	for (size_t i = 0; i < 256; i++)
+		shift[i] = max_shift;
+
+	for (size_t i = n_size - max_shift; i < n_size - 1; i++)
+		shift[(uint8_t) n[i]] = n_size - 1 - i;
+
+	size_t hs_size = str_size(hs);
+	uint8_t last = n[n_size - 1];
 	size_t off = 0;
 
-	if (str_lcmp(hs, n, str_length(n)) == 0)
-		return (char *)hs;
+	while (hs_size - off >= n_size) {
+		uint8_t b = hs[off + n_size - 1];
 
-	while (str_decode(hs, &off, STR_NO_LIMIT) != 0) {
-		if (str_lcmp(hs + off, n, str_length(n)) == 0)
-			return (char *)(hs + off);
+		if (b == last && memcmp(hs + off, n, n_size - 1) == 0)
+			return (char *) (hs + off);
+
+		off += shift[b];
 	}
 
 	return NULL;
@@ -1324,11 +1636,18 @@ char *str_rchr(const char *str, wchar_t ch)
 	size_t off = 0;
 	size_t last = 0;
 	const char *res = NULL;
+	char stop = ascii_check(ch) ? (char) ch : 0;
+
+	while (true) {
+		off += ascii_span(str + off, stop);
+		last = off;
+
+		acc = str_decode(str, &off, STR_NO_LIMIT);
+		if (acc == 0)
+			break;
 
-	while ((acc = str_decode(str, &off, STR_NO_LIMIT)) != 0) {
 		if (acc == ch)
 			res = (str + last);
-		last = off;
 	}
 
 	return (char *) res;
@@ -40,6 +40,8 @@
 
 extern uint32_t compute_crc32(uint8_t *, size_t);
 extern uint32_t compute_crc32_seed(uint8_t *, size_t, uint32_t);
+extern uint32_t compute_crc32c(uint8_t *, size_t);
+extern uint32_t compute_crc32c_seed(uint8_t *, size_t, uint32_t);
 
 #endif
 
@@ -40,6 +40,24 @@
 
 struct iplink_ev_ops;
 
+/** IP link verifies IPv4 header checksum of received packets */
+#define IPLINK_OFFLOAD_RX_IPV4_CSUM  0x0001
+/** IP link verifies TCP/UDP over IPv4 checksum of received packets */
+#define IPLINK_OFFLOAD_RX_L4_CSUM    0x0002
+/** IP link completes TCP/UDP over IPv4 checksum of sent packets */
+#define IPLINK_OFFLOAD_TX_L4_CSUM    0x0004
+/** IP link segments TCP over IPv4 packets larger than the MTU */
+#define IPLINK_OFFLOAD_TSO4          0x0008
+
+/** Received packet has valid IPv4 header checksum */
+#define IPLINK_SDU_IPV4_CSUM_OK  0x0001
+/** Received packet has valid TCP/UDP checksum */
+#define IPLINK_SDU_L4_CSUM_OK    0x0002
+/** TCP/UDP checksum field of the packet holds the pseudo-header sum only */
+#define IPLINK_SDU_L4_CSUM       0x0004
+/** Packet is a TCP super-segment to be split at @c mss */
+#define IPLINK_SDU_TSO           0x0008
+
 typedef struct {
 	async_sess_t *sess;
 	struct iplink_ev_ops *ev_ops;
@@ -56,6 +74,10 @@ typedef struct {
 	void *data;
 	/** Size of @c data in bytes */
 	size_t size;
+	/** Offload flags (IPLINK_SDU_xxx) */
+	uint32_t flags;
+	/** Maximum segment size for IPLINK_SDU_TSO */
+	size_t mss;
 } iplink_sdu_t;
 
 /** IPv6 link Service Data Unit */
@@ -74,6 +96,8 @@ typedef struct {
 	void *data;
 	/** Size of @c data in bytes */
 	size_t size;
+	/** Offload flags (IPLINK_SDU_xxx) */
+	uint32_t flags;
 } iplink_recv_sdu_t;
 
 typedef struct iplink_ev_ops {
@@ -89,6 +113,7 @@ extern errno_t iplink_addr_add(iplink_t *, inet_addr_t *);
 extern errno_t iplink_addr_remove(iplink_t *, inet_addr_t *);
 extern errno_t iplink_get_mtu(iplink_t *, size_t *);
 extern errno_t iplink_get_mac48(iplink_t *, addr48_t *);
+extern errno_t iplink_get_offload(iplink_t *, uint32_t *);
 extern errno_t iplink_set_mac48(iplink_t *, addr48_t);
 extern void *iplink_get_userptr(iplink_t *);
 
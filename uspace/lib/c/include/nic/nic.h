@@ -75,6 +75,32 @@
 #define NIC_DEFECTIVE_BAD_TCP_CHECKSUM   0x0080
 #define NIC_DEFECTIVE_BAD_UDP_CHECKSUM   0x0100
 
+/** NIC verifies IPv4 header checksum of received frames */
+#define NIC_OFFLOAD_RX_IPV4_CSUM  0x0001
+/** NIC verifies TCP/UDP over IPv4 checksum of received frames */
+#define NIC_OFFLOAD_RX_L4_CSUM    0x0002
+/** NIC completes TCP/UDP over IPv4 checksum of sent frames */
+#define NIC_OFFLOAD_TX_L4_CSUM    0x0004
+/** NIC splits TCP over IPv4 super-segments into MSS-sized frames */
+#define NIC_OFFLOAD_TSO4          0x0008
+
+/*
+ * Per-frame offload flags. Frames sent with NIC_FF_L4_CSUM carry the
+ * one's complement sum of the L4 pseudo-header in the checksum field,
+ * the NIC sums the L4 header and payload on top of it. NIC_FF_TSO frames
+ * are segmented at the given MSS, checksums of the segments are always
+ * completed by the NIC.
+ */
+
+/** Received frame has valid IPv4 header checksum */
+#define NIC_FF_IPV4_CSUM_OK  0x0001
+/** Received frame has valid TCP/UDP checksum */
+#define NIC_FF_L4_CSUM_OK    0x0002
+/** Complete TCP/UDP checksum of the frame to be sent */
+#define NIC_FF_L4_CSUM       0x0004
+/** Segment the TCP payload of the frame to be sent */
+#define NIC_FF_TSO           0x0008
+
 /**
  * The bitmap uses single bit for each of the 2^12 = 4096 possible VLAN tags.
  * This means its size is 4096/8 = 512 bytes.
@@ -432,7 +458,14 @@ typedef enum nic_poll_mode {
 	 * must create software timer, internal hardware timer of NIC must not be
 	 * used even if the NIC supports it.
 	 */
-	NIC_POLL_SOFTWARE_PERIODIC
+	NIC_POLL_SOFTWARE_PERIODIC,
+	/**
+	 * The NIC framework switches between NIC_POLL_IMMEDIATE and periodic
+	 * polling according to the receive rate. Interrupts are used while
+	 * the traffic is light, the NIC is polled with the given period
+	 * while the frame rate stays above the driver's threshold.
+	 */
+	NIC_POLL_ADAPTIVE
 } nic_poll_mode_t;
 
 /**
@@ -120,6 +120,16 @@ extern int puts(const char *);
 
 extern int ungetc(int, FILE *);
 
+/* Stream locking */
+extern void flockfile(FILE *);
+extern int ftrylockfile(FILE *);
+extern void funlockfile(FILE *);
+
+extern int getc_unlocked(FILE *);
+extern int getchar_unlocked(void);
+extern int putc_unlocked(int, FILE *);
+extern int putchar_unlocked(int);
+
 extern wint_t fputwc(wchar_t, FILE *);
 extern wint_t putwchar(wchar_t);
 
@@ -213,6 +223,19 @@ extern int fileno(FILE *);
 extern int fseek64(FILE *, off64_t, int);
 extern off64_t ftell64(FILE *);
 
+/* Variants that expect the caller to hold the stream lock. */
+extern int fgetc_unlocked(FILE *);
+extern char *fgets_unlocked(char *, int, FILE *);
+extern int fputc_unlocked(int, FILE *);
+extern int fputs_unlocked(const char *, FILE *);
+extern wint_t fputwc_unlocked(wchar_t, FILE *);
+extern size_t fread_unlocked(void *, size_t, size_t, FILE *);
+extern size_t fwrite_unlocked(const void *, size_t, size_t, FILE *);
+extern int fflush_unlocked(FILE *);
+extern int feof_unlocked(FILE *);
+extern int ferror_unlocked(FILE *);
+extern void clearerr_unlocked(FILE *);
+
 __HELENOS_DECLS_END;
 #endif
 
@@ -42,12 +42,24 @@
 
 #define INET_TTL_MAX 255
 
+/** Datagram offload flags */
+typedef enum {
+	/** Received datagram has valid TCP/UDP checksum */
+	INET_DGRAM_L4_CSUM_OK = 0x1,
+	/** TCP/UDP checksum field holds the pseudo-header sum only */
+	INET_DGRAM_L4_CSUM = 0x2,
+	/** TCP segment may be split into MTU-sized segments */
+	INET_DGRAM_TSO = 0x4
+} inet_dgram_flags_t;
+
 typedef struct {
 	/** Local IP link service ID (optional) */
 	service_id_t iplink;
 	inet_addr_t src;
 	inet_addr_t dest;
 	uint8_t tos;
+	/** Offload flags (inet_dgram_flags_t) */
+	uint32_t flags;
 	void *data;
 	size_t size;
 } inet_dgram_t;
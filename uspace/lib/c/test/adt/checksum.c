@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <adt/checksum.h>
+#include <pcut/pcut.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(checksum);
+
+enum {
+	buffer_size = 1024
+};
+
+static uint8_t buffer[buffer_size];
+
+/** Bit-at-a-time reference implementation of a reflected CRC-32. */
+static uint32_t crc_reference(uint32_t poly, const uint8_t *data,
+    size_t length, uint32_t seed)
+{
+	uint32_t crc = ~seed;
+	size_t i;
+	int bit;
+
+	for (i = 0; i < length; i++) {
+		crc ^= data[i];
+		for (bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+	}
+
+	return ~crc;
+}
+
+static void fill_buffer(void)
+{
+	size_t i;
+
+	for (i = 0; i < buffer_size; i++)
+		buffer[i] = (uint8_t) (i * 167 + (i >> 8) * 13);
+}
+
+/** Standard check values of both polynomials. */
+PCUT_TEST(check_value)
+{
+	uint8_t data[] = "123456789";
+
+	PCUT_ASSERT_INT_EQUALS(0, compute_crc32(data, 0));
+	PCUT_ASSERT_INT_EQUALS(0xcbf43926, compute_crc32(data, 9));
+	PCUT_ASSERT_INT_EQUALS(0, compute_crc32c(data, 0));
+	PCUT_ASSERT_INT_EQUALS(0xe3069283, compute_crc32c(data, 9));
+}
+
+/** All lengths and alignments of the slicing and hardware paths. */
+PCUT_TEST(lengths)
+{
+	size_t off;
+	size_t len;
+
+	fill_buffer();
+
+	for (off = 0; off < 8; off++) {
+		for (len = 0; len + off <= buffer_size; len += 1 + len / 16) {
+			PCUT_ASSERT_INT_EQUALS(
+			    crc_reference(0xedb88320, buffer + off, len, 0),
+			    compute_crc32(buffer + off, len));
+			PCUT_ASSERT_INT_EQUALS(
+			    crc_reference(0x82f63b78, buffer + off, len, 0),
+			    compute_crc32c(buffer + off, len));
+		}
+	}
+}
+
+/** Checksumming in pieces gives the same result as in one go. */
+PCUT_TEST(chaining)
+{
+	uint32_t crc;
+	uint32_t crcc;
+	size_t split;
+
+	fill_buffer();
+
+	for (split = 0; split <= buffer_size; split += 93) {
+		crc = compute_crc32(buffer, split);
+		crc = compute_crc32_seed(buffer + split, buffer_size - split,
+		    crc);
+		PCUT_ASSERT_INT_EQUALS(compute_crc32(buffer, buffer_size), crc);
+
+		crcc = compute_crc32c(buffer, split);
+		crcc = compute_crc32c_seed(buffer + split, buffer_size - split,
+		    crcc);
+		PCUT_ASSERT_INT_EQUALS(compute_crc32c(buffer, buffer_size), crcc);
+	}
+}
+
+PCUT_EXPORT(checksum);
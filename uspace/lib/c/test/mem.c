@@ -28,11 +28,27 @@
 
 #include <mem.h>
 #include <pcut/pcut.h>
+#include <stdint.h>
 
 PCUT_INIT;
 
 PCUT_TEST_SUITE(mem);
 
+/** Size of the buffers used to exercise all size classes. */
+#define TEST_SIZE 8192
+
+static uint8_t src_buf[TEST_SIZE];
+static uint8_t dst_buf[TEST_SIZE];
+
+/** Fill buffer with a pattern that differs for every offset and seed. */
+static void fill_pattern(uint8_t *buf, size_t size, unsigned seed)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++)
+		buf[i] = (uint8_t) (i * 7 + seed);
+}
+
 /** memcpy function */
 PCUT_TEST(memcpy)
 {
@@ -115,4 +131,94 @@ PCUT_TEST(memset)
 	PCUT_ASSERT_INT_EQUALS('x', buf[4]);
 }
 
+/** memcpy function with all size classes and alignments */
+PCUT_TEST(memcpy_sizes)
+{
+	static const size_t sizes[] = {
+		0, 1, 2, 3, 7, 8, 15, 16, 17, 31, 32, 33, 63, 64, 65, 255,
+		256, 1023, 2047, 2048, 2049, 4096, TEST_SIZE - 64
+	};
+	size_t s, soff, doff, i;
+
+	fill_pattern(src_buf, TEST_SIZE, 1);
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		for (soff = 0; soff < 16; soff += 5) {
+			for (doff = 0; doff < 16; doff += 3) {
+				size_t n = sizes[s];
+
+				memset(dst_buf, 0xaa, TEST_SIZE);
+				memcpy(dst_buf + doff, src_buf + soff, n);
+
+				for (i = 0; i < doff; i++)
+					PCUT_ASSERT_INT_EQUALS(0xaa, dst_buf[i]);
+				for (i = 0; i < n; i++) {
+					PCUT_ASSERT_INT_EQUALS(src_buf[soff + i],
+					    dst_buf[doff + i]);
+				}
+				PCUT_ASSERT_INT_EQUALS(0xaa, dst_buf[doff + n]);
+			}
+		}
+	}
+}
+
+/** memmove function with overlapping blocks in both directions */
+PCUT_TEST(memmove_overlap)
+{
+	static const size_t sizes[] = {
+		2, 9, 16, 17, 40, 100, 1000, 4000
+	};
+	static const size_t shifts[] = { 1, 3, 8, 15, 16, 17, 100 };
+	size_t s, d, i;
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		for (d = 0; d < sizeof(shifts) / sizeof(shifts[0]); d++) {
+			size_t n = sizes[s];
+			size_t shift = shifts[d];
+
+			/* Towards lower addresses. */
+			fill_pattern(dst_buf, TEST_SIZE, 3);
+			memmove(dst_buf + 1, dst_buf + 1 + shift, n);
+			PCUT_ASSERT_INT_EQUALS(3, dst_buf[0]);
+			for (i = 0; i < n; i++) {
+				PCUT_ASSERT_INT_EQUALS((uint8_t) ((1 + shift + i) * 7 + 3),
+				    dst_buf[1 + i]);
+			}
+
+			/* Towards higher addresses. */
+			fill_pattern(dst_buf, TEST_SIZE, 5);
+			memmove(dst_buf + 1 + shift, dst_buf + 1, n);
+			PCUT_ASSERT_INT_EQUALS(5, dst_buf[0]);
+			for (i = 0; i < n; i++) {
+				PCUT_ASSERT_INT_EQUALS((uint8_t) ((1 + i) * 7 + 5),
+				    dst_buf[1 + shift + i]);
+			}
+		}
+	}
+}
+
+/** memset function with all size classes and alignments */
+PCUT_TEST(memset_sizes)
+{
+	static const size_t sizes[] = {
+		0, 1, 3, 8, 15, 16, 17, 33, 100, 2047, 2048, 5000
+	};
+	size_t s, off, i;
+
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		for (off = 0; off < 16; off += 5) {
+			size_t n = sizes[s];
+
+			memset(dst_buf, 0xaa, TEST_SIZE);
+			memset(dst_buf + off, 0x5c, n);
+
+			for (i = 0; i < off; i++)
+				PCUT_ASSERT_INT_EQUALS(0xaa, dst_buf[i]);
+			for (i = 0; i < n; i++)
+				PCUT_ASSERT_INT_EQUALS(0x5c, dst_buf[off + i]);
+			PCUT_ASSERT_INT_EQUALS(0xaa, dst_buf[off + n]);
+		}
+	}
+}
+
 PCUT_EXPORT(mem);
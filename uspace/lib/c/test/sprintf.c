@@ -26,6 +26,8 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <limits.h>
+#include <mem.h>
 #include <stdio.h>
 #include <str.h>
 #include <pcut/pcut.h>
@@ -82,4 +84,38 @@ SPRINTF_TEST(int_as_hex, "[0x11] [0x012] [0x013] [0x00014] [0x00015]",
     "[%#x] [%#5.3x] [%#-5.3x] [%#3.5x] [%#-3.5x]",
     17, 18, 19, 20, 21);
 
+SPRINTF_TEST(int_extremes, "[-2147483648] [18446744073709551615] [10000000000]",
+    "[%d] [%llu] [%llu]", INT_MIN, ULLONG_MAX, 10000000000ULL);
+
+SPRINTF_TEST(int_bases, "[11111111] [377] [ff] [FF]",
+    "[%b] [%o] [%x] [%X]", 255, 255, 255, 255);
+
+/** Truncation never leaves a character after one that did not fit */
+PCUT_TEST(truncate_multibyte)
+{
+	int rc = snprintf(buffer, 4, "a\u017e%s", "b");
+	PCUT_ASSERT_INT_EQUALS(4, rc);
+	PCUT_ASSERT_STR_EQUALS("a\u017e", buffer);
+
+	rc = snprintf(buffer, 3, "a\u017e%s", "b");
+	PCUT_ASSERT_INT_EQUALS(4, rc);
+	PCUT_ASSERT_STR_EQUALS("a", buffer);
+}
+
+/** Output longer than the internal buffer of printf_core() */
+PCUT_TEST(long_output)
+{
+	char str[1001];
+	int rc;
+
+	memset(str, 'x', 1000);
+	str[1000] = '\0';
+
+	rc = snprintf(buffer, BUFFER_SIZE, "%d%s%d", 1, str, 2);
+	PCUT_ASSERT_INT_EQUALS(1002, rc);
+	PCUT_ASSERT_INT_EQUALS('1', buffer[0]);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(buffer + 1, str, 1000));
+	PCUT_ASSERT_STR_EQUALS("2", buffer + 1001);
+}
+
 PCUT_EXPORT(sprintf);
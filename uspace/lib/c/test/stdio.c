@@ -35,8 +35,11 @@
  */
 
 #include <errno.h>
+#include <mem.h>
 #include <pcut/pcut.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <str.h>
 #include <tmpfile.h>
 #include <vfs/vfs.h>
@@ -203,6 +206,88 @@ PCUT_TEST(fgetpos_setpos)
 	(void) fclose(f);
 }
 
+/** Locked stream can be accessed using the unlocked functions */
+PCUT_TEST(flockfile_unlocked)
+{
+	int rc;
+	int c;
+	FILE *f;
+
+	f = tmpfile();
+	PCUT_ASSERT_NOT_NULL(f);
+
+	flockfile(f);
+
+	/* The lock is recursive */
+	rc = ftrylockfile(f);
+	PCUT_ASSERT_INT_EQUALS(0, rc);
+	funlockfile(f);
+
+	for (c = 0; c < 256; c++) {
+		rc = putc_unlocked(c, f);
+		PCUT_ASSERT_INT_EQUALS(c, rc);
+	}
+
+	funlockfile(f);
+
+	rewind(f);
+
+	flockfile(f);
+	for (c = 0; c < 256; c++) {
+		rc = getc_unlocked(f);
+		PCUT_ASSERT_INT_EQUALS(c, rc);
+	}
+
+	rc = getc_unlocked(f);
+	PCUT_ASSERT_INT_EQUALS(EOF, rc);
+	funlockfile(f);
+
+	(void) fclose(f);
+}
+
+/** Reads and writes larger than the stream buffer */
+PCUT_TEST(fread_fwrite_large)
+{
+	size_t i;
+	size_t n;
+	uint8_t *wbuf;
+	uint8_t *rbuf;
+	FILE *f;
+	const size_t size = 200000;
+
+	wbuf = malloc(size);
+	PCUT_ASSERT_NOT_NULL(wbuf);
+	rbuf = malloc(size);
+	PCUT_ASSERT_NOT_NULL(rbuf);
+
+	for (i = 0; i < size; i++)
+		wbuf[i] = i * 7;
+
+	f = tmpfile();
+	PCUT_ASSERT_NOT_NULL(f);
+
+	/* Small write first so that the buffer is partly full */
+	n = fwrite(wbuf, 1, 3, f);
+	PCUT_ASSERT_INT_EQUALS(3, n);
+	n = fwrite(wbuf + 3, 1, size - 3, f);
+	PCUT_ASSERT_INT_EQUALS(size - 3, n);
+
+	rewind(f);
+
+	PCUT_ASSERT_INT_EQUALS(wbuf[0], fgetc(f));
+	n = fread(rbuf + 1, 1, size - 1, f);
+	PCUT_ASSERT_INT_EQUALS(size - 1, n);
+	PCUT_ASSERT_INT_EQUALS(EOF, fgetc(f));
+	PCUT_ASSERT_TRUE(feof(f));
+
+	rbuf[0] = wbuf[0];
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(wbuf, rbuf, size));
+
+	(void) fclose(f);
+	free(wbuf);
+	free(rbuf);
+}
+
 /** perror function with NULL as argument */
 PCUT_TEST(perror_null_msg)
 {
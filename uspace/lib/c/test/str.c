@@ -114,4 +114,114 @@ PCUT_TEST(str_str_empty_n)
 	PCUT_ASSERT_TRUE((const char *)p == hs);
 }
 
+PCUT_TEST(str_str_long)
+{
+	const char *hs = "the quick brown fox jumps over the lazy dog, "
+	    "the quick brown fox jumps over the lazy cat";
+	char *p;
+
+	p = str_str(hs, "lazy cat");
+	PCUT_ASSERT_TRUE((const char *)p == hs + 80);
+
+	p = str_str(hs, "lazy d");
+	PCUT_ASSERT_TRUE((const char *)p == hs + 35);
+
+	p = str_str(hs, "g");
+	PCUT_ASSERT_TRUE((const char *)p == hs + 42);
+
+	p = str_str(hs, "lazy cow");
+	PCUT_ASSERT_TRUE(p == NULL);
+
+	p = str_str("short", "much longer needle");
+	PCUT_ASSERT_TRUE(p == NULL);
+}
+
+PCUT_TEST(str_str_utf8)
+{
+	const char *hs = "příliš žluťoučký kůň";
+	char *p;
+
+	p = str_str(hs, "žluť");
+	PCUT_ASSERT_TRUE((const char *)p == hs + 10);
+
+	p = str_str(hs, "ň");
+	PCUT_ASSERT_TRUE((const char *)p == hs + 27);
+
+	p = str_str(hs, "kuň");
+	PCUT_ASSERT_TRUE(p == NULL);
+}
+
+PCUT_TEST(str_size_length)
+{
+	size_t off;
+
+	/* Exercise all alignments of the string start and end */
+	for (off = 0; off < 32; off++) {
+		SET_BUFFER("");
+		str_cpy(buffer + off, BUFFER_SIZE - off,
+		    "a fairly long string that spans several words");
+		PCUT_ASSERT_INT_EQUALS(45, str_size(buffer + off));
+		PCUT_ASSERT_INT_EQUALS(45 - off % 7,
+		    str_size(buffer + off + off % 7));
+		PCUT_ASSERT_INT_EQUALS(45, str_length(buffer + off));
+	}
+
+	PCUT_ASSERT_INT_EQUALS(0, str_size(""));
+	PCUT_ASSERT_INT_EQUALS(0, str_length(""));
+	PCUT_ASSERT_INT_EQUALS(35, str_size("ascii and then some šš and €€"));
+	PCUT_ASSERT_INT_EQUALS(29, str_length("ascii and then some šš and €€"));
+}
+
+PCUT_TEST(str_cmp_prefix)
+{
+	PCUT_ASSERT_INT_EQUALS(0, str_cmp("/usr/lib/libc.so", "/usr/lib/libc.so"));
+	PCUT_ASSERT_INT_EQUALS(-1, str_cmp("/usr/lib/libc.so", "/usr/lib/libd.so"));
+	PCUT_ASSERT_INT_EQUALS(1, str_cmp("/usr/lib/libc.so.1", "/usr/lib/libc.so"));
+	PCUT_ASSERT_INT_EQUALS(-1, str_cmp("/usr/lib/libc", "/usr/lib/libč"));
+	PCUT_ASSERT_INT_EQUALS(1, str_cmp("ššš€", "ššš~"));
+
+	PCUT_ASSERT_INT_EQUALS(0, str_lcmp("/usr/lib/libc.so", "/usr/lib/libd.so", 12));
+	PCUT_ASSERT_INT_EQUALS(-1, str_lcmp("/usr/lib/libc.so", "/usr/lib/libd.so", 13));
+	PCUT_ASSERT_INT_EQUALS(0, str_lcmp("ššša", "šššb", 3));
+}
+
+PCUT_TEST(str_chr_rchr)
+{
+	const char *str = "a/long/path/to/some/file/in/a/directory";
+
+	PCUT_ASSERT_TRUE(str_chr(str, '/') == str + 1);
+	PCUT_ASSERT_TRUE(str_rchr(str, '/') == str + 29);
+	PCUT_ASSERT_TRUE(str_chr(str, 'y') == str + 38);
+	PCUT_ASSERT_TRUE(str_chr(str, 'z') == NULL);
+	PCUT_ASSERT_TRUE(str_rchr(str, 'z') == NULL);
+
+	str = "cesta/k/souborům/v/adresáři";
+	PCUT_ASSERT_TRUE(str_chr(str, L'ů') == str + 14);
+	PCUT_ASSERT_TRUE(str_rchr(str, L'ř') == str + 27);
+	PCUT_ASSERT_TRUE(str_rchr(str, '/') == str + 19);
+}
+
+PCUT_TEST(str_check)
+{
+	PCUT_ASSERT_TRUE(str_check(""));
+	PCUT_ASSERT_TRUE(str_check("plain ASCII text that is long enough"));
+	PCUT_ASSERT_TRUE(str_check("příliš žluťoučký kůň € \xf0\x9f\x98\x80"));
+	PCUT_ASSERT_TRUE(str_check("\xf4\x8f\xbf\xbf"));
+
+	/* Stray continuation byte */
+	PCUT_ASSERT_FALSE(str_check("abc\x80"));
+	/* Truncated sequence */
+	PCUT_ASSERT_FALSE(str_check("abc\xc5"));
+	PCUT_ASSERT_FALSE(str_check("\xe2\x82"));
+	/* Overlong encodings */
+	PCUT_ASSERT_FALSE(str_check("\xc0\xaf"));
+	PCUT_ASSERT_FALSE(str_check("\xe0\x80\xaf"));
+	PCUT_ASSERT_FALSE(str_check("\xf0\x80\x80\xaf"));
+	/* Surrogate */
+	PCUT_ASSERT_FALSE(str_check("\xed\xa0\x80"));
+	/* Above U+10FFFF */
+	PCUT_ASSERT_FALSE(str_check("\xf4\x90\x80\x80"));
+	PCUT_ASSERT_FALSE(str_check("\xff"));
+}
+
 PCUT_EXPORT(str);
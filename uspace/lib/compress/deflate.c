@@ -0,0 +1,1171 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file
+ * @brief Implementation of deflate compression
+ *
+ * Compression into the `deflate' format as described by RFC 1951.
+ * Repeated strings are found using hash chains over a 32 KB sliding
+ * window. The lower levels emit the longest match found greedily and
+ * give up the search early, the higher levels search longer chains and
+ * use lazy matching (a match is deferred if the next position yields
+ * a longer one).
+ *
+ * The symbols are collected in blocks and each block is emitted using
+ * dynamic Huffman codes, the fixed Huffman codes or stored verbatim,
+ * whichever is the shortest.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <mem.h>
+#include "deflate.h"
+
+/** Maximum bits in the Huffman code */
+#define MAX_HUFFMAN_BIT  15
+/** Maximum bits in the code length code */
+#define MAX_CODE_BIT     7
+
+/** Number of length codes */
+#define MAX_LEN           29
+/** Number of distance codes */
+#define MAX_DIST          30
+/** Number of order codes */
+#define MAX_ORDER         19
+/** Number of literal/length codes */
+#define MAX_LITLEN        286
+/** Number of fixed literal/length codes */
+#define MAX_FIXED_LITLEN  288
+
+/** End of block symbol */
+#define END_OF_BLOCK  256
+
+/** Size of the sliding window */
+#define WINDOW_SIZE  32768
+#define WINDOW_MASK  (WINDOW_SIZE - 1)
+
+/** Shortest and longest match */
+#define MIN_MATCH  3
+#define MAX_MATCH  258
+
+/** Lookahead needed to find the longest match */
+#define MIN_LOOKAHEAD  (MAX_MATCH + MIN_MATCH + 1)
+
+/** Maximum match distance kept clear of the lookahead */
+#define MAX_WINDOW_DIST  (WINDOW_SIZE - MIN_LOOKAHEAD)
+
+/** Matches of minimal length farther than this are not worth it */
+#define TOO_FAR  4096
+
+/** Hash table of string heads */
+#define HASH_BITS  15
+#define HASH_SIZE  (1 << HASH_BITS)
+
+/** Symbols collected per block */
+#define SYMBOL_BUF_SIZE  16384
+
+/** Output buffer size */
+#define OUTPUT_BUF_SIZE  16384
+
+/** Maximal size of a stored block */
+#define MAX_STORED  65535
+
+/** Compression level parameters */
+typedef struct {
+	/** Shorten the search once a match this long is known */
+	uint16_t good_length;
+	/** Do not insert or defer longer matches */
+	uint16_t max_lazy;
+	/** Stop the search on a match this long */
+	uint16_t nice_length;
+	/** Maximal number of chain entries to examine */
+	uint16_t max_chain;
+	/** Use lazy matching */
+	bool lazy;
+} deflate_config_t;
+
+/** Parameters of the compression levels */
+static const deflate_config_t deflate_config[] = {
+	{ 0, 0, 0, 0, false },
+	{ 4, 4, 8, 4, false },
+	{ 4, 5, 16, 8, false },
+	{ 4, 6, 32, 32, false },
+	{ 4, 4, 16, 16, true },
+	{ 8, 16, 32, 32, true },
+	{ 8, 16, 128, 128, true },
+	{ 8, 32, 128, 256, true },
+	{ 32, 128, 258, 1024, true },
+	{ 32, 258, 258, 4096, true }
+};
+
+/** Huffman code used by the encoder */
+typedef struct {
+	uint16_t code[MAX_FIXED_LITLEN];   /**< Bit-reversed codes */
+	uint8_t length[MAX_FIXED_LITLEN];  /**< Code lengths */
+} huffman_code_t;
+
+/** Deflate encoder state
+ *
+ */
+struct deflate_stream {
+	deflate_write_t write;      /**< Output callback */
+	void *arg;                  /**< Output callback argument */
+	errno_t error;              /**< Sticky output error */
+	const deflate_config_t *config;  /**< Level parameters */
+	bool store;                 /**< Emit stored blocks only */
+
+	/** Sliding window (two halves and slack for word compares) */
+	uint8_t window[2 * WINDOW_SIZE + sizeof(uint64_t)];
+	size_t strstart;            /**< Current position in the window */
+	size_t lookahead;           /**< Bytes available after strstart */
+	size_t block_start;         /**< Window position of the block */
+	size_t emitted;             /**< Window position covered by symbols */
+
+	uint16_t head[HASH_SIZE];   /**< Most recent position of a hash */
+	uint16_t prev[WINDOW_SIZE]; /**< Previous position of the same hash */
+
+	size_t match_length;        /**< Match found at strstart */
+	size_t match_dist;          /**< Distance of that match */
+	bool match_available;       /**< Previous position not yet emitted */
+
+	/** Block symbols: distance 0 for literals */
+	uint16_t sym_dist[SYMBOL_BUF_SIZE];
+	/** Block symbols: literal or match length minus MIN_MATCH */
+	uint8_t sym_lit[SYMBOL_BUF_SIZE];
+	size_t sym_cnt;             /**< Number of block symbols */
+
+	uint16_t lit_freq[MAX_FIXED_LITLEN];  /**< Literal/length frequencies */
+	uint16_t dist_freq[MAX_DIST];         /**< Distance frequencies */
+
+	uint8_t len_sym[MAX_MATCH - MIN_MATCH + 1];  /**< Length to code */
+	uint8_t dist_sym[512];                       /**< Distance to code */
+
+	huffman_code_t fixed_lit;   /**< Fixed literal/length code */
+	huffman_code_t fixed_dist;  /**< Fixed distance code */
+
+	uint64_t bitbuf;            /**< Bit buffer */
+	size_t bitlen;              /**< Number of bits in the bit buffer */
+	uint8_t out[OUTPUT_BUF_SIZE];  /**< Output buffer */
+	size_t outcnt;              /**< Bytes in the output buffer */
+};
+
+/** Length codes
+ *
+ */
+static const uint16_t lens[MAX_LEN] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+/** Extended length codes
+ *
+ */
+static const uint16_t lens_ext[MAX_LEN] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+/** Distance codes
+ *
+ */
+static const uint16_t dists[MAX_DIST] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577
+};
+
+/** Extended distance codes
+ *
+ */
+static const uint16_t dists_ext[MAX_DIST] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11,
+	12, 12, 13, 13
+};
+
+/** Order codes
+ *
+ */
+static const uint8_t order[MAX_ORDER] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+/** Write out the output buffer
+ *
+ * @param state Deflate state.
+ *
+ */
+static void output_flush(deflate_stream_t *state)
+{
+	if ((state->outcnt > 0) && (state->error == EOK))
+		state->error = state->write(state->arg, state->out, state->outcnt);
+
+	state->outcnt = 0;
+}
+
+/** Append a byte to the output buffer
+ *
+ * @param state Deflate state.
+ * @param byte  Byte to append.
+ *
+ */
+static inline void output_byte(deflate_stream_t *state, uint8_t byte)
+{
+	if (state->outcnt == OUTPUT_BUF_SIZE)
+		output_flush(state);
+
+	state->out[state->outcnt] = byte;
+	state->outcnt++;
+}
+
+/** Put bits into the bit buffer
+ *
+ * @param state Deflate state.
+ * @param value Bits to put (least significant bit first).
+ * @param cnt   Number of bits (at most 32).
+ *
+ */
+static inline void put_bits(deflate_stream_t *state, uint32_t value,
+    size_t cnt)
+{
+	state->bitbuf |= ((uint64_t) value) << state->bitlen;
+	state->bitlen += cnt;
+
+	if (state->bitlen >= 32) {
+		if (state->outcnt + 4 > OUTPUT_BUF_SIZE)
+			output_flush(state);
+
+		for (size_t i = 0; i < 4; i++) {
+			state->out[state->outcnt + i] = (uint8_t) state->bitbuf;
+			state->bitbuf >>= 8;
+		}
+
+		state->outcnt += 4;
+		state->bitlen -= 32;
+	}
+}
+
+/** Pad the bit buffer to the byte boundary and write it out
+ *
+ * @param state Deflate state.
+ *
+ */
+static void put_align(deflate_stream_t *state)
+{
+	while (state->bitlen > 0) {
+		output_byte(state, (uint8_t) state->bitbuf);
+		state->bitbuf >>= 8;
+		state->bitlen = (state->bitlen > 8) ? state->bitlen - 8 : 0;
+	}
+
+	state->bitbuf = 0;
+}
+
+/** Reverse the bits of a code
+ *
+ * @param code Code to reverse.
+ * @param len  Code length.
+ *
+ * @return Reversed code.
+ *
+ */
+static uint16_t bits_reverse(uint16_t code, size_t len)
+{
+	uint16_t rev = 0;
+
+	for (size_t bit = 0; bit < len; bit++)
+		rev |= ((code >> bit) & 1) << (len - 1 - bit);
+
+	return rev;
+}
+
+/** Assign canonical codes to code lengths
+ *
+ * @param huffman Huffman code with the lengths filled in.
+ * @param n       Number of symbols.
+ *
+ */
+static void huffman_codes(huffman_code_t *huffman, size_t n)
+{
+	uint16_t count[MAX_HUFFMAN_BIT + 1];
+	uint16_t next[MAX_HUFFMAN_BIT + 1];
+	size_t len;
+
+	for (len = 0; len <= MAX_HUFFMAN_BIT; len++)
+		count[len] = 0;
+
+	for (size_t symbol = 0; symbol < n; symbol++)
+		count[huffman->length[symbol]]++;
+
+	count[0] = 0;
+
+	uint16_t code = 0;
+	for (len = 1; len <= MAX_HUFFMAN_BIT; len++) {
+		code = (code + count[len - 1]) << 1;
+		next[len] = code;
+	}
+
+	for (size_t symbol = 0; symbol < n; symbol++) {
+		len = huffman->length[symbol];
+		if (len != 0) {
+			huffman->code[symbol] = bits_reverse(next[len], len);
+			next[len]++;
+		}
+	}
+}
+
+/** Build a length-limited Huffman code
+ *
+ * The code is built by the two-queue method over the symbols
+ * sorted by frequency. If the longest code exceeds the limit,
+ * the frequencies are flattened and the code is rebuilt.
+ *
+ * At least two symbols always get a code, as some decoders reject
+ * a code with a single symbol.
+ *
+ * @param huffman Huffman code to build.
+ * @param freq    Symbol frequencies.
+ * @param n       Number of symbols.
+ * @param limit   Maximal code length.
+ *
+ */
+static void huffman_build(huffman_code_t *huffman, const uint16_t *freq,
+    size_t n, size_t limit)
+{
+	uint32_t weight[2 * MAX_FIXED_LITLEN];
+	uint16_t parent[2 * MAX_FIXED_LITLEN];
+	uint16_t depth[2 * MAX_FIXED_LITLEN];
+	uint16_t sym[MAX_FIXED_LITLEN];
+	uint32_t f[MAX_FIXED_LITLEN];
+	size_t used = 0;
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		f[i] = freq[i];
+		if (f[i] != 0)
+			used++;
+	}
+
+	for (i = 0; (used < 2) && (i < n); i++) {
+		if (f[i] == 0) {
+			f[i] = 1;
+			used++;
+		}
+	}
+
+	while (true) {
+		/* Sort the used symbols by frequency (insertion sort) */
+		size_t m = 0;
+		for (i = 0; i < n; i++) {
+			if (f[i] == 0)
+				continue;
+
+			size_t j = m;
+			while ((j > 0) && (f[sym[j - 1]] > f[i])) {
+				sym[j] = sym[j - 1];
+				j--;
+			}
+
+			sym[j] = i;
+			m++;
+		}
+
+		for (i = 0; i < m; i++)
+			weight[i] = f[sym[i]];
+
+		/*
+		 * Merge the two lightest nodes repeatedly. Both the leaves
+		 * and the merged nodes are created in the order of their
+		 * weights, so the lightest ones are at the heads of the two
+		 * queues.
+		 */
+		size_t leaf = 0;
+		size_t node = m;
+		size_t next = m;
+
+		while (next < 2 * m - 1) {
+			size_t pick[2];
+
+			for (size_t k = 0; k < 2; k++) {
+				if ((leaf < m) &&
+				    ((node == next) || (weight[leaf] <= weight[node]))) {
+					pick[k] = leaf;
+					leaf++;
+				} else {
+					pick[k] = node;
+					node++;
+				}
+			}
+
+			weight[next] = weight[pick[0]] + weight[pick[1]];
+			parent[pick[0]] = next;
+			parent[pick[1]] = next;
+			next++;
+		}
+
+		/* Parents always follow their children */
+		size_t max = 0;
+		depth[next - 1] = 0;
+		for (i = next - 1; i-- > 0;) {
+			depth[i] = depth[parent[i]] + 1;
+			if (depth[i] > max)
+				max = depth[i];
+		}
+
+		if (max <= limit) {
+			for (i = 0; i < n; i++)
+				huffman->length[i] = 0;
+
+			for (i = 0; i < m; i++)
+				huffman->length[sym[i]] = depth[i];
+
+			break;
+		}
+
+		/* Flatten the distribution and try again */
+		for (i = 0; i < n; i++) {
+			if (f[i] != 0)
+				f[i] = (f[i] >> 1) | 1;
+		}
+	}
+
+	huffman_codes(huffman, n);
+}
+
+/** Compute the size of the block symbols in a given code
+ *
+ * @param state Deflate state.
+ * @param lit   Literal/length code.
+ * @param dist  Distance code.
+ *
+ * @return Size in bits, including the extra bits and end of block.
+ *
+ */
+static size_t block_cost(deflate_stream_t *state, const huffman_code_t *lit,
+    const huffman_code_t *dist)
+{
+	size_t cost = 0;
+	size_t i;
+
+	for (i = 0; i < 256; i++)
+		cost += (size_t) state->lit_freq[i] * lit->length[i];
+
+	for (i = 0; i < MAX_LEN; i++) {
+		cost += (size_t) state->lit_freq[257 + i] *
+		    (lit->length[257 + i] + lens_ext[i]);
+	}
+
+	for (i = 0; i < MAX_DIST; i++) {
+		cost += (size_t) state->dist_freq[i] *
+		    (dist->length[i] + dists_ext[i]);
+	}
+
+	return cost + lit->length[END_OF_BLOCK];
+}
+
+/** Emit the block symbols
+ *
+ * @param state Deflate state.
+ * @param lit   Literal/length code.
+ * @param dist  Distance code.
+ *
+ */
+static void block_symbols(deflate_stream_t *state, const huffman_code_t *lit,
+    const huffman_code_t *dist)
+{
+	for (size_t i = 0; i < state->sym_cnt; i++) {
+		size_t d = state->sym_dist[i];
+		size_t lc = state->sym_lit[i];
+
+		if (d == 0) {
+			put_bits(state, lit->code[lc], lit->length[lc]);
+			continue;
+		}
+
+		size_t code = state->len_sym[lc];
+		put_bits(state, lit->code[257 + code], lit->length[257 + code]);
+		if (lens_ext[code] != 0) {
+			put_bits(state, lc + MIN_MATCH - lens[code],
+			    lens_ext[code]);
+		}
+
+		d--;
+		code = (d < 256) ? state->dist_sym[d] :
+		    state->dist_sym[256 + (d >> 7)];
+		put_bits(state, dist->code[code], dist->length[code]);
+		if (dists_ext[code] != 0)
+			put_bits(state, d + 1 - dists[code], dists_ext[code]);
+	}
+
+	put_bits(state, lit->code[END_OF_BLOCK], lit->length[END_OF_BLOCK]);
+}
+
+/** Emit the current block
+ *
+ * @param state Deflate state.
+ * @param last  This is the last block of the stream.
+ *
+ */
+static void block_flush(deflate_stream_t *state, bool last)
+{
+	huffman_code_t dyn_lit;
+	huffman_code_t dyn_dist;
+	huffman_code_t code_code;
+	uint8_t cl_sym[MAX_LITLEN + MAX_DIST];
+	uint8_t cl_ext[MAX_LITLEN + MAX_DIST];
+	uint16_t cl_freq[MAX_ORDER];
+	uint8_t length[MAX_LITLEN + MAX_DIST];
+	size_t ncl = 0;
+	size_t i;
+
+	size_t raw = state->emitted - state->block_start;
+
+	/* Stored cost: header and padding are estimated at a full byte */
+	size_t stored_cost = (raw + 5 * (raw / MAX_STORED + 1)) * 8;
+
+	size_t fixed_cost = SIZE_MAX;
+	size_t dyn_cost = SIZE_MAX;
+	size_t nlit = 0;
+	size_t ndist = 0;
+	size_t ncode = 0;
+
+	if (!state->store) {
+		state->lit_freq[END_OF_BLOCK] = 1;
+
+		fixed_cost = 3 + block_cost(state, &state->fixed_lit,
+		    &state->fixed_dist);
+
+		huffman_build(&dyn_lit, state->lit_freq, MAX_LITLEN,
+		    MAX_HUFFMAN_BIT);
+		huffman_build(&dyn_dist, state->dist_freq, MAX_DIST,
+		    MAX_HUFFMAN_BIT);
+
+		/* Trim unused trailing codes */
+		for (nlit = MAX_LITLEN; dyn_lit.length[nlit - 1] == 0; nlit--)
+			;
+		for (ndist = MAX_DIST; dyn_dist.length[ndist - 1] == 0; ndist--)
+			;
+
+		/* Run-length encode the code lengths */
+		for (i = 0; i < nlit; i++)
+			length[i] = dyn_lit.length[i];
+		for (i = 0; i < ndist; i++)
+			length[nlit + i] = dyn_dist.length[i];
+
+		for (i = 0; i < MAX_ORDER; i++)
+			cl_freq[i] = 0;
+
+		i = 0;
+		while (i < nlit + ndist) {
+			uint8_t cur = length[i];
+			size_t run = 1;
+			while ((i + run < nlit + ndist) && (length[i + run] == cur))
+				run++;
+
+			i += run;
+
+			if (cur == 0) {
+				while (run >= 11) {
+					size_t r = (run > 138) ? 138 : run;
+					cl_sym[ncl] = 18;
+					cl_ext[ncl++] = r - 11;
+					run -= r;
+				}
+
+				if (run >= 3) {
+					cl_sym[ncl] = 17;
+					cl_ext[ncl++] = run - 3;
+					run = 0;
+				}
+			} else {
+				cl_sym[ncl] = cur;
+				cl_ext[ncl++] = 0;
+				run--;
+
+				while (run >= 3) {
+					size_t r = (run > 6) ? 6 : run;
+					cl_sym[ncl] = 16;
+					cl_ext[ncl++] = r - 3;
+					run -= r;
+				}
+			}
+
+			while (run > 0) {
+				cl_sym[ncl] = cur;
+				cl_ext[ncl++] = 0;
+				run--;
+			}
+		}
+
+		for (i = 0; i < ncl; i++)
+			cl_freq[cl_sym[i]]++;
+
+		huffman_build(&code_code, cl_freq, MAX_ORDER, MAX_CODE_BIT);
+
+		for (ncode = MAX_ORDER;
+		    (ncode > 4) && (code_code.length[order[ncode - 1]] == 0);
+		    ncode--)
+			;
+
+		dyn_cost = 3 + 14 + 3 * ncode +
+		    block_cost(state, &dyn_lit, &dyn_dist);
+
+		for (i = 0; i < ncl; i++) {
+			dyn_cost += code_code.length[cl_sym[i]];
+			if (cl_sym[i] == 16)
+				dyn_cost += 2;
+			else if (cl_sym[i] == 17)
+				dyn_cost += 3;
+			else if (cl_sym[i] == 18)
+				dyn_cost += 7;
+		}
+	}
+
+	if ((stored_cost <= fixed_cost) && (stored_cost <= dyn_cost)) {
+		const uint8_t *data = state->window + state->block_start;
+
+		do {
+			size_t len = (raw > MAX_STORED) ? MAX_STORED : raw;
+			bool final = last && (len == raw);
+
+			put_bits(state, final ? 1 : 0, 3);
+			put_align(state);
+
+			output_byte(state, len & 0xff);
+			output_byte(state, len >> 8);
+			output_byte(state, ~len & 0xff);
+			output_byte(state, (~len >> 8) & 0xff);
+
+			while (len > 0) {
+				if (state->outcnt == OUTPUT_BUF_SIZE)
+					output_flush(state);
+
+				size_t chunk = OUTPUT_BUF_SIZE - state->outcnt;
+				if (chunk > len)
+					chunk = len;
+
+				memcpy(state->out + state->outcnt, data, chunk);
+				state->outcnt += chunk;
+				data += chunk;
+				raw -= chunk;
+				len -= chunk;
+			}
+		} while (raw > 0);
+	} else if (fixed_cost <= dyn_cost) {
+		put_bits(state, (last ? 1 : 0) | (1 << 1), 3);
+		block_symbols(state, &state->fixed_lit, &state->fixed_dist);
+	} else {
+		put_bits(state, (last ? 1 : 0) | (2 << 1), 3);
+		put_bits(state, nlit - 257, 5);
+		put_bits(state, ndist - 1, 5);
+		put_bits(state, ncode - 4, 4);
+
+		for (i = 0; i < ncode; i++)
+			put_bits(state, code_code.length[order[i]], 3);
+
+		for (i = 0; i < ncl; i++) {
+			put_bits(state, code_code.code[cl_sym[i]],
+			    code_code.length[cl_sym[i]]);
+
+			if (cl_sym[i] == 16)
+				put_bits(state, cl_ext[i], 2);
+			else if (cl_sym[i] == 17)
+				put_bits(state, cl_ext[i], 3);
+			else if (cl_sym[i] == 18)
+				put_bits(state, cl_ext[i], 7);
+		}
+
+		block_symbols(state, &dyn_lit, &dyn_dist);
+	}
+
+	/* Start a new block */
+	state->block_start = state->emitted;
+	state->sym_cnt = 0;
+	memset(state->lit_freq, 0, sizeof(state->lit_freq));
+	memset(state->dist_freq, 0, sizeof(state->dist_freq));
+}
+
+/** Record a literal
+ *
+ * @param state Deflate state.
+ * @param lit   Literal byte.
+ *
+ */
+static inline void tally_literal(deflate_stream_t *state, uint8_t lit)
+{
+	state->sym_dist[state->sym_cnt] = 0;
+	state->sym_lit[state->sym_cnt] = lit;
+	state->sym_cnt++;
+	state->lit_freq[lit]++;
+	state->emitted++;
+
+	if (state->sym_cnt == SYMBOL_BUF_SIZE)
+		block_flush(state, false);
+}
+
+/** Record a match
+ *
+ * @param state Deflate state.
+ * @param dist  Match distance.
+ * @param len   Match length.
+ *
+ */
+static inline void tally_match(deflate_stream_t *state, size_t dist,
+    size_t len)
+{
+	state->sym_dist[state->sym_cnt] = dist;
+	state->sym_lit[state->sym_cnt] = len - MIN_MATCH;
+	state->sym_cnt++;
+	state->lit_freq[257 + state->len_sym[len - MIN_MATCH]]++;
+
+	dist--;
+	state->dist_freq[(dist < 256) ? state->dist_sym[dist] :
+	    state->dist_sym[256 + (dist >> 7)]]++;
+	state->emitted += len;
+
+	if (state->sym_cnt == SYMBOL_BUF_SIZE)
+		block_flush(state, false);
+}
+
+/** Insert a string into the hash chains
+ *
+ * @param state Deflate state.
+ * @param pos   Window position of the string.
+ *
+ * @return Previous head of the hash chain (0 if none).
+ *
+ */
+static inline size_t insert_string(deflate_stream_t *state, size_t pos)
+{
+	const uint8_t *p = state->window + pos;
+	uint32_t key = p[0] | (p[1] << 8) | (p[2] << 16);
+	size_t hash = (key * UINT32_C(0x9e3779b1)) >> (32 - HASH_BITS);
+
+	size_t head = state->head[hash];
+	state->prev[pos & WINDOW_MASK] = head;
+	state->head[hash] = pos;
+
+	return head;
+}
+
+/** Find the length of the common prefix of two strings
+ *
+ * @param scan  First string.
+ * @param match Second string.
+ * @param limit Maximal length to compare.
+ *
+ * @return Length of the common prefix (may exceed limit by less
+ *         than a word).
+ *
+ */
+static inline size_t match_length(const uint8_t *scan, const uint8_t *match,
+    size_t limit)
+{
+	size_t len = 0;
+
+	while (len < limit) {
+		uint64_t a;
+		uint64_t b;
+
+		memcpy(&a, scan + len, sizeof(a));
+		memcpy(&b, match + len, sizeof(b));
+
+		uint64_t diff = a ^ b;
+		if (diff != 0) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+			return len + (__builtin_ctzll(diff) >> 3);
+#else
+			return len + (__builtin_clzll(diff) >> 3);
+#endif
+		}
+
+		len += sizeof(uint64_t);
+	}
+
+	return len;
+}
+
+/** Find the longest match for the current position
+ *
+ * @param state    Deflate state.
+ * @param cur      Head of the hash chain.
+ * @param best_len Length to beat.
+ * @param rdist    Place to store the distance of a longer match.
+ *
+ * @return Length of the longest match (best_len if none was longer).
+ *
+ */
+static size_t longest_match(deflate_stream_t *state, size_t cur,
+    size_t best_len, size_t *rdist)
+{
+	const deflate_config_t *config = state->config;
+	const uint8_t *scan = state->window + state->strstart;
+	size_t chain = config->max_chain;
+	size_t limit = (state->strstart > MAX_WINDOW_DIST) ?
+	    state->strstart - MAX_WINDOW_DIST : 0;
+
+	size_t max_len = (state->lookahead < MAX_MATCH) ?
+	    state->lookahead : MAX_MATCH;
+	size_t nice = config->nice_length;
+	if (nice > max_len)
+		nice = max_len;
+
+	/* Nothing longer can be found */
+	if (best_len >= max_len)
+		return best_len;
+
+	if (best_len >= config->good_length)
+		chain >>= 2;
+
+	do {
+		const uint8_t *match = state->window + cur;
+
+		/* Quick rejection before the full comparison */
+		if ((match[best_len] != scan[best_len]) ||
+		    (match[0] != scan[0]) || (match[1] != scan[1]))
+			continue;
+
+		size_t len = match_length(scan, match, max_len);
+		if (len > max_len)
+			len = max_len;
+
+		if (len > best_len) {
+			*rdist = state->strstart - cur;
+			best_len = len;
+			if (len >= nice)
+				break;
+		}
+	} while (((cur = state->prev[cur & WINDOW_MASK]) > limit) &&
+	    (--chain != 0));
+
+	return best_len;
+}
+
+/** Compress using greedy matching
+ *
+ * @param state Deflate state.
+ * @param flush Process all the input (not just up to the lookahead).
+ *
+ */
+static void deflate_fast(deflate_stream_t *state, bool flush)
+{
+	size_t min_lookahead = flush ? 1 : MIN_LOOKAHEAD;
+
+	while (state->lookahead >= min_lookahead) {
+		size_t head = 0;
+		if (state->lookahead >= MIN_MATCH)
+			head = insert_string(state, state->strstart);
+
+		size_t len = 0;
+		size_t dist = 0;
+		if ((head != 0) && (state->strstart - head <= MAX_WINDOW_DIST))
+			len = longest_match(state, head, MIN_MATCH - 1, &dist);
+
+		if (len >= MIN_MATCH) {
+			tally_match(state, dist, len);
+			state->lookahead -= len;
+
+			if ((len <= state->config->max_lazy) &&
+			    (state->lookahead >= MIN_MATCH)) {
+				/* Insert the strings covered by the match */
+				while (--len != 0) {
+					state->strstart++;
+					insert_string(state, state->strstart);
+				}
+
+				state->strstart++;
+			} else {
+				state->strstart += len;
+			}
+		} else {
+			tally_literal(state, state->window[state->strstart]);
+			state->strstart++;
+			state->lookahead--;
+		}
+	}
+}
+
+/** Compress using lazy matching
+ *
+ * @param state Deflate state.
+ * @param flush Process all the input (not just up to the lookahead).
+ *
+ */
+static void deflate_lazy(deflate_stream_t *state, bool flush)
+{
+	size_t min_lookahead = flush ? 1 : MIN_LOOKAHEAD;
+
+	while (state->lookahead >= min_lookahead) {
+		size_t head = 0;
+		if (state->lookahead >= MIN_MATCH)
+			head = insert_string(state, state->strstart);
+
+		size_t prev_length = state->match_length;
+		size_t prev_dist = state->match_dist;
+		state->match_length = MIN_MATCH - 1;
+
+		if ((head != 0) && (prev_length < state->config->max_lazy) &&
+		    (state->strstart - head <= MAX_WINDOW_DIST)) {
+			state->match_length = longest_match(state, head,
+			    prev_length > MIN_MATCH - 1 ? prev_length : MIN_MATCH - 1,
+			    &state->match_dist);
+
+			if ((state->match_length <= prev_length) ||
+			    ((state->match_length == MIN_MATCH) &&
+			    (state->match_dist > TOO_FAR)))
+				state->match_length = MIN_MATCH - 1;
+		}
+
+		if ((prev_length >= MIN_MATCH) &&
+		    (state->match_length <= prev_length)) {
+			/* The match at the previous position wins */
+			size_t max_insert = state->strstart + state->lookahead -
+			    MIN_MATCH;
+
+			tally_match(state, prev_dist, prev_length);
+
+			/*
+			 * Insert the strings covered by the match, the first
+			 * two of them have been inserted already.
+			 */
+			state->lookahead -= prev_length - 1;
+			prev_length -= 2;
+			while (prev_length-- > 0) {
+				state->strstart++;
+				if (state->strstart <= max_insert)
+					insert_string(state, state->strstart);
+			}
+
+			state->match_available = false;
+			state->match_length = MIN_MATCH - 1;
+			state->strstart++;
+		} else if (state->match_available) {
+			/* Emit the previous position as a literal */
+			tally_literal(state, state->window[state->strstart - 1]);
+			state->strstart++;
+			state->lookahead--;
+		} else {
+			/* Defer the decision to the next position */
+			state->match_available = true;
+			state->strstart++;
+			state->lookahead--;
+		}
+	}
+
+	if (flush && state->match_available) {
+		tally_literal(state, state->window[state->strstart - 1]);
+		state->match_available = false;
+	}
+}
+
+/** Compress the data in the window
+ *
+ * @param state Deflate state.
+ * @param flush Process all the input (not just up to the lookahead).
+ *
+ */
+static void deflate_process(deflate_stream_t *state, bool flush)
+{
+	if (state->store) {
+		state->strstart += state->lookahead;
+		state->emitted = state->strstart;
+		state->lookahead = 0;
+	} else if (state->config->lazy) {
+		deflate_lazy(state, flush);
+	} else {
+		deflate_fast(state, flush);
+	}
+}
+
+/** Slide the window by its half
+ *
+ * @param state Deflate state.
+ *
+ */
+static void window_slide(deflate_stream_t *state)
+{
+	/* The block must not refer to the data being discarded */
+	block_flush(state, false);
+
+	memcpy(state->window, state->window + WINDOW_SIZE, WINDOW_SIZE);
+	state->strstart -= WINDOW_SIZE;
+	state->block_start -= WINDOW_SIZE;
+	state->emitted -= WINDOW_SIZE;
+
+	for (size_t i = 0; i < HASH_SIZE; i++) {
+		state->head[i] = (state->head[i] >= WINDOW_SIZE) ?
+		    state->head[i] - WINDOW_SIZE : 0;
+	}
+
+	for (size_t i = 0; i < WINDOW_SIZE; i++) {
+		state->prev[i] = (state->prev[i] >= WINDOW_SIZE) ?
+		    state->prev[i] - WINDOW_SIZE : 0;
+	}
+}
+
+/** Create a streaming encoder
+ *
+ * @param level  Compression level (DEFLATE_LEVEL_STORE to
+ *               DEFLATE_LEVEL_BEST).
+ * @param write  Output callback.
+ * @param arg    Output callback argument.
+ * @param rstate Place to store the new encoder.
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t deflate_stream_create(unsigned level, deflate_write_t write,
+    void *arg, deflate_stream_t **rstate)
+{
+	if (level > DEFLATE_LEVEL_BEST)
+		return EINVAL;
+
+	deflate_stream_t *state = calloc(1, sizeof(deflate_stream_t));
+	if (state == NULL)
+		return ENOMEM;
+
+	state->write = write;
+	state->arg = arg;
+	state->error = EOK;
+	state->config = &deflate_config[level];
+	state->store = (level == DEFLATE_LEVEL_STORE);
+	state->match_length = MIN_MATCH - 1;
+
+	/* Map lengths and distances to their codes */
+	size_t code;
+	for (code = 0; code < MAX_LEN; code++) {
+		size_t end = (code + 1 < MAX_LEN) ? lens[code + 1] : MAX_MATCH + 1;
+		for (size_t len = lens[code]; len < end; len++)
+			state->len_sym[len - MIN_MATCH] = code;
+	}
+
+	for (code = 0; code < MAX_DIST; code++) {
+		size_t end = (code + 1 < MAX_DIST) ? dists[code + 1] :
+		    WINDOW_SIZE + 1;
+		for (size_t dist = dists[code]; dist < end; dist++) {
+			if (dist <= 256)
+				state->dist_sym[dist - 1] = code;
+			else
+				state->dist_sym[256 + ((dist - 1) >> 7)] = code;
+		}
+	}
+
+	/* Fixed Huffman codes */
+	size_t symbol;
+	for (symbol = 0; symbol < 144; symbol++)
+		state->fixed_lit.length[symbol] = 8;
+	for (; symbol < 256; symbol++)
+		state->fixed_lit.length[symbol] = 9;
+	for (; symbol < 280; symbol++)
+		state->fixed_lit.length[symbol] = 7;
+	for (; symbol < MAX_FIXED_LITLEN; symbol++)
+		state->fixed_lit.length[symbol] = 8;
+
+	huffman_codes(&state->fixed_lit, MAX_FIXED_LITLEN);
+
+	for (symbol = 0; symbol < MAX_DIST; symbol++)
+		state->fixed_dist.length[symbol] = 5;
+
+	huffman_codes(&state->fixed_dist, MAX_DIST);
+
+	*rstate = state;
+	return EOK;
+}
+
+/** Compress data
+ *
+ * @param state Streaming encoder.
+ * @param data  Data to compress.
+ * @param size  Size of the data (bytes).
+ *
+ * @return EOK on success.
+ * @return Error code returned by the output callback.
+ *
+ */
+errno_t deflate_stream_write(deflate_stream_t *state, const void *data,
+    size_t size)
+{
+	const uint8_t *dp = (const uint8_t *) data;
+
+	while ((size > 0) && (state->error == EOK)) {
+		size_t end = state->strstart + state->lookahead;
+		if (end == 2 * WINDOW_SIZE) {
+			window_slide(state);
+			end -= WINDOW_SIZE;
+		}
+
+		size_t len = 2 * WINDOW_SIZE - end;
+		if (len > size)
+			len = size;
+
+		memcpy(state->window + end, dp, len);
+		state->lookahead += len;
+		dp += len;
+		size -= len;
+
+		deflate_process(state, false);
+	}
+
+	return state->error;
+}
+
+/** Finish the compressed stream
+ *
+ * Compress the remaining data and emit the last block. No more
+ * data can be written afterwards.
+ *
+ * @param state Streaming encoder.
+ *
+ * @return EOK on success.
+ * @return Error code returned by the output callback.
+ *
+ */
+errno_t deflate_stream_finish(deflate_stream_t *state)
+{
+	deflate_process(state, true);
+	block_flush(state, true);
+	put_align(state);
+	output_flush(state);
+
+	return state->error;
+}
+
+/** Destroy a streaming encoder
+ *
+ * @param state Streaming encoder.
+ *
+ */
+void deflate_stream_destroy(deflate_stream_t *state)
+{
+	free(state);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCOMPRESS_DEFLATE_H_
+#define LIBCOMPRESS_DEFLATE_H_
+
+#include <errno.h>
+#include <stddef.h>
+
+/** No compression, stored blocks only */
+#define DEFLATE_LEVEL_STORE    0
+/** Fastest compression */
+#define DEFLATE_LEVEL_FAST     1
+/** Default trade-off between speed and compression ratio */
+#define DEFLATE_LEVEL_DEFAULT  6
+/** Best compression */
+#define DEFLATE_LEVEL_BEST     9
+
+/** Output callback of a streaming encoder
+ *
+ * @param arg  Callback argument.
+ * @param buf  Compressed data.
+ * @param size Size of the data (bytes).
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+typedef errno_t (*deflate_write_t)(void *, const void *, size_t);
+
+typedef struct deflate_stream deflate_stream_t;
+
+extern errno_t deflate_stream_create(unsigned, deflate_write_t, void *,
+    deflate_stream_t **);
+extern errno_t deflate_stream_write(deflate_stream_t *, const void *, size_t);
+extern errno_t deflate_stream_finish(deflate_stream_t *);
+extern void deflate_stream_destroy(deflate_stream_t *);
+
+#endif
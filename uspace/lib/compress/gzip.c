@@ -28,12 +28,15 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include <errno.h>
 #include <mem.h>
 #include <byteorder.h>
 #include <stdlib.h>
+#include <adt/checksum.h>
 #include "gzip.h"
 #include "inflate.h"
+#include "deflate.h"
 
 #define GZIP_ID1  UINT8_C(0x1f)
 #define GZIP_ID2  UINT8_C(0x8b)
@@ -46,6 +49,11 @@
 #define GZIP_FLAG_FNAME     UINT8_C(1 << 3)
 #define GZIP_FLAG_FCOMMENT  UINT8_C(1 << 4)
 
+#define GZIP_XFL_BEST     UINT8_C(2)
+#define GZIP_XFL_FASTEST  UINT8_C(4)
+
+#define GZIP_OS_UNKNOWN  UINT8_C(255)
+
 typedef struct {
 	uint8_t id1;
 	uint8_t id2;
@@ -69,7 +77,8 @@ typedef struct {
  * data to 4 GiB (expanding input streams that actually
  * encode more data will always fail).
  *
- * So far, no CRC is perfomed.
+ * The CRC and the size of the uncompressed data
+ * are verified.
  *
  * @param[in]  src     Source data buffer.
  * @param[in]  srclen  Source buffer size (bytes).
@@ -79,7 +88,8 @@ typedef struct {
  * @return EOK on success.
  * @return ENOENT on distance too large.
  * @return EINVAL on invalid Huffman code, invalid deflate data,
- *                   invalid compression method or invalid stream.
+ *                   invalid compression method, invalid stream
+ *                   or CRC mismatch.
  * @return ELIMIT on input buffer overrun.
  * @return ENOMEM on output buffer overrun.
  *
@@ -174,10 +184,517 @@ errno_t gzip_expand(void *src, size_t srclen, void **dest, size_t *destlen)
 		return ENOMEM;
 
 	errno_t ret = inflate(stream, stream_length, *dest, *destlen);
+	if ((ret == EOK) &&
+	    (compute_crc32(*dest, *destlen) != uint32_t_le2host(footer.crc32)))
+		ret = EINVAL;
+
 	if (ret != EOK) {
-		free(dest);
+		free(*dest);
+		*dest = NULL;
 		return ret;
 	}
 
 	return EOK;
 }
+
+/** Streaming GZIP decoder */
+struct gzip_reader {
+	inflate_read_t read;        /**< Input callback */
+	void *arg;                  /**< Input callback argument */
+	inflate_stream_t *inflate;  /**< Decoder of the deflate stream */
+	uint32_t crc32;             /**< CRC of the data read so far */
+	uint32_t size;              /**< Size of the data read so far */
+	bool done;                  /**< Footer verified */
+};
+
+/** Read exactly the given amount of input
+ *
+ * @param reader GZIP reader.
+ * @param buf    Buffer for the data.
+ * @param size   Number of bytes to read.
+ *
+ * @return EOK on success.
+ * @return ELIMIT on truncated input.
+ * @return Error code returned by the input callback.
+ *
+ */
+static errno_t gzip_read_exact(gzip_reader_t *reader, void *buf, size_t size)
+{
+	uint8_t *bp = (uint8_t *) buf;
+
+	/* Input following a member may already be buffered by the decoder */
+	if (reader->inflate != NULL)
+		return inflate_stream_trailer(reader->inflate, buf, size);
+
+	while (size > 0) {
+		size_t nread;
+		errno_t rc = reader->read(reader->arg, bp, size, &nread);
+		if (rc != EOK)
+			return rc;
+
+		if (nread == 0)
+			return ELIMIT;
+
+		bp += nread;
+		size -= nread;
+	}
+
+	return EOK;
+}
+
+/** Skip a zero-terminated header field
+ *
+ * @param reader GZIP reader.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t gzip_skip_string(gzip_reader_t *reader)
+{
+	uint8_t c;
+
+	do {
+		errno_t rc = gzip_read_exact(reader, &c, sizeof(c));
+		if (rc != EOK)
+			return rc;
+	} while (c != 0);
+
+	return EOK;
+}
+
+/** Read and check the GZIP header
+ *
+ * @param reader GZIP reader.
+ * @param end    If not NULL, the input may end instead of the header.
+ *               True is stored here in that case. Like GNU gzip, we
+ *               also treat trailing bytes that do not start with the
+ *               GZIP magic (e.g. zero padding) as the end of input.
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression method or invalid stream.
+ * @return ELIMIT on truncated input.
+ * @return Error code returned by the input callback.
+ *
+ */
+static errno_t gzip_read_header(gzip_reader_t *reader, bool *end)
+{
+	gzip_header_t header;
+	errno_t rc = gzip_read_exact(reader, &header.id1, sizeof(header.id1));
+	if ((rc == EOK) && (header.id1 == GZIP_ID1))
+		rc = gzip_read_exact(reader, &header.id2, sizeof(header.id2));
+
+	if ((end != NULL) && ((rc == ELIMIT) || ((rc == EOK) &&
+	    ((header.id1 != GZIP_ID1) || (header.id2 != GZIP_ID2))))) {
+		*end = true;
+		return EOK;
+	}
+
+	if (rc != EOK)
+		return rc;
+
+	if (end != NULL)
+		*end = false;
+
+	rc = gzip_read_exact(reader, &header.method,
+	    sizeof(header) - offsetof(gzip_header_t, method));
+	if (rc != EOK)
+		return rc;
+
+	if ((header.id1 != GZIP_ID1) ||
+	    (header.id2 != GZIP_ID2) ||
+	    (header.method != GZIP_METHOD_DEFLATE) ||
+	    ((header.flags & (~GZIP_FLAGS_MASK)) != 0))
+		return EINVAL;
+
+	/* Ignore extra metadata */
+
+	if ((header.flags & GZIP_FLAG_FEXTRA) != 0) {
+		uint16_t extra_length;
+		rc = gzip_read_exact(reader, &extra_length, sizeof(extra_length));
+		if (rc != EOK)
+			return rc;
+
+		extra_length = uint16_t_le2host(extra_length);
+		while (extra_length > 0) {
+			uint8_t skip[64];
+			size_t len = (extra_length > sizeof(skip)) ?
+			    sizeof(skip) : extra_length;
+
+			rc = gzip_read_exact(reader, skip, len);
+			if (rc != EOK)
+				return rc;
+
+			extra_length -= len;
+		}
+	}
+
+	if ((header.flags & GZIP_FLAG_FNAME) != 0) {
+		rc = gzip_skip_string(reader);
+		if (rc != EOK)
+			return rc;
+	}
+
+	if ((header.flags & GZIP_FLAG_FCOMMENT) != 0) {
+		rc = gzip_skip_string(reader);
+		if (rc != EOK)
+			return rc;
+	}
+
+	if ((header.flags & GZIP_FLAG_FHCRC) != 0) {
+		uint16_t hcrc;
+		rc = gzip_read_exact(reader, &hcrc, sizeof(hcrc));
+		if (rc != EOK)
+			return rc;
+	}
+
+	return EOK;
+}
+
+/** Create a streaming GZIP decoder
+ *
+ * The GZIP header is read and checked right away, the compressed
+ * data are then pulled in using the input callback as needed.
+ * Several concatenated GZIP members are decoded as a single stream.
+ *
+ * @param read    Input callback.
+ * @param arg     Input callback argument.
+ * @param rreader Place to store the new reader.
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression method or invalid stream.
+ * @return ELIMIT on truncated input.
+ * @return ENOMEM if out of memory.
+ * @return Error code returned by the input callback.
+ *
+ */
+errno_t gzip_reader_create(inflate_read_t read, void *arg,
+    gzip_reader_t **rreader)
+{
+	gzip_reader_t *reader = calloc(1, sizeof(gzip_reader_t));
+	if (reader == NULL)
+		return ENOMEM;
+
+	reader->read = read;
+	reader->arg = arg;
+
+	errno_t rc = gzip_read_header(reader, NULL);
+	if (rc == EOK)
+		rc = inflate_stream_create(read, arg, &reader->inflate);
+
+	if (rc != EOK) {
+		free(reader);
+		return rc;
+	}
+
+	*rreader = reader;
+	return EOK;
+}
+
+/** Finish a GZIP member
+ *
+ * Verify the footer of the member that has just been decoded and
+ * start decoding the next member if there is any.
+ *
+ * @param reader GZIP reader.
+ *
+ * @return EOK on success.
+ * @return EINVAL on CRC mismatch or invalid next member.
+ * @return ELIMIT on truncated input.
+ * @return Error code returned by the input callback.
+ *
+ */
+static errno_t gzip_next_member(gzip_reader_t *reader)
+{
+	gzip_footer_t footer;
+	errno_t rc = gzip_read_exact(reader, &footer, sizeof(footer));
+	if (rc != EOK)
+		return rc;
+
+	if ((uint32_t_le2host(footer.crc32) != reader->crc32) ||
+	    (uint32_t_le2host(footer.size) != reader->size))
+		return EINVAL;
+
+	reader->crc32 = 0;
+	reader->size = 0;
+
+	rc = gzip_read_header(reader, &reader->done);
+	if ((rc != EOK) || (reader->done))
+		return rc;
+
+	return inflate_stream_restart(reader->inflate);
+}
+
+/** Read decompressed data from a streaming GZIP decoder
+ *
+ * The CRC and the size of the data are verified at the end
+ * of each GZIP member.
+ *
+ * @param reader GZIP reader.
+ * @param buf    Buffer for the decompressed data.
+ * @param size   Size of the buffer (bytes).
+ * @param nread  Place to store the number of bytes read. Fewer than
+ *               size bytes are returned only at the end of the data.
+ *
+ * @return EOK on success.
+ * @return ENOENT on distance too large.
+ * @return EINVAL on invalid Huffman code, invalid deflate data,
+ *                CRC mismatch or invalid GZIP member.
+ * @return ELIMIT on truncated input.
+ * @return Error code returned by the input callback.
+ *
+ */
+errno_t gzip_reader_read(gzip_reader_t *reader, void *buf, size_t size,
+    size_t *nread)
+{
+	uint8_t *bp = (uint8_t *) buf;
+	size_t done = 0;
+	errno_t rc = EOK;
+
+	while ((done < size) && (!reader->done)) {
+		size_t len;
+		rc = inflate_stream_read(reader->inflate, bp + done,
+		    size - done, &len);
+		if (rc != EOK)
+			break;
+
+		reader->crc32 = compute_crc32_seed(bp + done, len,
+		    reader->crc32);
+		reader->size += len;
+		done += len;
+
+		if (done < size) {
+			/* End of the member */
+			rc = gzip_next_member(reader);
+			if (rc != EOK)
+				break;
+		}
+	}
+
+	*nread = done;
+	return rc;
+}
+
+/** Destroy a streaming GZIP decoder
+ *
+ * @param reader GZIP reader.
+ *
+ */
+void gzip_reader_destroy(gzip_reader_t *reader)
+{
+	if (reader == NULL)
+		return;
+
+	inflate_stream_destroy(reader->inflate);
+	free(reader);
+}
+
+/** Streaming GZIP encoder */
+struct gzip_writer {
+	deflate_write_t write;      /**< Output callback */
+	void *arg;                  /**< Output callback argument */
+	deflate_stream_t *deflate;  /**< Encoder of the deflate stream */
+	uint32_t crc32;             /**< CRC of the data written so far */
+	uint32_t size;              /**< Size of the data written so far */
+};
+
+/** Create a streaming GZIP encoder
+ *
+ * @param level   Compression level (DEFLATE_LEVEL_STORE to
+ *                DEFLATE_LEVEL_BEST).
+ * @param write   Output callback.
+ * @param arg     Output callback argument.
+ * @param rwriter Place to store the new writer.
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ * @return Error code returned by the output callback.
+ *
+ */
+errno_t gzip_writer_create(unsigned level, deflate_write_t write, void *arg,
+    gzip_writer_t **rwriter)
+{
+	gzip_writer_t *writer = calloc(1, sizeof(gzip_writer_t));
+	if (writer == NULL)
+		return ENOMEM;
+
+	writer->write = write;
+	writer->arg = arg;
+
+	errno_t rc = deflate_stream_create(level, write, arg, &writer->deflate);
+	if (rc != EOK) {
+		free(writer);
+		return rc;
+	}
+
+	gzip_header_t header;
+
+	header.id1 = GZIP_ID1;
+	header.id2 = GZIP_ID2;
+	header.method = GZIP_METHOD_DEFLATE;
+	header.flags = 0;
+	header.mtime = 0;
+	header.os = GZIP_OS_UNKNOWN;
+
+	if (level == DEFLATE_LEVEL_BEST)
+		header.extra_flags = GZIP_XFL_BEST;
+	else if (level == DEFLATE_LEVEL_FAST)
+		header.extra_flags = GZIP_XFL_FASTEST;
+	else
+		header.extra_flags = 0;
+
+	rc = write(arg, &header, sizeof(header));
+	if (rc != EOK) {
+		gzip_writer_destroy(writer);
+		return rc;
+	}
+
+	*rwriter = writer;
+	return EOK;
+}
+
+/** Compress data into a GZIP stream
+ *
+ * @param writer GZIP writer.
+ * @param data   Data to compress.
+ * @param size   Size of the data (bytes).
+ *
+ * @return EOK on success.
+ * @return Error code returned by the output callback.
+ *
+ */
+errno_t gzip_writer_write(gzip_writer_t *writer, const void *data,
+    size_t size)
+{
+	writer->crc32 = compute_crc32_seed((uint8_t *) data, size,
+	    writer->crc32);
+	writer->size += size;
+
+	return deflate_stream_write(writer->deflate, data, size);
+}
+
+/** Finish a GZIP stream
+ *
+ * Emit the rest of the compressed data and the GZIP footer.
+ *
+ * @param writer GZIP writer.
+ *
+ * @return EOK on success.
+ * @return Error code returned by the output callback.
+ *
+ */
+errno_t gzip_writer_finish(gzip_writer_t *writer)
+{
+	errno_t rc = deflate_stream_finish(writer->deflate);
+	if (rc != EOK)
+		return rc;
+
+	gzip_footer_t footer;
+
+	footer.crc32 = host2uint32_t_le(writer->crc32);
+	footer.size = host2uint32_t_le(writer->size);
+
+	return writer->write(writer->arg, &footer, sizeof(footer));
+}
+
+/** Destroy a streaming GZIP encoder
+ *
+ * @param writer GZIP writer.
+ *
+ */
+void gzip_writer_destroy(gzip_writer_t *writer)
+{
+	if (writer == NULL)
+		return;
+
+	deflate_stream_destroy(writer->deflate);
+	free(writer);
+}
+
+/** Growing output buffer of gzip_compress() */
+typedef struct {
+	uint8_t *data;  /**< Buffer */
+	size_t size;    /**< Bytes used */
+	size_t alloc;   /**< Bytes allocated */
+} gzip_buffer_t;
+
+/** Append compressed data to a growing buffer
+ *
+ * @param arg  Growing buffer.
+ * @param data Compressed data.
+ * @param size Size of the data (bytes).
+ *
+ * @return EOK on success.
+ * @return ENOMEM if out of memory.
+ *
+ */
+static errno_t gzip_buffer_write(void *arg, const void *data, size_t size)
+{
+	gzip_buffer_t *buffer = (gzip_buffer_t *) arg;
+
+	if (buffer->size + size > buffer->alloc) {
+		size_t alloc = 2 * buffer->alloc;
+		if (alloc < buffer->size + size)
+			alloc = buffer->size + size;
+
+		uint8_t *ndata = realloc(buffer->data, alloc);
+		if (ndata == NULL)
+			return ENOMEM;
+
+		buffer->data = ndata;
+		buffer->alloc = alloc;
+	}
+
+	memcpy(buffer->data + buffer->size, data, size);
+	buffer->size += size;
+
+	return EOK;
+}
+
+/** Compress data into GZIP format
+ *
+ * The routine allocates the output buffer.
+ *
+ * @param[in]  src     Source data buffer.
+ * @param[in]  srclen  Source buffer size (bytes).
+ * @param[in]  level   Compression level (DEFLATE_LEVEL_STORE to
+ *                     DEFLATE_LEVEL_BEST).
+ * @param[out] dest    Destination data buffer.
+ * @param[out] destlen Destination buffer size (bytes).
+ *
+ * @return EOK on success.
+ * @return EINVAL on invalid compression level.
+ * @return ENOMEM if out of memory.
+ *
+ */
+errno_t gzip_compress(void *src, size_t srclen, unsigned level, void **dest,
+    size_t *destlen)
+{
+	gzip_buffer_t buffer;
+	gzip_writer_t *writer;
+
+	buffer.alloc = srclen / 2 + 64;
+	buffer.size = 0;
+	buffer.data = malloc(buffer.alloc);
+	if (buffer.data == NULL)
+		return ENOMEM;
+
+	errno_t rc = gzip_writer_create(level, gzip_buffer_write, &buffer,
+	    &writer);
+	if (rc == EOK) {
+		rc = gzip_writer_write(writer, src, srclen);
+		if (rc == EOK)
+			rc = gzip_writer_finish(writer);
+
+		gzip_writer_destroy(writer);
+	}
+
+	if (rc != EOK) {
+		free(buffer.data);
+		return rc;
+	}
+
+	*dest = buffer.data;
+	*destlen = buffer.size;
+	return EOK;
+}
@@ -29,8 +29,25 @@
 #ifndef LIBCOMPRESS_GZIP_H_
 #define LIBCOMPRESS_GZIP_H_
 
+#include <errno.h>
 #include <stddef.h>
+#include "inflate.h"
+#include "deflate.h"
+
+typedef struct gzip_reader gzip_reader_t;
+typedef struct gzip_writer gzip_writer_t;
 
 extern errno_t gzip_expand(void *, size_t, void **, size_t *);
+extern errno_t gzip_compress(void *, size_t, unsigned, void **, size_t *);
+
+extern errno_t gzip_reader_create(inflate_read_t, void *, gzip_reader_t **);
+extern errno_t gzip_reader_read(gzip_reader_t *, void *, size_t, size_t *);
+extern void gzip_reader_destroy(gzip_reader_t *);
+
+extern errno_t gzip_writer_create(unsigned, deflate_write_t, void *,
+    gzip_writer_t **);
+extern errno_t gzip_writer_write(gzip_writer_t *, const void *, size_t);
+extern errno_t gzip_writer_finish(gzip_writer_t *);
+extern void gzip_writer_destroy(gzip_writer_t *);
 
 #endif
@@ -29,8 +29,32 @@
 #ifndef LIBCOMPRESS_INFLATE_H_
 #define LIBCOMPRESS_INFLATE_H_
 
+#include <errno.h>
 #include <stddef.h>
 
+/** Input callback of a streaming decoder
+ *
+ * @param arg   Callback argument.
+ * @param buf   Buffer to fill.
+ * @param size  Size of the buffer (bytes).
+ * @param nread Place to store the number of bytes read,
+ *              zero signals the end of input.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+typedef errno_t (*inflate_read_t)(void *, void *, size_t, size_t *);
+
+typedef struct inflate_stream inflate_stream_t;
+
 extern errno_t inflate(void *, size_t, void *, size_t);
 
+extern errno_t inflate_stream_create(inflate_read_t, void *,
+    inflate_stream_t **);
+extern errno_t inflate_stream_read(inflate_stream_t *, void *, size_t,
+    size_t *);
+extern errno_t inflate_stream_trailer(inflate_stream_t *, void *, size_t);
+extern errno_t inflate_stream_restart(inflate_stream_t *);
+extern void inflate_stream_destroy(inflate_stream_t *);
+
 #endif
@@ -0,0 +1,338 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "../gzip.h"
+
+#define TEST_SIZE  200000
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(gzip);
+
+/** Fill a buffer with compressible data
+ *
+ * Short random strings are mixed with copies of earlier data so
+ * that both literals and matches at various distances occur.
+ */
+static void fill_data(uint8_t *data, size_t size)
+{
+	uint32_t seed = 1;
+	size_t i = 0;
+
+	while (i < size) {
+		seed = seed * 1103515245 + 12345;
+		size_t run = 1 + ((seed >> 16) % 300);
+
+		if ((i > 1000) && ((seed & 1) != 0)) {
+			size_t dist = 1 + ((seed >> 8) % (i < 32768 ? i : 32768));
+			for (; (run > 0) && (i < size); run--, i++)
+				data[i] = data[i - dist];
+		} else {
+			for (; (run > 0) && (i < size); run--, i++) {
+				seed = seed * 1103515245 + 12345;
+				data[i] = 'a' + ((seed >> 16) % 16);
+			}
+		}
+	}
+}
+
+typedef struct {
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+} test_input_t;
+
+/** Input callback returning the data in small irregular pieces */
+static errno_t test_read(void *arg, void *buf, size_t size, size_t *nread)
+{
+	test_input_t *input = (test_input_t *) arg;
+	size_t len = input->size - input->pos;
+
+	if (len > size)
+		len = size;
+	if (len > 1 + input->pos % 777)
+		len = 1 + input->pos % 777;
+
+	memcpy(buf, input->data + input->pos, len);
+	input->pos += len;
+	*nread = len;
+	return EOK;
+}
+
+/** Compress and expand data at all levels */
+PCUT_TEST(compress_expand)
+{
+	uint8_t *data = malloc(TEST_SIZE);
+	PCUT_ASSERT_NOT_NULL(data);
+	fill_data(data, TEST_SIZE);
+
+	for (unsigned level = DEFLATE_LEVEL_STORE; level <= DEFLATE_LEVEL_BEST;
+	    level++) {
+		void *packed;
+		size_t packed_size;
+		errno_t rc = gzip_compress(data, TEST_SIZE, level, &packed,
+		    &packed_size);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+		if (level != DEFLATE_LEVEL_STORE)
+			PCUT_ASSERT_TRUE(packed_size < TEST_SIZE / 2);
+
+		void *unpacked;
+		size_t unpacked_size;
+		rc = gzip_expand(packed, packed_size, &unpacked, &unpacked_size);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+		PCUT_ASSERT_INT_EQUALS(TEST_SIZE, unpacked_size);
+		PCUT_ASSERT_INT_EQUALS(0, memcmp(data, unpacked, TEST_SIZE));
+
+		free(unpacked);
+		free(packed);
+	}
+
+	free(data);
+}
+
+/** Compress empty data */
+PCUT_TEST(compress_empty)
+{
+	void *packed;
+	size_t packed_size;
+	errno_t rc = gzip_compress(NULL, 0, DEFLATE_LEVEL_DEFAULT, &packed,
+	    &packed_size);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	void *unpacked;
+	size_t unpacked_size;
+	rc = gzip_expand(packed, packed_size, &unpacked, &unpacked_size);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(0, unpacked_size);
+
+	free(unpacked);
+	free(packed);
+}
+
+/** Decompress using the streaming reader */
+PCUT_TEST(reader)
+{
+	uint8_t *data = malloc(TEST_SIZE);
+	uint8_t *buf = malloc(TEST_SIZE);
+	PCUT_ASSERT_NOT_NULL(data);
+	PCUT_ASSERT_NOT_NULL(buf);
+	fill_data(data, TEST_SIZE);
+
+	void *packed;
+	size_t packed_size;
+	errno_t rc = gzip_compress(data, TEST_SIZE, DEFLATE_LEVEL_DEFAULT,
+	    &packed, &packed_size);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_input_t input = { packed, packed_size, 0 };
+	gzip_reader_t *reader;
+	rc = gzip_reader_create(test_read, &input, &reader);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	size_t pos = 0;
+	size_t chunk = 1;
+	size_t nread;
+
+	do {
+		if (chunk > TEST_SIZE - pos)
+			chunk = TEST_SIZE - pos;
+
+		rc = gzip_reader_read(reader, buf + pos, chunk, &nread);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+		pos += nread;
+		chunk = chunk * 3 + 1;
+	} while (nread > 0);
+
+	PCUT_ASSERT_INT_EQUALS(TEST_SIZE, pos);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, buf, TEST_SIZE));
+
+	gzip_reader_destroy(reader);
+	free(packed);
+	free(buf);
+	free(data);
+}
+
+/** Corrupted data is rejected */
+PCUT_TEST(corrupted)
+{
+	uint8_t *data = malloc(TEST_SIZE);
+	PCUT_ASSERT_NOT_NULL(data);
+	fill_data(data, TEST_SIZE);
+
+	void *packed;
+	size_t packed_size;
+	errno_t rc = gzip_compress(data, TEST_SIZE, DEFLATE_LEVEL_DEFAULT,
+	    &packed, &packed_size);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Damage the stored CRC */
+	((uint8_t *) packed)[packed_size - 8] ^= 1;
+
+	void *unpacked;
+	size_t unpacked_size;
+	rc = gzip_expand(packed, packed_size, &unpacked, &unpacked_size);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+
+	/* Truncate the compressed data */
+	test_input_t input = { packed, packed_size / 2, 0 };
+	gzip_reader_t *reader;
+	rc = gzip_reader_create(test_read, &input, &reader);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	size_t nread;
+	rc = gzip_reader_read(reader, data, TEST_SIZE, &nread);
+	PCUT_ASSERT_ERRNO_VAL(ELIMIT, rc);
+
+	gzip_reader_destroy(reader);
+
+	free(packed);
+	free(data);
+}
+
+/** Concatenated GZIP members are decoded as a single stream */
+PCUT_TEST(reader_members)
+{
+	uint8_t *data = malloc(TEST_SIZE);
+	uint8_t *buf = malloc(TEST_SIZE);
+	PCUT_ASSERT_NOT_NULL(data);
+	PCUT_ASSERT_NOT_NULL(buf);
+	fill_data(data, TEST_SIZE);
+
+	/* Members of various sizes, including an empty one */
+	static const size_t splits[] = { 0, 1000, 1000, 70000, TEST_SIZE };
+	uint8_t *packed = NULL;
+	size_t packed_size = 0;
+	errno_t rc;
+
+	for (size_t i = 0; i + 1 < sizeof(splits) / sizeof(splits[0]); i++) {
+		void *member;
+		size_t member_size;
+		rc = gzip_compress(data + splits[i],
+		    splits[i + 1] - splits[i], DEFLATE_LEVEL_DEFAULT, &member,
+		    &member_size);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+		packed = realloc(packed, packed_size + member_size);
+		PCUT_ASSERT_NOT_NULL(packed);
+		memcpy(packed + packed_size, member, member_size);
+		packed_size += member_size;
+		free(member);
+	}
+
+	test_input_t input = { packed, packed_size, 0 };
+	gzip_reader_t *reader;
+	rc = gzip_reader_create(test_read, &input, &reader);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	size_t pos = 0;
+	size_t nread;
+
+	do {
+		size_t chunk = TEST_SIZE - pos;
+		if (chunk > 4099)
+			chunk = 4099;
+
+		rc = gzip_reader_read(reader, buf + pos, chunk, &nread);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+		pos += nread;
+	} while (nread == 4099);
+
+	PCUT_ASSERT_INT_EQUALS(TEST_SIZE, pos);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, buf, TEST_SIZE));
+
+	gzip_reader_destroy(reader);
+
+	/* Zero padding after the last member is ignored */
+	packed = realloc(packed, packed_size + 512);
+	PCUT_ASSERT_NOT_NULL(packed);
+	memset(packed + packed_size, 0, 512);
+
+	input.data = packed;
+	input.size = packed_size + 512;
+	input.pos = 0;
+	rc = gzip_reader_create(test_read, &input, &reader);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gzip_reader_read(reader, buf, TEST_SIZE, &nread);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(TEST_SIZE, nread);
+
+	rc = gzip_reader_read(reader, buf, 1, &nread);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(0, nread);
+
+	gzip_reader_destroy(reader);
+
+	/* So is a lone first magic byte */
+	packed[packed_size] = 0x1f;
+
+	input.size = packed_size + 1;
+	input.pos = 0;
+	rc = gzip_reader_create(test_read, &input, &reader);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gzip_reader_read(reader, buf, TEST_SIZE, &nread);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(TEST_SIZE, nread);
+
+	rc = gzip_reader_read(reader, buf, 1, &nread);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(0, nread);
+
+	gzip_reader_destroy(reader);
+
+	/* A corrupt member that starts with the magic is rejected */
+	packed[packed_size + 1] = 0x8b;
+	packed[packed_size + 2] = 0xff;
+
+	input.size = packed_size + 512;
+	input.pos = 0;
+	rc = gzip_reader_create(test_read, &input, &reader);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = gzip_reader_read(reader, buf, TEST_SIZE, &nread);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(TEST_SIZE, nread);
+
+	rc = gzip_reader_read(reader, buf, 1, &nread);
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, rc);
+
+	gzip_reader_destroy(reader);
+
+	free(packed);
+	free(buf);
+	free(data);
+}
+
+PCUT_EXPORT(gzip);
@@ -0,0 +1,862 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_ADT_FLAT_HASH_TABLE
+#define LIBCPP_BITS_ADT_FLAT_HASH_TABLE
+
+#include <__bits/iterator_helpers.hpp>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace std::aux
+{
+    /**
+     * Open addressing hash table using Robin Hood hashing
+     * with backward shift deletion. Values are stored in one
+     * flat array and each slot has a byte holding its distance
+     * from its home slot plus one (zero means the slot is empty).
+     * Lookups thus only touch a couple of adjacent slots instead
+     * of chasing list nodes, but elements move on insertion,
+     * erasure and rehash, so unlike hash_table this cannot
+     * provide the reference stability that unordered containers
+     * require. It is used by the opt-in flat_unordered_map and
+     * flat_unordered_set containers.
+     *
+     * Probe sequences do not wrap around: the array has a tail
+     * of extra slots behind the last home slot that clusters
+     * run into, and the tail grows if a cluster reaches its end.
+     * Keys sharing a hash thus only make their cluster slow,
+     * and since elements never move to a lower index than their
+     * home slot, erasing while iterating visits each element once.
+     */
+
+    template<class Value, class Reference, class Pointer, class Size>
+    class flat_hash_table_iterator
+    {
+        public:
+            using value_type      = Value;
+            using size_type       = Size;
+            using reference       = Reference;
+            using pointer         = Pointer;
+            using difference_type = ptrdiff_t;
+
+            using iterator_category = forward_iterator_tag;
+
+            flat_hash_table_iterator(value_type* slots = nullptr,
+                                     const uint8_t* dists = nullptr,
+                                     size_type idx = size_type{},
+                                     size_type capacity = size_type{})
+                : slots_{slots}, dists_{dists}, idx_{idx}, capacity_{capacity}
+            {
+                skip_empty_();
+            }
+
+            template<class R, class P>
+            flat_hash_table_iterator(
+                const flat_hash_table_iterator<Value, R, P, Size>& other
+            )
+                : slots_{other.slots()}, dists_{other.dists()},
+                  idx_{other.idx()}, capacity_{other.capacity()}
+            { /* DUMMY BODY */ }
+
+            reference operator*() const
+            {
+                return slots_[idx_];
+            }
+
+            pointer operator->() const
+            {
+                return &slots_[idx_];
+            }
+
+            flat_hash_table_iterator& operator++()
+            {
+                ++idx_;
+                skip_empty_();
+
+                return *this;
+            }
+
+            flat_hash_table_iterator operator++(int)
+            {
+                auto tmp = *this;
+                ++(*this);
+
+                return tmp;
+            }
+
+            value_type* slots() const
+            {
+                return slots_;
+            }
+
+            const uint8_t* dists() const
+            {
+                return dists_;
+            }
+
+            size_type idx() const
+            {
+                return idx_;
+            }
+
+            size_type capacity() const
+            {
+                return capacity_;
+            }
+
+        private:
+            value_type* slots_;
+            const uint8_t* dists_;
+            size_type idx_;
+            size_type capacity_;
+
+            void skip_empty_()
+            {
+                while (idx_ < capacity_ && dists_[idx_] == 0)
+                    ++idx_;
+            }
+    };
+
+    template<class Value, class R1, class P1, class R2, class P2, class Size>
+    bool operator==(const flat_hash_table_iterator<Value, R1, P1, Size>& lhs,
+                    const flat_hash_table_iterator<Value, R2, P2, Size>& rhs)
+    {
+        return lhs.slots() == rhs.slots() && lhs.idx() == rhs.idx();
+    }
+
+    template<class Value, class R1, class P1, class R2, class P2, class Size>
+    bool operator!=(const flat_hash_table_iterator<Value, R1, P1, Size>& lhs,
+                    const flat_hash_table_iterator<Value, R2, P2, Size>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<
+        class Value, class Key, class KeyExtractor,
+        class Hasher, class KeyEq, class Alloc,
+        class Iterator, class ConstIterator
+    >
+    class flat_hash_table
+    {
+        public:
+            using value_type     = Value;
+            using key_type       = Key;
+            using size_type      = size_t;
+            using allocator_type = Alloc;
+            using key_equal      = KeyEq;
+            using hasher         = Hasher;
+            using key_extract    = KeyExtractor;
+
+            using iterator       = Iterator;
+            using const_iterator = ConstIterator;
+
+            flat_hash_table(size_type capacity, const hasher& hf = hasher{},
+                            const key_equal& eql = key_equal{},
+                            const allocator_type& alloc = allocator_type{})
+                : slots_{}, dists_{}, capacity_{}, slot_count_{},
+                  shift_{}, size_{},
+                  hasher_{hf}, key_eq_{eql}, key_extractor_{},
+                  allocator_{alloc}, max_load_factor_{default_max_load_factor_}
+            {
+                if (capacity > 0)
+                    allocate_(capacity_for_(capacity));
+            }
+
+            flat_hash_table(const flat_hash_table& other)
+                : flat_hash_table{
+                    other.size_, other.hasher_, other.key_eq_, other.allocator_
+                  }
+            {
+                max_load_factor_ = other.max_load_factor_;
+                for (const auto& x: other)
+                    insert(x);
+            }
+
+            flat_hash_table(flat_hash_table&& other) noexcept
+                : slots_{other.slots_}, dists_{other.dists_},
+                  capacity_{other.capacity_}, slot_count_{other.slot_count_},
+                  shift_{other.shift_}, size_{other.size_}, hasher_{move(other.hasher_)},
+                  key_eq_{move(other.key_eq_)}, key_extractor_{},
+                  allocator_{move(other.allocator_)},
+                  max_load_factor_{other.max_load_factor_}
+            {
+                other.slots_ = nullptr;
+                other.dists_ = nullptr;
+                other.capacity_ = size_type{};
+                other.slot_count_ = size_type{};
+                other.shift_ = size_type{};
+                other.size_ = size_type{};
+            }
+
+            flat_hash_table& operator=(const flat_hash_table& other)
+            {
+                flat_hash_table tmp{other};
+                tmp.swap(*this);
+
+                return *this;
+            }
+
+            flat_hash_table& operator=(flat_hash_table&& other) noexcept
+            {
+                flat_hash_table tmp{move(other)};
+                tmp.swap(*this);
+
+                return *this;
+            }
+
+            ~flat_hash_table()
+            {
+                clear();
+                deallocate_();
+            }
+
+            allocator_type get_allocator() const noexcept
+            {
+                return allocator_;
+            }
+
+            bool empty() const noexcept
+            {
+                return size_ == 0;
+            }
+
+            size_type size() const noexcept
+            {
+                return size_;
+            }
+
+            size_type max_size() const noexcept
+            {
+                return allocator_traits<allocator_type>::max_size(allocator_);
+            }
+
+            iterator begin() noexcept
+            {
+                return iterator{slots_, dists_, 0, slot_count_};
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return cbegin();
+            }
+
+            iterator end() noexcept
+            {
+                return iterator{slots_, dists_, slot_count_, slot_count_};
+            }
+
+            const_iterator end() const noexcept
+            {
+                return cend();
+            }
+
+            const_iterator cbegin() const noexcept
+            {
+                return const_iterator{slots_, dists_, 0, slot_count_};
+            }
+
+            const_iterator cend() const noexcept
+            {
+                return const_iterator{slots_, dists_, slot_count_, slot_count_};
+            }
+
+            /**
+             * Inserts a value constructed from args unless an
+             * element with the same key is already present.
+             */
+            template<class... Args>
+            pair<iterator, bool> emplace(Args&&... args)
+            {
+                /**
+                 * Note: We need the key before we know where
+                 *       to put the value, so we construct it
+                 *       here and move it into its slot.
+                 */
+                value_type val(forward<Args>(args)...);
+
+                return insert_(val);
+            }
+
+            pair<iterator, bool> insert(const value_type& val)
+            {
+                auto it = find(key_extractor_(val));
+                if (it != end())
+                    return make_pair(it, false);
+
+                value_type tmp(val);
+
+                return insert_new_(tmp);
+            }
+
+            pair<iterator, bool> insert(value_type&& val)
+            {
+                return insert_(val);
+            }
+
+            /**
+             * Inserts a value constructed from key and args
+             * unless key is already present, in which case
+             * args are left untouched.
+             */
+            template<class K, class... Args>
+            pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+            {
+                auto it = find(key);
+                if (it != end())
+                    return make_pair(it, false);
+
+                value_type val(
+                    forward<K>(key),
+                    typename value_type::second_type(forward<Args>(args)...)
+                );
+
+                return insert_new_(val);
+            }
+
+            size_type erase(const key_type& key)
+            {
+                auto idx = find_idx_(key);
+                if (idx == slot_count_)
+                    return 0;
+
+                erase_idx_(idx);
+
+                return 1;
+            }
+
+            /**
+             * Note: Backward shift deletion moves the following
+             *       element into the erased slot, so the returned
+             *       iterator may point to the same slot as it.
+             *       Elements never move from before the erased slot,
+             *       so none is visited twice.
+             */
+            iterator erase(const_iterator it)
+            {
+                auto idx = it.idx();
+                erase_idx_(idx);
+
+                return iterator{slots_, dists_, idx, slot_count_};
+            }
+
+            iterator erase(const_iterator first, const_iterator last)
+            {
+                /**
+                 * Erasing can move elements from behind last
+                 * into the range, so we count the elements to
+                 * erase first and keep erasing at the position
+                 * of first.
+                 */
+                size_type count{};
+                for (auto it = first; it != last; ++it)
+                    ++count;
+
+                iterator res{slots_, dists_, first.idx(), slot_count_};
+                while (count-- > 0)
+                    res = erase(res);
+
+                return res;
+            }
+
+            void clear() noexcept
+            {
+                for (size_type i = 0; i < slot_count_; ++i)
+                {
+                    if (dists_[i] != 0)
+                    {
+                        allocator_traits<allocator_type>::destroy(
+                            allocator_, &slots_[i]
+                        );
+                        dists_[i] = 0;
+                    }
+                }
+
+                size_ = size_type{};
+            }
+
+            void swap(flat_hash_table& other)
+                noexcept(allocator_traits<allocator_type>::is_always_equal::value &&
+                         noexcept(swap(declval<Hasher&>(), declval<Hasher&>())) &&
+                         noexcept(swap(declval<KeyEq&>(), declval<KeyEq&>())))
+            {
+                std::swap(slots_, other.slots_);
+                std::swap(dists_, other.dists_);
+                std::swap(capacity_, other.capacity_);
+                std::swap(slot_count_, other.slot_count_);
+                std::swap(shift_, other.shift_);
+                std::swap(size_, other.size_);
+                std::swap(hasher_, other.hasher_);
+                std::swap(key_eq_, other.key_eq_);
+                std::swap(allocator_, other.allocator_);
+                std::swap(max_load_factor_, other.max_load_factor_);
+            }
+
+            hasher hash_function() const
+            {
+                return hasher_;
+            }
+
+            key_equal key_eq() const
+            {
+                return key_eq_;
+            }
+
+            iterator find(const key_type& key)
+            {
+                auto idx = find_idx_(key);
+
+                return iterator{slots_, dists_, idx, slot_count_};
+            }
+
+            const_iterator find(const key_type& key) const
+            {
+                auto idx = find_idx_(key);
+
+                return const_iterator{slots_, dists_, idx, slot_count_};
+            }
+
+            size_type count(const key_type& key) const
+            {
+                return find_idx_(key) != slot_count_ ? 1 : 0;
+            }
+
+            pair<iterator, iterator> equal_range(const key_type& key)
+            {
+                auto it = find(key);
+                if (it == end())
+                    return make_pair(it, it);
+
+                auto last = it;
+                return make_pair(it, ++last);
+            }
+
+            pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+            {
+                auto it = find(key);
+                if (it == end())
+                    return make_pair(it, it);
+
+                auto last = it;
+                return make_pair(it, ++last);
+            }
+
+            size_type capacity() const noexcept
+            {
+                return capacity_;
+            }
+
+            float load_factor() const noexcept
+            {
+                if (capacity_ == 0)
+                    return 0.f;
+
+                return size_ / static_cast<float>(capacity_);
+            }
+
+            float max_load_factor() const noexcept
+            {
+                return max_load_factor_;
+            }
+
+            /**
+             * Long probe sequences quickly get expensive with
+             * open addressing, so the load factor is capped.
+             */
+            void max_load_factor(float factor)
+            {
+                if (factor > 0.f)
+                    max_load_factor_ = min(factor, max_max_load_factor_);
+
+                if (size_ > max_load_factor_ * capacity_)
+                    rehash(0);
+            }
+
+            void rehash(size_type count)
+            {
+                count = capacity_for_(max(count, size_));
+                if (count != capacity_)
+                    rehash_(count);
+            }
+
+            void reserve(size_type count)
+            {
+                rehash(count);
+            }
+
+            bool is_eq_to(const flat_hash_table& other) const
+            {
+                if (size_ != other.size_)
+                    return false;
+
+                for (const auto& x: *this)
+                {
+                    auto it = other.find(key_extractor_(x));
+                    if (it == other.end() || !(*it == x))
+                        return false;
+                }
+
+                return true;
+            }
+
+        private:
+            value_type* slots_;
+            uint8_t* dists_;
+            size_type capacity_;
+            size_type slot_count_;
+            size_type shift_;
+            size_type size_;
+            hasher hasher_;
+            key_equal key_eq_;
+            key_extract key_extractor_;
+            allocator_type allocator_;
+            float max_load_factor_;
+
+            using dist_allocator_type = typename allocator_traits<
+                allocator_type
+            >::template rebind_alloc<uint8_t>;
+
+            static constexpr size_type min_capacity_{8};
+            static constexpr uint8_t max_dist_{numeric_limits<uint8_t>::max()};
+            static constexpr float default_max_load_factor_{0.875f};
+            static constexpr float max_max_load_factor_{0.95f};
+
+            /**
+             * Fibonacci hashing spreads the bits of weak hashes
+             * (like the identity for integers) over the table
+             * and lets us use the top bits as the home slot.
+             */
+            static constexpr size_t fibonacci_multiplier_{
+                sizeof(size_t) > 4 ? size_t(0x9E3779B97F4A7C15ULL) : size_t(0x9E3779B9UL)
+            };
+
+            size_type home_(const key_type& key) const
+            {
+                return (hasher_(key) * fibonacci_multiplier_) >> shift_;
+            }
+
+            /**
+             * Distances that do not fit into their byte are
+             * stored as max_dist_ and recomputed from the hash
+             * when needed, which only happens in long clusters
+             * of keys sharing their home slot.
+             */
+            size_type dist_(size_type idx) const
+            {
+                if (dists_[idx] != max_dist_)
+                    return dists_[idx];
+
+                return idx - home_(key_extractor_(slots_[idx])) + 1;
+            }
+
+            void set_dist_(size_type idx, size_type dist) noexcept
+            {
+                dists_[idx] = dist < max_dist_ ? dist : max_dist_;
+            }
+
+            /**
+             * Smallest power of two capacity that holds count
+             * elements without exceeding the max load factor.
+             */
+            size_type capacity_for_(size_type count) const noexcept
+            {
+                if (count == 0)
+                    return 0;
+
+                size_type res{min_capacity_};
+                while (res * max_load_factor_ < count)
+                    res *= 2;
+
+                return res;
+            }
+
+            void allocate_(size_type capacity, size_type tail)
+            {
+                dist_allocator_type dist_alloc{allocator_};
+
+                slots_ = allocator_.allocate(capacity + tail);
+                dists_ = dist_alloc.allocate(capacity + tail);
+                for (size_type i = 0; i < capacity + tail; ++i)
+                    dists_[i] = 0;
+                capacity_ = capacity;
+                slot_count_ = capacity + tail;
+
+                size_type bits{};
+                while ((size_type{1} << bits) < capacity)
+                    ++bits;
+                shift_ = numeric_limits<size_t>::digits - bits;
+            }
+
+            void allocate_(size_type capacity)
+            {
+                /**
+                 * With a sane hash function clusters rarely
+                 * get longer than the logarithm of the capacity.
+                 */
+                size_type tail{};
+                while ((size_type{1} << tail) < capacity)
+                    ++tail;
+
+                allocate_(capacity, tail);
+            }
+
+            void deallocate_()
+            {
+                if (!slots_)
+                    return;
+
+                dist_allocator_type dist_alloc{allocator_};
+
+                allocator_.deallocate(slots_, slot_count_);
+                dist_alloc.deallocate(dists_, slot_count_);
+                slots_ = nullptr;
+                dists_ = nullptr;
+            }
+
+            size_type find_idx_(const key_type& key) const
+            {
+                if (size_ == 0)
+                    return slot_count_;
+
+                auto idx = home_(key);
+                for (size_type dist = 1; idx < slot_count_ && dists_[idx] != 0; ++dist)
+                {
+                    /**
+                     * Note: Elements are ordered by their home slot
+                     *       within a cluster, so once we see one that
+                     *       is closer to home than we would be, our key
+                     *       is not in the table.
+                     */
+                    auto cur = dist_(idx);
+                    if (cur < dist)
+                        break;
+
+                    if (cur == dist &&
+                        key_eq_(key, key_extractor_(slots_[idx])))
+                        return idx;
+
+                    ++idx;
+                }
+
+                return slot_count_;
+            }
+
+            /**
+             * Constructs to from the value at from, moving out
+             * of it. The key of a map is const, but the value at
+             * from is destroyed right afterwards, so moving the
+             * key out of it is safe as well.
+             */
+            template<class K, class V>
+            void construct_from_(pair<const K, V>* to, pair<const K, V>& from)
+            {
+                allocator_traits<allocator_type>::construct(
+                    allocator_, to, const_cast<K&&>(from.first),
+                    move(from.second)
+                );
+            }
+
+            template<class T>
+            void construct_from_(T* to, T& from)
+            {
+                allocator_traits<allocator_type>::construct(
+                    allocator_, to, move(from)
+                );
+            }
+
+            /**
+             * Moves the element at from into the empty slot to.
+             */
+            void relocate_(value_type* from, value_type* to)
+            {
+                construct_from_(to, *from);
+                allocator_traits<allocator_type>::destroy(allocator_, from);
+            }
+
+            /**
+             * Moves val into the table unless its key is present.
+             */
+            pair<iterator, bool> insert_(value_type& val)
+            {
+                auto it = find(key_extractor_(val));
+                if (it != end())
+                    return make_pair(it, false);
+
+                return insert_new_(val);
+            }
+
+            /**
+             * Moves in a value whose key is known not to be
+             * in the table.
+             */
+            pair<iterator, bool> insert_new_(value_type& val)
+            {
+                if (capacity_ == 0 || size_ + 1 > max_load_factor_ * capacity_)
+                    rehash_(capacity_for_(size_ + 1));
+
+                size_type idx{};
+                while (!place_(val, idx))
+                    grow_tail_();
+
+                ++size_;
+
+                return make_pair(iterator{slots_, dists_, idx, slot_count_}, true);
+            }
+
+            /**
+             * Finds the slot of a new value and moves it there,
+             * shifting the rest of the cluster forward by one.
+             * Fails without side effects if the cluster would
+             * run past the tail, the caller then grows the tail.
+             */
+            bool place_(value_type& val, size_type& res)
+            {
+                auto idx = home_(key_extractor_(val));
+                size_type dist{1};
+
+                /**
+                 * Robin Hood: we take the slot of the first
+                 * element that is closer to its home than
+                 * we are to ours.
+                 */
+                while (idx < slot_count_ && dists_[idx] != 0 && dist_(idx) >= dist)
+                {
+                    ++idx;
+                    ++dist;
+                }
+
+                auto empty = idx;
+                while (empty < slot_count_ && dists_[empty] != 0)
+                    ++empty;
+
+                if (empty == slot_count_)
+                    return false;
+
+                while (empty != idx)
+                {
+                    auto prev = empty - 1;
+
+                    set_dist_(empty, dist_(prev) + 1);
+                    relocate_(&slots_[prev], &slots_[empty]);
+                    empty = prev;
+                }
+
+                construct_from_(&slots_[idx], val);
+                set_dist_(idx, dist);
+                res = idx;
+
+                return true;
+            }
+
+            void erase_idx_(size_type idx)
+            {
+                allocator_traits<allocator_type>::destroy(
+                    allocator_, &slots_[idx]
+                );
+
+                auto next = idx + 1;
+                while (next < slot_count_ && dists_[next] > 1)
+                {
+                    set_dist_(idx, dist_(next) - 1);
+                    relocate_(&slots_[next], &slots_[idx]);
+
+                    idx = next;
+                    next = idx + 1;
+                }
+
+                dists_[idx] = 0;
+                --size_;
+            }
+
+            /**
+             * Called when a cluster reaches the end of the tail.
+             * The home slots do not change, so the elements keep
+             * their positions in the longer array.
+             */
+            void grow_tail_()
+            {
+                auto old_slots = slots_;
+                auto old_dists = dists_;
+                auto old_slot_count = slot_count_;
+
+                allocate_(capacity_, 2 * (slot_count_ - capacity_) + 1);
+
+                for (size_type i = 0; i < old_slot_count; ++i)
+                {
+                    if (old_dists[i] == 0)
+                        continue;
+
+                    relocate_(&old_slots[i], &slots_[i]);
+                    dists_[i] = old_dists[i];
+                }
+
+                dist_allocator_type dist_alloc{allocator_};
+
+                allocator_.deallocate(old_slots, old_slot_count);
+                dist_alloc.deallocate(old_dists, old_slot_count);
+            }
+
+            void rehash_(size_type capacity)
+            {
+                auto old_slots = slots_;
+                auto old_dists = dists_;
+                auto old_slot_count = slot_count_;
+
+                slots_ = nullptr;
+                dists_ = nullptr;
+                allocate_(max(capacity, min_capacity_));
+
+                for (size_type i = 0; i < old_slot_count; ++i)
+                {
+                    if (old_dists[i] == 0)
+                        continue;
+
+                    size_type idx{};
+                    while (!place_(old_slots[i], idx))
+                        grow_tail_();
+
+                    allocator_traits<allocator_type>::destroy(
+                        allocator_, &old_slots[i]
+                    );
+                }
+
+                if (old_slots)
+                {
+                    dist_allocator_type dist_alloc{allocator_};
+
+                    allocator_.deallocate(old_slots, old_slot_count);
+                    dist_alloc.deallocate(old_dists, old_slot_count);
+                }
+            }
+    };
+}
+
+#endif
@@ -29,6 +29,7 @@
 #ifndef LIBCPP_BITS_ALGORITHM
 #define LIBCPP_BITS_ALGORITHM
 
+#include <__bits/memory/misc.hpp>
 #include <iterator>
 #include <utility>
 
@@ -653,7 +654,50 @@ namespace std
      * 25.3.11, rotate:
      */
 
-    // TODO: implement
+    template<class ForwardIterator>
+    ForwardIterator rotate(ForwardIterator first, ForwardIterator middle,
+                           ForwardIterator last)
+    {
+        if (first == middle)
+            return last;
+        if (middle == last)
+            return first;
+
+        /**
+         * Swap the first block with the start of the second
+         * one until one of them is exhausted, then continue
+         * with whatever remains out of place.
+         */
+        auto next = middle;
+        while (true)
+        {
+            iter_swap(first++, next++);
+            if (next == last)
+                break;
+            if (first == middle)
+                middle = next;
+        }
+
+        auto res = first;
+        next = middle;
+        while (first != middle)
+        {
+            iter_swap(first++, next++);
+            if (next == last)
+                next = middle;
+            else if (first == middle)
+                middle = next;
+        }
+
+        return res;
+    }
+
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator rotate_copy(ForwardIterator first, ForwardIterator middle,
+                               ForwardIterator last, OutputIterator result)
+    {
+        return copy(first, middle, copy(middle, last, result));
+    }
 
     /**
      * 25.3.12, shuffle:
@@ -687,6 +731,151 @@ namespace std
     void sort_heap(RandomAccessIterator, RandomAccessIterator,
                    Compare);
 
+    template<class RandomAccessIterator, class Compare>
+    void partial_sort(RandomAccessIterator, RandomAccessIterator,
+                      RandomAccessIterator, Compare);
+
+    namespace aux
+    {
+        template<class RandomAccessIterator, class Size, class Compare>
+        void correct_children(RandomAccessIterator, Size, Size, Compare);
+
+        /**
+         * Ranges of at most this many elements are left
+         * to insertion sort by sort and nth_element.
+         */
+        constexpr ptrdiff_t insertion_sort_threshold{16};
+
+        template<class Size>
+        Size sort_depth_limit(Size count)
+        {
+            Size res{};
+            while (count > 1)
+            {
+                count /= 2;
+                res += 2;
+            }
+
+            return res;
+        }
+
+        template<class RandomAccessIterator, class Compare>
+        void unguarded_linear_insert(RandomAccessIterator last, Compare comp)
+        {
+            auto tmp = move(*last);
+            auto prev = last - 1;
+            while (comp(tmp, *prev))
+            {
+                *last = move(*prev);
+                last = prev--;
+            }
+            *last = move(tmp);
+        }
+
+        template<class RandomAccessIterator, class Compare>
+        void insertion_sort(RandomAccessIterator first,
+                            RandomAccessIterator last, Compare comp)
+        {
+            if (first == last)
+                return;
+
+            for (auto it = first + 1; it != last; ++it)
+            {
+                if (comp(*it, *first))
+                {
+                    // New minimum, shift the whole sorted prefix.
+                    auto tmp = move(*it);
+                    for (auto hole = it; hole != first; --hole)
+                        *hole = move(*(hole - 1));
+                    *first = move(tmp);
+                }
+                else
+                    unguarded_linear_insert(it, comp);
+            }
+        }
+
+        /**
+         * Moves the median of *a, *b and *c to *result.
+         */
+        template<class RandomAccessIterator, class Compare>
+        void move_median_to_first(RandomAccessIterator result,
+                                  RandomAccessIterator a,
+                                  RandomAccessIterator b,
+                                  RandomAccessIterator c, Compare comp)
+        {
+            if (comp(*a, *b))
+            {
+                if (comp(*b, *c))
+                    iter_swap(result, b);
+                else if (comp(*a, *c))
+                    iter_swap(result, c);
+                else
+                    iter_swap(result, a);
+            }
+            else if (comp(*a, *c))
+                iter_swap(result, a);
+            else if (comp(*b, *c))
+                iter_swap(result, c);
+            else
+                iter_swap(result, b);
+        }
+
+        /**
+         * Partitions a range of at least four elements around
+         * the median of its first, middle and last element
+         * and returns the start of the upper part. The median
+         * selection guarantees that neither scan runs off the
+         * range, so they need no bound checks.
+         */
+        template<class RandomAccessIterator, class Compare>
+        RandomAccessIterator partition_pivot(RandomAccessIterator first,
+                                             RandomAccessIterator last,
+                                             Compare comp)
+        {
+            auto mid = first + (last - first) / 2;
+            move_median_to_first(first, first + 1, mid, last - 1, comp);
+
+            auto lo = first + 1;
+            auto hi = last;
+            while (true)
+            {
+                while (comp(*lo, *first))
+                    ++lo;
+                --hi;
+                while (comp(*first, *hi))
+                    --hi;
+
+                if (!(lo < hi))
+                    return lo;
+
+                iter_swap(lo, hi);
+                ++lo;
+            }
+        }
+
+        template<class RandomAccessIterator, class Size, class Compare>
+        void introsort_loop(RandomAccessIterator first,
+                            RandomAccessIterator last,
+                            Size depth_limit, Compare comp)
+        {
+            while (last - first > insertion_sort_threshold)
+            {
+                if (depth_limit == 0)
+                {
+                    // Bad pivots, fall back to heapsort.
+                    partial_sort(first, last, last, comp);
+
+                    return;
+                }
+                --depth_limit;
+
+                auto cut = partition_pivot(first, last, comp);
+                introsort_loop(cut, last, depth_limit, comp);
+                last = cut;
+            }
+        }
+    }
+
     template<class RandomAccessIterator>
     void sort(RandomAccessIterator first, RandomAccessIterator last)
     {
@@ -700,89 +889,372 @@ namespace std
               Compare comp)
     {
         /**
-         * Note: This isn't the most effective approach,
-         *       but since we already have these two functions
-         *       and they satisfy asymptotic limitations
-         *       imposed by the standard, we're using them at
-         *       the moment. Might be good to change it to qsort
-         *       or merge sort later.
+         * Introsort: quicksort with median of three pivots
+         * that switches to heapsort when the recursion gets
+         * too deep and leaves short ranges unsorted. Those
+         * are finished by a single insertion sort pass at the
+         * end, which needs no bound checks past the first
+         * range because every element has a smaller or equal
+         * one in front of it.
          */
+        auto count = last - first;
+        if (count < 2)
+            return;
+
+        aux::introsort_loop(first, last, aux::sort_depth_limit(count), comp);
 
-        make_heap(first, last, comp);
-        sort_heap(first, last, comp);
+        if (count > aux::insertion_sort_threshold)
+        {
+            auto mid = first + aux::insertion_sort_threshold;
+            aux::insertion_sort(first, mid, comp);
+            for (auto it = mid; it != last; ++it)
+                aux::unguarded_linear_insert(it, comp);
+        }
+        else
+            aux::insertion_sort(first, last, comp);
     }
 
     /**
      * 25.4.1.2, stable_sort:
      */
 
-    // TODO: implement
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator lower_bound(ForwardIterator, ForwardIterator,
+                                const T&, Compare);
+
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator upper_bound(ForwardIterator, ForwardIterator,
+                                const T&, Compare);
+
+    namespace aux
+    {
+        /**
+         * Merges [first, middle) and [middle, last) moving the
+         * first part to the buffer, which must be large enough.
+         */
+        template<class BidirectionalIterator, class Pointer, class Compare>
+        void merge_with_buffer(BidirectionalIterator first,
+                               BidirectionalIterator middle,
+                               BidirectionalIterator last,
+                               Pointer buffer, Compare comp)
+        {
+            using value_type = typename iterator_traits<BidirectionalIterator>::value_type;
+
+            auto buffer_end = buffer;
+            for (auto it = first; it != middle; ++it, ++buffer_end)
+                ::new (static_cast<void*>(buffer_end)) value_type(move(*it));
+
+            auto buf = buffer;
+            while (buf != buffer_end && middle != last)
+            {
+                // Take from the first part on ties to stay stable.
+                if (comp(*middle, *buf))
+                    *first++ = move(*middle++);
+                else
+                    *first++ = move(*buf++);
+            }
+
+            while (buf != buffer_end)
+                *first++ = move(*buf++);
+
+            for (buf = buffer; buf != buffer_end; ++buf)
+                buf->~value_type();
+        }
+
+        /**
+         * Stable merge of [first, middle) and [middle, last)
+         * using the buffer where the first part fits into it
+         * and rotations where it does not.
+         */
+        template<class BidirectionalIterator, class Distance,
+                 class Pointer, class Compare>
+        void merge_adaptive(BidirectionalIterator first,
+                            BidirectionalIterator middle,
+                            BidirectionalIterator last,
+                            Distance len1, Distance len2,
+                            Pointer buffer, Distance buffer_size,
+                            Compare comp)
+        {
+            if (len1 == 0 || len2 == 0)
+                return;
+
+            // Already in order, common for presorted input.
+            auto prev = middle;
+            if (!comp(*middle, *--prev))
+                return;
+
+            if (len1 <= buffer_size)
+            {
+                merge_with_buffer(first, middle, last, buffer, comp);
+
+                return;
+            }
+
+            if (len1 + len2 == 2)
+            {
+                iter_swap(first, middle);
+
+                return;
+            }
+
+            /**
+             * Split the longer part in half, find where its
+             * middle element belongs in the other part and
+             * rotate the two inner quarters into place.
+             */
+            auto first_cut = first;
+            auto second_cut = middle;
+            Distance len11{};
+            Distance len22{};
+            if (len1 > len2)
+            {
+                len11 = len1 / 2;
+                advance(first_cut, len11);
+                second_cut = lower_bound(middle, last, *first_cut, comp);
+                len22 = distance(middle, second_cut);
+            }
+            else
+            {
+                len22 = len2 / 2;
+                advance(second_cut, len22);
+                first_cut = upper_bound(first, middle, *second_cut, comp);
+                len11 = distance(first, first_cut);
+            }
+
+            auto new_middle = rotate(first_cut, middle, second_cut);
+            merge_adaptive(first, first_cut, new_middle, len11, len22,
+                           buffer, buffer_size, comp);
+            merge_adaptive(new_middle, second_cut, last, len1 - len11,
+                           len2 - len22, buffer, buffer_size, comp);
+        }
+
+        template<class RandomAccessIterator, class Pointer,
+                 class Distance, class Compare>
+        void merge_sort(RandomAccessIterator first, RandomAccessIterator last,
+                        Pointer buffer, Distance buffer_size, Compare comp)
+        {
+            Distance count = last - first;
+            if (count <= insertion_sort_threshold)
+            {
+                insertion_sort(first, last, comp);
+
+                return;
+            }
+
+            auto middle = first + count / 2;
+            merge_sort(first, middle, buffer, buffer_size, comp);
+            merge_sort(middle, last, buffer, buffer_size, comp);
+            merge_adaptive(first, middle, last, Distance(middle - first),
+                           Distance(last - middle), buffer, buffer_size, comp);
+        }
+    }
+
+    template<class RandomAccessIterator>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        stable_sort(first, last, less<value_type>{});
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last,
+                     Compare comp)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        /**
+         * Merge sort with a buffer for half of the range,
+         * merges that do not fit into a smaller buffer (or
+         * no buffer at all) are done in place.
+         */
+        auto count = last - first;
+        if (count < 2)
+            return;
+
+        auto buffer = get_temporary_buffer<value_type>((count + 1) / 2);
+        aux::merge_sort(first, last, buffer.first, buffer.second, comp);
+        return_temporary_buffer(buffer.first);
+    }
 
     /**
      * 25.4.1.3, partial_sort:
      */
 
-    // TODO: implement
+    template<class RandomAccessIterator>
+    void partial_sort(RandomAccessIterator first,
+                      RandomAccessIterator middle,
+                      RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
 
-    /**
-     * 25.4.1.4, partial_sort_copy:
-     */
+        partial_sort(first, middle, last, less<value_type>{});
+    }
 
-    // TODO: implement
+    template<class RandomAccessIterator, class Compare>
+    void partial_sort(RandomAccessIterator first,
+                      RandomAccessIterator middle,
+                      RandomAccessIterator last,
+                      Compare comp)
+    {
+        if (first == middle)
+            return;
+
+        /**
+         * Keep the smallest elements seen so far in a max-heap
+         * so that each remaining one is compared to its top only.
+         */
+        make_heap(first, middle, comp);
+
+        auto count = middle - first;
+        for (auto it = middle; it != last; ++it)
+        {
+            if (comp(*it, *first))
+            {
+                iter_swap(it, first);
+                aux::correct_children(first, decltype(count){}, count, comp);
+            }
+        }
+
+        sort_heap(first, middle, comp);
+    }
 
     /**
-     * 25.4.1.5, is_sorted:
+     * 25.4.1.4, partial_sort_copy:
      */
 
-    template<class ForwardIterator>
-    bool is_sorted(ForwardIterator first, ForwardIterator last)
+    template<class InputIterator, class RandomAccessIterator>
+    RandomAccessIterator partial_sort_copy(InputIterator first,
+                                           InputIterator last,
+                                           RandomAccessIterator result_first,
+                                           RandomAccessIterator result_last)
     {
-        return is_sorted_until(first, last) == last;
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        return partial_sort_copy(first, last, result_first, result_last,
+                                 less<value_type>{});
     }
 
-    template<class ForwardIterator, class Comp>
-    bool is_sorted(ForwardIterator first, ForwardIterator last,
-                   Comp comp)
+    template<class InputIterator, class RandomAccessIterator, class Compare>
+    RandomAccessIterator partial_sort_copy(InputIterator first,
+                                           InputIterator last,
+                                           RandomAccessIterator result_first,
+                                           RandomAccessIterator result_last,
+                                           Compare comp)
     {
-        return is_sorted_until(first, last, comp) == last;
+        auto result = result_first;
+        while (first != last && result != result_last)
+            *result++ = *first++;
+
+        if (result == result_first)
+            return result;
+
+        make_heap(result_first, result, comp);
+
+        auto count = result - result_first;
+        for (; first != last; ++first)
+        {
+            if (comp(*first, *result_first))
+            {
+                *result_first = *first;
+                aux::correct_children(result_first, decltype(count){},
+                                      count, comp);
+            }
+        }
+
+        sort_heap(result_first, result, comp);
+
+        return result;
     }
 
+    /**
+     * 25.4.1.5, is_sorted:
+     */
+
     template<class ForwardIterator>
     ForwardIterator is_sorted_until(ForwardIterator first, ForwardIterator last)
     {
-        if (distance(first, last) < 2)
-            return last;
-
-        while (first != last)
-        {
-            if (*first > *(++first))
-                return first;
-        }
+        using value_type = typename iterator_traits<ForwardIterator>::value_type;
 
-        return last;
+        return is_sorted_until(first, last, less<value_type>{});
     }
 
     template<class ForwardIterator, class Comp>
     ForwardIterator is_sorted_until(ForwardIterator first, ForwardIterator last,
                                     Comp comp)
     {
-        if (distance(first, last) < 2)
+        if (first == last)
             return last;
 
-        while (first != last)
+        auto next = first;
+        while (++next != last)
         {
-            if (!comp(*first, *(++first)))
-                return first;
+            if (comp(*next, *first))
+                return next;
+            first = next;
         }
 
         return last;
     }
 
+    template<class ForwardIterator>
+    bool is_sorted(ForwardIterator first, ForwardIterator last)
+    {
+        return is_sorted_until(first, last) == last;
+    }
+
+    template<class ForwardIterator, class Comp>
+    bool is_sorted(ForwardIterator first, ForwardIterator last,
+                   Comp comp)
+    {
+        return is_sorted_until(first, last, comp) == last;
+    }
+
     /**
      * 25.4.2, nth_element:
      */
 
-    // TODO: implement
+    template<class RandomAccessIterator>
+    void nth_element(RandomAccessIterator first, RandomAccessIterator nth,
+                     RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        nth_element(first, nth, last, less<value_type>{});
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void nth_element(RandomAccessIterator first, RandomAccessIterator nth,
+                     RandomAccessIterator last, Compare comp)
+    {
+        if (first == last || nth == last)
+            return;
+
+        /**
+         * Introselect: partition like sort does but only
+         * continue with the part containing nth, use heap
+         * selection if the pivots keep being bad.
+         */
+        auto depth_limit = aux::sort_depth_limit(last - first);
+        while (last - first > 3)
+        {
+            if (depth_limit == 0)
+            {
+                partial_sort(first, nth + 1, last, comp);
+
+                return;
+            }
+            --depth_limit;
+
+            auto cut = aux::partition_pivot(first, last, comp);
+            if (cut <= nth)
+                first = cut;
+            else
+                last = cut;
+        }
+
+        aux::insertion_sort(first, last, comp);
+    }
 
     /**
      * 25.4.3, binary search:
@@ -792,31 +1264,167 @@ namespace std
      * 25.4.3.1, lower_bound
      */
 
-    // TODO: implement
+    template<class ForwardIterator, class T>
+    ForwardIterator lower_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value)
+    {
+        return lower_bound(first, last, value, less<void>{});
+    }
+
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator lower_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value, Compare comp)
+    {
+        auto count = distance(first, last);
+        while (count > 0)
+        {
+            auto half = count / 2;
+            auto mid = first;
+            advance(mid, half);
+
+            if (comp(*mid, value))
+            {
+                first = ++mid;
+                count -= half + 1;
+            }
+            else
+                count = half;
+        }
+
+        return first;
+    }
 
     /**
      * 25.4.3.2, upper_bound
      */
 
-    // TODO: implement
+    template<class ForwardIterator, class T>
+    ForwardIterator upper_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value)
+    {
+        return upper_bound(first, last, value, less<void>{});
+    }
+
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator upper_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value, Compare comp)
+    {
+        auto count = distance(first, last);
+        while (count > 0)
+        {
+            auto half = count / 2;
+            auto mid = first;
+            advance(mid, half);
+
+            if (!comp(value, *mid))
+            {
+                first = ++mid;
+                count -= half + 1;
+            }
+            else
+                count = half;
+        }
+
+        return first;
+    }
 
     /**
      * 25.4.3.3, equal_range:
      */
 
-    // TODO: implement
+    template<class ForwardIterator, class T>
+    pair<ForwardIterator, ForwardIterator>
+    equal_range(ForwardIterator first, ForwardIterator last, const T& value)
+    {
+        return equal_range(first, last, value, less<void>{});
+    }
+
+    template<class ForwardIterator, class T, class Compare>
+    pair<ForwardIterator, ForwardIterator>
+    equal_range(ForwardIterator first, ForwardIterator last,
+                const T& value, Compare comp)
+    {
+        auto lower = lower_bound(first, last, value, comp);
+
+        return make_pair(lower, upper_bound(lower, last, value, comp));
+    }
 
     /**
      * 25.4.3.4, binary_search:
      */
 
-    // TODO: implement
+    template<class ForwardIterator, class T>
+    bool binary_search(ForwardIterator first, ForwardIterator last,
+                       const T& value)
+    {
+        return binary_search(first, last, value, less<void>{});
+    }
+
+    template<class ForwardIterator, class T, class Compare>
+    bool binary_search(ForwardIterator first, ForwardIterator last,
+                       const T& value, Compare comp)
+    {
+        auto it = lower_bound(first, last, value, comp);
+
+        return it != last && !comp(value, *it);
+    }
 
     /**
      * 25.4.4, merge:
      */
 
-    // TODO: implement
+    template<class InputIterator1, class InputIterator2, class OutputIterator>
+    OutputIterator merge(InputIterator1 first1, InputIterator1 last1,
+                         InputIterator2 first2, InputIterator2 last2,
+                         OutputIterator result)
+    {
+        return merge(first1, last1, first2, last2, result, less<void>{});
+    }
+
+    template<class InputIterator1, class InputIterator2,
+             class OutputIterator, class Compare>
+    OutputIterator merge(InputIterator1 first1, InputIterator1 last1,
+                         InputIterator2 first2, InputIterator2 last2,
+                         OutputIterator result, Compare comp)
+    {
+        while (first1 != last1 && first2 != last2)
+        {
+            if (comp(*first2, *first1))
+                *result++ = *first2++;
+            else
+                *result++ = *first1++;
+        }
+
+        return copy(first2, last2, copy(first1, last1, result));
+    }
+
+    template<class BidirectionalIterator>
+    void inplace_merge(BidirectionalIterator first,
+                       BidirectionalIterator middle,
+                       BidirectionalIterator last)
+    {
+        using value_type = typename iterator_traits<BidirectionalIterator>::value_type;
+
+        inplace_merge(first, middle, last, less<value_type>{});
+    }
+
+    template<class BidirectionalIterator, class Compare>
+    void inplace_merge(BidirectionalIterator first,
+                       BidirectionalIterator middle,
+                       BidirectionalIterator last, Compare comp)
+    {
+        using value_type = typename iterator_traits<BidirectionalIterator>::value_type;
+
+        auto len1 = distance(first, middle);
+        auto len2 = distance(middle, last);
+        if (len1 == 0 || len2 == 0)
+            return;
+
+        auto buffer = get_temporary_buffer<value_type>(len1);
+        aux::merge_adaptive(first, middle, last, len1, len2, buffer.first,
+                            decltype(len1){buffer.second}, comp);
+        return_temporary_buffer(buffer.first);
+    }
 
     /**
      * 25.4.5, set operations on sorted structures:
@@ -883,32 +1491,27 @@ namespace std
             using aux::heap_left_child;
             using aux::heap_right_child;
 
-            auto left = heap_left_child(idx);
-            auto right = heap_right_child(idx);
-
-            bool left_incorrect{comp(first[idx], first[left])};
-            bool right_incorrect{comp(first[idx], first[right])};
-            while ((left < count && left_incorrect) ||
-                   (right < count && right_incorrect))
+            /**
+             * Sift the element down, swapping it with its larger
+             * child. Children at or past count are not part of
+             * the heap and must not be accessed.
+             */
+            while (true)
             {
-                if (right >= count || (left_incorrect && comp(first[right], first[left])))
-                {
-                    swap(first[idx], first[left]);
-
-                    idx = left;
-                }
-                else if (right < count && right_incorrect)
-                {
-                    swap(first[idx], first[right]);
+                auto left = heap_left_child(idx);
+                auto right = heap_right_child(idx);
+                auto largest = idx;
 
-                    idx = right;
-                } // Else should not happen because of the while condition.
+                if (left < count && comp(first[largest], first[left]))
+                    largest = left;
+                if (right < count && comp(first[largest], first[right]))
+                    largest = right;
 
-                left = heap_left_child(idx);
-                right = heap_right_child(idx);
+                if (largest == idx)
+                    return;
 
-                left_incorrect = comp(first[idx], first[left]);
-                right_incorrect = comp(first[idx], first[right]);
+                swap(first[idx], first[largest]);
+                idx = largest;
             }
         }
     }
@@ -971,7 +1574,7 @@ namespace std
             return;
 
         swap(first[0], first[count - 1]);
-        aux::correct_children(first, decltype(count){}, count - 2, comp);
+        aux::correct_children(first, decltype(count){}, count - 1, comp);
     }
 
     /**
@@ -996,7 +1599,8 @@ namespace std
         if (count <= 1)
             return;
 
-        for (auto i = count; i > 0; --i)
+        // Leaves are heaps already.
+        for (auto i = count / 2; i > 0; --i)
         {
             auto idx = i - 1;
 
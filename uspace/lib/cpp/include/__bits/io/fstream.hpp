@@ -29,10 +29,12 @@
 #ifndef LIBCPP_BITS_IO_FSTREAM
 #define LIBCPP_BITS_IO_FSTREAM
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
 #include <ios>
 #include <iosfwd>
+#include <iostream>
 #include <locale>
 #include <streambuf>
 #include <string>
@@ -64,20 +66,19 @@ namespace std
             basic_filebuf(const basic_filebuf&) = delete;
 
             basic_filebuf(basic_filebuf&& other)
-                : mode_{other.mode_}
+                : basic_streambuf<char_type, traits_type>{},
+                  obuf_{nullptr}, ibuf_{nullptr}, mode_{}, file_{nullptr}
             {
-                close();
-                std::swap(obuf_, other.obuf_);
-                std::swap(ibuf_, other.ibuf_);
-                std::swap(file_, other.file_);
-
-                basic_streambuf<char_type, traits_type>::swap(other);
+                swap(other);
             }
 
             virtual ~basic_filebuf()
             {
                 // TODO: exception here caught and not rethrown
                 close();
+
+                delete[] ibuf_;
+                delete[] obuf_;
             }
 
             /**
@@ -99,6 +100,7 @@ namespace std
                 std::swap(mode_, rhs.mode_);
                 std::swap(obuf_, rhs.obuf_);
                 std::swap(ibuf_, rhs.ibuf_);
+                std::swap(file_, rhs.file_);
 
                 basic_streambuf<char_type, traits_type>::swap(rhs);
             }
@@ -128,6 +130,13 @@ namespace std
                 if (!file_)
                     return nullptr;
 
+                /**
+                 * Note: We do our own buffering, so the FILE is made
+                 *       unbuffered and fread/fwrite go straight to
+                 *       the file system without an extra copy.
+                 */
+                setvbuf(file_, nullptr, ::helenos::_IONBF, 0);
+
                 if ((mode_ & ios_base::ate) != 0)
                 {
                     if (fseek(file_, 0, SEEK_END) != 0)
@@ -138,7 +147,7 @@ namespace std
                 }
 
                 if (!ibuf_ && mode_is_in_(mode_))
-                    ibuf_ = new char_type[buf_size_];
+                    ibuf_ = new char_type[putback_size_ + buf_size_];
                 if (!obuf_ && mode_is_out_(mode_))
                     obuf_ = new char_type[buf_size_];
                 init_();
@@ -156,15 +165,19 @@ namespace std
                 // TODO: caught exceptions are to be rethrown after closing the file
                 if (!file_)
                     return nullptr;
-                // TODO: deallocate buffers?
 
-                if (this->output_next_ != this->output_begin_)
-                    overflow(traits_type::eof());
+                bool flushed = flush_();
                 // TODO: unshift? (p. 1084 at the top)
 
-                fclose(file_);
+                auto res = fclose(file_);
                 file_ = nullptr;
 
+                this->input_begin_ = this->input_next_ = this->input_end_ = nullptr;
+                this->output_begin_ = this->output_next_ = this->output_end_ = nullptr;
+
+                if (!flushed || res != 0)
+                    return nullptr;
+
                 return this;
             }
 
@@ -173,50 +186,101 @@ namespace std
              * 27.9.1.5, overriden virtual functions:
              */
 
+            streamsize showmanyc() override
+            {
+                if (!file_ || !mode_is_in_(mode_) || !flush_())
+                    return -1;
+
+                auto cur = ftell(file_);
+                if (cur < 0 || fseek(file_, 0, SEEK_END) != 0)
+                    return 0;
+
+                auto end = ftell(file_);
+                fseek(file_, cur, SEEK_SET);
+
+                if (end <= cur)
+                    return -1;
+
+                return static_cast<streamsize>((end - cur) / sizeof(char_type));
+            }
+
             int_type underflow() override
             {
                 // TODO: use codecvt
-                if (!mode_is_in_(mode_))
+                if (!file_ || !mode_is_in_(mode_) || !begin_input_())
                     return traits_type::eof();
 
+                if (this->read_avail_())
+                    return traits_type::to_int_type(*this->input_next_);
+
                 if (!ibuf_)
+                    ibuf_ = new char_type[putback_size_ + buf_size_];
+
+                /**
+                 * Note: The tail of the previous block is kept in front
+                 *       of the new one, so that putback keeps working
+                 *       across block boundaries.
+                 */
+                size_t putback{};
+                if (this->input_next_)
                 {
-                    ibuf_ = new char_type[buf_size_];
-                    this->input_begin_ = this->input_next_ = this->input_end_ = ibuf_;
+                    putback = min(
+                        putback_size_,
+                        static_cast<size_t>(this->input_next_ - this->input_begin_)
+                    );
+                    traits_type::move(
+                        ibuf_ + putback_size_ - putback,
+                        this->input_next_ - putback, putback
+                    );
                 }
 
-                off_type i{};
-                if (this->input_next_ < this->input_end_)
-                {
-                    auto idx = static_cast<off_type>(this->input_next_ - this->input_begin_);
-                    auto count = static_cast<off_type>(buf_size_) - idx;
+                auto count = fread(ibuf_ + putback_size_, sizeof(char_type), buf_size_, file_);
 
-                    for (; i < count; ++i, ++idx)
-                        ibuf_[i] = ibuf_[idx];
-                }
+                this->input_begin_ = ibuf_ + putback_size_ - putback;
+                this->input_next_ = ibuf_ + putback_size_;
+                this->input_end_ = this->input_next_ + count;
 
-                for (; i < static_cast<off_type>(buf_size_); ++i)
-                {
-                    auto c = fgetc(file_);
-                    if (c == traits_type::eof())
-                        break;
+                if (count == 0)
+                    return traits_type::eof();
+
+                return traits_type::to_int_type(*this->input_next_);
+            }
 
-                    ibuf_[i] = static_cast<char_type>(c);
+            streamsize xsgetn(char_type* s, streamsize n) override
+            {
+                if (!s || n <= 0 || !file_ || !mode_is_in_(mode_) || !begin_input_())
+                    return 0;
 
-                    if (ibuf_[i] == '\n')
+                streamsize copied{};
+                while (copied < n)
+                {
+                    if (!this->read_avail_())
                     {
-                        ++i;
-                        break;
+                        /**
+                         * Large reads go directly to the destination,
+                         * copying them through our buffer would only
+                         * cost time.
+                         */
+                        if (static_cast<size_t>(n - copied) >= buf_size_)
+                        {
+                            copied += read_direct_(s + copied, n - copied);
+                            break;
+                        }
+
+                        if (traits_type::eq_int_type(underflow(), traits_type::eof()))
+                            break;
                     }
-                }
 
-                this->input_next_ = this->input_begin_;
-                this->input_end_ = this->input_begin_ + i;
+                    auto count = min(n - copied, static_cast<streamsize>(
+                        this->input_end_ - this->input_next_
+                    ));
+                    traits_type::copy(s + copied, this->input_next_, count);
 
-                if (i == 0)
-                    return traits_type::eof();
+                    this->input_next_ += count;
+                    copied += count;
+                }
 
-                return traits_type::to_int_type(*this->input_next_);
+                return copied;
             }
 
             int_type pbackfail(int_type c = traits_type::eof()) override
@@ -251,18 +315,60 @@ namespace std
             int_type overflow(int_type c = traits_type::eof()) override
             {
                 // TODO: use codecvt
-                if (!mode_is_out_(mode_))
+                if (!file_ || !mode_is_out_(mode_))
                     return traits_type::eof();
 
-                auto count = static_cast<size_t>(this->output_next_ - this->output_begin_);
-                fwrite(obuf_, sizeof(char_type), count, file_);
-                fflush(file_);
+                if (!flush_() || !begin_output_())
+                    return traits_type::eof();
 
-                this->output_next_ = this->output_begin_;
+                if (!traits_type::eq_int_type(c, traits_type::eof()))
+                    *this->output_next_++ = traits_type::to_char_type(c);
 
                 return traits_type::not_eof(c);
             }
 
+            streamsize xsputn(const char_type* s, streamsize n) override
+            {
+                if (!s || n <= 0 || !file_ || !mode_is_out_(mode_) || !begin_output_())
+                    return 0;
+
+                auto space = static_cast<streamsize>(
+                    this->output_end_ - this->output_next_
+                );
+                if (n <= space)
+                {
+                    traits_type::copy(this->output_next_, s, n);
+                    this->output_next_ += n;
+
+                    return n;
+                }
+
+                /**
+                 * Large writes bypass the buffer, we only have to
+                 * write out whatever is already buffered first.
+                 */
+                if (static_cast<size_t>(n) >= buf_size_)
+                {
+                    if (!flush_())
+                        return 0;
+
+                    return static_cast<streamsize>(
+                        fwrite(s, sizeof(char_type), n, file_)
+                    );
+                }
+
+                traits_type::copy(this->output_next_, s, space);
+                this->output_next_ += space;
+
+                if (traits_type::eq_int_type(overflow(), traits_type::eof()))
+                    return space;
+
+                traits_type::copy(this->output_next_, s + space, n - space);
+                this->output_next_ += n - space;
+
+                return n;
+            }
+
             basic_streambuf<char_type, traits_type>*
             setbuf(char_type* s, streamsize n) override
             {
@@ -274,25 +380,69 @@ namespace std
             pos_type seekoff(off_type off, ios_base::seekdir dir,
                              ios_base::openmode mode = ios_base::in | ios_base::out) override
             {
-                // TODO: implement
-                __unimplemented();
-                return pos_type{};
+                // TODO: use codecvt
+                if (!file_ || !flush_())
+                    return pos_type(off_type(-1));
+
+                /**
+                 * The file position is ahead of the logical
+                 * position by the characters we have buffered
+                 * but not yet handed out.
+                 */
+                off_type unread{};
+                if (this->read_avail_())
+                    unread = static_cast<off_type>(this->input_end_ - this->input_next_);
+
+                /**
+                 * Note: This is how tellg and tellp are implemented,
+                 *       so we answer without dropping the buffer.
+                 */
+                if (dir == ios_base::cur && off == 0)
+                {
+                    auto pos = ftell(file_);
+                    if (pos < 0)
+                        return pos_type(off_type(-1));
+
+                    return pos_type(pos / sizeof(char_type) - unread);
+                }
+
+                int whence{SEEK_SET};
+                if (dir == ios_base::cur)
+                {
+                    whence = SEEK_CUR;
+                    off -= unread;
+                }
+                else if (dir == ios_base::end)
+                    whence = SEEK_END;
+
+                if (this->input_next_)
+                {
+                    this->input_begin_ = this->input_next_ =
+                        this->input_end_ = ibuf_ + putback_size_;
+                }
+
+                if (fseek(file_, off * sizeof(char_type), whence) != 0)
+                    return pos_type(off_type(-1));
+
+                auto pos = ftell(file_);
+                if (pos < 0)
+                    return pos_type(off_type(-1));
+
+                return pos_type(pos / sizeof(char_type));
             }
 
             pos_type seekpos(pos_type pos,
                              ios_base::openmode mode = ios_base::in | ios_base::out) override
             {
-                // TODO: implement
-                __unimplemented();
-                return pos_type{};
+                return seekoff(off_type(pos), ios_base::beg, mode);
             }
 
             int sync() override
             {
-                if (mode_is_out_(mode_))
-                    overflow();
+                if (!file_)
+                    return 0;
 
-                return 0; // TODO: what is the correct return value?
+                return flush_() ? 0 : -1;
             }
 
             void imbue(const locale& loc) override
@@ -309,7 +459,12 @@ namespace std
 
             FILE* file_;
 
-            static constexpr size_t buf_size_{128};
+            /**
+             * Note: Transfers of at least buf_size_ characters bypass
+             *       the buffer in xsgetn and xsputn.
+             */
+            static constexpr size_t buf_size_{4 * BUFSIZ / sizeof(char_type)};
+            static constexpr size_t putback_size_{8};
 
             const char* get_mode_str_(ios_base::openmode mode)
             {
@@ -366,7 +521,10 @@ namespace std
             void init_()
             {
                 if (ibuf_)
-                    this->input_begin_ = this->input_next_ = this->input_end_ = ibuf_;
+                {
+                    this->input_begin_ = this->input_next_ =
+                        this->input_end_ = ibuf_ + putback_size_;
+                }
 
                 if (obuf_)
                 {
@@ -374,6 +532,95 @@ namespace std
                     this->output_end_ = obuf_ + buf_size_;
                 }
             }
+
+            /**
+             * Writes out the put area.
+             */
+            bool flush_()
+            {
+                auto count = static_cast<size_t>(this->output_next_ - this->output_begin_);
+                this->output_next_ = this->output_begin_;
+
+                if (count == 0)
+                    return true;
+
+                return fwrite(obuf_, sizeof(char_type), count, file_) == count;
+            }
+
+            /**
+             * The buffer is either in output mode, where the put area
+             * may hold pending characters and the get area is empty,
+             * or in input mode, where the get area may hold unread
+             * characters and the put area has no room, so that every
+             * put goes through overflow. Switching to output moves the
+             * file position back over the unread input, switching to
+             * input writes out the pending output.
+             */
+            bool begin_output_()
+            {
+                if (this->output_begin_ != this->output_end_)
+                    return true;
+
+                if (!discard_input_())
+                    return false;
+
+                if (!obuf_)
+                    obuf_ = new char_type[buf_size_];
+
+                this->output_begin_ = this->output_next_ = obuf_;
+                this->output_end_ = obuf_ + buf_size_;
+
+                return true;
+            }
+
+            bool begin_input_()
+            {
+                if (!flush_())
+                    return false;
+
+                this->output_begin_ = this->output_next_ = this->output_end_ = obuf_;
+
+                return true;
+            }
+
+            /**
+             * Drops the get area and moves the file position back
+             * to the first character that was not read yet, which
+             * is where a following write has to go.
+             */
+            bool discard_input_()
+            {
+                if (!this->input_next_)
+                    return true;
+
+                auto unread = static_cast<long>(this->input_end_ - this->input_next_);
+                this->input_begin_ = this->input_next_ =
+                    this->input_end_ = ibuf_ + putback_size_;
+
+                if (unread == 0)
+                    return true;
+
+                return fseek(file_, -unread * static_cast<long>(sizeof(char_type)), SEEK_CUR) == 0;
+            }
+
+            streamsize read_direct_(char_type* s, streamsize n)
+            {
+                auto count = fread(s, sizeof(char_type), n, file_);
+
+                /**
+                 * Keep the tail of what we read for putback.
+                 */
+                if (ibuf_)
+                {
+                    auto putback = min(putback_size_, count);
+                    traits_type::copy(ibuf_ + putback_size_ - putback, s + count - putback, putback);
+
+                    this->input_begin_ = ibuf_ + putback_size_ - putback;
+                    this->input_next_ = this->input_end_ = ibuf_ + putback_size_;
+                }
+
+                return static_cast<streamsize>(count);
+            }
     };
 
     template<class Char, class Traits>
@@ -604,17 +604,9 @@ namespace std
                     return *this;
                 }
 
-                while (gcount_ < n)
-                {
-                    auto c = this->rdbuf()->sbumpc();
-                    if (traits_type::eq_int_type(c, traits_type::eof()))
-                    {
-                        this->setstate(ios_base::failbit | ios_base::eofbit);
-                        break;
-                    }
-
-                    s[gcount_++] = traits_type::to_char_type(c);
-                }
+                gcount_ = this->rdbuf()->sgetn(s, n);
+                if (gcount_ < n)
+                    this->setstate(ios_base::failbit | ios_base::eofbit);
 
                 return *this;
             }
@@ -731,7 +723,7 @@ namespace std
                 sentry sen{*this, true};
 
                 if (!this->fail())
-                    this->rdbuf()->pubseekoff(pos, ios_base::in);
+                    this->rdbuf()->pubseekpos(pos, ios_base::in);
                 else
                     this->setstate(ios_base::failbit);
 
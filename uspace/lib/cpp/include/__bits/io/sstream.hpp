@@ -72,9 +72,13 @@ namespace std
             basic_stringbuf(const basic_stringbuf&) = delete;
 
             basic_stringbuf(basic_stringbuf&& other)
-                : mode_{move(other.mode_)}, str_{move(other.str_)}
+                : mode_{move(other.mode_)}, str_{}
             {
+                auto base = other.str_.begin();
+                str_ = move(other.str_);
+
                 basic_streambuf<char_type, traits_type>::swap(other);
+                rebase_(base);
             }
 
             /**
@@ -90,10 +94,15 @@ namespace std
 
             void swap(basic_stringbuf& rhs)
             {
+                auto base = str_.begin();
+                auto rhs_base = rhs.str_.begin();
+
                 std::swap(mode_, rhs.mode_);
                 std::swap(str_, rhs.str_);
 
                 basic_streambuf<char_type, traits_type>::swap(rhs);
+                rebase_(rhs_base);
+                rhs.rebase_(base);
             }
 
             /**
@@ -250,9 +259,37 @@ namespace std
                 }
             }
 
+            /**
+             * Short strings are stored inside the string object,
+             * so moving str_ can move the buffer our get and put
+             * areas point to.
+             */
+            void rebase_(char_type* old_base)
+            {
+                auto base = str_.begin();
+                if (base == old_base)
+                    return;
+
+                if (this->input_begin_)
+                {
+                    this->input_next_ = base + (this->input_next_ - old_base);
+                    this->input_end_ = base + (this->input_end_ - old_base);
+                    this->input_begin_ = base + (this->input_begin_ - old_base);
+                }
+
+                if (this->output_begin_)
+                {
+                    this->output_next_ = base + (this->output_next_ - old_base);
+                    this->output_end_ = base + (this->output_end_ - old_base);
+                    this->output_begin_ = base + (this->output_begin_ - old_base);
+                }
+            }
+
             bool ensure_free_space_(size_t n = 1)
             {
+                auto base = str_.begin();
                 str_.ensure_free_space_(n);
+                rebase_(base);
                 this->output_end_ = str_.begin() + str_.capacity();
 
                 return true;
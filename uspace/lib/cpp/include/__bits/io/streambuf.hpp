@@ -337,12 +337,18 @@ namespace std
 
                 streamsize i{0};
                 auto eof = traits_type::eof();
-                for (; i <= n; ++i)
+                for (; i < n; ++i)
                 {
-                    if (!read_avail_() && traits_type::eq_int_type(uflow(), eof))
-                        break;
-
-                    *s++ = *input_next_++;
+                    if (read_avail_())
+                        *s++ = *input_next_++;
+                    else
+                    {
+                        auto c = uflow();
+                        if (traits_type::eq_int_type(c, eof))
+                            break;
+
+                        *s++ = traits_type::to_char_type(c);
+                    }
                 }
 
                 return i;
@@ -381,12 +387,13 @@ namespace std
                     return 0;
 
                 streamsize i{0};
-                for (; i <= n; ++i)
+                auto eof = traits_type::eof();
+                for (; i < n; ++i, ++s)
                 {
-                    if (!write_avail_() && traits_type::eq_int_type(overflow(), traits_type::eof()))
+                    if (write_avail_())
+                        *output_next_++ = *s;
+                    else if (traits_type::eq_int_type(overflow(traits_type::to_int_type(*s)), eof))
                         break;
-
-                    *output_next_++ = *s++;
                 }
 
                 return i;
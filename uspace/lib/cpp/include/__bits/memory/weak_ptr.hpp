@@ -212,7 +212,7 @@ namespace std
             void remove_payload_()
             {
                 if (payload_ && payload_->decrement_weak())
-                    payload_->destroy();
+                    delete payload_;
                 payload_ = nullptr;
             }
 
@@ -29,12 +29,10 @@
 #ifndef LIBCPP_BITS_REFCOUNT_OBJ
 #define LIBCPP_BITS_REFCOUNT_OBJ
 
+#include <__bits/atomic.hpp>
+
 namespace std::aux
 {
-    /**
-     * At the moment we do not have atomics, change this
-     * to std::atomic<long> once we do.
-     */
     using refcount_t = long;
 
     class refcount_obj
@@ -60,9 +58,12 @@ namespace std::aux
              * this makes it easier for weak_ptrs that
              * can't decrement the weak_refcount_ to
              * zero with shared_ptrs using this object.
+             * The owner of that extra reference drops
+             * it in destroy(), so whoever decrements
+             * weak_refcount_ to zero frees the object.
              */
-            refcount_t refcount_{1};
-            refcount_t weak_refcount_{1};
+            atomic<refcount_t> refcount_{1};
+            atomic<refcount_t> weak_refcount_{1};
     };
 }
 
@@ -470,7 +470,8 @@ namespace std
             { /* DUMMY BODY */ }
 
             explicit basic_string(const allocator_type& alloc)
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
                 /**
                  * Postconditions:
@@ -478,29 +479,27 @@ namespace std
                  *  size() = 0
                  *  capacity() = unspecified
                  */
-                data_ = allocator_.allocate(default_capacity_);
-                capacity_ = default_capacity_;
+                ensure_null_terminator_();
             }
 
             basic_string(const basic_string& other)
-                : data_{}, size_{other.size_}, capacity_{other.capacity_},
+                : data_{local_}, size_{}, capacity_{local_capacity_},
                   allocator_{other.allocator_}
             {
-                init_(other.data(), size_);
+                init_(other.data(), other.size());
             }
 
-            basic_string(basic_string&& other)
-                : data_{other.data_}, size_{other.size_},
-                  capacity_{other.capacity_}, allocator_{move(other.allocator_)}
+            basic_string(basic_string&& other) noexcept
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{move(other.allocator_)}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                steal_(other);
             }
 
             basic_string(const basic_string& other, size_type pos, size_type n = npos,
                          const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
                 // TODO: if pos < other.size() throw out_of_range.
                 auto len = min(n, other.size() - pos);
@@ -508,40 +507,38 @@ namespace std
             }
 
             basic_string(const value_type* str, size_type n, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
-                init_(str, size_);
+                init_(str, n);
             }
 
             basic_string(const value_type* str, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
                 init_(str, traits_type::length(str));
             }
 
             basic_string(size_type n, value_type c, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
-                data_ = allocator_.allocate(capacity_);
-                for (size_type i = 0; i < size_; ++i)
-                    traits_type::assign(data_[i], c);
-                ensure_null_terminator_();
+                init_(n, c);
             }
 
             template<class InputIterator>
             basic_string(InputIterator first, InputIterator last,
                          const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
                 if constexpr (is_integral<InputIterator>::value)
                 { // Required by the standard.
-                    size_ = static_cast<size_type>(first);
-                    capacity_ = size_;
-                    data_ = allocator_.allocate(capacity_);
-
-                    for (size_type i = 0; i < size_; ++i)
-                        traits_type::assign(data_[i], static_cast<value_type>(last));
-                    ensure_null_terminator_();
+                    init_(
+                        static_cast<size_type>(first),
+                        static_cast<value_type>(last)
+                    );
                 }
                 else
                 {
@@ -555,22 +552,22 @@ namespace std
             { /* DUMMY BODY */ }
 
             basic_string(const basic_string& other, const allocator_type& alloc)
-                : data_{}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
-                init_(other.data(), size_);
+                init_(other.data(), other.size());
             }
 
             basic_string(basic_string&& other, const allocator_type& alloc)
-                : data_{other.data_}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : data_{local_}, size_{}, capacity_{local_capacity_},
+                  allocator_{alloc}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                steal_(other);
             }
 
             ~basic_string()
             {
-                allocator_.deallocate(data_, capacity_);
+                deallocate_();
             }
 
             basic_string& operator=(const basic_string& other)
@@ -603,7 +600,7 @@ namespace std
 
             basic_string& operator=(value_type c)
             {
-                *this = basic_string{1, c};
+                *this = basic_string(1, c);
 
                 return *this;
             }
@@ -704,9 +701,9 @@ namespace std
                 // TODO: if new_size > max_size() throw length_error.
                 if (new_size > size_)
                 {
-                    ensure_free_space_(new_size - size_ + 1);
+                    ensure_free_space_(new_size - size_);
                     for (size_type i = size_; i < new_size; ++i)
-                        traits_type::assign(data_[i], i);
+                        traits_type::assign(data_[i], c);
                 }
 
                 size_ = new_size;
@@ -720,7 +717,8 @@ namespace std
 
             size_type capacity() const noexcept
             {
-                return capacity_;
+                // The null terminator does not count.
+                return capacity_ - 1;
             }
 
             void reserve(size_type new_capacity = 0)
@@ -728,21 +726,22 @@ namespace std
                 // TODO: if new_capacity > max_size() throw
                 //       length_error (this function shall have no
                 //       effect in such case)
-                if (new_capacity > capacity_)
-                    resize_with_copy_(size_, new_capacity);
-                else if (new_capacity < capacity_)
+                if (new_capacity > capacity())
+                    reallocate_(new_capacity + 1);
+                else if (new_capacity < capacity())
                     shrink_to_fit(); // Non-binding request, but why not.
             }
 
             void shrink_to_fit()
             {
-                if (size_ != capacity_)
-                    resize_with_copy_(size_, capacity_);
+                if (!is_local_() && size_ + 1 < capacity_)
+                    reallocate_(size_ + 1);
             }
 
             void clear() noexcept
             {
                 size_ = 0;
+                ensure_null_terminator_();
             }
 
             bool empty() const noexcept
@@ -907,8 +906,16 @@ namespace std
             basic_string& assign(const value_type* str, size_type n)
             {
                 // TODO: if (n > max_size()) throw length_error.
-                resize_without_copy_(n);
-                traits_type::copy(begin(), str, n);
+                if (n + 1 > capacity_)
+                {
+                    basic_string tmp{str, n, allocator_};
+                    swap(tmp);
+
+                    return *this;
+                }
+
+                // The source may be a part of this string.
+                traits_type::move(begin(), str, n);
                 size_ = n;
                 ensure_null_terminator_();
 
@@ -1083,7 +1090,7 @@ namespace std
                 auto len = min(n1, size_ - pos);
 
                 basic_string tmp{};
-                tmp.resize_without_copy_(size_ - len + n2);
+                tmp.resize_without_copy_(size_ - len + n2 + 1);
 
                 // Prefix.
                 copy_(begin(), begin() + pos, tmp.begin());
@@ -1095,6 +1102,7 @@ namespace std
                 copy_(begin() + pos + len, end(), tmp.begin() + pos + n2);
 
                 tmp.size_ = size_ - len + n2;
+                tmp.ensure_null_terminator_();
                 swap(tmp);
                 return *this;
             }
@@ -1160,9 +1168,17 @@ namespace std
                 noexcept(allocator_traits<allocator_type>::propagate_on_container_swap::value ||
                          allocator_traits<allocator_type>::is_always_equal::value)
             {
-                std::swap(data_, other.data_);
-                std::swap(size_, other.size_);
-                std::swap(capacity_, other.capacity_);
+                if (this == &other)
+                    return;
+
+                /**
+                 * Local buffers cannot be exchanged by swapping
+                 * pointers, but moving never allocates.
+                 */
+                basic_string tmp{allocator_};
+                tmp.steal_(other);
+                other.steal_(*this);
+                steal_(tmp);
             }
 
             /**
@@ -1476,32 +1492,77 @@ namespace std
             }
 
         private:
+            /**
+             * Short strings (including the null terminator) are
+             * stored in local_ and data_ points to it, longer
+             * ones are on the heap. The capacity_ always counts
+             * the null terminator.
+             */
+            static constexpr size_type local_capacity_{
+                sizeof(value_type) < 16 ? 16 / sizeof(value_type) : 1
+            };
+
             value_type* data_;
             size_type size_;
             size_type capacity_;
             allocator_type allocator_;
+            value_type local_[local_capacity_];
 
             template<class C, class T, class A>
             friend class basic_stringbuf;
 
+            bool is_local_() const noexcept
+            {
+                return data_ == local_;
+            }
+
+            void deallocate_()
+            {
+                if (!is_local_())
+                    allocator_.deallocate(data_, capacity_);
+            }
+
             /**
-             * Arbitrary value, standard just requires
-             * data() to have some capacity.
-             * (Well, we could've done data_ = &data_ and
-             * set capacity to 0, but that would be too cryptic.)
+             * Takes the contents of other, which is left empty.
+             * Our own buffer must not hold any memory.
              */
-            static constexpr size_type default_capacity_{4};
+            void steal_(basic_string& other) noexcept
+            {
+                if (other.is_local_())
+                {
+                    data_ = local_;
+                    capacity_ = local_capacity_;
+                    traits_type::copy(data_, other.data_, other.size_ + 1);
+                }
+                else
+                {
+                    data_ = other.data_;
+                    capacity_ = other.capacity_;
+                }
+                size_ = other.size_;
+
+                other.data_ = other.local_;
+                other.size_ = 0;
+                other.capacity_ = local_capacity_;
+                other.ensure_null_terminator_();
+            }
 
             void init_(const value_type* str, size_type size)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                resize_without_copy_(size + 1);
 
+                traits_type::copy(data_, str, size);
                 size_ = size;
-                capacity_ = size + 1;
+                ensure_null_terminator_();
+            }
 
-                data_ = allocator_.allocate(capacity_);
-                traits_type::copy(data_, str, size);
+            void init_(size_type size, value_type c)
+            {
+                resize_without_copy_(size + 1);
+
+                for (size_type i = 0; i < size; ++i)
+                    traits_type::assign(data_[i], c);
+                size_ = size;
                 ensure_null_terminator_();
             }
 
@@ -1521,37 +1582,53 @@ namespace std
                  *       reserve can cause shrinking.
                  */
                 if (size_ + 1 + n > capacity_)
-                    resize_with_copy_(size_, max(size_ + 1 + n, next_capacity_()));
+                    reallocate_(next_capacity_(size_ + 1 + n));
             }
 
+            /**
+             * Makes room for capacity characters (including
+             * the null terminator) without preserving contents,
+             * the buffer is only reallocated if it is too small.
+             * Callers set the size and the null terminator.
+             */
             void resize_without_copy_(size_type capacity)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                if (capacity > capacity_)
+                {
+                    auto new_data = allocator_.allocate(capacity);
+                    deallocate_();
+
+                    data_ = new_data;
+                    capacity_ = capacity;
+                }
 
-                data_ = allocator_.allocate(capacity);
                 size_ = 0;
-                capacity_ = capacity;
-                ensure_null_terminator_();
             }
 
-            void resize_with_copy_(size_type size, size_type capacity)
+            /**
+             * Moves the contents to a buffer for capacity
+             * characters (including the null terminator),
+             * which is the local one if they fit in it.
+             */
+            void reallocate_(size_type capacity)
             {
-                if(capacity_ == 0 || capacity_ < capacity)
+                value_type* new_data{};
+                if (capacity <= local_capacity_)
                 {
-                    auto new_data = allocator_.allocate(capacity);
-
-                    auto to_copy = min(size, size_);
-                    traits_type::move(new_data, data_, to_copy);
+                    if (is_local_())
+                        return;
 
-                    std::swap(data_, new_data);
-
-                    allocator_.deallocate(new_data, capacity_);
+                    new_data = local_;
+                    capacity = local_capacity_;
                 }
+                else
+                    new_data = allocator_.allocate(capacity);
 
+                traits_type::copy(new_data, data_, size_ + 1);
+                deallocate_();
+
+                data_ = new_data;
                 capacity_ = capacity;
-                size_ = size;
-                ensure_null_terminator_();
             }
 
             template<class Iterator1, class Iterator2>
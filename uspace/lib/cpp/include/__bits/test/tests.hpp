@@ -30,6 +30,7 @@
 #define LIBCPP_BITS_TEST_TESTS
 
 #include <__bits/test/test.hpp>
+#include <chrono>
 #include <cstdio>
 #include <vector>
 
@@ -123,6 +124,7 @@ namespace std::test
             void test_find();
             void test_substr();
             void test_compare();
+            void test_capacity();
     };
 
     class bitset_test: public test_suite
@@ -205,6 +207,7 @@ namespace std::test
             void test_histogram();
             void test_emplace_insert();
             void test_multi();
+            void test_flat();
     };
 
     class unordered_set_test: public test_suite
@@ -217,6 +220,7 @@ namespace std::test
             void test_constructors_and_assignment();
             void test_emplace_insert();
             void test_multi();
+            void test_flat();
     };
 
     class numeric_test: public test_suite
@@ -293,6 +297,38 @@ namespace std::test
         private:
             void test_non_modifying();
             void test_mutating();
+            void test_sorting();
+    };
+
+    class hash_bench: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+        private:
+            template<class Map>
+            void bench(const char*, const vector<int>&);
+    };
+
+    class iostream_bench: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+        private:
+            void bench_write(const char*, const vector<char>&, size_t);
+            void bench_read(const char*, const vector<char>&, size_t);
+            void report_result(const char*, chrono::steady_clock::time_point);
+    };
+
+    class sort_bench: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+        private:
+            template<class Sort>
+            void bench(const char*, const char*, const vector<int>&, Sort);
     };
 
     class future_test: public test_suite
@@ -307,6 +343,30 @@ namespace std::test
             void test_async();
             void test_packaged_task();
             void test_shared_future();
+            void test_thread_pool();
+    };
+
+    class fstream_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+        private:
+            void test_read_write();
+            void test_seek();
+            void test_putback();
+    };
+
+    class atomic_test: public test_suite
+    {
+        public:
+            bool run(bool) override;
+            const char* name() override;
+        private:
+            void test_integral();
+            void test_pointer();
+            void test_flag();
+            void test_shared_ptr();
     };
 }
 
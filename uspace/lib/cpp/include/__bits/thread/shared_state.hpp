@@ -38,6 +38,7 @@
 #include <__bits/functional/invoke.hpp>
 #include <__bits/refcount_obj.hpp>
 #include <__bits/thread/future_common.hpp>
+#include <__bits/thread/thread_pool.hpp>
 #include <__bits/thread/threading.hpp>
 #include <cerrno>
 #include <thread>
@@ -274,38 +275,30 @@ namespace std::aux
     {
         public:
             async_shared_state(F&& f, Args&&... args)
-                : shared_state<R>{}, thread_{}
+                : shared_state<R>{}
             {
-                thread_ = thread{
+                thread_pool::instance().submit(
                     [=](){
                         try
                         {
                             if constexpr (!is_same_v<R, void>)
-                                this->set_value(invoke(f, args...));
+                                this->value_ = invoke(f, args...);
                             else
-                            {
                                 invoke(f, args...);
-                                this->mark_set(true);
-                            }
                         }
                         catch(const exception& __exception)
                         {
                             this->set_exception(make_exception_ptr(__exception));
                         }
+
+                        this->notify_();
                     }
-                };
+                );
             }
 
             void destroy() override
             {
-                if (!this->is_set())
-                    thread_.join();
-            }
-
-            void wait() const override
-            {
-                if (!this->is_set())
-                    const_cast<thread&>(thread_).join();
+                this->wait();
             }
 
             ~async_shared_state() override
@@ -313,22 +306,19 @@ namespace std::aux
                 destroy();
             }
 
-        protected:
-            future_status timed_wait_(aux::time_unit_t time) const override
+        private:
+            void notify_()
             {
                 /**
-                 * Note: Currently we have no timed join, but this
-                 *       behaviour should be compliant.
+                 * Note: We broadcast with the mutex held and waiters
+                 *       always take the mutex before returning, so the
+                 *       state cannot be destroyed while we still use it.
                  */
-                aux::threading::time::sleep(time);
-                if (this->value_set_)
-                    return future_status::ready;
-                else
-                    return future_status::timeout;
+                aux::threading::mutex::lock(this->mutex_);
+                this->mark_set(true);
+                aux::threading::condvar::broadcast(this->condvar_);
+                aux::threading::mutex::unlock(this->mutex_);
             }
-
-        private:
-            thread thread_;
     };
 
     template<class R, class F, class... Args>
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_THREAD_THREAD_POOL
+#define LIBCPP_BITS_THREAD_THREAD_POOL
+
+#include <__bits/thread/threading.hpp>
+#include <__bits/utility/forward_move.hpp>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace std::aux
+{
+    /**
+     * Type erased move-only task, we cannot use function
+     * because it requires the target to be copyable and
+     * tasks like packaged_task are not.
+     */
+    class pool_task
+    {
+        public:
+            virtual void run() = 0;
+
+            virtual ~pool_task() = default;
+    };
+
+    template<class F>
+    class pool_task_impl: public pool_task
+    {
+        public:
+            template<class G>
+            pool_task_impl(G&& g)
+                : func_{forward<G>(g)}
+            { /* DUMMY BODY */ }
+
+            void run() override
+            {
+                func_();
+            }
+
+        private:
+            F func_;
+    };
+
+    /**
+     * Work stealing executor used by async(launch::async).
+     * Every worker owns a queue, tasks submitted by a worker
+     * go to its own queue and are taken from its back (which
+     * keeps the data they use in cache), other workers steal
+     * from the front when they run out of work. Tasks submitted
+     * from outside of the pool are distributed round-robin.
+     *
+     * The pool is created on first use with one worker per
+     * CPU and lives until the task terminates. Every queued
+     * task reserves a worker that is not running anything,
+     * when there is none (e.g. because all workers wait for
+     * other tasks) the task gets a thread of its own, so async
+     * tasks still run as if each had its own thread.
+     */
+    class thread_pool
+    {
+        public:
+            static thread_pool& instance();
+
+            template<class F>
+            void submit(F&& f)
+            {
+                push_(new pool_task_impl<decay_t<F>>{forward<F>(f)});
+            }
+
+            size_t size() const noexcept
+            {
+                return size_;
+            }
+
+            thread_pool(const thread_pool&) = delete;
+            thread_pool& operator=(const thread_pool&) = delete;
+
+        private:
+            struct worker;
+
+            worker* workers_;
+            size_t size_;
+
+            atomic<size_t> next_;
+
+            /**
+             * Number of workers that neither run a task
+             * nor are reserved by a queued one.
+             */
+            atomic<size_t> available_;
+
+            /**
+             * Number of queued tasks, idle workers sleep
+             * on the condvar while it is zero.
+             */
+            atomic<long> pending_;
+            aux::mutex_t idle_mtx_;
+            aux::condvar_t idle_cv_;
+
+            thread_pool(size_t size);
+
+            bool reserve_();
+            void push_(pool_task* task);
+            pool_task* pop_(size_t idx);
+            pool_task* steal_(size_t idx);
+            pool_task* take_(size_t idx);
+            void worker_main_(size_t idx);
+    };
+}
+
+#endif
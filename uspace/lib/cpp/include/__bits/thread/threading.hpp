@@ -209,13 +209,40 @@ namespace std::aux
         };
     };
 
+    /**
+     * Note: Kernel threads are not part of the public libc API,
+     *       fibrils are scheduled onto runners (kernel threads) by
+     *       libc instead. This policy therefore keeps the fibril
+     *       synchronization primitives (which work across runners),
+     *       but opts the task into multiple runners when the first
+     *       thread starts, so that threads actually execute in parallel.
+     */
     template<>
-    struct threading_policy<thread_tag>
+    struct threading_policy<thread_tag>: threading_policy<fibril_tag>
     {
-        // TODO:
+        struct thread: threading_policy<fibril_tag>::thread
+        {
+            static void start(thread_type thr)
+            {
+                enable_runners();
+                ::helenos::fibril_add_ready(thr);
+            }
+
+            private:
+                static void enable_runners();
+        };
     };
 
+    /**
+     * Note: Define LIBCPP_FIBRIL_THREADS to get the old
+     *       behaviour of running all threads within the
+     *       runners the task already has.
+     */
+#ifdef LIBCPP_FIBRIL_THREADS
     using default_tag = fibril_tag;
+#else
+    using default_tag = thread_tag;
+#endif
     using threading = threading_policy<default_tag>;
 
     using thread_t       = typename threading::thread_type;
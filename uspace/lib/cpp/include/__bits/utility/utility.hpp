@@ -219,7 +219,7 @@ namespace std
 
         template<typename U, typename V>
         constexpr pair(U&& x, V&& y)
-            : first(x), second(y)
+            : first(forward<U>(x)), second(forward<V>(y))
         { /* DUMMY BODY */ }
 
         template<typename U, typename V>
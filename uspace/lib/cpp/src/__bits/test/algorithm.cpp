@@ -29,8 +29,10 @@
 #include <__bits/test/tests.hpp>
 #include <algorithm>
 #include <array>
+#include <functional>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace std::test
 {
@@ -41,6 +43,7 @@ namespace std::test
 
         test_non_modifying();
         test_mutating();
+        test_sorting();
 
         return end();
     }
@@ -293,4 +296,143 @@ namespace std::test
         );
         test_eq("transform pt2", res6, data10.end());
     }
+
+    void algorithm_test::test_sorting()
+    {
+        auto check1 = {1, 1, 2, 3, 4, 5, 5, 6, 9};
+        auto check2 = {9, 6, 5, 5, 4, 3, 2, 1, 1};
+        std::array<int, 9> data1{5, 1, 4, 9, 2, 6, 5, 3, 1};
+
+        auto data2 = data1;
+        std::sort(data2.begin(), data2.end());
+        test_eq(
+            "sort pt1", check1.begin(), check1.end(),
+            data2.begin(), data2.end()
+        );
+
+        data2 = data1;
+        std::sort(data2.begin(), data2.end(), std::greater<int>{});
+        test_eq(
+            "sort pt2", check2.begin(), check2.end(),
+            data2.begin(), data2.end()
+        );
+
+        /**
+         * Large enough to go through partitioning, with
+         * many duplicates and a sorted start.
+         */
+        std::vector<int> data3{};
+        for (int i = 0; i < 1000; ++i)
+            data3.push_back(i < 300 ? i : (i * 7919) % 101);
+        std::sort(data3.begin(), data3.end());
+        test("sort pt3", std::is_sorted(data3.begin(), data3.end()));
+
+        std::vector<std::pair<int, int>> data4{};
+        for (int i = 0; i < 100; ++i)
+            data4.emplace_back((i * 37) % 10, i);
+        std::stable_sort(
+            data4.begin(), data4.end(),
+            [](const auto& lhs, const auto& rhs){
+                return lhs.first < rhs.first;
+            }
+        );
+        test("stable_sort pt1", std::is_sorted(data4.begin(), data4.end()));
+
+        data2 = data1;
+        std::stable_sort(data2.begin(), data2.end());
+        test_eq(
+            "stable_sort pt2", check1.begin(), check1.end(),
+            data2.begin(), data2.end()
+        );
+
+        auto check3 = {1, 1, 2, 3};
+        data2 = data1;
+        std::partial_sort(data2.begin(), data2.begin() + 4, data2.end());
+        test_eq(
+            "partial_sort", check3.begin(), check3.end(),
+            data2.begin(), data2.begin() + 4
+        );
+
+        std::array<int, 4> data5{};
+        auto res1 = std::partial_sort_copy(
+            data1.begin(), data1.end(),
+            data5.begin(), data5.end()
+        );
+        test_eq(
+            "partial_sort_copy pt1", check3.begin(), check3.end(),
+            data5.begin(), data5.end()
+        );
+        test_eq("partial_sort_copy pt2", res1, data5.end());
+
+        data2 = data1;
+        std::nth_element(data2.begin(), data2.begin() + 6, data2.end());
+        test_eq("nth_element pt1", data2[6], 5);
+        test(
+            "nth_element pt2",
+            std::all_of(
+                data2.begin(), data2.begin() + 6,
+                [](auto x){ return x <= 5; }
+            )
+        );
+
+        auto data6 = data3;
+        std::nth_element(data6.begin(), data6.begin() + 500, data6.end());
+        test_eq("nth_element pt3", data6[500], data3[500]);
+
+        std::array<int, 9> data7{1, 1, 2, 3, 4, 5, 5, 6, 9};
+        auto res2 = std::lower_bound(data7.begin(), data7.end(), 5);
+        test_eq("lower_bound pt1", res2, &data7[5]);
+        auto res3 = std::lower_bound(data7.begin(), data7.end(), 10);
+        test_eq("lower_bound pt2", res3, data7.end());
+
+        auto res4 = std::upper_bound(data7.begin(), data7.end(), 5);
+        test_eq("upper_bound pt1", res4, &data7[7]);
+        auto res5 = std::upper_bound(data7.begin(), data7.end(), 0);
+        test_eq("upper_bound pt2", res5, data7.begin());
+
+        auto res6 = std::equal_range(data7.begin(), data7.end(), 1);
+        test_eq("equal_range pt1", res6.first, data7.begin());
+        test_eq("equal_range pt2", res6.second, &data7[2]);
+
+        test("binary_search pt1", std::binary_search(data7.begin(), data7.end(), 6));
+        test("binary_search pt2", !std::binary_search(data7.begin(), data7.end(), 7));
+
+        auto check4 = {1, 2, 3, 4, 5, 6, 7};
+        std::array<int, 3> data8{2, 4, 6};
+        std::array<int, 4> data9{1, 3, 5, 7};
+        std::array<int, 7> data10{};
+        auto res7 = std::merge(
+            data8.begin(), data8.end(),
+            data9.begin(), data9.end(),
+            data10.begin()
+        );
+        test_eq(
+            "merge pt1", check4.begin(), check4.end(),
+            data10.begin(), data10.end()
+        );
+        test_eq("merge pt2", res7, data10.end());
+
+        std::array<int, 7> data11{2, 4, 6, 1, 3, 5, 7};
+        std::inplace_merge(data11.begin(), data11.begin() + 3, data11.end());
+        test_eq(
+            "inplace_merge", check4.begin(), check4.end(),
+            data11.begin(), data11.end()
+        );
+
+        auto check5 = {4, 5, 6, 7, 1, 2, 3};
+        std::array<int, 7> data12{1, 2, 3, 4, 5, 6, 7};
+        auto res8 = std::rotate(data12.begin(), data12.begin() + 3, data12.end());
+        test_eq(
+            "rotate pt1", check5.begin(), check5.end(),
+            data12.begin(), data12.end()
+        );
+        test_eq("rotate pt2", res8, &data12[4]);
+
+        test("is_sorted pt1", std::is_sorted(data7.begin(), data7.end()));
+        test("is_sorted pt2", !std::is_sorted(data1.begin(), data1.end()));
+
+        std::array<int, 9> data13{1, 2, 2, 3, 1, 4, 5, 6, 7};
+        auto res9 = std::is_sorted_until(data13.begin(), data13.end());
+        test_eq("is_sorted_until", res9, &data13[4]);
+    }
 }
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/mock.hpp>
+#include <__bits/test/tests.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace std::test
+{
+    bool atomic_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_integral();
+        test_pointer();
+        test_flag();
+        test_shared_ptr();
+
+        return end();
+    }
+
+    const char* atomic_test::name()
+    {
+        return "atomic";
+    }
+
+    void atomic_test::test_integral()
+    {
+        std::atomic<int> a1{5};
+        test_eq("load", a1.load(), 5);
+
+        a1.store(7);
+        test_eq("store", a1.load(), 7);
+
+        test_eq("exchange pt1", a1.exchange(3), 7);
+        test_eq("exchange pt2", a1.load(), 3);
+
+        test_eq("fetch_add pt1", a1.fetch_add(2), 3);
+        test_eq("fetch_add pt2", a1.load(), 5);
+        test_eq("fetch_sub", a1.fetch_sub(1), 5);
+        test_eq("operator++", ++a1, 5);
+        test_eq("operator--(int)", a1--, 5);
+        test_eq("operator+=", a1 += 10, 14);
+        test_eq("operator|=", a1 |= 1, 15);
+        test_eq("operator&=", a1 &= 6, 6);
+        test_eq("operator^=", a1 ^= 2, 4);
+
+        int expected{3};
+        auto res1 = a1.compare_exchange_strong(expected, 9);
+        test("compare_exchange_strong failure pt1", !res1);
+        test_eq("compare_exchange_strong failure pt2", expected, 4);
+
+        auto res2 = a1.compare_exchange_strong(expected, 9);
+        test("compare_exchange_strong success pt1", res2);
+        test_eq("compare_exchange_strong success pt2", a1.load(), 9);
+
+        expected = 9;
+        while (!a1.compare_exchange_weak(expected, 11))
+        { /* DUMMY BODY */ }
+        test_eq("compare_exchange_weak", a1.load(), 11);
+
+        std::atomic_long a2{};
+        std::atomic_init(&a2, 1L);
+        std::atomic_fetch_add_explicit(&a2, 2L, std::memory_order_relaxed);
+        test_eq("free functions", std::atomic_load(&a2), 3L);
+
+        std::atomic<bool> a3{false};
+        a3 = true;
+        test("bool", a3.load());
+
+        test("is_lock_free", a1.is_lock_free());
+    }
+
+    void atomic_test::test_pointer()
+    {
+        int arr[5]{};
+        std::atomic<int*> a1{arr};
+
+        test_eq("pointer fetch_add pt1", a1.fetch_add(2), &arr[0]);
+        test_eq("pointer fetch_add pt2", a1.load(), &arr[2]);
+        test_eq("pointer operator++", ++a1, &arr[3]);
+        test_eq("pointer operator-=", a1 -= 3, &arr[0]);
+    }
+
+    void atomic_test::test_flag()
+    {
+        std::atomic_flag flag = ATOMIC_FLAG_INIT;
+
+        test("test_and_set pt1", !flag.test_and_set());
+        test("test_and_set pt2", flag.test_and_set());
+
+        flag.clear();
+        test("clear", !flag.test_and_set(std::memory_order_acquire));
+    }
+
+    void atomic_test::test_shared_ptr()
+    {
+        mock::clear();
+        {
+            auto ptr = std::make_shared<mock>();
+            std::weak_ptr<mock> weak{ptr};
+
+            std::vector<std::thread> threads{};
+            for (int i = 0; i < 4; ++i)
+            {
+                threads.emplace_back([ptr](){
+                    for (int j = 0; j < 1000; ++j)
+                    {
+                        auto copy = ptr;
+                        std::this_thread::yield();
+                    }
+                });
+            }
+
+            for (auto& thr: threads)
+                thr.join();
+
+            test_eq("shared_ptr concurrent copies", ptr.use_count(), 1L);
+
+            ptr.reset();
+            test("weak_ptr expired after reset", weak.expired());
+            test_eq("shared_ptr destroyed once", mock::destructor_calls, 1U);
+        }
+    }
+}
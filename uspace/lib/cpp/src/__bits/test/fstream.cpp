@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace std::test
+{
+    namespace
+    {
+        constexpr const char* test_file{"/tmp/cpptest_fstream.bin"};
+
+        /**
+         * Larger than the filebuf buffer, so that reads
+         * cross buffer refills.
+         */
+        constexpr size_t test_size{64 * 1024};
+
+        char expected_char(size_t pos)
+        {
+            return static_cast<char>('a' + pos % 26);
+        }
+
+        void write_test_file()
+        {
+            ofstream out{test_file, ios_base::out | ios_base::binary};
+            for (size_t i = 0; i < test_size; ++i)
+                out.put(expected_char(i));
+        }
+    }
+
+    bool fstream_test::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        test_read_write();
+        test_seek();
+        test_putback();
+
+        remove(test_file);
+
+        return end();
+    }
+
+    const char* fstream_test::name()
+    {
+        return "fstream";
+    }
+
+    void fstream_test::test_read_write()
+    {
+        write_test_file();
+
+        {
+            fstream f{test_file, ios_base::in | ios_base::out | ios_base::binary};
+
+            char buf[10]{};
+            f.read(buf, 10);
+            test("read write read pt1", f.good() && buf[9] == expected_char(9));
+
+            /**
+             * The write has to land right behind what we read,
+             * not behind what the filebuf has buffered.
+             */
+            f.write("XYZ", 3);
+            test_eq("read write read pt2", f.get(), static_cast<int>(expected_char(13)));
+            test_eq("read write read pt3", static_cast<size_t>(f.tellg()), 14U);
+
+            f.put('W');
+            f.seekg(10);
+            f.read(buf, 5);
+            test(
+                "read write read pt4",
+                string(buf, 5) == string("XYZ") + expected_char(13) + "W"
+            );
+        }
+
+        ifstream in{test_file, ios_base::in | ios_base::binary};
+        string data(test_size, '\0');
+        in.read(&data[0], test_size);
+
+        auto expected = string(1, expected_char(9)) + "XYZ" + expected_char(13) +
+                        "W" + expected_char(15);
+        test("read write read pt5", in.good() && data.substr(9, 7) == expected);
+        test_eq("read write read pt6", data.back(), expected_char(test_size - 1));
+    }
+
+    void fstream_test::test_seek()
+    {
+        write_test_file();
+
+        fstream f{test_file, ios_base::in | ios_base::out | ios_base::binary};
+
+        bool ok{true};
+        for (size_t pos: {size_t{0}, size_t{5000}, test_size - 1, size_t{20000}})
+        {
+            f.seekg(pos);
+            ok = ok && static_cast<size_t>(f.tellg()) == pos;
+            ok = ok && f.peek() == expected_char(pos);
+            ok = ok && static_cast<size_t>(f.tellg()) == pos;
+        }
+        test("seekg tellg round trip", ok);
+
+        f.seekg(30000);
+        f.get();
+        f.seekp(f.tellg());
+        f.put('Q');
+        test_eq("seekp after get", static_cast<size_t>(f.tellp()), 30002U);
+
+        f.seekg(-2, ios_base::cur);
+        test_eq("seekg back over write pt1", f.get(), static_cast<int>(expected_char(30000)));
+        test_eq("seekg back over write pt2", f.get(), static_cast<int>('Q'));
+
+        f.seekg(0, ios_base::end);
+        test_eq("seekg to end", static_cast<size_t>(f.tellg()), test_size);
+    }
+
+    void fstream_test::test_putback()
+    {
+        write_test_file();
+
+        ifstream in{test_file, ios_base::in | ios_base::binary};
+
+        /**
+         * Stop one character before the end of the first
+         * buffer, so that the next two gets refill it.
+         */
+        string buf(BUFSIZ * 4 - 1, '\0');
+        in.read(&buf[0], buf.size());
+
+        auto pos = buf.size();
+        auto c1 = in.get();
+        auto c2 = in.get();
+        test(
+            "get across refill",
+            c1 == expected_char(pos) && c2 == expected_char(pos + 1)
+        );
+
+        in.putback(static_cast<char>(c2));
+        in.putback(static_cast<char>(c1));
+        in.putback(expected_char(pos - 1));
+        test("putback across refill pt1", in.good());
+        test_eq("putback across refill pt2", in.get(), static_cast<int>(expected_char(pos - 1)));
+        test_eq("putback across refill pt3", static_cast<size_t>(in.tellg()), pos);
+    }
+}
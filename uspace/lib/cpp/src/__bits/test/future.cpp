@@ -28,11 +28,15 @@
 
 #include <__bits/test/mock.hpp>
 #include <__bits/test/tests.hpp>
+#include <atomic>
 #include <chrono>
 #include <exception>
+#include <functional>
 #include <future>
+#include <thread>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 using namespace std::chrono_literals;
 
@@ -66,6 +70,7 @@ namespace std::test
         test_async();
         test_packaged_task();
         test_shared_future();
+        test_thread_pool();
 
         return end();
     }
@@ -348,4 +353,100 @@ namespace std::test
         test_eq("first result correct", res1, 42);
         test_eq("second result correct", res2, 42);
     }
+
+    void future_test::test_thread_pool()
+    {
+        test("hardware_concurrency non zero", std::thread::hardware_concurrency() > 0);
+
+        auto& pool = std::aux::thread_pool::instance();
+        test_eq(
+            "pool sized to cpu count", pool.size(),
+            static_cast<std::size_t>(std::thread::hardware_concurrency())
+        );
+
+        std::vector<std::future<int>> futures{};
+        for (int i = 0; i < 64; ++i)
+        {
+            futures.push_back(std::async(
+                std::launch::async, [](int x){
+                    return x * x;
+                }, i
+            ));
+        }
+
+        int sum{};
+        for (auto& f: futures)
+            sum += f.get();
+        test_eq("many async tasks", sum, 85344);
+
+        /**
+         * Tasks waiting for other tasks must not exhaust
+         * the pool, nest deeper than there are workers.
+         */
+        std::function<int(int)> nested = [&nested](int depth){
+            if (depth == 0)
+                return 0;
+
+            auto f = std::async(std::launch::async, nested, depth - 1);
+            return f.get() + 1;
+        };
+        auto res1 = std::async(
+            std::launch::async, nested,
+            static_cast<int>(pool.size()) * 2 + 1
+        );
+        test_eq(
+            "nested async", res1.get(),
+            static_cast<int>(pool.size()) * 2 + 1
+        );
+
+        /**
+         * Each task waits until all of them have started,
+         * which only works if they run as if on their own
+         * threads, even when there are more than workers.
+         */
+        int barrier_count = static_cast<int>(pool.size()) * 2 + 1;
+        std::atomic<int> started{};
+        std::vector<std::future<void>> barrier{};
+        for (int i = 0; i < barrier_count; ++i)
+        {
+            barrier.push_back(std::async(
+                std::launch::async, [&started, barrier_count](){
+                    started.fetch_add(1);
+                    while (started.load() < barrier_count)
+                        std::this_thread::yield();
+                }
+            ));
+        }
+
+        for (auto& f: barrier)
+            f.get();
+        test_eq("async tasks waiting for each other", started.load(), barrier_count);
+
+        std::packaged_task<int()> pt1{
+            [](){
+                return 42;
+            }
+        };
+        auto f1 = pt1.get_future();
+        pool.submit(std::move(pt1));
+        test_eq("packaged_task on pool", f1.get(), 42);
+
+        std::atomic<int> count{};
+        {
+            std::thread threads[4] = {};
+            for (auto& t: threads)
+            {
+                t = std::thread{
+                    [&count](){
+                        for (int i = 0; i < 1000; ++i)
+                            count.fetch_add(1);
+                    }
+                };
+            }
+
+            for (auto& t: threads)
+                t.join();
+        }
+        test_eq("threads run to completion", count.load(), 4000);
+    }
 }
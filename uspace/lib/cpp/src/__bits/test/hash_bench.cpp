@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+namespace std::test
+{
+    namespace
+    {
+        constexpr size_t bench_size{100000};
+
+        vector<int> bench_keys()
+        {
+            vector<int> res(bench_size);
+            unsigned int seed{54321U};
+            for (auto& x: res)
+            {
+                seed = seed * 1103515245U + 12345U;
+                x = static_cast<int>((seed >> 1) % (bench_size * 4));
+            }
+
+            return res;
+        }
+    }
+
+    bool hash_bench::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        auto keys = bench_keys();
+        bench<std::unordered_map<int, int>>("unordered_map", keys);
+        bench<std::aux::flat_unordered_map<int, int>>("flat_unordered_map", keys);
+
+        return end();
+    }
+
+    const char* hash_bench::name()
+    {
+        return "hash_bench";
+    }
+
+    template<class Map>
+    void hash_bench::bench(const char* map_name, const vector<int>& keys)
+    {
+        Map map{};
+
+        auto start = chrono::steady_clock::now();
+        for (auto key: keys)
+            ++map[key];
+        auto inserted = chrono::steady_clock::now();
+
+        size_t sum{};
+        for (auto key: keys)
+        {
+            auto it = map.find(key);
+            if (it != map.end())
+                sum += it->second;
+            it = map.find(key + 1);
+            if (it != map.end())
+                sum += it->second;
+        }
+        auto found = chrono::steady_clock::now();
+
+        size_t erased{};
+        for (auto key: keys)
+            erased += map.erase(key);
+        auto stop = chrono::steady_clock::now();
+
+        if (report_)
+        {
+            auto us = [](auto first, auto last){
+                return static_cast<long long>(
+                    chrono::duration_cast<chrono::microseconds>(last - first).count()
+                );
+            };
+
+            std::printf("[%s][%s, %zu keys] insert %lld us, find %lld us, erase %lld us\n",
+                        name(), map_name, keys.size(), us(start, inserted),
+                        us(inserted, found), us(found, stop));
+        }
+
+        test(map_name, sum >= keys.size() && map.empty() && erased > 0);
+    }
+}
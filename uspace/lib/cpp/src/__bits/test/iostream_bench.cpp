@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace std::test
+{
+    namespace
+    {
+        constexpr const char* bench_file{"/tmp/cpptest_iostream.bin"};
+        constexpr size_t bench_size{4 * 1024 * 1024};
+        constexpr size_t large_block{64 * 1024};
+        constexpr size_t small_block{100};
+    }
+
+    bool iostream_bench::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        vector<char> data(bench_size);
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<char>('a' + i % 26);
+
+        bench_write("write large blocks", data, large_block);
+        bench_write("write small blocks", data, small_block);
+
+        bench_read("read large blocks", data, large_block);
+        bench_read("read small blocks", data, small_block);
+
+        {
+            auto start = chrono::steady_clock::now();
+            ifstream in{bench_file, ios_base::in | ios_base::binary};
+
+            size_t count{};
+            bool same{true};
+            for (auto c = in.get(); in; c = in.get())
+                same = same && c == data[count++];
+
+            report_result("get per character", start);
+            test("get per character", same && count == data.size());
+        }
+
+        {
+            auto start = chrono::steady_clock::now();
+            auto file = fopen(bench_file, "rb");
+
+            vector<char> buf(large_block);
+            size_t count{};
+            if (file)
+            {
+                for (size_t n; (n = fread(buf.data(), 1, buf.size(), file)) > 0;)
+                    count += n;
+                fclose(file);
+            }
+
+            report_result("fread reference", start);
+            test("fread reference", count == data.size());
+        }
+
+        remove(bench_file);
+
+        return end();
+    }
+
+    const char* iostream_bench::name()
+    {
+        return "iostream_bench";
+    }
+
+    void iostream_bench::bench_write(const char* bench_name, const vector<char>& data,
+                                     size_t block)
+    {
+        auto start = chrono::steady_clock::now();
+        {
+            ofstream out{bench_file, ios_base::out | ios_base::binary};
+            for (size_t i = 0; i < data.size() && out; i += block)
+                out.write(data.data() + i, min(block, data.size() - i));
+        }
+        report_result(bench_name, start);
+
+        ifstream in{bench_file, ios_base::in | ios_base::binary};
+        in.seekg(0, ios_base::end);
+        test(bench_name, static_cast<size_t>(in.tellg()) == data.size());
+    }
+
+    void iostream_bench::bench_read(const char* bench_name, const vector<char>& data,
+                                    size_t block)
+    {
+        vector<char> buf(data.size());
+
+        auto start = chrono::steady_clock::now();
+        {
+            ifstream in{bench_file, ios_base::in | ios_base::binary};
+            for (size_t i = 0; i < buf.size() && in; i += block)
+                in.read(buf.data() + i, min(block, buf.size() - i));
+        }
+        report_result(bench_name, start);
+
+        test(bench_name, buf == data);
+    }
+
+    void iostream_bench::report_result(const char* bench_name,
+                                       chrono::steady_clock::time_point start)
+    {
+        if (report_)
+        {
+            auto us = static_cast<long long>(
+                chrono::duration_cast<chrono::microseconds>(
+                    chrono::steady_clock::now() - start
+                ).count()
+            );
+
+            std::printf("[%s][%s, %zu bytes] %lld us\n",
+                        name(), bench_name, bench_size, us);
+        }
+    }
+}
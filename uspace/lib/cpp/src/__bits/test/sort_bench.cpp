@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/test/tests.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+namespace std::test
+{
+    namespace
+    {
+        constexpr size_t bench_size{100000};
+
+        vector<int> bench_random()
+        {
+            vector<int> res(bench_size);
+            unsigned int seed{12345U};
+            for (auto& x: res)
+            {
+                seed = seed * 1103515245U + 12345U;
+                x = static_cast<int>(seed >> 1);
+            }
+
+            return res;
+        }
+
+        vector<int> bench_few_unique()
+        {
+            auto res = bench_random();
+            for (auto& x: res)
+                x %= 16;
+
+            return res;
+        }
+
+        vector<int> bench_sorted()
+        {
+            vector<int> res(bench_size);
+            for (size_t i = 0; i < bench_size; ++i)
+                res[i] = static_cast<int>(i);
+
+            return res;
+        }
+
+        vector<int> bench_reversed()
+        {
+            auto res = bench_sorted();
+            std::reverse(res.begin(), res.end());
+
+            return res;
+        }
+    }
+
+    bool sort_bench::run(bool report)
+    {
+        report_ = report;
+        start();
+
+        const pair<const char*, vector<int>> inputs[] = {
+            {"random", bench_random()},
+            {"few unique", bench_few_unique()},
+            {"sorted", bench_sorted()},
+            {"reversed", bench_reversed()}
+        };
+
+        for (const auto& input: inputs)
+        {
+            bench("sort", input.first, input.second,
+                [](auto first, auto last){
+                    std::sort(first, last);
+                }
+            );
+            bench("stable_sort", input.first, input.second,
+                [](auto first, auto last){
+                    std::stable_sort(first, last);
+                }
+            );
+            bench("heap sort", input.first, input.second,
+                [](auto first, auto last){
+                    std::make_heap(first, last);
+                    std::sort_heap(first, last);
+                }
+            );
+        }
+
+        return end();
+    }
+
+    const char* sort_bench::name()
+    {
+        return "sort_bench";
+    }
+
+    template<class Sort>
+    void sort_bench::bench(const char* alg, const char* input,
+                           const vector<int>& data, Sort sort)
+    {
+        auto copy = data;
+
+        auto start = chrono::steady_clock::now();
+        sort(copy.begin(), copy.end());
+        auto stop = chrono::steady_clock::now();
+
+        auto us = chrono::duration_cast<chrono::microseconds>(
+            stop - start
+        ).count();
+        if (report_)
+        {
+            std::printf("[%s][%s, %s, %zu elements] %lld us\n", name(),
+                        alg, input, data.size(), static_cast<long long>(us));
+        }
+
+        test(alg, std::is_sorted(copy.begin(), copy.end()));
+    }
+}
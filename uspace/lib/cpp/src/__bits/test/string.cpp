@@ -47,6 +47,7 @@ namespace std::test
         test_find();
         test_substr();
         test_compare();
+        test_capacity();
 
         return end();
     }
@@ -703,4 +704,43 @@ namespace std::test
             res, 0
         );
     }
+
+    void string_test::test_capacity()
+    {
+        std::string str1{"short"};
+        std::string str2{std::move(str1)};
+        test_eq("move short string", str2.c_str(), std::string{"short"});
+        test("moved from short string empty", str1.empty());
+
+        const char* check1 = "a string that does not fit into the object";
+        std::string str3{check1};
+        auto data = str3.data();
+        std::string str4{std::move(str3)};
+        test_eq("move long string pt1", str4.data(), data);
+        test("move long string pt2", str3.empty());
+
+        str2.swap(str4);
+        test_eq("swap short and long pt1", str2.data(), data);
+        test_eq("swap short and long pt2", str4, std::string{"short"});
+
+        std::string str5{};
+        for (int i = 0; i < 100; ++i)
+            str5.push_back('a');
+        test_eq("push_back growth pt1", str5.size(), 100ul);
+        test("push_back growth pt2", str5.capacity() >= 100);
+        test_eq("push_back growth pt3", str5.c_str()[100], '\0');
+
+        str5.resize(3);
+        str5.shrink_to_fit();
+        test_eq("shrink_to_fit pt1", str5, std::string{"aaa"});
+        test("shrink_to_fit pt2", str5.capacity() < 100);
+
+        str5.reserve(200);
+        test("reserve pt1", str5.capacity() >= 200);
+        test_eq("reserve pt2", str5, std::string{"aaa"});
+
+        std::string str6{"hello world"};
+        str6.assign(str6.data() + 6, 5);
+        test_eq("assign from itself", str6, std::string{"world"});
+    }
 }
@@ -44,6 +44,7 @@ namespace std::test
         test_histogram();
         test_emplace_insert();
         test_multi();
+        test_flat();
 
         return end();
     }
@@ -263,4 +264,143 @@ namespace std::test
         test_eq("multi erase by iterator pt1", res7->first, 7);
         test_eq("multi erase by iterator pt2", mmap.count(7), 1U);
     }
+
+    void unordered_map_test::test_flat()
+    {
+        auto check1 = {1, 2, 3, 4, 5, 6, 7};
+        auto src1 = {
+            std::pair<const int, int>{3, 3},
+            std::pair<const int, int>{1, 1},
+            std::pair<const int, int>{5, 5},
+            std::pair<const int, int>{2, 2},
+            std::pair<const int, int>{7, 7},
+            std::pair<const int, int>{6, 6},
+            std::pair<const int, int>{4, 4}
+        };
+
+        std::aux::flat_unordered_map<int, int> m1{src1};
+        test_contains(
+            "flat initializer list initialization",
+            check1.begin(), check1.end(), m1
+        );
+        test_eq("flat size", m1.size(), 7U);
+
+        auto m2 = m1;
+        test("flat copy", m1 == m2);
+
+        auto res1 = m1.emplace(8, 8);
+        test("flat emplace pt1", res1.second);
+        test_eq("flat emplace pt2", res1.first->second, 8);
+
+        auto res2 = m1.emplace(8, 9);
+        test("flat emplace duplicate pt1", !res2.second);
+        test_eq("flat emplace duplicate pt2", res2.first->second, 8);
+
+        m1[9] = 9;
+        test_eq("flat operator[] insert", m1.at(9), 9);
+        m1[9] += 1;
+        test_eq("flat operator[] existing", m1.at(9), 10);
+
+        test_eq("flat erase pt1", m1.erase(1), 1U);
+        test_eq("flat erase pt2", m1.erase(1), 0U);
+        test("flat erase pt3", m1.find(1) == m1.end());
+
+        std::aux::flat_unordered_map<int, int> m3{};
+        for (int i = 0; i < 1000; ++i)
+            m3.emplace(i, i * 2);
+        test_eq("flat growth pt1", m3.size(), 1000U);
+        test_eq("flat growth pt2", m3.find(999)->second, 1998);
+        test("flat growth pt3", m3.load_factor() <= m3.max_load_factor());
+
+        for (auto it = m3.begin(); it != m3.end();)
+        {
+            if (it->first % 2 == 1)
+                it = m3.erase(it);
+            else
+                ++it;
+        }
+        test_eq("flat erase while iterating pt1", m3.size(), 500U);
+        test("flat erase while iterating pt2", m3.count(500) == 1 && m3.count(501) == 0);
+
+        auto res3 = m3.try_emplace(0, 42);
+        test("flat try_emplace pt1", !res3.second);
+        test_eq("flat try_emplace pt2", m3.at(0), 0);
+
+        m3.insert_or_assign(0, 42);
+        test_eq("flat insert_or_assign", m3.at(0), 42);
+
+        m3.clear();
+        test("flat clear", m3.empty() && m3.begin() == m3.end());
+
+        struct colliding_hash
+        {
+            size_t operator()(int) const
+            {
+                return 42;
+            }
+        };
+
+        std::aux::flat_unordered_map<int, int, colliding_hash> m4{};
+        for (int i = 0; i < 600; ++i)
+            m4.emplace(i, i);
+        test_eq("flat colliding hashes pt1", m4.size(), 600U);
+        test_eq("flat colliding hashes pt2", m4.at(599), 599);
+
+        for (int i = 0; i < 600; i += 2)
+            m4.erase(i);
+        m4.rehash(2048);
+        test_eq("flat colliding hashes pt3", m4.size(), 300U);
+        test("flat colliding hashes pt4", m4.count(298) == 0 && m4.count(299) == 1);
+
+        std::aux::flat_unordered_map<int, int> m5{};
+        for (int i = 0; i < 1000; ++i)
+            m5.emplace(i * 7919, 0);
+
+        size_t visits{};
+        bool visited_twice{};
+        for (auto it = m5.begin(); it != m5.end();)
+        {
+            ++visits;
+            if (it->second++ > 0)
+                visited_twice = true;
+            it = m5.erase(it);
+        }
+        test_eq("flat erase all while iterating pt1", visits, 1000U);
+        test("flat erase all while iterating pt2", !visited_twice && m5.empty());
+
+        struct move_only_key
+        {
+            int value;
+
+            explicit move_only_key(int v)
+                : value{v}
+            { /* DUMMY BODY */ }
+
+            move_only_key(move_only_key&&) = default;
+            move_only_key(const move_only_key&) = delete;
+
+            bool operator==(const move_only_key& other) const
+            {
+                return value == other.value;
+            }
+        };
+
+        struct move_only_key_hash
+        {
+            size_t operator()(const move_only_key& key) const
+            {
+                return std::hash<int>{}(key.value);
+            }
+        };
+
+        std::aux::flat_unordered_map<move_only_key, int, move_only_key_hash> m6{};
+        for (int i = 0; i < 100; ++i)
+            m6.emplace(move_only_key{i}, i);
+        for (int i = 100; i < 200; ++i)
+            m6.try_emplace(move_only_key{i}, i);
+        m6.rehash(1024);
+        test_eq("flat move only keys pt1", m6.size(), 200U);
+        test_eq("flat move only keys pt2", m6.at(move_only_key{150}), 150);
+        test_eq("flat move only keys pt3", m6.erase(move_only_key{150}), 1U);
+    }
 }
@@ -42,6 +42,7 @@ namespace std::test
         test_constructors_and_assignment();
         test_emplace_insert();
         test_multi();
+        test_flat();
 
         return end();
     }
@@ -211,4 +212,42 @@ namespace std::test
         test_eq("multi erase by iterator pt1", *res7, 7);
         test_eq("multi erase by iterator pt2", mset.count(7), 1U);
     }
+
+    void unordered_set_test::test_flat()
+    {
+        auto check1 = {1, 2, 3, 4, 5, 6, 7};
+        auto src1 = {3, 1, 5, 2, 7, 6, 4};
+
+        std::aux::flat_unordered_set<int> s1{src1};
+        test_contains(
+            "flat initializer list initialization",
+            check1.begin(), check1.end(), s1
+        );
+        test_eq("flat size", s1.size(), 7U);
+
+        auto res1 = s1.insert(3);
+        test("flat insert duplicate pt1", !res1.second);
+        test_eq("flat insert duplicate pt2", *res1.first, 3);
+
+        auto res2 = s1.emplace(8);
+        test("flat emplace", res2.second);
+
+        std::aux::flat_unordered_set<int> s2{std::move(s1)};
+        test("flat move pt1", s1.empty());
+        test_eq("flat move pt2", s2.size(), 8U);
+
+        test_eq("flat erase", s2.erase(8), 1U);
+        test_contains(
+            "flat after erase",
+            check1.begin(), check1.end(), s2
+        );
+
+        std::aux::flat_unordered_set<std::string> s3{};
+        s3.reserve(100);
+        auto cap = s3.capacity();
+        for (int i = 0; i < 100; ++i)
+            s3.insert(std::to_string(i));
+        test_eq("flat reserve", s3.capacity(), cap);
+        test_eq("flat find", *s3.find("42"), std::string{"42"});
+    }
 }
@@ -26,14 +26,40 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <atomic>
 #include <cassert>
 #include <cstdlib>
 #include <exception>
 #include <thread>
 #include <utility>
 
+namespace helenos
+{
+    extern "C" {
+#include <stats.h>
+    }
+}
+
 namespace std
 {
+    namespace aux
+    {
+        namespace
+        {
+            atomic<bool> runners_enabled{};
+        }
+
+        void threading_policy<thread_tag>::thread::enable_runners()
+        {
+            /**
+             * Note: libc decides how many runners the task gets,
+             *       we only have to make sure it is asked once.
+             */
+            if (!runners_enabled.exchange(true))
+                ::helenos::fibril_enable_multithreaded();
+        }
+    }
+
     thread::thread() noexcept
         : id_{}
     { /* DUMMY BODY */ }
@@ -119,9 +145,20 @@ namespace std
 
     unsigned thread::hardware_concurrency() noexcept
     {
-        // TODO:
-        __unimplemented();
-        return 0;
+        size_t count{};
+        auto cpus = ::helenos::stats_get_cpus(&count);
+        if (!cpus)
+            return 0;
+
+        unsigned active{};
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (cpus[i].active)
+                ++active;
+        }
+        free(cpus);
+
+        return active;
     }
 
     void swap(thread& x, thread& y) noexcept
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <__bits/thread/thread_pool.hpp>
+#include <deque>
+#include <thread>
+
+namespace std::aux
+{
+    namespace
+    {
+        /**
+         * Index of the worker running on this thread,
+         * threads outside of the pool have no index.
+         */
+        thread_local size_t current_worker = static_cast<size_t>(-1);
+    }
+
+    struct thread_pool::worker
+    {
+        aux::mutex_t mtx;
+        deque<pool_task*> tasks;
+    };
+
+    thread_pool& thread_pool::instance()
+    {
+        /**
+         * Note: The pool is intentionally never destroyed,
+         *       its workers run until the task terminates.
+         */
+        static thread_pool* pool = new thread_pool{
+            std::thread::hardware_concurrency()
+        };
+
+        return *pool;
+    }
+
+    thread_pool::thread_pool(size_t size)
+        : workers_{}, size_{size > 0 ? size : 1}, next_{},
+          available_{size_}, pending_{}, idle_mtx_{}, idle_cv_{}
+    {
+        threading::mutex::init(idle_mtx_);
+        threading::condvar::init(idle_cv_);
+
+        workers_ = new worker[size_];
+        for (size_t i = 0; i < size_; ++i)
+            threading::mutex::init(workers_[i].mtx);
+
+        for (size_t i = 0; i < size_; ++i)
+        {
+            std::thread{
+                [this, i](){
+                    worker_main_(i);
+                }
+            }.detach();
+        }
+    }
+
+    bool thread_pool::reserve_()
+    {
+        auto avail = available_.load(memory_order_relaxed);
+        while (avail > 0)
+        {
+            if (available_.compare_exchange_weak(avail, avail - 1))
+                return true;
+        }
+
+        return false;
+    }
+
+    void thread_pool::push_(pool_task* task)
+    {
+        if (!reserve_())
+        {
+            /**
+             * Note: All workers may be blocked waiting for
+             *       the result of this very task, so it cannot
+             *       wait in a queue.
+             */
+            std::thread{
+                [task](){
+                    task->run();
+                    delete task;
+                }
+            }.detach();
+
+            return;
+        }
+
+        auto idx = current_worker;
+        if (idx >= size_)
+            idx = next_.fetch_add(1, memory_order_relaxed) % size_;
+
+        auto& w = workers_[idx];
+        threading::mutex::lock(w.mtx);
+        w.tasks.push_back(task);
+        threading::mutex::unlock(w.mtx);
+
+        threading::mutex::lock(idle_mtx_);
+        pending_.fetch_add(1);
+        threading::mutex::unlock(idle_mtx_);
+
+        threading::condvar::signal(idle_cv_);
+    }
+
+    pool_task* thread_pool::pop_(size_t idx)
+    {
+        pool_task* task{};
+        auto& w = workers_[idx];
+
+        threading::mutex::lock(w.mtx);
+        if (!w.tasks.empty())
+        {
+            task = w.tasks.back();
+            w.tasks.pop_back();
+        }
+        threading::mutex::unlock(w.mtx);
+
+        return task;
+    }
+
+    pool_task* thread_pool::steal_(size_t idx)
+    {
+        pool_task* task{};
+
+        /**
+         * Note: Victims are visited starting with the next
+         *       worker so that thieves do not all contend on
+         *       the same queue.
+         */
+        for (size_t i = 1; i <= size_ && !task; ++i)
+        {
+            auto victim = (idx + i) % size_;
+            if (victim == idx)
+                continue;
+
+            auto& w = workers_[victim];
+            threading::mutex::lock(w.mtx);
+            if (!w.tasks.empty())
+            {
+                task = w.tasks.front();
+                w.tasks.pop_front();
+            }
+            threading::mutex::unlock(w.mtx);
+        }
+
+        return task;
+    }
+
+    pool_task* thread_pool::take_(size_t idx)
+    {
+        auto task = pop_(idx);
+        if (!task)
+            task = steal_(idx);
+
+        if (task)
+            pending_.fetch_sub(1);
+
+        return task;
+    }
+
+    void thread_pool::worker_main_(size_t idx)
+    {
+        current_worker = idx;
+
+        while (true)
+        {
+            if (auto task = take_(idx))
+            {
+                task->run();
+                delete task;
+                available_.fetch_add(1);
+
+                continue;
+            }
+
+            threading::mutex::lock(idle_mtx_);
+            while (pending_.load() <= 0)
+                threading::condvar::wait(idle_cv_, idle_mtx_);
+            threading::mutex::unlock(idle_mtx_);
+        }
+    }
+}
@@ -35,32 +35,14 @@
 #include <str.h>
 #include <macros.h>
 #include <errno.h>
-#include <byteorder.h>
-#include <limits.h>
+#include <libarch/sha.h>
 #include "crypto.h"
 
-/** Hash function procedure definition. */
-typedef void (*hash_fnc_t)(uint32_t *, uint32_t *);
-
-/** Length of HMAC block. */
-#define HMAC_BLOCK_LENGTH  64
-
-/** Ceiling for uint32_t. */
-#define ceil_uint32(val) \
-	(((val) - (uint32_t) (val)) > 0 ? \
-	(uint32_t) ((val) + 1) : (uint32_t) (val))
-
-/** Floor for uint32_t. */
-#define floor_uint32(val) \
-	(((val) - (uint32_t) (val)) < 0 ? \
-	(uint32_t) ((val) - 1) : (uint32_t) (val))
-
-/** Pick value at specified index from array or zero if out of bounds. */
-#define get_at(input, size, i) \
-	((i) < (size) ? (input[i]) : 0)
+/** Number of PBKDF2 output blocks derived in one batch. */
+#define PBKDF2_LANES  4
 
 /** Init values used in SHA1 and MD5 functions. */
-static const uint32_t hash_init[] = {
+static const uint32_t md5_sha1_init[] = {
 	0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
 };
 
@@ -92,16 +74,139 @@ static const uint32_t md5_sbox[] = {
 	0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
 };
 
+/** Init values used in SHA-256 function. */
+static const uint32_t sha256_init[] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/** Init values used in SHA-512 function. */
+static const uint64_t sha512_init[] = {
+	0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+	0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+	0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+	0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+/** Round constants of SHA-256. */
+static const uint32_t sha256_k[] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/** Round constants of SHA-512. */
+static const uint64_t sha512_k[] = {
+	0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL,
+	0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+	0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+	0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+	0xd807aa98a3030242ULL, 0x12835b0145706fbeULL,
+	0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+	0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL,
+	0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+	0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+	0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+	0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL,
+	0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+	0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL,
+	0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+	0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+	0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+	0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL,
+	0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+	0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL,
+	0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+	0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+	0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+	0xd192e819d6ef5218ULL, 0xd69906245565a910ULL,
+	0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+	0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL,
+	0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+	0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+	0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+	0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL,
+	0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+	0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL,
+	0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+	0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+	0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+	0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL,
+	0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+	0x28db77f523047d84ULL, 0x32caab7b40c72493ULL,
+	0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+	0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+	0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+#ifdef ARCH_SHA1
+/** Whether the CPU can accelerate SHA-1, -1 if not probed yet. */
+static int sha1_arch = -1;
+#endif
+
+#ifdef ARCH_SHA256
+/** Whether the CPU can accelerate SHA-256, -1 if not probed yet. */
+static int sha256_arch = -1;
+#endif
+
+static uint32_t load_le32(const uint8_t *data)
+{
+	return ((uint32_t) data[3] << 24) | ((uint32_t) data[2] << 16) |
+	    ((uint32_t) data[1] << 8) | data[0];
+}
+
+static uint32_t load_be32(const uint8_t *data)
+{
+	return ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16) |
+	    ((uint32_t) data[2] << 8) | data[3];
+}
+
+static uint64_t load_be64(const uint8_t *data)
+{
+	return ((uint64_t) load_be32(data) << 32) | load_be32(data + 4);
+}
+
+static void store_be32(uint8_t *data, uint32_t val)
+{
+	data[0] = val >> 24;
+	data[1] = val >> 16;
+	data[2] = val >> 8;
+	data[3] = val;
+}
+
+static void store_be64(uint8_t *data, uint64_t val)
+{
+	store_be32(data, val >> 32);
+	store_be32(data + 4, val);
+}
+
 /** Working procedure of MD5 cryptographic hash function.
  *
- * @param h         Working array with interim hash parts values.
- * @param sched_arr Input array with scheduled values from input string.
+ * @param h     Working array with interim hash parts values.
+ * @param block Input block (64 bytes).
  *
  */
-static void md5_proc(uint32_t *h, uint32_t *sched_arr)
+static void md5_proc(uint32_t *h, const uint8_t *block)
 {
 	uint32_t f, g, temp;
 	uint32_t w[HASH_MD5 / 4];
+	uint32_t sched_arr[16];
+
+	for (size_t k = 0; k < 16; k++)
+		sched_arr[k] = load_le32(block + 4 * k);
 
 	memcpy(w, h, (HASH_MD5 / 4) * sizeof(uint32_t));
 
@@ -123,8 +228,7 @@ static void md5_proc(uint32_t *h, uint32_t *sched_arr)
 		temp = w[3];
 		w[3] = w[2];
 		w[2] = w[1];
-		w[1] += rotl_uint32(w[0] + f + md5_sbox[k] +
-		    uint32_t_byteorder_swap(sched_arr[g]),
+		w[1] += rotl_uint32(w[0] + f + md5_sbox[k] + sched_arr[g],
 		    md5_shift[k]);
 		w[0] = temp;
 	}
@@ -135,14 +239,18 @@ static void md5_proc(uint32_t *h, uint32_t *sched_arr)
 
 /** Working procedure of SHA-1 cryptographic hash function.
  *
- * @param h         Working array with interim hash parts values.
- * @param sched_arr Input array with scheduled values from input string.
+ * @param h     Working array with interim hash parts values.
+ * @param block Input block (64 bytes).
  *
  */
-static void sha1_proc(uint32_t *h, uint32_t *sched_arr)
+static void sha1_proc(uint32_t *h, const uint8_t *block)
 {
 	uint32_t f, cf, temp;
 	uint32_t w[HASH_SHA1 / 4];
+	uint32_t sched_arr[80];
+
+	for (size_t k = 0; k < 16; k++)
+		sched_arr[k] = load_be32(block + 4 * k);
 
 	for (size_t k = 16; k < 80; k++) {
 		sched_arr[k] = rotl_uint32(
@@ -183,6 +291,326 @@ static void sha1_proc(uint32_t *h, uint32_t *sched_arr)
 		h[k] += w[k];
 }
 
+/** Working procedure of SHA-256 cryptographic hash function.
+ *
+ * @param h     Working array with interim hash parts values.
+ * @param block Input block (64 bytes).
+ *
+ */
+static void sha256_proc(uint32_t *h, const uint8_t *block)
+{
+	uint32_t w[HASH_SHA256 / 4];
+	uint32_t sched_arr[64];
+
+	for (size_t k = 0; k < 16; k++)
+		sched_arr[k] = load_be32(block + 4 * k);
+
+	for (size_t k = 16; k < 64; k++) {
+		uint32_t s0 = rotr_uint32(sched_arr[k - 15], 7) ^
+		    rotr_uint32(sched_arr[k - 15], 18) ^ (sched_arr[k - 15] >> 3);
+		uint32_t s1 = rotr_uint32(sched_arr[k - 2], 17) ^
+		    rotr_uint32(sched_arr[k - 2], 19) ^ (sched_arr[k - 2] >> 10);
+
+		sched_arr[k] = sched_arr[k - 16] + s0 + sched_arr[k - 7] + s1;
+	}
+
+	memcpy(w, h, (HASH_SHA256 / 4) * sizeof(uint32_t));
+
+	for (size_t k = 0; k < 64; k++) {
+		uint32_t s1 = rotr_uint32(w[4], 6) ^ rotr_uint32(w[4], 11) ^
+		    rotr_uint32(w[4], 25);
+		uint32_t ch = (w[4] & w[5]) ^ (~w[4] & w[6]);
+		uint32_t temp1 = w[7] + s1 + ch + sha256_k[k] + sched_arr[k];
+		uint32_t s0 = rotr_uint32(w[0], 2) ^ rotr_uint32(w[0], 13) ^
+		    rotr_uint32(w[0], 22);
+		uint32_t maj = (w[0] & w[1]) ^ (w[0] & w[2]) ^ (w[1] & w[2]);
+		uint32_t temp2 = s0 + maj;
+
+		w[7] = w[6];
+		w[6] = w[5];
+		w[5] = w[4];
+		w[4] = w[3] + temp1;
+		w[3] = w[2];
+		w[2] = w[1];
+		w[1] = w[0];
+		w[0] = temp1 + temp2;
+	}
+
+	for (uint8_t k = 0; k < HASH_SHA256 / 4; k++)
+		h[k] += w[k];
+}
+
+/** Working procedure of SHA-512 cryptographic hash function.
+ *
+ * @param h     Working array with interim hash parts values.
+ * @param block Input block (128 bytes).
+ *
+ */
+static void sha512_proc(uint64_t *h, const uint8_t *block)
+{
+	uint64_t w[HASH_SHA512 / 8];
+	uint64_t sched_arr[80];
+
+	for (size_t k = 0; k < 16; k++)
+		sched_arr[k] = load_be64(block + 8 * k);
+
+	for (size_t k = 16; k < 80; k++) {
+		uint64_t s0 = rotr_uint64(sched_arr[k - 15], 1) ^
+		    rotr_uint64(sched_arr[k - 15], 8) ^ (sched_arr[k - 15] >> 7);
+		uint64_t s1 = rotr_uint64(sched_arr[k - 2], 19) ^
+		    rotr_uint64(sched_arr[k - 2], 61) ^ (sched_arr[k - 2] >> 6);
+
+		sched_arr[k] = sched_arr[k - 16] + s0 + sched_arr[k - 7] + s1;
+	}
+
+	memcpy(w, h, (HASH_SHA512 / 8) * sizeof(uint64_t));
+
+	for (size_t k = 0; k < 80; k++) {
+		uint64_t s1 = rotr_uint64(w[4], 14) ^ rotr_uint64(w[4], 18) ^
+		    rotr_uint64(w[4], 41);
+		uint64_t ch = (w[4] & w[5]) ^ (~w[4] & w[6]);
+		uint64_t temp1 = w[7] + s1 + ch + sha512_k[k] + sched_arr[k];
+		uint64_t s0 = rotr_uint64(w[0], 28) ^ rotr_uint64(w[0], 34) ^
+		    rotr_uint64(w[0], 39);
+		uint64_t maj = (w[0] & w[1]) ^ (w[0] & w[2]) ^ (w[1] & w[2]);
+		uint64_t temp2 = s0 + maj;
+
+		w[7] = w[6];
+		w[6] = w[5];
+		w[5] = w[4];
+		w[4] = w[3] + temp1;
+		w[3] = w[2];
+		w[2] = w[1];
+		w[1] = w[0];
+		w[0] = temp1 + temp2;
+	}
+
+	for (uint8_t k = 0; k < HASH_SHA512 / 8; k++)
+		h[k] += w[k];
+}
+
+/** Get the block length of a hash function.
+ *
+ * @param func Hash function.
+ *
+ * @return Block length in bytes.
+ *
+ */
+static size_t hash_block_length(hash_func_t func)
+{
+	return (func == HASH_SHA512) ? 128 : 64;
+}
+
+/** Run the compression function of a hash over complete blocks.
+ *
+ * @param func   Hash function.
+ * @param state  Intermediate hash value to update.
+ * @param data   Input blocks.
+ * @param blocks Number of blocks.
+ *
+ */
+static void hash_blocks(hash_func_t func, hash_state_t *state,
+    const uint8_t *data, size_t blocks)
+{
+	switch (func) {
+	case HASH_MD5:
+		for (size_t i = 0; i < blocks; i++)
+			md5_proc(state->h32, data + 64 * i);
+		break;
+	case HASH_SHA1:
+#ifdef ARCH_SHA1
+		if (sha1_arch < 0)
+			sha1_arch = arch_sha1_probe();
+
+		if (sha1_arch) {
+			arch_sha1_blocks(state->h32, data, blocks);
+			break;
+		}
+#endif
+		for (size_t i = 0; i < blocks; i++)
+			sha1_proc(state->h32, data + 64 * i);
+		break;
+	case HASH_SHA256:
+#ifdef ARCH_SHA256
+		if (sha256_arch < 0)
+			sha256_arch = arch_sha256_probe();
+
+		if (sha256_arch) {
+			arch_sha256_blocks(state->h32, data, blocks);
+			break;
+		}
+#endif
+		for (size_t i = 0; i < blocks; i++)
+			sha256_proc(state->h32, data + 64 * i);
+		break;
+	case HASH_SHA512:
+		for (size_t i = 0; i < blocks; i++)
+			sha512_proc(state->h64, data + 128 * i);
+		break;
+	}
+}
+
+/** Fill a block with the final padding of a message.
+ *
+ * @param func   Hash function.
+ * @param block  Block whose first @a fill bytes hold the message tail.
+ * @param fill   Number of message bytes in the block.
+ * @param length Total length of the message in bytes.
+ *
+ * @return Number of padded blocks (one or two).
+ *
+ */
+static size_t hash_pad(hash_func_t func, uint8_t *block, size_t fill,
+    uint64_t length)
+{
+	size_t block_len = hash_block_length(func);
+	size_t length_size = (func == HASH_SHA512) ? 16 : 8;
+	size_t blocks = (fill + 1 + length_size > block_len) ? 2 : 1;
+	size_t end = blocks * block_len;
+
+	block[fill] = 0x80;
+	memset(block + fill + 1, 0, end - fill - 1);
+
+	if (func == HASH_MD5) {
+		uint64_t bits = length << 3;
+
+		for (size_t i = 0; i < 8; i++)
+			block[end - 8 + i] = bits >> (8 * i);
+	} else {
+		store_be64(block + end - 8, length << 3);
+
+		if (func == HASH_SHA512)
+			store_be64(block + end - 16, length >> 61);
+	}
+
+	return blocks;
+}
+
+/** Serialize the intermediate hash value as the resulting hash.
+ *
+ * @param func   Hash function.
+ * @param state  Final hash value.
+ * @param output Result hash byte sequence.
+ *
+ */
+static void hash_output(hash_func_t func, const hash_state_t *state,
+    uint8_t *output)
+{
+	switch (func) {
+	case HASH_MD5:
+		for (size_t i = 0; i < HASH_MD5 / 4; i++) {
+			uint32_t val = state->h32[i];
+
+			output[4 * i] = val;
+			output[4 * i + 1] = val >> 8;
+			output[4 * i + 2] = val >> 16;
+			output[4 * i + 3] = val >> 24;
+		}
+		break;
+	case HASH_SHA1:
+	case HASH_SHA256:
+		for (size_t i = 0; i < func / 4; i++)
+			store_be32(output + 4 * i, state->h32[i]);
+		break;
+	case HASH_SHA512:
+		for (size_t i = 0; i < HASH_SHA512 / 8; i++)
+			store_be64(output + 8 * i, state->h64[i]);
+		break;
+	}
+}
+
+/** Initialize an incremental hash computation.
+ *
+ * @param ctx  Hash context.
+ * @param func Hash function.
+ *
+ * @return EINVAL for an unknown hash function, otherwise EOK.
+ *
+ */
+errno_t hash_init(hash_ctx_t *ctx, hash_func_t func)
+{
+	switch (func) {
+	case HASH_MD5:
+	case HASH_SHA1:
+		memcpy(ctx->state.h32, md5_sha1_init, func);
+		break;
+	case HASH_SHA256:
+		memcpy(ctx->state.h32, sha256_init, sizeof(sha256_init));
+		break;
+	case HASH_SHA512:
+		memcpy(ctx->state.h64, sha512_init, sizeof(sha512_init));
+		break;
+	default:
+		return EINVAL;
+	}
+
+	ctx->func = func;
+	ctx->length = 0;
+	ctx->fill = 0;
+
+	return EOK;
+}
+
+/** Add data to an incremental hash computation.
+ *
+ * Complete blocks are hashed directly from the input, only the tail
+ * is buffered.
+ *
+ * @param ctx  Hash context.
+ * @param data Input data.
+ * @param size Size of the input data.
+ *
+ */
+void hash_update(hash_ctx_t *ctx, const void *data, size_t size)
+{
+	const uint8_t *input = (const uint8_t *) data;
+	size_t block_len = hash_block_length(ctx->func);
+
+	ctx->length += size;
+
+	if (ctx->fill > 0) {
+		size_t chunk = min(block_len - ctx->fill, size);
+
+		memcpy(ctx->buffer + ctx->fill, input, chunk);
+		ctx->fill += chunk;
+		input += chunk;
+		size -= chunk;
+
+		if (ctx->fill < block_len)
+			return;
+
+		hash_blocks(ctx->func, &ctx->state, ctx->buffer, 1);
+		ctx->fill = 0;
+	}
+
+	size_t blocks = size / block_len;
+	if (blocks > 0) {
+		hash_blocks(ctx->func, &ctx->state, input, blocks);
+		input += blocks * block_len;
+		size -= blocks * block_len;
+	}
+
+	memcpy(ctx->buffer, input, size);
+	ctx->fill = size;
+}
+
+/** Finish an incremental hash computation.
+ *
+ * @param ctx    Hash context, must be initialized again for reuse.
+ * @param output Result hash byte sequence.
+ *
+ */
+void hash_final(hash_ctx_t *ctx, uint8_t *output)
+{
+	uint8_t last[2 * HASH_MAX_BLOCK_LENGTH];
+
+	memcpy(last, ctx->buffer, ctx->fill);
+	size_t blocks = hash_pad(ctx->func, last, ctx->fill, ctx->length);
+
+	hash_blocks(ctx->func, &ctx->state, last, blocks);
+	hash_output(ctx->func, &ctx->state, output);
+}
+
 /** Create hash based on selected algorithm.
  *
  * @param input      Input message byte sequence.
@@ -190,71 +618,161 @@ static void sha1_proc(uint32_t *h, uint32_t *sched_arr)
  * @param output     Result hash byte sequence.
  * @param hash_sel   Hash function selector.
  *
- * @return EINVAL when input not specified,
- *         ENOMEM when pointer for output hash result
+ * @return EINVAL when input not specified or the hash function
+ *         is unknown, ENOMEM when pointer for output hash result
  *         is not allocated, otherwise EOK.
  *
  */
 errno_t create_hash(uint8_t *input, size_t input_size, uint8_t *output,
     hash_func_t hash_sel)
 {
-	assert(input_size < SSIZE_MAX);
-
 	if (!input)
 		return EINVAL;
 
 	if (!output)
 		return ENOMEM;
 
-	hash_fnc_t hash_func = (hash_sel == HASH_MD5) ? md5_proc : sha1_proc;
-
-	/* Prepare scheduled input. */
-	uint8_t work_input[input_size + 1];
-	memcpy(work_input, input, input_size);
-	work_input[input_size] = 0x80;
-
-	// FIXME: double?
-	size_t blocks = ceil_uint32((((double) input_size + 1) / 4 + 2) / 16);
-	uint32_t work_arr[blocks * 16];
-	for (size_t i = 0; i < blocks; i++) {
-		for (size_t j = 0; j < 16; j++) {
-			work_arr[i * 16 + j] =
-			    (get_at(work_input, input_size + 1, i * 64 + j * 4) << 24) |
-			    (get_at(work_input, input_size + 1, i * 64 + j * 4 + 1) << 16) |
-			    (get_at(work_input, input_size + 1, i * 64 + j * 4 + 2) << 8) |
-			    get_at(work_input, input_size + 1, i * 64 + j * 4 + 3);
-		}
-	}
+	hash_ctx_t ctx;
+	errno_t rc = hash_init(&ctx, hash_sel);
+	if (rc != EOK)
+		return rc;
+
+	hash_update(&ctx, input, input_size);
+	hash_final(&ctx, output);
+
+	return EOK;
+}
 
-	uint64_t bits_size = (uint64_t) (input_size * 8);
-	if (hash_sel == HASH_MD5)
-		bits_size = uint64_t_byteorder_swap(bits_size);
+/** Initialize an incremental HMAC computation.
+ *
+ * @param ctx      HMAC context.
+ * @param key      Cryptographic key sequence.
+ * @param key_size Size of key sequence.
+ * @param hash_sel Hash function selector.
+ *
+ * @return EINVAL for an unknown hash function, otherwise EOK.
+ *
+ */
+errno_t hmac_init(hmac_ctx_t *ctx, const uint8_t *key, size_t key_size,
+    hash_func_t hash_sel)
+{
+	uint8_t work_key[HASH_MAX_BLOCK_LENGTH];
+	uint8_t key_pad[HASH_MAX_BLOCK_LENGTH];
 
-	work_arr[(blocks - 1) * 16 + 14] = bits_size >> 32;
-	work_arr[(blocks - 1) * 16 + 15] = bits_size & 0xffffffff;
+	errno_t rc = hash_init(&ctx->inner, hash_sel);
+	if (rc != EOK)
+		return rc;
 
-	/* Hash computation. */
-	uint32_t h[hash_sel / 4];
-	memcpy(h, hash_init, (hash_sel / 4) * sizeof(uint32_t));
-	uint32_t sched_arr[80];
-	for (size_t i = 0; i < blocks; i++) {
-		for (size_t k = 0; k < 16; k++)
-			sched_arr[k] = work_arr[i * 16 + k];
+	size_t block_len = hash_block_length(hash_sel);
+	memset(work_key, 0, block_len);
 
-		hash_func(h, sched_arr);
+	if (key_size > block_len) {
+		hash_update(&ctx->inner, key, key_size);
+		hash_final(&ctx->inner, work_key);
+		(void) hash_init(&ctx->inner, hash_sel);
+	} else {
+		memcpy(work_key, key, key_size);
 	}
 
-	/* Copy hash parts into final result. */
-	for (size_t i = 0; i < hash_sel / 4; i++) {
-		if (hash_sel == HASH_SHA1)
-			h[i] = uint32_t_byteorder_swap(h[i]);
+	(void) hash_init(&ctx->outer, hash_sel);
 
-		memcpy(output + i * sizeof(uint32_t), &h[i], sizeof(uint32_t));
-	}
+	for (size_t i = 0; i < block_len; i++)
+		key_pad[i] = work_key[i] ^ 0x36;
+
+	hash_update(&ctx->inner, key_pad, block_len);
+
+	for (size_t i = 0; i < block_len; i++)
+		key_pad[i] = work_key[i] ^ 0x5c;
+
+	hash_update(&ctx->outer, key_pad, block_len);
 
 	return EOK;
 }
 
+/** Add message data to an incremental HMAC computation.
+ *
+ * @param ctx  HMAC context.
+ * @param data Message data.
+ * @param size Size of the message data.
+ *
+ */
+void hmac_update(hmac_ctx_t *ctx, const void *data, size_t size)
+{
+	hash_update(&ctx->inner, data, size);
+}
+
+/** Finish an incremental HMAC computation.
+ *
+ * @param ctx  HMAC context, must be initialized again for reuse.
+ * @param hash Output parameter for result hash.
+ *
+ */
+void hmac_final(hmac_ctx_t *ctx, uint8_t *hash)
+{
+	uint8_t temp_hash[HASH_MAX_LENGTH];
+
+	hash_final(&ctx->inner, temp_hash);
+	hash_update(&ctx->outer, temp_hash, ctx->inner.func);
+	hash_final(&ctx->outer, hash);
+}
+
+/** Compute HMACs of several messages with the same key.
+ *
+ * The context is left untouched and can be used for further batches.
+ * Messages short enough to fit into a single block together with the
+ * padding, such as the chained values of PBKDF2, are hashed without
+ * any buffering: the padding is laid out once and only the message
+ * part of the block changes between the messages.
+ *
+ * @param ctx      HMAC context after hmac_init().
+ * @param msgs     Messages.
+ * @param msg_size Size of each message.
+ * @param hashes   Output parameters for the resulting hashes. They may
+ *                 coincide with the messages.
+ * @param count    Number of messages.
+ *
+ */
+void hmac_batch(const hmac_ctx_t *ctx, const uint8_t *const *msgs,
+    size_t msg_size, uint8_t *const *hashes, size_t count)
+{
+	hash_func_t func = ctx->inner.func;
+	size_t block_len = hash_block_length(func);
+	size_t length_size = (func == HASH_SHA512) ? 16 : 8;
+
+	if (msg_size + 1 + length_size > block_len) {
+		for (size_t i = 0; i < count; i++) {
+			hmac_ctx_t work = *ctx;
+
+			hmac_update(&work, msgs[i], msg_size);
+			hmac_final(&work, hashes[i]);
+		}
+
+		return;
+	}
+
+	/* The key pads are exactly one block, nothing is buffered. */
+	assert(ctx->inner.fill == 0);
+	assert(ctx->outer.fill == 0);
+
+	uint8_t inner_block[HASH_MAX_BLOCK_LENGTH];
+	uint8_t outer_block[HASH_MAX_BLOCK_LENGTH];
+
+	(void) hash_pad(func, inner_block, msg_size, block_len + msg_size);
+	(void) hash_pad(func, outer_block, func, block_len + func);
+
+	for (size_t i = 0; i < count; i++) {
+		hash_state_t state = ctx->inner.state;
+
+		memcpy(inner_block, msgs[i], msg_size);
+		hash_blocks(func, &state, inner_block, 1);
+		hash_output(func, &state, outer_block);
+
+		state = ctx->outer.state;
+		hash_blocks(func, &state, outer_block, 1);
+		hash_output(func, &state, hashes[i]);
+	}
+}
+
 /** Hash-based message authentication code.
  *
  * @param key      Cryptographic key sequence.
@@ -264,9 +782,9 @@ errno_t create_hash(uint8_t *input, size_t input_size, uint8_t *output,
  * @param hash     Output parameter for result hash.
  * @param hash_sel Hash function selector.
  *
- * @return EINVAL when key or message not specified,
- *         ENOMEM when pointer for output hash result
- *         is not allocated, otherwise EOK.
+ * @return EINVAL when key or message not specified or the hash
+ *         function is unknown, ENOMEM when pointer for output hash
+ *         result is not allocated, otherwise EOK.
  *
  */
 errno_t hmac(uint8_t *key, size_t key_size, uint8_t *msg, size_t msg_size,
@@ -278,33 +796,97 @@ errno_t hmac(uint8_t *key, size_t key_size, uint8_t *msg, size_t msg_size,
 	if (!hash)
 		return ENOMEM;
 
-	uint8_t work_key[HMAC_BLOCK_LENGTH];
-	uint8_t o_key_pad[HMAC_BLOCK_LENGTH];
-	uint8_t i_key_pad[HMAC_BLOCK_LENGTH];
-	uint8_t temp_hash[hash_sel];
-	memset(work_key, 0, HMAC_BLOCK_LENGTH);
+	hmac_ctx_t ctx;
+	errno_t rc = hmac_init(&ctx, key, key_size, hash_sel);
+	if (rc != EOK)
+		return rc;
 
-	if (key_size > HMAC_BLOCK_LENGTH)
-		create_hash(key, key_size, work_key, hash_sel);
-	else
-		memcpy(work_key, key, key_size);
+	hmac_update(&ctx, msg, msg_size);
+	hmac_final(&ctx, hash);
 
-	for (size_t i = 0; i < HMAC_BLOCK_LENGTH; i++) {
-		o_key_pad[i] = work_key[i] ^ 0x5c;
-		i_key_pad[i] = work_key[i] ^ 0x36;
-	}
+	return EOK;
+}
 
-	uint8_t temp_work[HMAC_BLOCK_LENGTH + max(msg_size, hash_sel)];
-	memcpy(temp_work, i_key_pad, HMAC_BLOCK_LENGTH);
-	memcpy(temp_work + HMAC_BLOCK_LENGTH, msg, msg_size);
+/** Password-Based Key Derivation Function 2.
+ *
+ * As defined in RFC 8018 with HMAC as the pseudorandom function. The
+ * key pads are hashed only once and the output blocks are derived in
+ * batches, so that each iteration costs two compression function
+ * calls per block.
+ *
+ * @param hash_sel   Hash function selector.
+ * @param pass       Password sequence.
+ * @param pass_size  Password sequence length.
+ * @param salt       Salt sequence to be used with password.
+ * @param salt_size  Salt sequence length.
+ * @param iterations Number of iterations.
+ * @param hash       Output parameter for the derived key.
+ * @param hash_size  Length of the derived key.
+ *
+ * @return EINVAL when pass or salt not specified, the hash function
+ *         is unknown or there are no iterations, ENOMEM when pointer
+ *         for output is not allocated, otherwise EOK.
+ *
+ */
+errno_t pbkdf2_hmac(hash_func_t hash_sel, const uint8_t *pass,
+    size_t pass_size, const uint8_t *salt, size_t salt_size,
+    unsigned iterations, uint8_t *hash, size_t hash_size)
+{
+	if ((!pass) || (!salt) || (iterations == 0))
+		return EINVAL;
 
-	create_hash(temp_work, HMAC_BLOCK_LENGTH + msg_size, temp_hash,
-	    hash_sel);
+	if (!hash)
+		return ENOMEM;
 
-	memcpy(temp_work, o_key_pad, HMAC_BLOCK_LENGTH);
-	memcpy(temp_work + HMAC_BLOCK_LENGTH, temp_hash, hash_sel);
+	hmac_ctx_t ctx;
+	errno_t rc = hmac_init(&ctx, pass, pass_size, hash_sel);
+	if (rc != EOK)
+		return rc;
+
+	size_t hlen = hash_sel;
+	uint8_t work_hmac[PBKDF2_LANES][HASH_MAX_LENGTH];
+	uint8_t xor_hmac[PBKDF2_LANES][HASH_MAX_LENGTH];
+	uint8_t *lanes[PBKDF2_LANES];
+	uint32_t block = 1;
+
+	for (size_t i = 0; i < PBKDF2_LANES; i++)
+		lanes[i] = work_hmac[i];
+
+	while (hash_size > 0) {
+		size_t count = min((hash_size + hlen - 1) / hlen,
+		    (size_t) PBKDF2_LANES);
+
+		for (size_t i = 0; i < count; i++) {
+			hmac_ctx_t work = ctx;
+			uint8_t be_block[4];
+
+			store_be32(be_block, block + i);
+			hmac_update(&work, salt, salt_size);
+			hmac_update(&work, be_block, 4);
+			hmac_final(&work, work_hmac[i]);
+			memcpy(xor_hmac[i], work_hmac[i], hlen);
+		}
 
-	create_hash(temp_work, HMAC_BLOCK_LENGTH + hash_sel, hash, hash_sel);
+		for (unsigned k = 1; k < iterations; k++) {
+			hmac_batch(&ctx, (const uint8_t *const *) lanes, hlen,
+			    lanes, count);
+
+			for (size_t i = 0; i < count; i++) {
+				for (size_t t = 0; t < hlen; t++)
+					xor_hmac[i][t] ^= work_hmac[i][t];
+			}
+		}
+
+		for (size_t i = 0; (i < count) && (hash_size > 0); i++) {
+			size_t chunk = min(hash_size, hlen);
+
+			memcpy(hash, xor_hmac[i], chunk);
+			hash += chunk;
+			hash_size -= chunk;
+		}
+
+		block += count;
+	}
 
 	return EOK;
 }
@@ -328,40 +910,6 @@ errno_t hmac(uint8_t *key, size_t key_size, uint8_t *msg, size_t msg_size,
 errno_t pbkdf2(uint8_t *pass, size_t pass_size, uint8_t *salt, size_t salt_size,
     uint8_t *hash)
 {
-	if ((!pass) || (!salt))
-		return EINVAL;
-
-	if (!hash)
-		return ENOMEM;
-
-	uint8_t work_salt[salt_size + 4];
-	memcpy(work_salt, salt, salt_size);
-	uint8_t work_hmac[HASH_SHA1];
-	uint8_t temp_hmac[HASH_SHA1];
-	uint8_t xor_hmac[HASH_SHA1];
-	uint8_t temp_hash[HASH_SHA1 * 2];
-
-	for (size_t i = 0; i < 2; i++) {
-		uint32_t be_i = host2uint32_t_be(i + 1);
-
-		memcpy(work_salt + salt_size, &be_i, 4);
-		hmac(pass, pass_size, work_salt, salt_size + 4,
-		    work_hmac, HASH_SHA1);
-		memcpy(xor_hmac, work_hmac, HASH_SHA1);
-
-		for (size_t k = 1; k < 4096; k++) {
-			memcpy(temp_hmac, work_hmac, HASH_SHA1);
-			hmac(pass, pass_size, temp_hmac, HASH_SHA1,
-			    work_hmac, HASH_SHA1);
-
-			for (size_t t = 0; t < HASH_SHA1; t++)
-				xor_hmac[t] ^= work_hmac[t];
-		}
-
-		memcpy(temp_hash + i * HASH_SHA1, xor_hmac, HASH_SHA1);
-	}
-
-	memcpy(hash, temp_hash, PBKDF2_KEY_LENGTH);
-
-	return EOK;
+	return pbkdf2_hmac(HASH_SHA1, pass, pass_size, salt, salt_size, 4096,
+	    hash, PBKDF2_KEY_LENGTH);
 }
@@ -33,8 +33,14 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#define AES_CIPHER_LENGTH  16
-#define PBKDF2_KEY_LENGTH  32
+#define AES_CIPHER_LENGTH   16
+#define AES_BLOCK_LENGTH    16
+#define AES_GCM_TAG_LENGTH  16
+#define AES_MAX_ROUNDS      14
+#define PBKDF2_KEY_LENGTH   32
+
+#define HASH_MAX_LENGTH        64
+#define HASH_MAX_BLOCK_LENGTH  128
 
 /* Left rotation for uint32_t. */
 #define rotl_uint32(val, shift) \
@@ -44,18 +50,102 @@
 #define rotr_uint32(val, shift) \
 	(((val) >> shift) | ((val) << (32 - shift)))
 
+/* Right rotation for uint64_t. */
+#define rotr_uint64(val, shift) \
+	(((val) >> shift) | ((val) << (64 - shift)))
+
+/** Expanded AES key.
+ *
+ * Round keys are kept as byte blocks so that they can be fed directly
+ * to hardware AES instructions.
+ */
+typedef struct {
+	/** Encryption round keys. */
+	uint8_t enc[AES_MAX_ROUNDS + 1][AES_BLOCK_LENGTH];
+	/** Decryption round keys (equivalent inverse cipher). */
+	uint8_t dec[AES_MAX_ROUNDS + 1][AES_BLOCK_LENGTH];
+	/** Number of rounds (10, 12 or 14). */
+	size_t rounds;
+} aes_key_t;
+
+/** AES-GCM context. */
+typedef struct {
+	/** Cipher key schedule. */
+	aes_key_t key;
+	/** Hash subkey as big-endian 64-bit halves. */
+	uint64_t h[2];
+	/** Multiples of the hash subkey for the 4-bit GHASH method. */
+	uint64_t hh[16];
+	uint64_t hl[16];
+} aes_gcm_t;
+
 /** Hash function selector and also result hash length indicator. */
 typedef enum {
-	HASH_MD5 =  16,
-	HASH_SHA1 = 20
+	HASH_MD5 =    16,
+	HASH_SHA1 =   20,
+	HASH_SHA256 = 32,
+	HASH_SHA512 = 64
 } hash_func_t;
 
+/** Intermediate hash value. */
+typedef union {
+	uint32_t h32[8];
+	uint64_t h64[8];
+} hash_state_t;
+
+/** Incremental hash computation context. */
+typedef struct {
+	/** Hash function. */
+	hash_func_t func;
+	/** Intermediate hash value. */
+	hash_state_t state;
+	/** Number of bytes hashed so far. */
+	uint64_t length;
+	/** Partial input block. */
+	uint8_t buffer[HASH_MAX_BLOCK_LENGTH];
+	/** Number of bytes in the partial block. */
+	size_t fill;
+} hash_ctx_t;
+
+/** Incremental HMAC computation context. */
+typedef struct {
+	/** Hash of the inner key pad and the message. */
+	hash_ctx_t inner;
+	/** Hash of the outer key pad. */
+	hash_ctx_t outer;
+} hmac_ctx_t;
+
 extern errno_t rc4(uint8_t *, size_t, uint8_t *, size_t, size_t, uint8_t *);
 extern errno_t aes_encrypt(uint8_t *, uint8_t *, uint8_t *);
 extern errno_t aes_decrypt(uint8_t *, uint8_t *, uint8_t *);
+extern errno_t aes_key_init(aes_key_t *, const uint8_t *, size_t);
+extern void aes_encrypt_block(const aes_key_t *, const uint8_t *, uint8_t *);
+extern void aes_decrypt_block(const aes_key_t *, const uint8_t *, uint8_t *);
+extern errno_t aes_cbc_encrypt(const aes_key_t *, uint8_t *, const uint8_t *,
+    uint8_t *, size_t);
+extern errno_t aes_cbc_decrypt(const aes_key_t *, uint8_t *, const uint8_t *,
+    uint8_t *, size_t);
+extern void aes_ctr_crypt(const aes_key_t *, uint8_t *, const uint8_t *,
+    uint8_t *, size_t);
+extern errno_t aes_gcm_init(aes_gcm_t *, const uint8_t *, size_t);
+extern void aes_gcm_encrypt(const aes_gcm_t *, const uint8_t *, size_t,
+    const uint8_t *, size_t, const uint8_t *, uint8_t *, size_t, uint8_t *);
+extern errno_t aes_gcm_decrypt(const aes_gcm_t *, const uint8_t *, size_t,
+    const uint8_t *, size_t, const uint8_t *, uint8_t *, size_t,
+    const uint8_t *);
 extern errno_t create_hash(uint8_t *, size_t, uint8_t *, hash_func_t);
+extern errno_t hash_init(hash_ctx_t *, hash_func_t);
+extern void hash_update(hash_ctx_t *, const void *, size_t);
+extern void hash_final(hash_ctx_t *, uint8_t *);
 extern errno_t hmac(uint8_t *, size_t, uint8_t *, size_t, uint8_t *, hash_func_t);
+extern errno_t hmac_init(hmac_ctx_t *, const uint8_t *, size_t, hash_func_t);
+extern void hmac_update(hmac_ctx_t *, const void *, size_t);
+extern void hmac_final(hmac_ctx_t *, uint8_t *);
+extern void hmac_batch(const hmac_ctx_t *, const uint8_t *const *, size_t,
+    uint8_t *const *, size_t);
 extern errno_t pbkdf2(uint8_t *, size_t, uint8_t *, size_t, uint8_t *);
+extern errno_t pbkdf2_hmac(hash_func_t, const uint8_t *, size_t,
+    const uint8_t *, size_t, unsigned, uint8_t *, size_t);
 
 extern uint16_t crc16_ibm(uint16_t crc, uint8_t *buf, size_t len);
 
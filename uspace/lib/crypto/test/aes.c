@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+#include <stdint.h>
+#include "../crypto.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(aes);
+
+/** FIPS 197 appendix C plaintext */
+static const uint8_t fips_plain[16] = {
+	0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+	0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+
+/** NIST SP 800-38A AES-128 key */
+static const uint8_t sp_key[16] = {
+	0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+	0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+/** NIST SP 800-38A plaintext (first two blocks) */
+static const uint8_t sp_plain[32] = {
+	0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+	0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+	0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+	0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51
+};
+
+/** Encrypt and decrypt the FIPS 197 example with a given key length */
+static void fips_check(size_t length, const uint8_t *expected)
+{
+	uint8_t key_data[32];
+	uint8_t block[16];
+	aes_key_t key;
+
+	for (size_t i = 0; i < length; i++)
+		key_data[i] = i;
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, aes_key_init(&key, key_data, length));
+
+	aes_encrypt_block(&key, fips_plain, block);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(block, expected, 16));
+
+	aes_decrypt_block(&key, block, block);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(block, fips_plain, 16));
+}
+
+PCUT_TEST(fips197)
+{
+	static const uint8_t c128[16] = {
+		0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+		0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+	};
+	static const uint8_t c192[16] = {
+		0xdd, 0xa9, 0x7c, 0xa4, 0x86, 0x4c, 0xdf, 0xe0,
+		0x6e, 0xaf, 0x70, 0xa0, 0xec, 0x0d, 0x71, 0x91
+	};
+	static const uint8_t c256[16] = {
+		0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+		0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89
+	};
+
+	fips_check(16, c128);
+	fips_check(24, c192);
+	fips_check(32, c256);
+}
+
+PCUT_TEST(key_length)
+{
+	uint8_t key_data[20] = { 0 };
+	aes_key_t key;
+
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, aes_key_init(&key, key_data, 20));
+}
+
+PCUT_TEST(legacy)
+{
+	uint8_t key_data[16];
+	uint8_t block[16];
+
+	for (size_t i = 0; i < 16; i++)
+		key_data[i] = i;
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, aes_encrypt(key_data,
+	    (uint8_t *) fips_plain, block));
+	PCUT_ASSERT_ERRNO_VAL(EOK, aes_decrypt(key_data, block, block));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(block, fips_plain, 16));
+}
+
+PCUT_TEST(cbc)
+{
+	static const uint8_t cipher[32] = {
+		0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+		0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+		0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee,
+		0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2
+	};
+	uint8_t iv[16];
+	uint8_t data[32];
+	aes_key_t key;
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, aes_key_init(&key, sp_key, 16));
+
+	/* Encrypt block by block to check IV chaining. */
+	for (size_t i = 0; i < 16; i++)
+		iv[i] = i;
+
+	memcpy(data, sp_plain, 32);
+	PCUT_ASSERT_ERRNO_VAL(EOK, aes_cbc_encrypt(&key, iv, data, data, 16));
+	PCUT_ASSERT_ERRNO_VAL(EOK, aes_cbc_encrypt(&key, iv, data + 16,
+	    data + 16, 16));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, cipher, 32));
+
+	for (size_t i = 0; i < 16; i++)
+		iv[i] = i;
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, aes_cbc_decrypt(&key, iv, data, data, 32));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, sp_plain, 32));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(iv, cipher + 16, 16));
+
+	PCUT_ASSERT_ERRNO_VAL(EINVAL, aes_cbc_decrypt(&key, iv, data, data, 20));
+}
+
+PCUT_TEST(ctr)
+{
+	static const uint8_t cipher[32] = {
+		0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26,
+		0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+		0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff,
+		0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff
+	};
+	uint8_t ctr[16];
+	uint8_t data[32];
+	aes_key_t key;
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, aes_key_init(&key, sp_key, 16));
+
+	for (size_t i = 0; i < 16; i++)
+		ctr[i] = 0xf0 + i;
+
+	aes_ctr_crypt(&key, ctr, sp_plain, data, 32);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, cipher, 32));
+
+	/* The counter carries into the upper bytes. */
+	PCUT_ASSERT_INT_EQUALS(0xf0, ctr[0]);
+	PCUT_ASSERT_INT_EQUALS(0xfd, ctr[13]);
+	PCUT_ASSERT_INT_EQUALS(0xff, ctr[14]);
+	PCUT_ASSERT_INT_EQUALS(0x01, ctr[15]);
+
+	/* Decrypt the odd length tail. */
+	for (size_t i = 0; i < 16; i++)
+		ctr[i] = 0xf0 + i;
+
+	aes_ctr_crypt(&key, ctr, data, data, 27);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, sp_plain, 27));
+}
+
+PCUT_TEST(gcm)
+{
+	static const uint8_t tag_empty[16] = {
+		0x58, 0xe2, 0xfc, 0xce, 0xfa, 0x7e, 0x30, 0x61,
+		0x36, 0x7f, 0x1d, 0x57, 0xa4, 0xe7, 0x45, 0x5a
+	};
+	static const uint8_t cipher[16] = {
+		0x03, 0x88, 0xda, 0xce, 0x60, 0xb6, 0xa3, 0x92,
+		0xf3, 0x28, 0xc2, 0xb9, 0x71, 0xb2, 0xfe, 0x78
+	};
+	static const uint8_t tag[16] = {
+		0xab, 0x6e, 0x47, 0xd4, 0x2c, 0xec, 0x13, 0xbd,
+		0xf5, 0x3a, 0x67, 0xb2, 0x12, 0x57, 0xbd, 0xdf
+	};
+	uint8_t zero[16];
+	uint8_t data[16];
+	uint8_t out_tag[16];
+	aes_gcm_t gcm;
+
+	memset(zero, 0, 16);
+	PCUT_ASSERT_ERRNO_VAL(EOK, aes_gcm_init(&gcm, zero, 16));
+
+	aes_gcm_encrypt(&gcm, zero, 12, NULL, 0, NULL, NULL, 0, out_tag);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(out_tag, tag_empty, 16));
+
+	aes_gcm_encrypt(&gcm, zero, 12, NULL, 0, zero, data, 16, out_tag);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, cipher, 16));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(out_tag, tag, 16));
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, aes_gcm_decrypt(&gcm, zero, 12, NULL, 0,
+	    data, data, 16, tag));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, zero, 16));
+}
+
+PCUT_TEST(gcm_forged)
+{
+	uint8_t key_data[16];
+	uint8_t iv[16];
+	uint8_t aad[20];
+	uint8_t plain[100];
+	uint8_t cipher[100];
+	uint8_t data[100];
+	uint8_t tag[16];
+	aes_gcm_t gcm;
+
+	for (size_t i = 0; i < sizeof(plain); i++)
+		plain[i] = i * 7;
+
+	memset(key_data, 0x42, 16);
+	memset(iv, 0x17, 16);
+	memset(aad, 0x99, 20);
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, aes_gcm_init(&gcm, key_data, 16));
+
+	/* Non-default IV length and a partial last block */
+	aes_gcm_encrypt(&gcm, iv, 16, aad, 20, plain, cipher, 100, tag);
+
+	memcpy(data, cipher, 100);
+	PCUT_ASSERT_ERRNO_VAL(EOK, aes_gcm_decrypt(&gcm, iv, 16, aad, 20,
+	    data, data, 100, tag));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, plain, 100));
+
+	/* Tampered AAD is rejected and the output left untouched */
+	aad[3] ^= 1;
+	memcpy(data, cipher, 100);
+	PCUT_ASSERT_ERRNO_VAL(EBADMSG, aes_gcm_decrypt(&gcm, iv, 16, aad, 20,
+	    data, data, 100, tag));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(data, cipher, 100));
+}
+
+PCUT_EXPORT(aes);
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+#include <stdint.h>
+#include <str.h>
+#include "../crypto.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(hash);
+
+/** Hash "abc" in one go and byte by byte */
+static void abc_check(hash_func_t func, const uint8_t *expected)
+{
+	uint8_t out[HASH_MAX_LENGTH];
+	hash_ctx_t ctx;
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, create_hash((uint8_t *) "abc", 3, out, func));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(out, expected, func));
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, hash_init(&ctx, func));
+	hash_update(&ctx, "a", 1);
+	hash_update(&ctx, "b", 1);
+	hash_update(&ctx, "c", 1);
+	hash_final(&ctx, out);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(out, expected, func));
+}
+
+PCUT_TEST(md5)
+{
+	static const uint8_t expected[16] = {
+		0x90, 0x01, 0x50, 0x98, 0x3c, 0xd2, 0x4f, 0xb0,
+		0xd6, 0x96, 0x3f, 0x7d, 0x28, 0xe1, 0x7f, 0x72
+	};
+
+	abc_check(HASH_MD5, expected);
+}
+
+PCUT_TEST(sha1)
+{
+	static const uint8_t expected[20] = {
+		0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a,
+		0xba, 0x3e, 0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c,
+		0x9c, 0xd0, 0xd8, 0x9d
+	};
+
+	abc_check(HASH_SHA1, expected);
+}
+
+PCUT_TEST(sha256)
+{
+	static const uint8_t expected[32] = {
+		0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+		0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+		0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+	};
+
+	abc_check(HASH_SHA256, expected);
+}
+
+PCUT_TEST(sha512)
+{
+	static const uint8_t expected[64] = {
+		0xdd, 0xaf, 0x35, 0xa1, 0x93, 0x61, 0x7a, 0xba,
+		0xcc, 0x41, 0x73, 0x49, 0xae, 0x20, 0x41, 0x31,
+		0x12, 0xe6, 0xfa, 0x4e, 0x89, 0xa9, 0x7e, 0xa2,
+		0x0a, 0x9e, 0xee, 0xe6, 0x4b, 0x55, 0xd3, 0x9a,
+		0x21, 0x92, 0x99, 0x2a, 0x27, 0x4f, 0xc1, 0xa8,
+		0x36, 0xba, 0x3c, 0x23, 0xa3, 0xfe, 0xeb, 0xbd,
+		0x45, 0x4d, 0x44, 0x23, 0x64, 0x3c, 0xe8, 0x0e,
+		0x2a, 0x9a, 0xc9, 0x4f, 0xa5, 0x4c, 0xa4, 0x9f
+	};
+
+	abc_check(HASH_SHA512, expected);
+}
+
+/** One million times 'a' fed in pieces that do not align to blocks */
+PCUT_TEST(sha256_stream)
+{
+	static const uint8_t expected[32] = {
+		0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92,
+		0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+		0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e,
+		0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0
+	};
+	uint8_t chunk[1000];
+	uint8_t out[32];
+	hash_ctx_t ctx;
+
+	memset(chunk, 'a', sizeof(chunk));
+	PCUT_ASSERT_ERRNO_VAL(EOK, hash_init(&ctx, HASH_SHA256));
+
+	/* Pieces of 1 and 999 bytes, 1000 * 1000 bytes in total */
+	for (size_t i = 0; i < 2000; i++)
+		hash_update(&ctx, chunk, 1 + (i % 2) * 998);
+
+	hash_final(&ctx, out);
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(out, expected, 32));
+}
+
+PCUT_TEST(hmac)
+{
+	static const uint8_t expected256[32] = {
+		0x5b, 0xdc, 0xc1, 0x46, 0xbf, 0x60, 0x75, 0x4e,
+		0x6a, 0x04, 0x24, 0x26, 0x08, 0x95, 0x75, 0xc7,
+		0x5a, 0x00, 0x3f, 0x08, 0x9d, 0x27, 0x39, 0x83,
+		0x9d, 0xec, 0x58, 0xb9, 0x64, 0xec, 0x38, 0x43
+	};
+	static const uint8_t expected512[64] = {
+		0x16, 0x4b, 0x7a, 0x7b, 0xfc, 0xf8, 0x19, 0xe2,
+		0xe3, 0x95, 0xfb, 0xe7, 0x3b, 0x56, 0xe0, 0xa3,
+		0x87, 0xbd, 0x64, 0x22, 0x2e, 0x83, 0x1f, 0xd6,
+		0x10, 0x27, 0x0c, 0xd7, 0xea, 0x25, 0x05, 0x54,
+		0x97, 0x58, 0xbf, 0x75, 0xc0, 0x5a, 0x99, 0x4a,
+		0x6d, 0x03, 0x4f, 0x65, 0xf8, 0xf0, 0xe6, 0xfd,
+		0xca, 0xea, 0xb1, 0xa3, 0x4d, 0x4a, 0x6b, 0x4b,
+		0x63, 0x6e, 0x07, 0x0a, 0x38, 0xbc, 0xe7, 0x37
+	};
+	const char *msg = "what do ya want for nothing?";
+	uint8_t out[64];
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, hmac((uint8_t *) "Jefe", 4, (uint8_t *) msg,
+	    str_size(msg), out, HASH_SHA256));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(out, expected256, 32));
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, hmac((uint8_t *) "Jefe", 4, (uint8_t *) msg,
+	    str_size(msg), out, HASH_SHA512));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(out, expected512, 64));
+}
+
+PCUT_TEST(hmac_batch)
+{
+	uint8_t msg[3][40];
+	uint8_t out[3][32];
+	uint8_t expected[32];
+	const uint8_t *msgs[3];
+	uint8_t *outs[3];
+	hmac_ctx_t ctx;
+
+	for (size_t i = 0; i < 3; i++) {
+		memset(msg[i], 'x' + i, sizeof(msg[i]));
+		msgs[i] = msg[i];
+		outs[i] = out[i];
+	}
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, hmac_init(&ctx, (uint8_t *) "key", 3,
+	    HASH_SHA256));
+	hmac_batch(&ctx, msgs, sizeof(msg[0]), outs, 3);
+
+	for (size_t i = 0; i < 3; i++) {
+		PCUT_ASSERT_ERRNO_VAL(EOK, hmac((uint8_t *) "key", 3, msg[i],
+		    sizeof(msg[i]), expected, HASH_SHA256));
+		PCUT_ASSERT_INT_EQUALS(0, memcmp(out[i], expected, 32));
+	}
+}
+
+/** IEEE 802.11i PSK test vector */
+PCUT_TEST(pbkdf2_wpa)
+{
+	static const uint8_t expected[32] = {
+		0xf4, 0x2c, 0x6f, 0xc5, 0x2d, 0xf0, 0xeb, 0xef,
+		0x9e, 0xbb, 0x4b, 0x90, 0xb3, 0x8a, 0x5f, 0x90,
+		0x2e, 0x83, 0xfe, 0x1b, 0x13, 0x5a, 0x70, 0xe2,
+		0x3a, 0xed, 0x76, 0x2e, 0x97, 0x10, 0xa1, 0x2e
+	};
+	uint8_t out[PBKDF2_KEY_LENGTH];
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, pbkdf2((uint8_t *) "password", 8,
+	    (uint8_t *) "IEEE", 4, out));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(out, expected, 32));
+}
+
+PCUT_TEST(pbkdf2_sha256)
+{
+	static const uint8_t expected[40] = {
+		0xae, 0x4d, 0x0c, 0x95, 0xaf, 0x6b, 0x46, 0xd3,
+		0x2d, 0x0a, 0xdf, 0xf9, 0x28, 0xf0, 0x6d, 0xd0,
+		0x2a, 0x30, 0x3f, 0x8e, 0xf3, 0xc2, 0x51, 0xdf,
+		0xd6, 0xe2, 0xd8, 0x5a, 0x95, 0x47, 0x4c, 0x43,
+		0x83, 0x06, 0x51, 0xaf, 0xcb, 0x5c, 0x86, 0x2f
+	};
+	uint8_t out[40];
+
+	PCUT_ASSERT_ERRNO_VAL(EOK, pbkdf2_hmac(HASH_SHA256,
+	    (uint8_t *) "password", 8, (uint8_t *) "salt", 4, 2, out, 40));
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(out, expected, 40));
+}
+
+PCUT_EXPORT(hash);
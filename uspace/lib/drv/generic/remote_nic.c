@@ -85,7 +85,8 @@ typedef enum {
 	NIC_OFFLOAD_SET,
 	NIC_POLL_GET_MODE,
 	NIC_POLL_SET_MODE,
-	NIC_POLL_NOW
+	NIC_POLL_NOW,
+	NIC_SEND_OFFLOAD
 } nic_funcs_t;
 
 /** Send frame from NIC
@@ -117,6 +118,38 @@ errno_t nic_send_frame(async_sess_t *dev_sess, void *data, size_t size)
 	return retval;
 }
 
+/** Send frame with offload requests to NIC
+ *
+ * @param[in] dev_sess
+ * @param[in] data     Frame data
+ * @param[in] size     Frame size in bytes
+ * @param[in] flags    Offload flags (NIC_FF_xxx)
+ * @param[in] mss      Maximum segment size for NIC_FF_TSO
+ *
+ * @return EOK If the operation was successfully completed
+ *
+ */
+errno_t nic_send_frame_offload(async_sess_t *dev_sess, void *data, size_t size,
+    uint32_t flags, size_t mss)
+{
+	async_exch_t *exch = async_exchange_begin(dev_sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_3(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
+	    NIC_SEND_OFFLOAD, (sysarg_t) flags, (sysarg_t) mss, &answer);
+	errno_t retval = async_data_write_start(exch, data, size);
+
+	async_exchange_end(exch);
+
+	if (retval != EOK) {
+		async_forget(req);
+		return retval;
+	}
+
+	async_wait_for(req, &retval);
+	return retval;
+}
+
 /** Create callback connection from NIC service
  *
  * @param[in] dev_sess
@@ -1244,7 +1277,7 @@ errno_t nic_offload_set(async_sess_t *dev_sess, uint32_t mask, uint32_t active)
 {
 	async_exch_t *exch = async_exchange_begin(dev_sess);
 	errno_t rc = async_req_3_0(exch, DEV_IFACE_ID(NIC_DEV_IFACE),
-	    NIC_AUTONEG_RESTART, (sysarg_t) mask, (sysarg_t) active);
+	    NIC_OFFLOAD_SET, (sysarg_t) mask, (sysarg_t) active);
 	async_exchange_end(exch);
 
 	return rc;
@@ -1356,6 +1389,35 @@ static void remote_nic_send_frame(ddf_fun_t *dev, void *iface,
 	free(data);
 }
 
+static void remote_nic_send_frame_offload(ddf_fun_t *dev, void *iface,
+    ipc_call_t *call)
+{
+	nic_iface_t *nic_iface = (nic_iface_t *) iface;
+
+	void *data;
+	size_t size;
+	errno_t rc;
+
+	rc = async_data_write_accept(&data, false, 0, 0, 0, &size);
+	if (rc != EOK) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	if (nic_iface->send_frame_offload == NULL) {
+		async_answer_0(call, ENOTSUP);
+		free(data);
+		return;
+	}
+
+	uint32_t flags = (uint32_t) ipc_get_arg2(call);
+	size_t mss = (size_t) ipc_get_arg3(call);
+
+	rc = nic_iface->send_frame_offload(dev, data, size, flags, mss);
+	async_answer_0(call, rc);
+	free(data);
+}
+
 static void remote_nic_callback_create(ddf_fun_t *dev, void *iface,
     ipc_call_t *call)
 {
@@ -2529,7 +2591,8 @@ static const remote_iface_func_ptr_t remote_nic_iface_ops[] = {
 	[NIC_OFFLOAD_SET] = remote_nic_offload_set,
 	[NIC_POLL_GET_MODE] = remote_nic_poll_get_mode,
 	[NIC_POLL_SET_MODE] = remote_nic_poll_set_mode,
-	[NIC_POLL_NOW] = remote_nic_poll_now
+	[NIC_POLL_NOW] = remote_nic_poll_now,
+	[NIC_SEND_OFFLOAD] = remote_nic_send_frame_offload
 };
 
 /** Remote NIC interface structure.
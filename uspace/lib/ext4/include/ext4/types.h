@@ -35,7 +35,10 @@
 #ifndef LIBEXT4_TYPES_H_
 #define LIBEXT4_TYPES_H_
 
+#include <adt/hash_table.h>
+#include <adt/list.h>
 #include <block.h>
+#include <fibril_synch.h>
 
 /*
  * Structure of the super block
@@ -215,6 +218,7 @@ typedef struct ext4_superblock {
 
 #define EXT4_FEATURE_INCOMPAT_SUPP \
 	(EXT4_FEATURE_INCOMPAT_FILETYPE | \
+	EXT4_FEATURE_INCOMPAT_RECOVER | \
 	EXT4_FEATURE_INCOMPAT_EXTENTS | \
 	EXT4_FEATURE_INCOMPAT_64BIT | \
 	EXT4_FEATURE_INCOMPAT_FLEX_BG)
@@ -232,6 +236,15 @@ typedef struct ext4_filesystem {
 	ext4_superblock_t *superblock;
 	aoff64_t inode_block_limits[4];
 	aoff64_t inode_blocks_per_level[4];
+
+	/* Journal, NULL if metadata are written in place */
+	struct ext4_journal *journal;
+
+	/* In-memory i-node state, see inode_info.c */
+	fibril_mutex_t inode_info_lock;
+	hash_table_t inode_info;
+	list_t inode_info_lru;          /* Unreferenced entries, LRU first */
+	size_t inode_info_unused;       /* Number of entries in the LRU list */
 } ext4_filesystem_t;
 
 /** Size of buffer for volume name. To hold 16 latin-1 chars encoded as UTF-8
@@ -387,12 +400,41 @@ typedef struct ext4_inode {
 
 #define EXT4_INODE_ROOT_INDEX  2
 
+/* Cached mapping of a run of logical blocks to physical blocks */
+typedef struct ext4_extent_status {
+	uint32_t iblock;        /* First logical block */
+	uint32_t count;         /* Number of blocks */
+	uint32_t fblock;        /* First physical block */
+} ext4_extent_status_t;
+
+#define EXT4_EXTENT_STATUS_COUNT  8
+
+/*
+ * In-memory state of an i-node, kept also while the i-node is not
+ * referenced so that it survives between file system operations
+ */
+typedef struct ext4_inode_info {
+	ht_link_t link;
+	link_t lru_link;
+	ext4_filesystem_t *fs;
+	uint32_t index;         /* Index number of the inode */
+	unsigned refcnt;        /* Number of i-node references using it */
+
+	/* Recently used extents, most recently used first */
+	ext4_extent_status_t extents[EXT4_EXTENT_STATUS_COUNT];
+	unsigned extent_count;
+
+	uint32_t prealloc_start; /* First block reserved for this inode */
+	uint32_t prealloc_count; /* Number of reserved blocks */
+} ext4_inode_info_t;
+
 typedef struct ext4_inode_ref {
 	block_t *block;         /* Reference to a block containing this inode */
 	ext4_inode_t *inode;
 	ext4_filesystem_t *fs;
 	uint32_t index;         /* Index number of this inode */
 	bool dirty;
+	ext4_inode_info_t *info; /* In-memory state of this inode */
 } ext4_inode_ref_t;
 
 #define EXT4_DIRECTORY_FILENAME_LEN  255
@@ -557,6 +599,90 @@ typedef struct ext4_hash_info {
 	const uint32_t *seed;
 } ext4_hash_info_t;
 
+/*
+ * JBD2 journal on-disk structures. Unlike the rest of the file system,
+ * the journal is stored in big endian.
+ */
+#define EXT4_JOURNAL_MAGIC  0xC03B3998
+
+#define EXT4_JOURNAL_DESCRIPTOR_BLOCK  1
+#define EXT4_JOURNAL_COMMIT_BLOCK      2
+#define EXT4_JOURNAL_SUPERBLOCK_V1     3
+#define EXT4_JOURNAL_SUPERBLOCK_V2     4
+#define EXT4_JOURNAL_REVOKE_BLOCK      5
+
+#define EXT4_JOURNAL_FLAG_ESCAPE     1  /* First four bytes were the magic */
+#define EXT4_JOURNAL_FLAG_SAME_UUID  2  /* No UUID follows the tag */
+#define EXT4_JOURNAL_FLAG_DELETED    4
+#define EXT4_JOURNAL_FLAG_LAST_TAG   8  /* Last tag in descriptor block */
+
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_REVOKE        0x0001
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT         0x0002
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_ASYNC_COMMIT  0x0004
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_CSUM_V2       0x0008
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_CSUM_V3       0x0010
+
+#define EXT4_JOURNAL_FEATURE_INCOMPAT_SUPP \
+	(EXT4_JOURNAL_FEATURE_INCOMPAT_REVOKE | \
+	EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT)
+
+typedef struct ext4_journal_header {
+	uint32_t magic;
+	uint32_t block_type;
+	uint32_t sequence;             /* Transaction the block belongs to */
+} __attribute__((packed)) ext4_journal_header_t;
+
+typedef struct ext4_journal_superblock {
+	ext4_journal_header_t header;
+
+	/* Static information describing the journal */
+	uint32_t block_size;           /* Journal device block size */
+	uint32_t max_len;              /* Total blocks in journal file */
+	uint32_t first;                /* First block of log information */
+
+	/* Dynamic information describing the current state of the log */
+	uint32_t sequence;             /* First commit ID expected in log */
+	uint32_t start;                /* Block number of start of log */
+	uint32_t error;                /* Error value, as set by abort */
+
+	/* Valid only for version 2 superblock */
+	uint32_t feature_compat;
+	uint32_t feature_incompat;
+	uint32_t feature_ro_compat;
+	uint8_t uuid[16];              /* UUID of the journal */
+	uint32_t nr_users;             /* Number of file systems sharing log */
+	uint32_t dyn_super;            /* Block number of dynamic superblock */
+	uint32_t max_transaction;      /* Limit of journal blocks per trans. */
+	uint32_t max_trans_data;       /* Limit of data blocks per trans. */
+	uint8_t checksum_type;
+	uint8_t padding2[3];
+	uint32_t padding[42];
+	uint32_t checksum;
+	uint8_t users[16 * 48];        /* IDs of file systems sharing log */
+} __attribute__((packed)) ext4_journal_superblock_t;
+
+typedef struct ext4_journal_block_tag {
+	uint32_t block_nr;
+	uint16_t checksum;
+	uint16_t flags;
+	uint32_t block_nr_high;        /* Only with 64-bit feature */
+} __attribute__((packed)) ext4_journal_block_tag_t;
+
+typedef struct ext4_journal_revoke_header {
+	ext4_journal_header_t header;
+	uint32_t count;                /* Bytes used in the block */
+} __attribute__((packed)) ext4_journal_revoke_header_t;
+
+typedef struct ext4_journal_commit_header {
+	ext4_journal_header_t header;
+	uint8_t checksum_type;
+	uint8_t checksum_size;
+	uint8_t padding[2];
+	uint32_t checksum[8];
+	uint64_t commit_sec;
+	uint32_t commit_nsec;
+} __attribute__((packed)) ext4_journal_commit_header_t;
+
 #endif
 
 /**
@@ -35,6 +35,7 @@
  * @brief Physical block allocator.
  */
 
+#include <assert.h>
 #include <errno.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -43,9 +44,13 @@
 #include "ext4/block_group.h"
 #include "ext4/filesystem.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/superblock.h"
 #include "ext4/types.h"
 
+/** Maximal number of blocks reserved for an inode at once */
+#define EXT4_BALLOC_MAX_RESERVE  2048
+
 /** Free block.
  *
  * @param inode_ref  Inode, where the block is allocated
@@ -80,9 +85,12 @@ errno_t ext4_balloc_free_block(ext4_inode_ref_t *inode_ref, uint32_t block_addr)
 		return rc;
 	}
 
+	/* Recovery must not overwrite the block once it is reused */
+	ext4_journal_revoke(fs, block_addr, 1);
+
 	/* Modify bitmap */
 	ext4_bitmap_free_bit(bitmap_block->data, index_in_group);
-	bitmap_block->dirty = true;
+	ext4_journal_dirty(fs, bitmap_block);
 
 	/* Release block with bitmap */
 	rc = block_put(bitmap_block);
@@ -119,10 +127,9 @@ errno_t ext4_balloc_free_block(ext4_inode_ref_t *inode_ref, uint32_t block_addr)
 	return ext4_filesystem_put_block_group_ref(bg_ref);
 }
 
-static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
-    uint32_t first, uint32_t count)
+static errno_t ext4_balloc_free_blocks_internal(ext4_filesystem_t *fs,
+    ext4_inode_ref_t *inode_ref, uint32_t first, uint32_t count)
 {
-	ext4_filesystem_t *fs = inode_ref->fs;
 	ext4_superblock_t *sb = fs->superblock;
 
 	/* Compute indexes */
@@ -153,9 +160,13 @@ static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
 		return rc;
 	}
 
+	/* Reserved blocks were never used, others may have been journaled */
+	if (inode_ref != NULL)
+		ext4_journal_revoke(fs, first, count);
+
 	/* Modify bitmap */
 	ext4_bitmap_free_bits(bitmap_block->data, index_in_group_first, count);
-	bitmap_block->dirty = true;
+	ext4_journal_dirty(fs, bitmap_block);
 
 	/* Release block with bitmap */
 	rc = block_put(bitmap_block);
@@ -173,12 +184,14 @@ static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
 	sb_free_blocks += count;
 	ext4_superblock_set_free_blocks_count(sb, sb_free_blocks);
 
-	/* Update inode blocks count */
-	uint64_t ino_blocks =
-	    ext4_inode_get_blocks_count(sb, inode_ref->inode);
-	ino_blocks -= count * (block_size / EXT4_INODE_BLOCK_SIZE);
-	ext4_inode_set_blocks_count(sb, inode_ref->inode, ino_blocks);
-	inode_ref->dirty = true;
+	/* Update inode blocks count (reserved blocks are not charged yet) */
+	if (inode_ref != NULL) {
+		uint64_t ino_blocks =
+		    ext4_inode_get_blocks_count(sb, inode_ref->inode);
+		ino_blocks -= count * (block_size / EXT4_INODE_BLOCK_SIZE);
+		ext4_inode_set_blocks_count(sb, inode_ref->inode, ino_blocks);
+		inode_ref->dirty = true;
+	}
 
 	/* Update block group free blocks count */
 	uint32_t free_blocks =
@@ -192,20 +205,21 @@ static errno_t ext4_balloc_free_blocks_internal(ext4_inode_ref_t *inode_ref,
 	return ext4_filesystem_put_block_group_ref(bg_ref);
 }
 
-/** Free continuous set of blocks.
+/** Free continuous set of blocks, possibly spanning several block groups.
  *
- * @param inode_ref Inode, where the blocks are allocated
+ * @param fs        Filesystem
+ * @param inode_ref Inode, where the blocks are allocated, or NULL if
+ *                  the blocks are not counted in any inode
  * @param first     First block to release
  * @param count     Number of blocks to release
  *
  */
-errno_t ext4_balloc_free_blocks(ext4_inode_ref_t *inode_ref,
-    uint32_t first, uint32_t count)
+static errno_t ext4_balloc_free_range(ext4_filesystem_t *fs,
+    ext4_inode_ref_t *inode_ref, uint32_t first, uint32_t count)
 {
 	errno_t r;
 	uint32_t gid;
 	uint64_t limit;
-	ext4_filesystem_t *fs = inode_ref->fs;
 	ext4_superblock_t *sb = fs->superblock;
 
 	while (count) {
@@ -220,7 +234,7 @@ errno_t ext4_balloc_free_blocks(ext4_inode_ref_t *inode_ref,
 			 */
 			uint32_t s = limit - first;
 
-			r = ext4_balloc_free_blocks_internal(inode_ref,
+			r = ext4_balloc_free_blocks_internal(fs, inode_ref,
 			    first, s);
 			if (r != EOK)
 				return r;
@@ -228,7 +242,7 @@ errno_t ext4_balloc_free_blocks(ext4_inode_ref_t *inode_ref,
 			first = limit;
 			count -= s;
 		} else {
-			return ext4_balloc_free_blocks_internal(inode_ref,
+			return ext4_balloc_free_blocks_internal(fs, inode_ref,
 			    first, count);
 		}
 	}
@@ -236,6 +250,38 @@ errno_t ext4_balloc_free_blocks(ext4_inode_ref_t *inode_ref,
 	return EOK;
 }
 
+/** Free continuous set of blocks.
+ *
+ * @param inode_ref Inode, where the blocks are allocated
+ * @param first     First block to release
+ * @param count     Number of blocks to release
+ *
+ */
+errno_t ext4_balloc_free_blocks(ext4_inode_ref_t *inode_ref,
+    uint32_t first, uint32_t count)
+{
+	return ext4_balloc_free_range(inode_ref->fs, inode_ref, first, count);
+}
+
+/** Free reserved blocks.
+ *
+ * Reserved blocks are marked as used, but they are not counted
+ * in any inode.
+ *
+ * @param fs    Filesystem
+ * @param first First block to release
+ * @param count Number of blocks to release
+ *
+ */
+errno_t ext4_balloc_free_reserved(ext4_filesystem_t *fs, uint32_t first,
+    uint32_t count)
+{
+	if (count == 0)
+		return EOK;
+
+	return ext4_balloc_free_range(fs, NULL, first, count);
+}
+
 /** Compute first block for data in block group.
  *
  * @param sb   Pointer to superblock
@@ -335,6 +381,238 @@ static errno_t ext4_balloc_find_goal(ext4_inode_ref_t *inode_ref, uint32_t *goal
 	return ext4_filesystem_put_block_group_ref(bg_ref);
 }
 
+/** Take the first block of the inode's reservation.
+ *
+ * The block is already marked as used in the bitmap, only the inode
+ * blocks count has to be updated.
+ *
+ * @param inode_ref Inode with non-empty reservation
+ *
+ */
+static void ext4_balloc_take_reserved(ext4_inode_ref_t *inode_ref)
+{
+	ext4_superblock_t *sb = inode_ref->fs->superblock;
+	uint32_t block_size = ext4_superblock_get_block_size(sb);
+
+	assert(inode_ref->info->prealloc_count > 0);
+	inode_ref->info->prealloc_start++;
+	inode_ref->info->prealloc_count--;
+
+	uint64_t ino_blocks =
+	    ext4_inode_get_blocks_count(sb, inode_ref->inode);
+	ino_blocks += block_size / EXT4_INODE_BLOCK_SIZE;
+	ext4_inode_set_blocks_count(sb, inode_ref->inode, ino_blocks);
+	inode_ref->dirty = true;
+}
+
+/** Allocate run of free blocks in one block group.
+ *
+ * The bitmap of the group is read once and the whole run is marked as
+ * used. Free blocks counters of the group and superblock are updated,
+ * the inode blocks count is not.
+ *
+ * @param inode_ref Inode to allocate blocks for
+ * @param bgid      Block group to allocate in
+ * @param goal_idx  Index in group where the search starts
+ * @param count     Requested number of blocks
+ * @param partial   Accept shorter run if there is no run of @a count blocks
+ * @param fblock    Output value - first allocated block
+ * @param rcount    Output value - number of allocated blocks, or the length
+ *                  of the longest free run when ENOSPC is returned
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_balloc_alloc_run_in_group(ext4_inode_ref_t *inode_ref,
+    uint32_t bgid, uint32_t goal_idx, uint32_t count, bool partial,
+    uint32_t *fblock, uint32_t *rcount)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	ext4_superblock_t *sb = fs->superblock;
+	ext4_block_group_ref_t *bg_ref;
+	block_t *bitmap_block;
+	uint32_t idx;
+	uint32_t len = 0;
+
+	*rcount = 0;
+
+	errno_t rc = ext4_filesystem_get_block_group_ref(fs, bgid, &bg_ref);
+	if (rc != EOK)
+		return rc;
+
+	uint32_t free_blocks =
+	    ext4_block_group_get_free_blocks_count(bg_ref->block_group, sb);
+	if (free_blocks == 0) {
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return ENOSPC;
+	}
+
+	uint32_t first_in_group_index =
+	    ext4_filesystem_blockaddr2_index_in_group(sb,
+	    ext4_balloc_get_first_data_block_in_group(sb, bg_ref));
+	uint32_t blocks_in_group = ext4_superblock_get_blocks_in_group(sb, bgid);
+
+	if (goal_idx < first_in_group_index)
+		goal_idx = first_in_group_index;
+
+	uint32_t bitmap_block_addr =
+	    ext4_block_group_get_block_bitmap(bg_ref->block_group, sb);
+	rc = block_get(&bitmap_block, fs->device, bitmap_block_addr,
+	    BLOCK_FLAGS_NONE);
+	if (rc != EOK) {
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc;
+	}
+
+	rc = ext4_bitmap_find_free_run(bitmap_block->data, goal_idx,
+	    blocks_in_group, count, &idx, &len);
+	if (rc != EOK && goal_idx > first_in_group_index) {
+		/* Try again from the beginning of the group */
+		uint32_t idx2;
+		uint32_t len2;
+
+		rc = ext4_bitmap_find_free_run(bitmap_block->data,
+		    first_in_group_index, blocks_in_group, count, &idx2, &len2);
+		if (rc == EOK || len2 > len) {
+			idx = idx2;
+			len = len2;
+		}
+	}
+
+	if (len == 0 || (rc != EOK && !partial)) {
+		*rcount = len;
+		block_put(bitmap_block);
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return ENOSPC;
+	}
+
+	ext4_bitmap_set_bits(bitmap_block->data, idx, len);
+	ext4_journal_dirty(fs, bitmap_block);
+
+	rc = block_put(bitmap_block);
+	if (rc != EOK) {
+		ext4_filesystem_put_block_group_ref(bg_ref);
+		return rc;
+	}
+
+	/* Update superblock free blocks count */
+	uint32_t sb_free_blocks = ext4_superblock_get_free_blocks_count(sb);
+	sb_free_blocks -= len;
+	ext4_superblock_set_free_blocks_count(sb, sb_free_blocks);
+
+	/* Update block group free blocks count */
+	ext4_block_group_set_free_blocks_count(bg_ref->block_group, sb,
+	    free_blocks - len);
+	bg_ref->dirty = true;
+
+	*fblock = ext4_filesystem_index_in_group2blockaddr(sb, idx, bgid);
+	*rcount = len;
+
+	return ext4_filesystem_put_block_group_ref(bg_ref);
+}
+
+/** Reserve contiguous run of blocks for an inode.
+ *
+ * Multi-block allocation: the blocks that are about to be appended to
+ * the inode are allocated as one run, reading each block group bitmap
+ * at most once. The run is kept in the in-memory i-node state and subsequent
+ * calls to ext4_balloc_alloc_block() and ext4_balloc_try_alloc_block()
+ * take blocks from it without touching the bitmaps, so that the file
+ * grows by one extent.
+ *
+ * The group of the goal block is tried first, then the other groups.
+ * If no group has a free run of @a count blocks, the longest run found
+ * is reserved instead.
+ *
+ * Reserved blocks are marked as used on disk, but they are charged to
+ * the inode only when taken. Unused blocks are returned by
+ * ext4_balloc_release_reservation().
+ *
+ * @param inode_ref Inode to reserve blocks for
+ * @param count     Number of blocks the caller is going to append
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_reserve(ext4_inode_ref_t *inode_ref, uint32_t count)
+{
+	ext4_superblock_t *sb = inode_ref->fs->superblock;
+	uint32_t goal;
+	uint32_t fblock;
+	uint32_t len;
+	errno_t rc;
+
+	/* Single blocks are handled well by ext4_balloc_alloc_block() */
+	if (count <= 1 || inode_ref->info->prealloc_count > 0)
+		return EOK;
+
+	if (count > EXT4_BALLOC_MAX_RESERVE)
+		count = EXT4_BALLOC_MAX_RESERVE;
+
+	rc = ext4_balloc_find_goal(inode_ref, &goal);
+	if (rc != EOK)
+		return rc;
+
+	uint32_t block_group_count = ext4_superblock_get_block_group_count(sb);
+	uint32_t goal_group = ext4_filesystem_blockaddr2group(sb, goal);
+	uint32_t goal_idx =
+	    ext4_filesystem_blockaddr2_index_in_group(sb, goal);
+	uint32_t best_group = goal_group;
+	uint32_t best_len = 0;
+
+	for (uint32_t i = 0; i < block_group_count; i++) {
+		uint32_t bgid = (goal_group + i) % block_group_count;
+
+		rc = ext4_balloc_alloc_run_in_group(inode_ref, bgid,
+		    bgid == goal_group ? goal_idx : 0, count, false,
+		    &fblock, &len);
+		if (rc == EOK)
+			goto success;
+		if (rc != ENOSPC)
+			return rc;
+
+		if (len > best_len) {
+			best_group = bgid;
+			best_len = len;
+		}
+	}
+
+	/* No run is long enough, take the longest one */
+	if (best_len <= 1)
+		return EOK;
+
+	rc = ext4_balloc_alloc_run_in_group(inode_ref, best_group,
+	    best_group == goal_group ? goal_idx : 0, best_len, true,
+	    &fblock, &len);
+	if (rc == ENOSPC)
+		return EOK;
+	if (rc != EOK)
+		return rc;
+
+success:
+	inode_ref->info->prealloc_start = fblock;
+	inode_ref->info->prealloc_count = len;
+	return EOK;
+}
+
+/** Release unused part of the inode's reservation.
+ *
+ * @param inode_ref Inode to release reservation of
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_balloc_release_reservation(ext4_inode_ref_t *inode_ref)
+{
+	uint32_t first = inode_ref->info->prealloc_start;
+	uint32_t count = inode_ref->info->prealloc_count;
+
+	inode_ref->info->prealloc_start = 0;
+	inode_ref->info->prealloc_count = 0;
+
+	return ext4_balloc_free_reserved(inode_ref->fs, first, count);
+}
+
 /** Data block allocation algorithm.
  *
  * @param inode_ref Inode to allocate block for
@@ -354,6 +632,13 @@ errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
 	uint32_t goal;
 	uint32_t block_size;
 
+	/* Take the block from the reservation if there is one */
+	if (inode_ref->info->prealloc_count > 0) {
+		*fblock = inode_ref->info->prealloc_start;
+		ext4_balloc_take_reserved(inode_ref);
+		return EOK;
+	}
+
 	/* Find GOAL */
 	errno_t rc = ext4_balloc_find_goal(inode_ref, &goal);
 	if (rc != EOK)
@@ -404,7 +689,7 @@ errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
 	/* Check if goal is free */
 	if (ext4_bitmap_is_free_bit(bitmap_block->data, index_in_group)) {
 		ext4_bitmap_set_bit(bitmap_block->data, index_in_group);
-		bitmap_block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, bitmap_block);
 		rc = block_put(bitmap_block);
 		if (rc != EOK) {
 			ext4_filesystem_put_block_group_ref(bg_ref);
@@ -430,7 +715,7 @@ errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
 	    ++tmp_idx) {
 		if (ext4_bitmap_is_free_bit(bitmap_block->data, tmp_idx)) {
 			ext4_bitmap_set_bit(bitmap_block->data, tmp_idx);
-			bitmap_block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, bitmap_block);
 			rc = block_put(bitmap_block);
 			if (rc != EOK)
 				return rc;
@@ -447,7 +732,7 @@ errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
 	rc = ext4_bitmap_find_free_byte_and_set_bit(bitmap_block->data,
 	    index_in_group, &rel_block_idx, blocks_in_group);
 	if (rc == EOK) {
-		bitmap_block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, bitmap_block);
 		rc = block_put(bitmap_block);
 		if (rc != EOK)
 			return rc;
@@ -463,7 +748,7 @@ errno_t ext4_balloc_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t *fblock)
 	rc = ext4_bitmap_find_free_bit_and_set(bitmap_block->data,
 	    index_in_group, &rel_block_idx, blocks_in_group);
 	if (rc == EOK) {
-		bitmap_block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, bitmap_block);
 		rc = block_put(bitmap_block);
 		if (rc != EOK)
 			return rc;
@@ -535,7 +820,7 @@ goal_failed:
 		rc = ext4_bitmap_find_free_byte_and_set_bit(bitmap_block->data,
 		    index_in_group, &rel_block_idx, blocks_in_group);
 		if (rc == EOK) {
-			bitmap_block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, bitmap_block);
 			rc = block_put(bitmap_block);
 			if (rc != EOK) {
 				ext4_filesystem_put_block_group_ref(bg_ref);
@@ -553,7 +838,7 @@ goal_failed:
 		rc = ext4_bitmap_find_free_bit_and_set(bitmap_block->data,
 		    index_in_group, &rel_block_idx, blocks_in_group);
 		if (rc == EOK) {
-			bitmap_block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, bitmap_block);
 			rc = block_put(bitmap_block);
 			if (rc != EOK) {
 				ext4_filesystem_put_block_group_ref(bg_ref);
@@ -631,6 +916,14 @@ errno_t ext4_balloc_try_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t fblock
 	ext4_filesystem_t *fs = inode_ref->fs;
 	ext4_superblock_t *sb = fs->superblock;
 
+	/* Block reserved for this inode is already marked as used */
+	if (inode_ref->info->prealloc_count > 0 &&
+	    inode_ref->info->prealloc_start == fblock) {
+		ext4_balloc_take_reserved(inode_ref);
+		*free = true;
+		return EOK;
+	}
+
 	/* Compute indexes */
 	uint32_t block_group = ext4_filesystem_blockaddr2group(sb, fblock);
 	uint32_t index_in_group =
@@ -658,7 +951,7 @@ errno_t ext4_balloc_try_alloc_block(ext4_inode_ref_t *inode_ref, uint32_t fblock
 	/* Allocate block if possible */
 	if (*free) {
 		ext4_bitmap_set_bit(bitmap_block->data, index_in_group);
-		bitmap_block->dirty = true;
+		ext4_journal_dirty(fs, bitmap_block);
 	}
 
 	/* Release block with bitmap */
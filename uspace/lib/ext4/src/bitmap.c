@@ -264,6 +264,110 @@ errno_t ext4_bitmap_find_free_bit_and_set(uint8_t *bitmap, uint32_t start_idx,
 	return ENOSPC;
 }
 
+/** Set continous set of bits (set to 1).
+ *
+ * Index and count must be checked by caller, if they aren't out of bounds.
+ *
+ * @param bitmap Pointer to bitmap
+ * @param index  Index of first bit to be set
+ * @param count  Number of bits to be set
+ *
+ */
+void ext4_bitmap_set_bits(uint8_t *bitmap, uint32_t index, uint32_t count)
+{
+	uint32_t idx = index;
+	uint32_t remaining = count;
+
+	/* Align index to multiple of 8 */
+	while (((idx % 8) != 0) && (remaining > 0)) {
+		bitmap[idx / 8] |= 1 << (idx % 8);
+		idx++;
+		remaining--;
+	}
+
+	/* Set the whole bytes */
+	while (remaining >= 8) {
+		bitmap[idx / 8] = 255;
+		idx += 8;
+		remaining -= 8;
+	}
+
+	/* Set the rest of bits */
+	while (remaining > 0) {
+		bitmap[idx / 8] |= 1 << (idx % 8);
+		idx++;
+		remaining--;
+	}
+}
+
+/** Find run of free bits.
+ *
+ * Walk through bitmap and try to find the first run of at least
+ * @a count free bits. Fully used bytes are skipped as a whole.
+ * Bitmap is not modified.
+ *
+ * @param bitmap    Pointer to bitmap
+ * @param start_idx Index of bit, where algorithm will begin
+ * @param max       Maximum index of bit in bitmap
+ * @param count     Requested length of the run
+ * @param index     Output value - index of the first bit of the run
+ *                  (or of the longest run if no run is long enough)
+ * @param len       Output value - length of the run found, at most @a count
+ *
+ * @return EOK if run of @a count bits was found, ENOSPC otherwise
+ *
+ */
+errno_t ext4_bitmap_find_free_run(uint8_t *bitmap, uint32_t start_idx,
+    uint32_t max, uint32_t count, uint32_t *index, uint32_t *len)
+{
+	uint32_t idx = start_idx;
+	uint32_t best_idx = 0;
+	uint32_t best_len = 0;
+
+	while (idx < max) {
+		/* Skip used bits, whole bytes at once */
+		if ((idx % 8) == 0 && bitmap[idx / 8] == 255) {
+			idx += 8;
+			continue;
+		}
+
+		if (!ext4_bitmap_is_free_bit(bitmap, idx)) {
+			idx++;
+			continue;
+		}
+
+		/* Measure the run of free bits */
+		uint32_t run = idx;
+		while (idx < max && idx - run < count) {
+			if ((idx % 8) == 0 && bitmap[idx / 8] == 0 &&
+			    idx + 8 <= max) {
+				idx += 8;
+				continue;
+			}
+
+			if (!ext4_bitmap_is_free_bit(bitmap, idx))
+				break;
+
+			idx++;
+		}
+
+		if (idx - run >= count) {
+			*index = run;
+			*len = count;
+			return EOK;
+		}
+
+		if (idx - run > best_len) {
+			best_idx = run;
+			best_len = idx - run;
+		}
+	}
+
+	*index = best_idx;
+	*len = best_len;
+	return ENOSPC;
+}
+
 /**
  * @}
  */
@@ -44,6 +44,7 @@
 #include "ext4/directory_index.h"
 #include "ext4/filesystem.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/superblock.h"
 
 /** Get i-node number from directory entry.
@@ -466,7 +467,7 @@ errno_t ext4_directory_add_entry(ext4_inode_ref_t *parent, const char *name,
 	    child, name, name_len);
 
 	/* Save new block */
-	new_block->dirty = true;
+	ext4_journal_dirty(fs, new_block);
 	rc = block_put(new_block);
 
 	return rc;
@@ -612,7 +613,7 @@ errno_t ext4_directory_remove_entry(ext4_inode_ref_t *parent, const char *name)
 		    tmp_dentry_length + del_entry_length);
 	}
 
-	result.block->dirty = true;
+	ext4_journal_dirty(parent->fs, result.block);
 
 	return ext4_directory_destroy_result(&result);
 }
@@ -655,7 +656,7 @@ errno_t ext4_directory_try_insert_entry(ext4_superblock_t *sb,
 		if ((inode == 0) && (rec_len >= required_len)) {
 			ext4_directory_write_entry(sb, dentry, rec_len, child,
 			    name, name_len);
-			target_block->dirty = true;
+			ext4_journal_dirty(child->fs, target_block);
 
 			return EOK;
 		}
@@ -682,7 +683,7 @@ errno_t ext4_directory_try_insert_entry(ext4_superblock_t *sb,
 				ext4_directory_write_entry(sb, new_entry,
 				    free_space, child, name, name_len);
 
-				target_block->dirty = true;
+				ext4_journal_dirty(child->fs, target_block);
 
 				return EOK;
 			}
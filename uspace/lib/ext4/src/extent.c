@@ -34,13 +34,16 @@
  * @brief Ext4 extent structures operations.
  */
 
+#include <assert.h>
 #include <byteorder.h>
 #include <errno.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 #include "ext4/balloc.h"
 #include "ext4/extent.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/superblock.h"
 
 /** Get logical number of the block covered by extent.
@@ -360,21 +363,87 @@ static void ext4_extent_binsearch(ext4_extent_header_t *header,
 	*extent = l - 1;
 }
 
-/** Find physical block in the extent tree by logical block number.
+/** Look up logical block in the extent status cache.
  *
- * There is no need to save path in the tree during this algorithm.
+ * Found entry is moved to the front of the cache.
  *
- * @param inode_ref I-node to load block from
- * @param iblock    Logical block number to find
- * @param fblock    Output value for physical block number
+ * @param info   In-memory state of the i-node
+ * @param iblock Logical block number to find
+ * @param es     Output value - cached extent containing @a iblock
+ *
+ * @return True if found
+ *
+ */
+static bool ext4_extent_cache_lookup(ext4_inode_info_t *info, uint32_t iblock,
+    ext4_extent_status_t *es)
+{
+	for (unsigned i = 0; i < info->extent_count; ++i) {
+		ext4_extent_status_t *entry = &info->extents[i];
+
+		if (iblock >= entry->iblock &&
+		    iblock - entry->iblock < entry->count) {
+			*es = *entry;
+			memmove(&info->extents[1], &info->extents[0],
+			    i * sizeof(ext4_extent_status_t));
+			info->extents[0] = *es;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** Insert extent to the extent status cache.
+ *
+ * The least recently used entry is dropped if the cache is full.
+ *
+ * @param info   In-memory state of the i-node
+ * @param iblock First logical block of the extent
+ * @param count  Number of blocks in the extent
+ * @param fblock First physical block of the extent
+ *
+ */
+static void ext4_extent_cache_insert(ext4_inode_info_t *info, uint32_t iblock,
+    uint32_t count, uint32_t fblock)
+{
+	unsigned keep = info->extent_count;
+	if (keep == EXT4_EXTENT_STATUS_COUNT)
+		keep--;
+
+	memmove(&info->extents[1], &info->extents[0],
+	    keep * sizeof(ext4_extent_status_t));
+
+	info->extents[0].iblock = iblock;
+	info->extents[0].count = count;
+	info->extents[0].fblock = fblock;
+	info->extent_count = keep + 1;
+}
+
+/** Map run of logical blocks to physical blocks.
+ *
+ * The extent status cache of the i-node is tried first, the extent
+ * tree is walked only on a miss.
+ *
+ * @param inode_ref I-node to map blocks of
+ * @param iblock    First logical block to map
+ * @param count     Maximal number of blocks to map (at least one)
+ * @param fblock    Output value - first physical block of the run,
+ *                  or 0 if the run is a hole
+ * @param rcount    Output value - number of blocks in the run, the
+ *                  physical blocks (if any) are contiguous
  *
  * @return Error code
  *
  */
-errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
-    uint32_t *fblock)
+errno_t ext4_extent_map_blocks(ext4_inode_ref_t *inode_ref, uint32_t iblock,
+    uint32_t count, uint32_t *fblock, uint32_t *rcount)
 {
 	errno_t rc = EOK;
+	ext4_inode_info_t *info = inode_ref->info;
+	ext4_extent_status_t es;
+
+	assert(count > 0);
+
 	/* Compute bound defined by i-node size */
 	uint64_t inode_size =
 	    ext4_inode_get_size(inode_ref->fs->superblock, inode_ref->inode);
@@ -385,8 +454,18 @@ errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
 	uint32_t last_idx = (inode_size - 1) / block_size;
 
 	/* Check if requested iblock is not over size of i-node */
-	if (iblock > last_idx) {
+	if (inode_size == 0 || iblock > last_idx) {
 		*fblock = 0;
+		*rcount = count;
+		return EOK;
+	}
+
+	if (count > last_idx - iblock + 1)
+		count = last_idx - iblock + 1;
+
+	if (ext4_extent_cache_lookup(info, iblock, &es)) {
+		*fblock = es.fblock + (iblock - es.iblock);
+		*rcount = min(count, es.count - (iblock - es.iblock));
 		return EOK;
 	}
 
@@ -425,22 +504,63 @@ errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
 	/* Prevent empty leaf */
 	if (extent == NULL) {
 		*fblock = 0;
+		*rcount = 1;
+		goto cleanup;
+	}
+
+	uint32_t first = ext4_extent_get_first_block(extent);
+	uint32_t len = ext4_extent_get_block_count(extent);
+
+	if (iblock < first) {
+		/* Hole before the first extent in the leaf */
+		*fblock = 0;
+		*rcount = min(count, first - iblock);
+	} else if (iblock - first >= len) {
+		/* Hole after the extent, up to the next one in the leaf */
+		ext4_extent_t *last = EXT4_EXTENT_FIRST(header) +
+		    ext4_extent_header_get_entries_count(header) - 1;
+
+		*fblock = 0;
+		*rcount = 1;
+		if (extent < last) {
+			uint32_t next = ext4_extent_get_first_block(extent + 1);
+			*rcount = min(count, next - iblock);
+		}
 	} else {
 		/* Compute requested physical block address */
-		uint32_t phys_block;
-		uint32_t first = ext4_extent_get_first_block(extent);
-		phys_block = ext4_extent_get_start(extent) + iblock - first;
+		uint32_t start = ext4_extent_get_start(extent);
 
-		*fblock = phys_block;
+		ext4_extent_cache_insert(info, first, len, start);
+		*fblock = start + (iblock - first);
+		*rcount = min(count, len - (iblock - first));
 	}
 
-	/* Cleanup */
+cleanup:
 	if (block != NULL)
 		rc = block_put(block);
 
 	return rc;
 }
 
+/** Find physical block in the extent tree by logical block number.
+ *
+ * There is no need to save path in the tree during this algorithm.
+ *
+ * @param inode_ref I-node to load block from
+ * @param iblock    Logical block number to find
+ * @param fblock    Output value for physical block number
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
+    uint32_t *fblock)
+{
+	uint32_t count;
+
+	return ext4_extent_map_blocks(inode_ref, iblock, 1, fblock, &count);
+}
+
 /** Find extent for specified iblock.
  *
  * This function is used for finding block in the extent tree with
@@ -619,6 +739,9 @@ static errno_t ext4_extent_release_branch(ext4_inode_ref_t *inode_ref,
 errno_t ext4_extent_release_blocks_from(ext4_inode_ref_t *inode_ref,
     uint32_t iblock_from)
 {
+	/* Cached extents may cover the released blocks */
+	inode_ref->info->extent_count = 0;
+
 	/* Find the first extent to modify */
 	ext4_extent_path_t *path;
 	errno_t rc2;
@@ -677,7 +800,7 @@ errno_t ext4_extent_release_blocks_from(ext4_inode_ref_t *inode_ref,
 	}
 
 	ext4_extent_header_set_entries_count(path_ptr->header, entries);
-	path_ptr->block->dirty = true;
+	ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 	/* If leaf node is empty, parent entry must be modified */
 	bool remove_parent_record = false;
@@ -716,7 +839,7 @@ errno_t ext4_extent_release_blocks_from(ext4_inode_ref_t *inode_ref,
 		}
 
 		ext4_extent_header_set_entries_count(path_ptr->header, entries);
-		path_ptr->block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 		/* Free the node if it is empty */
 		if ((entries == 0) && (path_ptr != path)) {
@@ -828,7 +951,7 @@ static errno_t ext4_extent_append_extent(ext4_inode_ref_t *inode_ref,
 			ext4_extent_header_set_depth(path_ptr->header, path_ptr->depth);
 			ext4_extent_header_set_generation(path_ptr->header, 0);
 
-			path_ptr->block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 			/* Jump to the preceeding item */
 			path_ptr--;
@@ -844,7 +967,7 @@ static errno_t ext4_extent_append_extent(ext4_inode_ref_t *inode_ref,
 			}
 
 			ext4_extent_header_set_entries_count(path_ptr->header, entries + 1);
-			path_ptr->block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 			/* No more splitting needed */
 			return EOK;
@@ -914,7 +1037,7 @@ static errno_t ext4_extent_append_extent(ext4_inode_ref_t *inode_ref,
 		ext4_extent_header_set_entries_count(old_root->header, entries + 1);
 		ext4_extent_header_set_max_entries_count(old_root->header, limit);
 
-		old_root->block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, old_root->block);
 
 		/* Re-initialize new root metadata */
 		new_root->depth = root_depth + 1;
@@ -930,7 +1053,7 @@ static errno_t ext4_extent_append_extent(ext4_inode_ref_t *inode_ref,
 		ext4_extent_index_set_first_block(new_root->index, 0);
 		ext4_extent_index_set_leaf(new_root->index, new_fblock);
 
-		new_root->block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, new_root->block);
 	} else {
 		if (path->depth) {
 			path->index = EXT4_EXTENT_FIRST_INDEX(path->header) + entries;
@@ -942,7 +1065,7 @@ static errno_t ext4_extent_append_extent(ext4_inode_ref_t *inode_ref,
 		}
 
 		ext4_extent_header_set_entries_count(path->header, entries + 1);
-		path->block->dirty = true;
+		ext4_journal_dirty(inode_ref->fs, path->block);
 	}
 
 	return EOK;
@@ -968,6 +1091,9 @@ errno_t ext4_extent_append_block(ext4_inode_ref_t *inode_ref, uint32_t *iblock,
 	uint64_t inode_size = ext4_inode_get_size(sb, inode_ref->inode);
 	uint32_t block_size = ext4_superblock_get_block_size(sb);
 
+	/* The extent tree is going to change */
+	inode_ref->info->extent_count = 0;
+
 	/* Calculate number of new logical block */
 	uint32_t new_block_idx = 0;
 	if (inode_size > 0) {
@@ -1016,7 +1142,7 @@ errno_t ext4_extent_append_block(ext4_inode_ref_t *inode_ref, uint32_t *iblock,
 				inode_ref->dirty = true;
 			}
 
-			path_ptr->block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 			goto finish;
 		} else {
@@ -1044,7 +1170,7 @@ errno_t ext4_extent_append_block(ext4_inode_ref_t *inode_ref, uint32_t *iblock,
 				inode_ref->dirty = true;
 			}
 
-			path_ptr->block->dirty = true;
+			ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 			goto finish;
 		}
@@ -1080,7 +1206,7 @@ append_extent:
 		inode_ref->dirty = true;
 	}
 
-	path_ptr->block->dirty = true;
+	ext4_journal_dirty(inode_ref->fs, path_ptr->block);
 
 finish:
 	rc2 = EOK;
@@ -53,6 +53,8 @@
 #include "ext4/filesystem.h"
 #include "ext4/ialloc.h"
 #include "ext4/inode.h"
+#include "ext4/inode_info.h"
+#include "ext4/journal.h"
 #include "ext4/ops.h"
 #include "ext4/superblock.h"
 
@@ -103,6 +105,10 @@ static errno_t ext4_filesystem_init(ext4_filesystem_t *fs, service_id_t service_
 	if (rc != EOK)
 		goto err_1;
 
+	rc = ext4_inode_info_init(fs);
+	if (rc != EOK)
+		goto err_2;
+
 	/* Compute limits for indirect block levels */
 	uint32_t block_ids_per_block = block_size / sizeof(uint32_t);
 	fs->inode_block_limits[0] = EXT4_INODE_DIRECT_BLOCK_COUNT;
@@ -119,25 +125,36 @@ static errno_t ext4_filesystem_init(ext4_filesystem_t *fs, service_id_t service_
 
 	uint16_t state = ext4_superblock_get_state(fs->superblock);
 
-	if (((state & EXT4_SUPERBLOCK_STATE_VALID_FS) !=
-	    EXT4_SUPERBLOCK_STATE_VALID_FS) ||
+	/*
+	 * A journaled file system that was not unmounted cleanly is made
+	 * consistent by replaying the journal when it is opened.
+	 */
+	bool recover = ext4_superblock_has_feature_compatible(fs->superblock,
+	    EXT4_FEATURE_COMPAT_HAS_JOURNAL) &&
+	    ext4_superblock_has_feature_incompatible(fs->superblock,
+	    EXT4_FEATURE_INCOMPAT_RECOVER);
+
+	if ((!recover && ((state & EXT4_SUPERBLOCK_STATE_VALID_FS) !=
+	    EXT4_SUPERBLOCK_STATE_VALID_FS)) ||
 	    ((state & EXT4_SUPERBLOCK_STATE_ERROR_FS) ==
 	    EXT4_SUPERBLOCK_STATE_ERROR_FS)) {
 		rc = ENOTSUP;
-		goto err_2;
+		goto err_3;
 	}
 
 	rc = ext4_superblock_check_sanity(fs->superblock);
 	if (rc != EOK)
-		goto err_2;
+		goto err_3;
 
 	/* Check flags */
 	bool read_only;
 	rc = ext4_filesystem_check_features(fs, &read_only);
 	if (rc != EOK)
-		goto err_2;
+		goto err_3;
 
 	return EOK;
+err_3:
+	ext4_inode_info_fini(fs);
 err_2:
 	block_cache_fini(fs->device);
 err_1:
@@ -155,6 +172,9 @@ err:
  */
 static void ext4_filesystem_fini(ext4_filesystem_t *fs)
 {
+	/* Release in-memory i-node state */
+	ext4_inode_info_fini(fs);
+
 	/* Release memory space for superblock */
 	free(fs->superblock);
 
@@ -440,13 +460,28 @@ errno_t ext4_filesystem_open(ext4_instance_t *inst, service_id_t service_id,
 
 	fs_inited = 1;
 
+	/* Replay the journal and start journaling metadata */
+	rc = ext4_journal_init(fs);
+	if (rc != EOK)
+		goto error;
+
 	/* Read root node */
 	rc = ext4_node_get_core(&root_node, inst, EXT4_INODE_ROOT_INDEX);
 	if (rc != EOK)
 		goto error;
 
-	/* Mark system as mounted */
-	ext4_superblock_set_state(fs->superblock, EXT4_SUPERBLOCK_STATE_ERROR_FS);
+	/*
+	 * Mark system as mounted. A journaled file system is only marked
+	 * as not clean, the journal is replayed if it is not closed.
+	 */
+	if (fs->journal != NULL) {
+		uint16_t state = ext4_superblock_get_state(fs->superblock);
+		ext4_superblock_set_state(fs->superblock,
+		    state & ~EXT4_SUPERBLOCK_STATE_VALID_FS);
+	} else {
+		ext4_superblock_set_state(fs->superblock,
+		    EXT4_SUPERBLOCK_STATE_ERROR_FS);
+	}
 	rc = ext4_superblock_write_direct(fs->device, fs->superblock);
 	if (rc != EOK)
 		goto error;
@@ -465,8 +500,10 @@ error:
 	if (root_node != NULL)
 		ext4_node_put(root_node);
 
-	if (fs_inited)
+	if (fs_inited) {
+		(void) ext4_journal_fini(fs);
 		ext4_filesystem_fini(fs);
+	}
 	free(fs);
 	return rc;
 }
@@ -481,9 +518,19 @@ error:
  */
 errno_t ext4_filesystem_close(ext4_filesystem_t *fs)
 {
+	/* Return blocks reserved for i-nodes before free counts are written */
+	errno_t rc = ext4_inode_info_flush(fs);
+	if (rc != EOK)
+		return rc;
+
+	/* Write everything in place, this also clears the recovery flag */
+	rc = ext4_journal_fini(fs);
+	if (rc != EOK)
+		return rc;
+
 	/* Write the superblock to the device */
 	ext4_superblock_set_state(fs->superblock, EXT4_SUPERBLOCK_STATE_VALID_FS);
-	errno_t rc = ext4_superblock_write_direct(fs->device, fs->superblock);
+	rc = ext4_superblock_write_direct(fs->device, fs->superblock);
 	if (rc != EOK)
 		return rc;
 
@@ -689,7 +736,7 @@ static errno_t ext4_filesystem_init_block_groups(ext4_filesystem_t *fs)
 			bg_block0 += ext4_superblock_get_blocks_per_group(sb);
 		}
 
-		block->dirty = true;
+		ext4_journal_dirty(fs, block);
 
 		rc = block_put(block);
 		if (rc != EOK)
@@ -800,7 +847,7 @@ static errno_t ext4_filesystem_init_block_bitmap(ext4_block_group_ref_t *bg_ref)
 		ext4_bitmap_set_bit(bitmap, block);
 	}
 
-	bitmap_block->dirty = true;
+	ext4_journal_dirty(bg_ref->fs, bitmap_block);
 
 	/* Save bitmap */
 	return block_put(bitmap_block);
@@ -843,7 +890,7 @@ static errno_t ext4_filesystem_init_inode_bitmap(ext4_block_group_ref_t *bg_ref)
 	if (i < end_bit)
 		memset(bitmap + (i >> 3), 0xff, (end_bit - i) >> 3);
 
-	bitmap_block->dirty = true;
+	ext4_journal_dirty(bg_ref->fs, bitmap_block);
 
 	/* Save bitmap */
 	return block_put(bitmap_block);
@@ -886,7 +933,7 @@ static errno_t ext4_filesystem_init_inode_table(ext4_block_group_ref_t *bg_ref)
 			return rc;
 
 		memset(block->data, 0, block_size);
-		block->dirty = true;
+		ext4_journal_dirty(bg_ref->fs, block);
 
 		rc = block_put(block);
 		if (rc != EOK)
@@ -1097,7 +1144,7 @@ errno_t ext4_filesystem_put_block_group_ref(ext4_block_group_ref_t *ref)
 		ext4_block_group_set_checksum(ref->block_group, checksum);
 
 		/* Mark block dirty for writing changes to physical device */
-		ref->block->dirty = true;
+		ext4_journal_dirty(ref->fs, ref->block);
 	}
 
 	/* Put back block, that contains block group descriptor */
@@ -1125,6 +1172,13 @@ errno_t ext4_filesystem_get_inode_ref(ext4_filesystem_t *fs, uint32_t index,
 	if (newref == NULL)
 		return ENOMEM;
 
+	/* Get in-memory state shared by all references to this i-node */
+	errno_t rc = ext4_inode_info_get(fs, index, &newref->info);
+	if (rc != EOK) {
+		free(newref);
+		return rc;
+	}
+
 	/* Compute number of i-nodes, that fits in one data block */
 	uint32_t inodes_per_group =
 	    ext4_superblock_get_inodes_per_group(fs->superblock);
@@ -1139,8 +1193,9 @@ errno_t ext4_filesystem_get_inode_ref(ext4_filesystem_t *fs, uint32_t index,
 
 	/* Load block group, where i-node is located */
 	ext4_block_group_ref_t *bg_ref;
-	errno_t rc = ext4_filesystem_get_block_group_ref(fs, block_group, &bg_ref);
+	rc = ext4_filesystem_get_block_group_ref(fs, block_group, &bg_ref);
 	if (rc != EOK) {
+		ext4_inode_info_put(newref->info);
 		free(newref);
 		return rc;
 	}
@@ -1153,6 +1208,7 @@ errno_t ext4_filesystem_get_inode_ref(ext4_filesystem_t *fs, uint32_t index,
 	/* Put back block group reference (not needed more) */
 	rc = ext4_filesystem_put_block_group_ref(bg_ref);
 	if (rc != EOK) {
+		ext4_inode_info_put(newref->info);
 		free(newref);
 		return rc;
 	}
@@ -1166,6 +1222,7 @@ errno_t ext4_filesystem_get_inode_ref(ext4_filesystem_t *fs, uint32_t index,
 	aoff64_t block_id = inode_table_start + (byte_offset_in_group / block_size);
 	rc = block_get(&newref->block, fs->device, block_id, 0);
 	if (rc != EOK) {
+		ext4_inode_info_put(newref->info);
 		free(newref);
 		return rc;
 	}
@@ -1196,11 +1253,12 @@ errno_t ext4_filesystem_put_inode_ref(ext4_inode_ref_t *ref)
 	/* Check if reference modified */
 	if (ref->dirty) {
 		/* Mark block dirty for writing changes to physical device */
-		ref->block->dirty = true;
+		ext4_journal_dirty(ref->fs, ref->block);
 	}
 
 	/* Put back block, that contains i-node */
 	errno_t rc = block_put(ref->block);
+	ext4_inode_info_put(ref->info);
 	free(ref);
 
 	return rc;
@@ -1370,6 +1428,12 @@ errno_t ext4_filesystem_free_inode(ext4_inode_ref_t *inode_ref)
 {
 	ext4_filesystem_t *fs = inode_ref->fs;
 
+	/* Forget in-memory state, the i-node number can be reused */
+	inode_ref->info->extent_count = 0;
+	errno_t rc = ext4_balloc_release_reservation(inode_ref);
+	if (rc != EOK)
+		return rc;
+
 	/* For extents must be data block destroyed by other way */
 	if ((ext4_superblock_has_feature_incompatible(fs->superblock,
 	    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
@@ -1502,7 +1566,6 @@ finish:
 	}
 
 	/* Free inode by allocator */
-	errno_t rc;
 	if (ext4_inode_is_type(fs->superblock, inode_ref->inode,
 	    EXT4_INODE_MODE_DIRECTORY))
 		rc = ext4_ialloc_free_inode(fs, inode_ref->index, true);
@@ -1538,6 +1601,11 @@ errno_t ext4_filesystem_truncate_inode(ext4_inode_ref_t *inode_ref,
 	if (old_size < new_size)
 		return EINVAL;
 
+	/* Blocks reserved behind the old end of file are not needed anymore */
+	errno_t rc = ext4_balloc_release_reservation(inode_ref);
+	if (rc != EOK)
+		return rc;
+
 	/* Compute how many blocks will be released */
 	aoff64_t size_diff = old_size - new_size;
 	uint32_t block_size  = ext4_superblock_get_block_size(sb);
@@ -1553,7 +1621,7 @@ errno_t ext4_filesystem_truncate_inode(ext4_inode_ref_t *inode_ref,
 	    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
 	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS))) {
 		/* Extents require special operation */
-		errno_t rc = ext4_extent_release_blocks_from(inode_ref,
+		rc = ext4_extent_release_blocks_from(inode_ref,
 		    old_blocks_count - diff_blocks_count);
 		if (rc != EOK)
 			return rc;
@@ -1562,7 +1630,7 @@ errno_t ext4_filesystem_truncate_inode(ext4_inode_ref_t *inode_ref,
 
 		/* Starting from 1 because of logical blocks are numbered from 0 */
 		for (uint32_t i = 1; i <= diff_blocks_count; ++i) {
-			errno_t rc = ext4_filesystem_release_inode_block(inode_ref,
+			rc = ext4_filesystem_release_inode_block(inode_ref,
 			    old_blocks_count - i);
 			if (rc != EOK)
 				return rc;
@@ -1689,6 +1757,55 @@ errno_t ext4_filesystem_get_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 	return EOK;
 }
 
+/** Map run of logical blocks of an i-node to physical blocks.
+ *
+ * @param inode_ref I-node to map blocks of
+ * @param iblock    First logical block to map
+ * @param count     Maximal number of blocks to map (at least one)
+ * @param fblock    Output value - first physical block of the run,
+ *                  or 0 if the run is a hole
+ * @param rcount    Output value - number of blocks in the run, the
+ *                  physical blocks (if any) are contiguous
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_filesystem_map_inode_blocks(ext4_inode_ref_t *inode_ref,
+    aoff64_t iblock, uint32_t count, uint32_t *fblock, uint32_t *rcount)
+{
+	ext4_filesystem_t *fs = inode_ref->fs;
+	uint32_t next;
+	errno_t rc;
+
+	/* Handle i-node using extents */
+	if ((ext4_superblock_has_feature_incompatible(fs->superblock,
+	    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
+	    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS)))
+		return ext4_extent_map_blocks(inode_ref, iblock, count, fblock,
+		    rcount);
+
+	/* Block maps have to be looked up block by block */
+	rc = ext4_filesystem_get_inode_data_block_index(inode_ref, iblock,
+	    fblock);
+	if (rc != EOK)
+		return rc;
+
+	*rcount = 1;
+	while (*rcount < count) {
+		rc = ext4_filesystem_get_inode_data_block_index(inode_ref,
+		    iblock + *rcount, &next);
+		if (rc != EOK)
+			return rc;
+
+		if (*fblock == 0 ? next != 0 : next != *fblock + *rcount)
+			break;
+
+		(*rcount)++;
+	}
+
+	return EOK;
+}
+
 /** Set physical block address for the block logical address into the i-node.
  *
  * @param inode_ref I-node to set block address to
@@ -1767,7 +1884,7 @@ errno_t ext4_filesystem_set_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 
 		/* Initialize new block */
 		memset(new_block->data, 0, block_size);
-		new_block->dirty = true;
+		ext4_journal_dirty(fs, new_block);
 
 		/* Put back the allocated block */
 		rc = block_put(new_block);
@@ -1807,7 +1924,7 @@ errno_t ext4_filesystem_set_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 
 			/* Initialize allocated block */
 			memset(new_block->data, 0, block_size);
-			new_block->dirty = true;
+			ext4_journal_dirty(fs, new_block);
 
 			rc = block_put(new_block);
 			if (rc != EOK) {
@@ -1818,7 +1935,7 @@ errno_t ext4_filesystem_set_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 			/* Write block address to the parent */
 			((uint32_t *) block->data)[offset_in_block] =
 			    host2uint32_t_le(new_block_addr);
-			block->dirty = true;
+			ext4_journal_dirty(fs, block);
 			current_block = new_block_addr;
 		}
 
@@ -1826,7 +1943,7 @@ errno_t ext4_filesystem_set_inode_data_block_index(ext4_inode_ref_t *inode_ref,
 		if (level == 1) {
 			((uint32_t *) block->data)[offset_in_block] =
 			    host2uint32_t_le(fblock);
-			block->dirty = true;
+			ext4_journal_dirty(fs, block);
 		}
 
 		rc = block_put(block);
@@ -1927,7 +2044,7 @@ errno_t ext4_filesystem_release_inode_block(ext4_inode_ref_t *inode_ref,
 		if (level == 1) {
 			((uint32_t *) block->data)[offset_in_block] =
 			    host2uint32_t_le(0);
-			block->dirty = true;
+			ext4_journal_dirty(fs, block);
 		}
 
 		rc = block_put(block);
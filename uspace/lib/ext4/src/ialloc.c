@@ -41,6 +41,7 @@
 #include "ext4/block_group.h"
 #include "ext4/filesystem.h"
 #include "ext4/ialloc.h"
+#include "ext4/journal.h"
 #include "ext4/superblock.h"
 
 /** Convert i-node number to relative index in block group.
@@ -119,7 +120,7 @@ errno_t ext4_ialloc_free_inode(ext4_filesystem_t *fs, uint32_t index, bool is_di
 	/* Free i-node in the bitmap */
 	uint32_t index_in_group = ext4_ialloc_inode2index_in_group(sb, index);
 	ext4_bitmap_free_bit(bitmap_block->data, index_in_group);
-	bitmap_block->dirty = true;
+	ext4_journal_dirty(fs, bitmap_block);
 
 	/* Put back the block with bitmap */
 	rc = block_put(bitmap_block);
@@ -252,7 +253,7 @@ retry:
 			}
 
 			/* Free i-node found, save the bitmap */
-			bitmap_block->dirty = true;
+			ext4_journal_dirty(fs, bitmap_block);
 
 			rc = block_put(bitmap_block);
 			if (rc != EOK) {
@@ -367,7 +368,7 @@ errno_t ext4_ialloc_alloc_this_inode(ext4_filesystem_t *fs, uint32_t inode,
 	ext4_bitmap_set_bit(bitmap_block->data, index_in_group);
 
 	/* Save the bitmap */
-	bitmap_block->dirty = true;
+	ext4_journal_dirty(fs, bitmap_block);
 
 	rc = block_put(bitmap_block);
 	if (rc != EOK) {
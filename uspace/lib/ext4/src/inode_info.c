@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libext4
+ * @{
+ */
+/**
+ * @file  inode_info.c
+ * @brief In-memory i-node state.
+ *
+ * Nodes are loaded and released for every file system operation, so
+ * anything worth remembering about an i-node between operations (the
+ * extent status cache and the block reservation) lives here. Entries
+ * are shared by all references to the same i-node and a limited number
+ * of unreferenced entries is kept in LRU order.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <assert.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
+#include "ext4/balloc.h"
+#include "ext4/inode_info.h"
+#include "ext4/types.h"
+
+/** Maximal number of unreferenced entries kept in memory */
+#define EXT4_INODE_INFO_UNUSED_MAX  64
+
+static size_t inode_info_key_hash(const void *key)
+{
+	const uint32_t *index = key;
+	return hash_mix32(*index);
+}
+
+static size_t inode_info_hash(const ht_link_t *item)
+{
+	ext4_inode_info_t *info =
+	    hash_table_get_inst(item, ext4_inode_info_t, link);
+	return hash_mix32(info->index);
+}
+
+static bool inode_info_key_equal(const void *key, const ht_link_t *item)
+{
+	const uint32_t *index = key;
+	ext4_inode_info_t *info =
+	    hash_table_get_inst(item, ext4_inode_info_t, link);
+	return info->index == *index;
+}
+
+static hash_table_ops_t inode_info_ops = {
+	.hash = inode_info_hash,
+	.key_hash = inode_info_key_hash,
+	.key_equal = inode_info_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Destroy unreferenced entry.
+ *
+ * Blocks reserved for the i-node are returned to the block groups.
+ *
+ * @param info Entry to destroy
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_inode_info_destroy(ext4_inode_info_t *info)
+{
+	ext4_filesystem_t *fs = info->fs;
+
+	assert(info->refcnt == 0);
+
+	hash_table_remove_item(&fs->inode_info, &info->link);
+	list_remove(&info->lru_link);
+	fs->inode_info_unused--;
+
+	errno_t rc = ext4_balloc_free_reserved(fs, info->prealloc_start,
+	    info->prealloc_count);
+	free(info);
+
+	return rc;
+}
+
+/** Initialize in-memory i-node state of a filesystem.
+ *
+ * @param fs Filesystem
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_inode_info_init(ext4_filesystem_t *fs)
+{
+	fibril_mutex_initialize(&fs->inode_info_lock);
+	list_initialize(&fs->inode_info_lru);
+	fs->inode_info_unused = 0;
+
+	if (!hash_table_create(&fs->inode_info, 0, 0, &inode_info_ops))
+		return ENOMEM;
+
+	return EOK;
+}
+
+/** Destroy all unreferenced entries.
+ *
+ * Reserved blocks are returned to the block groups, so this must be
+ * done before the superblock is written back.
+ *
+ * @param fs Filesystem
+ *
+ * @return Error code of the first failure
+ *
+ */
+errno_t ext4_inode_info_flush(ext4_filesystem_t *fs)
+{
+	errno_t rc = EOK;
+
+	fibril_mutex_lock(&fs->inode_info_lock);
+
+	while (!list_empty(&fs->inode_info_lru)) {
+		ext4_inode_info_t *info = list_get_instance(
+		    list_first(&fs->inode_info_lru), ext4_inode_info_t,
+		    lru_link);
+
+		errno_t rc2 = ext4_inode_info_destroy(info);
+		if (rc == EOK)
+			rc = rc2;
+	}
+
+	fibril_mutex_unlock(&fs->inode_info_lock);
+
+	return rc;
+}
+
+/** Finalize in-memory i-node state of a filesystem.
+ *
+ * All i-node references must have been put back.
+ *
+ * @param fs Filesystem
+ *
+ */
+void ext4_inode_info_fini(ext4_filesystem_t *fs)
+{
+	(void) ext4_inode_info_flush(fs);
+	hash_table_destroy(&fs->inode_info);
+}
+
+/** Get in-memory state of an i-node.
+ *
+ * @param fs    Filesystem
+ * @param index I-node index
+ * @param rinfo Output pointer to the entry
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_inode_info_get(ext4_filesystem_t *fs, uint32_t index,
+    ext4_inode_info_t **rinfo)
+{
+	ext4_inode_info_t *info;
+
+	fibril_mutex_lock(&fs->inode_info_lock);
+
+	ht_link_t *link = hash_table_find(&fs->inode_info, &index);
+	if (link != NULL) {
+		info = hash_table_get_inst(link, ext4_inode_info_t, link);
+		if (info->refcnt++ == 0) {
+			list_remove(&info->lru_link);
+			fs->inode_info_unused--;
+		}
+
+		fibril_mutex_unlock(&fs->inode_info_lock);
+		*rinfo = info;
+		return EOK;
+	}
+
+	info = calloc(1, sizeof(ext4_inode_info_t));
+	if (info == NULL) {
+		fibril_mutex_unlock(&fs->inode_info_lock);
+		return ENOMEM;
+	}
+
+	link_initialize(&info->lru_link);
+	info->fs = fs;
+	info->index = index;
+	info->refcnt = 1;
+
+	hash_table_insert(&fs->inode_info, &info->link);
+
+	fibril_mutex_unlock(&fs->inode_info_lock);
+	*rinfo = info;
+	return EOK;
+}
+
+/** Put back in-memory state of an i-node.
+ *
+ * The entry is kept in memory. If there are too many unreferenced
+ * entries, the least recently used one is destroyed.
+ *
+ * @param info Entry to put back
+ *
+ */
+void ext4_inode_info_put(ext4_inode_info_t *info)
+{
+	ext4_filesystem_t *fs = info->fs;
+
+	fibril_mutex_lock(&fs->inode_info_lock);
+
+	assert(info->refcnt > 0);
+	if (--info->refcnt == 0) {
+		list_append(&info->lru_link, &fs->inode_info_lru);
+		fs->inode_info_unused++;
+
+		if (fs->inode_info_unused > EXT4_INODE_INFO_UNUSED_MAX) {
+			ext4_inode_info_t *victim = list_get_instance(
+			    list_first(&fs->inode_info_lru), ext4_inode_info_t,
+			    lru_link);
+
+			/* Reserved blocks are lost until fsck on failure */
+			(void) ext4_inode_info_destroy(victim);
+		}
+	}
+
+	fibril_mutex_unlock(&fs->inode_info_lock);
+}
+
+/**
+ * @}
+ */
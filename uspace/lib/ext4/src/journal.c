@@ -0,0 +1,1436 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libext4
+ * @{
+ */
+/**
+ * @file  journal.c
+ * @brief JBD2 compatible metadata journal.
+ *
+ * Metadata blocks are journaled in the JBD2 format used by Linux, so a
+ * journal written here can be replayed by e2fsck and the other way round.
+ * File data are written in place (writeback mode).
+ *
+ * Blocks dirtied by a file system operation join the running transaction.
+ * The journal keeps an extra reference to each of them, which prevents
+ * libblock from writing the block in place before its transaction is
+ * committed. Operations are bracketed by ext4_journal_start() and
+ * ext4_journal_stop() and the transaction is committed once no operation
+ * is in progress and it has grown large enough or the commit interval
+ * has elapsed, so a single commit covers many operations.
+ *
+ * Committed blocks are remembered in the checkpoint set. Checkpointing
+ * writes them in place and empties the log, which happens whenever the
+ * log is getting full and when the journal is finalized. A transaction
+ * that has grown to its maximal size is committed before another
+ * operation may join it.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <assert.h>
+#include <block.h>
+#include <byteorder.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <str_error.h>
+#include "ext4/filesystem.h"
+#include "ext4/inode.h"
+#include "ext4/inode_info.h"
+#include "ext4/journal.h"
+#include "ext4/superblock.h"
+#include "ext4/types.h"
+
+/** Interval after which the running transaction is committed */
+#define EXT4_JOURNAL_COMMIT_INTERVAL  (5 * 1000 * 1000)
+
+/** Maximal number of blocks in a transaction */
+#define EXT4_JOURNAL_MAX_TRANSACTION  1024
+
+/** Block tracked by the journal */
+typedef struct {
+	ht_link_t link;
+	link_t list_link;
+	/** File system block number */
+	uint64_t lba;
+	/** Reference held while the block is in the running transaction */
+	block_t *block;
+	/** Last transaction revoking the block, used by recovery */
+	uint32_t tid;
+	/** Log block with the last committed copy of the block */
+	uint32_t pos;
+	/** Flags of the tag describing the last committed copy */
+	uint16_t flags;
+} ext4_journal_blk_t;
+
+/** Set of blocks tracked by the journal */
+typedef struct {
+	hash_table_t table;
+	list_t list;
+	size_t count;
+} ext4_journal_set_t;
+
+struct ext4_journal {
+	ext4_filesystem_t *fs;
+	uint32_t block_size;
+	/** Device blocks per file system block */
+	uint32_t ratio;
+	/** File system block of each journal block */
+	uint32_t *map;
+	/** Copy of the journal superblock */
+	ext4_journal_superblock_t *jsb;
+
+	/** First and one past the last log block */
+	uint32_t first;
+	uint32_t last;
+	/** Next log block to be written */
+	uint32_t head;
+	/** Oldest log block in use, 0 if the log is empty */
+	uint32_t tail;
+	/** Size of a block tag in descriptor blocks */
+	size_t tag_size;
+	/** Size of a block number in revoke blocks */
+	size_t revoke_size;
+	/** Number of blocks in a transaction that triggers a commit */
+	size_t max_transaction;
+
+	fibril_mutex_t lock;
+	fibril_timer_t *timer;
+	/** Identifier of the running transaction */
+	uint32_t tid;
+	/** Number of operations in progress */
+	unsigned handles;
+	/** Signalled when the last operation in progress finishes */
+	fibril_condvar_t idle;
+	/** Commit when the last operation in progress finishes */
+	bool commit_pending;
+	/** Metadata are written in place after an I/O error */
+	bool aborted;
+
+	/** Blocks of the running transaction */
+	ext4_journal_set_t running;
+	/** Blocks revoked by the running transaction */
+	ext4_journal_set_t revoked;
+	/** Committed blocks not yet written in place */
+	ext4_journal_set_t checkpoint;
+};
+
+/** Number of operations in progress in the current fibril */
+static fibril_local unsigned ext4_journal_nesting;
+
+/** Recovery passes, see ext4_journal_scan() */
+typedef enum {
+	EXT4_JOURNAL_PASS_SCAN,
+	EXT4_JOURNAL_PASS_REVOKE,
+	EXT4_JOURNAL_PASS_REPLAY
+} ext4_journal_pass_t;
+
+static size_t journal_blk_key_hash(const void *key)
+{
+	const uint64_t *lba = key;
+	return hash_mix64(*lba);
+}
+
+static size_t journal_blk_hash(const ht_link_t *item)
+{
+	ext4_journal_blk_t *blk =
+	    hash_table_get_inst(item, ext4_journal_blk_t, link);
+	return hash_mix64(blk->lba);
+}
+
+static bool journal_blk_key_equal(const void *key, const ht_link_t *item)
+{
+	const uint64_t *lba = key;
+	ext4_journal_blk_t *blk =
+	    hash_table_get_inst(item, ext4_journal_blk_t, link);
+	return blk->lba == *lba;
+}
+
+static hash_table_ops_t journal_blk_ops = {
+	.hash = journal_blk_hash,
+	.key_hash = journal_blk_key_hash,
+	.key_equal = journal_blk_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+static bool ext4_journal_set_init(ext4_journal_set_t *set)
+{
+	list_initialize(&set->list);
+	set->count = 0;
+	return hash_table_create(&set->table, 0, 0, &journal_blk_ops);
+}
+
+static ext4_journal_blk_t *ext4_journal_set_find(ext4_journal_set_t *set,
+    uint64_t lba)
+{
+	ht_link_t *link = hash_table_find(&set->table, &lba);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, ext4_journal_blk_t, link);
+}
+
+static errno_t ext4_journal_set_add(ext4_journal_set_t *set, uint64_t lba,
+    block_t *block)
+{
+	ext4_journal_blk_t *blk = malloc(sizeof(ext4_journal_blk_t));
+	if (blk == NULL)
+		return ENOMEM;
+
+	blk->lba = lba;
+	blk->block = block;
+	blk->tid = 0;
+	blk->pos = 0;
+	blk->flags = 0;
+	hash_table_insert(&set->table, &blk->link);
+	list_append(&blk->list_link, &set->list);
+	set->count++;
+	return EOK;
+}
+
+static void ext4_journal_set_remove(ext4_journal_set_t *set,
+    ext4_journal_blk_t *blk)
+{
+	hash_table_remove_item(&set->table, &blk->link);
+	list_remove(&blk->list_link);
+	set->count--;
+	free(blk);
+}
+
+/** Remove all blocks from a set, dropping the references held by them. */
+static void ext4_journal_set_clear(ext4_journal_set_t *set)
+{
+	while (!list_empty(&set->list)) {
+		ext4_journal_blk_t *blk = list_get_instance(
+		    list_first(&set->list), ext4_journal_blk_t, list_link);
+		if (blk->block != NULL)
+			block_put(blk->block);
+		ext4_journal_set_remove(set, blk);
+	}
+}
+
+static void ext4_journal_set_fini(ext4_journal_set_t *set)
+{
+	ext4_journal_set_clear(set);
+	hash_table_destroy(&set->table);
+}
+
+/** Get the log block following a log block. */
+static uint32_t ext4_journal_next(ext4_journal_t *journal, uint32_t pos)
+{
+	return pos + 1 < journal->last ? pos + 1 : journal->first;
+}
+
+/** Check whether the running transaction has reached its maximal size. */
+static bool ext4_journal_full(ext4_journal_t *journal)
+{
+	return journal->running.count + journal->revoked.count >=
+	    journal->max_transaction;
+}
+
+/** Get the number of log blocks available for new transactions. */
+static uint32_t ext4_journal_free_space(ext4_journal_t *journal)
+{
+	uint32_t size = journal->last - journal->first;
+	if (journal->tail == 0)
+		return size - 1;
+
+	uint32_t used = (journal->head + size - journal->tail) % size;
+	return size - used - 1;
+}
+
+/** Read or write consecutive log blocks.
+ *
+ * Physically contiguous parts of the journal file are transferred
+ * with a single request.
+ *
+ * @param journal Journal
+ * @param pos     First log block
+ * @param count   Number of log blocks
+ * @param buf     Buffer of count blocks
+ * @param write   Whether to write the blocks
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_io(ext4_journal_t *journal, uint32_t pos,
+    uint32_t count, void *buf, bool write)
+{
+	service_id_t dev = journal->fs->device;
+	uint8_t *data = buf;
+	errno_t rc;
+
+	while (count > 0) {
+		uint32_t run = 1;
+		while (run < count && pos + run < journal->last &&
+		    journal->map[pos + run] == journal->map[pos] + run)
+			run++;
+
+		aoff64_t ba = (aoff64_t) journal->map[pos] * journal->ratio;
+		size_t cnt = run * journal->ratio;
+		if (write)
+			rc = block_write_direct(dev, ba, cnt, data);
+		else
+			rc = block_read_direct(dev, ba, cnt, data);
+		if (rc != EOK)
+			return rc;
+
+		data += run * journal->block_size;
+		count -= run;
+		pos += run;
+		if (pos >= journal->last)
+			pos = journal->first;
+	}
+
+	return EOK;
+}
+
+/** Write the journal superblock.
+ *
+ * @param journal  Journal
+ * @param start    First log block in use, 0 if the log is empty
+ * @param sequence Identifier of the first transaction in the log
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_write_super(ext4_journal_t *journal,
+    uint32_t start, uint32_t sequence)
+{
+	journal->jsb->start = host2uint32_t_be(start);
+	journal->jsb->sequence = host2uint32_t_be(sequence);
+
+	return block_write_direct(journal->fs->device,
+	    (aoff64_t) journal->map[0] * journal->ratio, journal->ratio,
+	    journal->jsb);
+}
+
+/** Fill in the header of a journal block. */
+static void ext4_journal_set_header(void *buf, uint32_t type, uint32_t tid)
+{
+	ext4_journal_header_t *header = buf;
+
+	header->magic = host2uint32_t_be(EXT4_JOURNAL_MAGIC);
+	header->block_type = host2uint32_t_be(type);
+	header->sequence = host2uint32_t_be(tid);
+}
+
+/** Check whether a journal block has a valid header.
+ *
+ * @param buf  Journal block
+ * @param tid  Expected transaction identifier
+ * @param type Output value - type of the block
+ *
+ * @return True if the block belongs to the transaction
+ *
+ */
+static bool ext4_journal_check_header(void *buf, uint32_t tid, uint32_t *type)
+{
+	ext4_journal_header_t *header = buf;
+
+	if (uint32_t_be2host(header->magic) != EXT4_JOURNAL_MAGIC ||
+	    uint32_t_be2host(header->sequence) != tid)
+		return false;
+
+	*type = uint32_t_be2host(header->block_type);
+	return true;
+}
+
+/** Read the committed copy of a block from the log.
+ *
+ * @param journal Journal
+ * @param pos     Log block with the copy
+ * @param flags   Flags of the block tag
+ * @param buf     Buffer for one block
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_read_copy(ext4_journal_t *journal, uint32_t pos,
+    uint16_t flags, void *buf)
+{
+	errno_t rc = ext4_journal_io(journal, pos, 1, buf, false);
+	if (rc != EOK)
+		return rc;
+
+	if (flags & EXT4_JOURNAL_FLAG_ESCAPE) {
+		uint32_t magic = host2uint32_t_be(EXT4_JOURNAL_MAGIC);
+		memcpy(buf, &magic, sizeof(magic));
+	}
+
+	return EOK;
+}
+
+/** Write all checkpointed blocks in place and empty the log.
+ *
+ * Cached copies of blocks that joined the running transaction may
+ * contain changes that are not committed yet, such blocks are written
+ * from their committed copies in the log instead.
+ *
+ * @param journal Journal, locked
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_checkpoint(ext4_journal_t *journal)
+{
+	ext4_filesystem_t *fs = journal->fs;
+	uint8_t *buf = NULL;
+	errno_t rc;
+
+	list_foreach(journal->checkpoint.list, list_link, ext4_journal_blk_t,
+	    blk) {
+		if (ext4_journal_set_find(&journal->running, blk->lba) !=
+		    NULL) {
+			if (buf == NULL) {
+				buf = malloc(journal->block_size);
+				if (buf == NULL)
+					return ENOMEM;
+			}
+
+			rc = ext4_journal_read_copy(journal, blk->pos,
+			    blk->flags, buf);
+			if (rc == EOK) {
+				rc = block_write_direct(fs->device,
+				    blk->lba * journal->ratio, journal->ratio,
+				    buf);
+			}
+			if (rc != EOK) {
+				free(buf);
+				return rc;
+			}
+			continue;
+		}
+
+		block_t *block;
+		rc = block_get(&block, fs->device, blk->lba, BLOCK_FLAGS_NONE);
+		if (rc != EOK)
+			return rc;
+
+		if (block->dirty) {
+			rc = block_write_direct(fs->device, block->pba,
+			    journal->ratio, block->data);
+			if (rc == EOK)
+				block->dirty = false;
+		}
+
+		errno_t rc2 = block_put(block);
+		if (rc == EOK)
+			rc = rc2;
+		if (rc != EOK) {
+			free(buf);
+			return rc;
+		}
+	}
+
+	free(buf);
+
+	if (journal->tail != 0) {
+		rc = block_sync_cache(fs->device, 0, 0);
+		if (rc != EOK)
+			return rc;
+
+		rc = ext4_journal_write_super(journal, 0, journal->tid);
+		if (rc != EOK)
+			return rc;
+
+		rc = block_sync_cache(fs->device, 0, 0);
+		if (rc != EOK)
+			return rc;
+	}
+
+	ext4_journal_set_clear(&journal->checkpoint);
+	journal->head = journal->first;
+	journal->tail = 0;
+	return EOK;
+}
+
+/** Stop journaling after an I/O error.
+ *
+ * Blocks of the running transaction are left to be written in place
+ * and committed blocks are written in place right away, so that an
+ * outdated log cannot be replayed over them later.
+ *
+ * @param journal Journal, locked
+ * @param rc      Error that caused the abort
+ *
+ */
+static void ext4_journal_abort(ext4_journal_t *journal, errno_t rc)
+{
+	printf("libext4: journal aborted: %s\n", str_error(rc));
+
+	journal->aborted = true;
+	ext4_journal_set_clear(&journal->running);
+	ext4_journal_set_clear(&journal->revoked);
+	(void) ext4_journal_checkpoint(journal);
+}
+
+/** Put one block of the running transaction into a descriptor buffer.
+ *
+ * @param journal Journal
+ * @param desc    Descriptor block
+ * @param offset  In/out - offset of the next tag in the descriptor
+ * @param data    Buffer for the logged copy of the block
+ * @param blk     Block to log
+ * @param last    Whether this is the last tag in the descriptor
+ *
+ */
+static void ext4_journal_add_tag(ext4_journal_t *journal, uint8_t *desc,
+    size_t *offset, uint8_t *data, ext4_journal_blk_t *blk, bool last)
+{
+	ext4_journal_block_tag_t tag;
+	uint16_t flags = 0;
+
+	memcpy(data, blk->block->data, journal->block_size);
+
+	/* Blocks looking like journal blocks must not confuse recovery */
+	uint32_t magic;
+	memcpy(&magic, data, sizeof(magic));
+	if (uint32_t_be2host(magic) == EXT4_JOURNAL_MAGIC) {
+		memset(data, 0, sizeof(uint32_t));
+		flags |= EXT4_JOURNAL_FLAG_ESCAPE;
+	}
+
+	/* Only the first tag is followed by the journal UUID */
+	if (*offset != sizeof(ext4_journal_header_t))
+		flags |= EXT4_JOURNAL_FLAG_SAME_UUID;
+	if (last)
+		flags |= EXT4_JOURNAL_FLAG_LAST_TAG;
+
+	tag.block_nr = host2uint32_t_be((uint32_t) blk->lba);
+	tag.checksum = 0;
+	tag.flags = host2uint16_t_be(flags);
+	tag.block_nr_high = host2uint32_t_be((uint32_t) (blk->lba >> 32));
+	memcpy(desc + *offset, &tag, journal->tag_size);
+	*offset += journal->tag_size;
+
+	if ((flags & EXT4_JOURNAL_FLAG_SAME_UUID) == 0) {
+		memcpy(desc + *offset, journal->jsb->uuid, 16);
+		*offset += 16;
+	}
+
+	blk->flags = flags;
+}
+
+/** Write the running transaction to the log.
+ *
+ * @param journal Journal, locked, with no operation in progress
+ * @param buf     Buffer for a descriptor block followed by the blocks it
+ *                describes, or for a revoke block
+ * @param per_desc Number of blocks described by one descriptor block
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_write_transaction(ext4_journal_t *journal,
+    uint8_t *buf, size_t per_desc)
+{
+	size_t bs = journal->block_size;
+	errno_t rc;
+
+	link_t *link = list_first(&journal->running.list);
+	while (link != NULL) {
+		memset(buf, 0, bs);
+		ext4_journal_set_header(buf, EXT4_JOURNAL_DESCRIPTOR_BLOCK,
+		    journal->tid);
+
+		size_t offset = sizeof(ext4_journal_header_t);
+		uint32_t pos = journal->head;
+		uint32_t n = 0;
+		while (link != NULL && n < per_desc) {
+			ext4_journal_blk_t *blk = list_get_instance(link,
+			    ext4_journal_blk_t, list_link);
+			link = list_next(link, &journal->running.list);
+			n++;
+
+			pos = ext4_journal_next(journal, pos);
+			blk->pos = pos;
+
+			ext4_journal_add_tag(journal, buf, &offset,
+			    buf + n * bs, blk, link == NULL || n == per_desc);
+		}
+
+		rc = ext4_journal_io(journal, journal->head, n + 1, buf, true);
+		if (rc != EOK)
+			return rc;
+
+		for (uint32_t i = 0; i < n + 1; i++) {
+			journal->head = ext4_journal_next(journal,
+			    journal->head);
+		}
+	}
+
+	link = list_first(&journal->revoked.list);
+	while (link != NULL) {
+		memset(buf, 0, bs);
+		ext4_journal_set_header(buf, EXT4_JOURNAL_REVOKE_BLOCK,
+		    journal->tid);
+
+		size_t offset = sizeof(ext4_journal_revoke_header_t);
+		while (link != NULL && offset + journal->revoke_size <= bs) {
+			ext4_journal_blk_t *blk = list_get_instance(link,
+			    ext4_journal_blk_t, list_link);
+			link = list_next(link, &journal->revoked.list);
+
+			if (journal->revoke_size == sizeof(uint64_t)) {
+				uint64_t nr = host2uint64_t_be(blk->lba);
+				memcpy(buf + offset, &nr, sizeof(nr));
+			} else {
+				uint32_t nr = host2uint32_t_be(blk->lba);
+				memcpy(buf + offset, &nr, sizeof(nr));
+			}
+			offset += journal->revoke_size;
+		}
+
+		ext4_journal_revoke_header_t *header =
+		    (ext4_journal_revoke_header_t *) buf;
+		header->count = host2uint32_t_be(offset);
+
+		rc = ext4_journal_io(journal, journal->head, 1, buf, true);
+		if (rc != EOK)
+			return rc;
+
+		journal->head = ext4_journal_next(journal, journal->head);
+	}
+
+	return EOK;
+}
+
+/** Commit the running transaction.
+ *
+ * @param journal Journal, locked, with no operation in progress
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_commit(ext4_journal_t *journal)
+{
+	ext4_filesystem_t *fs = journal->fs;
+	size_t bs = journal->block_size;
+	errno_t rc;
+
+	assert(journal->handles == 0);
+	journal->commit_pending = false;
+
+	if (journal->aborted ||
+	    (journal->running.count == 0 && journal->revoked.count == 0))
+		return EOK;
+
+	/* The first tag of a descriptor is followed by the UUID */
+	size_t per_desc = (bs - sizeof(ext4_journal_header_t) - 16) /
+	    journal->tag_size;
+	size_t per_revoke = (bs - sizeof(ext4_journal_revoke_header_t)) /
+	    journal->revoke_size;
+	size_t needed = journal->running.count +
+	    (journal->running.count + per_desc - 1) / per_desc +
+	    (journal->revoked.count + per_revoke - 1) / per_revoke + 1;
+
+	/* Reclaim the log taken by transactions committed before */
+	if (needed > ext4_journal_free_space(journal)) {
+		rc = ext4_journal_checkpoint(journal);
+		if (rc != EOK)
+			goto error;
+	}
+
+	if (needed > ext4_journal_free_space(journal)) {
+		rc = ENOSPC;
+		goto error;
+	}
+
+	uint8_t *buf = malloc((per_desc + 1) * bs);
+	if (buf == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	uint32_t start = journal->head;
+	rc = ext4_journal_write_transaction(journal, buf, per_desc);
+	if (rc != EOK) {
+		free(buf);
+		goto error;
+	}
+
+	/* Point the journal superblock to the log if it was empty */
+	if (journal->tail == 0) {
+		rc = ext4_journal_write_super(journal, start, journal->tid);
+		if (rc != EOK) {
+			free(buf);
+			goto error;
+		}
+	}
+
+	/* The commit block must not reach the disk before the rest */
+	rc = block_sync_cache(fs->device, 0, 0);
+	if (rc != EOK) {
+		free(buf);
+		goto error;
+	}
+
+	memset(buf, 0, bs);
+	ext4_journal_set_header(buf, EXT4_JOURNAL_COMMIT_BLOCK, journal->tid);
+	rc = ext4_journal_io(journal, journal->head, 1, buf, true);
+	free(buf);
+	if (rc != EOK)
+		goto error;
+
+	rc = block_sync_cache(fs->device, 0, 0);
+	if (rc != EOK)
+		goto error;
+
+	if (journal->tail == 0)
+		journal->tail = start;
+	journal->head = ext4_journal_next(journal, journal->head);
+	journal->tid++;
+
+	/* Committed blocks may be written in place from now on */
+	while (!list_empty(&journal->running.list)) {
+		ext4_journal_blk_t *blk = list_get_instance(
+		    list_first(&journal->running.list), ext4_journal_blk_t,
+		    list_link);
+
+		ext4_journal_blk_t *cp = ext4_journal_set_find(
+		    &journal->checkpoint, blk->lba);
+		if (cp == NULL) {
+			rc = ext4_journal_set_add(&journal->checkpoint,
+			    blk->lba, NULL);
+			if (rc != EOK)
+				goto error;
+			cp = ext4_journal_set_find(&journal->checkpoint,
+			    blk->lba);
+		}
+		cp->pos = blk->pos;
+		cp->flags = blk->flags;
+
+		block_put(blk->block);
+		blk->block = NULL;
+		ext4_journal_set_remove(&journal->running, blk);
+	}
+
+	ext4_journal_set_clear(&journal->revoked);
+
+	/* Make sure the next transaction fits into the log */
+	if (ext4_journal_free_space(journal) < 2 * journal->max_transaction) {
+		rc = ext4_journal_checkpoint(journal);
+		if (rc != EOK)
+			goto error;
+	}
+
+	return EOK;
+error:
+	ext4_journal_abort(journal, rc);
+	return rc;
+}
+
+/** Commit the running transaction periodically. */
+static void ext4_journal_timer(void *arg)
+{
+	ext4_journal_t *journal = arg;
+
+	fibril_mutex_lock(&journal->lock);
+
+	if (journal->handles == 0)
+		(void) ext4_journal_commit(journal);
+	else
+		journal->commit_pending = true;
+
+	fibril_timer_set_locked(journal->timer, EXT4_JOURNAL_COMMIT_INTERVAL,
+	    ext4_journal_timer, journal);
+	fibril_mutex_unlock(&journal->lock);
+}
+
+/** Copy a logged block to its place unless it has been revoked.
+ *
+ * @param journal Journal
+ * @param pos     Log block with the copy
+ * @param tid     Transaction the copy belongs to
+ * @param lba     File system block
+ * @param flags   Flags of the block tag
+ * @param buf     Buffer for one block
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_replay_block(ext4_journal_t *journal,
+    uint32_t pos, uint32_t tid, uint64_t lba, uint16_t flags, void *buf)
+{
+	ext4_filesystem_t *fs = journal->fs;
+	block_t *block;
+	errno_t rc;
+
+	ext4_journal_blk_t *rev = ext4_journal_set_find(&journal->revoked,
+	    lba);
+	if (rev != NULL && (int32_t) (rev->tid - tid) >= 0)
+		return EOK;
+
+	rc = ext4_journal_read_copy(journal, pos, flags, buf);
+	if (rc != EOK)
+		return rc;
+
+	/* Go through the cache, later transactions may log the block again */
+	rc = block_get(&block, fs->device, lba, BLOCK_FLAGS_NOREAD);
+	if (rc != EOK)
+		return rc;
+
+	memcpy(block->data, buf, journal->block_size);
+	block->dirty = true;
+	rc = block_put(block);
+	if (rc != EOK)
+		return rc;
+
+	if (ext4_journal_set_find(&journal->checkpoint, lba) != NULL)
+		return EOK;
+
+	return ext4_journal_set_add(&journal->checkpoint, lba, NULL);
+}
+
+/** Walk the committed transactions in the log.
+ *
+ * Recovery walks the log three times. The first pass finds the end of
+ * the log, the second collects revoke records and the third copies the
+ * blocks that were not revoked to their place.
+ *
+ * @param journal Journal
+ * @param pass    Recovery pass
+ * @param end     In/out - one past the last committed transaction, set by
+ *                the scan pass
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_scan(ext4_journal_t *journal,
+    ext4_journal_pass_t pass, uint32_t *end)
+{
+	size_t bs = journal->block_size;
+	uint32_t pos = uint32_t_be2host(journal->jsb->start);
+	uint32_t tid = uint32_t_be2host(journal->jsb->sequence);
+	uint32_t type;
+	errno_t rc;
+
+	uint8_t *buf = malloc(2 * bs);
+	if (buf == NULL)
+		return ENOMEM;
+
+	uint8_t *data = buf + bs;
+
+	while (pass == EXT4_JOURNAL_PASS_SCAN || tid != *end) {
+		if (pos < journal->first || pos >= journal->last) {
+			rc = EINVAL;
+			goto out;
+		}
+
+		rc = ext4_journal_io(journal, pos, 1, buf, false);
+		if (rc != EOK)
+			goto out;
+
+		if (!ext4_journal_check_header(buf, tid, &type)) {
+			if (pass != EXT4_JOURNAL_PASS_SCAN) {
+				rc = EINVAL;
+				goto out;
+			}
+			break;
+		}
+
+		pos = ext4_journal_next(journal, pos);
+
+		if (type == EXT4_JOURNAL_COMMIT_BLOCK) {
+			tid++;
+			continue;
+		}
+
+		if (type == EXT4_JOURNAL_REVOKE_BLOCK) {
+			if (pass != EXT4_JOURNAL_PASS_REVOKE)
+				continue;
+
+			ext4_journal_revoke_header_t *header =
+			    (ext4_journal_revoke_header_t *) buf;
+			size_t count = uint32_t_be2host(header->count);
+			if (count > bs)
+				count = bs;
+
+			for (size_t offset = sizeof(*header);
+			    offset + journal->revoke_size <= count;
+			    offset += journal->revoke_size) {
+				uint64_t lba;
+				if (journal->revoke_size == sizeof(uint64_t)) {
+					uint64_t nr;
+					memcpy(&nr, buf + offset, sizeof(nr));
+					lba = uint64_t_be2host(nr);
+				} else {
+					uint32_t nr;
+					memcpy(&nr, buf + offset, sizeof(nr));
+					lba = uint32_t_be2host(nr);
+				}
+
+				/*
+				 * Revokes are collected in transaction order,
+				 * so a block is revoked up to the last
+				 * transaction that revoked it.
+				 */
+				ext4_journal_blk_t *blk = ext4_journal_set_find(
+				    &journal->revoked, lba);
+				if (blk == NULL) {
+					rc = ext4_journal_set_add(
+					    &journal->revoked, lba, NULL);
+					if (rc != EOK)
+						goto out;
+					blk = ext4_journal_set_find(
+					    &journal->revoked, lba);
+				}
+				blk->tid = tid;
+			}
+			continue;
+		}
+
+		if (type != EXT4_JOURNAL_DESCRIPTOR_BLOCK)
+			continue;
+
+		size_t offset = sizeof(ext4_journal_header_t);
+		while (offset + journal->tag_size <= bs) {
+			ext4_journal_block_tag_t tag;
+			memcpy(&tag, buf + offset, journal->tag_size);
+			offset += journal->tag_size;
+
+			uint16_t flags = uint16_t_be2host(tag.flags);
+			if ((flags & EXT4_JOURNAL_FLAG_SAME_UUID) == 0)
+				offset += 16;
+
+			uint64_t lba = uint32_t_be2host(tag.block_nr);
+			if (journal->tag_size > 8)
+				lba |= (uint64_t) uint32_t_be2host(
+				    tag.block_nr_high) << 32;
+
+			if (pass == EXT4_JOURNAL_PASS_REPLAY) {
+				rc = ext4_journal_replay_block(journal, pos,
+				    tid, lba, flags, data);
+				if (rc != EOK)
+					goto out;
+			}
+
+			pos = ext4_journal_next(journal, pos);
+
+			if (flags & EXT4_JOURNAL_FLAG_LAST_TAG)
+				break;
+		}
+	}
+
+	if (pass == EXT4_JOURNAL_PASS_SCAN)
+		*end = tid;
+	rc = EOK;
+out:
+	free(buf);
+	return rc;
+}
+
+/** Replay committed transactions left in the log.
+ *
+ * @param journal Journal
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_journal_recover(ext4_journal_t *journal)
+{
+	ext4_filesystem_t *fs = journal->fs;
+	uint32_t end;
+	errno_t rc;
+
+	rc = ext4_journal_scan(journal, EXT4_JOURNAL_PASS_SCAN, &end);
+	if (rc != EOK)
+		return rc;
+
+	rc = ext4_journal_scan(journal, EXT4_JOURNAL_PASS_REVOKE, &end);
+	if (rc == EOK)
+		rc = ext4_journal_scan(journal, EXT4_JOURNAL_PASS_REPLAY, &end);
+
+	ext4_journal_set_clear(&journal->revoked);
+
+	if (rc != EOK)
+		return rc;
+
+	/* Write replayed blocks in place and empty the log */
+	journal->tid = end;
+	journal->tail = uint32_t_be2host(journal->jsb->start);
+	rc = ext4_journal_checkpoint(journal);
+	if (rc != EOK)
+		return rc;
+
+	/* The superblock may have been replayed */
+	ext4_superblock_t *superblock;
+	rc = ext4_superblock_read_direct(fs->device, &superblock);
+	if (rc != EOK)
+		return rc;
+
+	ext4_superblock_release(fs->superblock);
+	fs->superblock = superblock;
+
+	/* Forget what was read from the replayed blocks */
+	return ext4_inode_info_flush(fs);
+}
+
+/** Map the journal i-node and read the journal superblock.
+ *
+ * @param journal Journal
+ * @param index   Journal i-node index
+ *
+ * @return Error code, ENOTSUP if the journal cannot be used
+ *
+ */
+static errno_t ext4_journal_load(ext4_journal_t *journal, uint32_t index)
+{
+	ext4_filesystem_t *fs = journal->fs;
+	ext4_inode_ref_t *inode_ref;
+	errno_t rc;
+
+	rc = ext4_filesystem_get_inode_ref(fs, index, &inode_ref);
+	if (rc != EOK)
+		return rc;
+
+	uint64_t size = ext4_inode_get_size(fs->superblock, inode_ref->inode);
+	uint64_t blocks = size / journal->block_size;
+	if (blocks < 2 || blocks > UINT32_MAX) {
+		rc = ENOTSUP;
+		goto out;
+	}
+
+	journal->map = malloc(blocks * sizeof(uint32_t));
+	if (journal->map == NULL) {
+		rc = ENOMEM;
+		goto out;
+	}
+
+	uint32_t iblock = 0;
+	while (iblock < blocks) {
+		uint32_t fblock;
+		uint32_t count;
+		rc = ext4_filesystem_map_inode_blocks(inode_ref, iblock,
+		    blocks - iblock, &fblock, &count);
+		if (rc != EOK)
+			goto out;
+
+		/* Holes in the journal are not allowed */
+		if (fblock == 0) {
+			rc = ENOTSUP;
+			goto out;
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+			journal->map[iblock + i] = fblock + i;
+		iblock += count;
+	}
+
+	journal->jsb = malloc(journal->block_size);
+	if (journal->jsb == NULL) {
+		rc = ENOMEM;
+		goto out;
+	}
+
+	journal->last = blocks;
+	rc = ext4_journal_io(journal, 0, 1, journal->jsb, false);
+	if (rc != EOK)
+		goto out;
+
+	ext4_journal_superblock_t *jsb = journal->jsb;
+	uint32_t type = uint32_t_be2host(jsb->header.block_type);
+	if (uint32_t_be2host(jsb->header.magic) != EXT4_JOURNAL_MAGIC ||
+	    (type != EXT4_JOURNAL_SUPERBLOCK_V1 &&
+	    type != EXT4_JOURNAL_SUPERBLOCK_V2) ||
+	    uint32_t_be2host(jsb->block_size) != journal->block_size) {
+		rc = ENOTSUP;
+		goto out;
+	}
+
+	uint32_t incompat = 0;
+	if (type == EXT4_JOURNAL_SUPERBLOCK_V2) {
+		incompat = uint32_t_be2host(jsb->feature_incompat);
+		if ((incompat & ~EXT4_JOURNAL_FEATURE_INCOMPAT_SUPP) != 0 ||
+		    uint32_t_be2host(jsb->nr_users) > 1) {
+			rc = ENOTSUP;
+			goto out;
+		}
+	}
+
+	journal->first = uint32_t_be2host(jsb->first);
+	if (uint32_t_be2host(jsb->max_len) < journal->last)
+		journal->last = uint32_t_be2host(jsb->max_len);
+	if (journal->first == 0 || journal->first + 8 > journal->last) {
+		rc = ENOTSUP;
+		goto out;
+	}
+
+	if (incompat & EXT4_JOURNAL_FEATURE_INCOMPAT_64BIT) {
+		journal->tag_size = sizeof(ext4_journal_block_tag_t);
+		journal->revoke_size = sizeof(uint64_t);
+	} else {
+		journal->tag_size = sizeof(ext4_journal_block_tag_t) -
+		    sizeof(uint32_t);
+		journal->revoke_size = sizeof(uint32_t);
+	}
+
+	journal->max_transaction = (journal->last - journal->first) / 4;
+	if (journal->max_transaction > EXT4_JOURNAL_MAX_TRANSACTION)
+		journal->max_transaction = EXT4_JOURNAL_MAX_TRANSACTION;
+
+	journal->head = journal->first;
+	journal->tail = 0;
+	journal->tid = uint32_t_be2host(jsb->sequence);
+	rc = EOK;
+out:
+	ext4_filesystem_put_inode_ref(inode_ref);
+	return rc;
+}
+
+static void ext4_journal_destroy(ext4_journal_t *journal)
+{
+	if (journal->timer != NULL)
+		fibril_timer_destroy(journal->timer);
+	ext4_journal_set_fini(&journal->running);
+	ext4_journal_set_fini(&journal->revoked);
+	ext4_journal_set_fini(&journal->checkpoint);
+	free(journal->jsb);
+	free(journal->map);
+	free(journal);
+}
+
+/** Start journaling metadata of a file system.
+ *
+ * Transactions left in the journal are replayed. File systems without
+ * an internal journal, or with a journal this driver cannot write, are
+ * used without journaling unless they need recovery.
+ *
+ * @param fs File system
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_journal_init(ext4_filesystem_t *fs)
+{
+	ext4_superblock_t *sb = fs->superblock;
+	bool recover = ext4_superblock_has_feature_incompatible(sb,
+	    EXT4_FEATURE_INCOMPAT_RECOVER);
+	uint32_t index = ext4_superblock_get_journal_inode_number(sb);
+	size_t dev_bsize;
+	errno_t rc;
+
+	fs->journal = NULL;
+
+	if (!ext4_superblock_has_feature_compatible(sb,
+	    EXT4_FEATURE_COMPAT_HAS_JOURNAL) || index == 0 ||
+	    ext4_superblock_get_journal_dev(sb) != 0)
+		return recover ? ENOTSUP : EOK;
+
+	rc = block_get_bsize(fs->device, &dev_bsize);
+	if (rc != EOK)
+		return rc;
+
+	ext4_journal_t *journal = calloc(1, sizeof(ext4_journal_t));
+	if (journal == NULL)
+		return ENOMEM;
+
+	journal->fs = fs;
+	journal->block_size = ext4_superblock_get_block_size(sb);
+	journal->ratio = journal->block_size / dev_bsize;
+	fibril_mutex_initialize(&journal->lock);
+	fibril_condvar_initialize(&journal->idle);
+
+	if (!ext4_journal_set_init(&journal->running) ||
+	    !ext4_journal_set_init(&journal->revoked) ||
+	    !ext4_journal_set_init(&journal->checkpoint)) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	journal->timer = fibril_timer_create(&journal->lock);
+	if (journal->timer == NULL) {
+		rc = ENOMEM;
+		goto error;
+	}
+
+	rc = ext4_journal_load(journal, index);
+	if (rc == ENOTSUP && !recover) {
+		ext4_journal_destroy(journal);
+		return EOK;
+	}
+	if (rc != EOK)
+		goto error;
+
+	if (journal->jsb->start != 0) {
+		rc = ext4_journal_recover(journal);
+		if (rc != EOK)
+			goto error;
+	}
+
+	/* Let other implementations know the journal is in use */
+	uint32_t incompat = ext4_superblock_get_features_incompatible(
+	    fs->superblock);
+	ext4_superblock_set_features_incompatible(fs->superblock,
+	    incompat | EXT4_FEATURE_INCOMPAT_RECOVER);
+
+	fs->journal = journal;
+	fibril_timer_set(journal->timer, EXT4_JOURNAL_COMMIT_INTERVAL,
+	    ext4_journal_timer, journal);
+	return EOK;
+error:
+	ext4_journal_destroy(journal);
+	return rc;
+}
+
+/** Stop journaling.
+ *
+ * Everything is committed and written in place, leaving the log empty.
+ *
+ * @param fs File system
+ *
+ * @return Error code. On error the journal stays in use.
+ *
+ */
+errno_t ext4_journal_fini(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+	errno_t rc;
+
+	if (journal == NULL)
+		return EOK;
+
+	fibril_mutex_lock(&journal->lock);
+	assert(journal->handles == 0);
+
+	rc = ext4_journal_commit(journal);
+	if (rc == EOK)
+		rc = ext4_journal_checkpoint(journal);
+	if (rc != EOK) {
+		fibril_mutex_unlock(&journal->lock);
+		return rc;
+	}
+
+	fibril_timer_clear_locked(journal->timer);
+	fibril_mutex_unlock(&journal->lock);
+
+	uint32_t incompat = ext4_superblock_get_features_incompatible(
+	    fs->superblock);
+	ext4_superblock_set_features_incompatible(fs->superblock,
+	    incompat & ~EXT4_FEATURE_INCOMPAT_RECOVER);
+
+	ext4_journal_destroy(journal);
+	fs->journal = NULL;
+	return EOK;
+}
+
+/** Start a file system operation.
+ *
+ * Blocks dirtied until the matching ext4_journal_stop() are committed
+ * together. Operations may nest. If the running transaction has reached
+ * its maximal size, the operation waits until it is committed.
+ *
+ * @param fs File system
+ *
+ */
+void ext4_journal_start(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+
+	if (journal == NULL)
+		return;
+
+	fibril_mutex_lock(&journal->lock);
+
+	/* A nested operation must not wait for the one it is part of */
+	if (ext4_journal_nesting == 0) {
+		while (!journal->aborted && journal->handles > 0 &&
+		    ext4_journal_full(journal))
+			fibril_condvar_wait(&journal->idle, &journal->lock);
+
+		if (journal->handles == 0 && ext4_journal_full(journal))
+			(void) ext4_journal_commit(journal);
+	}
+
+	journal->handles++;
+	ext4_journal_nesting++;
+	fibril_mutex_unlock(&journal->lock);
+}
+
+/** Finish a file system operation.
+ *
+ * Commits the running transaction if it is due and no other operation
+ * is in progress. Commit errors abort the journal rather than fail the
+ * operation, whose changes are then written in place.
+ *
+ * @param fs File system
+ *
+ */
+void ext4_journal_stop(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+
+	if (journal == NULL)
+		return;
+
+	fibril_mutex_lock(&journal->lock);
+	assert(journal->handles > 0);
+	assert(ext4_journal_nesting > 0);
+
+	ext4_journal_nesting--;
+	if (--journal->handles == 0) {
+		if (journal->commit_pending || ext4_journal_full(journal))
+			(void) ext4_journal_commit(journal);
+
+		fibril_condvar_broadcast(&journal->idle);
+	}
+
+	fibril_mutex_unlock(&journal->lock);
+}
+
+/** Commit the running transaction.
+ *
+ * @param fs File system
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_journal_sync(ext4_filesystem_t *fs)
+{
+	ext4_journal_t *journal = fs->journal;
+	errno_t rc = EOK;
+
+	if (journal == NULL)
+		return EOK;
+
+	fibril_mutex_lock(&journal->lock);
+	if (journal->handles == 0)
+		rc = ext4_journal_commit(journal);
+	else
+		journal->commit_pending = true;
+	fibril_mutex_unlock(&journal->lock);
+
+	return rc;
+}
+
+/** Mark a metadata block dirty.
+ *
+ * The block joins the running transaction and is not written in place
+ * until the transaction is committed.
+ *
+ * @param fs    File system
+ * @param block Block to mark dirty, referenced by the caller
+ *
+ */
+void ext4_journal_dirty(ext4_filesystem_t *fs, block_t *block)
+{
+	ext4_journal_t *journal = fs->journal;
+	block_t *ref;
+	errno_t rc;
+
+	block->dirty = true;
+
+	if (journal == NULL)
+		return;
+
+	fibril_mutex_lock(&journal->lock);
+
+	if (journal->aborted ||
+	    ext4_journal_set_find(&journal->running, block->lba) != NULL) {
+		fibril_mutex_unlock(&journal->lock);
+		return;
+	}
+
+	/* The block is in use again, a revoke would hide it from recovery */
+	ext4_journal_blk_t *rev = ext4_journal_set_find(&journal->revoked,
+	    block->lba);
+	if (rev != NULL)
+		ext4_journal_set_remove(&journal->revoked, rev);
+
+	/* Take a reference to the cached block to keep it in memory */
+	rc = block_get(&ref, fs->device, block->lba, BLOCK_FLAGS_NOREAD);
+	if (rc == EOK) {
+		assert(ref == block);
+		rc = ext4_journal_set_add(&journal->running, block->lba, ref);
+		if (rc != EOK)
+			block_put(ref);
+	}
+
+	if (rc != EOK)
+		ext4_journal_abort(journal, rc);
+
+	fibril_mutex_unlock(&journal->lock);
+}
+
+/** Forget blocks being freed.
+ *
+ * Freed blocks leave the running transaction. Blocks logged by committed
+ * transactions are revoked, so that recovery does not overwrite whatever
+ * the blocks are used for next.
+ *
+ * @param fs    File system
+ * @param lba   First block being freed
+ * @param count Number of blocks
+ *
+ */
+void ext4_journal_revoke(ext4_filesystem_t *fs, uint64_t lba, uint32_t count)
+{
+	ext4_journal_t *journal = fs->journal;
+	errno_t rc = EOK;
+
+	if (journal == NULL)
+		return;
+
+	fibril_mutex_lock(&journal->lock);
+
+	for (uint64_t b = lba; b < lba + count && !journal->aborted; b++) {
+		if (journal->running.count == 0 &&
+		    journal->checkpoint.count == 0)
+			break;
+
+		ext4_journal_blk_t *blk = ext4_journal_set_find(
+		    &journal->running, b);
+		if (blk != NULL) {
+			block_put(blk->block);
+			ext4_journal_set_remove(&journal->running, blk);
+		}
+
+		if (ext4_journal_set_find(&journal->checkpoint, b) != NULL &&
+		    ext4_journal_set_find(&journal->revoked, b) == NULL) {
+			rc = ext4_journal_set_add(&journal->revoked, b, NULL);
+			if (rc != EOK)
+				ext4_journal_abort(journal, rc);
+		}
+	}
+
+	fibril_mutex_unlock(&journal->lock);
+}
+
+/**
+ * @}
+ */
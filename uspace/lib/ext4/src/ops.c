@@ -37,6 +37,7 @@
 
 #include <adt/hash_table.h>
 #include <adt/hash.h>
+#include <align.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <libfs.h>
@@ -50,11 +51,15 @@
 #include "ext4/directory_index.h"
 #include "ext4/extent.h"
 #include "ext4/inode.h"
+#include "ext4/journal.h"
 #include "ext4/ops.h"
 #include "ext4/filesystem.h"
 #include "ext4/fstypes.h"
 #include "ext4/superblock.h"
 
+/** Maximal number of bytes returned by one read of a file */
+#define EXT4_READ_MAX_BYTES  (64 * 1024)
+
 /* Forward declarations of auxiliary functions */
 
 static errno_t ext4_read_directory(ipc_call_t *, aoff64_t, size_t,
@@ -402,7 +407,11 @@ errno_t ext4_node_put(fs_node_t *fn)
 	assert(enode->references > 0);
 	enode->references--;
 	if (enode->references == 0) {
+		/* Writing the i-node back is a transaction of its own */
+		ext4_filesystem_t *fs = enode->instance->filesystem;
+		ext4_journal_start(fs);
 		errno_t rc = ext4_node_put_core(enode);
+		ext4_journal_stop(fs);
 		if (rc != EOK) {
 			fibril_mutex_unlock(&open_nodes_lock);
 			return rc;
@@ -450,7 +459,9 @@ errno_t ext4_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
 
 	/* Allocate new i-node in filesystem */
 	ext4_inode_ref_t *inode_ref;
+	ext4_journal_start(inst->filesystem);
 	rc = ext4_filesystem_alloc_inode(inst->filesystem, &inode_ref, flags);
+	ext4_journal_stop(inst->filesystem);
 	if (rc != EOK) {
 		free(enode);
 		free(fs_node);
@@ -477,14 +488,14 @@ errno_t ext4_create_node(fs_node_t **rfn, service_id_t service_id, int flags)
 	return EOK;
 }
 
-/** Destroy existing node.
+/** Destroy existing node (without journal handle).
  *
  * @param fs Node to destroy
  *
  * @return Error code
  *
  */
-errno_t ext4_destroy_node(fs_node_t *fn)
+static errno_t ext4_destroy_node_core(fs_node_t *fn)
 {
 	/* If directory, check for children */
 	bool has_children;
@@ -526,7 +537,25 @@ errno_t ext4_destroy_node(fs_node_t *fn)
 	return ext4_node_put(fn);
 }
 
-/** Link the specfied node to directory.
+/** Destroy existing node.
+ *
+ * @param fs Node to destroy
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_destroy_node(fs_node_t *fn)
+{
+	ext4_filesystem_t *fs = EXT4_NODE(fn)->instance->filesystem;
+
+	ext4_journal_start(fs);
+	errno_t rc = ext4_destroy_node_core(fn);
+	ext4_journal_stop(fs);
+
+	return rc;
+}
+
+/** Link the specfied node to directory (without journal handle).
  *
  * @param pfn  Parent node to link in
  * @param cfn  Node to be linked
@@ -535,7 +564,8 @@ errno_t ext4_destroy_node(fs_node_t *fn)
  * @return Error code
  *
  */
-errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+static errno_t ext4_link_core(fs_node_t *pfn, fs_node_t *cfn,
+    const char *name)
 {
 	/* Check maximum name length */
 	if (str_size(name) > EXT4_DIRECTORY_FILENAME_LEN)
@@ -599,7 +629,27 @@ errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
 	return EOK;
 }
 
-/** Unlink node from specified directory.
+/** Link the specfied node to directory.
+ *
+ * @param pfn  Parent node to link in
+ * @param cfn  Node to be linked
+ * @param name Name which will be assigned to directory entry
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+{
+	ext4_filesystem_t *fs = EXT4_NODE(pfn)->instance->filesystem;
+
+	ext4_journal_start(fs);
+	errno_t rc = ext4_link_core(pfn, cfn, name);
+	ext4_journal_stop(fs);
+
+	return rc;
+}
+
+/** Unlink node from specified directory (without journal handle).
  *
  * @param pfn  Parent node to delete node from
  * @param cfn  Child node to be unlinked from directory
@@ -608,7 +658,8 @@ errno_t ext4_link(fs_node_t *pfn, fs_node_t *cfn, const char *name)
  * @return Error code
  *
  */
-errno_t ext4_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+static errno_t ext4_unlink_core(fs_node_t *pfn, fs_node_t *cfn,
+    const char *name)
 {
 	bool has_children;
 	errno_t rc = ext4_has_children(&has_children, cfn);
@@ -671,6 +722,26 @@ errno_t ext4_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
 	return EOK;
 }
 
+/** Unlink node from specified directory.
+ *
+ * @param pfn  Parent node to delete node from
+ * @param cfn  Child node to be unlinked from directory
+ * @param name Name of entry that will be removed
+ *
+ * @return Error code
+ *
+ */
+errno_t ext4_unlink(fs_node_t *pfn, fs_node_t *cfn, const char *name)
+{
+	ext4_filesystem_t *fs = EXT4_NODE(pfn)->instance->filesystem;
+
+	ext4_journal_start(fs);
+	errno_t rc = ext4_unlink_core(pfn, cfn, name);
+	ext4_journal_stop(fs);
+
+	return rc;
+}
+
 /** Check if specified node has children.
  *
  * For files is response allways false and check is executed only for directories.
@@ -1192,6 +1263,67 @@ errno_t ext4_read_directory(ipc_call_t *call, aoff64_t pos, size_t size,
  * @return Error code
  *
  */
+/** Read run of physically contiguous blocks of a file.
+ *
+ * @param call   IPC call
+ * @param fblock First physical block of the run
+ * @param offset Offset in the first block
+ * @param bytes  Number of bytes to read
+ * @param inst   Filesystem instance
+ * @param rbytes Output value - number of bytes read
+ *
+ * @return Error code
+ *
+ */
+static errno_t ext4_read_file_run(ipc_call_t *call, uint32_t fblock,
+    uint32_t offset, size_t bytes, ext4_instance_t *inst, size_t *rbytes)
+{
+	uint32_t block_size =
+	    ext4_superblock_get_block_size(inst->filesystem->superblock);
+	size_t done = 0;
+	errno_t rc;
+
+	uint8_t *buffer = malloc(bytes);
+	if (buffer == NULL) {
+		async_answer_0(call, ENOMEM);
+		return ENOMEM;
+	}
+
+	while (done < bytes) {
+		size_t chunk = min(bytes - done, (size_t) block_size - offset);
+		block_t *block;
+
+		rc = block_get(&block, inst->service_id, fblock,
+		    BLOCK_FLAGS_NONE);
+		if (rc != EOK) {
+			free(buffer);
+			async_answer_0(call, rc);
+			return rc;
+		}
+
+		memcpy(buffer + done, block->data + offset, chunk);
+
+		rc = block_put(block);
+		if (rc != EOK) {
+			free(buffer);
+			async_answer_0(call, rc);
+			return rc;
+		}
+
+		done += chunk;
+		offset = 0;
+		fblock++;
+	}
+
+	rc = async_data_read_finalize(call, buffer, bytes);
+	free(buffer);
+	if (rc != EOK)
+		return rc;
+
+	*rbytes = bytes;
+	return EOK;
+}
+
 errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
     ext4_instance_t *inst, ext4_inode_ref_t *inode_ref, size_t *rbytes)
 {
@@ -1205,30 +1337,38 @@ errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
 		return EOK;
 	}
 
-	/* For now, we only read data from one block at a time */
 	uint32_t block_size = ext4_superblock_get_block_size(sb);
 	aoff64_t file_block = pos / block_size;
 	uint32_t offset_in_block = pos % block_size;
-	uint32_t bytes = min(block_size - offset_in_block, size);
 
-	/* Handle end of file */
-	if (pos + bytes > file_size)
-		bytes = file_size - pos;
+	/* Handle end of file and limit size of the transfer */
+	if (size > file_size - pos)
+		size = file_size - pos;
+	if (size > EXT4_READ_MAX_BYTES)
+		size = EXT4_READ_MAX_BYTES;
 
-	/* Get the real block number */
+	/*
+	 * Map as many blocks of the request as are physically contiguous
+	 * (or as form a hole) at once.
+	 */
+	uint32_t nblocks = ROUND_UP(offset_in_block + size, block_size) /
+	    block_size;
 	uint32_t fs_block;
-	errno_t rc = ext4_filesystem_get_inode_data_block_index(inode_ref,
-	    file_block, &fs_block);
+	uint32_t run;
+	errno_t rc = ext4_filesystem_map_inode_blocks(inode_ref, file_block,
+	    nblocks, &fs_block, &run);
 	if (rc != EOK) {
 		async_answer_0(call, rc);
 		return rc;
 	}
 
+	size_t bytes = min(size, (size_t) run * block_size - offset_in_block);
+
 	/*
 	 * Check for sparse file.
-	 * If ext4_filesystem_get_inode_data_block_index returned
-	 * fs_block == 0, it means that the given block is not allocated for the
-	 * file and we need to return a buffer of zeros
+	 * If ext4_filesystem_map_inode_blocks returned fs_block == 0,
+	 * it means that the blocks are not allocated for the file and
+	 * we need to return a buffer of zeros
 	 */
 	uint8_t *buffer;
 	if (fs_block == 0) {
@@ -1247,6 +1387,11 @@ errno_t ext4_read_file(ipc_call_t *call, aoff64_t pos, size_t size,
 		return rc;
 	}
 
+	/* Contiguous blocks are gathered and sent in one transfer */
+	if (offset_in_block + bytes > block_size)
+		return ext4_read_file_run(call, fs_block, offset_in_block, bytes,
+		    inst, rbytes);
+
 	/* Usual case - we need to read a block from device */
 	block_t *block;
 	rc = block_get(&block, inst->service_id, fs_block, BLOCK_FLAGS_NONE);
@@ -1290,6 +1435,10 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 	if (rc != EOK)
 		return rc;
 
+	ext4_node_t *enode = EXT4_NODE(fn);
+	ext4_filesystem_t *fs = enode->instance->filesystem;
+	ext4_journal_start(fs);
+
 	ipc_call_t call;
 	size_t len;
 	if (!async_data_write_receive(&call, &len)) {
@@ -1298,9 +1447,6 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 		goto exit;
 	}
 
-	ext4_node_t *enode = EXT4_NODE(fn);
-	ext4_filesystem_t *fs = enode->instance->filesystem;
-
 	uint32_t block_size = ext4_superblock_get_block_size(fs->superblock);
 
 	/* Prevent writing to more than one block */
@@ -1324,6 +1470,24 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 
 	/* Check for sparse file */
 	if (fblock == 0) {
+		/*
+		 * Reserve contiguous blocks for the rest of this write request
+		 * (and the hole before it) so that it is not allocated block
+		 * by block and the file grows by a single extent.
+		 */
+		uint32_t size_blocks = ROUND_UP(ext4_inode_get_size(fs->superblock,
+		    inode_ref->inode), block_size) / block_size;
+		uint32_t req_blocks = ROUND_UP((pos % block_size) + len,
+		    block_size) / block_size;
+		if (iblock >= size_blocks) {
+			rc = ext4_balloc_reserve(inode_ref,
+			    iblock - size_blocks + req_blocks);
+			if (rc != EOK) {
+				async_answer_0(&call, rc);
+				goto exit;
+			}
+		}
+
 		if ((ext4_superblock_has_feature_incompatible(fs->superblock,
 		    EXT4_FEATURE_INCOMPAT_EXTENTS)) &&
 		    (ext4_inode_has_flag(inode_ref->inode, EXT4_INODE_FLAG_EXTENTS))) {
@@ -1403,6 +1567,7 @@ static errno_t ext4_write(service_id_t service_id, fs_index_t index, aoff64_t po
 
 exit:
 	rc2 = ext4_node_put(fn);
+	ext4_journal_stop(fs);
 	return rc == EOK ? rc2 : rc;
 }
 
@@ -1427,9 +1592,12 @@ static errno_t ext4_truncate(service_id_t service_id, fs_index_t index,
 
 	ext4_node_t *enode = EXT4_NODE(fn);
 	ext4_inode_ref_t *inode_ref = enode->inode_ref;
+	ext4_filesystem_t *fs = enode->instance->filesystem;
 
+	ext4_journal_start(fs);
 	rc = ext4_filesystem_truncate_inode(inode_ref, new_size);
 	errno_t const rc2 = ext4_node_put(fn);
+	ext4_journal_stop(fs);
 
 	return rc == EOK ? rc2 : rc;
 }
@@ -1480,9 +1648,15 @@ static errno_t ext4_sync(service_id_t service_id, fs_index_t index)
 		return rc;
 
 	ext4_node_t *enode = EXT4_NODE(fn);
+	ext4_filesystem_t *fs = enode->instance->filesystem;
 	enode->inode_ref->dirty = true;
 
-	return ext4_node_put(fn);
+	rc = ext4_node_put(fn);
+	if (rc != EOK)
+		return rc;
+
+	/* Commit the i-node together with everything before it */
+	return ext4_journal_sync(fs);
 }
 
 /** VFS operations
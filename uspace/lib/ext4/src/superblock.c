@@ -960,6 +960,30 @@ void ext4_superblock_set_last_mounted(ext4_superblock_t *sb, const char *last)
 	memcpy(sb->last_mounted, last, sizeof(sb->last_mounted));
 }
 
+/** Get index of the i-node holding the journal.
+ *
+ * @param sb Superblock
+ *
+ * @return Journal i-node index, 0 if there is no internal journal
+ *
+ */
+uint32_t ext4_superblock_get_journal_inode_number(ext4_superblock_t *sb)
+{
+	return uint32_t_le2host(sb->journal_inode_number);
+}
+
+/** Get device number of an external journal.
+ *
+ * @param sb Superblock
+ *
+ * @return Journal device number, 0 if the journal is internal
+ *
+ */
+uint32_t ext4_superblock_get_journal_dev(ext4_superblock_t *sb)
+{
+	return uint32_t_le2host(sb->journal_dev);
+}
+
 /** Get last orphaned i-node index.
  *
  * Orphans are stored in linked list.
@@ -199,10 +199,18 @@ errno_t ieee80211_prf(uint8_t *key, uint8_t *data, uint8_t *hash,
 	memcpy(work_arr, a, str_size(a));
 	memcpy(work_arr + str_size(a) + 1, data, PRF_CRYPT_DATA_LENGTH);
 
+	/* The key pads are hashed only once for all iterations. */
+	hmac_ctx_t ctx;
+	errno_t rc = hmac_init(&ctx, key, PBKDF2_KEY_LENGTH, HASH_SHA1);
+	if (rc != EOK)
+		return rc;
+
 	for (uint8_t i = 0; i < iters; i++) {
+		const uint8_t *msg = work_arr;
+		uint8_t *out = temp;
+
 		memcpy(work_arr + data_size - 1, &i, 1);
-		hmac(key, PBKDF2_KEY_LENGTH, work_arr, data_size, temp,
-		    HASH_SHA1);
+		hmac_batch(&ctx, &msg, data_size, &out, 1);
 		memcpy(result + i * HASH_SHA1, temp, HASH_SHA1);
 	}
 
@@ -226,6 +234,11 @@ errno_t ieee80211_aes_key_unwrap(uint8_t *kek, uint8_t *data, size_t data_size,
 	if (!output)
 		return ENOMEM;
 
+	aes_key_t key;
+	errno_t rc = aes_key_init(&key, kek, AES_CIPHER_LENGTH);
+	if (rc != EOK)
+		return rc;
+
 	uint32_t n = data_size / 8 - 1;
 	uint8_t work_data[n * 8];
 	uint8_t work_input[AES_CIPHER_LENGTH];
@@ -250,7 +263,7 @@ errno_t ieee80211_aes_key_unwrap(uint8_t *kek, uint8_t *data, size_t data_size,
 			work_block = work_data + (i - 1) * 8;
 			memcpy(work_input, a, 8);
 			memcpy(work_input + 8, work_block, 8);
-			aes_decrypt(kek, work_input, work_output);
+			aes_decrypt_block(&key, work_input, work_output);
 			memcpy(a, work_output, 8);
 			memcpy(work_data + (i - 1) * 8, work_output + 8, 8);
 		}
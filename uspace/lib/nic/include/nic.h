@@ -68,6 +68,8 @@ typedef struct {
 	link_t link;
 	void *data;
 	size_t size;
+	/** Offload flags (NIC_FF_xxx), set by the driver for received frames */
+	uint32_t flags;
 } nic_frame_t;
 
 typedef list_t nic_frame_list_t;
@@ -84,6 +86,30 @@ typedef list_t nic_frame_list_t;
  */
 typedef void (*send_frame_handler)(nic_t *, void *, size_t);
 
+/**
+ * Handler for writing frame data with offload requests to the NIC device.
+ * Only requests for offloads implemented by the hardware and currently
+ * active are passed, everything else is done by NICF in software before.
+ * Segmentation offload is always emulated by NICF.
+ *
+ * @param nic_data
+ * @param data		Pointer to frame data
+ * @param size		Size of frame data in bytes
+ * @param flags		Offload requests (NIC_FF_xxx)
+ */
+typedef void (*send_frame_offload_handler)(nic_t *, void *, size_t, uint32_t);
+
+/**
+ * Handler for change of the active offload computations.
+ *
+ * @param nic_data	NICF main structure
+ * @param active	Hardware offloads (NIC_OFFLOAD_xxx) that should be active
+ *
+ * @return EOK		If the offloads were set up
+ * @return ENOTSUP	If this combination of offloads is not supported
+ */
+typedef errno_t (*offload_change_handler)(nic_t *, uint32_t);
+
 /**
  * The handler for transitions between driver states.
  * If the handler returns error code, the transition between
@@ -228,6 +254,9 @@ extern void nic_set_wol_virtue_change_handlers(nic_t *,
     wol_virtue_add_handler, wol_virtue_remove_handler);
 extern void nic_set_poll_handlers(nic_t *,
     poll_mode_change_handler, poll_request_handler);
+extern void nic_set_adaptive_poll_rates(nic_t *, unsigned, unsigned);
+extern void nic_set_offload_handlers(nic_t *, uint32_t,
+    offload_change_handler, send_frame_offload_handler);
 
 /* General driver functions */
 extern ddf_dev_t *nic_get_ddf_dev(nic_t *);
@@ -244,6 +273,9 @@ extern void nic_query_address(nic_t *, nic_address_t *);
 extern void nic_received_frame(nic_t *, nic_frame_t *);
 extern void nic_received_frame_list(nic_t *, nic_frame_list_t *);
 extern nic_poll_mode_t nic_query_poll_mode(nic_t *, struct timespec *);
+extern uint32_t nic_query_offload(nic_t *);
+extern errno_t nic_offload_csum_location(const void *, size_t, size_t *,
+    size_t *);
 
 /* Statistics updates */
 extern void nic_report_send_ok(nic_t *, size_t, size_t);
@@ -277,6 +309,10 @@ extern uint64_t nic_query_mcast_hash(nic_t *);
 extern void nic_sw_period_start(nic_t *);
 extern void nic_sw_period_stop(nic_t *);
 
+/* Adaptive polling functions */
+extern errno_t nic_adaptive_poll_start(nic_t *, const struct timespec *);
+extern void nic_adaptive_poll_stop(nic_t *);
+
 #endif // __NIC_H__
 
 /** @}
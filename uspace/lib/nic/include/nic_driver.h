@@ -56,6 +56,41 @@ struct sw_poll_info {
 	volatile int running;
 };
 
+/** Length of the window in which the receive rate is sampled */
+#define NIC_ADAPTIVE_WINDOW_USEC	10000
+
+/** Default rate (frames per second) above which the NIC is polled */
+#define NIC_ADAPTIVE_DEFAULT_HIGH_RATE	10000
+/** Default rate (frames per second) below which interrupts are restored */
+#define NIC_ADAPTIVE_DEFAULT_LOW_RATE	2000
+/** Default polling period used in the adaptive mode */
+#define NIC_ADAPTIVE_DEFAULT_PERIOD_USEC	250
+
+struct adaptive_poll_info {
+	/** Worker fibril switching the poll modes */
+	fid_t fibril;
+	/** Adaptive mode is selected */
+	volatile bool enabled;
+	/** The NIC is currently polled instead of issuing interrupts */
+	volatile bool polling;
+	/** Polling is performed by the software period fibril */
+	bool sw_period;
+	/** Switch to polling above this many frames per second */
+	unsigned high_rate;
+	/** Switch back to interrupts below this many frames per second */
+	unsigned low_rate;
+	/** Start of the current sampling window (protected by stats_lock) */
+	struct timespec window_start;
+	/** Frames received in the current sampling window (stats_lock) */
+	unsigned window_frames;
+	/** Request to switch to polling is pending */
+	bool pending;
+	/** Lock protecting the pending flag */
+	fibril_mutex_t lock;
+	/** Signalled when a switch to polling is requested */
+	fibril_condvar_t cv;
+};
+
 struct nic {
 	/**
 	 * Device from device manager's point of view.
@@ -89,6 +124,12 @@ struct nic {
 	struct timespec default_poll_period;
 	/** Software period fibrill information */
 	struct sw_poll_info sw_poll_info;
+	/** Adaptive polling information */
+	struct adaptive_poll_info adaptive_poll;
+	/** Offload computations implemented by the hardware */
+	uint32_t offload_hw;
+	/** Currently active offload computations */
+	volatile uint32_t offload_active;
 	/**
 	 * Lock on everything but statistics, rx control and wol virtues. This lock
 	 * cannot be used if filters_lock or stats_lock is already held - you must
@@ -126,6 +167,18 @@ struct nic {
 	 * Called with the main_lock locked for reading.
 	 */
 	send_frame_handler send_frame;
+	/**
+	 * Function sending the data with offload requests. The implementation
+	 * is optional, without it all offloads are done in software.
+	 * Called with the main_lock locked for reading.
+	 */
+	send_frame_offload_handler send_frame_offload;
+	/**
+	 * Event handler called when the active offloads are changed.
+	 * The implementation is optional.
+	 * Called with the main_lock locked for writing.
+	 */
+	offload_change_handler on_offload_change;
 	/**
 	 * Event handler called when device goes to the ACTIVE state.
 	 * The implementation is optional.
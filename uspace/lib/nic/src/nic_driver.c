@@ -55,6 +55,9 @@
 
 nic_globals_t nic_globals;
 
+static bool nic_adaptive_poll_account(nic_t *);
+static void nic_adaptive_poll_request(nic_t *);
+
 /**
  * Initializes libraries required for NIC framework - logger
  *
@@ -101,6 +104,12 @@ void nic_driver_implement(driver_ops_t *driver_ops, ddf_dev_ops_t *dev_ops,
 			iface->set_state = nic_set_state_impl;
 		if (!iface->send_frame)
 			iface->send_frame = nic_send_frame_impl;
+		if (!iface->send_frame_offload)
+			iface->send_frame_offload = nic_send_frame_offload_impl;
+		if (!iface->offload_probe)
+			iface->offload_probe = nic_offload_probe_impl;
+		if (!iface->offload_set)
+			iface->offload_set = nic_offload_set_impl;
 		if (!iface->callback_create)
 			iface->callback_create = nic_callback_create_impl;
 		if (!iface->get_address)
@@ -232,6 +241,41 @@ void nic_set_poll_handlers(nic_t *nic_data,
 	nic_data->on_poll_request = on_poll_req;
 }
 
+/**
+ * Setup thresholds of the adaptive polling mode.
+ * This function can be called only in the add_device handler.
+ *
+ * @param high_rate	Receive rate (frames per second) above which the NIC
+ * 			is switched to polling
+ * @param low_rate	Receive rate (frames per second) below which the NIC
+ * 			is switched back to interrupts
+ */
+void nic_set_adaptive_poll_rates(nic_t *nic_data, unsigned high_rate,
+    unsigned low_rate)
+{
+	assert(low_rate <= high_rate);
+	nic_data->adaptive_poll.high_rate = high_rate;
+	nic_data->adaptive_poll.low_rate = low_rate;
+}
+
+/**
+ * Setup offload handlers.
+ * This function can be called only in the add_device handler.
+ *
+ * @param hw_offload		Offloads (NIC_OFFLOAD_xxx) implemented by the
+ * 				hardware
+ * @param on_offload_change	Called when the active offloads are changed
+ * @param sffunc		Function sending frames with offload requests
+ */
+void nic_set_offload_handlers(nic_t *nic_data, uint32_t hw_offload,
+    offload_change_handler on_offload_change,
+    send_frame_offload_handler sffunc)
+{
+	nic_data->offload_hw = hw_offload;
+	nic_data->on_offload_change = on_offload_change;
+	nic_data->send_frame_offload = sffunc;
+}
+
 /**
  * Connect to the parent's driver and get HW resources list in parsed format.
  * Note: this function should be called only from add_device handler, therefore
@@ -287,6 +331,7 @@ nic_frame_t *nic_alloc_frame(nic_t *nic_data, size_t size)
 	}
 
 	frame->size = size;
+	frame->flags = 0;
 	return frame;
 }
 
@@ -379,6 +424,10 @@ void nic_frame_list_append(nic_frame_list_t *frames,
  *	The main lock should be locked, otherwise the inconsistency between
  *	mode and period can occure.
  *
+ *	In the NIC_POLL_ADAPTIVE mode the mode the driver was last switched to
+ *	is returned, i.e. NIC_POLL_IMMEDIATE, NIC_POLL_PERIODIC or
+ *	NIC_POLL_ON_DEMAND (when the software period fibril polls the NIC).
+ *
  *  @param nic_data The controller data
  *  @param period [out] The the period. Valid only if mode == NIC_POLL_PERIODIC
  *  @return Current polling mode of the controller
@@ -387,14 +436,40 @@ nic_poll_mode_t nic_query_poll_mode(nic_t *nic_data, struct timespec *period)
 {
 	if (period)
 		*period = nic_data->poll_period;
+
+	if (nic_data->poll_mode == NIC_POLL_ADAPTIVE) {
+		if (!nic_data->adaptive_poll.polling)
+			return NIC_POLL_IMMEDIATE;
+		if (nic_data->adaptive_poll.sw_period)
+			return NIC_POLL_ON_DEMAND;
+		return NIC_POLL_PERIODIC;
+	}
+
 	return nic_data->poll_mode;
 }
 
+/** Query the active offload computations
+ *
+ *  Drivers use this to decide whether to report checksum verification
+ *  results of received frames.
+ *
+ *  @param nic_data The controller data
+ *  @return Active offloads (NIC_OFFLOAD_xxx)
+ */
+uint32_t nic_query_offload(nic_t *nic_data)
+{
+	return nic_data->offload_active;
+}
+
 /** Inform the NICF about poll mode
+ *
+ *  With NIC_POLL_ADAPTIVE the device must be issuing interrupts as in
+ *  NIC_POLL_IMMEDIATE, the period is used while the NIC is being polled.
  *
  *  @param nic_data The controller data
  *  @param mode
  *  @param period [out] The the period. Valid only if mode == NIC_POLL_PERIODIC
+ *                or mode == NIC_POLL_ADAPTIVE
  *  @return EOK
  *  @return EINVAL
  */
@@ -412,6 +487,12 @@ errno_t nic_report_poll_mode(nic_t *nic_data, nic_poll_mode_t mode,
 		} else {
 			rc = EINVAL;
 		}
+	} else if (mode == NIC_POLL_ADAPTIVE) {
+		rc = nic_adaptive_poll_start(nic_data, period);
+		if (rc == EOK) {
+			memcpy(&nic_data->default_poll_period, &nic_data->poll_period,
+			    sizeof(struct timespec));
+		}
 	}
 	fibril_rwlock_write_unlock(&nic_data->main_lock);
 	return rc;
@@ -529,6 +610,9 @@ void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
 	/* Update statistics */
 	fibril_rwlock_write_lock(&nic_data->stats_lock);
 
+	if (nic_adaptive_poll_account(nic_data))
+		nic_adaptive_poll_request(nic_data);
+
 	if (nic_data->state == NIC_STATE_ACTIVE && check) {
 		nic_data->stats.receive_packets++;
 		nic_data->stats.receive_bytes += frame->size;
@@ -543,8 +627,17 @@ void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
 			break;
 		}
 		fibril_rwlock_write_unlock(&nic_data->stats_lock);
+
+		/* Pass on only the results of active checksum offloads */
+		uint32_t flags = frame->flags;
+		uint32_t offload = nic_data->offload_active;
+		if ((offload & NIC_OFFLOAD_RX_IPV4_CSUM) == 0)
+			flags &= ~NIC_FF_IPV4_CSUM_OK;
+		if ((offload & NIC_OFFLOAD_RX_L4_CSUM) == 0)
+			flags &= ~NIC_FF_L4_CSUM_OK;
+
 		nic_ev_received(nic_data->client_session, frame->data,
-		    frame->size);
+		    frame->size, flags);
 	} else {
 		switch (frame_type) {
 		case NIC_FRAME_UNICAST:
@@ -612,11 +705,26 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	nic_data->poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->default_poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->send_frame = NULL;
+	nic_data->send_frame_offload = NULL;
+	nic_data->on_offload_change = NULL;
+	nic_data->offload_hw = 0;
+	nic_data->offload_active = 0;
 	nic_data->on_activating = NULL;
 	nic_data->on_going_down = NULL;
 	nic_data->on_stopping = NULL;
 	nic_data->specific = NULL;
 
+	nic_data->adaptive_poll.fibril = 0;
+	nic_data->adaptive_poll.enabled = false;
+	nic_data->adaptive_poll.polling = false;
+	nic_data->adaptive_poll.sw_period = false;
+	nic_data->adaptive_poll.high_rate = NIC_ADAPTIVE_DEFAULT_HIGH_RATE;
+	nic_data->adaptive_poll.low_rate = NIC_ADAPTIVE_DEFAULT_LOW_RATE;
+	nic_data->adaptive_poll.window_frames = 0;
+	nic_data->adaptive_poll.pending = false;
+	fibril_mutex_initialize(&nic_data->adaptive_poll.lock);
+	fibril_condvar_initialize(&nic_data->adaptive_poll.cv);
+
 	fibril_rwlock_initialize(&nic_data->main_lock);
 	fibril_rwlock_initialize(&nic_data->stats_lock);
 	fibril_rwlock_initialize(&nic_data->rxc_lock);
@@ -1132,5 +1240,228 @@ void nic_sw_period_stop(nic_t *nic_data)
 	nic_data->sw_poll_info.running = 0;
 }
 
+/** Account a received frame in the adaptive mode
+ *
+ *  The receive rate is estimated cheaply: the uptime is read only once the
+ *  number of frames needed to reach the high rate within the sampling window
+ *  has been received. Must be called with the stats_lock locked for writing.
+ *
+ *  @param nic_data Nic data structure
+ *
+ *  @return True if the NIC should be switched to polling
+ */
+static bool nic_adaptive_poll_account(nic_t *nic_data)
+{
+	struct adaptive_poll_info *info = &nic_data->adaptive_poll;
+
+	if (!info->enabled || info->polling)
+		return false;
+
+	unsigned threshold = (uint64_t) info->high_rate *
+	    NIC_ADAPTIVE_WINDOW_USEC / SEC2USEC(1);
+	if (++info->window_frames < threshold)
+		return false;
+
+	struct timespec now;
+	getuptime(&now);
+	nsec_t elapsed = ts_sub_diff(&now, &info->window_start);
+
+	info->window_start = now;
+	info->window_frames = 0;
+
+	return elapsed < USEC2NSEC(NIC_ADAPTIVE_WINDOW_USEC);
+}
+
+/** Ask the adaptive fibril to switch the NIC to polling
+ *
+ *  @param nic_data Nic data structure
+ */
+static void nic_adaptive_poll_request(nic_t *nic_data)
+{
+	struct adaptive_poll_info *info = &nic_data->adaptive_poll;
+
+	fibril_mutex_lock(&info->lock);
+	info->pending = true;
+	fibril_condvar_signal(&info->cv);
+	fibril_mutex_unlock(&info->lock);
+}
+
+/** Switch the NIC from interrupts to polling
+ *
+ *  The hardware periodic mode is preferred, the software period fibril
+ *  polling the NIC on demand is used if the driver does not support it.
+ *  Must be called with the main_lock locked for writing.
+ *
+ *  @param nic_data Nic data structure
+ */
+static void nic_adaptive_poll_enter(nic_t *nic_data)
+{
+	struct adaptive_poll_info *info = &nic_data->adaptive_poll;
+
+	errno_t rc = nic_data->on_poll_mode_change(nic_data, NIC_POLL_PERIODIC,
+	    &nic_data->poll_period);
+	if (rc == ENOTSUP && nic_data->on_poll_request != NULL) {
+		rc = nic_data->on_poll_mode_change(nic_data, NIC_POLL_ON_DEMAND,
+		    NULL);
+		if (rc == EOK) {
+			info->sw_period = true;
+			nic_sw_period_start(nic_data);
+		}
+	}
+
+	if (rc == EOK)
+		info->polling = true;
+}
+
+/** Switch the NIC from polling back to interrupts
+ *
+ *  Must be called with the main_lock locked for writing.
+ *
+ *  @param nic_data Nic data structure
+ */
+static void nic_adaptive_poll_leave(nic_t *nic_data)
+{
+	struct adaptive_poll_info *info = &nic_data->adaptive_poll;
+
+	if (info->sw_period) {
+		nic_sw_period_stop(nic_data);
+		info->sw_period = false;
+	}
+
+	errno_t rc = nic_data->on_poll_mode_change(nic_data, NIC_POLL_IMMEDIATE,
+	    NULL);
+	assert(rc == EOK);
+	(void) rc;
+
+	fibril_rwlock_write_lock(&nic_data->stats_lock);
+	info->polling = false;
+	info->window_frames = 0;
+	getuptime(&info->window_start);
+	fibril_rwlock_write_unlock(&nic_data->stats_lock);
+}
+
+/** Read the number of frames received so far
+ *
+ *  @param nic_data Nic data structure
+ */
+static uint64_t nic_adaptive_poll_frames(nic_t *nic_data)
+{
+	fibril_rwlock_read_lock(&nic_data->stats_lock);
+	uint64_t frames = nic_data->stats.receive_packets;
+	fibril_rwlock_read_unlock(&nic_data->stats_lock);
+	return frames;
+}
+
+/** Main function of the adaptive polling fibril
+ *
+ *  Sleeps until the receive path reports a frame rate above the high
+ *  threshold, then switches the NIC to polling and samples the receive
+ *  rate until it drops below the low threshold.
+ *
+ *  @param data The NIC structure pointer
+ *
+ *  @return 0, never reached
+ */
+static errno_t adaptive_fibril_fun(void *data)
+{
+	nic_t *nic = data;
+	struct adaptive_poll_info *info = &nic->adaptive_poll;
+
+	while (true) {
+		fibril_mutex_lock(&info->lock);
+		while (!info->pending)
+			fibril_condvar_wait(&info->cv, &info->lock);
+		info->pending = false;
+		fibril_mutex_unlock(&info->lock);
+
+		fibril_rwlock_write_lock(&nic->main_lock);
+		if (info->enabled && !info->polling)
+			nic_adaptive_poll_enter(nic);
+		fibril_rwlock_write_unlock(&nic->main_lock);
+
+		uint64_t low_frames = (uint64_t) info->low_rate *
+		    NIC_ADAPTIVE_WINDOW_USEC / SEC2USEC(1);
+
+		while (info->polling) {
+			uint64_t frames = nic_adaptive_poll_frames(nic);
+			fibril_usleep(NIC_ADAPTIVE_WINDOW_USEC);
+			if (nic_adaptive_poll_frames(nic) - frames >= low_frames)
+				continue;
+
+			fibril_rwlock_write_lock(&nic->main_lock);
+			if (info->polling)
+				nic_adaptive_poll_leave(nic);
+			fibril_rwlock_write_unlock(&nic->main_lock);
+		}
+	}
+	return EOK;
+}
+
+/** Start the adaptive polling mode
+ *
+ *  The NIC must be issuing interrupts (NIC_POLL_IMMEDIATE) when this is
+ *  called. Must be called with the main_lock locked for writing.
+ *
+ *  @param nic_data Nic data structure
+ *  @param period   Polling period, NULL for the default one
+ *
+ *  @return EOK
+ *  @return ENOTSUP if the driver cannot change the poll mode
+ *  @return ENOMEM if the fibril cannot be created
+ */
+errno_t nic_adaptive_poll_start(nic_t *nic_data, const struct timespec *period)
+{
+	struct adaptive_poll_info *info = &nic_data->adaptive_poll;
+
+	if (nic_data->on_poll_mode_change == NULL)
+		return ENOTSUP;
+
+	if (info->fibril == 0) {
+		info->fibril = fibril_create(adaptive_fibril_fun, nic_data);
+		if (info->fibril == 0)
+			return ENOMEM;
+		fibril_add_ready(info->fibril);
+	}
+
+	if (period != NULL) {
+		nic_data->poll_period = *period;
+	} else {
+		nic_data->poll_period.tv_sec = 0;
+		nic_data->poll_period.tv_nsec =
+		    USEC2NSEC(NIC_ADAPTIVE_DEFAULT_PERIOD_USEC);
+	}
+
+	nic_data->poll_mode = NIC_POLL_ADAPTIVE;
+
+	fibril_rwlock_write_lock(&nic_data->stats_lock);
+	info->polling = false;
+	info->window_frames = 0;
+	getuptime(&info->window_start);
+	info->enabled = true;
+	fibril_rwlock_write_unlock(&nic_data->stats_lock);
+
+	return EOK;
+}
+
+/** Stop the adaptive polling mode
+ *
+ *  The NIC is switched back to interrupts if it was being polled. Must be
+ *  called with the main_lock locked for writing.
+ *
+ *  @param nic_data Nic data structure
+ */
+void nic_adaptive_poll_stop(nic_t *nic_data)
+{
+	struct adaptive_poll_info *info = &nic_data->adaptive_poll;
+
+	if (!info->enabled)
+		return;
+
+	if (info->polling)
+		nic_adaptive_poll_leave(nic_data);
+
+	info->enabled = false;
+}
+
 /** @}
  */
@@ -74,12 +74,14 @@ errno_t nic_ev_device_state(async_sess_t *sess, sysarg_t state)
 }
 
 /** Frame received. */
-errno_t nic_ev_received(async_sess_t *sess, void *data, size_t size)
+errno_t nic_ev_received(async_sess_t *sess, void *data, size_t size,
+    uint32_t flags)
 {
 	async_exch_t *exch = async_exchange_begin(sess);
 
 	ipc_call_t answer;
-	aid_t req = async_send_0(exch, NIC_EV_RECEIVED, &answer);
+	aid_t req = async_send_1(exch, NIC_EV_RECEIVED, (sysarg_t) flags,
+	    &answer);
 	errno_t retval = async_data_write_start(exch, data, size);
 
 	async_exchange_end(exch);
@@ -42,6 +42,7 @@
 #include "nic_driver.h"
 #include "nic_ev.h"
 #include "nic_impl.h"
+#include "nic_offload.h"
 
 /**
  * Default implementation of the set_state method. Trivial.
@@ -118,9 +119,12 @@ errno_t nic_set_state_impl(ddf_fun_t *fun, nic_device_state_t state)
 		/* Notify upper layers that we are reseting the MAC */
 		errno_t rc = nic_ev_addr_changed(nic_data->client_session,
 		    &nic_data->default_mac);
+		nic_adaptive_poll_stop(nic_data);
 		nic_data->poll_mode = nic_data->default_poll_mode;
 		memcpy(&nic_data->poll_period, &nic_data->default_poll_period,
 		    sizeof(struct timespec));
+		if (nic_data->poll_mode == NIC_POLL_ADAPTIVE)
+			nic_adaptive_poll_start(nic_data, &nic_data->poll_period);
 		if (rc != EOK) {
 			/*
 			 * We have already ran the on stopped handler, even if we
@@ -184,6 +188,98 @@ errno_t nic_send_frame_impl(ddf_fun_t *fun, void *data, size_t size)
 	return EOK;
 }
 
+/**
+ * Default implementation of the send_frame_offload method.
+ * Offloads which the hardware does not implement are done in software.
+ *
+ * @param	fun
+ * @param	data	Frame data
+ * @param 	size	Frame size in bytes
+ * @param	flags	Offload requests (NIC_FF_xxx)
+ * @param	mss	Maximum segment size for NIC_FF_TSO
+ *
+ * @return EOK		If the message was sent
+ * @return EBUSY	If the device is not in state when the frame can be sent.
+ * @return EINVAL	If the offload requests do not match the frame
+ */
+errno_t nic_send_frame_offload_impl(ddf_fun_t *fun, void *data, size_t size,
+    uint32_t flags, size_t mss)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+
+	fibril_rwlock_read_lock(&nic_data->main_lock);
+	if (nic_data->state != NIC_STATE_ACTIVE || nic_data->tx_busy) {
+		fibril_rwlock_read_unlock(&nic_data->main_lock);
+		return EBUSY;
+	}
+
+	errno_t rc = nic_offload_send(nic_data, data, size, flags, mss);
+	fibril_rwlock_read_unlock(&nic_data->main_lock);
+	return rc;
+}
+
+/**
+ * Default implementation of the offload_probe method.
+ * Segmentation offload is always supported, it is emulated by NICF.
+ *
+ * @param		fun
+ * @param[out]	supported	Supported offloads
+ * @param[out]	active		Currently active offloads
+ *
+ * @return EOK
+ */
+errno_t nic_offload_probe_impl(ddf_fun_t *fun, uint32_t *supported,
+    uint32_t *active)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+
+	fibril_rwlock_read_lock(&nic_data->main_lock);
+	*supported = nic_data->offload_hw | NIC_OFFLOAD_TSO4;
+	*active = nic_data->offload_active;
+	fibril_rwlock_read_unlock(&nic_data->main_lock);
+	return EOK;
+}
+
+/**
+ * Default implementation of the offload_set method.
+ *
+ * @param	fun
+ * @param	mask	Offloads to be changed
+ * @param	active	New state of the offloads in @a mask
+ *
+ * @return EOK		If the offloads were set
+ * @return ENOTSUP	If some of the offloads is not supported
+ * @return Error code returned by the driver's handler
+ */
+errno_t nic_offload_set_impl(ddf_fun_t *fun, uint32_t mask, uint32_t active)
+{
+	nic_t *nic_data = nic_get_from_ddf_fun(fun);
+
+	fibril_rwlock_write_lock(&nic_data->main_lock);
+
+	uint32_t supported = nic_data->offload_hw | NIC_OFFLOAD_TSO4;
+	uint32_t new_active = (nic_data->offload_active & ~mask) |
+	    (active & mask);
+	if ((new_active & ~supported) != 0) {
+		fibril_rwlock_write_unlock(&nic_data->main_lock);
+		return ENOTSUP;
+	}
+
+	uint32_t hw_active = new_active & nic_data->offload_hw;
+	if (hw_active != (nic_data->offload_active & nic_data->offload_hw) &&
+	    nic_data->on_offload_change != NULL) {
+		errno_t rc = nic_data->on_offload_change(nic_data, hw_active);
+		if (rc != EOK) {
+			fibril_rwlock_write_unlock(&nic_data->main_lock);
+			return rc;
+		}
+	}
+
+	nic_data->offload_active = new_active;
+	fibril_rwlock_write_unlock(&nic_data->main_lock);
+	return EOK;
+}
+
 /**
  * Default implementation of the connect_client method.
  * Creates callback connection to the client.
@@ -755,12 +851,25 @@ errno_t nic_poll_set_mode_impl(ddf_fun_t *fun,
 	if (mode == NIC_POLL_PERIODIC || mode == NIC_POLL_SOFTWARE_PERIODIC) {
 		if (period == NULL)
 			return EINVAL;
+	}
+	if (period != NULL && mode != NIC_POLL_IMMEDIATE &&
+	    mode != NIC_POLL_ON_DEMAND) {
 		if (period->tv_sec == 0 && period->tv_nsec == 0)
 			return EINVAL;
 		if (period->tv_sec < 0 || period->tv_nsec < 0)
 			return EINVAL;
 	}
 	fibril_rwlock_write_lock(&nic_data->main_lock);
+	/* Leave the adaptive mode first, the NIC is issuing interrupts then */
+	nic_adaptive_poll_stop(nic_data);
+	if (mode == NIC_POLL_ADAPTIVE) {
+		errno_t rc = nic_data->on_poll_mode_change(nic_data,
+		    NIC_POLL_IMMEDIATE, NULL);
+		if (rc == EOK)
+			rc = nic_adaptive_poll_start(nic_data, period);
+		fibril_rwlock_write_unlock(&nic_data->main_lock);
+		return rc;
+	}
 	errno_t rc = nic_data->on_poll_mode_change(nic_data, mode, period);
 	assert(rc == EOK || rc == ENOTSUP || rc == EINVAL);
 	if (rc == ENOTSUP && (nic_data->on_poll_request != NULL) &&
@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @addtogroup libnic
+ * @{
+ */
+/**
+ * @file
+ * @brief Software emulation of checksum and segmentation offloads
+ *
+ * TCP super-segments are split here, in the driver task, so that the
+ * network stack passes only a single message per super-segment down to
+ * the driver. The checksums of the resulting frames are completed by the
+ * hardware if it is capable of it, otherwise in software.
+ */
+
+#include <errno.h>
+#include <macros.h>
+#include <mem.h>
+#include <stdlib.h>
+#include <nic/nic.h>
+#include "nic_driver.h"
+#include "nic_offload.h"
+
+#define ETH_HEADER_SIZE  14
+#define ETH_TYPE_IPV4    0x0800
+
+#define IPV4_HEADER_MIN  20
+#define IPV4_FRAG_MASK   0x3fff
+
+#define IP_PROTO_TCP  6
+#define IP_PROTO_UDP  17
+
+#define TCP_HEADER_MIN   20
+#define TCP_CSUM_OFFS    16
+#define TCP_FLAG_FIN     0x01
+#define TCP_FLAG_PSH     0x08
+
+#define UDP_HEADER_SIZE  8
+#define UDP_CSUM_OFFS    6
+
+/** Location of the protocol headers in a frame */
+typedef struct {
+	/** Offset of the IPv4 header */
+	size_t l3_offs;
+	/** Offset of the TCP/UDP header */
+	size_t l4_offs;
+	/** Total size of the headers, up to the L4 payload */
+	size_t hdr_size;
+	/** Offset of the end of the IPv4 datagram */
+	size_t end;
+	/** Offset of the L4 checksum field */
+	size_t csum_offs;
+	/** L4 protocol */
+	uint8_t proto;
+} nic_offload_hdrs_t;
+
+static uint16_t nic_offload_get16(const uint8_t *p)
+{
+	return ((uint16_t) p[0] << 8) | p[1];
+}
+
+static void nic_offload_set16(uint8_t *p, uint16_t val)
+{
+	p[0] = val >> 8;
+	p[1] = val & 0xff;
+}
+
+static uint32_t nic_offload_get32(const uint8_t *p)
+{
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) |
+	    ((uint32_t) p[2] << 8) | p[3];
+}
+
+static void nic_offload_set32(uint8_t *p, uint32_t val)
+{
+	p[0] = val >> 24;
+	p[1] = (val >> 16) & 0xff;
+	p[2] = (val >> 8) & 0xff;
+	p[3] = val & 0xff;
+}
+
+/** Add data to unfolded one's complement sum of 16-bit big-endian words */
+static uint32_t nic_offload_sum(uint32_t sum, const uint8_t *data, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i + 1 < size; i += 2)
+		sum += nic_offload_get16(data + i);
+
+	if (size % 2 != 0)
+		sum += (uint16_t) data[size - 1] << 8;
+
+	return sum;
+}
+
+static uint16_t nic_offload_fold(uint32_t sum)
+{
+	while ((sum >> 16) != 0)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return sum;
+}
+
+/** Locate the headers of a TCP or UDP over IPv4 frame
+ *
+ * @param data  Frame data
+ * @param size  Frame size in bytes
+ * @param hdrs  Place to store the header locations
+ *
+ * @return EOK on success, ENOTSUP if the frame is not an unfragmented
+ *         TCP or UDP over IPv4 frame, EINVAL if it is malformed
+ */
+static errno_t nic_offload_parse(const uint8_t *data, size_t size,
+    nic_offload_hdrs_t *hdrs)
+{
+	if (size < ETH_HEADER_SIZE + IPV4_HEADER_MIN)
+		return EINVAL;
+
+	if (nic_offload_get16(data + 12) != ETH_TYPE_IPV4)
+		return ENOTSUP;
+
+	const uint8_t *ip = data + ETH_HEADER_SIZE;
+	size_t ihl = (ip[0] & 0x0f) * 4;
+	size_t tot_len = nic_offload_get16(ip + 2);
+
+	if ((ip[0] >> 4) != 4 || ihl < IPV4_HEADER_MIN || tot_len < ihl ||
+	    ETH_HEADER_SIZE + tot_len > size)
+		return EINVAL;
+
+	if ((nic_offload_get16(ip + 6) & IPV4_FRAG_MASK) != 0)
+		return ENOTSUP;
+
+	hdrs->l3_offs = ETH_HEADER_SIZE;
+	hdrs->l4_offs = ETH_HEADER_SIZE + ihl;
+	hdrs->end = ETH_HEADER_SIZE + tot_len;
+	hdrs->proto = ip[9];
+
+	switch (hdrs->proto) {
+	case IP_PROTO_TCP:
+		if (hdrs->l4_offs + TCP_HEADER_MIN > hdrs->end)
+			return EINVAL;
+		hdrs->hdr_size = hdrs->l4_offs +
+		    (data[hdrs->l4_offs + 12] >> 4) * 4;
+		if (hdrs->hdr_size < hdrs->l4_offs + TCP_HEADER_MIN ||
+		    hdrs->hdr_size > hdrs->end)
+			return EINVAL;
+		hdrs->csum_offs = hdrs->l4_offs + TCP_CSUM_OFFS;
+		break;
+	case IP_PROTO_UDP:
+		hdrs->hdr_size = hdrs->l4_offs + UDP_HEADER_SIZE;
+		if (hdrs->hdr_size > hdrs->end)
+			return EINVAL;
+		hdrs->csum_offs = hdrs->l4_offs + UDP_CSUM_OFFS;
+		break;
+	default:
+		return ENOTSUP;
+	}
+
+	return EOK;
+}
+
+/** Complete the L4 checksum of a frame in software
+ *
+ * The checksum field must hold the pseudo-header sum.
+ */
+static void nic_offload_csum_complete(uint8_t *data, nic_offload_hdrs_t *hdrs)
+{
+	uint32_t sum = nic_offload_sum(0, data + hdrs->l4_offs,
+	    hdrs->end - hdrs->l4_offs);
+	uint16_t csum = ~nic_offload_fold(sum);
+
+	/* Zero means no checksum in UDP */
+	if (hdrs->proto == IP_PROTO_UDP && csum == 0)
+		csum = 0xffff;
+
+	nic_offload_set16(data + hdrs->csum_offs, csum);
+}
+
+/** Send frame whose L4 checksum is to be completed
+ *
+ * The hardware is used if it is capable of it.
+ */
+static void nic_offload_send_csum(nic_t *nic_data, uint8_t *data, size_t size,
+    nic_offload_hdrs_t *hdrs)
+{
+	if ((nic_data->offload_active & NIC_OFFLOAD_TX_L4_CSUM) != 0 &&
+	    nic_data->send_frame_offload != NULL) {
+		nic_data->send_frame_offload(nic_data, data, size,
+		    NIC_FF_L4_CSUM);
+		return;
+	}
+
+	nic_offload_csum_complete(data, hdrs);
+	nic_data->send_frame(nic_data, data, size);
+}
+
+/** Split TCP super-segment into frames carrying at most @a mss bytes
+ *
+ * @param nic_data
+ * @param data  Frame data
+ * @param hdrs  Header locations
+ * @param mss   Maximum segment size
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+static errno_t nic_offload_segment(nic_t *nic_data, uint8_t *data,
+    nic_offload_hdrs_t *hdrs, size_t mss)
+{
+	size_t hdr_size = hdrs->hdr_size;
+	size_t payload = hdrs->end - hdr_size;
+
+	uint8_t *seg = malloc(hdr_size + mss);
+	if (seg == NULL)
+		return ENOMEM;
+
+	uint16_t ident = nic_offload_get16(data + hdrs->l3_offs + 4);
+	uint32_t seq = nic_offload_get32(data + hdrs->l4_offs + 4);
+	uint8_t *ip = seg + hdrs->l3_offs;
+	uint8_t *tcp = seg + hdrs->l4_offs;
+	size_t ihl = hdrs->l4_offs - hdrs->l3_offs;
+
+	nic_offload_hdrs_t seg_hdrs = *hdrs;
+	size_t offs = 0;
+
+	while (offs < payload) {
+		size_t len = min(mss, payload - offs);
+		size_t l4_len = hdr_size - hdrs->l4_offs + len;
+
+		memcpy(seg, data, hdr_size);
+		memcpy(seg + hdr_size, data + hdr_size + offs, len);
+
+		/* IPv4 header */
+		nic_offload_set16(ip + 2, ihl + l4_len);
+		nic_offload_set16(ip + 4, ident++);
+		nic_offload_set16(ip + 10, 0);
+		nic_offload_set16(ip + 10,
+		    ~nic_offload_fold(nic_offload_sum(0, ip, ihl)));
+
+		/* TCP header, FIN and PSH belong to the last segment only */
+		nic_offload_set32(tcp + 4, seq + offs);
+		if (offs + len < payload)
+			tcp[13] &= ~(TCP_FLAG_FIN | TCP_FLAG_PSH);
+
+		/* Pseudo-header sum: addresses, protocol and TCP length */
+		uint32_t sum = nic_offload_sum(0, ip + 12, 8);
+		sum += IP_PROTO_TCP + l4_len;
+		nic_offload_set16(tcp + TCP_CSUM_OFFS, nic_offload_fold(sum));
+
+		seg_hdrs.end = hdr_size + len;
+		nic_offload_send_csum(nic_data, seg, hdr_size + len, &seg_hdrs);
+
+		offs += len;
+
+		/* The rest would be dropped anyway, leave it to retransmission */
+		if (nic_data->tx_busy)
+			break;
+	}
+
+	free(seg);
+	return EOK;
+}
+
+/** Locate the L4 checksum of a frame passed with NIC_FF_L4_CSUM
+ *
+ * Drivers use this to fill in the checksum offload fields of transmit
+ * descriptors.
+ *
+ * @param data        Frame data
+ * @param size        Frame size in bytes
+ * @param csum_start  Place to store offset where checksumming starts
+ * @param csum_offs   Place to store offset of the checksum field
+ *
+ * @return EOK on success, EINVAL if the frame is not TCP or UDP over IPv4
+ */
+errno_t nic_offload_csum_location(const void *data, size_t size,
+    size_t *csum_start, size_t *csum_offs)
+{
+	nic_offload_hdrs_t hdrs;
+
+	if (nic_offload_parse(data, size, &hdrs) != EOK)
+		return EINVAL;
+
+	*csum_start = hdrs.l4_offs;
+	*csum_offs = hdrs.csum_offs;
+	return EOK;
+}
+
+/** Send frame with offload requests
+ *
+ * Called with the main_lock locked for reading.
+ *
+ * @param nic_data
+ * @param data   Frame data
+ * @param size   Frame size in bytes
+ * @param flags  Offload requests (NIC_FF_xxx)
+ * @param mss    Maximum segment size for NIC_FF_TSO
+ *
+ * @return EOK on success
+ * @return EINVAL if the offload requests do not match the frame
+ * @return ENOMEM if out of memory
+ */
+errno_t nic_offload_send(nic_t *nic_data, void *data, size_t size,
+    uint32_t flags, size_t mss)
+{
+	nic_offload_hdrs_t hdrs;
+	errno_t rc;
+
+	if ((flags & (NIC_FF_L4_CSUM | NIC_FF_TSO)) == 0) {
+		nic_data->send_frame(nic_data, data, size);
+		return EOK;
+	}
+
+	rc = nic_offload_parse(data, size, &hdrs);
+	if (rc != EOK)
+		return EINVAL;
+
+	if ((flags & NIC_FF_TSO) != 0 && hdrs.proto == IP_PROTO_TCP &&
+	    hdrs.end - hdrs.hdr_size > mss) {
+		if (mss == 0)
+			return EINVAL;
+		return nic_offload_segment(nic_data, data, &hdrs, mss);
+	}
+
+	nic_offload_send_csum(nic_data, data, size, &hdrs);
+	return EOK;
+}
+
+/** @}
+ */
@@ -87,15 +87,6 @@ extern int dprintf(int fildes, const char *__restrict__ format, ...)
     _HELENOS_PRINTF_ATTRIBUTE(2, 3);
 extern int vdprintf(int fildes, const char *__restrict__ format, va_list ap);
 
-/* File Locking */
-extern void flockfile(FILE *file);
-extern int ftrylockfile(FILE *file);
-extern void funlockfile(FILE *file);
-extern int getc_unlocked(FILE *stream);
-extern int getchar_unlocked(void);
-extern int putc_unlocked(int c, FILE *stream);
-extern int putchar_unlocked(int c);
-
 /* Temporary Files */
 extern char *tempnam(const char *dir, const char *pfx);
 
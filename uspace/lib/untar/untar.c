@@ -32,14 +32,67 @@
 /** @file
  */
 
+#include <adt/list.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <str.h>
 #include <str_error.h>
 #include <vfs/vfs.h>
 #include "private/tar.h"
 #include "untar.h"
 
+/** Number of fibrils writing the extracted files */
+#define UNTAR_WRITERS  4
+
+/** Size of a chunk of file data handed over to a writer */
+#define UNTAR_CHUNK_SIZE  (128 * TAR_BLOCK_SIZE)
+
+/** Number of chunks (bounds the memory used for file data) */
+#define UNTAR_CHUNKS  16
+
+/** Chunk of file data */
+typedef struct {
+	link_t link;                      /**< Link to a writer or free list */
+	size_t size;                      /**< Bytes of file data */
+	uint8_t data[UNTAR_CHUNK_SIZE];   /**< File data */
+} untar_chunk_t;
+
+struct untar;
+
+/** Writer of extracted files */
+typedef struct {
+	struct untar *untar;    /**< Extraction state */
+	char filename[100];     /**< File being written */
+	list_t chunks;          /**< Chunks waiting to be written */
+	bool busy;              /**< A file has been assigned */
+	bool eof;               /**< All chunks of the file are queued */
+} untar_writer_t;
+
+/** Extraction state
+ *
+ * The archive is read and parsed by the calling fibril. The contents
+ * of regular files are passed in chunks to writer fibrils, so several
+ * files can be written while the archive is being read. The number
+ * of chunks is limited and a chunk is only reused once it has been
+ * written out.
+ *
+ */
+typedef struct untar {
+	tar_file_t *tar;                        /**< Archive */
+	fibril_mutex_t lock;                    /**< Protects the fields below */
+	fibril_condvar_t cv;                    /**< Signals any change */
+	list_t free_chunks;                     /**< Unused chunks */
+	untar_writer_t writers[UNTAR_WRITERS];  /**< Writers */
+	size_t nwriters;                        /**< Number of writers */
+	size_t running;                         /**< Running writer fibrils */
+	bool quit;                              /**< Writers should terminate */
+	errno_t error;                          /**< First error of a writer */
+} untar_t;
+
 static size_t get_block_count(size_t bytes)
 {
 	return (bytes + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE;
@@ -86,49 +139,253 @@ static errno_t tar_skip_blocks(tar_file_t *tar, size_t valid_data_size)
 	return EOK;
 }
 
-static errno_t tar_handle_normal_file(tar_file_t *tar,
-    const tar_header_t *header)
+/** Take the next chunk queued for a writer
+ *
+ * @param writer Writer.
+ *
+ * @return Next chunk or NULL if the whole file has been passed.
+ *
+ */
+static untar_chunk_t *untar_writer_get_chunk(untar_writer_t *writer)
+{
+	untar_t *untar = writer->untar;
+
+	fibril_mutex_lock(&untar->lock);
+
+	while ((list_empty(&writer->chunks)) && (!writer->eof))
+		fibril_condvar_wait(&untar->cv, &untar->lock);
+
+	untar_chunk_t *chunk = list_pop(&writer->chunks, untar_chunk_t, link);
+
+	fibril_mutex_unlock(&untar->lock);
+	return chunk;
+}
+
+/** Return a chunk to the free list
+ *
+ * @param untar Extraction state.
+ * @param chunk Chunk that is no longer used.
+ *
+ */
+static void untar_put_chunk(untar_t *untar, untar_chunk_t *chunk)
+{
+	fibril_mutex_lock(&untar->lock);
+	list_append(&chunk->link, &untar->free_chunks);
+	fibril_condvar_broadcast(&untar->cv);
+	fibril_mutex_unlock(&untar->lock);
+}
+
+/** Write a file assigned to a writer
+ *
+ * All chunks of the file are consumed even if writing fails,
+ * so that they are returned to the free list.
+ *
+ * @param writer Writer.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
+static errno_t untar_write_file(untar_writer_t *writer)
 {
+	untar_t *untar = writer->untar;
+	errno_t rc = EOK;
+
 	// FIXME: create the directory first
 
-	FILE *file = fopen(header->filename, "wb");
+	FILE *file = fopen(writer->filename, "wb");
 	if (file == NULL) {
-		tar_report(tar, "Failed to create %s: %s.\n", header->filename,
-		    str_error(errno));
-		return errno;
+		rc = errno;
+		tar_report(untar->tar, "Failed to create %s: %s.\n",
+		    writer->filename, str_error(rc));
 	}
 
-	errno_t rc = EOK;
-	size_t bytes_remaining = header->size;
-	size_t blocks = get_block_count(bytes_remaining);
+	while (true) {
+		untar_chunk_t *chunk = untar_writer_get_chunk(writer);
+		if (chunk == NULL)
+			break;
 
-	while (blocks > 0) {
-		uint8_t block[TAR_BLOCK_SIZE];
-		size_t actually_read = tar_read(tar, block, TAR_BLOCK_SIZE);
-		if (actually_read != TAR_BLOCK_SIZE) {
+		if (rc == EOK) {
+			size_t actually_written = fwrite(chunk->data, 1,
+			    chunk->size, file);
+			if (actually_written != chunk->size) {
+				rc = errno;
+				tar_report(untar->tar, "Failed to write to %s: %s.\n",
+				    writer->filename, str_error(rc));
+			}
+		}
+
+		untar_put_chunk(untar, chunk);
+	}
+
+	if (file != NULL) {
+		if ((fclose(file) != 0) && (rc == EOK)) {
 			rc = errno;
-			tar_report(tar, "Failed to read block for %s: %s.\n",
-			    header->filename, str_error(rc));
+			tar_report(untar->tar, "Failed to write to %s: %s.\n",
+			    writer->filename, str_error(rc));
+		}
+	}
+
+	return rc;
+}
+
+/** Writer fibril
+ *
+ * @param arg Writer.
+ *
+ * @return Always EOK.
+ *
+ */
+static errno_t untar_writer_fibril(void *arg)
+{
+	untar_writer_t *writer = (untar_writer_t *) arg;
+	untar_t *untar = writer->untar;
+
+	fibril_mutex_lock(&untar->lock);
+
+	while (true) {
+		while ((!writer->busy) && (!untar->quit))
+			fibril_condvar_wait(&untar->cv, &untar->lock);
+
+		if (!writer->busy)
 			break;
+
+		fibril_mutex_unlock(&untar->lock);
+		errno_t rc = untar_write_file(writer);
+		fibril_mutex_lock(&untar->lock);
+
+		if ((rc != EOK) && (untar->error == EOK))
+			untar->error = rc;
+
+		writer->busy = false;
+		fibril_condvar_broadcast(&untar->cv);
+	}
+
+	untar->running--;
+	fibril_condvar_broadcast(&untar->cv);
+	fibril_mutex_unlock(&untar->lock);
+
+	return EOK;
+}
+
+/** Assign a file to an idle writer
+ *
+ * Waits until a writer becomes idle. A file that is still being
+ * written by another writer is not opened again until it is done.
+ *
+ * @param untar    Extraction state.
+ * @param filename File to write.
+ * @param rwriter  Place to store the writer.
+ *
+ * @return EOK on success or the error of a writer that has failed.
+ *
+ */
+static errno_t untar_assign_writer(untar_t *untar, const char *filename,
+    untar_writer_t **rwriter)
+{
+	fibril_mutex_lock(&untar->lock);
+
+	while (untar->error == EOK) {
+		untar_writer_t *idle = NULL;
+		bool conflict = false;
+
+		for (size_t i = 0; i < untar->nwriters; i++) {
+			untar_writer_t *writer = &untar->writers[i];
+
+			if (!writer->busy) {
+				if (idle == NULL)
+					idle = writer;
+			} else if (str_cmp(writer->filename, filename) == 0) {
+				conflict = true;
+			}
 		}
 
-		size_t to_write = TAR_BLOCK_SIZE;
-		if (bytes_remaining < TAR_BLOCK_SIZE)
-			to_write = bytes_remaining;
+		if ((idle != NULL) && (!conflict)) {
+			str_cpy(idle->filename, sizeof(idle->filename), filename);
+			idle->eof = false;
+			idle->busy = true;
+			fibril_condvar_broadcast(&untar->cv);
+			fibril_mutex_unlock(&untar->lock);
 
-		size_t actually_written = fwrite(block, 1, to_write, file);
-		if (actually_written != to_write) {
+			*rwriter = idle;
+			return EOK;
+		}
+
+		fibril_condvar_wait(&untar->cv, &untar->lock);
+	}
+
+	errno_t rc = untar->error;
+	fibril_mutex_unlock(&untar->lock);
+	return rc;
+}
+
+/** Take a free chunk
+ *
+ * @param untar  Extraction state.
+ * @param rchunk Place to store the chunk.
+ *
+ * @return EOK on success or the error of a writer that has failed.
+ *
+ */
+static errno_t untar_get_chunk(untar_t *untar, untar_chunk_t **rchunk)
+{
+	fibril_mutex_lock(&untar->lock);
+
+	while ((list_empty(&untar->free_chunks)) && (untar->error == EOK))
+		fibril_condvar_wait(&untar->cv, &untar->lock);
+
+	errno_t rc = untar->error;
+	if (rc == EOK)
+		*rchunk = list_pop(&untar->free_chunks, untar_chunk_t, link);
+
+	fibril_mutex_unlock(&untar->lock);
+	return rc;
+}
+
+static errno_t tar_handle_normal_file(untar_t *untar,
+    const tar_header_t *header)
+{
+	tar_file_t *tar = untar->tar;
+	untar_writer_t *writer;
+
+	errno_t rc = untar_assign_writer(untar, header->filename, &writer);
+	if (rc != EOK)
+		return rc;
+
+	size_t bytes_remaining = header->size;
+
+	while (bytes_remaining > 0) {
+		untar_chunk_t *chunk;
+		rc = untar_get_chunk(untar, &chunk);
+		if (rc != EOK)
+			break;
+
+		chunk->size = UNTAR_CHUNK_SIZE;
+		if (bytes_remaining < UNTAR_CHUNK_SIZE)
+			chunk->size = bytes_remaining;
+
+		size_t to_read = get_block_count(chunk->size) * TAR_BLOCK_SIZE;
+		size_t actually_read = tar_read(tar, chunk->data, to_read);
+		if (actually_read != to_read) {
 			rc = errno;
-			tar_report(tar, "Failed to write to %s: %s.\n",
+			tar_report(tar, "Failed to read block for %s: %s.\n",
 			    header->filename, str_error(rc));
+			untar_put_chunk(untar, chunk);
 			break;
 		}
 
-		blocks--;
-		bytes_remaining -= TAR_BLOCK_SIZE;
+		fibril_mutex_lock(&untar->lock);
+		list_append(&chunk->link, &writer->chunks);
+		fibril_condvar_broadcast(&untar->cv);
+		fibril_mutex_unlock(&untar->lock);
+
+		bytes_remaining -= chunk->size;
 	}
 
-	fclose(file);
+	fibril_mutex_lock(&untar->lock);
+	writer->eof = true;
+	fibril_condvar_broadcast(&untar->cv);
+	fibril_mutex_unlock(&untar->lock);
+
 	return rc;
 }
 
@@ -146,14 +403,112 @@ static errno_t tar_handle_directory(tar_file_t *tar, const tar_header_t *header)
 	return tar_skip_blocks(tar, header->size);
 }
 
+/** Prepare the chunks and start the writer fibrils
+ *
+ * @param untar Extraction state.
+ * @param tar   Archive.
+ *
+ * @return EOK on success or ENOMEM if out of memory.
+ *
+ */
+static errno_t untar_init(untar_t *untar, tar_file_t *tar)
+{
+	untar->tar = tar;
+	fibril_mutex_initialize(&untar->lock);
+	fibril_condvar_initialize(&untar->cv);
+	list_initialize(&untar->free_chunks);
+	untar->nwriters = 0;
+	untar->running = 0;
+	untar->quit = false;
+	untar->error = EOK;
+
+	for (size_t i = 0; i < UNTAR_CHUNKS; i++) {
+		untar_chunk_t *chunk = malloc(sizeof(untar_chunk_t));
+		if (chunk == NULL)
+			break;
+
+		list_append(&chunk->link, &untar->free_chunks);
+	}
+
+	for (size_t i = 0; i < UNTAR_WRITERS; i++) {
+		untar_writer_t *writer = &untar->writers[i];
+
+		writer->untar = untar;
+		list_initialize(&writer->chunks);
+		writer->busy = false;
+		writer->eof = false;
+
+		fid_t fid = fibril_create(untar_writer_fibril, writer);
+		if (fid == 0)
+			break;
+
+		untar->nwriters++;
+		untar->running++;
+		fibril_add_ready(fid);
+	}
+
+	/* Fewer chunks or writers than requested will do */
+	if ((list_empty(&untar->free_chunks)) || (untar->nwriters == 0))
+		return ENOMEM;
+
+	return EOK;
+}
+
+/** Wait for the writers to finish and free the chunks
+ *
+ * @param untar Extraction state.
+ *
+ * @return EOK on success or the first error of a writer.
+ *
+ */
+static errno_t untar_fini(untar_t *untar)
+{
+	fibril_mutex_lock(&untar->lock);
+
+	untar->quit = true;
+	fibril_condvar_broadcast(&untar->cv);
+
+	while (untar->running > 0)
+		fibril_condvar_wait(&untar->cv, &untar->lock);
+
+	errno_t rc = untar->error;
+	fibril_mutex_unlock(&untar->lock);
+
+	while (!list_empty(&untar->free_chunks))
+		free(list_pop(&untar->free_chunks, untar_chunk_t, link));
+
+	return rc;
+}
+
+/** Extract a TAR archive
+ *
+ * Files are written by several fibrils while the archive is being
+ * read, the memory used for the file data is bounded.
+ *
+ * @param tar Archive.
+ *
+ * @return EOK on success or an error code.
+ *
+ */
 int untar(tar_file_t *tar)
 {
+	untar_t untar;
+
 	int rc = tar_open(tar);
 	if (rc != EOK) {
 		tar_report(tar, "Failed to open: %s.\n", str_error(rc));
 		return rc;
 	}
 
+	rc = untar_init(&untar, tar);
+	if (rc != EOK) {
+		tar_report(tar, "Failed to start extraction: %s.\n",
+		    str_error(rc));
+		(void) untar_fini(&untar);
+		tar_close(tar);
+		return rc;
+	}
+
 	while (true) {
 		tar_header_raw_t header_raw;
 		size_t header_ok = tar_read(tar, &header_raw, sizeof(header_raw));
@@ -161,9 +516,11 @@ int untar(tar_file_t *tar)
 			break;
 
 		tar_header_t header;
-		errno_t rc = tar_header_parse(&header, &header_raw);
-		if (rc == EEMPTY)
+		rc = tar_header_parse(&header, &header_raw);
+		if (rc == EEMPTY) {
+			rc = EOK;
 			continue;
+		}
 
 		if (rc != EOK) {
 			tar_report(tar, "Failed parsing TAR header: %s.\n", str_error(rc));
@@ -175,7 +532,7 @@ int untar(tar_file_t *tar)
 			rc = tar_handle_directory(tar, &header);
 			break;
 		case TAR_TYPE_NORMAL:
-			rc = tar_handle_normal_file(tar, &header);
+			rc = tar_handle_normal_file(&untar, &header);
 			break;
 		default:
 			rc = tar_skip_blocks(tar, header.size);
@@ -186,8 +543,12 @@ int untar(tar_file_t *tar)
 			break;
 	}
 
+	errno_t wrc = untar_fini(&untar);
+	if (rc == EOK)
+		rc = wrc;
+
 	tar_close(tar);
-	return EOK;
+	return rc;
 }
 
 /** @}
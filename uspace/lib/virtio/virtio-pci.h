@@ -181,6 +181,9 @@ typedef struct {
 
 	/** Virtqueues */
 	virtq_t *queues;
+
+	/** Accepted feature flags (bits 0 - 31) */
+	uint32_t features;
 } virtio_dev_t;
 
 extern errno_t virtio_setup_dma_bufs(unsigned int, size_t, bool, void *[],
@@ -200,11 +203,12 @@ extern void virtio_free_desc(virtio_dev_t *, uint16_t, uint16_t *, uint16_t);
 extern void virtio_virtq_produce_available(virtio_dev_t *, uint16_t, uint16_t);
 extern bool virtio_virtq_consume_used(virtio_dev_t *, uint16_t, uint16_t *,
     uint32_t *);
+extern void virtio_virtq_set_interrupts(virtio_dev_t *, uint16_t, bool);
 
 extern errno_t virtio_virtq_setup(virtio_dev_t *, uint16_t, uint16_t);
 extern void virtio_virtq_teardown(virtio_dev_t *, uint16_t);
 
-extern errno_t virtio_device_setup_start(virtio_dev_t *, uint32_t);
+extern errno_t virtio_device_setup_start(virtio_dev_t *, uint32_t, uint32_t);
 extern void virtio_device_setup_fail(virtio_dev_t *);
 extern void virtio_device_setup_finalize(virtio_dev_t *);
 
@@ -205,6 +205,33 @@ bool virtio_virtq_consume_used(virtio_dev_t *vdev, uint16_t num,
 	return true;
 }
 
+/**
+ * Enable or suppress used buffer notifications (interrupts) of a virtqueue
+ *
+ * The device may still send a notification shortly after they have been
+ * suppressed, so the driver must be able to cope with that. After enabling
+ * the notifications, the driver should check the used ring once again as
+ * buffers consumed in the meantime did not trigger any notification.
+ *
+ * @param vdev[in]    VIRTIO device
+ * @param num[in]     Index of the virtqueue
+ * @param enable[in]  True to enable, false to suppress the notifications
+ */
+void virtio_virtq_set_interrupts(virtio_dev_t *vdev, uint16_t num, bool enable)
+{
+	virtq_t *q = &vdev->queues[num];
+
+	fibril_mutex_lock(&q->lock);
+	uint16_t flags = pio_read_le16(&q->avail->flags);
+	if (enable)
+		flags &= ~VIRTQ_AVAIL_F_NO_INTERRUPT;
+	else
+		flags |= VIRTQ_AVAIL_F_NO_INTERRUPT;
+	pio_write_le16(&q->avail->flags, flags);
+	memory_barrier();
+	fibril_mutex_unlock(&q->lock);
+}
+
 errno_t virtio_virtq_setup(virtio_dev_t *vdev, uint16_t num, uint16_t size)
 {
 	virtq_t *q = &vdev->queues[num];
@@ -298,8 +325,13 @@ void virtio_virtq_teardown(virtio_dev_t *vdev, uint16_t num)
 /**
  * Perform device initialization as described in section 3.1.1 of the
  * specification, steps 1 - 6.
+ *
+ * The @a features must be offered by the device, the @a optional features
+ * are accepted only if offered. The accepted set is stored in
+ * @c vdev->features.
  */
-errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
+errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features,
+    uint32_t optional)
 {
 	virtio_pci_common_cfg_t *cfg = vdev->common_cfg;
 
@@ -328,6 +360,7 @@ errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
 
 	if (features != (features & device_features))
 		return ENOTSUP;
+	features |= optional;
 	features &= device_features;
 
 	if (reserved_features != (reserved_features & device_reserved_features))
@@ -352,6 +385,8 @@ errno_t virtio_device_setup_start(virtio_dev_t *vdev, uint32_t features)
 	if (!(status & VIRTIO_DEV_STATUS_FEATURES_OK))
 		return ENOTSUP;
 
+	vdev->features = features;
+
 	return EOK;
 }
 
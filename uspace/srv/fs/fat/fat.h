@@ -221,6 +221,16 @@ typedef struct {
 	struct fat_node	*nodep;
 } fat_idx_t;
 
+/** Run of physically contiguous clusters in a node's cluster chain. */
+typedef struct {
+	/** Index of the first cluster of the run within the cluster chain. */
+	uint32_t	lcl;
+	/** Number of the first cluster of the run. */
+	fat_cluster_t	pcl;
+	/** Number of clusters in the run. */
+	uint32_t	count;
+} fat_extent_t;
+
 /** FAT in-core node. */
 typedef struct fat_node {
 	/** Back pointer to the FS node. */
@@ -243,20 +253,30 @@ typedef struct fat_node {
 	bool			dirty;
 
 	/*
-	 * Cache of the node's last and "current" cluster to avoid some
-	 * unnecessary FAT walks.
+	 * Cache of the node's last cluster to avoid some unnecessary FAT
+	 * walks.
 	 */
 	/* Node's last cluster in FAT. */
 	bool		lastc_cached_valid;
 	fat_cluster_t	lastc_cached_value;
-	/* Node's "current" cluster, i.e. where the last I/O took place. */
-	bool		currc_cached_valid;
-	aoff64_t	currc_cached_bn;
-	fat_cluster_t	currc_cached_value;
+
+	/*
+	 * Extent map of the node's cluster chain. It is built lazily as far
+	 * as the accessed file offsets require, sorted by lcl.
+	 */
+	fat_extent_t	*ext;
+	/* Number of extents in the map. */
+	size_t		ext_count;
+	/* Number of extents the map has room for. */
+	size_t		ext_size;
+	/* The map covers the whole cluster chain. */
+	bool		ext_complete;
 } fat_node_t;
 
 typedef struct {
 	bool lfn_enabled;
+	/** Free cluster bitmap, NULL if not available. */
+	fat_bitmap_t *bitmap;
 } fat_instance_t;
 
 extern vfs_out_ops_t fat_ops;
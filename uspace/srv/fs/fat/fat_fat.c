@@ -46,7 +46,9 @@
 #include <byteorder.h>
 #include <align.h>
 #include <assert.h>
+#include <fibril.h>
 #include <fibril_synch.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 
@@ -59,6 +61,11 @@
  */
 static FIBRIL_MUTEX_INITIALIZE(fat_alloc_lock);
 
+/** Initial number of extents allocated for a node's extent map. */
+#define FAT_EXTENT_INIT		8
+/** Maximum number of extents in a node's extent map. */
+#define FAT_EXTENT_MAX		4096
+
 /** Walk the cluster chain.
  *
  * @param bs		Buffer holding the boot sector for the file.
@@ -112,6 +119,156 @@ fat_cluster_walk(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc,
 	return EOK;
 }
 
+/** Drop the node's extent map.
+ *
+ * @param nodep		FAT node.
+ */
+void fat_extent_invalidate(fat_node_t *nodep)
+{
+	free(nodep->ext);
+	nodep->ext = NULL;
+	nodep->ext_count = 0;
+	nodep->ext_size = 0;
+	nodep->ext_complete = false;
+}
+
+/** Append a new extent to the node's extent map.
+ *
+ * @param nodep		FAT node.
+ * @param lcl		Index of the cluster within the cluster chain.
+ * @param pcl		Cluster number.
+ *
+ * @return		EOK on success, ELIMIT if the map cannot grow any
+ *			further or ENOMEM.
+ */
+static errno_t fat_extent_append(fat_node_t *nodep, uint32_t lcl,
+    fat_cluster_t pcl)
+{
+	if (nodep->ext_count == nodep->ext_size) {
+		size_t nsize;
+		fat_extent_t *next;
+
+		if (nodep->ext_size >= FAT_EXTENT_MAX)
+			return ELIMIT;
+
+		nsize = nodep->ext_size ? 2 * nodep->ext_size :
+		    FAT_EXTENT_INIT;
+		next = realloc(nodep->ext, nsize * sizeof(fat_extent_t));
+		if (next == NULL)
+			return ENOMEM;
+
+		nodep->ext = next;
+		nodep->ext_size = nsize;
+	}
+
+	nodep->ext[nodep->ext_count].lcl = lcl;
+	nodep->ext[nodep->ext_count].pcl = pcl;
+	nodep->ext[nodep->ext_count].count = 1;
+	nodep->ext_count++;
+
+	return EOK;
+}
+
+/** Map cluster index within the node's cluster chain to cluster number.
+ *
+ * Mapped extents are looked up using binary search. If the index lies
+ * beyond the mapped part of the cluster chain, the map is extended by
+ * walking the FAT from the last mapped cluster.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param nodep		FAT node.
+ * @param lcl		Index of the cluster within the cluster chain.
+ * @param pcl		Output argument holding the cluster number.
+ *
+ * @return		EOK on success, ELIMIT if the cluster chain is shorter
+ *			or an error code.
+ */
+errno_t fat_extent_lookup(fat_bs_t *bs, fat_node_t *nodep, uint32_t lcl,
+    fat_cluster_t *pcl)
+{
+	service_id_t service_id = nodep->idx->service_id;
+	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
+	fat_extent_t *last;
+	fat_cluster_t c, nextc;
+	uint32_t endl;
+	uint32_t numc;
+	errno_t rc;
+
+	if (nodep->firstc == FAT_CLST_RES0)
+		return ELIMIT;
+
+	if (nodep->ext_count == 0) {
+		rc = fat_extent_append(nodep, 0, nodep->firstc);
+		if (rc != EOK) {
+			/* Cannot cache anything, walk the chain */
+			rc = fat_cluster_walk(bs, service_id, nodep->firstc,
+			    pcl, &numc, lcl);
+			if (rc != EOK)
+				return rc;
+			return numc == lcl ? EOK : ELIMIT;
+		}
+	}
+
+	last = &nodep->ext[nodep->ext_count - 1];
+	if (lcl < last->lcl + last->count) {
+		size_t lo = 0;
+		size_t hi = nodep->ext_count - 1;
+
+		/* Find the last extent starting at or before lcl */
+		while (lo < hi) {
+			size_t mid = (lo + hi + 1) / 2;
+			if (nodep->ext[mid].lcl <= lcl)
+				lo = mid;
+			else
+				hi = mid - 1;
+		}
+
+		*pcl = nodep->ext[lo].pcl + (lcl - nodep->ext[lo].lcl);
+		return EOK;
+	}
+
+	/* Extend the map */
+	while (true) {
+		last = &nodep->ext[nodep->ext_count - 1];
+		endl = last->lcl + last->count;
+		c = last->pcl + last->count - 1;
+		if (lcl < endl) {
+			*pcl = last->pcl + (lcl - last->lcl);
+			return EOK;
+		}
+
+		if (nodep->ext_complete)
+			return ELIMIT;
+
+		rc = fat_get_cluster(bs, service_id, FAT1, c, &nextc);
+		if (rc != EOK)
+			return rc;
+
+		if (nextc >= clst_last1) {
+			nodep->ext_complete = true;
+			return ELIMIT;
+		}
+
+		assert(nextc >= FAT_CLST_FIRST);
+		assert(nextc != FAT_CLST_BAD(bs));
+
+		if (nextc == c + 1) {
+			last->count++;
+			continue;
+		}
+
+		rc = fat_extent_append(nodep, endl, nextc);
+		if (rc != EOK) {
+			/* The map is full, walk the rest of the chain */
+			rc = fat_cluster_walk(bs, service_id, nextc, pcl,
+			    &numc, lcl - endl);
+			if (rc != EOK)
+				return rc;
+			return numc == lcl - endl ? EOK : ELIMIT;
+		}
+	}
+}
+
 /** Read block from file located on a FAT file system.
  *
  * @param block		Pointer to a block pointer for storing result.
@@ -126,16 +283,16 @@ errno_t
 fat_block_get(block_t **block, struct fat_bs *bs, fat_node_t *nodep,
     aoff64_t bn, int flags)
 {
-	fat_cluster_t firstc = nodep->firstc;
-	fat_cluster_t currc = 0;
-	aoff64_t relbn = bn;
+	fat_cluster_t c;
 	errno_t rc;
 
 	if (!nodep->size)
 		return ELIMIT;
 
-	if (!FAT_IS_FAT32(bs) && nodep->firstc == FAT_CLST_ROOT)
-		goto fall_through;
+	if (!FAT_IS_FAT32(bs) && nodep->firstc == FAT_CLST_ROOT) {
+		return _fat_block_get(block, bs, nodep->idx->service_id,
+		    nodep->firstc, NULL, bn, flags);
+	}
 
 	if (((((nodep->size - 1) / BPS(bs)) / SPC(bs)) == bn / SPC(bs)) &&
 	    nodep->lastc_cached_valid) {
@@ -147,29 +304,12 @@ fat_block_get(block_t **block, struct fat_bs *bs, fat_node_t *nodep,
 		    CLBN2PBN(bs, nodep->lastc_cached_value, bn), flags);
 	}
 
-	if (nodep->currc_cached_valid && bn >= nodep->currc_cached_bn) {
-		/*
-		 * We can start with the cluster cached by the previous call to
-		 * fat_block_get().
-		 */
-		firstc = nodep->currc_cached_value;
-		relbn -= (nodep->currc_cached_bn / SPC(bs)) * SPC(bs);
-	}
-
-fall_through:
-	rc = _fat_block_get(block, bs, nodep->idx->service_id, firstc,
-	    &currc, relbn, flags);
+	rc = fat_extent_lookup(bs, nodep, bn / SPC(bs), &c);
 	if (rc != EOK)
 		return rc;
 
-	/*
-	 * Update the "current" cluster cache.
-	 */
-	nodep->currc_cached_valid = true;
-	nodep->currc_cached_bn = bn;
-	nodep->currc_cached_value = currc;
-
-	return rc;
+	return block_get(block, nodep->idx->service_id, CLBN2PBN(bs, c, bn),
+	    flags);
 }
 
 /** Read block from file located on a FAT file system.
@@ -654,6 +794,440 @@ errno_t fat_alloc_shadow_clusters(fat_bs_t *bs, service_id_t service_id,
 	return EOK;
 }
 
+/** In-memory map of free clusters of a mounted file system. */
+struct fat_bitmap {
+	fibril_mutex_t lock;
+	/** Signalled when the bitmap has been built. */
+	fibril_condvar_t ready_cv;
+	service_id_t service_id;
+	/** One bit per cluster, set if the cluster is in use. */
+	uint32_t *bits;
+	/** Number of cluster numbers covered, including the reserved ones. */
+	uint32_t nclsts;
+	/** Number of free clusters. */
+	uint32_t nfree;
+	/** No cluster below the hint is free. */
+	fat_cluster_t hint;
+	/** Building the bitmap has finished. */
+	bool ready;
+	/** Building the bitmap should be abandoned. */
+	bool stop;
+	/** Result of building the bitmap. */
+	errno_t status;
+};
+
+/** Number of FAT12 entries examined while holding the bitmap lock. */
+#define FAT_BITMAP_CHUNK	256
+
+#define BM_WORD(c)	((c) / 32)
+#define BM_BIT(c)	((uint32_t) 1 << ((c) % 32))
+
+static bool fat_bitmap_used(fat_bitmap_t *bm, fat_cluster_t c)
+{
+	return (bm->bits[BM_WORD(c)] & BM_BIT(c)) != 0;
+}
+
+static void fat_bitmap_set(fat_bitmap_t *bm, fat_cluster_t c)
+{
+	bm->bits[BM_WORD(c)] |= BM_BIT(c);
+}
+
+static void fat_bitmap_clear(fat_bitmap_t *bm, fat_cluster_t c)
+{
+	bm->bits[BM_WORD(c)] &= ~BM_BIT(c);
+}
+
+/** Find the first free cluster at or after @a c. */
+static fat_cluster_t fat_bitmap_next_free(fat_bitmap_t *bm, fat_cluster_t c)
+{
+	while (c < bm->nclsts) {
+		if (c % 32 == 0 && bm->bits[BM_WORD(c)] == UINT32_MAX) {
+			c += 32;
+			continue;
+		}
+		if (!fat_bitmap_used(bm, c))
+			return c;
+		c++;
+	}
+
+	return bm->nclsts;
+}
+
+/** Find the first used cluster at or after @a c. */
+static fat_cluster_t fat_bitmap_next_used(fat_bitmap_t *bm, fat_cluster_t c)
+{
+	while (c < bm->nclsts) {
+		if (c % 32 == 0 && bm->bits[BM_WORD(c)] == 0) {
+			c += 32;
+			continue;
+		}
+		if (fat_bitmap_used(bm, c))
+			return c;
+		c++;
+	}
+
+	return bm->nclsts;
+}
+
+/** Record FAT entries read by the bitmap builder. */
+static void fat_bitmap_record(fat_bitmap_t *bm, fat_cluster_t c,
+    fat_cluster_t value)
+{
+	if (c < FAT_CLST_FIRST || value != FAT_CLST_RES0) {
+		fat_bitmap_set(bm, c);
+	} else {
+		bm->nfree++;
+		if (c < bm->hint)
+			bm->hint = c;
+	}
+}
+
+/** Build the bitmap from FAT1.
+ *
+ * Runs in its own fibril so that mounting does not wait for the whole
+ * FAT to be read. The bitmap lock is only held while a single block of
+ * FAT entries is processed, so clusters can be freed meanwhile.
+ */
+static errno_t fat_bitmap_build(void *arg)
+{
+	fat_bitmap_t *bm = (fat_bitmap_t *) arg;
+	service_id_t service_id = bm->service_id;
+	fat_bs_t *bs = block_bb_get(service_id);
+	fat_cluster_t c = 0;
+	fat_cluster_t value;
+	block_t *b;
+	errno_t rc = EOK;
+
+	while (c < bm->nclsts) {
+		fibril_mutex_lock(&bm->lock);
+		if (bm->stop) {
+			fibril_mutex_unlock(&bm->lock);
+			rc = EINTR;
+			break;
+		}
+
+		if (FAT_IS_FAT12(bs)) {
+			fat_cluster_t end = min(c + FAT_BITMAP_CHUNK,
+			    bm->nclsts);
+
+			for (; c < end; c++) {
+				rc = fat_get_cluster(bs, service_id, FAT1, c,
+				    &value);
+				if (rc != EOK)
+					break;
+				fat_bitmap_record(bm, c, value);
+			}
+		} else {
+			/* Process one FAT block at a time. */
+			size_t esize = FAT_CLST_SIZE(bs);
+			aoff64_t offset = (aoff64_t) c * esize;
+			fat_cluster_t end = min(c + (BPS(bs) - offset % BPS(bs)) /
+			    esize, bm->nclsts);
+
+			rc = block_get(&b, service_id, RSCNT(bs) +
+			    offset / BPS(bs), BLOCK_FLAGS_NONE);
+			if (rc == EOK) {
+				for (; c < end; c++) {
+					uint8_t *ep = b->data +
+					    ((aoff64_t) c * esize) % BPS(bs);
+					if (FAT_IS_FAT32(bs)) {
+						value = uint32_t_le2host(
+						    *(uint32_t *) ep) & FAT32_MASK;
+					} else {
+						value = uint16_t_le2host(
+						    *(uint16_t *) ep);
+					}
+					fat_bitmap_record(bm, c, value);
+				}
+				rc = block_put(b);
+			}
+		}
+
+		fibril_mutex_unlock(&bm->lock);
+		if (rc != EOK)
+			break;
+	}
+
+	fibril_mutex_lock(&bm->lock);
+	bm->status = rc;
+	bm->ready = true;
+	fibril_mutex_unlock(&bm->lock);
+	fibril_condvar_broadcast(&bm->ready_cv);
+
+	return EOK;
+}
+
+/** Start building the free cluster bitmap of a file system.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Service ID of the file system.
+ * @param rbm		Output argument holding the new bitmap.
+ *
+ * @return		EOK on success or ENOMEM.
+ */
+errno_t fat_bitmap_create(fat_bs_t *bs, service_id_t service_id,
+    fat_bitmap_t **rbm)
+{
+	fat_bitmap_t *bm;
+	fid_t fid;
+
+	bm = calloc(1, sizeof(fat_bitmap_t));
+	if (bm == NULL)
+		return ENOMEM;
+
+	fibril_mutex_initialize(&bm->lock);
+	fibril_condvar_initialize(&bm->ready_cv);
+	bm->service_id = service_id;
+	bm->nclsts = CC(bs) + 2;
+	bm->hint = bm->nclsts;
+
+	bm->bits = calloc(BM_WORD(bm->nclsts) + 1, sizeof(uint32_t));
+	if (bm->bits == NULL) {
+		free(bm);
+		return ENOMEM;
+	}
+
+	fid = fibril_create(fat_bitmap_build, bm);
+	if (fid == 0) {
+		free(bm->bits);
+		free(bm);
+		return ENOMEM;
+	}
+
+	fibril_add_ready(fid);
+	*rbm = bm;
+	return EOK;
+}
+
+/** Destroy free cluster bitmap.
+ *
+ * Waits for the bitmap builder to finish if it is still running.
+ *
+ * @param bm		Bitmap.
+ */
+void fat_bitmap_destroy(fat_bitmap_t *bm)
+{
+	fibril_mutex_lock(&bm->lock);
+	bm->stop = true;
+	while (!bm->ready)
+		fibril_condvar_wait(&bm->ready_cv, &bm->lock);
+	fibril_mutex_unlock(&bm->lock);
+
+	free(bm->bits);
+	free(bm);
+}
+
+/** Get free cluster bitmap of a mounted file system.
+ *
+ * @param service_id	Service ID of the file system.
+ *
+ * @return		Bitmap or NULL if there is no usable bitmap.
+ */
+static fat_bitmap_t *fat_bitmap_get(service_id_t service_id)
+{
+	fat_instance_t *instance;
+	fat_bitmap_t *bm;
+	void *data;
+
+	if (fs_instance_get(service_id, &data) != EOK)
+		return NULL;
+
+	instance = (fat_instance_t *) data;
+	bm = instance->bitmap;
+	if (bm == NULL)
+		return NULL;
+
+	fibril_mutex_lock(&bm->lock);
+	while (!bm->ready)
+		fibril_condvar_wait(&bm->ready_cv, &bm->lock);
+	fibril_mutex_unlock(&bm->lock);
+
+	return bm->status == EOK ? bm : NULL;
+}
+
+/** Get number of free clusters from the bitmap.
+ *
+ * @param service_id	Service ID of the file system.
+ * @param count		Output argument holding the number of free clusters.
+ *
+ * @return		EOK on success, ENOENT if there is no usable bitmap.
+ */
+errno_t fat_bitmap_free_count(service_id_t service_id, uint32_t *count)
+{
+	fat_bitmap_t *bm = fat_bitmap_get(service_id);
+
+	if (bm == NULL)
+		return ENOENT;
+
+	fibril_mutex_lock(&bm->lock);
+	*count = bm->nfree;
+	fibril_mutex_unlock(&bm->lock);
+
+	return EOK;
+}
+
+/** Pick free clusters in the bitmap and mark them used.
+ *
+ * The smallest run of free clusters that can hold all @a nclsts clusters is
+ * preferred. If there is no such run, free clusters are taken in address
+ * order, still keeping them in as few runs as possible.
+ *
+ * @param bm		Bitmap.
+ * @param nclsts	Number of clusters.
+ * @param lifo		Array where the clusters are stored in descending
+ *			chain order (the last cluster of the chain first).
+ *
+ * @return		EOK on success or ENOSPC.
+ */
+static errno_t fat_bitmap_alloc(fat_bitmap_t *bm, unsigned nclsts,
+    fat_cluster_t *lifo)
+{
+	fat_cluster_t best = 0;
+	uint32_t best_len = 0;
+	fat_cluster_t c, end;
+	unsigned found;
+
+	assert(fibril_mutex_is_locked(&bm->lock));
+
+	if (bm->nfree < nclsts)
+		return ENOSPC;
+
+	/* Best fit */
+	c = fat_bitmap_next_free(bm, bm->hint);
+	while (c < bm->nclsts) {
+		end = fat_bitmap_next_used(bm, c);
+		if (end - c >= nclsts && (best_len == 0 || end - c < best_len)) {
+			best = c;
+			best_len = end - c;
+			if (best_len == nclsts)
+				break;
+		}
+
+		c = fat_bitmap_next_free(bm, end);
+	}
+
+	if (best_len == 0)
+		best = bm->hint;
+
+	/* Take clusters in ascending order, starting with the chosen run */
+	found = 0;
+	c = fat_bitmap_next_free(bm, best);
+	while (found < nclsts) {
+		assert(c < bm->nclsts);
+		fat_bitmap_set(bm, c);
+		lifo[nclsts - 1 - found] = c;
+		found++;
+		c = fat_bitmap_next_free(bm, c + 1);
+	}
+
+	bm->nfree -= nclsts;
+	bm->hint = fat_bitmap_next_free(bm, bm->hint);
+
+	return EOK;
+}
+
+/** Return clusters picked by fat_bitmap_alloc() to the bitmap. */
+static void fat_bitmap_unalloc(fat_bitmap_t *bm, unsigned nclsts,
+    fat_cluster_t *lifo)
+{
+	unsigned i;
+
+	fibril_mutex_lock(&bm->lock);
+	for (i = 0; i < nclsts; i++) {
+		fat_bitmap_clear(bm, lifo[i]);
+		if (lifo[i] < bm->hint)
+			bm->hint = lifo[i];
+	}
+	bm->nfree += nclsts;
+	fibril_mutex_unlock(&bm->lock);
+}
+
+/** Mark cluster free in the bitmap of a file system.
+ *
+ * @param bm		Bitmap or NULL.
+ * @param c		Cluster which was freed in FAT.
+ */
+static void fat_bitmap_free(fat_bitmap_t *bm, fat_cluster_t c)
+{
+	if (bm == NULL)
+		return;
+
+	fibril_mutex_lock(&bm->lock);
+	/* The builder may not have seen this cluster yet */
+	if (c < bm->nclsts && fat_bitmap_used(bm, c)) {
+		fat_bitmap_clear(bm, c);
+		bm->nfree++;
+		if (c < bm->hint)
+			bm->hint = c;
+	}
+	fibril_mutex_unlock(&bm->lock);
+}
+
+/** Allocate clusters in all copies of FAT using the free cluster bitmap.
+ *
+ * @param bs		Buffer holding the boot sector of the file system.
+ * @param service_id	Device service ID of the file system.
+ * @param bm		Bitmap.
+ * @param nclsts	Number of clusters to allocate.
+ * @param mcl		Output parameter where the first cluster in the chain
+ *			will be returned.
+ * @param lcl		Output parameter where the last cluster in the chain
+ *			will be returned.
+ *
+ * @return		EOK on success, an error code otherwise.
+ */
+static errno_t
+fat_alloc_clusters_bitmap(fat_bs_t *bs, service_id_t service_id,
+    fat_bitmap_t *bm, unsigned nclsts, fat_cluster_t *mcl, fat_cluster_t *lcl)
+{
+	fat_cluster_t *lifo;
+	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
+	unsigned c;
+	errno_t rc;
+
+	lifo = (fat_cluster_t *) malloc(nclsts * sizeof(fat_cluster_t));
+	if (!lifo)
+		return ENOMEM;
+
+	fibril_mutex_lock(&bm->lock);
+	rc = fat_bitmap_alloc(bm, nclsts, lifo);
+	fibril_mutex_unlock(&bm->lock);
+	if (rc != EOK) {
+		free(lifo);
+		return rc;
+	}
+
+	/*
+	 * The clusters are marked used in the bitmap, so nobody else can
+	 * pick them while we are linking them together in FAT1.
+	 */
+	for (c = 0; c < nclsts; c++) {
+		rc = fat_set_cluster(bs, service_id, FAT1, lifo[c],
+		    c == 0 ? clst_last1 : lifo[c - 1]);
+		if (rc != EOK)
+			break;
+	}
+
+	if (rc == EOK)
+		rc = fat_alloc_shadow_clusters(bs, service_id, lifo, nclsts);
+
+	if (rc != EOK) {
+		while (c--) {
+			(void) fat_set_cluster(bs, service_id, FAT1, lifo[c],
+			    FAT_CLST_RES0);
+		}
+		fat_bitmap_unalloc(bm, nclsts, lifo);
+		free(lifo);
+		return rc;
+	}
+
+	*mcl = lifo[nclsts - 1];
+	*lcl = lifo[0];
+	free(lifo);
+
+	return EOK;
+}
+
 /** Allocate clusters in all copies of FAT.
  *
  * This function will attempt to allocate the requested number of clusters in
@@ -661,6 +1235,10 @@ errno_t fat_alloc_shadow_clusters(fat_bs_t *bs, service_id_t service_id,
  * clusters form an independent chain (i.e. a chain which does not belong to any
  * file yet).
  *
+ * When the file system has a free cluster bitmap, the clusters are picked
+ * from it, preferring a single contiguous run. Otherwise FAT1 is scanned
+ * for unused clusters.
+ *
  * @param bs		Buffer holding the boot sector of the file system.
  * @param service_id	Device service ID of the file system.
  * @param nclsts	Number of clusters to allocate.
@@ -680,8 +1258,15 @@ fat_alloc_clusters(fat_bs_t *bs, service_id_t service_id, unsigned nclsts,
 	fat_cluster_t clst;
 	fat_cluster_t value = 0;
 	fat_cluster_t clst_last1 = FAT_CLST_LAST1(bs);
+	fat_bitmap_t *bm;
 	errno_t rc = EOK;
 
+	bm = fat_bitmap_get(service_id);
+	if (bm != NULL) {
+		return fat_alloc_clusters_bitmap(bs, service_id, bm, nclsts,
+		    mcl, lcl);
+	}
+
 	lifo = (fat_cluster_t *) malloc(nclsts * sizeof(fat_cluster_t));
 	if (!lifo)
 		return ENOMEM;
@@ -748,6 +1333,7 @@ fat_free_clusters(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc)
 	unsigned fatno;
 	fat_cluster_t nextc = 0;
 	fat_cluster_t clst_bad = FAT_CLST_BAD(bs);
+	fat_bitmap_t *bm = fat_bitmap_get(service_id);
 	errno_t rc;
 
 	/* Mark all clusters in the chain as free in all copies of FAT. */
@@ -765,6 +1351,7 @@ fat_free_clusters(fat_bs_t *bs, service_id_t service_id, fat_cluster_t firstc)
 				return rc;
 		}
 
+		fat_bitmap_free(bm, firstc);
 		firstc = nextc;
 	}
 
@@ -790,6 +1377,7 @@ errno_t fat_append_clusters(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t mcl,
 
 	if (nodep->firstc == FAT_CLST_RES0) {
 		/* No clusters allocated to the node yet. */
+		fat_extent_invalidate(nodep);
 		nodep->firstc = mcl;
 		nodep->dirty = true;	/* need to sync node */
 	} else {
@@ -809,6 +1397,12 @@ errno_t fat_append_clusters(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t mcl,
 			if (rc != EOK)
 				return rc;
 		}
+
+		/*
+		 * The mapped part of the chain stays valid, but the chain
+		 * now continues past its former end.
+		 */
+		nodep->ext_complete = false;
 	}
 
 	nodep->lastc_cached_valid = true;
@@ -837,8 +1431,7 @@ errno_t fat_chop_clusters(fat_bs_t *bs, fat_node_t *nodep, fat_cluster_t lcl)
 	 * Invalidate cached cluster numbers.
 	 */
 	nodep->lastc_cached_valid = false;
-	if (nodep->currc_cached_value != lcl)
-		nodep->currc_cached_valid = false;
+	fat_extent_invalidate(nodep);
 
 	if (lcl == FAT_CLST_RES0) {
 		/* The node will have zero size and no clusters allocated. */
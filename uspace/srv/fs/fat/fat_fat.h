@@ -105,11 +105,18 @@ struct fat_bs;
 
 typedef uint32_t fat_cluster_t;
 
+/** Free cluster bitmap of a mounted file system. */
+typedef struct fat_bitmap fat_bitmap_t;
+
 #define fat_clusters_get(numc, bs, sid, fc) \
     fat_cluster_walk((bs), (sid), (fc), NULL, (numc), (uint32_t) -1)
 extern errno_t fat_cluster_walk(struct fat_bs *, service_id_t, fat_cluster_t,
     fat_cluster_t *, uint32_t *, uint32_t);
 
+extern errno_t fat_extent_lookup(struct fat_bs *, struct fat_node *, uint32_t,
+    fat_cluster_t *);
+extern void fat_extent_invalidate(struct fat_node *);
+
 extern errno_t fat_block_get(block_t **, struct fat_bs *, struct fat_node *,
     aoff64_t, int);
 extern errno_t _fat_block_get(block_t **, struct fat_bs *, service_id_t,
@@ -119,6 +126,10 @@ extern errno_t fat_append_clusters(struct fat_bs *, struct fat_node *,
     fat_cluster_t, fat_cluster_t);
 extern errno_t fat_chop_clusters(struct fat_bs *, struct fat_node *,
     fat_cluster_t);
+extern errno_t fat_bitmap_create(struct fat_bs *, service_id_t,
+    fat_bitmap_t **);
+extern void fat_bitmap_destroy(fat_bitmap_t *);
+extern errno_t fat_bitmap_free_count(service_id_t, uint32_t *);
 extern errno_t fat_alloc_clusters(struct fat_bs *, service_id_t, unsigned,
     fat_cluster_t *, fat_cluster_t *);
 extern errno_t fat_free_clusters(struct fat_bs *, service_id_t, fat_cluster_t);
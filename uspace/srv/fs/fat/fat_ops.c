@@ -108,9 +108,10 @@ static void fat_node_initialize(fat_node_t *node)
 	node->dirty = false;
 	node->lastc_cached_valid = false;
 	node->lastc_cached_value = 0;
-	node->currc_cached_valid = false;
-	node->currc_cached_bn = 0;
-	node->currc_cached_value = 0;
+	node->ext = NULL;
+	node->ext_count = 0;
+	node->ext_size = 0;
+	node->ext_complete = false;
 }
 
 static errno_t fat_node_sync(fat_node_t *node)
@@ -192,6 +193,7 @@ restart:
 				return rc;
 		}
 		nodep->idx->nodep = NULL;
+		fat_extent_invalidate(nodep);
 		free(nodep->bp);
 		free(nodep);
 
@@ -230,11 +232,13 @@ static errno_t fat_node_get_new(fat_node_t **nodepp)
 				idxp_tmp->nodep = NULL;
 				fibril_mutex_unlock(&nodep->lock);
 				fibril_mutex_unlock(&idxp_tmp->lock);
+				fat_extent_invalidate(nodep);
 				free(nodep->bp);
 				free(nodep);
 				return rc;
 			}
 		}
+		fat_extent_invalidate(nodep);
 		idxp_tmp->nodep = NULL;
 		fibril_mutex_unlock(&nodep->lock);
 		fibril_mutex_unlock(&idxp_tmp->lock);
@@ -476,6 +480,7 @@ errno_t fat_node_put(fs_node_t *fn)
 	}
 	fibril_mutex_unlock(&nodep->lock);
 	if (destroy) {
+		fat_extent_invalidate(nodep);
 		free(nodep->bp);
 		free(nodep);
 	}
@@ -569,6 +574,7 @@ errno_t fat_destroy_node(fs_node_t *fn)
 	}
 
 	fat_idx_destroy(nodep->idx);
+	fat_extent_invalidate(nodep);
 	free(nodep->bp);
 	free(nodep);
 	return rc;
@@ -868,9 +874,16 @@ errno_t fat_free_block_count(service_id_t service_id, uint64_t *count)
 	uint64_t block_count;
 	errno_t rc;
 	uint32_t cluster_no, clusters;
+	uint32_t nfree;
 
-	block_count = 0;
+	/* Use the free cluster bitmap if it is available. */
 	bs = block_bb_get(service_id);
+	if (fat_bitmap_free_count(service_id, &nfree) == EOK) {
+		*count = nfree;
+		return EOK;
+	}
+
+	block_count = 0;
 	clusters = (SPC(bs)) ? TS(bs) / SPC(bs) : 0;
 	for (cluster_no = 0; cluster_no < clusters; cluster_no++) {
 		rc = fat_get_cluster(bs, service_id, FAT1, cluster_no, &e0);
@@ -1088,6 +1101,7 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 	if (!instance)
 		return ENOMEM;
 	instance->lfn_enabled = true;
+	instance->bitmap = NULL;
 
 	/* Parse mount options. */
 	char *mntopts = (char *) opts;
@@ -1105,11 +1119,21 @@ fat_mounted(service_id_t service_id, const char *opts, fs_index_t *index,
 		return rc;
 	}
 
+	/*
+	 * Start building the free cluster bitmap. It is built in the
+	 * background and allocations wait for it to become ready. Without
+	 * the bitmap, we fall back to scanning FAT.
+	 */
+	(void) fat_bitmap_create(block_bb_get(service_id), service_id,
+	    &instance->bitmap);
+
 	fibril_mutex_lock(&ridxp->lock);
 
 	rc = fs_instance_create(service_id, instance);
 	if (rc != EOK) {
 		fibril_mutex_unlock(&ridxp->lock);
+		if (instance->bitmap != NULL)
+			fat_bitmap_destroy(instance->bitmap);
 		fat_fs_close(service_id, rfn);
 		free(instance);
 		return rc;
@@ -1177,6 +1201,20 @@ static errno_t fat_unmounted(service_id_t service_id)
 		return EBUSY;
 	}
 
+	/*
+	 * Stop using the free cluster bitmap. It must be destroyed while
+	 * libblock is still available to its builder.
+	 */
+	void *data;
+	if (fs_instance_get(service_id, &data) == EOK) {
+		fat_instance_t *instance = (fat_instance_t *) data;
+		fat_bitmap_t *bm = instance->bitmap;
+
+		instance->bitmap = NULL;
+		if (bm != NULL)
+			fat_bitmap_destroy(bm);
+	}
+
 	if (FAT_IS_FAT32(bs)) {
 		/*
 		 * Attempt to update the FAT32 FS info.
@@ -1197,7 +1235,6 @@ static errno_t fat_unmounted(service_id_t service_id)
 	(void) fat_node_fini_by_service_id(service_id);
 	fat_fs_close(service_id, fn);
 
-	void *data;
 	if (fs_instance_get(service_id, &data) == EOK) {
 		fs_instance_destroy(service_id);
 		free(data);
@@ -1495,8 +1532,8 @@ fat_truncate(service_id_t service_id, fs_index_t index, aoff64_t size)
 				goto out;
 		} else {
 			fat_cluster_t lastc;
-			rc = fat_cluster_walk(bs, service_id, nodep->firstc,
-			    &lastc, NULL, (size - 1) / BPC(bs));
+			rc = fat_extent_lookup(bs, nodep, (size - 1) / BPC(bs),
+			    &lastc);
 			if (rc != EOK)
 				goto out;
 			rc = fat_chop_clusters(bs, nodep, lastc);
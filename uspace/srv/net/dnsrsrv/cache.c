@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2026 HelenOS project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup dnsrsrv
+ * @{
+ */
+/**
+ * @file
+ * @brief DNS answer cache.
+ *
+ * Caches both positive answers and negative answers (non-existent names
+ * or names without records of the requested type) for the time allowed
+ * by their TTL. An entry is also created while a query is in flight so
+ * that concurrent lookups of the same name wait for the single query
+ * instead of sending their own.
+ */
+
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fibril_synch.h>
+#include <io/log.h>
+#include <macros.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <str.h>
+#include <time.h>
+
+#include "cache.h"
+
+/** Maximum number of cached answers */
+#define DNS_CACHE_MAX  128
+
+/** Upper limit on time an answer is cached (seconds) */
+#define DNS_CACHE_TTL_MAX  (24U * 60 * 60)
+
+/** Upper limit on time a negative answer is cached (seconds) */
+#define DNS_CACHE_NEG_TTL_MAX  (5U * 60)
+
+/** Cached answer */
+struct dns_cache_entry {
+	/** Link to @c dns_cache */
+	ht_link_t link;
+	/** Link to @c dns_cache_lru */
+	link_t lru;
+	/** Queried name */
+	char *name;
+	/** Query type */
+	dns_qtype_t qtype;
+	/** Query is in flight */
+	bool pending;
+	/** Number of fibrils using the entry, entry cannot be evicted */
+	unsigned refcnt;
+	/** Broadcast when query completes */
+	fibril_condvar_t done_cv;
+	/** Query result */
+	errno_t status;
+	/** Canonical name if @c status is EOK */
+	char *cname;
+	/** Address if @c status is EOK */
+	inet_addr_t addr;
+	/** Time after which the answer is no longer valid */
+	struct timespec expires;
+	/** Value of @c dns_cache_gen when the query was sent */
+	unsigned gen;
+};
+
+typedef struct {
+	const char *name;
+	dns_qtype_t qtype;
+} dns_cache_key_t;
+
+/** Cache of answers (of dns_cache_entry_t) */
+static hash_table_t dns_cache;
+/** Cached answers in least recently used order */
+static LIST_INITIALIZE(dns_cache_lru);
+/** Number of entries in @c dns_cache */
+static size_t dns_cache_cnt;
+/** Incremented by each flush, answers to older queries are not cached */
+static unsigned dns_cache_gen;
+static FIBRIL_MUTEX_INITIALIZE(dns_cache_lock);
+
+/** Compute case-insensitive hash of a query */
+static size_t dns_cache_hash_fn(const char *name, dns_qtype_t qtype)
+{
+	size_t hash = hash_mix(qtype);
+
+	while (*name != '\0')
+		hash = hash_combine(hash, tolower((unsigned char) *name++));
+
+	return hash;
+}
+
+static size_t dns_cache_key_hash(const void *key)
+{
+	const dns_cache_key_t *k = key;
+	return dns_cache_hash_fn(k->name, k->qtype);
+}
+
+static size_t dns_cache_hash(const ht_link_t *item)
+{
+	dns_cache_entry_t *entry = hash_table_get_inst(item,
+	    dns_cache_entry_t, link);
+	return dns_cache_hash_fn(entry->name, entry->qtype);
+}
+
+static bool dns_cache_key_equal(const void *key, const ht_link_t *item)
+{
+	const dns_cache_key_t *k = key;
+	dns_cache_entry_t *entry = hash_table_get_inst(item,
+	    dns_cache_entry_t, link);
+
+	return entry->qtype == k->qtype &&
+	    str_casecmp(entry->name, k->name) == 0;
+}
+
+static void dns_cache_remove_callback(ht_link_t *item)
+{
+	dns_cache_entry_t *entry = hash_table_get_inst(item,
+	    dns_cache_entry_t, link);
+
+	list_remove(&entry->lru);
+	free(entry->name);
+	free(entry->cname);
+	free(entry);
+}
+
+static hash_table_ops_t dns_cache_ops = {
+	.hash = dns_cache_hash,
+	.key_hash = dns_cache_key_hash,
+	.key_equal = dns_cache_key_equal,
+	.equal = NULL,
+	.remove_callback = dns_cache_remove_callback
+};
+
+errno_t dns_cache_init(void)
+{
+	if (!hash_table_create(&dns_cache, 0, 0, &dns_cache_ops))
+		return ENOMEM;
+
+	return EOK;
+}
+
+/** Remove an entry from the cache.
+ *
+ * Entries that are in use are only marked as expired.
+ */
+static void dns_cache_remove(dns_cache_entry_t *entry)
+{
+	assert(fibril_mutex_is_locked(&dns_cache_lock));
+
+	if (entry->refcnt > 0) {
+		getuptime(&entry->expires);
+		return;
+	}
+
+	hash_table_remove_item(&dns_cache, &entry->link);
+	--dns_cache_cnt;
+}
+
+/** Evict least recently used entries while the cache is over limit. */
+static void dns_cache_evict(void)
+{
+	assert(fibril_mutex_is_locked(&dns_cache_lock));
+
+	list_foreach_safe(dns_cache_lru, cur, next) {
+		if (dns_cache_cnt <= DNS_CACHE_MAX)
+			break;
+
+		dns_cache_entry_t *entry = list_get_instance(cur,
+		    dns_cache_entry_t, lru);
+		if (entry->refcnt == 0)
+			dns_cache_remove(entry);
+	}
+}
+
+/** Discard all cached answers.
+ *
+ * Used when the DNS server changes.
+ */
+void dns_cache_flush(void)
+{
+	fibril_mutex_lock(&dns_cache_lock);
+
+	list_foreach_safe(dns_cache_lru, cur, next) {
+		dns_cache_entry_t *entry = list_get_instance(cur,
+		    dns_cache_entry_t, lru);
+		dns_cache_remove(entry);
+	}
+
+	++dns_cache_gen;
+	fibril_mutex_unlock(&dns_cache_lock);
+}
+
+/** Copy cached answer to host information. */
+static errno_t dns_cache_result(dns_cache_entry_t *entry,
+    dns_host_info_t *info)
+{
+	if (entry->status != EOK)
+		return entry->status;
+
+	info->cname = str_dup(entry->cname);
+	if (info->cname == NULL)
+		return ENOMEM;
+
+	info->addr = entry->addr;
+	return EOK;
+}
+
+/** Look up answer in cache.
+ *
+ * If a valid answer is cached, it is returned. If a query for the same
+ * name and type is in flight, waits for it to complete and returns its
+ * result. Otherwise an in-flight entry is created and returned in
+ * @a rentry. The caller must then send the query and pass the answer to
+ * dns_cache_put().
+ *
+ * @param name   Queried name
+ * @param qtype  Query type
+ * @param info   Place to store cached answer
+ * @param rentry Place to store entry the caller must complete, set to
+ *               @c NULL if the answer was found in cache
+ *
+ * @return EOK if answer was found or the caller needs to query, cached
+ *         error code for negative answer or failed query, ENOMEM if out
+ *         of memory
+ */
+errno_t dns_cache_get(const char *name, dns_qtype_t qtype,
+    dns_host_info_t *info, dns_cache_entry_t **rentry)
+{
+	dns_cache_key_t key;
+	dns_cache_entry_t *entry;
+	struct timespec now;
+	ht_link_t *link;
+	errno_t rc;
+
+	key.name = name;
+	key.qtype = qtype;
+	*rentry = NULL;
+
+	fibril_mutex_lock(&dns_cache_lock);
+
+	link = hash_table_find(&dns_cache, &key);
+	if (link != NULL) {
+		entry = hash_table_get_inst(link, dns_cache_entry_t, link);
+
+		if (entry->pending) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "dns_cache_get: "
+			    "waiting for query in flight");
+
+			++entry->refcnt;
+			while (entry->pending)
+				fibril_condvar_wait(&entry->done_cv, &dns_cache_lock);
+			--entry->refcnt;
+
+			rc = dns_cache_result(entry, info);
+			fibril_mutex_unlock(&dns_cache_lock);
+			return rc;
+		}
+
+		getuptime(&now);
+		if (!ts_gteq(&now, &entry->expires)) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "dns_cache_get: hit");
+
+			list_remove(&entry->lru);
+			list_append(&entry->lru, &dns_cache_lru);
+
+			rc = dns_cache_result(entry, info);
+			fibril_mutex_unlock(&dns_cache_lock);
+			return rc;
+		}
+
+		/* Expired, query again reusing the entry */
+		free(entry->cname);
+		entry->cname = NULL;
+	} else {
+		entry = calloc(1, sizeof(dns_cache_entry_t));
+		if (entry == NULL) {
+			fibril_mutex_unlock(&dns_cache_lock);
+			return ENOMEM;
+		}
+
+		entry->name = str_dup(name);
+		if (entry->name == NULL) {
+			free(entry);
+			fibril_mutex_unlock(&dns_cache_lock);
+			return ENOMEM;
+		}
+
+		entry->qtype = qtype;
+		fibril_condvar_initialize(&entry->done_cv);
+		link_initialize(&entry->lru);
+		list_append(&entry->lru, &dns_cache_lru);
+		hash_table_insert(&dns_cache, &entry->link);
+		++dns_cache_cnt;
+	}
+
+	entry->pending = true;
+	entry->gen = dns_cache_gen;
+	++entry->refcnt;
+	dns_cache_evict();
+
+	fibril_mutex_unlock(&dns_cache_lock);
+
+	*rentry = entry;
+	return EOK;
+}
+
+/** Complete query and store its answer in cache.
+ *
+ * Wakes up all lookups waiting for the query. Only positive answers (EOK)
+ * and negative answers (ENOENT) are cached, other failures are reported
+ * to the waiting lookups, but not remembered. Neither is an answer to
+ * a query sent before the cache was flushed.
+ *
+ * @param entry  Entry returned by dns_cache_get()
+ * @param status Query result
+ * @param info   Answer if @a status is EOK
+ * @param ttl    Time for which the answer may be cached (seconds)
+ */
+void dns_cache_put(dns_cache_entry_t *entry, errno_t status,
+    dns_host_info_t *info, uint32_t ttl)
+{
+	fibril_mutex_lock(&dns_cache_lock);
+
+	assert(entry->pending);
+
+	entry->status = status;
+	if (status == EOK) {
+		entry->cname = str_dup(info->cname);
+		if (entry->cname == NULL) {
+			/* Cannot cache, waiters will get ENOMEM */
+			entry->status = ENOMEM;
+		}
+
+		entry->addr = info->addr;
+		ttl = min(ttl, DNS_CACHE_TTL_MAX);
+	} else if (status == ENOENT) {
+		ttl = min(ttl, DNS_CACHE_NEG_TTL_MAX);
+	} else {
+		ttl = 0;
+	}
+
+	if (entry->status != status)
+		ttl = 0;
+
+	/* The answer may come from a server used before the last flush */
+	if (entry->gen != dns_cache_gen)
+		ttl = 0;
+
+	getuptime(&entry->expires);
+	entry->expires.tv_sec += ttl;
+
+	entry->pending = false;
+	--entry->refcnt;
+	fibril_condvar_broadcast(&entry->done_cv);
+
+	if (ttl == 0 && entry->refcnt == 0)
+		dns_cache_remove(entry);
+
+	fibril_mutex_unlock(&dns_cache_lock);
+}
+
+/** @}
+ */
@@ -34,21 +34,79 @@
  */
 
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
 #include <io/log.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 #include <str.h>
+#include "cache.h"
 #include "dns_msg.h"
 #include "dns_std.h"
 #include "dns_type.h"
 #include "query.h"
 #include "transport.h"
 
+/** Negative answer TTL if the server does not provide one (seconds) */
+#define DNS_NEG_TTL_DEFAULT  60
+
+/** Minimum size of SOA RDATA (two root names and five 32-bit fields) */
+#define DNS_SOA_RDATA_MIN  22
+
 static uint16_t msg_id;
 
+/** Parallel address query */
+typedef struct {
+	const char *name;
+	dns_qtype_t qtype;
+	dns_host_info_t info;
+	errno_t rc;
+	bool done;
+	fibril_mutex_t lock;
+	fibril_condvar_t done_cv;
+} dns_pquery_t;
+
+/** Determine how long a negative answer may be cached.
+ *
+ * Per RFC 2308 this is the lesser of the TTL of the SOA record
+ * in the authority section and its MINIMUM field.
+ *
+ * @param amsg Answer message
+ * @return Negative answer TTL in seconds
+ */
+static uint32_t dns_neg_ttl(dns_message_t *amsg)
+{
+	list_foreach(amsg->authority, msg, dns_rr_t, rr) {
+		if ((rr->rtype == DTYPE_SOA) && (rr->rclass == DC_IN) &&
+		    (rr->rdata_size >= DNS_SOA_RDATA_MIN)) {
+			/* MINIMUM is the last field of SOA RDATA */
+			uint32_t minimum = dns_uint32_t_decode((uint8_t *)
+			    rr->rdata + rr->rdata_size - sizeof(uint32_t),
+			    sizeof(uint32_t));
+			return min(rr->ttl, minimum);
+		}
+	}
+
+	return DNS_NEG_TTL_DEFAULT;
+}
+
+/** Query DNS server for address of a host.
+ *
+ * @param name  Host name
+ * @param qtype Query type (DTYPE_A or DTYPE_AAAA)
+ * @param info  Place to store host information
+ * @param rttl  Place to store time for which the answer may be cached
+ *
+ * @return EOK on success, ENOENT if the server answered that there is
+ *         no such address, other error code if the query failed
+ */
 static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
-    dns_host_info_t *info)
+    dns_host_info_t *info, uint32_t *rttl)
 {
+	/* Answer is only valid as long as all records used */
+	uint32_t ttl = UINT32_MAX;
+
 	/* Start with the caller-provided name */
 	char *sname = str_dup(name);
 	if (sname == NULL)
@@ -129,6 +187,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 			/* Continue looking for the more canonical name */
 			free(sname);
 			sname = cname;
+			ttl = min(ttl, rr->ttl);
 		}
 
 		if ((qtype == DTYPE_A) && (rr->rtype == DTYPE_A) &&
@@ -146,6 +205,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 
 			inet_addr_set(dns_uint32_t_decode(rr->rdata, rr->rdata_size),
 			    &info->addr);
+			*rttl = min(ttl, rr->ttl);
 
 			dns_message_destroy(msg);
 			dns_message_destroy(amsg);
@@ -171,6 +231,7 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 			dns_addr128_t_decode(rr->rdata, rr->rdata_size, addr);
 
 			inet_addr_set6(addr, &info->addr);
+			*rttl = min(ttl, rr->ttl);
 
 			dns_message_destroy(msg);
 			dns_message_destroy(amsg);
@@ -182,11 +243,111 @@ static errno_t dns_name_query(const char *name, dns_qtype_t qtype,
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "'%s' not resolved, fail", sname);
 
+	if ((amsg->rcode == RC_OK) || (amsg->rcode == RC_NAME_ERR)) {
+		/* Name does not exist or has no such records */
+		*rttl = dns_neg_ttl(amsg);
+		rc = ENOENT;
+	} else {
+		rc = EIO;
+	}
+
 	dns_message_destroy(msg);
 	dns_message_destroy(amsg);
 	free(sname);
 
-	return EIO;
+	return rc;
+}
+
+/** Look up address of a host, using the cache if possible.
+ *
+ * @param name  Host name
+ * @param qtype Query type (DTYPE_A or DTYPE_AAAA)
+ * @param info  Place to store host information
+ *
+ * @return EOK on success, ENOENT if there is no such address, other
+ *         error code if the lookup failed
+ */
+static errno_t dns_name_lookup(const char *name, dns_qtype_t qtype,
+    dns_host_info_t *info)
+{
+	dns_cache_entry_t *entry;
+	uint32_t ttl = 0;
+	errno_t rc;
+
+	rc = dns_cache_get(name, qtype, info, &entry);
+	if (entry == NULL)
+		return rc;
+
+	rc = dns_name_query(name, qtype, info, &ttl);
+	dns_cache_put(entry, rc, info, ttl);
+	return rc;
+}
+
+static errno_t dns_pquery_fibril(void *arg)
+{
+	dns_pquery_t *pq = (dns_pquery_t *) arg;
+	errno_t rc;
+
+	rc = dns_name_lookup(pq->name, pq->qtype, &pq->info);
+
+	fibril_mutex_lock(&pq->lock);
+	pq->rc = rc;
+	pq->done = true;
+	fibril_mutex_unlock(&pq->lock);
+	fibril_condvar_broadcast(&pq->done_cv);
+
+	return EOK;
+}
+
+/** Look up IPv6 and IPv4 address of a host in parallel.
+ *
+ * IPv6 address is preferred if both are available.
+ *
+ * @param name Host name
+ * @param info Place to store host information
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t dns_name_lookup_any(const char *name, dns_host_info_t *info)
+{
+	dns_pquery_t pq;
+	fid_t fid;
+	errno_t rc;
+
+	memset(&pq, 0, sizeof(pq));
+	pq.name = name;
+	pq.qtype = DTYPE_A;
+	fibril_mutex_initialize(&pq.lock);
+	fibril_condvar_initialize(&pq.done_cv);
+
+	fid = fibril_create(dns_pquery_fibril, &pq);
+	if (fid == 0) {
+		/* Fall back to sequential queries */
+		rc = dns_name_lookup(name, DTYPE_AAAA, info);
+		if (rc != EOK)
+			rc = dns_name_lookup(name, DTYPE_A, info);
+		return rc;
+	}
+
+	fibril_add_ready(fid);
+
+	rc = dns_name_lookup(name, DTYPE_AAAA, info);
+
+	fibril_mutex_lock(&pq.lock);
+	while (!pq.done)
+		fibril_condvar_wait(&pq.done_cv, &pq.lock);
+	fibril_mutex_unlock(&pq.lock);
+
+	if (rc == EOK) {
+		if (pq.rc == EOK)
+			free(pq.info.cname);
+		return EOK;
+	}
+
+	if (pq.rc == EOK)
+		*info = pq.info;
+
+	return pq.rc;
 }
 
 errno_t dns_name2host(const char *name, dns_host_info_t **rinfo, ip_ver_t ver)
@@ -199,22 +360,22 @@ errno_t dns_name2host(const char *name, dns_host_info_t **rinfo, ip_ver_t ver)
 
 	switch (ver) {
 	case ip_any:
-		rc = dns_name_query(name, DTYPE_AAAA, info);
-
-		if (rc != EOK)
-			rc = dns_name_query(name, DTYPE_A, info);
-
+		rc = dns_name_lookup_any(name, info);
 		break;
 	case ip_v4:
-		rc = dns_name_query(name, DTYPE_A, info);
+		rc = dns_name_lookup(name, DTYPE_A, info);
 		break;
 	case ip_v6:
-		rc = dns_name_query(name, DTYPE_AAAA, info);
+		rc = dns_name_lookup(name, DTYPE_AAAA, info);
 		break;
 	default:
 		rc = EINVAL;
 	}
 
+	/* Keep reporting unresolved names the way clients expect */
+	if (rc == ENOENT)
+		rc = EIO;
+
 	if (rc == EOK)
 		*rinfo = info;
 	else
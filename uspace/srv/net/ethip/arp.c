@@ -46,9 +46,6 @@
 #include "pdu.h"
 #include "std.h"
 
-/** Time to wait for ARP reply in microseconds */
-#define ARP_REQUEST_TIMEOUT (3 * 1000 * 1000)
-
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet);
 
 void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
@@ -63,6 +60,14 @@ void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ARP PDU decoded, opcode=%d, tpa=%x",
 	    packet.opcode, packet.target_proto_addr);
 
+	/*
+	 * Refresh any translation we already have for the sender. This
+	 * also covers gratuitous ARP and ARP traffic not addressed to us.
+	 * Address probes carry no sender address.
+	 */
+	if (packet.sender_proto_addr != 0)
+		atrans_update(packet.sender_proto_addr, packet.sender_hw_addr);
+
 	inet_addr_t addr;
 	inet_addr_set(packet.target_proto_addr, &addr);
 
@@ -75,10 +80,17 @@ void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
 	if (laddr_ver != ip_v4)
 		return;
 
+	if (packet.sender_proto_addr == laddr_v4) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Gratuitous ARP for my address");
+		return;
+	}
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Request/reply to my address");
 
-	(void) atrans_add(packet.sender_proto_addr,
-	    packet.sender_hw_addr);
+	if (packet.sender_proto_addr != 0) {
+		(void) atrans_add(nic, laddr_v4, packet.sender_proto_addr,
+		    packet.sender_hw_addr);
+	}
 
 	if (packet.opcode == aop_request) {
 		arp_eth_packet_t reply;
@@ -93,32 +105,70 @@ void arp_received(ethip_nic_t *nic, eth_frame_t *frame)
 	}
 }
 
-errno_t arp_translate(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
-    addr48_t mac_addr)
+/** Send IPv4 frame, resolving the destination MAC address.
+ *
+ * If the destination address is not known yet, the frame is queued
+ * until the translation is resolved.
+ *
+ * @param nic      NIC
+ * @param src_addr Source IPv4 address
+ * @param ip_addr  Destination IPv4 address
+ * @param data     Encoded Ethernet frame, ownership is transferred
+ * @param size     Frame size
+ * @param flags    Offload requests (NIC_FF_xxx)
+ * @param mss      Maximum segment size if NIC_FF_TSO is requested
+ *
+ * @return EOK on success or an error code
+ */
+errno_t arp_send(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
+    void *data, size_t size, uint32_t flags, size_t mss)
 {
+	errno_t rc;
+
 	/* Broadcast address */
 	if (ip_addr == addr32_broadcast_all_hosts) {
-		addr48(addr48_broadcast, mac_addr);
-		return EOK;
+		eth_pdu_set_dest(data, addr48_broadcast);
+		rc = ethip_nic_send_offload(nic, data, size, flags, mss);
+		free(data);
+		return rc;
 	}
 
-	errno_t rc = atrans_lookup(ip_addr, mac_addr);
-	if (rc == EOK)
-		return EOK;
+	return atrans_send(nic, src_addr, ip_addr, data, size, flags, mss);
+}
 
+/** Send ARP request.
+ *
+ * @param nic      NIC
+ * @param src_addr Sender IPv4 address
+ * @param ip_addr  IPv4 address to resolve
+ * @param dest     Destination MAC address (broadcast or unicast probe)
+ *
+ * @return EOK on success or an error code
+ */
+errno_t arp_send_request(ethip_nic_t *nic, addr32_t src_addr,
+    addr32_t ip_addr, const addr48_t dest)
+{
 	arp_eth_packet_t packet;
 
 	packet.opcode = aop_request;
 	addr48(nic->mac_addr, packet.sender_hw_addr);
 	packet.sender_proto_addr = src_addr;
-	addr48(addr48_broadcast, packet.target_hw_addr);
+	addr48(dest, packet.target_hw_addr);
 	packet.target_proto_addr = ip_addr;
 
-	rc = arp_send_packet(nic, &packet);
-	if (rc != EOK)
-		return rc;
+	return arp_send_packet(nic, &packet);
+}
 
-	return atrans_lookup_timeout(ip_addr, ARP_REQUEST_TIMEOUT, mac_addr);
+/** Send gratuitous ARP announcing our translation.
+ *
+ * @param nic  NIC
+ * @param addr Our IPv4 address
+ *
+ * @return EOK on success or an error code
+ */
+errno_t arp_announce(ethip_nic_t *nic, addr32_t addr)
+{
+	return arp_send_request(nic, addr, addr, addr48_broadcast);
 }
 
 static errno_t arp_send_packet(ethip_nic_t *nic, arp_eth_packet_t *packet)
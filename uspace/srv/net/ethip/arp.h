@@ -42,7 +42,11 @@
 #include "ethip.h"
 
 extern void arp_received(ethip_nic_t *, eth_frame_t *);
-extern errno_t arp_translate(ethip_nic_t *, addr32_t, addr32_t, addr48_t);
+extern errno_t arp_send(ethip_nic_t *, addr32_t, addr32_t, void *, size_t,
+    uint32_t, size_t);
+extern errno_t arp_send_request(ethip_nic_t *, addr32_t, addr32_t,
+    const addr48_t);
+extern errno_t arp_announce(ethip_nic_t *, addr32_t);
 
 #endif
 
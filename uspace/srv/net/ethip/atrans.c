@@ -34,131 +34,497 @@
  * @brief
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <inet/iplink_srv.h>
+#include <io/log.h>
 #include <stdlib.h>
 
+#include "arp.h"
 #include "atrans.h"
 #include "ethip.h"
+#include "ethip_nic.h"
+#include "pdu.h"
 
-/** Address translation list (of ethip_atrans_t) */
-static FIBRIL_MUTEX_INITIALIZE(atrans_list_lock);
-static LIST_INITIALIZE(atrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(atrans_cv);
+/** Aging timer period in microseconds */
+#define ATRANS_TICK_USEC  (1000 * 1000)
 
-static ethip_atrans_t *atrans_find(addr32_t ip_addr)
+/** Ticks after which a confirmed translation becomes stale */
+#define ATRANS_REACHABLE_TICKS  30
+
+/** Ticks after which an unused stale translation is discarded */
+#define ATRANS_GC_TICKS  600
+
+/** Number of requests sent before resolution is given up */
+#define ATRANS_MAX_REQUESTS  3
+
+/** Maximum number of frames queued per unresolved address */
+#define ATRANS_MAX_PENDING  16
+
+/** Frame waiting for address resolution */
+typedef struct {
+	/** Link to ethip_atrans_t.pending */
+	link_t link;
+	/** NIC to send the frame over */
+	ethip_nic_t *nic;
+	/** Encoded Ethernet frame */
+	void *data;
+	/** Frame size */
+	size_t size;
+	/** Offload requests (NIC_FF_xxx) */
+	uint32_t flags;
+	/** Maximum segment size */
+	size_t mss;
+} atrans_pending_t;
+
+/** ARP request to send after the table lock is released */
+typedef struct {
+	link_t link;
+	ethip_nic_t *nic;
+	addr32_t src_addr;
+	addr32_t ip_addr;
+	addr48_t dest;
+} atrans_request_t;
+
+/** Address translation table (of ethip_atrans_t) */
+static FIBRIL_MUTEX_INITIALIZE(atrans_lock);
+static hash_table_t atrans_table;
+static fibril_timer_t *atrans_timer;
+
+/** Requests collected by the aging timer (of atrans_request_t) */
+static LIST_INITIALIZE(atrans_requests);
+
+static void atrans_timer_fun(void *);
+
+static size_t atrans_key_hash(const void *key)
+{
+	const addr32_t *ip_addr = key;
+	return hash_mix32(*ip_addr);
+}
+
+static size_t atrans_hash(const ht_link_t *item)
+{
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    atrans_link);
+	return hash_mix32(atrans->ip_addr);
+}
+
+static bool atrans_key_equal(const void *key, const ht_link_t *item)
+{
+	const addr32_t *ip_addr = key;
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    atrans_link);
+	return atrans->ip_addr == *ip_addr;
+}
+
+static void atrans_remove_callback(ht_link_t *item)
 {
-	list_foreach(atrans_list, atrans_list, ethip_atrans_t, atrans) {
-		if (atrans->ip_addr == ip_addr)
-			return atrans;
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    atrans_link);
+
+	list_foreach_safe(atrans->pending, cur, next) {
+		atrans_pending_t *pend = list_get_instance(cur, atrans_pending_t,
+		    link);
+		list_remove(&pend->link);
+		free(pend->data);
+		free(pend);
 	}
 
-	return NULL;
+	free(atrans);
 }
 
-errno_t atrans_add(addr32_t ip_addr, addr48_t mac_addr)
+static hash_table_ops_t atrans_ops = {
+	.hash = atrans_hash,
+	.key_hash = atrans_key_hash,
+	.key_equal = atrans_key_equal,
+	.equal = NULL,
+	.remove_callback = atrans_remove_callback
+};
+
+/** Initialize address translation table
+ *
+ * @return EOK on success or an error code
+ */
+errno_t atrans_init(void)
 {
-	ethip_atrans_t *atrans;
-	ethip_atrans_t *prev;
+	if (!hash_table_create(&atrans_table, 0, 0, &atrans_ops))
+		return ENOMEM;
 
-	atrans = calloc(1, sizeof(ethip_atrans_t));
-	if (atrans == NULL)
+	atrans_timer = fibril_timer_create(&atrans_lock);
+	if (atrans_timer == NULL) {
+		hash_table_destroy(&atrans_table);
 		return ENOMEM;
+	}
+
+	fibril_timer_set(atrans_timer, ATRANS_TICK_USEC, atrans_timer_fun,
+	    NULL);
+	return EOK;
+}
+
+static ethip_atrans_t *atrans_find(addr32_t ip_addr)
+{
+	ht_link_t *link = hash_table_find(&atrans_table, &ip_addr);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, ethip_atrans_t, atrans_link);
+}
+
+static ethip_atrans_t *atrans_create(ethip_nic_t *nic, addr32_t src_addr,
+    addr32_t ip_addr)
+{
+	ethip_atrans_t *atrans = calloc(1, sizeof(ethip_atrans_t));
+	if (atrans == NULL)
+		return NULL;
 
 	atrans->ip_addr = ip_addr;
+	atrans->nic = nic;
+	atrans->src_addr = src_addr;
+	list_initialize(&atrans->pending);
+	hash_table_insert(&atrans_table, &atrans->atrans_link);
+
+	return atrans;
+}
+
+/** Mark translation as confirmed.
+ *
+ * Moves frames waiting for resolution to @a flush. The caller is expected
+ * to send them with atrans_flush() after releasing the table lock.
+ */
+static void atrans_confirm_locked(ethip_atrans_t *atrans, addr48_t mac_addr,
+    list_t *flush)
+{
 	addr48(mac_addr, atrans->mac_addr);
+	atrans->state = ats_reachable;
+	atrans->age = 0;
+	atrans->requests = 0;
+
+	list_concat(flush, &atrans->pending);
+	atrans->npending = 0;
+}
 
-	fibril_mutex_lock(&atrans_list_lock);
-	prev = atrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->atrans_list);
-		free(prev);
+/** Send frames released by atrans_confirm_locked(). */
+static void atrans_flush(list_t *flush, addr48_t mac_addr)
+{
+	list_foreach_safe(*flush, cur, next) {
+		atrans_pending_t *pend = list_get_instance(cur, atrans_pending_t,
+		    link);
+		list_remove(&pend->link);
+
+		eth_pdu_set_dest(pend->data, mac_addr);
+		(void) ethip_nic_send_offload(pend->nic, pend->data, pend->size,
+		    pend->flags, pend->mss);
+
+		free(pend->data);
+		free(pend);
 	}
+}
 
-	list_append(&atrans->atrans_list, &atrans_list);
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
+/** Add confirmed translation.
+ *
+ * Called when an ARP packet addressed to us is received. Any frames
+ * waiting for the translation are sent out.
+ *
+ * @param nic      NIC the packet was received on
+ * @param src_addr Our address the packet was addressed to
+ * @param ip_addr  IP address
+ * @param mac_addr MAC address
+ *
+ * @return EOK on success, ENOMEM if out of memory
+ */
+errno_t atrans_add(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
+    addr48_t mac_addr)
+{
+	list_t flush;
+	ethip_atrans_t *atrans;
+
+	list_initialize(&flush);
 
+	fibril_mutex_lock(&atrans_lock);
+	atrans = atrans_find(ip_addr);
+	if (atrans == NULL) {
+		atrans = atrans_create(nic, src_addr, ip_addr);
+		if (atrans == NULL) {
+			fibril_mutex_unlock(&atrans_lock);
+			return ENOMEM;
+		}
+	}
+
+	atrans->nic = nic;
+	atrans->src_addr = src_addr;
+	atrans_confirm_locked(atrans, mac_addr, &flush);
+	fibril_mutex_unlock(&atrans_lock);
+
+	atrans_flush(&flush, mac_addr);
 	return EOK;
 }
 
-errno_t atrans_remove(addr32_t ip_addr)
+/** Update existing translation.
+ *
+ * Called for every ARP packet received (including gratuitous ARP and
+ * packets not addressed to us). Only refreshes entries that already exist
+ * so that the table does not fill up with unused translations.
+ *
+ * @param ip_addr  IP address
+ * @param mac_addr MAC address
+ */
+void atrans_update(addr32_t ip_addr, addr48_t mac_addr)
 {
+	list_t flush;
 	ethip_atrans_t *atrans;
 
-	fibril_mutex_lock(&atrans_list_lock);
+	list_initialize(&flush);
+
+	fibril_mutex_lock(&atrans_lock);
 	atrans = atrans_find(ip_addr);
 	if (atrans == NULL) {
-		fibril_mutex_unlock(&atrans_list_lock);
-		return ENOENT;
+		fibril_mutex_unlock(&atrans_lock);
+		return;
 	}
 
-	list_remove(&atrans->atrans_list);
-	fibril_mutex_unlock(&atrans_list_lock);
-	free(atrans);
+	if (atrans->state == ats_incomplete) {
+		atrans_confirm_locked(atrans, mac_addr, &flush);
+	} else if (!addr48_compare(atrans->mac_addr, mac_addr)) {
+		/* Address has moved. Use the new one, but verify it. */
+		addr48(mac_addr, atrans->mac_addr);
+		atrans->state = ats_stale;
+	}
 
-	return EOK;
+	fibril_mutex_unlock(&atrans_lock);
+
+	atrans_flush(&flush, mac_addr);
 }
 
-static errno_t atrans_lookup_locked(addr32_t ip_addr, addr48_t mac_addr)
+errno_t atrans_remove(addr32_t ip_addr)
 {
-	ethip_atrans_t *atrans = atrans_find(ip_addr);
-	if (atrans == NULL)
+	ethip_atrans_t *atrans;
+
+	fibril_mutex_lock(&atrans_lock);
+	atrans = atrans_find(ip_addr);
+	if (atrans == NULL) {
+		fibril_mutex_unlock(&atrans_lock);
 		return ENOENT;
+	}
+
+	hash_table_remove_item(&atrans_table, &atrans->atrans_link);
+	fibril_mutex_unlock(&atrans_lock);
 
-	addr48(atrans->mac_addr, mac_addr);
 	return EOK;
 }
 
 errno_t atrans_lookup(addr32_t ip_addr, addr48_t mac_addr)
 {
-	errno_t rc;
+	ethip_atrans_t *atrans;
+	errno_t rc = ENOENT;
 
-	fibril_mutex_lock(&atrans_list_lock);
-	rc = atrans_lookup_locked(ip_addr, mac_addr);
-	fibril_mutex_unlock(&atrans_list_lock);
+	fibril_mutex_lock(&atrans_lock);
+	atrans = atrans_find(ip_addr);
+	if (atrans != NULL && atrans->state != ats_incomplete) {
+		addr48(atrans->mac_addr, mac_addr);
+		rc = EOK;
+	}
 
+	fibril_mutex_unlock(&atrans_lock);
 	return rc;
 }
 
-static void atrans_lookup_timeout_handler(void *arg)
+/** Queue frame until the translation is resolved. */
+static errno_t atrans_enqueue(ethip_atrans_t *atrans, ethip_nic_t *nic,
+    void *data, size_t size, uint32_t flags, size_t mss)
 {
-	bool *timedout = (bool *)arg;
+	atrans_pending_t *pend;
 
-	fibril_mutex_lock(&atrans_list_lock);
-	*timedout = true;
-	fibril_mutex_unlock(&atrans_list_lock);
-	fibril_condvar_broadcast(&atrans_cv);
+	if (atrans->npending >= ATRANS_MAX_PENDING) {
+		/* Drop the oldest frame */
+		pend = list_get_instance(list_first(&atrans->pending),
+		    atrans_pending_t, link);
+		list_remove(&pend->link);
+		free(pend->data);
+		free(pend);
+		--atrans->npending;
+	}
+
+	pend = calloc(1, sizeof(atrans_pending_t));
+	if (pend == NULL)
+		return ENOMEM;
+
+	pend->nic = nic;
+	pend->data = data;
+	pend->size = size;
+	pend->flags = flags;
+	pend->mss = mss;
+
+	list_append(&pend->link, &atrans->pending);
+	++atrans->npending;
+	return EOK;
 }
 
-errno_t atrans_lookup_timeout(addr32_t ip_addr, usec_t timeout,
-    addr48_t mac_addr)
+/** Send frame to IP address.
+ *
+ * If the translation is known, the destination address in the frame is
+ * filled in and the frame is sent immediately. Otherwise the frame is
+ * queued and sent once the translation is resolved. Only one request is
+ * sent per resolution no matter how many frames are waiting for it.
+ *
+ * @param nic      NIC
+ * @param src_addr Source IP address (used in ARP requests)
+ * @param ip_addr  Destination IP address
+ * @param data     Encoded Ethernet frame, ownership is transferred
+ * @param size     Frame size
+ * @param flags    Offload requests (NIC_FF_xxx)
+ * @param mss      Maximum segment size if NIC_FF_TSO is requested
+ *
+ * @return EOK if the frame was sent or queued, error code otherwise
+ */
+errno_t atrans_send(ethip_nic_t *nic, addr32_t src_addr, addr32_t ip_addr,
+    void *data, size_t size, uint32_t flags, size_t mss)
 {
-	fibril_timer_t *t;
-	bool timedout;
+	ethip_atrans_t *atrans;
+	addr48_t mac_addr;
+	bool request = false;
+	bool probe = false;
 	errno_t rc;
 
-	t = fibril_timer_create(NULL);
-	if (t == NULL)
-		return ENOMEM;
+	fibril_mutex_lock(&atrans_lock);
+	atrans = atrans_find(ip_addr);
+
+	if (atrans != NULL && atrans->state != ats_incomplete) {
+		addr48(atrans->mac_addr, mac_addr);
+		atrans->idle = 0;
 
-	timedout = false;
-	fibril_timer_set(t, timeout, atrans_lookup_timeout_handler, &timedout);
+		if (atrans->state == ats_stale) {
+			atrans->state = ats_probe;
+			atrans->nic = nic;
+			atrans->src_addr = src_addr;
+			atrans->requests = 1;
+			probe = true;
+		}
 
-	fibril_mutex_lock(&atrans_list_lock);
+		fibril_mutex_unlock(&atrans_lock);
 
-	while ((rc = atrans_lookup_locked(ip_addr, mac_addr)) == ENOENT &&
-	    !timedout) {
-		fibril_condvar_wait(&atrans_cv, &atrans_list_lock);
+		if (probe)
+			(void) arp_send_request(nic, src_addr, ip_addr, mac_addr);
+
+		eth_pdu_set_dest(data, mac_addr);
+		rc = ethip_nic_send_offload(nic, data, size, flags, mss);
+		free(data);
+		return rc;
 	}
 
-	fibril_mutex_unlock(&atrans_list_lock);
-	(void) fibril_timer_clear(t);
-	fibril_timer_destroy(t);
+	if (atrans == NULL) {
+		atrans = atrans_create(nic, src_addr, ip_addr);
+		if (atrans == NULL) {
+			fibril_mutex_unlock(&atrans_lock);
+			free(data);
+			return ENOMEM;
+		}
 
-	return rc;
+		atrans->state = ats_incomplete;
+		atrans->requests = 1;
+		request = true;
+	}
+
+	rc = atrans_enqueue(atrans, nic, data, size, flags, mss);
+	fibril_mutex_unlock(&atrans_lock);
+
+	if (rc != EOK) {
+		free(data);
+		return rc;
+	}
+
+	if (request) {
+		(void) arp_send_request(nic, src_addr, ip_addr,
+		    addr48_broadcast);
+	}
+
+	return EOK;
+}
+
+/** Schedule ARP request to be sent by the aging timer. */
+static void atrans_request_add(ethip_atrans_t *atrans, const addr48_t dest)
+{
+	atrans_request_t *req = calloc(1, sizeof(atrans_request_t));
+	if (req == NULL)
+		return;
+
+	req->nic = atrans->nic;
+	req->src_addr = atrans->src_addr;
+	req->ip_addr = atrans->ip_addr;
+	addr48(dest, req->dest);
+	list_append(&req->link, &atrans_requests);
+	++atrans->requests;
+}
+
+/** Age a single translation table entry.
+ *
+ * @return Always @c true to continue iterating
+ */
+static bool atrans_age(ht_link_t *item, void *arg)
+{
+	ethip_atrans_t *atrans = hash_table_get_inst(item, ethip_atrans_t,
+	    atrans_link);
+
+	switch (atrans->state) {
+	case ats_incomplete:
+		if (atrans->requests < ATRANS_MAX_REQUESTS) {
+			atrans_request_add(atrans, addr48_broadcast);
+		} else {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Failed to resolve "
+			    "IPv4 address 0x%" PRIx32, atrans->ip_addr);
+			hash_table_remove_item(&atrans_table, item);
+		}
+		return true;
+	case ats_reachable:
+		if (++atrans->age >= ATRANS_REACHABLE_TICKS)
+			atrans->state = ats_stale;
+		break;
+	case ats_stale:
+		break;
+	case ats_probe:
+		if (atrans->requests < ATRANS_MAX_REQUESTS) {
+			atrans_request_add(atrans, atrans->mac_addr);
+		} else {
+			hash_table_remove_item(&atrans_table, item);
+			return true;
+		}
+		break;
+	}
+
+	if (++atrans->idle >= ATRANS_GC_TICKS && atrans->state == ats_stale)
+		hash_table_remove_item(&atrans_table, item);
+
+	return true;
+}
+
+/** Aging timer handler.
+ *
+ * Retransmits outstanding requests, expires confirmed translations
+ * and discards unused ones.
+ */
+static void atrans_timer_fun(void *arg)
+{
+	list_t requests;
+
+	list_initialize(&requests);
+
+	fibril_mutex_lock(&atrans_lock);
+	hash_table_apply(&atrans_table, atrans_age, NULL);
+	list_concat(&requests, &atrans_requests);
+	fibril_timer_set_locked(atrans_timer, ATRANS_TICK_USEC,
+	    atrans_timer_fun, NULL);
+	fibril_mutex_unlock(&atrans_lock);
+
+	list_foreach_safe(requests, cur, next) {
+		atrans_request_t *req = list_get_instance(cur, atrans_request_t,
+		    link);
+		list_remove(&req->link);
+		(void) arp_send_request(req->nic, req->src_addr, req->ip_addr,
+		    req->dest);
+		free(req);
+	}
 }
 
 /** @}
@@ -41,10 +41,12 @@
 #include <inet/iplink_srv.h>
 #include <io/log.h>
 #include <loc.h>
+#include <nic/nic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <task.h>
 #include "arp.h"
+#include "atrans.h"
 #include "ethip.h"
 #include "ethip_nic.h"
 #include "pdu.h"
@@ -61,6 +63,7 @@ static errno_t ethip_get_mac48(iplink_srv_t *srv, addr48_t *mac);
 static errno_t ethip_set_mac48(iplink_srv_t *srv, addr48_t *mac);
 static errno_t ethip_addr_add(iplink_srv_t *srv, inet_addr_t *addr);
 static errno_t ethip_addr_remove(iplink_srv_t *srv, inet_addr_t *addr);
+static errno_t ethip_get_offload(iplink_srv_t *srv, uint32_t *offload);
 
 static void ethip_client_conn(ipc_call_t *icall, void *arg);
 
@@ -73,14 +76,22 @@ static iplink_ops_t ethip_iplink_ops = {
 	.get_mac48 = ethip_get_mac48,
 	.set_mac48 = ethip_set_mac48,
 	.addr_add = ethip_addr_add,
-	.addr_remove = ethip_addr_remove
+	.addr_remove = ethip_addr_remove,
+	.get_offload = ethip_get_offload
 };
 
 static errno_t ethip_init(void)
 {
 	async_set_fallback_port_handler(ethip_client_conn, NULL);
 
-	errno_t rc = loc_server_register(NAME);
+	errno_t rc = atrans_init();
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed initializing address "
+		    "translation table.");
+		return rc;
+	}
+
+	rc = loc_server_register(NAME);
 	if (rc != EOK) {
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed registering server.");
 		return rc;
@@ -176,13 +187,8 @@ static errno_t ethip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
 	eth_frame_t frame;
 
-	errno_t rc = arp_translate(nic, sdu->src, sdu->dest, frame.dest);
-	if (rc != EOK) {
-		log_msg(LOG_DEFAULT, LVL_WARN, "Failed to look up IPv4 address 0x%"
-		    PRIx32, sdu->dest);
-		return rc;
-	}
-
+	/* Destination address is filled in by arp_send() */
+	addr48(addr48_broadcast, frame.dest);
 	addr48(nic->mac_addr, frame.src);
 	frame.etype_len = ETYPE_IP;
 	frame.data = sdu->data;
@@ -190,12 +196,21 @@ static errno_t ethip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 
 	void *data;
 	size_t size;
-	rc = eth_pdu_encode(&frame, &data, &size);
+	errno_t rc = eth_pdu_encode(&frame, &data, &size);
 	if (rc != EOK)
 		return rc;
 
-	rc = ethip_nic_send(nic, data, size);
-	free(data);
+	uint32_t flags = 0;
+	if ((sdu->flags & IPLINK_SDU_L4_CSUM) != 0)
+		flags |= NIC_FF_L4_CSUM;
+	if ((sdu->flags & IPLINK_SDU_TSO) != 0)
+		flags |= NIC_FF_TSO;
+
+	rc = arp_send(nic, sdu->src, sdu->dest, data, size, flags, sdu->mss);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed to send to IPv4 address "
+		    "0x%" PRIx32, sdu->dest);
+	}
 
 	return rc;
 }
@@ -225,7 +240,15 @@ static errno_t ethip_send6(iplink_srv_t *srv, iplink_sdu6_t *sdu)
 	return rc;
 }
 
-errno_t ethip_received(iplink_srv_t *srv, void *data, size_t size)
+/** Process frame received from the NIC
+ *
+ * @param srv   IP link service
+ * @param data  Frame data
+ * @param size  Frame size in bytes
+ * @param flags Results of receive offloads (NIC_FF_xxx)
+ */
+errno_t ethip_received(iplink_srv_t *srv, void *data, size_t size,
+    uint32_t flags)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_received(): srv=%p", srv);
 	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
@@ -249,6 +272,11 @@ errno_t ethip_received(iplink_srv_t *srv, void *data, size_t size)
 		log_msg(LOG_DEFAULT, LVL_DEBUG, " - construct SDU");
 		sdu.data = frame.data;
 		sdu.size = frame.size;
+		sdu.flags = 0;
+		if ((flags & NIC_FF_IPV4_CSUM_OK) != 0)
+			sdu.flags |= IPLINK_SDU_IPV4_CSUM_OK;
+		if ((flags & NIC_FF_L4_CSUM_OK) != 0)
+			sdu.flags |= IPLINK_SDU_L4_CSUM_OK;
 		log_msg(LOG_DEFAULT, LVL_DEBUG, " - call iplink_ev_recv");
 		rc = iplink_ev_recv(&nic->iplink, &sdu, ip_v4);
 		break;
@@ -256,6 +284,7 @@ errno_t ethip_received(iplink_srv_t *srv, void *data, size_t size)
 		log_msg(LOG_DEFAULT, LVL_DEBUG, " - construct SDU IPv6");
 		sdu.data = frame.data;
 		sdu.size = frame.size;
+		sdu.flags = 0;
 		log_msg(LOG_DEFAULT, LVL_DEBUG, " - call iplink_ev_recv");
 		rc = iplink_ev_recv(&nic->iplink, &sdu, ip_v6);
 		break;
@@ -309,6 +338,25 @@ static errno_t ethip_addr_remove(iplink_srv_t *srv, inet_addr_t *addr)
 	return ethip_nic_addr_remove(nic, addr);
 }
 
+static errno_t ethip_get_offload(iplink_srv_t *srv, uint32_t *offload)
+{
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_get_offload()");
+
+	ethip_nic_t *nic = (ethip_nic_t *) srv->arg;
+
+	*offload = 0;
+	if ((nic->offload & NIC_OFFLOAD_RX_IPV4_CSUM) != 0)
+		*offload |= IPLINK_OFFLOAD_RX_IPV4_CSUM;
+	if ((nic->offload & NIC_OFFLOAD_RX_L4_CSUM) != 0)
+		*offload |= IPLINK_OFFLOAD_RX_L4_CSUM;
+	if ((nic->offload & NIC_OFFLOAD_TX_L4_CSUM) != 0)
+		*offload |= IPLINK_OFFLOAD_TX_L4_CSUM;
+	if ((nic->offload & NIC_OFFLOAD_TSO4) != 0)
+		*offload |= IPLINK_OFFLOAD_TSO4;
+
+	return EOK;
+}
+
 int main(int argc, char *argv[])
 {
 	errno_t rc;
@@ -37,6 +37,7 @@
 #ifndef ETHIP_H_
 #define ETHIP_H_
 
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <async.h>
 #include <inet/iplink_srv.h>
@@ -62,6 +63,9 @@ typedef struct ethip_nic {
 	/** MAC address */
 	addr48_t mac_addr;
 
+	/** Offloads enabled on the NIC (NIC_OFFLOAD_xxx) */
+	uint32_t offload;
+
 	/**
 	 * List of IP addresses configured on this link
 	 * (of the type ethip_link_addr_t)
@@ -108,15 +112,43 @@ typedef struct {
 	addr32_t target_proto_addr;
 } arp_eth_packet_t;
 
+/** Address translation entry state */
+typedef enum {
+	/** Resolution in progress, outgoing frames are queued */
+	ats_incomplete,
+	/** Translation has been confirmed recently */
+	ats_reachable,
+	/** Translation is usable, but has not been confirmed recently */
+	ats_stale,
+	/** Stale translation is being confirmed using unicast requests */
+	ats_probe
+} ethip_atrans_state_t;
+
 /** Address translation table element */
 typedef struct {
-	link_t atrans_list;
+	/** Link to address translation table */
+	ht_link_t atrans_link;
 	addr32_t ip_addr;
 	addr48_t mac_addr;
+	ethip_atrans_state_t state;
+	/** Ticks since the translation was last confirmed */
+	unsigned age;
+	/** Ticks since the translation was last used */
+	unsigned idle;
+	/** Number of requests sent during current resolution or probe */
+	unsigned requests;
+	/** NIC used for sending requests */
+	ethip_nic_t *nic;
+	/** Source address used for sending requests */
+	addr32_t src_addr;
+	/** Frames waiting for resolution to complete */
+	list_t pending;
+	/** Number of frames in @c pending */
+	size_t npending;
 } ethip_atrans_t;
 
 extern errno_t ethip_iplink_init(ethip_nic_t *);
-extern errno_t ethip_received(iplink_srv_t *, void *, size_t);
+extern errno_t ethip_received(iplink_srv_t *, void *, size_t, uint32_t);
 
 #endif
 
@@ -46,10 +46,38 @@
 #include <nic_iface.h>
 #include <stdlib.h>
 #include <mem.h>
+#include "arp.h"
 #include "ethip.h"
 #include "ethip_nic.h"
 #include "pdu.h"
 
+/** Enable all offloads supported by the NIC
+ *
+ * Failure is not fatal, the NIC is then used without offloads.
+ */
+static void ethip_nic_offload_init(ethip_nic_t *nic)
+{
+	uint32_t supported;
+	uint32_t active;
+
+	nic->offload = 0;
+
+	errno_t rc = nic_offload_probe(nic->sess, &supported, &active);
+	if (rc != EOK)
+		return;
+
+	rc = nic_offload_set(nic->sess, supported, supported);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_WARN, "Failed enabling offloads "
+		    "on '%s'.", nic->svc_name);
+		return;
+	}
+
+	nic->offload = supported;
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "Offloads on '%s': 0x%" PRIx32,
+	    nic->svc_name, nic->offload);
+}
+
 static errno_t ethip_nic_open(service_id_t sid);
 static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg);
 
@@ -181,6 +209,8 @@ static errno_t ethip_nic_open(service_id_t sid)
 	list_append(&nic->link, &ethip_nic_list);
 	in_list = true;
 
+	ethip_nic_offload_init(nic);
+
 	rc = ethip_iplink_init(nic);
 	if (rc != EOK)
 		goto error;
@@ -252,6 +282,13 @@ static void ethip_nic_addr_changed(ethip_nic_t *nic, ipc_call_t *call)
 		return;
 	}
 
+	/* Let neighbours know about the new address */
+	list_foreach(nic->addr_list, link, ethip_link_addr_t, laddr) {
+		addr32_t v4;
+		if (inet_addr_get(&laddr->addr, &v4, NULL) == ip_v4)
+			(void) arp_announce(nic, v4);
+	}
+
 	free(addr);
 	async_answer_0(call, EOK);
 }
@@ -274,7 +311,7 @@ static void ethip_nic_received(ethip_nic_t *nic, ipc_call_t *call)
 	    size);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "call ethip_received");
-	rc = ethip_received(&nic->iplink, data, size);
+	rc = ethip_received(&nic->iplink, data, size, ipc_get_arg1(call));
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "free data");
 	free(data);
 
@@ -358,6 +395,30 @@ errno_t ethip_nic_send(ethip_nic_t *nic, void *data, size_t size)
 	return rc;
 }
 
+/** Send frame requesting checksum or segmentation offload
+ *
+ * @param nic   NIC
+ * @param data  Frame data
+ * @param size  Frame size in bytes
+ * @param flags Offload requests (NIC_FF_xxx)
+ * @param mss   Maximum segment size if NIC_FF_TSO is requested
+ */
+errno_t ethip_nic_send_offload(ethip_nic_t *nic, void *data, size_t size,
+    uint32_t flags, size_t mss)
+{
+	errno_t rc;
+
+	if (flags == 0)
+		return ethip_nic_send(nic, data, size);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_send_offload(size=%zu, "
+	    "flags=0x%" PRIx32 ")", size, flags);
+	rc = nic_send_frame_offload(nic->sess, data, size, flags, mss);
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "nic_send_frame_offload -> %s",
+	    str_error_name(rc));
+	return rc;
+}
+
 /** Setup accepted multicast addresses
  *
  * Currently the set of accepted multicast addresses is
@@ -438,6 +499,10 @@ errno_t ethip_nic_addr_add(ethip_nic_t *nic, inet_addr_t *addr)
 
 	list_append(&laddr->link, &nic->addr_list);
 
+	addr32_t v4;
+	if (inet_addr_get(addr, &v4, NULL) == ip_v4)
+		(void) arp_announce(nic, v4);
+
 	return ethip_nic_setup_multicast(nic);
 }
 
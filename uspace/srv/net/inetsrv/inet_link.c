@@ -46,6 +46,7 @@
 #include "addrobj.h"
 #include "inetsrv.h"
 #include "inet_link.h"
+#include "inet_std.h"
 #include "pdu.h"
 
 static bool first_link = true;
@@ -95,7 +96,7 @@ static errno_t inet_iplink_recv(iplink_t *iplink, iplink_recv_sdu_t *sdu, ip_ver
 	switch (ver) {
 	case ip_v4:
 		rc = inet_pdu_decode(sdu->data, sdu->size, ilink->svc_id,
-		    &packet);
+		    sdu->flags, &packet);
 		break;
 	case ip_v6:
 		rc = inet_pdu_decode6(sdu->data, sdu->size, ilink->svc_id,
@@ -204,6 +205,10 @@ errno_t inet_link_open(service_id_t sid)
 	rc = iplink_get_mac48(ilink->iplink, &ilink->mac);
 	ilink->mac_valid = (rc == EOK);
 
+	rc = iplink_get_offload(ilink->iplink, &ilink->offload);
+	if (rc != EOK)
+		ilink->offload = 0;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "Opened IP link '%s'", ilink->svc_name);
 
 	fibril_mutex_lock(&inet_links_lock);
@@ -296,6 +301,77 @@ error:
 	return rc;
 }
 
+/** Complete TCP or UDP checksum in software.
+ *
+ * The checksum field must contain the pseudo-header sum
+ * (see INET_DGRAM_L4_CSUM).
+ *
+ * @param proto Protocol
+ * @param data  TCP or UDP segment, modified in place
+ * @param size  Size of the segment in bytes
+ */
+static void inet_link_csum_complete(uint8_t proto, void *data, size_t size)
+{
+	uint8_t *bdata = (uint8_t *) data;
+	size_t csum_offs;
+
+	switch (proto) {
+	case IP_PROTO_TCP:
+		csum_offs = TCP_CHECKSUM_OFFS;
+		break;
+	case IP_PROTO_UDP:
+		csum_offs = UDP_CHECKSUM_OFFS;
+		break;
+	default:
+		return;
+	}
+
+	if (size < csum_offs + sizeof(uint16_t))
+		return;
+
+	uint16_t csum = inet_checksum_calc(INET_CHECKSUM_INIT, data, size);
+
+	/* Zero means no checksum in UDP */
+	if (proto == IP_PROTO_UDP && csum == 0)
+		csum = 0xffff;
+
+	bdata[csum_offs] = csum >> 8;
+	bdata[csum_offs + 1] = csum & 0xff;
+}
+
+/** Determine maximum segment size for segmentation offload.
+ *
+ * @param ilink Internet link
+ * @param dgram Datagram containing TCP segment
+ * @param rmss  Place to store maximum segment size
+ *
+ * @return @c true if the link should segment the datagram
+ */
+static bool inet_link_tso_mss(inet_link_t *ilink, inet_dgram_t *dgram,
+    size_t *rmss)
+{
+	uint8_t *bdata = (uint8_t *) dgram->data;
+
+	if ((ilink->offload & IPLINK_OFFLOAD_TSO4) == 0)
+		return false;
+
+	/* Fits in one frame or not in one IPv4 datagram */
+	if (sizeof(ip_header_t) + dgram->size <= ilink->def_mtu ||
+	    sizeof(ip_header_t) + dgram->size > UINT16_MAX)
+		return false;
+
+	if (dgram->size < TCP_HEADER_MIN)
+		return false;
+
+	size_t hdr_size = sizeof(uint32_t) * (bdata[TCP_DOFFS_OFFS] >> 4);
+	if (hdr_size < TCP_HEADER_MIN ||
+	    sizeof(ip_header_t) + hdr_size >= ilink->def_mtu)
+		return false;
+
+	*rmss = ilink->def_mtu - sizeof(ip_header_t) - hdr_size;
+	return true;
+}
+
 /** Send IPv4 datagram over Internet link
  *
  * @param ilink Internet link
@@ -353,12 +429,29 @@ errno_t inet_link_send_dgram(inet_link_t *ilink, addr32_t lsrc, addr32_t ldest,
 
 	errno_t rc;
 	size_t offs = 0;
+	size_t mtu = ilink->def_mtu;
+
+	sdu.flags = 0;
+	sdu.mss = 0;
+
+	if ((dgram->flags & INET_DGRAM_TSO) != 0 && proto == IP_PROTO_TCP &&
+	    inet_link_tso_mss(ilink, dgram, &sdu.mss)) {
+		/* Let the link split the segment instead of fragmenting it */
+		sdu.flags = IPLINK_SDU_TSO | IPLINK_SDU_L4_CSUM;
+		mtu = sizeof(ip_header_t) + packet.size;
+	} else if ((dgram->flags & (INET_DGRAM_L4_CSUM | INET_DGRAM_TSO)) != 0) {
+		if ((ilink->offload & IPLINK_OFFLOAD_TX_L4_CSUM) != 0 &&
+		    sizeof(ip_header_t) + packet.size <= mtu)
+			sdu.flags = IPLINK_SDU_L4_CSUM;
+		else
+			inet_link_csum_complete(proto, dgram->data, dgram->size);
+	}
 
 	do {
 		/* Encode one fragment */
 
 		size_t roffs;
-		rc = inet_pdu_encode(&packet, src_v4, dest_v4, offs, ilink->def_mtu,
+		rc = inet_pdu_encode(&packet, src_v4, dest_v4, offs, mtu,
 		    &sdu.data, &sdu.size, &roffs);
 		if (rc != EOK)
 			return rc;
@@ -424,6 +517,10 @@ errno_t inet_link_send_dgram6(inet_link_t *ilink, addr48_t ldest,
 	packet.data = dgram->data;
 	packet.size = dgram->size;
 
+	/* IPv6 links do not offload checksums */
+	if ((dgram->flags & (INET_DGRAM_L4_CSUM | INET_DGRAM_TSO)) != 0)
+		inet_link_csum_complete(proto, dgram->data, dgram->size);
+
 	errno_t rc;
 	size_t offs = 0;
 
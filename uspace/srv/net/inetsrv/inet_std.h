@@ -41,6 +41,18 @@
 
 #define IP6_NEXT_FRAGMENT  44
 
+#define IP_PROTO_TCP  6
+#define IP_PROTO_UDP  17
+
+/** Offset of Checksum field in TCP header */
+#define TCP_CHECKSUM_OFFS  16
+/** Offset of Data Offset field in TCP header */
+#define TCP_DOFFS_OFFS     12
+/** Minimum size of TCP header */
+#define TCP_HEADER_MIN     20
+/** Offset of Checksum field in UDP header */
+#define UDP_CHECKSUM_OFFS  6
+
 /** IPv4 Datagram header (fixed part) */
 typedef struct {
 	/** Version, Internet Header Length */
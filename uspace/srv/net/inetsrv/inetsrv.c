@@ -57,6 +57,7 @@
 #include "inetcfg.h"
 #include "inetping.h"
 #include "inet_link.h"
+#include "ntrans.h"
 #include "reass.h"
 #include "sroute.h"
 
@@ -87,8 +88,16 @@ static errno_t inet_init(void)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_init()");
 
+	errno_t rc = ntrans_init();
+	if (rc != EOK)
+		return rc;
+
+	rc = inet_reass_init();
+	if (rc != EOK)
+		return rc;
+
 	port_id_t port;
-	errno_t rc = async_create_port(INTERFACE_INET,
+	rc = async_create_port(INTERFACE_INET,
 	    inet_default_conn, NULL, &port);
 	if (rc != EOK)
 		return rc;
@@ -296,6 +305,9 @@ static void inet_send_srv(inet_client_t *client, ipc_call_t *icall)
 	uint8_t ttl = ipc_get_arg3(icall);
 	int df = ipc_get_arg4(icall);
 
+	/* Clients may only request offloads */
+	dgram.flags = ipc_get_arg5(icall) & (INET_DGRAM_L4_CSUM | INET_DGRAM_TSO);
+
 	ipc_call_t call;
 	size_t size;
 	if (!async_data_write_receive(&call, &size)) {
@@ -449,8 +461,8 @@ errno_t inet_ev_recv(inet_client_t *client, inet_dgram_t *dgram)
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_ev_recv: iplink=%zu",
 	    dgram->iplink);
 
-	aid_t req = async_send_2(exch, INET_EV_RECV, dgram->tos,
-	    dgram->iplink, &answer);
+	aid_t req = async_send_3(exch, INET_EV_RECV, dgram->tos,
+	    dgram->iplink, dgram->flags, &answer);
 
 	errno_t rc = async_data_write_start(exch, &dgram->src, sizeof(inet_addr_t));
 	if (rc != EOK) {
@@ -525,6 +537,9 @@ errno_t inet_recv_packet(inet_packet_t *packet)
 			dgram.tos = packet->tos;
 			dgram.data = packet->data;
 			dgram.size = packet->size;
+			dgram.flags = 0;
+			if ((packet->flags & IPLINK_SDU_L4_CSUM_OK) != 0)
+				dgram.flags |= INET_DGRAM_L4_CSUM_OK;
 
 			return inet_recv_dgram_local(&dgram, packet->proto);
 		} else {
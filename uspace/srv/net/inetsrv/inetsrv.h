@@ -99,6 +99,8 @@ typedef struct {
 	void *data;
 	/** Packet data size in bytes */
 	size_t size;
+	/** Receive offload results (IPLINK_SDU_xxx) */
+	uint32_t flags;
 } inet_packet_t;
 
 typedef struct {
@@ -110,6 +112,8 @@ typedef struct {
 	size_t def_mtu;
 	addr48_t mac;
 	bool mac_valid;
+	/** Offloads supported by the link (IPLINK_OFFLOAD_xxx) */
+	uint32_t offload;
 } inet_link_t;
 
 typedef struct {
@@ -44,9 +44,6 @@
 #include "inet_link.h"
 #include "ndp.h"
 
-/** Time to wait for NDP reply in microseconds */
-#define NDP_REQUEST_TIMEOUT  (3 * 1000 * 1000)
-
 static addr128_t solicited_node_ip =
     { 0xff, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01, 0xff, 0, 0, 0 };
 
@@ -106,8 +103,8 @@ errno_t ndp_received(inet_dgram_t *dgram)
 	case ICMPV6_NEIGHBOUR_SOLICITATION:
 		laddr = inet_addrobj_find(&target, iaf_addr);
 		if (laddr != NULL) {
-			rc = ntrans_add(packet.sender_proto_addr,
-			    packet.sender_hw_addr);
+			rc = ntrans_add(laddr->ilink, packet.target_proto_addr,
+			    packet.sender_proto_addr, packet.sender_hw_addr);
 			if (rc != EOK)
 				return rc;
 
@@ -125,10 +122,15 @@ errno_t ndp_received(inet_dgram_t *dgram)
 		break;
 	case ICMPV6_NEIGHBOUR_ADVERTISEMENT:
 		laddr = inet_addrobj_find(&dgram->dest, iaf_addr);
-		if (laddr != NULL)
-			return ntrans_add(packet.sender_proto_addr,
-			    packet.sender_hw_addr);
+		if (laddr != NULL) {
+			addr128_t laddr_v6;
+			inet_addr_get(&dgram->dest, NULL, &laddr_v6);
+			return ntrans_add(laddr->ilink, laddr_v6,
+			    packet.sender_proto_addr, packet.sender_hw_addr);
+		}
 
+		/* Unsolicited advertisement, refresh existing entry only */
+		ntrans_update(packet.sender_proto_addr, packet.sender_hw_addr);
 		break;
 	case ICMPV6_ROUTER_ADVERTISEMENT:
 		return ndp_router_advertisement(dgram, &sender);
@@ -139,6 +141,38 @@ errno_t ndp_received(inet_dgram_t *dgram)
 	return EOK;
 }
 
+/** Send neighbour solicitation
+ *
+ * @param ilink    Network interface
+ * @param src_addr Source IPv6 address
+ * @param ip_addr  IPv6 address to be resolved
+ * @param mac_addr MAC address for unicast probe or NULL to send
+ *                 the solicitation to the solicited-node multicast address
+ *
+ * @return EOK on success
+ *
+ */
+errno_t ndp_solicit(inet_link_t *ilink, addr128_t src_addr, addr128_t ip_addr,
+    addr48_t mac_addr)
+{
+	ndp_packet_t packet;
+
+	packet.opcode = ICMPV6_NEIGHBOUR_SOLICITATION;
+	addr48(ilink->mac, packet.sender_hw_addr);
+	addr128(src_addr, packet.sender_proto_addr);
+	addr128(ip_addr, packet.solicited_ip);
+
+	if (mac_addr != NULL) {
+		addr48(mac_addr, packet.target_hw_addr);
+		addr128(ip_addr, packet.target_proto_addr);
+	} else {
+		addr48_solicited_node(ip_addr, packet.target_hw_addr);
+		ndp_solicited_node_ip(ip_addr, packet.target_proto_addr);
+	}
+
+	return ndp_send_packet(ilink, &packet);
+}
+
 /** Translate IPv6 to MAC address
  *
  * @param src  Source IPv6 address
@@ -159,24 +193,8 @@ errno_t ndp_translate(addr128_t src_addr, addr128_t ip_addr, addr48_t mac_addr,
 		return EOK;
 	}
 
-	errno_t rc = ntrans_lookup(ip_addr, mac_addr);
-	if (rc == EOK)
-		return EOK;
-
-	ndp_packet_t packet;
-
-	packet.opcode = ICMPV6_NEIGHBOUR_SOLICITATION;
-	addr48(ilink->mac, packet.sender_hw_addr);
-	addr128(src_addr, packet.sender_proto_addr);
-	addr128(ip_addr, packet.solicited_ip);
-	addr48_solicited_node(ip_addr, packet.target_hw_addr);
-	ndp_solicited_node_ip(ip_addr, packet.target_proto_addr);
-
-	rc = ndp_send_packet(ilink, &packet);
-	if (rc != EOK)
-		return rc;
-
-	(void) ntrans_wait_timeout(NDP_REQUEST_TIMEOUT);
-
-	return ntrans_lookup(ip_addr, mac_addr);
+	return ntrans_resolve(ilink, src_addr, ip_addr, mac_addr);
 }
+
+/** @}
+ */
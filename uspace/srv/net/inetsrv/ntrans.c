@@ -34,17 +34,117 @@
  * @brief
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <inet/iplink_srv.h>
+#include <io/log.h>
+#include <mem.h>
 #include <stdlib.h>
+#include "ndp.h"
 #include "ntrans.h"
 
-/** Address translation list (of inet_ntrans_t) */
-static FIBRIL_MUTEX_INITIALIZE(ntrans_list_lock);
-static LIST_INITIALIZE(ntrans_list);
-static FIBRIL_CONDVAR_INITIALIZE(ntrans_cv);
+/** Aging timer period in microseconds */
+#define NTRANS_TICK_USEC  (1000 * 1000)
+
+/** Ticks after which a confirmed translation becomes stale */
+#define NTRANS_REACHABLE_TICKS  30
+
+/** Ticks after which an unused stale translation is discarded */
+#define NTRANS_GC_TICKS  600
+
+/** Number of solicitations sent before resolution is given up */
+#define NTRANS_MAX_REQUESTS  3
+
+/** Neighbour solicitation to send after the table lock is released */
+typedef struct {
+	link_t link;
+	inet_link_t *ilink;
+	addr128_t src_addr;
+	addr128_t ip_addr;
+	/** Send unicast probe to @c mac_addr instead of multicast */
+	bool unicast;
+	addr48_t mac_addr;
+} ntrans_request_t;
+
+/** Address translation table (of inet_ntrans_t) */
+static FIBRIL_MUTEX_INITIALIZE(ntrans_lock);
+static hash_table_t ntrans_table;
+static fibril_timer_t *ntrans_timer;
+
+/** Solicitations collected by the aging timer (of ntrans_request_t) */
+static LIST_INITIALIZE(ntrans_requests);
+
+static void ntrans_timer_fun(void *);
+
+static size_t ntrans_addr_hash(const addr128_t ip_addr)
+{
+	size_t hash = 0;
+
+	for (size_t i = 0; i < 16; i += 4) {
+		hash = hash_combine(hash, ((uint32_t) ip_addr[i] << 24) |
+		    ((uint32_t) ip_addr[i + 1] << 16) |
+		    ((uint32_t) ip_addr[i + 2] << 8) | ip_addr[i + 3]);
+	}
+
+	return hash;
+}
+
+static size_t ntrans_key_hash(const void *key)
+{
+	return ntrans_addr_hash(key);
+}
+
+static size_t ntrans_hash(const ht_link_t *item)
+{
+	inet_ntrans_t *ntrans = hash_table_get_inst(item, inet_ntrans_t,
+	    ntrans_link);
+	return ntrans_addr_hash(ntrans->ip_addr);
+}
+
+static bool ntrans_key_equal(const void *key, const ht_link_t *item)
+{
+	inet_ntrans_t *ntrans = hash_table_get_inst(item, inet_ntrans_t,
+	    ntrans_link);
+	return addr128_compare(ntrans->ip_addr, key);
+}
+
+static void ntrans_remove_callback(ht_link_t *item)
+{
+	free(hash_table_get_inst(item, inet_ntrans_t, ntrans_link));
+}
+
+static hash_table_ops_t ntrans_ops = {
+	.hash = ntrans_hash,
+	.key_hash = ntrans_key_hash,
+	.key_equal = ntrans_key_equal,
+	.equal = NULL,
+	.remove_callback = ntrans_remove_callback
+};
+
+/** Initialize address translation table
+ *
+ * @return EOK on success
+ * @return ENOMEM if not enough memory
+ *
+ */
+errno_t ntrans_init(void)
+{
+	if (!hash_table_create(&ntrans_table, 0, 0, &ntrans_ops))
+		return ENOMEM;
+
+	ntrans_timer = fibril_timer_create(&ntrans_lock);
+	if (ntrans_timer == NULL) {
+		hash_table_destroy(&ntrans_table);
+		return ENOMEM;
+	}
+
+	fibril_timer_set(ntrans_timer, NTRANS_TICK_USEC, ntrans_timer_fun,
+	    NULL);
+	return EOK;
+}
 
 /** Look for address in translation table
  *
@@ -55,16 +155,60 @@ static FIBRIL_CONDVAR_INITIALIZE(ntrans_cv);
  */
 static inet_ntrans_t *ntrans_find(addr128_t ip_addr)
 {
-	list_foreach(ntrans_list, ntrans_list, inet_ntrans_t, ntrans) {
-		if (addr128_compare(ntrans->ip_addr, ip_addr))
-			return ntrans;
+	ht_link_t *link = hash_table_find(&ntrans_table, ip_addr);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, inet_ntrans_t, ntrans_link);
+}
+
+/** Create translation table entry
+ *
+ * @return New entry on success
+ * @return NULL if not enough memory
+ */
+static inet_ntrans_t *ntrans_create(inet_link_t *ilink, addr128_t src_addr,
+    addr128_t ip_addr)
+{
+	inet_ntrans_t *ntrans = calloc(1, sizeof(inet_ntrans_t));
+	if (ntrans == NULL)
+		return NULL;
+
+	addr128(ip_addr, ntrans->ip_addr);
+	addr128(src_addr, ntrans->src_addr);
+	ntrans->ilink = ilink;
+	fibril_condvar_initialize(&ntrans->cv);
+	hash_table_insert(&ntrans_table, &ntrans->ntrans_link);
+
+	return ntrans;
+}
+
+/** Mark translation as confirmed and wake up waiting fibrils */
+static void ntrans_confirm_locked(inet_ntrans_t *ntrans, addr48_t mac_addr)
+{
+	addr48(mac_addr, ntrans->mac_addr);
+	ntrans->state = nts_reachable;
+	ntrans->age = 0;
+	ntrans->requests = 0;
+	fibril_condvar_broadcast(&ntrans->cv);
+}
+
+/** Give up resolution, removing the entry once nobody waits for it */
+static void ntrans_fail_locked(inet_ntrans_t *ntrans)
+{
+	if (ntrans->waiters == 0) {
+		hash_table_remove_item(&ntrans_table, &ntrans->ntrans_link);
+		return;
 	}
 
-	return NULL;
+	ntrans->state = nts_failed;
+	fibril_condvar_broadcast(&ntrans->cv);
 }
 
-/** Add entry to translation table
+/** Add confirmed entry to translation table
  *
+ * @param ilink    Link the confirmation was received on
+ * @param src_addr Our IPv6 address on that link
  * @param ip_addr  IPv6 address of the new entry
  * @param mac_addr MAC address of the new entry
  *
@@ -72,32 +216,57 @@ static inet_ntrans_t *ntrans_find(addr128_t ip_addr)
  * @return ENOMEM if not enough memory
  *
  */
-errno_t ntrans_add(addr128_t ip_addr, addr48_t mac_addr)
+errno_t ntrans_add(inet_link_t *ilink, addr128_t src_addr, addr128_t ip_addr,
+    addr48_t mac_addr)
 {
 	inet_ntrans_t *ntrans;
-	inet_ntrans_t *prev;
 
-	ntrans = calloc(1, sizeof(inet_ntrans_t));
-	if (ntrans == NULL)
-		return ENOMEM;
-
-	addr128(ip_addr, ntrans->ip_addr);
-	addr48(mac_addr, ntrans->mac_addr);
-
-	fibril_mutex_lock(&ntrans_list_lock);
-	prev = ntrans_find(ip_addr);
-	if (prev != NULL) {
-		list_remove(&prev->ntrans_list);
-		free(prev);
+	fibril_mutex_lock(&ntrans_lock);
+	ntrans = ntrans_find(ip_addr);
+	if (ntrans == NULL) {
+		ntrans = ntrans_create(ilink, src_addr, ip_addr);
+		if (ntrans == NULL) {
+			fibril_mutex_unlock(&ntrans_lock);
+			return ENOMEM;
+		}
 	}
 
-	list_append(&ntrans->ntrans_list, &ntrans_list);
-	fibril_mutex_unlock(&ntrans_list_lock);
-	fibril_condvar_broadcast(&ntrans_cv);
+	ntrans->ilink = ilink;
+	addr128(src_addr, ntrans->src_addr);
+	ntrans_confirm_locked(ntrans, mac_addr);
+	fibril_mutex_unlock(&ntrans_lock);
 
 	return EOK;
 }
 
+/** Update existing entry in translation table
+ *
+ * Used for unsolicited advertisements. Does not create new entries.
+ *
+ * @param ip_addr  IPv6 address of the entry
+ * @param mac_addr MAC address advertised for the entry
+ *
+ */
+void ntrans_update(addr128_t ip_addr, addr48_t mac_addr)
+{
+	inet_ntrans_t *ntrans;
+
+	fibril_mutex_lock(&ntrans_lock);
+	ntrans = ntrans_find(ip_addr);
+	if (ntrans != NULL) {
+		if (ntrans->state == nts_incomplete ||
+		    ntrans->state == nts_failed) {
+			ntrans_confirm_locked(ntrans, mac_addr);
+		} else if (!addr48_compare(ntrans->mac_addr, mac_addr)) {
+			/* Neighbour has moved. Use new address, but verify it. */
+			addr48(mac_addr, ntrans->mac_addr);
+			ntrans->state = nts_stale;
+		}
+	}
+
+	fibril_mutex_unlock(&ntrans_lock);
+}
+
 /** Remove entry from translation table
  *
  * @param ip_addr IPv6 address of the entry to be removed
@@ -110,16 +279,15 @@ errno_t ntrans_remove(addr128_t ip_addr)
 {
 	inet_ntrans_t *ntrans;
 
-	fibril_mutex_lock(&ntrans_list_lock);
+	fibril_mutex_lock(&ntrans_lock);
 	ntrans = ntrans_find(ip_addr);
 	if (ntrans == NULL) {
-		fibril_mutex_unlock(&ntrans_list_lock);
+		fibril_mutex_unlock(&ntrans_lock);
 		return ENOENT;
 	}
 
-	list_remove(&ntrans->ntrans_list);
-	fibril_mutex_unlock(&ntrans_list_lock);
-	free(ntrans);
+	ntrans_fail_locked(ntrans);
+	fibril_mutex_unlock(&ntrans_lock);
 
 	return EOK;
 }
@@ -135,35 +303,197 @@ errno_t ntrans_remove(addr128_t ip_addr)
  */
 errno_t ntrans_lookup(addr128_t ip_addr, addr48_t mac_addr)
 {
-	fibril_mutex_lock(&ntrans_list_lock);
+	errno_t rc = ENOENT;
+
+	fibril_mutex_lock(&ntrans_lock);
 	inet_ntrans_t *ntrans = ntrans_find(ip_addr);
-	if (ntrans == NULL) {
-		fibril_mutex_unlock(&ntrans_list_lock);
-		return ENOENT;
+	if (ntrans != NULL && ntrans->state != nts_incomplete &&
+	    ntrans->state != nts_failed) {
+		addr48(ntrans->mac_addr, mac_addr);
+		rc = EOK;
 	}
 
-	fibril_mutex_unlock(&ntrans_list_lock);
-	addr48(ntrans->mac_addr, mac_addr);
-	return EOK;
+	fibril_mutex_unlock(&ntrans_lock);
+	return rc;
 }
 
-/** Wait on translation table CV for some time
+/** Resolve IPv6 address to MAC address
  *
- * @param timeout Timeout in microseconds
+ * If the translation is not known, a neighbour solicitation is sent and
+ * the caller is blocked until the neighbour answers or resolution is
+ * given up. Concurrent callers resolving the same address share a single
+ * solicitation and are all released once the advertisement arrives.
  *
- * @return EOK if woken up by another fibril
- * @return ETIMEOUT if timed out
+ * @param ilink    Link to resolve on
+ * @param src_addr Source IPv6 address for solicitations
+ * @param ip_addr  IPv6 address to be translated
+ * @param mac_addr MAC address to be assigned
+ *
+ * @return EOK on success
+ * @return ENOENT when translation failed
+ * @return ENOMEM if not enough memory
  *
  */
-errno_t ntrans_wait_timeout(usec_t timeout)
+errno_t ntrans_resolve(inet_link_t *ilink, addr128_t src_addr,
+    addr128_t ip_addr, addr48_t mac_addr)
 {
-	fibril_mutex_lock(&ntrans_list_lock);
-	errno_t rc = fibril_condvar_wait_timeout(&ntrans_cv, &ntrans_list_lock,
-	    timeout);
-	fibril_mutex_unlock(&ntrans_list_lock);
+	inet_ntrans_t *ntrans;
+	bool request = false;
+	errno_t rc;
+
+	fibril_mutex_lock(&ntrans_lock);
+	ntrans = ntrans_find(ip_addr);
 
+	if (ntrans != NULL && ntrans->state != nts_incomplete &&
+	    ntrans->state != nts_failed) {
+		addr48(ntrans->mac_addr, mac_addr);
+		ntrans->idle = 0;
+
+		if (ntrans->state == nts_stale) {
+			ntrans->state = nts_probe;
+			ntrans->ilink = ilink;
+			addr128(src_addr, ntrans->src_addr);
+			ntrans->requests = 1;
+			request = true;
+		}
+
+		fibril_mutex_unlock(&ntrans_lock);
+
+		if (request)
+			(void) ndp_solicit(ilink, src_addr, ip_addr, mac_addr);
+
+		return EOK;
+	}
+
+	if (ntrans == NULL) {
+		ntrans = ntrans_create(ilink, src_addr, ip_addr);
+		if (ntrans == NULL) {
+			fibril_mutex_unlock(&ntrans_lock);
+			return ENOMEM;
+		}
+	}
+
+	if (ntrans->state != nts_incomplete || ntrans->requests == 0) {
+		/* Start new resolution */
+		ntrans->state = nts_incomplete;
+		ntrans->ilink = ilink;
+		addr128(src_addr, ntrans->src_addr);
+		ntrans->requests = 1;
+		request = true;
+	}
+
+	ntrans->waiters++;
+	fibril_mutex_unlock(&ntrans_lock);
+
+	if (request)
+		(void) ndp_solicit(ilink, src_addr, ip_addr, NULL);
+
+	fibril_mutex_lock(&ntrans_lock);
+
+	while (ntrans->state == nts_incomplete)
+		fibril_condvar_wait(&ntrans->cv, &ntrans_lock);
+
+	ntrans->waiters--;
+
+	if (ntrans->state == nts_failed) {
+		rc = ENOENT;
+		if (ntrans->waiters == 0) {
+			hash_table_remove_item(&ntrans_table,
+			    &ntrans->ntrans_link);
+		}
+	} else {
+		addr48(ntrans->mac_addr, mac_addr);
+		ntrans->idle = 0;
+		rc = EOK;
+	}
+
+	fibril_mutex_unlock(&ntrans_lock);
 	return rc;
 }
 
+/** Schedule solicitation to be sent by the aging timer */
+static void ntrans_request_add(inet_ntrans_t *ntrans, bool unicast)
+{
+	ntrans_request_t *req = calloc(1, sizeof(ntrans_request_t));
+	if (req == NULL)
+		return;
+
+	req->ilink = ntrans->ilink;
+	addr128(ntrans->src_addr, req->src_addr);
+	addr128(ntrans->ip_addr, req->ip_addr);
+	req->unicast = unicast;
+	addr48(ntrans->mac_addr, req->mac_addr);
+	list_append(&req->link, &ntrans_requests);
+	ntrans->requests++;
+}
+
+/** Age a single translation table entry
+ *
+ * @return Always @c true to continue iterating
+ */
+static bool ntrans_age(ht_link_t *item, void *arg)
+{
+	inet_ntrans_t *ntrans = hash_table_get_inst(item, inet_ntrans_t,
+	    ntrans_link);
+
+	switch (ntrans->state) {
+	case nts_incomplete:
+		if (ntrans->requests < NTRANS_MAX_REQUESTS)
+			ntrans_request_add(ntrans, false);
+		else
+			ntrans_fail_locked(ntrans);
+		return true;
+	case nts_failed:
+		return true;
+	case nts_reachable:
+		if (++ntrans->age >= NTRANS_REACHABLE_TICKS)
+			ntrans->state = nts_stale;
+		break;
+	case nts_stale:
+		break;
+	case nts_probe:
+		if (ntrans->requests < NTRANS_MAX_REQUESTS) {
+			ntrans_request_add(ntrans, true);
+		} else {
+			hash_table_remove_item(&ntrans_table, item);
+			return true;
+		}
+		break;
+	}
+
+	if (++ntrans->idle >= NTRANS_GC_TICKS && ntrans->state == nts_stale)
+		hash_table_remove_item(&ntrans_table, item);
+
+	return true;
+}
+
+/** Aging timer handler
+ *
+ * Retransmits outstanding solicitations, expires confirmed translations
+ * and discards unused ones.
+ */
+static void ntrans_timer_fun(void *arg)
+{
+	list_t requests;
+
+	list_initialize(&requests);
+
+	fibril_mutex_lock(&ntrans_lock);
+	hash_table_apply(&ntrans_table, ntrans_age, NULL);
+	list_concat(&requests, &ntrans_requests);
+	fibril_timer_set_locked(ntrans_timer, NTRANS_TICK_USEC,
+	    ntrans_timer_fun, NULL);
+	fibril_mutex_unlock(&ntrans_lock);
+
+	list_foreach_safe(requests, cur, next) {
+		ntrans_request_t *req = list_get_instance(cur, ntrans_request_t,
+		    link);
+		list_remove(&req->link);
+		(void) ndp_solicit(req->ilink, req->src_addr, req->ip_addr,
+		    req->unicast ? req->mac_addr : NULL);
+		free(req);
+	}
+}
+
 /** @}
  */
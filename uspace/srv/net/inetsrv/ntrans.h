@@ -37,20 +37,55 @@
 #ifndef NTRANS_H_
 #define NTRANS_H_
 
+#include <adt/hash_table.h>
+#include <fibril_synch.h>
 #include <inet/iplink_srv.h>
 #include <inet/addr.h>
+#include "inetsrv.h"
+
+/** Neighbour translation entry state */
+typedef enum {
+	/** Resolution in progress */
+	nts_incomplete,
+	/** Translation has been confirmed recently */
+	nts_reachable,
+	/** Translation is usable, but has not been confirmed recently */
+	nts_stale,
+	/** Stale translation is being confirmed using unicast solicitations */
+	nts_probe,
+	/** Resolution failed, entry is kept until all waiters are gone */
+	nts_failed
+} inet_ntrans_state_t;
 
 /** Address translation table element */
 typedef struct {
-	link_t ntrans_list;
+	/** Link to address translation table */
+	ht_link_t ntrans_link;
 	addr128_t ip_addr;
 	addr48_t mac_addr;
+	inet_ntrans_state_t state;
+	/** Ticks since the translation was last confirmed */
+	unsigned age;
+	/** Ticks since the translation was last used */
+	unsigned idle;
+	/** Number of solicitations sent during current resolution or probe */
+	unsigned requests;
+	/** Link used for sending solicitations */
+	inet_link_t *ilink;
+	/** Source address used for sending solicitations */
+	addr128_t src_addr;
+	/** Number of fibrils waiting for resolution */
+	unsigned waiters;
+	/** Broadcast when resolution completes or fails */
+	fibril_condvar_t cv;
 } inet_ntrans_t;
 
-extern errno_t ntrans_add(addr128_t, addr48_t);
+extern errno_t ntrans_init(void);
+extern errno_t ntrans_add(inet_link_t *, addr128_t, addr128_t, addr48_t);
+extern void ntrans_update(addr128_t, addr48_t);
 extern errno_t ntrans_remove(addr128_t);
 extern errno_t ntrans_lookup(addr128_t, addr48_t);
-extern errno_t ntrans_wait_timeout(usec_t);
+extern errno_t ntrans_resolve(inet_link_t *, addr128_t, addr128_t, addr48_t);
 
 #endif
 
@@ -300,6 +300,7 @@ errno_t inet_pdu_encode6(inet_packet_t *packet, addr128_t src, addr128_t dest,
  * @param data    Serialized IPv4 datagram
  * @param size    Length of serialized IPv4 datagram
  * @param link_id Link on which PDU was received
+ * @param flags   Receive offload results (IPLINK_SDU_xxx)
  * @param packet  IP datagram structure to be filled
  *
  * @return EOK on success
@@ -308,7 +309,7 @@ errno_t inet_pdu_encode6(inet_packet_t *packet, addr128_t src, addr128_t dest,
  *
  */
 errno_t inet_pdu_decode(void *data, size_t size, service_id_t link_id,
-    inet_packet_t *packet)
+    uint32_t flags, inet_packet_t *packet)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_pdu_decode()");
 
@@ -342,7 +343,22 @@ errno_t inet_pdu_decode(void *data, size_t size, service_id_t link_id,
 	uint16_t flags_foff = uint16_t_be2host(hdr->flags_foff);
 	uint16_t foff = BIT_RANGE_EXTRACT(uint16_t, FF_FRAGOFF_h, FF_FRAGOFF_l,
 	    flags_foff);
-	/* XXX Checksum */
+
+	/* XXX IP options */
+	size_t data_offs = sizeof(uint32_t) *
+	    BIT_RANGE_EXTRACT(uint8_t, VI_IHL_h, VI_IHL_l, hdr->ver_ihl);
+	if (data_offs < sizeof(ip_header_t) || data_offs > tot_len) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Invalid header length (%zu)",
+		    data_offs);
+		return EINVAL;
+	}
+
+	/* Unless already verified by the link, verify header checksum */
+	if ((flags & IPLINK_SDU_IPV4_CSUM_OK) == 0 &&
+	    inet_checksum_calc(INET_CHECKSUM_INIT, data, data_offs) != 0) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Header checksum mismatch");
+		return EINVAL;
+	}
 
 	inet_addr_set(uint32_t_be2host(hdr->src_addr), &packet->src);
 	inet_addr_set(uint32_t_be2host(hdr->dest_addr), &packet->dest);
@@ -354,10 +370,7 @@ errno_t inet_pdu_decode(void *data, size_t size, service_id_t link_id,
 	packet->df = (flags_foff & BIT_V(uint16_t, FF_FLAG_DF)) != 0;
 	packet->mf = (flags_foff & BIT_V(uint16_t, FF_FLAG_MF)) != 0;
 	packet->offs = foff * FRAG_OFFS_UNIT;
-
-	/* XXX IP options */
-	size_t data_offs = sizeof(uint32_t) *
-	    BIT_RANGE_EXTRACT(uint8_t, VI_IHL_h, VI_IHL_l, hdr->ver_ihl);
+	packet->flags = flags;
 
 	packet->size = tot_len - data_offs;
 	packet->data = calloc(packet->size, 1);
@@ -452,6 +465,7 @@ errno_t inet_pdu_decode6(void *data, size_t size, service_id_t link_id,
 	packet->df = 1;
 	packet->mf = (offsmf & BIT_V(uint16_t, OF_FLAG_M)) != 0;
 	packet->offs = foff * FRAG_OFFS_UNIT;
+	packet->flags = 0;
 
 	packet->size = payload_len;
 	packet->data = calloc(packet->size, 1);
@@ -478,6 +492,7 @@ errno_t ndp_pdu_encode(ndp_packet_t *ndp, inet_dgram_t *dgram)
 	inet_addr_set6(ndp->sender_proto_addr, &dgram->src);
 	inet_addr_set6(ndp->target_proto_addr, &dgram->dest);
 	dgram->tos = 0;
+	dgram->flags = 0;
 	dgram->size = sizeof(icmpv6_message_t) + sizeof(ndp_message_t);
 
 	dgram->data = calloc(1, dgram->size);
@@ -51,7 +51,8 @@ extern errno_t inet_pdu_encode(inet_packet_t *, addr32_t, addr32_t, size_t, size
     void **, size_t *, size_t *);
 extern errno_t inet_pdu_encode6(inet_packet_t *, addr128_t, addr128_t, size_t,
     size_t, void **, size_t *, size_t *);
-extern errno_t inet_pdu_decode(void *, size_t, service_id_t, inet_packet_t *);
+extern errno_t inet_pdu_decode(void *, size_t, service_id_t, uint32_t,
+    inet_packet_t *);
 extern errno_t inet_pdu_decode6(void *, size_t, service_id_t, inet_packet_t *);
 
 extern errno_t ndp_pdu_decode(inet_dgram_t *, ndp_packet_t *);
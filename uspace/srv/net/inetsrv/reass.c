@@ -34,46 +34,172 @@
  * @brief Datagram reassembly.
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
 #include <errno.h>
 #include <fibril_synch.h>
 #include <io/log.h>
 #include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "inetsrv.h"
 #include "inet_std.h"
 #include "reass.h"
 
-/** Datagram being reassembled.
+/** Time after which an incomplete datagram is discarded (RFC 791) */
+#define REASS_TIMEOUT_SEC  30
+
+/** Maximum memory used by fragment data of all datagrams */
+#define REASS_MEM_MAX  (1024 * 1024)
+
+/** Maximum number of datagrams being reassembled */
+#define REASS_DGRAM_MAX  256
+
+/** Datagram reassembly key.
  *
- * Uniquely identified by (source address, destination address, protocol,
- * identification) per RFC 791 sec. 2.3 / Fragmentation.
+ * Datagram is uniquely identified by (source address, destination address,
+ * protocol, identification) per RFC 791 sec. 2.3 / Fragmentation.
  */
 typedef struct {
-	link_t map_link;
-	/** List of fragments, @c reass_frag_t */
+	inet_addr_t src;
+	inet_addr_t dest;
+	uint8_t proto;
+	uint32_t ident;
+} reass_key_t;
+
+/** Datagram being reassembled. */
+typedef struct {
+	/** Link to @c reass_dgram_map */
+	ht_link_t map_link;
+	/** Link to @c reass_lru */
+	link_t lru_link;
+	/** Datagram key */
+	reass_key_t key;
+	/** Header fields of the first fragment received */
+	service_id_t link_id;
+	uint8_t tos;
+	/** List of non-overlapping fragments sorted by offset, @c reass_frag_t */
 	list_t frags;
+	/** Number of bytes received so far */
+	size_t received;
+	/** Total datagram size, valid if @c have_last is @c true */
+	size_t total;
+	/** Fragment with MF cleared has been received */
+	bool have_last;
+	/** Memory used by fragment data */
+	size_t mem;
+	/** Time when the datagram is discarded if not complete */
+	struct timespec expires;
 } reass_dgram_t;
 
 /** One datagram fragment */
 typedef struct {
 	link_t dgram_link;
-	inet_packet_t packet;
+	/** Offset of fragment into datagram, in bytes */
+	size_t offs;
+	/** Fragment data */
+	void *data;
+	/** Fragment data size in bytes */
+	size_t size;
 } reass_frag_t;
 
-/** Datagram map, list of reass_dgram_t */
-static LIST_INITIALIZE(reass_dgram_map);
+/** Datagram map, hash table of reass_dgram_t */
+static hash_table_t reass_dgram_map;
+/** Datagrams in least recently used order, list of reass_dgram_t */
+static LIST_INITIALIZE(reass_lru);
+/** Number of datagrams in @c reass_dgram_map */
+static size_t reass_dgram_cnt;
+/** Memory used by fragment data of all datagrams */
+static size_t reass_mem;
 /** Protects access to @c reass_dgram_map */
 static FIBRIL_MUTEX_INITIALIZE(reass_dgram_map_lock);
 
-static reass_dgram_t *reass_dgram_new(void);
+static reass_dgram_t *reass_dgram_new(reass_key_t *, inet_packet_t *);
 static reass_dgram_t *reass_dgram_get(inet_packet_t *);
 static errno_t reass_dgram_insert_frag(reass_dgram_t *, inet_packet_t *);
 static bool reass_dgram_complete(reass_dgram_t *);
 static void reass_dgram_remove(reass_dgram_t *);
 static errno_t reass_dgram_deliver(reass_dgram_t *);
 static void reass_dgram_destroy(reass_dgram_t *);
+static void reass_expire(void);
+static void reass_evict(reass_dgram_t *);
+
+static size_t reass_addr_hash(size_t hash, const inet_addr_t *addr)
+{
+	size_t i;
+
+	switch (addr->version) {
+	case ip_v4:
+		return hash_combine(hash, hash_mix32(addr->addr));
+	case ip_v6:
+		for (i = 0; i < 16; i += 4) {
+			hash = hash_combine(hash,
+			    ((uint32_t) addr->addr6[i] << 24) |
+			    ((uint32_t) addr->addr6[i + 1] << 16) |
+			    ((uint32_t) addr->addr6[i + 2] << 8) |
+			    addr->addr6[i + 3]);
+		}
+		return hash;
+	default:
+		return hash;
+	}
+}
+
+static size_t reass_key_hash_fn(const reass_key_t *key)
+{
+	size_t hash = hash_mix32(key->ident);
+
+	hash = hash_combine(hash, key->proto);
+	hash = reass_addr_hash(hash, &key->src);
+	return reass_addr_hash(hash, &key->dest);
+}
+
+static size_t reass_key_hash(const void *key)
+{
+	return reass_key_hash_fn(key);
+}
+
+static size_t reass_hash(const ht_link_t *item)
+{
+	reass_dgram_t *rdg = hash_table_get_inst(item, reass_dgram_t,
+	    map_link);
+	return reass_key_hash_fn(&rdg->key);
+}
+
+static bool reass_key_equal(const void *key, const ht_link_t *item)
+{
+	const reass_key_t *k = key;
+	reass_dgram_t *rdg = hash_table_get_inst(item, reass_dgram_t,
+	    map_link);
+
+	return (rdg->key.ident == k->ident) &&
+	    (rdg->key.proto == k->proto) &&
+	    inet_addr_compare(&rdg->key.src, &k->src) &&
+	    inet_addr_compare(&rdg->key.dest, &k->dest);
+}
+
+static hash_table_ops_t reass_dgram_map_ops = {
+	.hash = reass_hash,
+	.key_hash = reass_key_hash,
+	.key_equal = reass_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Initialize datagram reassembly.
+ *
+ * @return		EOK on success or ENOMEM.
+ */
+errno_t inet_reass_init(void)
+{
+	if (!hash_table_create(&reass_dgram_map, 0, 0, &reass_dgram_map_ops))
+		return ENOMEM;
+
+	return EOK;
+}
 
 /** Queue packet for datagram reassembly.
  *
@@ -89,6 +215,9 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 
 	fibril_mutex_lock(&reass_dgram_map_lock);
 
+	/* Discard datagrams that timed out */
+	reass_expire();
+
 	/* Get existing or new datagram */
 	rdg = reass_dgram_get(packet);
 	if (rdg == NULL) {
@@ -100,8 +229,14 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 
 	/* Insert fragment into the datagram */
 	rc = reass_dgram_insert_frag(rdg, packet);
-	if (rc != EOK)
-		return ENOMEM;
+	if (rc != EOK) {
+		/* Fragments are inconsistent or we are out of memory */
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Discarding datagram.");
+		reass_dgram_remove(rdg);
+		fibril_mutex_unlock(&reass_dgram_map_lock);
+		reass_dgram_destroy(rdg);
+		return rc;
+	}
 
 	/* Check if datagram is complete */
 	if (reass_dgram_complete(rdg)) {
@@ -115,6 +250,11 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
 		return rc;
 	}
 
+	/* Mark as most recently used and enforce limits */
+	list_remove(&rdg->lru_link);
+	list_append(&rdg->lru_link, &reass_lru);
+	reass_evict(rdg);
+
 	fibril_mutex_unlock(&reass_dgram_map_lock);
 	return EOK;
 }
@@ -126,33 +266,31 @@ errno_t inet_reass_queue_packet(inet_packet_t *packet)
  */
 static reass_dgram_t *reass_dgram_get(inet_packet_t *packet)
 {
-	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+	reass_key_t key;
+	ht_link_t *link;
 
-	list_foreach(reass_dgram_map, map_link, reass_dgram_t, rdg) {
-		link_t *f1_link = list_first(&rdg->frags);
-		assert(f1_link != NULL);
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-		reass_frag_t *f1 = list_get_instance(f1_link, reass_frag_t,
-		    dgram_link);
+	key.src = packet->src;
+	key.dest = packet->dest;
+	key.proto = packet->proto;
+	key.ident = packet->ident;
 
-		if ((inet_addr_compare(&f1->packet.src, &packet->src)) &&
-		    (inet_addr_compare(&f1->packet.dest, &packet->dest)) &&
-		    (f1->packet.proto == packet->proto) &&
-		    (f1->packet.ident == packet->ident)) {
-			/* Match */
-			return rdg;
-		}
-	}
+	link = hash_table_find(&reass_dgram_map, &key);
+	if (link != NULL)
+		return hash_table_get_inst(link, reass_dgram_t, map_link);
 
 	/* No existing reassembly structure. Create a new one. */
-	return reass_dgram_new();
+	return reass_dgram_new(&key, packet);
 }
 
 /** Create new datagram reassembly structure.
  *
+ * @param key		Datagram key
+ * @param packet	First fragment received
  * @return New datagram reassembly structure.
  */
-static reass_dgram_t *reass_dgram_new(void)
+static reass_dgram_t *reass_dgram_new(reass_key_t *key, inet_packet_t *packet)
 {
 	reass_dgram_t *rdg;
 
@@ -160,13 +298,23 @@ static reass_dgram_t *reass_dgram_new(void)
 	if (rdg == NULL)
 		return NULL;
 
-	list_append(&rdg->map_link, &reass_dgram_map);
+	rdg->key = *key;
+	rdg->link_id = packet->link_id;
+	rdg->tos = packet->tos;
 	list_initialize(&rdg->frags);
 
+	getuptime(&rdg->expires);
+	rdg->expires.tv_sec += REASS_TIMEOUT_SEC;
+
+	hash_table_insert(&reass_dgram_map, &rdg->map_link);
+	list_append(&rdg->lru_link, &reass_lru);
+	++reass_dgram_cnt;
+
 	return rdg;
 }
 
-static reass_frag_t *reass_frag_new(void)
+static reass_frag_t *reass_frag_new(size_t offs, const void *data,
+    size_t size)
 {
 	reass_frag_t *frag;
 
@@ -174,59 +322,131 @@ static reass_frag_t *reass_frag_new(void)
 	if (frag == NULL)
 		return NULL;
 
+	frag->data = malloc(size);
+	if (frag->data == NULL) {
+		free(frag);
+		return NULL;
+	}
+
 	link_initialize(&frag->dgram_link);
+	frag->offs = offs;
+	frag->size = size;
+	memcpy(frag->data, data, size);
 
 	return frag;
 }
 
+static void reass_frag_delete(reass_dgram_t *rdg, reass_frag_t *frag)
+{
+	list_remove(&frag->dgram_link);
+	rdg->received -= frag->size;
+	rdg->mem -= frag->size;
+	reass_mem -= frag->size;
+	free(frag->data);
+	free(frag);
+}
+
+/** Insert fragment into datagram.
+ *
+ * Fragments are kept as a sorted list of disjoint intervals. Data already
+ * present is not replaced, overlapping parts of the new fragment are
+ * dropped and existing fragments completely covered by the new one
+ * are replaced by it.
+ *
+ * @param rdg		Datagram reassembly structure
+ * @param packet	Fragment
+ * @return		EOK on success, EINVAL if fragment is inconsistent
+ *			with the datagram, ENOMEM if out of memory
+ */
 static errno_t reass_dgram_insert_frag(reass_dgram_t *rdg, inet_packet_t *packet)
 {
 	reass_frag_t *frag;
-	void *data_copy;
 	link_t *link;
+	size_t fb, fe;
 
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-	frag = reass_frag_new();
+	fb = packet->offs;
+	fe = packet->offs + packet->size;
 
-	/* Clone the packet */
+	/* Upper bound for datagram size */
+	if (fe > FRAG_OFFS_UNIT * (1 << (FF_FRAGOFF_h - FF_FRAGOFF_l + 1)))
+		return EINVAL;
 
-	data_copy = malloc(packet->size);
-	if (data_copy == NULL) {
-		free(frag);
-		return ENOMEM;
+	if (!packet->mf) {
+		if (rdg->have_last && rdg->total != fe)
+			return EINVAL;
+
+		/* Data beyond the end of datagram */
+		if (!list_empty(&rdg->frags)) {
+			reass_frag_t *lf = list_get_instance(
+			    list_last(&rdg->frags), reass_frag_t, dgram_link);
+			if (lf->offs + lf->size > fe)
+				return EINVAL;
+		}
+
+		rdg->have_last = true;
+		rdg->total = fe;
+	} else if (rdg->have_last && fe > rdg->total) {
+		return EINVAL;
 	}
 
-	memcpy(data_copy, packet->data, packet->size);
+	/* Find the first fragment ending after the start of the new one */
+	link = list_first(&rdg->frags);
+	while (link != NULL) {
+		reass_frag_t *qf = list_get_instance(link, reass_frag_t,
+		    dgram_link);
 
-	frag->packet = *packet;
-	frag->packet.data = data_copy;
+		if (qf->offs + qf->size > fb) {
+			if (qf->offs <= fb) {
+				/* Head of new fragment is already present */
+				fb = qf->offs + qf->size;
+				link = list_next(link, &rdg->frags);
+				continue;
+			}
 
-	/*
-	 * XXX Make resource-consuming attacks harder, eliminate any duplicate
-	 * data immediately. Possibly eliminate redundant packet headers.
-	 */
+			break;
+		}
 
-	/*
-	 * Insert into the list, which is sorted by offs member ascending.
-	 */
+		link = list_next(link, &rdg->frags);
+	}
 
-	link = list_first(&rdg->frags);
-	while (link != NULL) {
+	/* Drop existing fragments covered by the new one, trim the tail */
+	while (link != NULL && fb < fe) {
 		reass_frag_t *qf = list_get_instance(link, reass_frag_t,
 		    dgram_link);
 
-		if (qf->packet.offs >= packet->offs)
+		if (qf->offs >= fe)
 			break;
 
+		if (qf->offs + qf->size > fe) {
+			fe = qf->offs;
+			break;
+		}
+
 		link = list_next(link, &rdg->frags);
+		reass_frag_delete(rdg, qf);
 	}
 
+	if (fb >= fe) {
+		/* Duplicate */
+		return EOK;
+	}
+
+	frag = reass_frag_new(fb, (uint8_t *) packet->data +
+	    (fb - packet->offs), fe - fb);
+	if (frag == NULL)
+		return ENOMEM;
+
 	if (link != NULL)
-		list_insert_after(&frag->dgram_link, link);
+		list_insert_before(&frag->dgram_link, link);
 	else
 		list_append(&frag->dgram_link, &rdg->frags);
 
+	rdg->received += frag->size;
+	rdg->mem += frag->size;
+	reass_mem += frag->size;
+
 	return EOK;
 }
 
@@ -237,52 +457,74 @@ static errno_t reass_dgram_insert_frag(reass_dgram_t *rdg, inet_packet_t *packet
  */
 static bool reass_dgram_complete(reass_dgram_t *rdg)
 {
-	reass_frag_t *frag, *prev;
-	link_t *link;
-
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
-	assert(!list_empty(&rdg->frags));
-
-	link = list_first(&rdg->frags);
-	assert(link != NULL);
 
-	frag = list_get_instance(link, reass_frag_t,
-	    dgram_link);
-
-	/* First fragment must be at offset zero */
-	if (frag->packet.offs != 0)
-		return false;
+	/* Fragments are disjoint, so only the byte count matters */
+	return rdg->have_last && rdg->received == rdg->total;
+}
 
-	prev = frag;
+/** Remove datagram from reassembly map.
+ *
+ * @param rdg		Datagram reassembly structure
+ */
+static void reass_dgram_remove(reass_dgram_t *rdg)
+{
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
+	hash_table_remove_item(&reass_dgram_map, &rdg->map_link);
+	list_remove(&rdg->lru_link);
+	--reass_dgram_cnt;
+	reass_mem -= rdg->mem;
+}
 
-	while (true) {
-		link = list_next(link, &rdg->frags);
-		if (link == NULL)
-			break;
+/** Discard datagrams that were not completed in time. */
+static void reass_expire(void)
+{
+	struct timespec now;
 
-		/* Each next fragment must follow immediately or overlap */
-		frag = list_get_instance(link, reass_frag_t, dgram_link);
-		if (frag->packet.offs > prev->packet.offs + prev->packet.size)
-			return false;
+	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
 
-		/* No more fragments - datagram is complete */
-		if (!frag->packet.mf)
-			return true;
+	getuptime(&now);
 
-		prev = frag;
+	/*
+	 * The LRU list is ordered by last activity, not by creation time,
+	 * so the whole list needs to be checked.
+	 */
+	list_foreach_safe(reass_lru, cur, next) {
+		reass_dgram_t *rdg = list_get_instance(cur, reass_dgram_t,
+		    lru_link);
+
+		if (ts_gteq(&now, &rdg->expires)) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "Reassembly timed out.");
+			reass_dgram_remove(rdg);
+			reass_dgram_destroy(rdg);
+		}
 	}
-
-	return false;
 }
 
-/** Remove datagram from reassembly map.
+/** Evict least recently used datagrams to stay within limits.
  *
- * @param rdg		Datagram reassembly structure
+ * @param keep		Datagram the last fragment was added to
  */
-static void reass_dgram_remove(reass_dgram_t *rdg)
+static void reass_evict(reass_dgram_t *keep)
 {
 	assert(fibril_mutex_is_locked(&reass_dgram_map_lock));
-	list_remove(&rdg->map_link);
+
+	while (reass_mem > REASS_MEM_MAX || reass_dgram_cnt > REASS_DGRAM_MAX) {
+		/*
+		 * @a keep is most recently used, so it is only evicted
+		 * if it alone exceeds the limits.
+		 */
+		reass_dgram_t *rdg = list_get_instance(list_first(&reass_lru),
+		    reass_dgram_t, lru_link);
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Reassembly limits exceeded, "
+		    "evicting datagram.");
+		reass_dgram_remove(rdg);
+		reass_dgram_destroy(rdg);
+
+		if (rdg == keep)
+			break;
+	}
 }
 
 /** Deliver complete datagram.
@@ -291,70 +533,30 @@ static void reass_dgram_remove(reass_dgram_t *rdg)
  */
 static errno_t reass_dgram_deliver(reass_dgram_t *rdg)
 {
-	size_t dgram_size;
-	size_t fragoff_limit;
 	inet_dgram_t dgram;
-	uint8_t proto;
-	reass_frag_t *frag;
 	errno_t rc;
 
-	/*
-	 * Potentially there could be something beyond the first packet
-	 * that has !MF. Make sure we ignore that.
-	 */
-	frag = NULL;
-	list_foreach(rdg->frags, dgram_link, reass_frag_t, cfrag) {
-		if (!cfrag->packet.mf) {
-			frag = cfrag;
-			break;
-		}
-	}
-
-	assert(frag != NULL);
-	assert(!frag->packet.mf);
-
-	dgram_size = frag->packet.offs + frag->packet.size;
-
-	/* Upper bound for fragment offset field */
-	fragoff_limit = 1 << (FF_FRAGOFF_h - FF_FRAGOFF_l + 1);
+	assert(rdg->have_last);
 
-	/* Verify that total size of datagram is within reasonable bounds */
-	if (dgram_size > FRAG_OFFS_UNIT * fragoff_limit)
-		return ELIMIT;
-
-	dgram.data = calloc(dgram_size, 1);
+	dgram.data = malloc(rdg->total);
 	if (dgram.data == NULL)
 		return ENOMEM;
 
 	/* XXX What if different fragments came from different link? */
-	dgram.iplink = frag->packet.link_id;
-	dgram.size = dgram_size;
-	dgram.src = frag->packet.src;
-	dgram.dest = frag->packet.dest;
-	dgram.tos = frag->packet.tos;
-	proto = frag->packet.proto;
+	dgram.iplink = rdg->link_id;
+	dgram.size = rdg->total;
+	dgram.src = rdg->key.src;
+	dgram.dest = rdg->key.dest;
+	dgram.tos = rdg->tos;
+	dgram.flags = 0;
 
 	/* Pull together data from individual fragments */
-
-	size_t doffs = 0;
-
-	list_foreach(rdg->frags, dgram_link, reass_frag_t, cfrag) {
-		size_t cb, ce;
-
-		cb = max(doffs, cfrag->packet.offs);
-		ce = min(dgram_size, cfrag->packet.offs + cfrag->packet.size);
-
-		if (ce > cb) {
-			memcpy(dgram.data + cb,
-			    cfrag->packet.data + cb - cfrag->packet.offs,
-			    ce - cb);
-		}
-
-		if (!cfrag->packet.mf)
-			break;
+	list_foreach(rdg->frags, dgram_link, reass_frag_t, frag) {
+		memcpy((uint8_t *) dgram.data + frag->offs, frag->data,
+		    frag->size);
 	}
 
-	rc = inet_recv_dgram_local(&dgram, proto);
+	rc = inet_recv_dgram_local(&dgram, rdg->key.proto);
 	free(dgram.data);
 	return rc;
 }
@@ -371,7 +573,7 @@ static void reass_dgram_destroy(reass_dgram_t *rdg)
 		    dgram_link);
 
 		list_remove(&frag->dgram_link);
-		free(frag->packet.data);
+		free(frag->data);
 		free(frag);
 	}
 
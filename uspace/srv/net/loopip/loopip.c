@@ -185,6 +185,7 @@ static errno_t loopip_send(iplink_srv_t *srv, iplink_sdu_t *sdu)
 
 	memcpy(rqe->sdu.data, sdu->data, sdu->size);
 	rqe->sdu.size = sdu->size;
+	rqe->sdu.flags = 0;
 
 	/*
 	 * Insert to receive queue
@@ -214,6 +215,7 @@ static errno_t loopip_send6(iplink_srv_t *srv, iplink_sdu6_t *sdu)
 
 	memcpy(rqe->sdu.data, sdu->data, sdu->size);
 	rqe->sdu.size = sdu->size;
+	rqe->sdu.flags = 0;
 
 	/*
 	 * Insert to receive queue
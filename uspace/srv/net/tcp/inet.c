@@ -112,6 +112,14 @@ static errno_t tcp_inet_ev_recv(inet_dgram_t *dgram)
 	pdu->src = dgram->src;
 	pdu->dest = dgram->dest;
 
+	/* Unless already verified by the NIC, verify checksum */
+	if ((dgram->flags & INET_DGRAM_L4_CSUM_OK) == 0 &&
+	    !tcp_pdu_checksum_verify(pdu)) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Checksum mismatch. PDU dropped.");
+		tcp_pdu_delete(pdu);
+		return EINVAL;
+	}
+
 	tcp_received_pdu(pdu);
 	tcp_pdu_delete(pdu);
 
@@ -143,6 +151,8 @@ void tcp_transmit_pdu(tcp_pdu_t *pdu)
 	dgram.tos = 0;
 	dgram.data = pdu_raw;
 	dgram.size = pdu_raw_size;
+	/* Checksum is seeded, segment may exceed MTU */
+	dgram.flags = INET_DGRAM_L4_CSUM | INET_DGRAM_TSO;
 
 	rc = inet_send(&dgram, INET_TTL_MAX, 0);
 	if (rc != EOK)
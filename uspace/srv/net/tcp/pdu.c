@@ -260,10 +260,10 @@ void tcp_pdu_delete(tcp_pdu_t *pdu)
 	free(pdu);
 }
 
-static uint16_t tcp_pdu_checksum_calc(tcp_pdu_t *pdu)
+/** Compute checksum of the pseudo-header of a PDU */
+static uint16_t tcp_pdu_phdr_checksum_calc(tcp_pdu_t *pdu)
 {
 	uint16_t cs_phdr;
-	uint16_t cs_headers;
 	tcp_phdr_t phdr;
 	tcp_phdr6_t phdr6;
 
@@ -281,6 +281,15 @@ static uint16_t tcp_pdu_checksum_calc(tcp_pdu_t *pdu)
 		assert(false);
 	}
 
+	return cs_phdr;
+}
+
+static uint16_t tcp_pdu_checksum_calc(tcp_pdu_t *pdu)
+{
+	uint16_t cs_phdr;
+	uint16_t cs_headers;
+
+	cs_phdr = tcp_pdu_phdr_checksum_calc(pdu);
 	cs_headers = tcp_checksum_calc(cs_phdr, pdu->header, pdu->header_size);
 	return tcp_checksum_calc(cs_headers, pdu->text, pdu->text_size);
 }
@@ -293,6 +302,17 @@ static void tcp_pdu_set_checksum(tcp_pdu_t *pdu, uint16_t checksum)
 	hdr->checksum = host2uint16_t_be(checksum);
 }
 
+/** Verify checksum of incoming PDU
+ *
+ * @param pdu PDU
+ * @return @c true if the checksum is correct
+ */
+bool tcp_pdu_checksum_verify(tcp_pdu_t *pdu)
+{
+	/* Sum over the whole PDU including the checksum field is zero */
+	return tcp_pdu_checksum_calc(pdu) == 0;
+}
+
 /** Decode incoming PDU */
 errno_t tcp_pdu_decode(tcp_pdu_t *pdu, inet_ep2_t *epp, tcp_segment_t **seg)
 {
@@ -317,12 +337,15 @@ errno_t tcp_pdu_decode(tcp_pdu_t *pdu, inet_ep2_t *epp, tcp_segment_t **seg)
 	return EOK;
 }
 
-/** Encode outgoing PDU */
+/** Encode outgoing PDU
+ *
+ * The checksum field is only seeded with the pseudo-header sum, it is
+ * completed by the network stack or the NIC (INET_DGRAM_L4_CSUM).
+ */
 errno_t tcp_pdu_encode(inet_ep2_t *epp, tcp_segment_t *seg, tcp_pdu_t **pdu)
 {
 	tcp_pdu_t *npdu;
 	size_t text_size;
-	uint16_t checksum;
 	errno_t rc;
 
 	npdu = tcp_pdu_new();
@@ -348,9 +371,8 @@ errno_t tcp_pdu_encode(inet_ep2_t *epp, tcp_segment_t *seg, tcp_pdu_t **pdu)
 	npdu->text_size = text_size;
 	memcpy(npdu->text, seg->data, text_size);
 
-	/* Checksum calculation */
-	checksum = tcp_pdu_checksum_calc(npdu);
-	tcp_pdu_set_checksum(npdu, checksum);
+	/* Seed checksum with the (uncomplemented) pseudo-header sum */
+	tcp_pdu_set_checksum(npdu, ~tcp_pdu_phdr_checksum_calc(npdu));
 
 	*pdu = npdu;
 	return EOK;
@@ -26,6 +26,7 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <byteorder.h>
 #include <errno.h>
 #include <inet/endpoint.h>
 #include <mem.h>
@@ -35,11 +36,39 @@
 #include "main.h"
 #include "../pdu.h"
 #include "../segment.h"
+#include "../std.h"
 
 PCUT_INIT;
 
 PCUT_TEST_SUITE(pdu);
 
+/** Add data to one's complement sum (as done by NIC checksum offload) */
+static uint32_t test_sum(uint32_t sum, uint8_t *data, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i + 1 < size; i += 2)
+		sum += ((uint32_t) data[i] << 8) | data[i + 1];
+	if (size % 2 != 0)
+		sum += (uint32_t) data[size - 1] << 8;
+
+	return sum;
+}
+
+/** Complete seeded checksum of PDU */
+static void test_csum_complete(tcp_pdu_t *pdu)
+{
+	tcp_header_t *hdr = (tcp_header_t *) pdu->header;
+	uint32_t sum;
+
+	sum = test_sum(0, pdu->header, pdu->header_size);
+	sum = test_sum(sum, pdu->text, pdu->text_size);
+	while ((sum >> 16) != 0)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	hdr->checksum = host2uint16_t_be(~sum & 0xffff);
+}
+
 /** Test encode/decode round trip for control PDU */
 PCUT_TEST(encdec_syn)
 {
@@ -108,4 +137,42 @@ PCUT_TEST(encdec_data)
 	free(data);
 }
 
+/** Test that completing seeded checksum gives valid checksum */
+PCUT_TEST(checksum_seed)
+{
+	tcp_segment_t *seg;
+	tcp_pdu_t *pdu;
+	inet_ep2_t epp;
+	uint8_t data[15];
+	size_t i;
+	errno_t rc;
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 1, 2, 3, 4);
+	inet_addr(&epp.remote.addr, 5, 6, 7, 8);
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = (uint8_t) (i * 17);
+
+	seg = tcp_segment_make_data(CTL_ACK, data, sizeof(data));
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	seg->seq = 0x12345678;
+	seg->ack = 0x9abcdef0;
+	seg->wnd = 1024;
+
+	rc = tcp_pdu_encode(&epp, seg, &pdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_csum_complete(pdu);
+	PCUT_ASSERT_TRUE(tcp_pdu_checksum_verify(pdu));
+
+	/* Corrupt payload */
+	((uint8_t *) pdu->text)[3] ^= 0x40;
+	PCUT_ASSERT_FALSE(tcp_pdu_checksum_verify(pdu));
+
+	tcp_pdu_delete(pdu);
+	tcp_segment_delete(seg);
+}
+
 PCUT_EXPORT(pdu);
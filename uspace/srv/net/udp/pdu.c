@@ -129,7 +129,8 @@ void udp_pdu_delete(udp_pdu_t *pdu)
 	free(pdu);
 }
 
-static uint16_t udp_pdu_checksum_calc(udp_pdu_t *pdu)
+/** Compute checksum of the pseudo-header of a PDU */
+static uint16_t udp_pdu_phdr_checksum_calc(udp_pdu_t *pdu)
 {
 	uint16_t cs_phdr;
 	udp_phdr_t phdr;
@@ -149,7 +150,13 @@ static uint16_t udp_pdu_checksum_calc(udp_pdu_t *pdu)
 		assert(false);
 	}
 
-	return udp_checksum_calc(cs_phdr, pdu->data, pdu->data_size);
+	return cs_phdr;
+}
+
+static uint16_t udp_pdu_checksum_calc(udp_pdu_t *pdu)
+{
+	return udp_checksum_calc(udp_pdu_phdr_checksum_calc(pdu), pdu->data,
+	    pdu->data_size);
 }
 
 static void udp_pdu_set_checksum(udp_pdu_t *pdu, uint16_t checksum)
@@ -160,6 +167,27 @@ static void udp_pdu_set_checksum(udp_pdu_t *pdu, uint16_t checksum)
 	hdr->checksum = host2uint16_t_be(checksum);
 }
 
+/** Verify checksum of incoming PDU
+ *
+ * @param pdu PDU
+ * @return @c true if the checksum is correct or not present
+ */
+bool udp_pdu_checksum_verify(udp_pdu_t *pdu)
+{
+	udp_header_t *hdr;
+
+	if (pdu->data_size < sizeof(udp_header_t))
+		return false;
+
+	/* Zero means the sender did not compute checksum */
+	hdr = (udp_header_t *)pdu->data;
+	if (hdr->checksum == 0)
+		return true;
+
+	/* Sum over the whole PDU including the checksum field is zero */
+	return udp_pdu_checksum_calc(pdu) == 0;
+}
+
 /** Decode incoming PDU */
 errno_t udp_pdu_decode(udp_pdu_t *pdu, inet_ep2_t *epp, udp_msg_t **msg)
 {
@@ -168,7 +196,6 @@ errno_t udp_pdu_decode(udp_pdu_t *pdu, inet_ep2_t *epp, udp_msg_t **msg)
 	void *text;
 	size_t text_size;
 	uint16_t length;
-	uint16_t checksum;
 
 	if (pdu->data_size < sizeof(udp_header_t))
 		return EINVAL;
@@ -185,8 +212,6 @@ errno_t udp_pdu_decode(udp_pdu_t *pdu, inet_ep2_t *epp, udp_msg_t **msg)
 	epp->local.addr = pdu->dest;
 
 	length = uint16_t_be2host(hdr->length);
-	checksum = uint16_t_be2host(hdr->checksum);
-	(void) checksum;
 
 	if (length < sizeof(udp_header_t) ||
 	    length > sizeof(udp_header_t) + text_size)
@@ -207,12 +232,15 @@ errno_t udp_pdu_decode(udp_pdu_t *pdu, inet_ep2_t *epp, udp_msg_t **msg)
 	return EOK;
 }
 
-/** Encode outgoing PDU */
+/** Encode outgoing PDU
+ *
+ * The checksum field is only seeded with the pseudo-header sum, it is
+ * completed by the network stack or the NIC (INET_DGRAM_L4_CSUM).
+ */
 errno_t udp_pdu_encode(inet_ep2_t *epp, udp_msg_t *msg, udp_pdu_t **pdu)
 {
 	udp_pdu_t *npdu;
 	udp_header_t *hdr;
-	uint16_t checksum;
 
 	npdu = udp_pdu_new();
 	if (npdu == NULL)
@@ -238,9 +266,8 @@ errno_t udp_pdu_encode(inet_ep2_t *epp, udp_msg_t *msg, udp_pdu_t **pdu)
 	memcpy((uint8_t *)npdu->data + sizeof(udp_header_t), msg->data,
 	    msg->data_size);
 
-	/* Checksum calculation */
-	checksum = udp_pdu_checksum_calc(npdu);
-	udp_pdu_set_checksum(npdu, checksum);
+	/* Seed checksum with the (uncomplemented) pseudo-header sum */
+	udp_pdu_set_checksum(npdu, ~udp_pdu_phdr_checksum_calc(npdu));
 
 	*pdu = npdu;
 	return EOK;
@@ -36,11 +36,13 @@
 #define PDU_H
 
 #include <inet/endpoint.h>
+#include <stdbool.h>
 #include "std.h"
 #include "udp_type.h"
 
 extern udp_pdu_t *udp_pdu_new(void);
 extern void udp_pdu_delete(udp_pdu_t *);
+extern bool udp_pdu_checksum_verify(udp_pdu_t *);
 extern errno_t udp_pdu_decode(udp_pdu_t *, inet_ep2_t *, udp_msg_t **);
 extern errno_t udp_pdu_encode(inet_ep2_t *, udp_msg_t *, udp_pdu_t **);
 
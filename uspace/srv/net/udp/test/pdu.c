@@ -26,11 +26,13 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <byteorder.h>
 #include <inet/endpoint.h>
 #include <pcut/pcut.h>
 #include <str.h>
 #include "../msg.h"
 #include "../pdu.h"
+#include "../std.h"
 
 PCUT_INIT;
 
@@ -128,4 +130,57 @@ PCUT_TEST(encode_decode_v6)
 	udp_msg_delete(dmsg);
 }
 
+/** Test that completing seeded checksum gives valid checksum */
+PCUT_TEST(checksum_seed)
+{
+	inet_ep2_t epp;
+	udp_msg_t *msg;
+	udp_pdu_t *pdu;
+	udp_header_t *hdr;
+	uint8_t *data;
+	const char *msgstr = "Hello";
+	uint32_t sum;
+	size_t i;
+	errno_t rc;
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 192, 168, 0, 1);
+	epp.local.port = 1;
+	inet_addr(&epp.remote.addr, 192, 168, 0, 2);
+	epp.remote.port = 2;
+
+	msg = udp_msg_new();
+	PCUT_ASSERT_NOT_NULL(msg);
+	msg->data_size = str_size(msgstr) + 1;
+	msg->data = str_dup(msgstr);
+
+	rc = udp_pdu_encode(&epp, msg, &pdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Complete checksum the way a NIC does */
+	data = pdu->data;
+	sum = 0;
+	for (i = 0; i + 1 < pdu->data_size; i += 2)
+		sum += ((uint32_t) data[i] << 8) | data[i + 1];
+	if (pdu->data_size % 2 != 0)
+		sum += (uint32_t) data[pdu->data_size - 1] << 8;
+	while ((sum >> 16) != 0)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	hdr = (udp_header_t *) pdu->data;
+	hdr->checksum = host2uint16_t_be(~sum & 0xffff);
+	PCUT_ASSERT_TRUE(udp_pdu_checksum_verify(pdu));
+
+	/* Corrupt payload */
+	data[sizeof(udp_header_t)] ^= 0x01;
+	PCUT_ASSERT_FALSE(udp_pdu_checksum_verify(pdu));
+
+	/* No checksum */
+	hdr->checksum = 0;
+	PCUT_ASSERT_TRUE(udp_pdu_checksum_verify(pdu));
+
+	udp_pdu_delete(pdu);
+	udp_msg_delete(msg);
+}
+
 PCUT_EXPORT(pdu);
@@ -66,6 +66,15 @@ static errno_t udp_inet_ev_recv(inet_dgram_t *dgram)
 	pdu->src = dgram->src;
 	pdu->dest = dgram->dest;
 
+	/* Unless already verified by the NIC, verify checksum */
+	if ((dgram->flags & INET_DGRAM_L4_CSUM_OK) == 0 &&
+	    !udp_pdu_checksum_verify(pdu)) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "Checksum mismatch. PDU dropped.");
+		pdu->data = NULL;
+		udp_pdu_delete(pdu);
+		return EINVAL;
+	}
+
 	udp_received_pdu(pdu);
 
 	/* We don't want udp_pdu_delete() to free dgram->data */
@@ -89,6 +98,8 @@ errno_t udp_transmit_pdu(udp_pdu_t *pdu)
 	dgram.tos = 0;
 	dgram.data = pdu->data;
 	dgram.size = pdu->data_size;
+	/* Checksum is seeded */
+	dgram.flags = INET_DGRAM_L4_CSUM;
 
 	rc = inet_send(&dgram, INET_TTL_MAX, 0);
 	if (rc != EOK)